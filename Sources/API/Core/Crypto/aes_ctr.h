@@ -0,0 +1,88 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class DataBuffer;
+	class AES_CTR_Impl;
+
+	/// \brief AES encryption and decryption in Counter mode
+	///
+	/// Encryption and decryption are the same operation. Data of any length can be added, no padding is used.
+	/// The last 32 bits of the counter block are incremented for each block as a big endian integer.
+	/// A counter block must never be used twice with the same key.
+	class AES_CTR
+	{
+	public:
+		/// \brief Constructs an AES counter mode cipher
+		AES_CTR();
+
+		/// \brief Get the processed data
+		///
+		/// This is the databuffer used internally to store the output.
+		/// You may call "set_size()" to clear the buffer, inbetween calls to "add()"
+		DataBuffer get_data() const;
+
+		static const int iv_size = 16;
+		static const int block_size = 16;
+
+		/// \brief Resets the output and the counter position
+		void reset();
+
+		/// \brief Sets the initial counter block
+		///
+		/// This must be called before the initial add()
+		void set_iv(const unsigned char iv[iv_size]);
+
+		/// \brief Sets the cipher key
+		///
+		/// \param key = The key
+		/// \param key_length = 16, 24 or 32 bytes for AES-128, AES-192 or AES-256
+		void set_key(const unsigned char *key, int key_length);
+
+		/// \brief Adds data to be encrypted or decrypted
+		void add(const void *data, int size);
+
+		/// \brief Adds data to be encrypted or decrypted
+		///
+		/// \param data = Data Buffer
+		void add(const DataBuffer &data);
+
+	private:
+		std::shared_ptr<AES_CTR_Impl> impl;
+	};
+
+	/// \}
+}
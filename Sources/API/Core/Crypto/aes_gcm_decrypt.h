@@ -0,0 +1,97 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class DataBuffer;
+	class AES_GCM_Impl;
+
+	/// \brief AES authenticated decryption in Galois/Counter Mode
+	class AES_GCM_Decrypt
+	{
+	public:
+		/// \brief Constructs an AES-GCM decryptor
+		AES_GCM_Decrypt();
+
+		/// \brief Get decrypted data
+		///
+		/// This is the databuffer used internally to store the decrypted data.
+		/// It must not be used unless calculate() returned true.
+		DataBuffer get_data() const;
+
+		static const int iv_size = 12;
+		static const int tag_size = 16;
+		static const int block_size = 16;
+
+		/// \brief Resets the decryption
+		void reset();
+
+		/// \brief Sets the cipher key
+		///
+		/// The key is kept between messages
+		///
+		/// \param key = The key
+		/// \param key_length = 16, 24 or 32 bytes for AES-128, AES-192 or AES-256
+		void set_key(const unsigned char *key, int key_length);
+
+		/// \brief Sets the initialisation vector (nonce) used to encrypt the message
+		///
+		/// This must be called before each message
+		void set_iv(const unsigned char *iv, int iv_length = iv_size);
+
+		/// \brief Adds additional data that is authenticated but not encrypted
+		///
+		/// This must be called before the first add()
+		void add_aad(const void *data, int size);
+
+		/// \brief Adds data to be decrypted
+		void add(const void *data, int size);
+
+		/// \brief Adds data to be decrypted
+		///
+		/// \param data = Data Buffer
+		void add(const DataBuffer &data);
+
+		/// \brief Finalize decryption and verify the authentication tag
+		///
+		/// \return false = The data or the additional data was modified, or the key or initialisation vector is wrong
+		bool calculate(const unsigned char tag[tag_size]);
+
+	private:
+		std::shared_ptr<AES_GCM_Impl> impl;
+	};
+
+	/// \}
+}
@@ -0,0 +1,98 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class DataBuffer;
+	class AES_GCM_Impl;
+
+	/// \brief AES authenticated encryption in Galois/Counter Mode
+	class AES_GCM_Encrypt
+	{
+	public:
+		/// \brief Constructs an AES-GCM encryptor
+		AES_GCM_Encrypt();
+
+		/// \brief Get encrypted data
+		///
+		/// This is the databuffer used internally to store the encrypted data.
+		DataBuffer get_data() const;
+
+		static const int iv_size = 12;
+		static const int tag_size = 16;
+		static const int block_size = 16;
+
+		/// \brief Resets the encryption
+		void reset();
+
+		/// \brief Sets the cipher key
+		///
+		/// The key is kept between messages
+		///
+		/// \param key = The key
+		/// \param key_length = 16, 24 or 32 bytes for AES-128, AES-192 or AES-256
+		void set_key(const unsigned char *key, int key_length);
+
+		/// \brief Sets the initialisation vector (nonce)
+		///
+		/// This must be called before each message and must never be repeated with the same key.
+		/// Other lengths than iv_size are supported but slower.
+		void set_iv(const unsigned char *iv, int iv_length = iv_size);
+
+		/// \brief Adds additional data that is authenticated but not encrypted
+		///
+		/// This must be called before the first add()
+		void add_aad(const void *data, int size);
+
+		/// \brief Adds data to be encrypted
+		void add(const void *data, int size);
+
+		/// \brief Adds data to be encrypted
+		///
+		/// \param data = Data Buffer
+		void add(const DataBuffer &data);
+
+		/// \brief Finalize encryption and calculate the authentication tag
+		void calculate();
+
+		/// \brief Gets the authentication tag calculated by calculate()
+		void get_tag(unsigned char out_tag[tag_size]) const;
+
+	private:
+		std::shared_ptr<AES_GCM_Impl> impl;
+	};
+
+	/// \}
+}
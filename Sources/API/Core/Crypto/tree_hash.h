@@ -0,0 +1,93 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+namespace clan
+{
+	/// \addtogroup clanCore_Crypto clanCore Crypto
+	/// \{
+
+	class DataBuffer;
+	class IODevice;
+	class WorkQueue;
+	class TreeHash_Impl;
+
+	/// \brief Parallel SHA-256 tree hash for integrity checks of large files.
+	///
+	/// The data is split into chunks of chunk_size bytes that are hashed on the threads of a WorkQueue.
+	/// A chunk is hashed as SHA-256(chunk || 0x00) and two subtrees are combined as SHA-256(left || right || 0x01),
+	/// where the left subtree always covers the largest power of two number of chunks. The hash only depends on
+	/// the data, not on how it was added or how many threads were used. It is not the SHA-256 of the data.
+	class TreeHash
+	{
+	public:
+		/// \brief Constructs a tree hash generator hashing chunks on the threads of work_queue.
+		TreeHash(WorkQueue &work_queue);
+
+		static const int hash_size = 32;
+		static const int chunk_size = 64 * 1024;
+
+		/// \brief Returns the calculated hash.
+		std::string get_hash(bool uppercase = false) const;
+
+		/// \brief Get hash
+		///
+		/// \param out_hash = where to write to
+		void get_hash(unsigned char out_hash[hash_size]) const;
+
+		/// \brief Resets the hash generator.
+		void reset();
+
+		/// \brief Adds data to be hashed.
+		void add(const void *data, int64_t size);
+
+		/// \brief Add
+		///
+		/// \param data = Data Buffer
+		void add(const DataBuffer &data);
+
+		/// \brief Adds everything read from the device until the end of the stream.
+		void add(IODevice &device);
+
+		/// \brief Adds the contents of a file. Large files are memory mapped rather than read.
+		void add_file(const std::string &filename);
+
+		/// \brief Finalize hash calculation.
+		void calculate();
+
+	private:
+		std::shared_ptr<TreeHash_Impl> impl;
+	};
+
+	/// \}
+}
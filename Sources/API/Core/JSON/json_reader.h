@@ -0,0 +1,110 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class JsonReader_Impl;
+
+	enum class JsonToken
+	{
+		end,
+		begin_object,
+		end_object,
+		begin_array,
+		end_array,
+		property_name,
+		string,
+		number,
+		boolean,
+		null
+	};
+
+	/// \brief Pull parser reading JSON one token at a time
+	///
+	/// The reader never builds a tree. Input is either a memory span or an IODevice that is read in chunks,
+	/// so documents larger than memory can be processed. Consecutive top level values (such as line delimited JSON)
+	/// are returned one after another.
+	class JsonReader
+	{
+	public:
+		JsonReader();
+
+		/// \brief Constructs a reader streaming from a device
+		JsonReader(IODevice &input);
+
+		/// \brief Constructs a reader over a memory span. The data is not copied and must outlive the reader.
+		JsonReader(const void *data, size_t length);
+
+		~JsonReader();
+
+		/// \brief Reads the next token. Throws JsonException on malformed input.
+		JsonToken next();
+
+		/// \brief Returns the current token
+		JsonToken get_token() const;
+
+		/// \brief Returns the number of objects and arrays enclosing the current position
+		int get_depth() const;
+
+		/// \brief Returns the text of the current property name, string or number token
+		///
+		/// The text is not null terminated. It points directly into the input unless the string contained escape
+		/// sequences, and is only valid until the next call to next().
+		const char *get_text() const;
+		size_t get_text_length() const;
+
+		/// \brief Returns the text of the current property name or string token as a string
+		std::string get_string() const;
+
+		/// \brief Returns the value of the current number token
+		double get_number() const;
+
+		/// \brief Returns the value of the current boolean token
+		bool get_boolean() const;
+
+		/// \brief Skips the value started by the current token
+		///
+		/// For begin_object and begin_array the reader advances to the matching end token.
+		/// For a property name the value of the property is skipped.
+		void skip_value();
+
+	private:
+		std::shared_ptr<JsonReader_Impl> impl;
+	};
+
+	/// \}
+}
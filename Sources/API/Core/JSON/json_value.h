@@ -36,6 +36,9 @@ namespace clan
 	/// \addtogroup clanCore_JSON clanCore JSON
 	/// \{
 
+	class IODevice;
+	class JsonReader;
+
 	/// \brief Exception class thrown for JSON exceptions.
 	class JsonException : public Exception
 	{
@@ -73,6 +76,15 @@ namespace clan
 		static JsonValue string(const std::string &value) { JsonValue v; v._type = JsonType::string; v._string = value; return v; }
 
 		static JsonValue parse(const std::string &json);
+
+		/// \brief Parses the first value read from a device
+		static JsonValue parse(IODevice &input);
+
+		/// \brief Parses the next value of a reader
+		///
+		/// This can be used to build trees for parts of a document while streaming through the rest of it.
+		static JsonValue parse(JsonReader &reader);
+
 		std::string to_json() const;
 
 		const JsonValue &prop(const std::string &name) const { auto it = _properties.find(name); if (it != _properties.end()) return it->second; static JsonValue undef; return undef; }
@@ -0,0 +1,88 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace clan
+{
+	/// \addtogroup clanCore_JSON clanCore JSON
+	/// \{
+
+	class IODevice;
+	class JsonValue;
+	class JsonWriter_Impl;
+
+	/// \brief Streaming JSON writer
+	///
+	/// Output is buffered and written through to the device in large chunks, so no intermediate tree or
+	/// string of the whole document is needed. Commas and colons are inserted automatically.
+	class JsonWriter
+	{
+	public:
+		JsonWriter();
+
+		/// \brief Constructs a writer writing to a device
+		/// \param flush_threshold Number of buffered bytes that causes a write to the device
+		JsonWriter(IODevice &output, size_t flush_threshold = 64 * 1024);
+
+		/// \brief Constructs a writer appending to a string
+		JsonWriter(std::string &output);
+
+		/// \brief Flushes any buffered output
+		~JsonWriter();
+
+		void begin_object();
+		void end_object();
+		void begin_array();
+		void end_array();
+
+		/// \brief Writes the name of the next property in an object
+		void write_property_name(const std::string &name);
+		void write_property_name(const char *name, size_t length);
+
+		void write_string(const std::string &value);
+		void write_string(const char *value, size_t length);
+		void write_number(double value);
+		void write_boolean(bool value);
+		void write_null();
+
+		/// \brief Writes a value tree
+		void write_value(const JsonValue &value);
+
+		/// \brief Writes buffered output to the device
+		void flush();
+
+	private:
+		std::shared_ptr<JsonWriter_Impl> impl;
+	};
+
+	/// \}
+}
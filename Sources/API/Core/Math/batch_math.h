@@ -0,0 +1,97 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "vec3.h"
+#include "vec4.h"
+#include "mat4.h"
+#include "quaternion.h"
+
+namespace clan
+{
+	/// \addtogroup clanCore_Math clanCore Math
+	/// \{
+
+	class AxisAlignedBoundingBox;
+	class OrientedBoundingBox;
+	class FrustumPlanes;
+
+	/// \brief Math operations on arrays of vectors, boxes and quaternions.
+	///
+	/// The functions give the same results as calling the single object versions in a loop, but use
+	/// SSE2 or AVX2 and FMA3 kernels selected at runtime from the instructions the CPU supports.
+	class BatchMath
+	{
+	public:
+		/// \brief Transforms points by a matrix, out[i] = matrix * Vec4f(in[i], 1)
+		///
+		/// \param matrix = Matrix to transform with
+		/// \param in = Points to transform
+		/// \param out = Transformed points. May not overlap the input.
+		/// \param count = Number of points
+		static void transform_points(const Mat4f &matrix, const Vec3f *in, Vec4f *out, size_t count);
+
+		/// \brief Transforms vectors by a matrix, out[i] = matrix * in[i]
+		///
+		/// The input and output may be the same array.
+		static void transform_points(const Mat4f &matrix, const Vec4f *in, Vec4f *out, size_t count);
+
+		/// \brief Culls axis aligned bounding boxes against a frustum
+		///
+		/// Bit (i % 32) of out_visible[i / 32] is set when box i is not outside the frustum. Bits past count are cleared.
+		///
+		/// \param frustum = Frustum to test against
+		/// \param boxes = Boxes to test
+		/// \param count = Number of boxes
+		/// \param out_visible = Receives the visibility mask, (count + 31) / 32 words
+		/// \param out_inside = Optional mask of boxes entirely inside the frustum, (count + 31) / 32 words
+		static void frustum_aabb(const FrustumPlanes &frustum, const AxisAlignedBoundingBox *boxes, size_t count, uint32_t *out_visible, uint32_t *out_inside = nullptr);
+
+		/// \brief Culls oriented bounding boxes against a frustum
+		///
+		/// The masks use the same layout as for frustum_aabb.
+		static void frustum_obb(const FrustumPlanes &frustum, const OrientedBoundingBox *boxes, size_t count, uint32_t *out_visible, uint32_t *out_inside = nullptr);
+
+		/// \brief Spherical linear interpolation between two arrays of quaternions
+		///
+		/// \param initial = Quaternions at time 0.0
+		/// \param final = Quaternions at time 1.0
+		/// \param time = Interpolation time in the range of 0.0 to 1.0, one per quaternion
+		/// \param out = Interpolated quaternions. May be the same array as initial or final.
+		/// \param count = Number of quaternions
+		static void slerp(const Quaternionf *initial, const Quaternionf *final, const float *time, Quaternionf *out, size_t count);
+
+		/// \brief Spherical linear interpolation between two arrays of quaternions, using the same time for all
+		static void slerp(const Quaternionf *initial, const Quaternionf *final, float time, Quaternionf *out, size_t count);
+	};
+
+	/// \}
+}
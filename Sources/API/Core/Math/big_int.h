@@ -135,12 +135,14 @@ namespace clan
 
 		/// \brief  Compute c = (a ** b) mod m.
 		///
-		/// Uses a standard square-and-multiply
-		/// method with modular reductions at each step. (This is basically the
-		/// same code as expt(), except for the addition of the reductions)
+		/// For odd moduli this uses Montgomery multiplication on 64-bit limbs with
+		/// sliding window exponentiation. Even moduli use a standard square-and-multiply
+		/// method with the modular reductions done using Barrett's algorithm.
 		///
-		/// The modular reductions are done using Barrett's algorithm (see reduce() for details)
-		void exptmod(const BigInt *b, const BigInt *m, BigInt *c) const;
+		/// \param constant_time = Use a fixed window whose timing and memory accesses do not depend on the
+		///                        bits of b. Use this for private keys. Only supported for odd moduli.
+		///                        The reduction of a modulo m only depends on the sizes of a and m.
+		void exptmod(const BigInt *b, const BigInt *m, BigInt *c, bool constant_time = false) const;
 
 		/// \brief  Compute c = a (mod m).  Result will always be 0 <= c < m.
 		void mod(const BigInt *m, BigInt *c) const;
@@ -29,6 +29,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "rect.h"
 
 namespace clan
@@ -51,6 +52,19 @@ namespace clan
 			fail_if_full
 		};
 
+		/// \brief Algorithm used to place rects within a group.
+		enum PackingAlgorithm
+		{
+			/// \brief Binary tree of guillotine cuts. Fast, but wastes space when rect sizes vary.
+			guillotine,
+
+			/// \brief Maximal free rectangles with best short side fit. Packs tightest.
+			max_rects,
+
+			/// \brief Bottom-left skyline. Fast and tight for rects of similar height, such as glyphs.
+			skyline
+		};
+
 		struct AllocatedRect
 		{
 		public:
@@ -59,11 +73,20 @@ namespace clan
 			Rect rect;
 		};
 
+		/// \brief A rect moved by defragment().
+		struct Relocation
+		{
+		public:
+			Relocation(const AllocatedRect &from, const AllocatedRect &to) : from(from), to(to) {}
+			AllocatedRect from;
+			AllocatedRect to;
+		};
+
 		/// \brief Constructs a null instance.
 		RectPacker();
 
 		/// \brief Constructs a rect group.
-		RectPacker(const Size &max_group_size, AllocationPolicy policy = create_new_group);
+		RectPacker(const Size &max_group_size, AllocationPolicy policy = create_new_group, PackingAlgorithm algorithm = guillotine);
 
 		~RectPacker();
 
@@ -76,6 +99,9 @@ namespace clan
 		/// \brief Returns the allocation policy.
 		AllocationPolicy get_allocation_policy() const;
 
+		/// \brief Returns the packing algorithm.
+		PackingAlgorithm get_packing_algorithm() const;
+
 		/// \brief Returns the max group size.
 		Size get_max_group_size() const;
 
@@ -88,12 +114,33 @@ namespace clan
 		/// \brief Returns the amount of rects used by group.
 		int get_group_count() const;
 
+		/// \brief Returns the area covered by allocated rects in a group.
+		int get_used_area(unsigned int group_index = 0) const;
+
+		/// \brief Returns the allocated area divided by the total area of all groups, between 0 and 1.
+		float get_packing_efficiency() const;
+
 		/// \brief Set the allocation policy.
 		void set_allocation_policy(AllocationPolicy policy);
 
 		/// \brief Allocate space for another rect.
 		AllocatedRect add(const Size &size);
 
+		/// \brief Allocate space for another rect without throwing.
+		///
+		/// \return false if the allocation policy did not allow the rect to be placed.
+		bool try_add(const Size &size, AllocatedRect &out_rect);
+
+		/// \brief Release the space of a previously allocated rect so it can be reused.
+		void remove(const AllocatedRect &rect);
+
+		/// \brief Move the rects of the least used group into free space in the other groups.
+		///
+		/// The group is released if all of its rects could be moved, and the groups after it
+		/// shift down by one index. Nothing is moved if the group cannot be emptied.
+		/// \return The moved rects, including rects whose group index only shifted.
+		std::vector<Relocation> defragment();
+
 	private:
 		std::shared_ptr<RectPacker_Impl> impl;
 	};
@@ -32,6 +32,7 @@
 #include <memory>
 #include <functional>
 #include <vector>
+#include <algorithm>
 
 namespace clan
 {
@@ -67,14 +68,46 @@ namespace clan
 	class SignalImpl
 	{
 	public:
-		std::vector<std::weak_ptr<SlotImplType>> slots;
+		/// \brief Connected slots. Entries of slots destroyed during an emit are set to null and removed once the emit completes.
+		std::vector<SlotImplType *> slots;
+
+		/// \brief Callbacks of slots destroyed during an emit. Kept alive until the emit completes as one of them may still be executing.
+		std::vector<std::unique_ptr<typename SlotImplType::CallbackType>> retired_callbacks;
+
+		/// \brief Number of emits currently in progress on the call stack
+		int emit_depth = 0;
+
+		void remove(SlotImplType *slot)
+		{
+			auto it = std::find(slots.begin(), slots.end(), slot);
+			if (it == slots.end())
+				return;
+
+			if (emit_depth > 0)
+			{
+				*it = nullptr;
+				retired_callbacks.push_back(std::move(slot->callback));
+			}
+			else
+			{
+				slots.erase(it);
+			}
+		}
+
+		void compact()
+		{
+			slots.erase(std::remove(slots.begin(), slots.end(), nullptr), slots.end());
+			retired_callbacks.clear();
+		}
 	};
 
 	template<typename FuncType>
 	class SlotImplT : public SlotImpl
 	{
 	public:
-		SlotImplT(const std::weak_ptr<SignalImpl<SlotImplT>> &signal, const std::function<FuncType> &callback) : signal(signal), callback(callback)
+		typedef std::function<FuncType> CallbackType;
+
+		SlotImplT(const std::weak_ptr<SignalImpl<SlotImplT>> &signal, const std::function<FuncType> &callback) : signal(signal), callback(new CallbackType(callback))
 		{
 		}
 
@@ -82,22 +115,13 @@ namespace clan
 		{
 			std::shared_ptr<SignalImpl<SlotImplT>> sig = signal.lock();
 			if (sig)
-			{
-				for (auto it = sig->slots.begin(); it != sig->slots.end(); ++it)
-				{
-					// todo: investigate if "it->lock().get() == this" is required
-					if (it->expired() || it->lock().get() == this)
-					{
-						it = sig->slots.erase(it);
-						if (it == sig->slots.end())
-							break;
-					}
-				}
-			}
+				sig->remove(this);
 		}
 
 		std::weak_ptr<SignalImpl<SlotImplT>> signal;
-		std::function<FuncType> callback;
+
+		// Heap allocated so a callback can outlive its slot while it is executing
+		std::unique_ptr<CallbackType> callback;
 	};
 
 	template<typename FuncType>
@@ -106,16 +130,25 @@ namespace clan
 	public:
 		Signal() : impl(std::make_shared<SignalImpl<SlotImplT<FuncType>>>()) { }
 
+		/// \brief Calls all connected slots
+		///
+		/// Emitting does not allocate. Slots connected during the emit are first called by the next emit,
+		/// and slots disconnected during the emit are not called once disconnected.
 		template<typename... Args>
 		void operator()(Args&&... args)
 		{
-			std::vector<std::weak_ptr<SlotImplT<FuncType>>> slots = impl->slots;
-			for (std::weak_ptr<SlotImplT<FuncType>> &weak_slot : slots)
+			// Keeps the signal alive if a callback destroys it
+			std::shared_ptr<SignalImpl<SlotImplT<FuncType>>> sig = impl;
+			EmitScope scope(sig.get());
+
+			size_t count = sig->slots.size();
+			for (size_t i = 0; i < count; i++)
 			{
-				std::shared_ptr<SlotImplT<FuncType>> slot = weak_slot.lock();
+				// Indexed access as callbacks may connect new slots and reallocate the vector
+				SlotImplT<FuncType> *slot = sig->slots[i];
 				if (slot)
 				{
-					slot->callback(std::forward<Args>(args)...);
+					(*slot->callback)(std::forward<Args>(args)...);
 				}
 			}
 		}
@@ -123,7 +156,7 @@ namespace clan
 		Slot connect(const std::function<FuncType> &func)
 		{
 			auto slot_impl = std::make_shared<SlotImplT<FuncType>>(impl, func);
-			impl->slots.push_back(slot_impl);
+			impl->slots.push_back(slot_impl.get());
 			return Slot(slot_impl);
 		}
 
@@ -134,6 +167,16 @@ namespace clan
 		}
 
 	private:
+		class EmitScope
+		{
+		public:
+			EmitScope(SignalImpl<SlotImplT<FuncType>> *sig) : sig(sig) { sig->emit_depth++; }
+			~EmitScope() { if (--sig->emit_depth == 0 && !sig->retired_callbacks.empty()) sig->compact(); }
+
+		private:
+			SignalImpl<SlotImplT<FuncType>> *sig;
+		};
+
 		std::shared_ptr<SignalImpl<SlotImplT<FuncType>>> impl;
 	};
 
@@ -0,0 +1,138 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "work_queue.h"
+#include <memory>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+namespace clan
+{
+	/// \addtogroup clanCore_System clanCore System
+	/// \{
+
+	class Task_Impl;
+	class TaskGroup_Impl;
+
+	/// \brief Handle to a task running in a TaskGroup
+	class Task
+	{
+	public:
+		/// \brief Constructs a null instance
+		Task();
+
+		/// \brief Returns true if this object is invalid
+		bool is_null() const { return !impl; }
+
+		/// \brief Returns true if the task has finished running
+		bool is_finished() const;
+
+		/// \brief Queue a continuation task that is started once this task has finished
+		Task then(const std::function<void()> &func) const;
+
+	private:
+		Task(const std::shared_ptr<Task_Impl> &impl);
+
+		std::shared_ptr<Task_Impl> impl;
+
+		friend class TaskGroup;
+		friend class TaskGroup_Impl;
+	};
+
+	/// \brief Group of tasks executed by the worker threads of a WorkQueue
+	///
+	/// Tasks can depend on other tasks, which allows a frame to be expressed as a graph of jobs.
+	/// A thread waiting on the group helps the worker threads process queued work until all tasks have finished.
+	class TaskGroup
+	{
+	public:
+		/// \brief Constructs a task group that runs its tasks on the worker threads of the work queue
+		TaskGroup(WorkQueue &work_queue);
+		~TaskGroup();
+
+		/// \brief Queue a task
+		Task run(const std::function<void()> &func);
+
+		/// \brief Queue a task that is started once all the dependencies have finished
+		Task run(const std::function<void()> &func, const std::vector<Task> &dependencies);
+
+		/// \brief Returns the number of tasks in the group that have not yet finished
+		int get_tasks_pending() const;
+
+		/// \brief Waits for all tasks in the group to finish
+		///
+		/// The calling thread processes queued work while it waits. If a task threw an exception, the first exception is rethrown here.
+		void wait();
+
+	private:
+		std::shared_ptr<TaskGroup_Impl> impl;
+	};
+
+	/// \brief Calls func(range_begin, range_end) for sub ranges of [begin, end) on the worker threads of the work queue
+	///
+	/// The range is split into chunks of grain_size items. The calling thread participates and the function returns when all chunks have been processed.
+	void parallel_for(WorkQueue &work_queue, int begin, int end, int grain_size, const std::function<void(int range_begin, int range_end)> &func);
+
+	/// \brief Maps sub ranges of [begin, end) to values on the worker threads and reduces them on the calling thread
+	///
+	/// map_func(range_begin, range_end) returns the value for one chunk. The chunk values are folded with reduce_func(a, b) in range order,
+	/// so the result is deterministic as long as reduce_func is associative.
+	template<typename Type, typename MapFunc, typename ReduceFunc>
+	Type parallel_reduce(WorkQueue &work_queue, int begin, int end, int grain_size, const Type &identity, MapFunc map_func, ReduceFunc reduce_func)
+	{
+		if (end <= begin)
+			return identity;
+
+		grain_size = std::max(grain_size, 1);
+		int num_chunks = (end - begin + grain_size - 1) / grain_size;
+
+		// Wrapped so that std::vector<bool> can't turn concurrent chunk writes into a data race
+		struct ChunkResult { Type value; };
+		std::vector<ChunkResult> results(num_chunks, ChunkResult{ identity });
+
+		parallel_for(work_queue, 0, num_chunks, 1, [&](int chunk_begin, int chunk_end)
+		{
+			for (int chunk = chunk_begin; chunk < chunk_end; chunk++)
+			{
+				int range_begin = begin + chunk * grain_size;
+				int range_end = std::min(range_begin + grain_size, end);
+				results[chunk].value = map_func(range_begin, range_end);
+			}
+		});
+
+		Type result = identity;
+		for (const auto &chunk_result : results)
+			result = reduce_func(result, chunk_result.value);
+		return result;
+	}
+
+	/// \}
+}
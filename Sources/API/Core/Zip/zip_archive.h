@@ -75,6 +75,14 @@ namespace clan
 		/// \brief Opens a file in the archive.
 		IODevice open_file(const std::string &filename);
 
+		/// \brief Enables random access seeking in compressed files.
+		///
+		/// Devices opened on a compressed file save the decompressor state every interval bytes
+		/// while reading, so later seeks can continue from the closest saved state instead of
+		/// decompressing from the start. Each saved state uses about 43 KB of memory.
+		/// \param interval = Uncompressed bytes between saved states, or 0 to disable (the default).
+		void set_seek_index_interval(int interval);
+
 		/// \brief Get full path to source:
 		std::string get_pathname(const std::string &filename);
 
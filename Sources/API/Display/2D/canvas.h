@@ -67,6 +67,26 @@ namespace clan
 		map_user_projection
 	};
 
+	/// \brief Vertex data uploaded by the canvas sprite and triangle batcher.
+	class CanvasBatchStatistics
+	{
+	public:
+		/// \brief Vertices uploaded by the most recent flush.
+		int last_flush_vertices = 0;
+
+		/// \brief Bytes of vertex data uploaded by the most recent flush.
+		int last_flush_bytes = 0;
+
+		/// \brief Number of flushes since the statistics were last reset.
+		int flushes = 0;
+
+		/// \brief Vertices uploaded since the statistics were last reset.
+		uint64_t total_vertices = 0;
+
+		/// \brief Bytes of vertex data uploaded since the statistics were last reset.
+		uint64_t total_bytes = 0;
+	};
+
 	/// \brief 2D Graphics Canvas
 	class Canvas
 	{
@@ -122,6 +142,11 @@ namespace clan
 		/// \brief Returns the current clipping rectangle
 		Rectf get_cliprect() const;
 
+		/// \brief Returns how much vertex data the sprite and triangle batcher has uploaded.
+		///
+		/// The batcher is shared by all canvases using the same graphic context.
+		CanvasBatchStatistics get_batch_statistics() const;
+
 		/// \brief Return the content of the read buffer into a pixel buffer.
 		PixelBuffer get_pixeldata(const Rect& rect, TextureFormat texture_format = tf_rgba8, bool clamp = true);
 
@@ -210,6 +235,9 @@ namespace clan
 		/// \brief Flushes the render batcher currently active.
 		void flush();
 
+		/// \brief Resets the counters returned by get_batch_statistics.
+		void reset_batch_statistics();
+
 		/// \brief Draw a point.
 		void draw_point(float x1, float y1, const Colorf &color);
 
@@ -42,6 +42,7 @@ namespace clan
 	class Canvas;
 	class Pen;
 	class Brush;
+	class PixelBuffer;
 
 	enum class PathFillMode
 	{
@@ -70,6 +71,11 @@ namespace clan
 		/// \brief Fills a path
 		void fill(Canvas &canvas, const Brush &brush);
 
+		/// \brief Fills a path into a pixel buffer on the CPU
+		///
+		/// The color is blended source-over with analytic anti-aliasing. Only tf_rgba8 and tf_bgra8 pixel buffers are supported.
+		void fill(PixelBuffer &pixels, const Colorf &color);
+
 		/// \brief First fills a path, then strokes on top
 		void fill_and_stroke(Canvas &canvas, const Pen &pen, const Brush &brush);
 
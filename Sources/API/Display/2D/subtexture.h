@@ -69,6 +69,8 @@ namespace clan
 
 	private:
 		std::shared_ptr<Subtexture_Impl> impl;
+
+		friend class TextureGroup_Impl;
 	};
 
 	/// \}
@@ -30,6 +30,8 @@
 #pragma once
 
 #include <memory>
+#include <vector>
+#include "../../Core/Math/rect_packer.h"
 
 namespace clan
 {
@@ -58,7 +60,10 @@ namespace clan
 		TextureGroup();
 
 		/// \brief Constructs a texture group
-		TextureGroup(const Size &texture_sizes);
+		///
+		/// \param texture_sizes = Size of the textures allocated by the group
+		/// \param algorithm = Algorithm used to place sub-textures within each texture
+		TextureGroup(const Size &texture_sizes, RectPacker::PackingAlgorithm algorithm = RectPacker::guillotine);
 
 		~TextureGroup();
 
@@ -87,16 +92,29 @@ namespace clan
 		/// \brief Returns the textures.
 		std::vector<Texture2D> get_textures() const;
 
+		/// \brief Returns the packing algorithm used within each texture.
+		RectPacker::PackingAlgorithm get_packing_algorithm() const;
+
+		/// \brief Returns the area used by sub-textures divided by the area of all textures, between 0 and 1.
+		float get_packing_efficiency() const;
+
 		/// \brief Allocate space for another sub texture.
 		Subtexture add(GraphicContext &context, const Size &size);
 
 		/// \brief Deallocate space, from a previously allocated texture
 		///
-		/// Warning - It is advised to set TextureAllocationPolicy to search_previous_textures
-		/// if using this function.  Also be aware of texture fragmentation.
-		/// Empty textures are not removed.
+		/// The space is reused by later allocations. It is advised to set TextureAllocationPolicy
+		/// to search_previous_textures if using this function. Textures that become empty are released.
 		void remove(Subtexture &subtexture);
 
+		/// \brief Move the sub-textures of the least used textures into free space in the other textures.
+		///
+		/// Pixels are copied on the GPU. Subtexture objects returned by add() are updated to
+		/// the new texture and geometry; copies of their texture or geometry made elsewhere are not.
+		/// \param max_textures = Maximum amount of textures to release in this pass
+		/// \return The amount of textures released
+		int defragment(GraphicContext &context, int max_textures = 1);
+
 		/// \brief Set the texture allocation policy.
 		void set_texture_allocation_policy(TextureAllocationPolicy policy);
 
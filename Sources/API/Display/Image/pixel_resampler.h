@@ -0,0 +1,117 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <memory>
+#include "texture_format.h"
+
+namespace clan
+{
+	/// \addtogroup clanDisplay_Display clanDisplay Display
+	/// \{
+
+	class PixelBuffer;
+	class PixelBufferSet;
+	class WorkQueue;
+	class PixelResampler_Impl;
+
+	/// \brief Filter used by PixelResampler
+	enum PixelResampleFilter
+	{
+		/// \brief Averages the pixels covered by each destination pixel. Same result as a GPU generated mipmap.
+		resample_box,
+
+		/// \brief Three lobe Lanczos windowed sinc. Sharpest, with some ringing at hard edges.
+		resample_lanczos3,
+
+		/// \brief Kaiser windowed sinc (width 3, alpha 4). Sharper than box with less ringing than Lanczos.
+		resample_kaiser
+	};
+
+	/// \brief Scales pixel buffers and generates mipmap chains on the CPU.
+	///
+	/// Pixels are filtered as 32 bit floats. The color channels of sRGB formats are converted to linear light
+	/// before filtering and back afterwards, so mipmaps keep the brightness of the original image.
+	/// Colors are weighted by alpha while filtering, so fully transparent pixels do not bleed into their neighbours.
+	///
+	/// The image is processed in tiles. With a WorkQueue the tiles are filtered on its worker threads.
+	/// Compressed and GPU pixel buffers are not supported.
+	class PixelResampler
+	{
+	public:
+		/// \brief Constructs a resampler that filters on the calling thread
+		PixelResampler();
+
+		/// \brief Constructs a resampler that filters tiles on the threads of work_queue
+		PixelResampler(WorkQueue &work_queue);
+
+		~PixelResampler();
+
+		/// \brief Returns the filter
+		PixelResampleFilter get_filter() const;
+
+		/// \brief Returns true if all formats are treated as sRGB encoded
+		bool get_srgb() const;
+
+		/// \brief Returns true if the color channels are already premultiplied by alpha
+		bool get_premultiplied_alpha() const;
+
+		/// \brief Set the filter
+		///
+		/// This defaults to resample_box.
+		void set_filter(PixelResampleFilter filter);
+
+		/// \brief Treat the color channels as sRGB encoded, regardless of the texture format
+		///
+		/// Useful for images loaded without the sRGB flag. tf_srgb8 and tf_srgb8_alpha8 are always filtered in linear light.
+		/// This defaults to off.
+		void set_srgb(bool enable);
+
+		/// \brief Set if the color channels are already premultiplied by alpha
+		///
+		/// This defaults to off.
+		void set_premultiplied_alpha(bool enable);
+
+		/// \brief Returns a copy of the image scaled to the specified size, in the format of the image
+		PixelBuffer resample(const PixelBuffer &image, int width, int height);
+
+		/// \brief Creates a 2D image set with the image as level 0, followed by a complete mipmap chain down to 1x1
+		PixelBufferSet create_mipmaps(const PixelBuffer &image);
+
+		/// \brief Replaces level 1 and up of every slice with a mipmap chain generated from level 0 of the slice
+		///
+		/// Each slice is filtered on its own, which is correct for arrays and cube maps. 3D textures are not supported.
+		void generate_mipmaps(PixelBufferSet &image_set);
+
+	private:
+		std::shared_ptr<PixelResampler_Impl> impl;
+	};
+
+	/// \}
+}
@@ -37,6 +37,7 @@ namespace clan
 	/// \{
 
 	class FileSystem;
+	class WorkQueue;
 
 	/// \brief Image provider that can load JPEG (.jpg) files.
 	class JPEGProvider
@@ -59,6 +60,21 @@ namespace clan
 			IODevice &file,
 			bool srgb = false);
 
+		/// \brief Load using worker threads
+		///
+		/// Baseline images are transformed and colour converted on the worker threads one MCU row at a time
+		/// while the calling thread decodes the entropy coded data. Images with restart markers have their
+		/// restart intervals decoded in parallel.
+		static PixelBuffer load(
+			IODevice &file,
+			bool srgb,
+			WorkQueue &work_queue);
+
+		static PixelBuffer load(
+			const std::string &fullname,
+			bool srgb,
+			WorkQueue &work_queue);
+
 		/// \brief Save the given PixelBuffer into a JPEG
 		///
 		/// \param buffer The PixelBuffer to save, format doesn't matter its converted if needed
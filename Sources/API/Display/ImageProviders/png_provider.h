@@ -37,6 +37,7 @@ namespace clan
 	/// \{
 
 	class FileSystem;
+	class WorkQueue;
 
 	/// \brief Surface provider that can load PNG (.png) files.
 	class PNGProvider
@@ -62,6 +63,23 @@ namespace clan
 		/// \return Pixel Buffer
 		static PixelBuffer load(IODevice &dev, bool srgb = false);
 
+		/// \brief Load using worker threads
+		///
+		/// The image data is inflated on the calling thread while unfiltering and colour conversion
+		/// of the already inflated rows (or Adam7 passes) run on the worker threads of the work queue.
+		///
+		/// \param dev = IODevice
+		/// \param srgb = Load the image as sRGB
+		/// \param work_queue = Work queue used for decoding
+		///
+		/// \return Pixel Buffer
+		static PixelBuffer load(IODevice &dev, bool srgb, WorkQueue &work_queue);
+
+		static PixelBuffer load(
+			const std::string &fullname,
+			bool srgb,
+			WorkQueue &work_queue);
+
 		/// \brief Called to save a given PixelBuffer to a file
 		static void save(
 			PixelBuffer buffer,
@@ -0,0 +1,104 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace clan
+{
+	/// \addtogroup clanDisplay_Display clanDisplay Display
+	/// \{
+
+	class GraphicContext;
+
+	/// \brief Work submitted to a recording graphic context.
+	class RecordingStatistics
+	{
+	public:
+		/// \brief Number of display window flips.
+		int frames = 0;
+
+		/// \brief Number of draw and dispatch calls.
+		int draw_calls = 0;
+
+		/// \brief Vertices or indices submitted by draw calls, including instances.
+		uint64_t vertices = 0;
+
+		/// \brief Number of clear calls.
+		int clears = 0;
+
+		/// \brief Number of state changes (programs, textures, buffers, render states, scissor and viewport).
+		int state_changes = 0;
+
+		/// \brief Number of GPU resources allocated.
+		int resources_created = 0;
+
+		/// \brief Number of uploads to vertex, element, uniform, storage and transfer buffers.
+		int buffer_uploads = 0;
+
+		/// \brief Bytes uploaded to buffers.
+		uint64_t buffer_bytes = 0;
+
+		/// \brief Number of uploads to textures.
+		int texture_uploads = 0;
+
+		/// \brief Bytes uploaded to textures.
+		uint64_t texture_bytes = 0;
+	};
+
+	/// \brief Display target that records rendering commands in memory instead of drawing them.
+	///
+	/// No window system or graphics driver is needed, which makes it possible to measure the CPU
+	/// cost of the 2D and UI renderers. The graphic context reports itself as a GLSL target.
+	class RecordingTarget
+	{
+	public:
+		/// \brief Returns true if this display target is the current target
+		static bool is_current();
+
+		/// \brief Set this display target to be the current target
+		static void set_current();
+
+		/// \brief Returns the work recorded by a graphic context since the statistics were last reset.
+		static RecordingStatistics get_statistics(const GraphicContext &gc);
+
+		/// \brief Resets the statistics and clears the command log
+		static void reset_statistics(const GraphicContext &gc);
+
+		/// \brief Enables or disables logging of each command submitted to the graphic context
+		static void set_command_log_enabled(const GraphicContext &gc, bool enable);
+
+		/// \brief Returns the commands logged since the statistics were last reset, one per line.
+		static std::vector<std::string> get_command_log(const GraphicContext &gc);
+	};
+
+	/// \}
+}
@@ -30,6 +30,8 @@
 
 #include "../../Core/Resources/resource.h"
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace clan
 {
@@ -45,6 +47,16 @@ namespace clan
 	class Font;
 	class FontDescription;
 
+	/// \brief Progress of an asynchronously requested resource
+	enum class ResourceLoadState
+	{
+		none,        // Never requested asynchronously
+		pending,     // Waiting to be read, decoded or uploaded
+		loaded,      // The resource placeholders have been updated
+		failed,      // The resource could not be loaded
+		cancelled    // The request was cancelled before it finished
+	};
+
 	class DisplayCache
 	{
 	public:
@@ -54,6 +66,44 @@ namespace clan
 		virtual Resource<Texture> get_texture(GraphicContext &gc, const std::string &id) = 0;
 		virtual Resource<Font> get_font(Canvas &canvas, const std::string &family_name, const FontDescription &desc) = 0;
 
+		/// \brief Requests a sprite without blocking on file access or image decoding
+		///
+		/// Returns a placeholder holding a null sprite until process_loads() fills it in, after which
+		/// Resource::updated() reports the change. Requests with a higher priority are decoded and uploaded first.
+		/// If the file can't be read or decoded, process_loads() sets the placeholder to a null sprite instead,
+		/// so Resource::updated() reports that too, and get_load_state() returns ResourceLoadState::failed.
+		/// The default implementation loads synchronously.
+		virtual Resource<Sprite> get_sprite_async(Canvas &canvas, const std::string &id, int /*priority*/ = 0) { return get_sprite(canvas, id); }
+
+		/// \brief Requests an image without blocking on file access or image decoding
+		virtual Resource<Image> get_image_async(Canvas &canvas, const std::string &id, int /*priority*/ = 0) { return get_image(canvas, id); }
+
+		/// \brief Requests a texture without blocking on file access or image decoding
+		virtual Resource<Texture> get_texture_async(GraphicContext &gc, const std::string &id, int /*priority*/ = 0) { return get_texture(gc, id); }
+
+		/// \brief Starts loading a list of texture resources in the background
+		virtual void prefetch(GraphicContext &gc, const std::vector<std::string> &ids, int /*priority*/ = 0) { for (const auto &id : ids) get_texture(gc, id); }
+
+		/// \brief Changes the priority of a pending request
+		virtual void set_priority(const std::string & /*id*/, int /*priority*/) { }
+
+		/// \brief Cancels a pending request. Placeholders already handed out stay empty.
+		virtual void cancel(const std::string & /*id*/) { }
+
+		/// \brief Returns how far an asynchronous request has come
+		virtual ResourceLoadState get_load_state(const std::string & /*id*/) const { return ResourceLoadState::none; }
+
+		/// \brief Returns the number of asynchronous requests that have not finished yet
+		virtual int get_pending_loads() const { return 0; }
+
+		/// \brief Uploads decoded resources to the GPU and updates their placeholders
+		///
+		/// Placeholders of requests that failed are updated with a null value.
+		/// Must be called on the thread owning the graphic context, typically once per frame.
+		/// Returns when all decoded resources are uploaded or when the time budget is spent.
+		/// \param budget_microseconds Time to spend uploading. At least one step of work is always done.
+		virtual void process_loads(GraphicContext & /*gc*/, int /*budget_microseconds*/ = 2000) { }
+
 		static DisplayCache &get(const ResourceManager &resources);
 		static void set(ResourceManager &resources, const std::shared_ptr<DisplayCache> &cache);
 	};
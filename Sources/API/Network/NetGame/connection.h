@@ -39,6 +39,7 @@ namespace clan
 
 	class NetGameConnectionSite;
 	class NetGameConnection_Impl;
+	class NetGameReactor;
 	class SocketName;
 	class TCPConnection;
 
@@ -82,11 +83,16 @@ namespace clan
 		SocketName get_remote_name() const;
 
 	private:
+		/// \brief Constructs a connection serviced by a NetGameServer reactor instead of its own thread
+		NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor);
+
 		/// \brief Disallow copy constructors
 		NetGameConnection(NetGameConnection &other) = delete;
 		NetGameConnection &operator =(const NetGameConnection &other) = delete;
 
 		NetGameConnection_Impl *impl;
+
+		friend class NetGameServer;
 	};
 
 	/// \}
@@ -63,6 +63,8 @@ namespace clan
 	private:
 		std::string name;
 		std::vector<NetGameEventValue> arguments;
+
+		friend class NetGameNetworkData;
 	};
 
 	/// \}
@@ -247,6 +247,8 @@ namespace clan
 		std::string value_string;
 		DataBuffer value_binary;
 		std::vector<NetGameEventValue> value_complex;
+
+		friend class NetGameNetworkData;
 	};
 
 	/// \}
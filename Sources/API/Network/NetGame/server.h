@@ -42,11 +42,27 @@ namespace clan
 	class NetGameConnection;
 	class NetGameServer_Impl;
 
+	/// \brief How NetGameServer services its client connections
+	enum NetGameServerMode
+	{
+		/// \brief Each connection runs on its own thread
+		netgame_server_thread_per_connection,
+
+		/// \brief Connections are multiplexed on a pool of epoll I/O threads
+		///
+		/// Only available on Linux. Other platforms fall back to netgame_server_thread_per_connection.
+		netgame_server_reactor
+	};
+
 	/// \brief NetGameServer
 	class NetGameServer : NetGameConnectionSite
 	{
 	public:
-		NetGameServer();
+		/// \brief Constructs a NetGameServer
+		///
+		/// \param mode = Connection servicing mode
+		/// \param num_io_threads = I/O threads used by netgame_server_reactor (0 = one per core)
+		NetGameServer(NetGameServerMode mode = netgame_server_thread_per_connection, int num_io_threads = 0);
 		~NetGameServer();
 
 		/// \brief Start
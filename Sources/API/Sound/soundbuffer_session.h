@@ -41,6 +41,16 @@ namespace clan
 	class SoundBuffer_Session_Impl;
 	class SoundOutput;
 
+	/// \brief Sample rate conversion used when a session plays at a different frequency than the sound output
+	enum SoundResampleQuality
+	{
+		/// \brief Linear interpolation between neighbouring samples
+		resample_linear,
+
+		/// \brief Polyphase windowed sinc filter. Higher quality at a higher mixing cost.
+		resample_sinc
+	};
+
 	/// \brief SoundBuffer_Session provides control over a playing soundeffect.
 	///
 	///    <p>Whenever a soundbuffer is played, it returns a SoundBuffer_Session
@@ -85,6 +95,9 @@ namespace clan
 		///    is playing at "max" volume.
 		float get_volume() const;
 
+		/// \brief Returns the sample rate conversion quality of the session.
+		SoundResampleQuality get_resample_quality() const;
+
 		/// \brief Returns the current pan (in a measure from -1 -> 1).
 		///
 		/// -1 means the soundeffect is only playing in the left speaker,
@@ -127,6 +140,11 @@ namespace clan
 		/// \param new_freq New frequency of session.
 		void set_frequency(int new_freq);
 
+		/// \brief Sets the sample rate conversion quality of the session.
+		///
+		/// The default is resample_linear. Sessions playing at the mixing frequency are copied without conversion.
+		void set_resample_quality(SoundResampleQuality quality);
+
 		/// \brief Sets the volume of the session in a relative measure (0->1)
 		///
 		/// A value of 0 will effectively mute the sound (although it will
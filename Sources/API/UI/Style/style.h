@@ -33,6 +33,7 @@
 #include "../../Display/2D/color.h"
 #include "style_get_value.h"
 #include <memory>
+#include <cstdint>
 
 namespace clan
 {
@@ -68,6 +69,11 @@ namespace clan
 		StyleGetValue declared_value(const char *property_name) const;
 		StyleGetValue declared_value(const std::string &property_name) const { return declared_value(property_name.c_str()); }
 
+		/// Number that changes every time a property is set
+		///
+		/// Renderers use this to find out if output cached for the style is still valid.
+		uint64_t generation() const;
+
 		/// Static helper that generates a "rgba(%1,%2,%3,%4)" string for the given color.
 		static std::string to_rgba(const Colorf &c)
 		{
@@ -37,6 +37,29 @@ namespace clan
 	class Canvas;
 	class ViewTreeImpl;
 
+	/// Counters for the retained rendering of a view tree
+	class ViewRenderStatistics
+	{
+	public:
+		/// Views whose background and border were drawn from their cached display list
+		int cache_hits = 0;
+
+		/// Views whose display list had to be built because their style or geometry changed
+		int cache_misses = 0;
+
+		/// Views rendered, including views only partially inside a damaged region
+		int views_rendered = 0;
+
+		/// Views whose children were laid out again because the view was resized or something below it changed
+		int views_laid_out = 0;
+
+		/// Regions rendered, one for each damaged region or full render
+		int damage_rects = 0;
+
+		/// Total area of the rendered regions, in canvas pixels
+		float damage_area = 0.0f;
+	};
+
 	/// Base class for managing a tree of views
 	class ViewTree
 	{
@@ -80,6 +103,12 @@ namespace clan
 			return add_child<View>();
 		}
 
+		/// Counters accumulated since the statistics were last reset
+		const ViewRenderStatistics &render_statistics() const;
+
+		/// Resets the render counters
+		void reset_render_statistics();
+
 	protected:
 		/// Set or clears the focus
 		void set_focus_view(View *view);
@@ -87,6 +116,12 @@ namespace clan
 		/// Renders view into the specified canvas
 		void render(Canvas &canvas, const Rectf &margin_box);
 
+		/// Lays out the views if needed and returns the regions of the canvas that must be rendered again
+		///
+		/// The returned damage is cleared. Rendering only these regions, clipped, gives the same result as
+		/// rendering everything when the canvas kept the output of the previous render.
+		std::vector<Rectf> update_damage(Canvas &canvas, const Rectf &margin_box);
+
 		/// Dispatch activation change event to all views
 		void dispatch_activation_change(ActivationChangeType type);
 
@@ -362,5 +362,6 @@ namespace clan
 		friend class ViewTree;
 		friend class ViewImpl;
 		friend class ViewAction;
+		friend class PositionedLayout;
 	};
 }
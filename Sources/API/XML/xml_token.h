@@ -31,6 +31,8 @@
 
 #include <vector>
 #include <utility>
+#include <string>
+#include <cstring>
 
 namespace clan
 {
@@ -85,5 +87,53 @@ namespace clan
 		std::vector<Attribute> attributes;
 	};
 
+	/// \brief Characters of a token returned by XMLTokenizer, not null terminated.
+	class XMLStringView
+	{
+	public:
+		XMLStringView() : data(nullptr), length(0) { }
+		XMLStringView(const char *data, size_t length) : data(data), length(length) { }
+
+		const char *data;
+		size_t length;
+
+		bool empty() const { return length == 0; }
+		std::string to_string() const { return std::string(data, length); }
+
+		bool operator==(const char *text) const { return strlen(text) == length && memcmp(data, text, length) == 0; }
+		bool operator==(const std::string &text) const { return text.length() == length && memcmp(data, text.data(), length) == 0; }
+		bool operator!=(const char *text) const { return !(*this == text); }
+		bool operator!=(const std::string &text) const { return !(*this == text); }
+	};
+
+	/// \brief XML token referring directly to the tokenizer input.
+	///
+	/// Names and values point into the input buffer of the tokenizer, or into its decode buffer for
+	/// values that contained entities. They are only valid until the next token is read.
+	class XMLTokenView
+	{
+	public:
+		XMLTokenView() : type(XMLToken::NULL_TOKEN), variant(XMLToken::SINGLE)
+		{
+		}
+
+		typedef std::pair<XMLStringView, XMLStringView> Attribute;
+
+		/// \brief The token type.
+		XMLToken::TokenType type;
+
+		/// \brief The token variant.
+		XMLToken::TokenVariant variant;
+
+		/// \brief The name of the token.
+		XMLStringView name;
+
+		/// \brief The value of the token.
+		XMLStringView value;
+
+		/// \brief All the attributes attached to the token.
+		std::vector<Attribute> attributes;
+	};
+
 	/// \}
 }
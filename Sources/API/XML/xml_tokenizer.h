@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <cstddef>
 
 namespace clan
 {
@@ -38,6 +39,7 @@ namespace clan
 
 	class IODevice;
 	class XMLToken;
+	class XMLTokenView;
 	class XMLTokenizer_Impl;
 
 	/// \brief The XML Tokenizer breaks a XML file into XML tokens.
@@ -53,9 +55,15 @@ namespace clan
 
 		/// \brief Constructs a XMLTokenizer
 		///
+		/// The device is read in chunks as tokens are requested.
 		/// \param input = IODevice
 		XMLTokenizer(IODevice &input);
 
+		/// \brief Constructs a XMLTokenizer over a memory span, such as a mapped file
+		///
+		/// The data is not copied and must outlive the tokenizer.
+		XMLTokenizer(const void *data, size_t length);
+
 		virtual ~XMLTokenizer();
 
 		/// \brief Returns true if eat whitespace flag is set.
@@ -72,6 +80,12 @@ namespace clan
 		/// \param out_token = XMLToken
 		void next(XMLToken *out_token);
 
+		/// \brief Returns the next token without copying its text
+		///
+		/// Entities are only decoded for text that contains them. The token is valid until the next call.
+		/// \param out_token = XMLTokenView
+		void next(XMLTokenView *out_token);
+
 	private:
 		std::shared_ptr<XMLTokenizer_Impl> impl;
 	};
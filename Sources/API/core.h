@@ -73,6 +73,7 @@
 #include "Core/System/userdata.h"
 #include "Core/System/game_time.h"
 #include "Core/System/work_queue.h"
+#include "Core/System/task_group.h"
 #include "Core/ErrorReporting/crash_reporter.h"
 #include "Core/ErrorReporting/exception_dialog.h"
 #include "Core/Signals/signal.h"
@@ -82,7 +83,9 @@
 #include "Core/Resources/resource_manager.h"
 #include "Core/Resources/file_resource_document.h"
 #include "Core/Resources/file_resource_manager.h"
+#include "Core/JSON/json_reader.h"
 #include "Core/JSON/json_value.h"
+#include "Core/JSON/json_writer.h"
 #include "Core/IOData/file.h"
 #include "Core/IOData/file_help.h"
 #include "Core/IOData/path_help.h"
@@ -130,6 +133,7 @@
 #include "Core/Math/big_int.h"
 #include "Core/Math/frustum_planes.h"
 #include "Core/Math/intersection_test.h"
+#include "Core/Math/batch_math.h"
 #include "Core/Math/aabb.h"
 #include "Core/Math/obb.h"
 #include "Core/Math/easing.h"
@@ -149,6 +153,10 @@
 #include "Core/Crypto/aes192_decrypt.h"
 #include "Core/Crypto/aes256_encrypt.h"
 #include "Core/Crypto/aes256_decrypt.h"
+#include "Core/Crypto/aes_ctr.h"
+#include "Core/Crypto/aes_gcm_encrypt.h"
+#include "Core/Crypto/aes_gcm_decrypt.h"
+#include "Core/Crypto/tree_hash.h"
 #include "Core/Crypto/rsa.h"
 #include "Core/Crypto/tls_client.h"
 #include "Core/Math/size.h"
@@ -69,6 +69,7 @@
 #include "Display/Image/perlin_noise.h"
 #include "Display/Image/image_import_description.h"
 #include "Display/Image/pixel_converter.h"
+#include "Display/Image/pixel_resampler.h"
 #include "Display/ImageProviders/jpeg_provider.h"
 #include "Display/ImageProviders/png_provider.h"
 #include "Display/ImageProviders/provider_factory.h"
@@ -110,6 +111,7 @@
 #include "Display/Render/texture_cube_array.h"
 #include "Display/Render/vertex_array_buffer.h"
 #include "Display/Render/vertex_array_vector.h"
+#include "Display/Recording/recording_target.h"
 #include "Display/ShaderEffect/shader_effect.h"
 #include "Display/ShaderEffect/shader_effect_description.h"
 #include "Display/TargetProviders/cursor_provider.h"
@@ -28,6 +28,7 @@
 
 #include "Core/precomp.h"
 #include "aes192_encrypt_impl.h"
+#include "aes_ni.h"
 #include "API/Core/Math/cl_math.h"
 
 #ifndef WIN32
@@ -38,6 +39,7 @@ namespace clan
 {
 	AES192_Encrypt_Impl::AES192_Encrypt_Impl() : initialisation_vector_set(false), cipher_key_set(false), padding_enabled(true), padding_pkcs7(true), padding_num_additional_padded_blocks(0)
 	{
+		use_aesni = AES_NI::is_supported();
 		reset();
 	}
 
@@ -77,6 +79,8 @@ namespace clan
 	{
 		cipher_key_set = true;
 		extract_encrypt_key192(key, key_expanded);
+		if (use_aesni)
+			AES_NI::convert_key(key_expanded, aes192_num_rounds_nr, round_keys);
 	}
 
 	void AES192_Encrypt_Impl::add(const void *_data, int size)
@@ -94,6 +98,14 @@ namespace clan
 		int pos = 0;
 		while (pos < size)
 		{
+			if (use_aesni && chunk_filled == 0 && size - pos >= aes192_block_size_bytes)
+			{
+				int num_blocks = (size - pos) / aes192_block_size_bytes;
+				process_blocks(data + pos, num_blocks);
+				pos += num_blocks * aes192_block_size_bytes;
+				continue;
+			}
+
 			int data_left = size - pos;
 			int buffer_space = aes192_block_size_bytes - chunk_filled;
 			int data_used = min(buffer_space, data_left);
@@ -143,7 +155,8 @@ namespace clan
 		calculated = true;
 		initialisation_vector_set = false;	// Force to reset after each call
 		cipher_key_set = false;				// Force to reset after each call (to avoid keeping the cipher key in memory)
-		memset(key_expanded, 0, sizeof(key_expanded));	// Remove the key from memory
+		memset(key_expanded, 0, sizeof(key_expanded));
+		memset(round_keys, 0, sizeof(round_keys));	// Remove the key from memory
 	}
 
 	void AES192_Encrypt_Impl::process_chunk()
@@ -239,4 +252,21 @@ namespace clan
 		initialisation_vector_3 = s2;
 		initialisation_vector_4 = s3;
 	}
+
+	void AES192_Encrypt_Impl::process_blocks(const unsigned char *data, int num_blocks)
+	{
+		unsigned char iv[aes192_block_size_bytes];
+		put_word(initialisation_vector_1, iv);
+		put_word(initialisation_vector_2, iv + 4);
+		put_word(initialisation_vector_3, iv + 8);
+		put_word(initialisation_vector_4, iv + 12);
+
+		unsigned char *output = append_data(databuffer, num_blocks * aes192_block_size_bytes);
+		AES_NI::encrypt_cbc(round_keys, aes192_num_rounds_nr, iv, data, output, num_blocks);
+
+		initialisation_vector_1 = get_word(iv);
+		initialisation_vector_2 = get_word(iv + 4);
+		initialisation_vector_3 = get_word(iv + 8);
+		initialisation_vector_4 = get_word(iv + 12);
+	}
 }
@@ -80,9 +80,13 @@ namespace clan
 
 	private:
 		void process_chunk();
+		void process_blocks(const unsigned char *data, int num_blocks);
 
 		uint32_t key_expanded[aes256_nb_mult_nr_plus1];
 
+		bool use_aesni;
+		unsigned char round_keys[aes256_nb_mult_nr_plus1 * 4];
+
 		unsigned char chunk[aes256_block_size_bytes];
 		uint32_t initialisation_vector_1;
 		uint32_t initialisation_vector_2;
@@ -0,0 +1,171 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "aes_ctr_impl.h"
+#include "aes_ni.h"
+
+#ifndef WIN32
+#include <cstring>
+#endif
+
+namespace clan
+{
+	AES_CTR_Impl::AES_CTR_Impl() : num_rounds(0), keystream_used(16), initialisation_vector_set(false), cipher_key_set(false)
+	{
+		use_aesni = AES_NI::is_supported();
+		memset(counter, 0, sizeof(counter));
+		memset(keystream, 0, sizeof(keystream));
+	}
+
+	AES_CTR_Impl::~AES_CTR_Impl()
+	{
+		// Remove the key from memory
+		memset(key_expanded, 0, sizeof(key_expanded));
+		memset(round_keys, 0, sizeof(round_keys));
+		memset(keystream, 0, sizeof(keystream));
+	}
+
+	DataBuffer AES_CTR_Impl::get_data() const
+	{
+		return databuffer;
+	}
+
+	void AES_CTR_Impl::reset()
+	{
+		databuffer.set_size(0);
+		memset(counter, 0, sizeof(counter));
+		memset(keystream, 0, sizeof(keystream));
+		keystream_used = 16;
+		initialisation_vector_set = false;
+	}
+
+	void AES_CTR_Impl::set_iv(const unsigned char iv[16])
+	{
+		memcpy(counter, iv, sizeof(counter));
+		keystream_used = 16;
+		initialisation_vector_set = true;
+	}
+
+	void AES_CTR_Impl::set_key(const unsigned char *key, int key_length)
+	{
+		switch (key_length)
+		{
+		case aes128_key_length_bytes:
+			extract_encrypt_key128(key, key_expanded);
+			num_rounds = aes128_num_rounds_nr;
+			break;
+		case aes192_key_length_bytes:
+			extract_encrypt_key192(key, key_expanded);
+			num_rounds = aes192_num_rounds_nr;
+			break;
+		case aes256_key_length_bytes:
+			extract_encrypt_key256(key, key_expanded);
+			num_rounds = aes256_num_rounds_nr;
+			break;
+		default:
+			throw Exception("AES key length must be 16, 24 or 32 bytes");
+		}
+
+		if (use_aesni)
+			AES_NI::convert_key(key_expanded, num_rounds, round_keys);
+
+		cipher_key_set = true;
+	}
+
+	void AES_CTR_Impl::add(const void *data, int size)
+	{
+		if (size <= 0)
+			return;
+		unsigned char *output = append_data(databuffer, size);
+		crypt((const unsigned char *)data, output, size);
+	}
+
+	void AES_CTR_Impl::crypt(const unsigned char *input, unsigned char *output, int size)
+	{
+		if (!initialisation_vector_set)
+			throw Exception("AES initialisation vector has not been set");
+
+		if (!cipher_key_set)
+			throw Exception("AES cipher key has not been set");
+
+		int pos = 0;
+
+		// Use what is left of the previous keystream block
+		while (keystream_used < 16 && pos < size)
+		{
+			output[pos] = input[pos] ^ keystream[keystream_used++];
+			pos++;
+		}
+
+		int num_blocks = (size - pos) / 16;
+		if (use_aesni)
+		{
+			AES_NI::crypt_ctr(round_keys, num_rounds, counter, input + pos, output + pos, num_blocks);
+			pos += num_blocks * 16;
+		}
+		else
+		{
+			for (int block = 0; block < num_blocks; block++)
+			{
+				next_keystream_block();
+				for (int i = 0; i < 16; i++)
+					output[pos + i] = input[pos + i] ^ keystream[i];
+				pos += 16;
+			}
+		}
+
+		if (pos < size)
+		{
+			next_keystream_block();
+			keystream_used = 0;
+			while (pos < size)
+			{
+				output[pos] = input[pos] ^ keystream[keystream_used++];
+				pos++;
+			}
+		}
+	}
+
+	void AES_CTR_Impl::encrypt_block(const unsigned char input[16], unsigned char output[16]) const
+	{
+		AES_Impl::encrypt_block(key_expanded, num_rounds, input, output);
+	}
+
+	void AES_CTR_Impl::next_keystream_block()
+	{
+		encrypt_block(counter, keystream);
+
+		// Increment the last 32 bits of the counter
+		for (int i = 15; i >= 12; i--)
+		{
+			if (++counter[i] != 0)
+				break;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/databuffer.h"
+#include "aes_impl.h"
+
+namespace clan
+{
+	class AES_CTR_Impl : public AES_Impl
+	{
+	public:
+		AES_CTR_Impl();
+		~AES_CTR_Impl();
+
+		DataBuffer get_data() const;
+
+		void reset();
+
+		void set_iv(const unsigned char iv[16]);
+
+		/// \brief Sets the cipher key, 16, 24 or 32 bytes
+		void set_key(const unsigned char *key, int key_length);
+
+		/// \brief Adds data to be encrypted or decrypted, appending the result to the databuffer
+		void add(const void *data, int size);
+
+		/// \brief Encrypts or decrypts size bytes, continuing from the current counter position
+		///
+		/// Input and output may be the same buffer
+		void crypt(const unsigned char *input, unsigned char *output, int size);
+
+		/// \brief Encrypts a single block with the key, not using or changing the counter
+		void encrypt_block(const unsigned char input[16], unsigned char output[16]) const;
+
+		bool is_key_set() const { return cipher_key_set; }
+		bool is_iv_set() const { return initialisation_vector_set; }
+
+	private:
+		void next_keystream_block();
+
+		int num_rounds;
+		uint32_t key_expanded[aes256_nb_mult_nr_plus1];
+
+		bool use_aesni;
+		unsigned char round_keys[aes256_nb_mult_nr_plus1 * 4];
+
+		unsigned char counter[16];
+		unsigned char keystream[16];
+		int keystream_used;
+
+		bool initialisation_vector_set;
+		bool cipher_key_set;
+
+		DataBuffer databuffer;
+	};
+}
@@ -0,0 +1,85 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Crypto/aes_gcm_encrypt.h"
+#include "API/Core/System/databuffer.h"
+#include "aes_gcm_impl.h"
+
+namespace clan
+{
+	AES_GCM_Encrypt::AES_GCM_Encrypt()
+		: impl(std::make_shared<AES_GCM_Impl>(true))
+	{
+	}
+
+	DataBuffer AES_GCM_Encrypt::get_data() const
+	{
+		return impl->get_data();
+	}
+
+	void AES_GCM_Encrypt::reset()
+	{
+		impl->reset();
+	}
+
+	void AES_GCM_Encrypt::set_key(const unsigned char *key, int key_length)
+	{
+		impl->set_key(key, key_length);
+	}
+
+	void AES_GCM_Encrypt::set_iv(const unsigned char *iv, int iv_length)
+	{
+		impl->set_iv(iv, iv_length);
+	}
+
+	void AES_GCM_Encrypt::add_aad(const void *data, int size)
+	{
+		impl->add_aad(data, size);
+	}
+
+	void AES_GCM_Encrypt::add(const void *data, int size)
+	{
+		impl->add(data, size);
+	}
+
+	void AES_GCM_Encrypt::add(const DataBuffer &data)
+	{
+		add(data.get_data(), data.get_size());
+	}
+
+	void AES_GCM_Encrypt::calculate()
+	{
+		impl->calculate();
+	}
+
+	void AES_GCM_Encrypt::get_tag(unsigned char out_tag[tag_size]) const
+	{
+		impl->get_tag(out_tag);
+	}
+}
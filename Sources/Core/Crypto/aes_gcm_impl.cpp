@@ -0,0 +1,304 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "aes_gcm_impl.h"
+#include "aes_ni.h"
+#include "API/Core/Math/cl_math.h"
+
+#ifndef WIN32
+#include <cstring>
+#endif
+
+namespace clan
+{
+	AES_GCM_Impl::AES_GCM_Impl(bool encrypt) : encrypt(encrypt), hash_buffer_filled(0), aad_length(0), data_length(0), data_started(false), calculated(false)
+	{
+		use_clmul = AES_NI::is_clmul_supported();
+		memset(hash_key, 0, sizeof(hash_key));
+		memset(hash_key_powers, 0, sizeof(hash_key_powers));
+		memset(tag_mask, 0, sizeof(tag_mask));
+		memset(tag, 0, sizeof(tag));
+		memset(hash, 0, sizeof(hash));
+		memset(hash_buffer, 0, sizeof(hash_buffer));
+	}
+
+	AES_GCM_Impl::~AES_GCM_Impl()
+	{
+		// Remove the hash key from memory
+		memset(hash_key, 0, sizeof(hash_key));
+		memset(hash_key_powers, 0, sizeof(hash_key_powers));
+		memset(tag_mask, 0, sizeof(tag_mask));
+	}
+
+	DataBuffer AES_GCM_Impl::get_data() const
+	{
+		return databuffer;
+	}
+
+	void AES_GCM_Impl::reset()
+	{
+		calculated = false;
+		data_started = false;
+		aad_length = 0;
+		data_length = 0;
+		hash_buffer_filled = 0;
+		memset(hash, 0, sizeof(hash));
+		memset(tag, 0, sizeof(tag));
+		databuffer.set_size(0);
+		ctr.reset();
+	}
+
+	void AES_GCM_Impl::set_key(const unsigned char *key, int key_length)
+	{
+		ctr.set_key(key, key_length);
+
+		unsigned char zero_block[16] = { 0 };
+		ctr.encrypt_block(zero_block, hash_key);
+		if (use_clmul)
+			AES_NI::ghash_key(hash_key, hash_key_powers);
+	}
+
+	void AES_GCM_Impl::set_iv(const unsigned char *iv, int iv_length)
+	{
+		if (!ctr.is_key_set())
+			throw Exception("AES-GCM cipher key has not been set");
+
+		if (iv_length <= 0)
+			throw Exception("AES-GCM initialisation vector cannot be empty");
+
+		reset();
+
+		unsigned char pre_counter_block[16];
+		if (iv_length == 12)
+		{
+			memcpy(pre_counter_block, iv, 12);
+			pre_counter_block[12] = 0;
+			pre_counter_block[13] = 0;
+			pre_counter_block[14] = 0;
+			pre_counter_block[15] = 1;
+		}
+		else
+		{
+			ghash_update(iv, iv_length);
+			ghash_flush();
+
+			unsigned char length_block[16] = { 0 };
+			uint64_t iv_bits = (uint64_t)iv_length * 8;
+			for (int i = 0; i < 8; i++)
+				length_block[15 - i] = (unsigned char)(iv_bits >> (i * 8));
+			ghash_blocks(length_block, 1);
+
+			memcpy(pre_counter_block, hash, 16);
+			memset(hash, 0, sizeof(hash));
+		}
+
+		ctr.encrypt_block(pre_counter_block, tag_mask);
+
+		// The data is encrypted starting from the block after the pre-counter block
+		for (int i = 15; i >= 12; i--)
+		{
+			if (++pre_counter_block[i] != 0)
+				break;
+		}
+		ctr.set_iv(pre_counter_block);
+	}
+
+	void AES_GCM_Impl::add_aad(const void *data, int size)
+	{
+		if (calculated)
+			reset();
+
+		if (!ctr.is_iv_set())
+			throw Exception("AES-GCM initialisation vector has not been set");
+
+		if (data_started)
+			throw Exception("AES-GCM additional data must be added before the data");
+
+		ghash_update((const unsigned char *)data, size);
+		aad_length += size;
+	}
+
+	void AES_GCM_Impl::add(const void *_data, int size)
+	{
+		if (calculated)
+			reset();
+
+		if (!ctr.is_iv_set())
+			throw Exception("AES-GCM initialisation vector has not been set");
+
+		if (!data_started)
+			start_data();
+
+		const unsigned char *data = (const unsigned char *)_data;
+		unsigned char *output = AES_Impl::append_data(databuffer, size);
+
+		// Encrypt and hash in slices that stay in the L1 cache between the two passes
+		const int slice_size = 4096;
+		for (int pos = 0; pos < size; pos += slice_size)
+		{
+			int length = min(slice_size, size - pos);
+			if (encrypt)
+			{
+				ctr.crypt(data + pos, output + pos, length);
+				ghash_update(output + pos, length);
+			}
+			else
+			{
+				ghash_update(data + pos, length);
+				ctr.crypt(data + pos, output + pos, length);
+			}
+		}
+		data_length += size;
+	}
+
+	void AES_GCM_Impl::calculate()
+	{
+		if (!ctr.is_iv_set())
+			throw Exception("AES-GCM initialisation vector has not been set");
+
+		if (!data_started)
+			start_data();
+		ghash_flush();
+
+		unsigned char length_block[16];
+		uint64_t aad_bits = aad_length * 8;
+		uint64_t data_bits = data_length * 8;
+		for (int i = 0; i < 8; i++)
+		{
+			length_block[7 - i] = (unsigned char)(aad_bits >> (i * 8));
+			length_block[15 - i] = (unsigned char)(data_bits >> (i * 8));
+		}
+		ghash_blocks(length_block, 1);
+
+		for (int i = 0; i < 16; i++)
+			tag[i] = hash[i] ^ tag_mask[i];
+
+		calculated = true;
+
+		// Force a new initialisation vector for the next message, reusing it would reveal the hash key
+		ctr.reset();
+		memset(tag_mask, 0, sizeof(tag_mask));
+	}
+
+	void AES_GCM_Impl::get_tag(unsigned char out_tag[16]) const
+	{
+		memcpy(out_tag, tag, 16);
+	}
+
+	bool AES_GCM_Impl::verify_tag(const unsigned char other_tag[16]) const
+	{
+		unsigned char difference = 0;
+		for (int i = 0; i < 16; i++)
+			difference |= tag[i] ^ other_tag[i];
+		return difference == 0;
+	}
+
+	void AES_GCM_Impl::start_data()
+	{
+		// The additional data is padded with zeros to a whole block
+		ghash_flush();
+		data_started = true;
+	}
+
+	void AES_GCM_Impl::ghash_update(const unsigned char *data, int size)
+	{
+		int pos = 0;
+		if (hash_buffer_filled > 0)
+		{
+			int data_used = min(16 - hash_buffer_filled, size);
+			memcpy(hash_buffer + hash_buffer_filled, data, data_used);
+			hash_buffer_filled += data_used;
+			pos += data_used;
+			if (hash_buffer_filled < 16)
+				return;
+			ghash_blocks(hash_buffer, 1);
+			hash_buffer_filled = 0;
+		}
+
+		int num_blocks = (size - pos) / 16;
+		ghash_blocks(data + pos, num_blocks);
+		pos += num_blocks * 16;
+
+		hash_buffer_filled = size - pos;
+		memcpy(hash_buffer, data + pos, hash_buffer_filled);
+	}
+
+	void AES_GCM_Impl::ghash_flush()
+	{
+		if (hash_buffer_filled > 0)
+		{
+			memset(hash_buffer + hash_buffer_filled, 0, 16 - hash_buffer_filled);
+			ghash_blocks(hash_buffer, 1);
+			hash_buffer_filled = 0;
+		}
+	}
+
+	void AES_GCM_Impl::ghash_blocks(const unsigned char *data, int num_blocks)
+	{
+		if (use_clmul)
+		{
+			AES_NI::ghash(hash_key_powers, hash, data, num_blocks);
+			return;
+		}
+
+		uint64_t key_high = 0, key_low = 0;
+		for (int i = 0; i < 8; i++)
+		{
+			key_high = (key_high << 8) | hash_key[i];
+			key_low = (key_low << 8) | hash_key[i + 8];
+		}
+
+		for (int block = 0; block < num_blocks; block++)
+		{
+			unsigned char x[16];
+			for (int i = 0; i < 16; i++)
+				x[i] = hash[i] ^ data[block * 16 + i];
+
+			// Multiplication in GF(2^128) as described in NIST SP 800-38D, without branching on the data
+			uint64_t z_high = 0, z_low = 0;
+			uint64_t v_high = key_high, v_low = key_low;
+			for (int i = 0; i < 128; i++)
+			{
+				uint64_t bit_mask = 0 - (uint64_t)((x[i >> 3] >> (7 - (i & 7))) & 1);
+				z_high ^= v_high & bit_mask;
+				z_low ^= v_low & bit_mask;
+
+				uint64_t reduce_mask = 0 - (v_low & 1);
+				v_low = (v_low >> 1) | (v_high << 63);
+				v_high = (v_high >> 1) ^ (0xe100000000000000ULL & reduce_mask);
+			}
+
+			for (int i = 0; i < 8; i++)
+			{
+				hash[i] = (unsigned char)(z_high >> (56 - i * 8));
+				hash[i + 8] = (unsigned char)(z_low >> (56 - i * 8));
+			}
+		}
+	}
+}
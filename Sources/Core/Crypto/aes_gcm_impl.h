@@ -0,0 +1,89 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include "API/Core/System/databuffer.h"
+#include "aes_ctr_impl.h"
+
+namespace clan
+{
+	/// \brief Galois/Counter Mode shared by AES_GCM_Encrypt and AES_GCM_Decrypt
+	class AES_GCM_Impl
+	{
+	public:
+		AES_GCM_Impl(bool encrypt);
+		~AES_GCM_Impl();
+
+		DataBuffer get_data() const;
+
+		void reset();
+
+		void set_key(const unsigned char *key, int key_length);
+		void set_iv(const unsigned char *iv, int iv_length);
+
+		void add_aad(const void *data, int size);
+		void add(const void *data, int size);
+
+		/// \brief Finalize and calculate the authentication tag
+		void calculate();
+
+		void get_tag(unsigned char out_tag[16]) const;
+
+		/// \brief Compares the calculated tag in constant time
+		bool verify_tag(const unsigned char tag[16]) const;
+
+	private:
+		void ghash_update(const unsigned char *data, int size);
+		void ghash_flush();
+		void ghash_blocks(const unsigned char *data, int num_blocks);
+		void start_data();
+
+		bool encrypt;
+		AES_CTR_Impl ctr;
+
+		bool use_clmul;
+		unsigned char hash_key[16];
+		unsigned char hash_key_powers[64];
+
+		unsigned char tag_mask[16];
+		unsigned char tag[16];
+		unsigned char hash[16];
+
+		unsigned char hash_buffer[16];
+		int hash_buffer_filled;
+
+		uint64_t aad_length;
+		uint64_t data_length;
+		bool data_started;
+		bool calculated;
+
+		DataBuffer databuffer;
+	};
+}
@@ -161,23 +161,54 @@ namespace clan
 	void AES_Impl::store_block(uint32_t s0, uint32_t s1, uint32_t s2, uint32_t s3, DataBuffer &databuffer)
 	{
 		// (Note AES 128, 192 and 256 all have the same block size)
+		unsigned char *dest_ptr = append_data(databuffer, aes128_block_size_bytes);
 
-		// Store the data
+		put_word(s0, dest_ptr);
+		put_word(s1, dest_ptr + 4);
+		put_word(s2, dest_ptr + 8);
+		put_word(s3, dest_ptr + 12);
+	}
+
+	unsigned char *AES_Impl::append_data(DataBuffer &databuffer, int size)
+	{
 		int current_size = databuffer.get_size();
 		int current_capacity = databuffer.get_capacity();
-		int available = current_capacity - current_size;
-		if (available < aes128_block_size_bytes)	// Increase capacity required
+		if (current_capacity - current_size < size)	// Increase capacity required
 		{
-			databuffer.set_capacity(current_capacity + 1024);	// Increase in blocks of 1K
+			// Grow geometrically so that large payloads are not copied once per kilobyte
+			databuffer.set_capacity(max(current_capacity * 2, current_size + size + 1024));
 		}
-		databuffer.set_size(current_size + aes128_block_size_bytes);
-		unsigned char *dest_ptr = (unsigned char *)databuffer.get_data();
-		dest_ptr += current_size;
+		databuffer.set_size(current_size + size);
+		return (unsigned char *)databuffer.get_data() + current_size;
+	}
 
-		put_word(s0, dest_ptr);
-		put_word(s1, dest_ptr + 4);
-		put_word(s2, dest_ptr + 8);
-		put_word(s3, dest_ptr + 12);
+	void AES_Impl::encrypt_block(const uint32_t *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const
+	{
+		uint32_t s0 = get_word(input) ^ key_expanded[0];
+		uint32_t s1 = get_word(input + 4) ^ key_expanded[1];
+		uint32_t s2 = get_word(input + 8) ^ key_expanded[2];
+		uint32_t s3 = get_word(input + 12) ^ key_expanded[3];
+
+		for (int round = 1; round < num_rounds; round++)
+		{
+			key_expanded += 4;
+			uint32_t t0 = table_e0[s0 >> 24] ^ table_e1[(s1 >> 16) & 0xff] ^ table_e2[(s2 >> 8) & 0xff] ^ table_e3[s3 & 0xff] ^ key_expanded[0];
+			uint32_t t1 = table_e0[s1 >> 24] ^ table_e1[(s2 >> 16) & 0xff] ^ table_e2[(s3 >> 8) & 0xff] ^ table_e3[s0 & 0xff] ^ key_expanded[1];
+			uint32_t t2 = table_e0[s2 >> 24] ^ table_e1[(s3 >> 16) & 0xff] ^ table_e2[(s0 >> 8) & 0xff] ^ table_e3[s1 & 0xff] ^ key_expanded[2];
+			uint32_t t3 = table_e0[s3 >> 24] ^ table_e1[(s0 >> 16) & 0xff] ^ table_e2[(s1 >> 8) & 0xff] ^ table_e3[s2 & 0xff] ^ key_expanded[3];
+			s0 = t0;
+			s1 = t1;
+			s2 = t2;
+			s3 = t3;
+		}
+
+		key_expanded += 4;
+
+		// Apply last round
+		put_word((sbox_substitution_values[(s0 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s1 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s2 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s3)& 0xff] & 0x000000ff) ^ key_expanded[0], output);
+		put_word((sbox_substitution_values[(s1 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s2 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s3 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s0)& 0xff] & 0x000000ff) ^ key_expanded[1], output + 4);
+		put_word((sbox_substitution_values[(s2 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s3 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s0 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s1)& 0xff] & 0x000000ff) ^ key_expanded[2], output + 8);
+		put_word((sbox_substitution_values[(s3 >> 24)] & 0xff000000) ^ (sbox_substitution_values[(s0 >> 16) & 0xff] & 0x00ff0000) ^ (sbox_substitution_values[(s1 >> 8) & 0xff] & 0x0000ff00) ^ (sbox_substitution_values[(s2)& 0xff] & 0x000000ff) ^ key_expanded[3], output + 12);
 	}
 
 	void AES_Impl::extract_decrypt_key(uint32_t *key_expanded, int num_rounds)
@@ -77,6 +77,12 @@ namespace clan
 		void extract_decrypt_key(uint32_t *key_expanded, int num_rounds);
 		void store_block(uint32_t s0, uint32_t s1, uint32_t s2, uint32_t s3, DataBuffer &databuffer);
 
+		/// \brief Grows the databuffer by size bytes, returning a pointer to the added bytes
+		static unsigned char *append_data(DataBuffer &databuffer, int size);
+
+		/// \brief Encrypts a single block using the tables, for key sizes without an unrolled implementation
+		void encrypt_block(const uint32_t *key_expanded, int num_rounds, const unsigned char input[16], unsigned char output[16]) const;
+
 		inline uint32_t get_word(const unsigned char *data) const
 		{
 			return ((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | (data[3]));
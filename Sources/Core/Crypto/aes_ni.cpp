@@ -0,0 +1,327 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/system.h"
+#include "aes_ni.h"
+
+#if !defined(ARM_PLATFORM) && !defined(CL_ARM)
+#define CL_AES_NI
+#include <wmmintrin.h>
+#include <smmintrin.h>
+#endif
+
+// The kernels are compiled for the instructions they use, independent of the flags the library is built with.
+// They are only called after detect_cpu_extension confirmed the CPU supports them.
+#if defined(__GNUC__)
+#define AES_NI_TARGET __attribute__((target("aes,pclmul,sse4.1")))
+#else
+#define AES_NI_TARGET
+#endif
+
+namespace clan
+{
+	bool AES_NI::is_supported()
+	{
+#ifdef CL_AES_NI
+		static bool supported = System::detect_cpu_extension(System::aes) && System::detect_cpu_extension(System::sse4_1);
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	bool AES_NI::is_clmul_supported()
+	{
+#ifdef CL_AES_NI
+		static bool supported = is_supported() && System::detect_cpu_extension(System::pclmul);
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	void AES_NI::convert_key(const uint32_t *key_expanded, int num_rounds, unsigned char *out_round_keys)
+	{
+		for (int i = 0; i < (num_rounds + 1) * 4; i++)
+		{
+			out_round_keys[i * 4] = (unsigned char)(key_expanded[i] >> 24);
+			out_round_keys[i * 4 + 1] = (unsigned char)(key_expanded[i] >> 16);
+			out_round_keys[i * 4 + 2] = (unsigned char)(key_expanded[i] >> 8);
+			out_round_keys[i * 4 + 3] = (unsigned char)(key_expanded[i]);
+		}
+	}
+
+#ifdef CL_AES_NI
+
+	namespace
+	{
+		AES_NI_TARGET inline void load_keys(const unsigned char *round_keys, int num_rounds, __m128i *keys)
+		{
+			for (int i = 0; i <= num_rounds; i++)
+				keys[i] = _mm_loadu_si128((const __m128i*)(round_keys + i * 16));
+		}
+
+		AES_NI_TARGET inline __m128i encrypt_block(const __m128i *keys, int num_rounds, __m128i block)
+		{
+			block = _mm_xor_si128(block, keys[0]);
+			for (int round = 1; round < num_rounds; round++)
+				block = _mm_aesenc_si128(block, keys[round]);
+			return _mm_aesenclast_si128(block, keys[num_rounds]);
+		}
+
+		AES_NI_TARGET inline __m128i decrypt_block(const __m128i *keys, int num_rounds, __m128i block)
+		{
+			block = _mm_xor_si128(block, keys[0]);
+			for (int round = 1; round < num_rounds; round++)
+				block = _mm_aesdec_si128(block, keys[round]);
+			return _mm_aesdeclast_si128(block, keys[num_rounds]);
+		}
+
+		inline uint32_t byte_swap(uint32_t value)
+		{
+			return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+		}
+
+		AES_NI_TARGET inline __m128i byte_reverse(__m128i value)
+		{
+			return _mm_shuffle_epi8(value, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+		}
+
+		// Carry-less multiplication of two byte reversed GHASH values, accumulating the unreduced 256 bit product
+		AES_NI_TARGET inline void clmul_accumulate(__m128i a, __m128i b, __m128i &lo, __m128i &hi)
+		{
+			__m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+			__m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+			__m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+			__m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+			t1 = _mm_xor_si128(t1, t2);
+			lo = _mm_xor_si128(lo, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+			hi = _mm_xor_si128(hi, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+		}
+
+		// Shifts the product one bit left (GHASH uses reflected bit order) and reduces it modulo x^128 + x^7 + x^2 + x + 1
+		AES_NI_TARGET inline __m128i clmul_reduce(__m128i lo, __m128i hi)
+		{
+			__m128i lo_carry = _mm_srli_epi32(lo, 31);
+			__m128i hi_carry = _mm_srli_epi32(hi, 31);
+			lo = _mm_slli_epi32(lo, 1);
+			hi = _mm_slli_epi32(hi, 1);
+			__m128i cross_carry = _mm_srli_si128(lo_carry, 12);
+			hi_carry = _mm_slli_si128(hi_carry, 4);
+			lo_carry = _mm_slli_si128(lo_carry, 4);
+			lo = _mm_or_si128(lo, lo_carry);
+			hi = _mm_or_si128(hi, hi_carry);
+			hi = _mm_or_si128(hi, cross_carry);
+
+			__m128i a = _mm_slli_epi32(lo, 31);
+			__m128i b = _mm_slli_epi32(lo, 30);
+			__m128i c = _mm_slli_epi32(lo, 25);
+			a = _mm_xor_si128(a, b);
+			a = _mm_xor_si128(a, c);
+			b = _mm_srli_si128(a, 4);
+			a = _mm_slli_si128(a, 12);
+			lo = _mm_xor_si128(lo, a);
+
+			__m128i d = _mm_srli_epi32(lo, 1);
+			__m128i e = _mm_srli_epi32(lo, 2);
+			__m128i f = _mm_srli_epi32(lo, 7);
+			d = _mm_xor_si128(d, e);
+			d = _mm_xor_si128(d, f);
+			d = _mm_xor_si128(d, b);
+			lo = _mm_xor_si128(lo, d);
+			return _mm_xor_si128(hi, lo);
+		}
+
+		AES_NI_TARGET inline __m128i gf_multiply(__m128i a, __m128i b)
+		{
+			__m128i lo = _mm_setzero_si128();
+			__m128i hi = _mm_setzero_si128();
+			clmul_accumulate(a, b, lo, hi);
+			return clmul_reduce(lo, hi);
+		}
+	}
+
+	AES_NI_TARGET void AES_NI::encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+	{
+		__m128i keys[15];
+		load_keys(round_keys, num_rounds, keys);
+
+		// Each block depends on the previous ciphertext, so there is nothing to interleave
+		__m128i state = _mm_loadu_si128((const __m128i*)iv);
+		for (int i = 0; i < num_blocks; i++)
+		{
+			state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i*)(input + i * 16)));
+			state = encrypt_block(keys, num_rounds, state);
+			_mm_storeu_si128((__m128i*)(output + i * 16), state);
+		}
+		_mm_storeu_si128((__m128i*)iv, state);
+	}
+
+	AES_NI_TARGET void AES_NI::decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks)
+	{
+		__m128i keys[15];
+		load_keys(round_keys, num_rounds, keys);
+
+		__m128i previous = _mm_loadu_si128((const __m128i*)iv);
+		int i = 0;
+
+		// Decryption of the blocks is independent, so eight are kept in flight to hide the aesdec latency
+		for (; i + 8 <= num_blocks; i += 8)
+		{
+			__m128i ciphertext[8], state[8];
+			for (int j = 0; j < 8; j++)
+			{
+				ciphertext[j] = _mm_loadu_si128((const __m128i*)(input + (i + j) * 16));
+				state[j] = _mm_xor_si128(ciphertext[j], keys[0]);
+			}
+			for (int round = 1; round < num_rounds; round++)
+			{
+				for (int j = 0; j < 8; j++)
+					state[j] = _mm_aesdec_si128(state[j], keys[round]);
+			}
+			for (int j = 0; j < 8; j++)
+			{
+				state[j] = _mm_aesdeclast_si128(state[j], keys[num_rounds]);
+				_mm_storeu_si128((__m128i*)(output + (i + j) * 16), _mm_xor_si128(state[j], j == 0 ? previous : ciphertext[j - 1]));
+			}
+			previous = ciphertext[7];
+		}
+
+		for (; i < num_blocks; i++)
+		{
+			__m128i ciphertext = _mm_loadu_si128((const __m128i*)(input + i * 16));
+			__m128i state = decrypt_block(keys, num_rounds, ciphertext);
+			_mm_storeu_si128((__m128i*)(output + i * 16), _mm_xor_si128(state, previous));
+			previous = ciphertext;
+		}
+
+		_mm_storeu_si128((__m128i*)iv, previous);
+	}
+
+	AES_NI_TARGET void AES_NI::crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks)
+	{
+		__m128i keys[15];
+		load_keys(round_keys, num_rounds, keys);
+
+		__m128i counter_block = _mm_loadu_si128((const __m128i*)counter);
+		uint32_t count = (counter[12] << 24) | (counter[13] << 16) | (counter[14] << 8) | counter[15];
+		int i = 0;
+
+		for (; i + 8 <= num_blocks; i += 8)
+		{
+			__m128i state[8];
+			for (int j = 0; j < 8; j++)
+				state[j] = _mm_xor_si128(_mm_insert_epi32(counter_block, (int)byte_swap(count + j), 3), keys[0]);
+			count += 8;
+
+			for (int round = 1; round < num_rounds; round++)
+			{
+				for (int j = 0; j < 8; j++)
+					state[j] = _mm_aesenc_si128(state[j], keys[round]);
+			}
+			for (int j = 0; j < 8; j++)
+			{
+				state[j] = _mm_aesenclast_si128(state[j], keys[num_rounds]);
+				__m128i data = _mm_loadu_si128((const __m128i*)(input + (i + j) * 16));
+				_mm_storeu_si128((__m128i*)(output + (i + j) * 16), _mm_xor_si128(data, state[j]));
+			}
+		}
+
+		for (; i < num_blocks; i++)
+		{
+			__m128i state = encrypt_block(keys, num_rounds, _mm_insert_epi32(counter_block, (int)byte_swap(count), 3));
+			count++;
+			__m128i data = _mm_loadu_si128((const __m128i*)(input + i * 16));
+			_mm_storeu_si128((__m128i*)(output + i * 16), _mm_xor_si128(data, state));
+		}
+
+		counter[12] = (unsigned char)(count >> 24);
+		counter[13] = (unsigned char)(count >> 16);
+		counter[14] = (unsigned char)(count >> 8);
+		counter[15] = (unsigned char)count;
+	}
+
+	AES_NI_TARGET void AES_NI::ghash_key(const unsigned char h[16], unsigned char *out_powers)
+	{
+		__m128i h1 = byte_reverse(_mm_loadu_si128((const __m128i*)h));
+		__m128i h2 = gf_multiply(h1, h1);
+		__m128i h3 = gf_multiply(h2, h1);
+		__m128i h4 = gf_multiply(h3, h1);
+		_mm_storeu_si128((__m128i*)out_powers, h1);
+		_mm_storeu_si128((__m128i*)(out_powers + 16), h2);
+		_mm_storeu_si128((__m128i*)(out_powers + 32), h3);
+		_mm_storeu_si128((__m128i*)(out_powers + 48), h4);
+	}
+
+	AES_NI_TARGET void AES_NI::ghash(const unsigned char *powers, unsigned char y[16], const unsigned char *input, int num_blocks)
+	{
+		__m128i h1 = _mm_loadu_si128((const __m128i*)powers);
+		__m128i h2 = _mm_loadu_si128((const __m128i*)(powers + 16));
+		__m128i h3 = _mm_loadu_si128((const __m128i*)(powers + 32));
+		__m128i h4 = _mm_loadu_si128((const __m128i*)(powers + 48));
+
+		__m128i x = byte_reverse(_mm_loadu_si128((const __m128i*)y));
+		int i = 0;
+
+		// X4 = (X + B0)*H^4 + B1*H^3 + B2*H^2 + B3*H, with a single reduction for the four products
+		for (; i + 4 <= num_blocks; i += 4)
+		{
+			__m128i b0 = byte_reverse(_mm_loadu_si128((const __m128i*)(input + i * 16)));
+			__m128i b1 = byte_reverse(_mm_loadu_si128((const __m128i*)(input + i * 16 + 16)));
+			__m128i b2 = byte_reverse(_mm_loadu_si128((const __m128i*)(input + i * 16 + 32)));
+			__m128i b3 = byte_reverse(_mm_loadu_si128((const __m128i*)(input + i * 16 + 48)));
+
+			__m128i lo = _mm_setzero_si128();
+			__m128i hi = _mm_setzero_si128();
+			clmul_accumulate(_mm_xor_si128(x, b0), h4, lo, hi);
+			clmul_accumulate(b1, h3, lo, hi);
+			clmul_accumulate(b2, h2, lo, hi);
+			clmul_accumulate(b3, h1, lo, hi);
+			x = clmul_reduce(lo, hi);
+		}
+
+		for (; i < num_blocks; i++)
+		{
+			__m128i block = byte_reverse(_mm_loadu_si128((const __m128i*)(input + i * 16)));
+			x = gf_multiply(_mm_xor_si128(x, block), h1);
+		}
+
+		_mm_storeu_si128((__m128i*)y, byte_reverse(x));
+	}
+
+#else
+
+	void AES_NI::encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks) { }
+	void AES_NI::decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks) { }
+	void AES_NI::crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks) { }
+	void AES_NI::ghash_key(const unsigned char h[16], unsigned char *out_powers) { }
+	void AES_NI::ghash(const unsigned char *powers, unsigned char y[16], const unsigned char *input, int num_blocks) { }
+
+#endif
+}
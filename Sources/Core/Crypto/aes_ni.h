@@ -0,0 +1,60 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+namespace clan
+{
+	/// \brief AES and GHASH kernels using the AES-NI and PCLMULQDQ instructions
+	///
+	/// Round keys are stored as 16 bytes per round in the byte order of the AES specification.
+	/// Decryption uses the equivalent inverse cipher keys produced by AES_Impl::extract_decrypt_key.
+	/// The kernels must only be called when is_supported() (and is_clmul_supported() for ghash) returns true.
+	class AES_NI
+	{
+	public:
+		static bool is_supported();
+		static bool is_clmul_supported();
+
+		/// \brief Converts an expanded key from AES_Impl to round keys for the kernels
+		static void convert_key(const uint32_t *key_expanded, int num_rounds, unsigned char *out_round_keys);
+
+		/// \brief Cipher block chaining. The iv is updated to the last ciphertext block
+		static void encrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks);
+		static void decrypt_cbc(const unsigned char *round_keys, int num_rounds, unsigned char iv[16], const unsigned char *input, unsigned char *output, int num_blocks);
+
+		/// \brief Counter mode, incrementing the last 32 bits of the counter block as a big endian integer
+		static void crypt_ctr(const unsigned char *round_keys, int num_rounds, unsigned char counter[16], const unsigned char *input, unsigned char *output, int num_blocks);
+
+		/// \brief Precalculates the powers of the hash key used by ghash (4 blocks of 16 bytes)
+		static void ghash_key(const unsigned char h[16], unsigned char *out_powers);
+
+		/// \brief Updates the GHASH value y with whole blocks of input
+		static void ghash(const unsigned char *powers, unsigned char y[16], const unsigned char *input, int num_blocks);
+	};
+}
@@ -31,6 +31,10 @@
 #include "API/Core/Math/cl_math.h"
 #include "API/Core/Crypto/secret.h"
 #include "API/Core/Crypto/random.h"
+#include "Core/Math/big_int_limbs.h"
+#include "Core/Math/big_int_montgomery.h"
+#include <algorithm>
+#include <vector>
 
 #ifndef WIN32
 #include <cstring>
@@ -205,7 +209,92 @@ namespace clan
 			throw Exception("ciphertext is out of range of modulus");
 		}
 
-		cipher->exptmod(d, modulus, msg);
+		cipher->exptmod(d, modulus, msg, true);
+	}
+
+	void RSA_Impl::rsadp_crt(BigInt *cipher, const RSAPrivateKey &key, BigInt *msg)
+	{
+		// Insure that ciphertext representative is in range of modulus
+		if ((cipher->cmp_z() < 0) || (cipher->cmp(&key.modulus) >= 0))
+		{
+			throw Exception("ciphertext is out of range of modulus");
+		}
+
+		// Two exponentiations with half size exponents and moduli are about four times faster than one full size:
+		// m1 = c^exponent1 mod p, m2 = c^exponent2 mod q, m = m2 + q * ((m1 - m2) * coefficient mod p)
+		BigInt m1, m2;
+		cipher->exptmod(&key.exponent1, &key.prime1, &m1, true);
+		cipher->exptmod(&key.exponent2, &key.prime2, &m2, true);
+
+		// The recombination is done on limbs, as BigInt division and subtraction take different paths for different values
+		int num_limbs = (std::max(key.prime1.unsigned_octet_size(), key.prime2.unsigned_octet_size()) + 7) / 8;
+		std::vector<uint64_t> limbs(9 * num_limbs + BigInt_Limbs::scratch_size(num_limbs));
+		uint64_t *p = limbs.data();
+		uint64_t *q = p + num_limbs;
+		uint64_t *m1_limbs = q + num_limbs;
+		uint64_t *m2_limbs = m1_limbs + num_limbs;
+		uint64_t *coefficient = m2_limbs + num_limbs;
+		uint64_t *h = coefficient + num_limbs;
+		uint64_t *t = h + num_limbs;
+		uint64_t *product = t + num_limbs;
+		uint64_t *scratch = product + 2 * num_limbs;
+		to_limbs(key.prime1, p, num_limbs);
+		to_limbs(key.prime2, q, num_limbs);
+		to_limbs(m1, m1_limbs, num_limbs);
+		to_limbs(m2, m2_limbs, num_limbs);
+		to_limbs(key.coefficient, coefficient, num_limbs);
+
+		BigInt_Montgomery montgomery(p, num_limbs);
+
+		// h = m1 - (m2 mod p), adding p back with a mask if it went negative
+		montgomery.mod(t, m2_limbs, num_limbs);
+		uint64_t add_p = 0 - BigInt_Limbs::sub(h, m1_limbs, t, num_limbs);
+		for (int i = 0; i < num_limbs; i++)
+			t[i] = p[i] & add_p;
+		BigInt_Limbs::add(h, h, t, num_limbs);
+
+		// h = h * coefficient mod p. The Montgomery product divides by R, to_montgomery multiplies it back
+		montgomery.mul(t, h, coefficient);
+		montgomery.to_montgomery(h, t);
+
+		// m = m2 + q * h, which is below the modulus
+		BigInt_Limbs::mul(product, q, num_limbs, h, num_limbs, scratch);
+		uint64_t carry = BigInt_Limbs::add(product, product, m2_limbs, num_limbs);
+		for (int i = num_limbs; i < 2 * num_limbs; i++)
+		{
+			product[i] += carry;
+			carry = (product[i] < carry);
+		}
+		from_limbs(product, 2 * num_limbs, msg);
+
+		// Do not leave copies of the primes or the message behind
+		std::fill(limbs.begin(), limbs.end(), 0);
+	}
+
+	void RSA_Impl::to_limbs(const BigInt &value, uint64_t *limbs, int num_limbs)
+	{
+		Secret octets(num_limbs * 8);
+		value.to_unsigned_octets(octets.get_data(), octets.get_size());
+		const unsigned char *data = octets.get_data();
+		for (int i = 0; i < num_limbs; i++)
+		{
+			uint64_t limb = 0;
+			for (int j = 0; j < 8; j++)
+				limb = (limb << 8) | data[(num_limbs - 1 - i) * 8 + j];
+			limbs[i] = limb;
+		}
+	}
+
+	void RSA_Impl::from_limbs(const uint64_t *limbs, int num_limbs, BigInt *value)
+	{
+		Secret octets(num_limbs * 8);
+		unsigned char *data = octets.get_data();
+		for (int i = 0; i < num_limbs; i++)
+		{
+			for (int j = 0; j < 8; j++)
+				data[(num_limbs - 1 - i) * 8 + j] = (unsigned char)(limbs[i] >> (56 - j * 8));
+		}
+		value->read_unsigned_octets(octets.get_data(), octets.get_size());
 	}
 
 	void RSA_Impl::pkcs1v15_encode(int block_type, Random &random, const char *msg, int mlen, char *emsg, int emlen)
@@ -299,7 +388,7 @@ namespace clan
 		return buffer;
 	}
 
-	Secret RSA_Impl::pkcs1v15_decrypt(const char *msg, int mlen, const BigInt *d, const BigInt *modulus)
+	Secret RSA_Impl::pkcs1v15_decrypt(const char *msg, int mlen, const BigInt *d, const BigInt *modulus, const RSAPrivateKey *crt_key)
 	{
 		int     k;
 
@@ -313,7 +402,10 @@ namespace clan
 		mrep.read_unsigned_octets((const unsigned char *)msg, mlen);
 
 		// Decrypt ...
-		rsadp(&mrep, d, modulus, &mrep);
+		if (crt_key)
+			rsadp_crt(&mrep, *crt_key, &mrep);
+		else
+			rsadp(&mrep, d, modulus, &mrep);
 
 		Secret key_buffer(k);
 		mrep.to_unsigned_octets(key_buffer.get_data(), k);
@@ -342,6 +434,19 @@ namespace clan
 		return pkcs1v15_decrypt((const char *)in_data, in_data_size, &exponent, &modulus);
 	}
 
+	Secret RSA_Impl::decrypt(const Secret &in_prime1, const Secret &in_prime2, const Secret &in_exponent1, const Secret &in_exponent2, const Secret &in_coefficient, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size)
+	{
+		RSAPrivateKey key;
+		key.prime1.read_unsigned_octets((const unsigned char *)in_prime1.get_data(), in_prime1.get_size());
+		key.prime2.read_unsigned_octets((const unsigned char *)in_prime2.get_data(), in_prime2.get_size());
+		key.exponent1.read_unsigned_octets((const unsigned char *)in_exponent1.get_data(), in_exponent1.get_size());
+		key.exponent2.read_unsigned_octets((const unsigned char *)in_exponent2.get_data(), in_exponent2.get_size());
+		key.coefficient.read_unsigned_octets((const unsigned char *)in_coefficient.get_data(), in_coefficient.get_size());
+		key.modulus.read_unsigned_octets((const unsigned char *)in_modulus, in_modulus_size);
+
+		return pkcs1v15_decrypt((const char *)in_data, in_data_size, nullptr, &key.modulus, &key);
+	}
+
 	void RSA_Impl::create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value)
 	{
 		create(random, key_size_in_bits, public_exponent_value);
@@ -354,4 +459,24 @@ namespace clan
 		out_modulus = DataBuffer(rsa_private_key.modulus.unsigned_octet_size());
 		rsa_private_key.modulus.to_unsigned_octets((unsigned char *)out_modulus.get_data(), out_modulus.get_size());
 	}
+
+	void RSA_Impl::create_keypair(Random &random, Secret &out_private_exponent, Secret &out_prime1, Secret &out_prime2, Secret &out_exponent1, Secret &out_exponent2, Secret &out_coefficient, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value)
+	{
+		create_keypair(random, out_private_exponent, out_public_exponent, out_modulus, key_size_in_bits, public_exponent_value);
+
+		out_prime1 = Secret(rsa_private_key.prime1.unsigned_octet_size());
+		rsa_private_key.prime1.to_unsigned_octets(out_prime1.get_data(), out_prime1.get_size());
+
+		out_prime2 = Secret(rsa_private_key.prime2.unsigned_octet_size());
+		rsa_private_key.prime2.to_unsigned_octets(out_prime2.get_data(), out_prime2.get_size());
+
+		out_exponent1 = Secret(rsa_private_key.exponent1.unsigned_octet_size());
+		rsa_private_key.exponent1.to_unsigned_octets(out_exponent1.get_data(), out_exponent1.get_size());
+
+		out_exponent2 = Secret(rsa_private_key.exponent2.unsigned_octet_size());
+		rsa_private_key.exponent2.to_unsigned_octets(out_exponent2.get_data(), out_exponent2.get_size());
+
+		out_coefficient = Secret(rsa_private_key.coefficient.unsigned_octet_size());
+		rsa_private_key.coefficient.to_unsigned_octets(out_coefficient.get_data(), out_coefficient.get_size());
+	}
 }
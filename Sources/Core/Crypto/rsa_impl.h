@@ -77,6 +77,7 @@ namespace clan
 
 		static DataBuffer encrypt(int block_type, Random &random, const void *in_public_exponent, unsigned int in_public_exponent_size, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
 		static Secret decrypt(const Secret &in_private_exponent, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
+		static Secret decrypt(const Secret &in_prime1, const Secret &in_prime2, const Secret &in_exponent1, const Secret &in_exponent2, const Secret &in_coefficient, const void *in_modulus, unsigned int in_modulus_size, const void *in_data, unsigned int in_data_size);
 
 		/// \brief Create the keypair
 		void create(Random &random, int key_size_in_bits, int public_exponent_value);
@@ -91,12 +92,20 @@ namespace clan
 		/// \param public_exponent_value = public exponent value
 		void create_keypair(Random &random, Secret &out_private_exponent, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value);
 
+		/// \brief Create a keypair, including the values used for decryption with the Chinese remainder theorem
+		void create_keypair(Random &random, Secret &out_private_exponent, Secret &out_prime1, Secret &out_prime2, Secret &out_exponent1, Secret &out_exponent2, Secret &out_coefficient, DataBuffer &out_public_exponent, DataBuffer &out_modulus, int key_size_in_bits, int public_exponent_value);
+
 	private:
 		void generate_prime(Random &random, BigInt &prime, int prime_len);
 		bool build_from_primes(BigInt *p, BigInt *q, BigInt *e, BigInt *d, unsigned int key_size_in_bits);
 
 		static void rsaep(BigInt *msg, const BigInt *e, const BigInt *modulus, BigInt *cipher);
 		static void rsadp(BigInt *cipher, const BigInt *d, const BigInt *modulus, BigInt *msg);
+		static void rsadp_crt(BigInt *cipher, const RSAPrivateKey &key, BigInt *msg);
+
+		// Fixed length conversions between BigInt and little endian 64-bit limbs
+		static void to_limbs(const BigInt &value, uint64_t *limbs, int num_limbs);
+		static void from_limbs(const uint64_t *limbs, int num_limbs, BigInt *value);
 
 		// PKCS#1 v.1.5 message padding and encoding
 		// msg       - input message
@@ -123,7 +132,8 @@ namespace clan
 		// mlen      - length of input message, in bytes
 		// d         - decryption exponent
 		// modulus   - decryption key modulus
-		static Secret pkcs1v15_decrypt(const char *msg, int mlen, const BigInt *d, const BigInt *modulus);
+		// crt_key   - primes, exponents and coefficient of the private key, or null to decrypt with d
+		static Secret pkcs1v15_decrypt(const char *msg, int mlen, const BigInt *d, const BigInt *modulus, const RSAPrivateKey *crt_key = nullptr);
 
 		RSAPrivateKey rsa_private_key;
 	};
@@ -28,6 +28,7 @@
 
 #include "Core/precomp.h"
 #include "sha1_impl.h"
+#include "sha_simd.h"
 #include "API/Core/Math/cl_math.h"
 #include "API/Core/Crypto/sha1.h"
 
@@ -110,6 +111,15 @@ namespace clan
 		while (pos < size)
 		{
 			int data_left = size - pos;
+			if (chunk_filled == 0 && data_left >= block_size)
+			{
+				// Whole blocks are hashed directly from the input
+				int num_blocks = data_left / block_size;
+				process_blocks(data + pos, num_blocks);
+				pos += num_blocks * block_size;
+				continue;
+			}
+
 			int buffer_space = block_size - chunk_filled;
 			int data_used = min(buffer_space, data_left);
 			memcpy(chunk + chunk_filled, data + pos, data_used);
@@ -117,7 +127,7 @@ namespace clan
 			pos += data_used;
 			if (chunk_filled == block_size)
 			{
-				process_chunk();
+				process_blocks(chunk, 1);
 				chunk_filled = 0;
 			}
 		}
@@ -207,17 +217,36 @@ namespace clan
 		}
 	}
 
-	void SHA1_Impl::process_chunk()
+	void SHA1_Impl::process_blocks(const unsigned char *data, int num_blocks)
+	{
+		if (SHA_SIMD::is_sha_ni_supported())
+		{
+			uint32_t state[5] = { h0, h1, h2, h3, h4 };
+			SHA_SIMD::process_sha1(state, data, num_blocks);
+			h0 = state[0];
+			h1 = state[1];
+			h2 = state[2];
+			h3 = state[3];
+			h4 = state[4];
+		}
+		else
+		{
+			for (int i = 0; i < num_blocks; i++)
+				process_chunk(data + i * block_size);
+		}
+	}
+
+	void SHA1_Impl::process_chunk(const unsigned char *block)
 	{
 		int i;
 		unsigned int w[80];
 
 		for (i = 0; i < 16; i++)
 		{
-			unsigned int b1 = chunk[i * 4];
-			unsigned int b2 = chunk[i * 4 + 1];
-			unsigned int b3 = chunk[i * 4 + 2];
-			unsigned int b4 = chunk[i * 4 + 3];
+			unsigned int b1 = block[i * 4];
+			unsigned int b2 = block[i * 4 + 1];
+			unsigned int b3 = block[i * 4 + 2];
+			unsigned int b4 = block[i * 4 + 3];
 			w[i] = (b1 << 24) + (b2 << 16) + (b3 << 8) + b4;
 		}
 
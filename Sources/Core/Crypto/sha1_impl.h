@@ -46,7 +46,8 @@ namespace clan
 		void calculate();
 
 	private:
-		void process_chunk();
+		void process_blocks(const unsigned char *data, int num_blocks);
+		void process_chunk(const unsigned char *block);
 
 		inline unsigned int leftrotate_uint32(unsigned int value, int shift) const
 		{
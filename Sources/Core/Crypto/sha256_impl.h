@@ -76,7 +76,8 @@ namespace clan
 			return  (((x)& ((y) | (z))) | ((y)& (z)));
 		}
 
-		void process_chunk();
+		void process_blocks(const unsigned char *data, int num_blocks);
+		void process_chunk(const unsigned char *block);
 
 		uint32_t h0, h1, h2, h3, h4, h5, h6, h7;
 		const static int block_size = 64;
@@ -248,6 +248,16 @@ namespace clan
 		while (pos < size)
 		{
 			int data_left = size - pos;
+			if (chunk_filled == 0 && data_left >= block_size)
+			{
+				// Whole blocks are hashed directly from the input
+				int num_blocks = data_left / block_size;
+				for (int i = 0; i < num_blocks; i++)
+					process_chunk(data + pos + i * block_size);
+				pos += num_blocks * block_size;
+				continue;
+			}
+
 			int buffer_space = block_size - chunk_filled;
 			int data_used = min(buffer_space, data_left);
 			memcpy(chunk + chunk_filled, data + pos, data_used);
@@ -255,7 +265,7 @@ namespace clan
 			pos += data_used;
 			if (chunk_filled == block_size)
 			{
-				process_chunk();
+				process_chunk(chunk);
 				chunk_filled = 0;
 			}
 		}
@@ -407,7 +417,7 @@ namespace clan
 		}
 	}
 
-	void SHA512_Impl::process_chunk()
+	void SHA512_Impl::process_chunk(const unsigned char *block)
 	{
 		// Constants defined in FIPS 180-3, section 4.2.3
 		static const uint64_t constant_K[80] = {
@@ -446,14 +456,14 @@ namespace clan
 
 		for (i = 0; i < 16; i++)
 		{
-			uint64_t b1 = chunk[i * 8];
-			uint64_t b2 = chunk[i * 8 + 1];
-			uint64_t b3 = chunk[i * 8 + 2];
-			uint64_t b4 = chunk[i * 8 + 3];
-			uint64_t b5 = chunk[i * 8 + 4];
-			uint64_t b6 = chunk[i * 8 + 5];
-			uint64_t b7 = chunk[i * 8 + 6];
-			uint64_t b8 = chunk[i * 8 + 7];
+			uint64_t b1 = block[i * 8];
+			uint64_t b2 = block[i * 8 + 1];
+			uint64_t b3 = block[i * 8 + 2];
+			uint64_t b4 = block[i * 8 + 3];
+			uint64_t b5 = block[i * 8 + 4];
+			uint64_t b6 = block[i * 8 + 5];
+			uint64_t b7 = block[i * 8 + 6];
+			uint64_t b8 = block[i * 8 + 7];
 			w[i] = (b1 << 56) + (b2 << 48) + (b3 << 40) + (b4 << 32) + (b5 << 24) + (b6 << 16) + (b7 << 8) + b8;
 		}
 
@@ -76,7 +76,7 @@ namespace clan
 			return  (((x)& ((y) | (z))) | ((y)& (z)));
 		}
 
-		void process_chunk();
+		void process_chunk(const unsigned char *block);
 
 		uint64_t h0, h1, h2, h3, h4, h5, h6, h7;
 		const static int block_size = 128;
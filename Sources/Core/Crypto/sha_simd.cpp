@@ -0,0 +1,298 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/system.h"
+#include "sha_simd.h"
+
+#if !defined(ARM_PLATFORM) && !defined(CL_ARM)
+#define CL_SHA_SIMD
+#include <immintrin.h>
+#endif
+
+// The kernels are compiled for the instructions they use, independent of the flags the library is built with.
+// They are only called after detect_cpu_extension confirmed the CPU supports them.
+#if defined(__GNUC__)
+#define SHA_NI_TARGET __attribute__((target("sha,sse4.1")))
+#define SHA_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define SHA_NI_TARGET
+#define SHA_AVX2_TARGET
+#endif
+
+namespace clan
+{
+	bool SHA_SIMD::is_sha_ni_supported()
+	{
+#ifdef CL_SHA_SIMD
+		static bool supported = System::detect_cpu_extension(System::sha) && System::detect_cpu_extension(System::sse4_1);
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	bool SHA_SIMD::is_avx2_supported()
+	{
+#ifdef CL_SHA_SIMD
+		static bool supported = System::detect_cpu_extension(System::avx2);
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+#ifdef CL_SHA_SIMD
+
+	namespace
+	{
+		// Constants defined in FIPS 180-3, section 4.2.2
+		alignas(16) const uint32_t constant_K[64] = {
+			0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+			0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+			0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+			0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+			0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+			0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+			0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+			0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+		};
+
+		// Four rounds of SHA-1. Each group of four message words is derived from the four previous groups
+		template<int func>
+		SHA_NI_TARGET inline void sha1_rounds(__m128i &abcd, __m128i &e, __m128i &abcd_prev, __m128i *msg, int group, const unsigned char *data, __m128i mask)
+		{
+			__m128i &w = msg[group & 3];
+			if (group < 4)
+			{
+				w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + group * 16)), mask);
+			}
+			else
+			{
+				__m128i t = _mm_sha1msg1_epu32(w, msg[(group + 1) & 3]);
+				t = _mm_xor_si128(t, msg[(group + 2) & 3]);
+				w = _mm_sha1msg2_epu32(t, msg[(group + 3) & 3]);
+			}
+
+			if (group == 0)
+				e = _mm_add_epi32(e, w);
+			else
+				e = _mm_sha1nexte_epu32(abcd_prev, w);
+
+			abcd_prev = abcd;
+			abcd = _mm_sha1rnds4_epu32(abcd, e, func);
+		}
+	}
+
+	SHA_NI_TARGET void SHA_SIMD::process_sha1(uint32_t state[5], const unsigned char *data, int num_blocks)
+	{
+		const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+		__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0x1b);
+		__m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+		for (int block = 0; block < num_blocks; block++, data += 64)
+		{
+			__m128i abcd_save = abcd;
+			__m128i e_save = e0;
+			__m128i abcd_prev = abcd;
+			__m128i e = e0;
+			__m128i msg[4];
+
+			for (int group = 0; group < 5; group++)
+				sha1_rounds<0>(abcd, e, abcd_prev, msg, group, data, mask);
+			for (int group = 5; group < 10; group++)
+				sha1_rounds<1>(abcd, e, abcd_prev, msg, group, data, mask);
+			for (int group = 10; group < 15; group++)
+				sha1_rounds<2>(abcd, e, abcd_prev, msg, group, data, mask);
+			for (int group = 15; group < 20; group++)
+				sha1_rounds<3>(abcd, e, abcd_prev, msg, group, data, mask);
+
+			e0 = _mm_sha1nexte_epu32(abcd_prev, e_save);
+			abcd = _mm_add_epi32(abcd, abcd_save);
+		}
+
+		_mm_storeu_si128((__m128i*)state, _mm_shuffle_epi32(abcd, 0x1b));
+		state[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+	}
+
+	SHA_NI_TARGET void SHA_SIMD::process_sha256(uint32_t state[8], const unsigned char *data, int num_blocks)
+	{
+		const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+		// The instructions keep the state as ABEF and CDGH
+		__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)state), 0xb1);
+		__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(state + 4)), 0x1b);
+		__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+		state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+		for (int block = 0; block < num_blocks; block++, data += 64)
+		{
+			__m128i abef_save = state0;
+			__m128i cdgh_save = state1;
+			__m128i msg[4];
+
+			for (int group = 0; group < 16; group++)
+			{
+				__m128i &w = msg[group & 3];
+				if (group < 4)
+				{
+					w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + group * 16)), mask);
+				}
+				else
+				{
+					__m128i t = _mm_sha256msg1_epu32(w, msg[(group + 1) & 3]);
+					t = _mm_add_epi32(t, _mm_alignr_epi8(msg[(group + 3) & 3], msg[(group + 2) & 3], 4));
+					w = _mm_sha256msg2_epu32(t, msg[(group + 3) & 3]);
+				}
+
+				__m128i wk = _mm_add_epi32(w, _mm_load_si128((const __m128i*)(constant_K + group * 4)));
+				state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+				state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0e));
+			}
+
+			state0 = _mm_add_epi32(state0, abef_save);
+			state1 = _mm_add_epi32(state1, cdgh_save);
+		}
+
+		tmp = _mm_shuffle_epi32(state0, 0x1b);
+		state1 = _mm_shuffle_epi32(state1, 0xb1);
+		_mm_storeu_si128((__m128i*)state, _mm_blend_epi16(tmp, state1, 0xf0));
+		_mm_storeu_si128((__m128i*)(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+	}
+
+	namespace
+	{
+		SHA_AVX2_TARGET inline __m256i rotr(__m256i value, int shift)
+		{
+			return _mm256_or_si256(_mm256_srli_epi32(value, shift), _mm256_slli_epi32(value, 32 - shift));
+		}
+
+		// Transposes eight rows of eight words, turning the same word of the eight lanes into one vector
+		SHA_AVX2_TARGET inline void transpose(__m256i *r)
+		{
+			__m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+			__m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+			__m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+			__m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+			__m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+			__m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+			__m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+			__m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+			__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+			__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+			__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+			__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+			__m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+			__m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+			__m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+			__m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+			r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+			r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+			r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+			r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+			r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+			r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+			r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+			r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+		}
+	}
+
+	SHA_AVX2_TARGET void SHA_SIMD::process_sha256_x8(uint32_t state[8][lanes], const unsigned char * const data[lanes], int num_blocks)
+	{
+		const __m256i mask = _mm256_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL, 0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+		__m256i h[8];
+		for (int i = 0; i < 8; i++)
+			h[i] = _mm256_loadu_si256((const __m256i*)state[i]);
+
+		for (int block = 0; block < num_blocks; block++)
+		{
+			__m256i w[16];
+			for (int half = 0; half < 2; half++)
+			{
+				for (int lane = 0; lane < lanes; lane++)
+					w[half * 8 + lane] = _mm256_loadu_si256((const __m256i*)(data[lane] + block * 64 + half * 32));
+				transpose(w + half * 8);
+			}
+			for (int i = 0; i < 16; i++)
+				w[i] = _mm256_shuffle_epi8(w[i], mask);
+
+			__m256i a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], hh = h[7];
+			for (int i = 0; i < 64; i++)
+			{
+				if (i >= 16)
+				{
+					__m256i w15 = w[(i - 15) & 15];
+					__m256i w2 = w[(i - 2) & 15];
+					__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr(w15, 7), rotr(w15, 18)), _mm256_srli_epi32(w15, 3));
+					__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr(w2, 17), rotr(w2, 19)), _mm256_srli_epi32(w2, 10));
+					w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+				}
+
+				__m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr(e, 6), rotr(e, 11)), rotr(e, 25));
+				__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, _mm256_xor_si256(f, g)), g);
+				__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(hh, sigma1), _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32(constant_K[i]), w[i & 15])));
+				__m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr(a, 2), rotr(a, 13)), rotr(a, 22));
+				__m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+				__m256i t2 = _mm256_add_epi32(sigma0, maj);
+
+				hh = g;
+				g = f;
+				f = e;
+				e = _mm256_add_epi32(d, t1);
+				d = c;
+				c = b;
+				b = a;
+				a = _mm256_add_epi32(t1, t2);
+			}
+
+			h[0] = _mm256_add_epi32(h[0], a);
+			h[1] = _mm256_add_epi32(h[1], b);
+			h[2] = _mm256_add_epi32(h[2], c);
+			h[3] = _mm256_add_epi32(h[3], d);
+			h[4] = _mm256_add_epi32(h[4], e);
+			h[5] = _mm256_add_epi32(h[5], f);
+			h[6] = _mm256_add_epi32(h[6], g);
+			h[7] = _mm256_add_epi32(h[7], hh);
+		}
+
+		for (int i = 0; i < 8; i++)
+			_mm256_storeu_si256((__m256i*)state[i], h[i]);
+	}
+
+#else
+
+	void SHA_SIMD::process_sha1(uint32_t state[5], const unsigned char *data, int num_blocks) { }
+	void SHA_SIMD::process_sha256(uint32_t state[8], const unsigned char *data, int num_blocks) { }
+	void SHA_SIMD::process_sha256_x8(uint32_t state[8][lanes], const unsigned char * const data[lanes], int num_blocks) { }
+
+#endif
+}
@@ -0,0 +1,53 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+namespace clan
+{
+	/// \brief SHA-1 and SHA-256 compression kernels using the SHA extensions (SHA-NI) and AVX2
+	///
+	/// States are in the word order of the specification (h0 first). The kernels process whole 64 byte
+	/// blocks and must only be called when the matching is_..._supported() function returns true.
+	class SHA_SIMD
+	{
+	public:
+		static bool is_sha_ni_supported();
+		static bool is_avx2_supported();
+
+		static void process_sha1(uint32_t state[5], const unsigned char *data, int num_blocks);
+		static void process_sha256(uint32_t state[8], const unsigned char *data, int num_blocks);
+
+		static const int lanes = 8;
+
+		/// \brief Runs eight independent SHA-256 streams of equal length in parallel (AVX2)
+		///
+		/// The states are stored as state[word][lane], so each word of the eight states fills one vector.
+		static void process_sha256_x8(uint32_t state[8][lanes], const unsigned char * const data[lanes], int num_blocks);
+	};
+}
@@ -0,0 +1,80 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Crypto/tree_hash.h"
+#include "API/Core/System/databuffer.h"
+#include "tree_hash_impl.h"
+
+namespace clan
+{
+	TreeHash::TreeHash(WorkQueue &work_queue)
+		: impl(std::make_shared<TreeHash_Impl>(work_queue))
+	{
+	}
+
+	std::string TreeHash::get_hash(bool uppercase) const
+	{
+		return impl->get_hash(uppercase);
+	}
+
+	void TreeHash::get_hash(unsigned char out_hash[hash_size]) const
+	{
+		impl->get_hash(out_hash);
+	}
+
+	void TreeHash::reset()
+	{
+		impl->reset();
+	}
+
+	void TreeHash::add(const void *data, int64_t size)
+	{
+		impl->add(data, size);
+	}
+
+	void TreeHash::add(const DataBuffer &data)
+	{
+		add(data.get_data(), data.get_size());
+	}
+
+	void TreeHash::add(IODevice &device)
+	{
+		impl->add(device);
+	}
+
+	void TreeHash::add_file(const std::string &filename)
+	{
+		impl->add_file(filename);
+	}
+
+	void TreeHash::calculate()
+	{
+		impl->calculate();
+	}
+}
@@ -0,0 +1,268 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "tree_hash_impl.h"
+#include "sha_simd.h"
+#include "API/Core/Crypto/sha256.h"
+#include "API/Core/IOData/file.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/System/task_group.h"
+#include "Core/Zip/zip_mapped_file.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clan
+{
+	namespace
+	{
+		// Chunks hashed per parallel_for call, bounding the memory used for their hashes
+		const int max_batch_chunks = 4096;
+
+		// Files smaller than this are read rather than memory mapped
+		const size_t mapping_threshold = 4 * 1024 * 1024;
+
+		const unsigned char leaf_suffix = 0x00;
+		const unsigned char parent_suffix = 0x01;
+	}
+
+	TreeHash_Impl::TreeHash_Impl(WorkQueue &work_queue) : work_queue(work_queue), chunk(TreeHash::chunk_size)
+	{
+		reset();
+	}
+
+	std::string TreeHash_Impl::get_hash(bool uppercase) const
+	{
+		if (calculated == false)
+			throw Exception("Tree hash has not been calculated yet!");
+
+		const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+		std::string digest(TreeHash::hash_size * 2, ' ');
+		for (int i = 0; i < TreeHash::hash_size; i++)
+		{
+			digest[i * 2] = digits[root.hash[i] >> 4];
+			digest[i * 2 + 1] = digits[root.hash[i] & 0xf];
+		}
+		return digest;
+	}
+
+	void TreeHash_Impl::get_hash(unsigned char *out_hash) const
+	{
+		if (calculated == false)
+			throw Exception("Tree hash has not been calculated yet!");
+
+		memcpy(out_hash, root.hash, TreeHash::hash_size);
+	}
+
+	void TreeHash_Impl::reset()
+	{
+		chunk_filled = 0;
+		chunks_hashed = 0;
+		subtrees.clear();
+		calculated = false;
+	}
+
+	void TreeHash_Impl::add(const void *_data, int64_t size)
+	{
+		if (calculated)
+			reset();
+
+		const unsigned char *data = (const unsigned char *)_data;
+		while (size > 0)
+		{
+			if (chunk_filled == 0 && size >= TreeHash::chunk_size)
+			{
+				// Whole chunks are hashed directly from the input
+				int num_chunks = (int)std::min(size / TreeHash::chunk_size, (int64_t)max_batch_chunks);
+				add_chunks(data, num_chunks);
+				data += (int64_t)num_chunks * TreeHash::chunk_size;
+				size -= (int64_t)num_chunks * TreeHash::chunk_size;
+			}
+			else
+			{
+				int data_used = (int)std::min((int64_t)(TreeHash::chunk_size - chunk_filled), size);
+				memcpy(chunk.data() + chunk_filled, data, data_used);
+				chunk_filled += data_used;
+				data += data_used;
+				size -= data_used;
+				if (chunk_filled == TreeHash::chunk_size)
+				{
+					add_chunks(chunk.data(), 1);
+					chunk_filled = 0;
+				}
+			}
+		}
+	}
+
+	void TreeHash_Impl::add(IODevice &device)
+	{
+		std::vector<unsigned char> buffer(max_batch_chunks / 16 * TreeHash::chunk_size);
+		while (true)
+		{
+			size_t received = device.read(buffer.data(), buffer.size());
+			if (received == 0)
+				break;
+			add(buffer.data(), received);
+		}
+	}
+
+	void TreeHash_Impl::add_file(const std::string &filename)
+	{
+		{
+			File file(filename);
+			if (file.get_size() < mapping_threshold)
+			{
+				add(file);
+				return;
+			}
+		}
+
+		ZipMappedFile mapping(filename);
+		add(mapping.get_data(), mapping.get_size());
+	}
+
+	void TreeHash_Impl::calculate()
+	{
+		if (calculated)
+			reset();
+
+		// The last chunk may be partial. Empty input is hashed as a single empty chunk
+		if (chunk_filled > 0 || chunks_hashed == 0)
+		{
+			Node node;
+			hash_chunk(chunk.data(), chunk_filled, node.hash);
+			push_chunk(node);
+			chunk_filled = 0;
+		}
+
+		// Fold the remaining subtrees from the smallest (rightmost) to the largest
+		root = subtrees.back();
+		for (int i = (int)subtrees.size() - 2; i >= 0; i--)
+			hash_parent(subtrees[i].hash, root.hash, root.hash);
+
+		calculated = true;
+	}
+
+	void TreeHash_Impl::add_chunks(const unsigned char *data, int num_chunks)
+	{
+		batch.resize(num_chunks);
+
+		// Without SHA-NI eight chunks are hashed at once by the AVX2 multi-buffer kernel
+		bool use_x8 = SHA_SIMD::is_avx2_supported() && !SHA_SIMD::is_sha_ni_supported();
+
+		parallel_for(work_queue, 0, num_chunks, SHA_SIMD::lanes, [&](int range_begin, int range_end)
+		{
+			int i = range_begin;
+			if (use_x8)
+			{
+				for (; i + SHA_SIMD::lanes <= range_end; i += SHA_SIMD::lanes)
+					hash_chunks_x8(data + (int64_t)i * TreeHash::chunk_size, &batch[i]);
+			}
+			for (; i < range_end; i++)
+				hash_chunk(data + (int64_t)i * TreeHash::chunk_size, TreeHash::chunk_size, batch[i].hash);
+		});
+
+		for (int i = 0; i < num_chunks; i++)
+			push_chunk(batch[i]);
+	}
+
+	void TreeHash_Impl::push_chunk(Node node)
+	{
+		// Each completed pair of equally sized subtrees is merged, like carrying in a binary counter
+		chunks_hashed++;
+		for (uint64_t count = chunks_hashed; (count & 1) == 0; count >>= 1)
+		{
+			hash_parent(subtrees.back().hash, node.hash, node.hash);
+			subtrees.pop_back();
+		}
+		subtrees.push_back(node);
+	}
+
+	void TreeHash_Impl::hash_chunk(const unsigned char *data, int size, unsigned char *out_hash)
+	{
+		SHA256 sha256;
+		sha256.add(data, size);
+		sha256.add(&leaf_suffix, 1);
+		sha256.calculate();
+		sha256.get_hash(out_hash);
+	}
+
+	void TreeHash_Impl::hash_chunks_x8(const unsigned char *data, Node *out_nodes)
+	{
+		static const uint32_t initial_hash[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+		const int lanes = SHA_SIMD::lanes;
+
+		uint32_t state[8][lanes];
+		for (int word = 0; word < 8; word++)
+		{
+			for (int lane = 0; lane < lanes; lane++)
+				state[word][lane] = initial_hash[word];
+		}
+
+		const unsigned char *lane_data[lanes];
+		for (int lane = 0; lane < lanes; lane++)
+			lane_data[lane] = data + lane * TreeHash::chunk_size;
+		SHA_SIMD::process_sha256_x8(state, lane_data, TreeHash::chunk_size / 64);
+
+		// All chunks end with the same block: the suffix, the padding and the message length in bits
+		unsigned char last_block[64] = { 0 };
+		last_block[0] = leaf_suffix;
+		last_block[1] = 0x80;
+		uint64_t length_message = (TreeHash::chunk_size + 1) * (uint64_t)8;
+		for (int i = 0; i < 8; i++)
+			last_block[63 - i] = (unsigned char)(length_message >> (i * 8));
+
+		for (int lane = 0; lane < lanes; lane++)
+			lane_data[lane] = last_block;
+		SHA_SIMD::process_sha256_x8(state, lane_data, 1);
+
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			for (int word = 0; word < 8; word++)
+			{
+				out_nodes[lane].hash[word * 4] = (unsigned char)(state[word][lane] >> 24);
+				out_nodes[lane].hash[word * 4 + 1] = (unsigned char)(state[word][lane] >> 16);
+				out_nodes[lane].hash[word * 4 + 2] = (unsigned char)(state[word][lane] >> 8);
+				out_nodes[lane].hash[word * 4 + 3] = (unsigned char)state[word][lane];
+			}
+		}
+	}
+
+	void TreeHash_Impl::hash_parent(const unsigned char *left, const unsigned char *right, unsigned char *out_hash)
+	{
+		unsigned char data[TreeHash::hash_size * 2 + 1];
+		memcpy(data, left, TreeHash::hash_size);
+		memcpy(data + TreeHash::hash_size, right, TreeHash::hash_size);
+		data[TreeHash::hash_size * 2] = parent_suffix;
+
+		SHA256 sha256;
+		sha256.add(data, sizeof(data));
+		sha256.calculate();
+		sha256.get_hash(out_hash);
+	}
+}
@@ -0,0 +1,77 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/Crypto/tree_hash.h"
+#include "API/Core/System/work_queue.h"
+#include <vector>
+
+namespace clan
+{
+	class TreeHash_Impl
+	{
+	public:
+		TreeHash_Impl(WorkQueue &work_queue);
+
+		std::string get_hash(bool uppercase) const;
+		void get_hash(unsigned char *out_hash) const;
+
+		void reset();
+		void add(const void *data, int64_t size);
+		void add(IODevice &device);
+		void add_file(const std::string &filename);
+		void calculate();
+
+	private:
+		struct Node
+		{
+			unsigned char hash[TreeHash::hash_size];
+		};
+
+		void add_chunks(const unsigned char *data, int num_chunks);
+		void push_chunk(Node node);
+
+		static void hash_chunk(const unsigned char *data, int size, unsigned char *out_hash);
+		static void hash_chunks_x8(const unsigned char *data, Node *out_nodes);
+		static void hash_parent(const unsigned char *left, const unsigned char *right, unsigned char *out_hash);
+
+		WorkQueue work_queue;
+
+		std::vector<unsigned char> chunk;
+		int chunk_filled = 0;
+		uint64_t chunks_hashed = 0;
+
+		// Roots of the completed subtrees, largest first. Their sizes are the bits set in chunks_hashed
+		std::vector<Node> subtrees;
+		std::vector<Node> batch;
+
+		Node root;
+		bool calculated = false;
+	};
+}
@@ -0,0 +1,493 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_reader.h"
+#include "API/Core/JSON/json_value.h"
+#include "API/Core/IOData/iodevice.h"
+#include "API/Core/Text/string_help.h"
+#include "json_scan.h"
+#include <algorithm>
+#include <vector>
+
+namespace clan
+{
+	class JsonReader_Impl
+	{
+	public:
+		JsonReader_Impl(const char *data, size_t length) : pos(data), end(data + length) { }
+		JsonReader_Impl(IODevice &input) : device(input), streaming(true) { }
+
+		JsonToken next();
+		void skip_value();
+
+		JsonToken token = JsonToken::end;
+		const char *text = nullptr;
+		size_t text_length = 0;
+		double number = 0.0;
+		bool boolean = false;
+		std::vector<char> containers;
+
+	private:
+		enum class Expect
+		{
+			done,		// Between top level values
+			value,
+			value_or_end,
+			name_or_end,
+			name,
+			colon,
+			separator_or_end
+		};
+
+		bool fill(size_t count);
+		void skip_whitespace();
+		JsonToken read_value();
+		JsonToken end_container();
+		void read_string();
+		void read_number();
+		void read_literal(const char *literal, size_t length);
+		unsigned int read_hex4(size_t offset);
+		void after_value() { expect = containers.empty() ? Expect::done : Expect::separator_or_end; }
+
+		IODevice device;
+		bool streaming = false;
+		bool eof = false;
+		std::vector<char> buffer;
+		const char *pos = nullptr;
+		const char *end = nullptr;
+		std::string scratch;
+		Expect expect = Expect::done;
+
+		static const size_t chunk_size = 64 * 1024;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonReader::JsonReader() : impl(std::make_shared<JsonReader_Impl>(nullptr, 0))
+	{
+	}
+
+	JsonReader::JsonReader(IODevice &input) : impl(std::make_shared<JsonReader_Impl>(input))
+	{
+	}
+
+	JsonReader::JsonReader(const void *data, size_t length) : impl(std::make_shared<JsonReader_Impl>(static_cast<const char*>(data), length))
+	{
+	}
+
+	JsonReader::~JsonReader()
+	{
+	}
+
+	JsonToken JsonReader::next()
+	{
+		return impl->next();
+	}
+
+	JsonToken JsonReader::get_token() const
+	{
+		return impl->token;
+	}
+
+	int JsonReader::get_depth() const
+	{
+		return static_cast<int>(impl->containers.size());
+	}
+
+	const char *JsonReader::get_text() const
+	{
+		return impl->text;
+	}
+
+	size_t JsonReader::get_text_length() const
+	{
+		return impl->text_length;
+	}
+
+	std::string JsonReader::get_string() const
+	{
+		return std::string(impl->text, impl->text_length);
+	}
+
+	double JsonReader::get_number() const
+	{
+		return impl->number;
+	}
+
+	bool JsonReader::get_boolean() const
+	{
+		return impl->boolean;
+	}
+
+	void JsonReader::skip_value()
+	{
+		impl->skip_value();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonToken JsonReader_Impl::next()
+	{
+		text = nullptr;
+		text_length = 0;
+
+		while (true)
+		{
+			skip_whitespace();
+
+			if (pos == end)
+			{
+				if (expect != Expect::done)
+					throw JsonException("Unexpected end of JSON data");
+				token = JsonToken::end;
+				return token;
+			}
+
+			switch (expect)
+			{
+			case Expect::done:
+			case Expect::value:
+				return read_value();
+
+			case Expect::value_or_end:
+				if (*pos == ']')
+					return end_container();
+				return read_value();
+
+			case Expect::name_or_end:
+				if (*pos == '}')
+					return end_container();
+				// Fall through
+			case Expect::name:
+				if (*pos != '"')
+					throw JsonException("Unexpected character in JSON data");
+				read_string();
+				// The colon is consumed by the next call, as reading more input could move the name text
+				expect = Expect::colon;
+				token = JsonToken::property_name;
+				return token;
+
+			case Expect::colon:
+				if (*pos != ':')
+					throw JsonException("Unexpected character in JSON data");
+				pos++;
+				expect = Expect::value;
+				break;
+
+			case Expect::separator_or_end:
+				if (*pos == ',')
+				{
+					pos++;
+					expect = containers.back() == '{' ? Expect::name : Expect::value;
+				}
+				else if (*pos == (containers.back() == '{' ? '}' : ']'))
+				{
+					return end_container();
+				}
+				else
+				{
+					throw JsonException("Unexpected character in JSON data");
+				}
+				break;
+			}
+		}
+	}
+
+	void JsonReader_Impl::skip_value()
+	{
+		if (token == JsonToken::property_name)
+			next();
+
+		if (token == JsonToken::begin_object || token == JsonToken::begin_array)
+		{
+			size_t depth = containers.size() - 1;
+			while (containers.size() > depth)
+				next();
+		}
+	}
+
+	JsonToken JsonReader_Impl::read_value()
+	{
+		switch (*pos)
+		{
+		case '{':
+			pos++;
+			containers.push_back('{');
+			expect = Expect::name_or_end;
+			token = JsonToken::begin_object;
+			return token;
+		case '[':
+			pos++;
+			containers.push_back('[');
+			expect = Expect::value_or_end;
+			token = JsonToken::begin_array;
+			return token;
+		case '"':
+			read_string();
+			token = JsonToken::string;
+			break;
+		case '-':
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			read_number();
+			token = JsonToken::number;
+			break;
+		case 't':
+			read_literal("true", 4);
+			boolean = true;
+			token = JsonToken::boolean;
+			break;
+		case 'f':
+			read_literal("false", 5);
+			boolean = false;
+			token = JsonToken::boolean;
+			break;
+		case 'n':
+			read_literal("null", 4);
+			token = JsonToken::null;
+			break;
+		default:
+			throw JsonException("Unexpected character in JSON data");
+		}
+
+		after_value();
+		return token;
+	}
+
+	JsonToken JsonReader_Impl::end_container()
+	{
+		pos++;
+		char type = containers.back();
+		containers.pop_back();
+		after_value();
+		token = (type == '{') ? JsonToken::end_object : JsonToken::end_array;
+		return token;
+	}
+
+	void JsonReader_Impl::read_string()
+	{
+		// Offsets are relative to pos, since reading more input can move the buffer
+		bool escaped = false;
+		size_t run_start = 1;
+		size_t i = 1;
+		while (true)
+		{
+			const char *special = JsonScan::find_string_special(pos + i, end);
+			i = special - pos;
+			if (special == end)
+			{
+				if (!fill(i + 1))
+					throw JsonException("Unexpected end of JSON data");
+				continue;
+			}
+
+			if (*special == '"')
+			{
+				break;
+			}
+			else if (*special == '\\')
+			{
+				if (!escaped)
+				{
+					scratch.clear();
+					escaped = true;
+				}
+				scratch.append(pos + run_start, pos + i);
+
+				if (!fill(i + 2))
+					throw JsonException("Unexpected end of JSON data");
+
+				switch (pos[i + 1])
+				{
+				case '"': scratch.push_back('"'); break;
+				case '\\': scratch.push_back('\\'); break;
+				case '/': scratch.push_back('/'); break;
+				case 'b': scratch.push_back('\b'); break;
+				case 'f': scratch.push_back('\f'); break;
+				case 'n': scratch.push_back('\n'); break;
+				case 'r': scratch.push_back('\r'); break;
+				case 't': scratch.push_back('\t'); break;
+				case 'u':
+				{
+					unsigned int codepoint = read_hex4(i + 2);
+					if (codepoint >= 0xd800 && codepoint < 0xdc00 && fill(i + 12) && pos[i + 6] == '\\' && pos[i + 7] == 'u')
+					{
+						unsigned int low = read_hex4(i + 8);
+						if (low >= 0xdc00 && low < 0xe000)
+						{
+							codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+							i += 6;
+						}
+					}
+					scratch += StringHelp::unicode_to_utf8(codepoint);
+					i += 4;
+					break;
+				}
+				default:
+					throw JsonException("Invalid escape sequence in JSON string");
+				}
+
+				i += 2;
+				run_start = i;
+			}
+			else
+			{
+				// Control characters are passed through as is
+				i++;
+			}
+		}
+
+		if (escaped)
+		{
+			scratch.append(pos + run_start, pos + i);
+			text = scratch.data();
+			text_length = scratch.size();
+		}
+		else
+		{
+			text = pos + 1;
+			text_length = i - 1;
+		}
+		pos += i + 1;
+	}
+
+	unsigned int JsonReader_Impl::read_hex4(size_t offset)
+	{
+		if (!fill(offset + 4))
+			throw JsonException("Unexpected end of JSON data");
+
+		unsigned int codepoint = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			char c = pos[offset + i];
+			codepoint <<= 4;
+			if (c >= '0' && c <= '9')
+				codepoint |= c - '0';
+			else if (c >= 'a' && c <= 'f')
+				codepoint |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				codepoint |= c - 'A' + 10;
+			else
+				throw JsonException("Invalid unicode escape");
+		}
+		return codepoint;
+	}
+
+	void JsonReader_Impl::read_number()
+	{
+		size_t i = 0;
+		while (true)
+		{
+			if (pos + i == end && !fill(i + 1))
+				break;
+
+			char c = pos[i];
+			if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+				i++;
+			else
+				break;
+		}
+
+		text = pos;
+		text_length = i;
+		pos += i;
+
+		// strtod needs a null terminated string
+		char local[64];
+		const char *number_text = local;
+		if (text_length < sizeof(local))
+		{
+			memcpy(local, text, text_length);
+			local[text_length] = 0;
+		}
+		else
+		{
+			scratch.assign(text, text_length);
+			number_text = scratch.c_str();
+		}
+
+		char *number_end = nullptr;
+		number = strtod(number_text, &number_end);
+		if (number_end != number_text + text_length)
+			throw JsonException("Invalid number in JSON data");
+	}
+
+	void JsonReader_Impl::read_literal(const char *literal, size_t length)
+	{
+		if (!fill(length) || memcmp(pos, literal, length) != 0)
+			throw JsonException("Unexpected character in JSON data");
+		pos += length;
+	}
+
+	void JsonReader_Impl::skip_whitespace()
+	{
+		while (true)
+		{
+			pos = JsonScan::skip_whitespace(pos, end);
+			if (pos != end || !fill(1))
+				break;
+		}
+	}
+
+	bool JsonReader_Impl::fill(size_t count)
+	{
+		size_t available = end - pos;
+		if (available >= count)
+			return true;
+		if (!streaming || eof)
+			return false;
+
+		// Move the unread data to the front and make room for at least another chunk
+		if (available > 0 && pos != buffer.data())
+			memmove(buffer.data(), pos, available);
+		size_t needed = std::max(count, available + chunk_size);
+		if (buffer.size() < needed)
+			buffer.resize(std::max(needed, buffer.size() * 2));
+
+		while (available < count && !eof)
+		{
+			size_t received = device.read(buffer.data() + available, buffer.size() - available, false);
+			if (received == 0)
+				eof = true;
+			available += received;
+		}
+
+		pos = buffer.data();
+		end = pos + available;
+		return available >= count;
+	}
+}
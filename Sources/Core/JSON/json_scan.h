@@ -0,0 +1,118 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#if !defined __ANDROID__ && ! defined CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Character scanning shared by the JSON reader and writer
+	///
+	/// Both functions look at 16 bytes at a time while a full vector fits before the end pointer.
+	class JsonScan
+	{
+	public:
+		/// \brief Returns the first quote, backslash or control character, or end if there is none
+		static const char *find_string_special(const char *pos, const char *end)
+		{
+#ifdef __SSE2__
+			const __m128i quote = _mm_set1_epi8('"');
+			const __m128i backslash = _mm_set1_epi8('\\');
+			const __m128i control = _mm_set1_epi8(0x1f);
+			while (end - pos >= 16)
+			{
+				__m128i data = _mm_loadu_si128((const __m128i*)pos);
+				__m128i special = _mm_or_si128(_mm_cmpeq_epi8(data, quote), _mm_cmpeq_epi8(data, backslash));
+				special = _mm_or_si128(special, _mm_cmpeq_epi8(_mm_max_epu8(data, control), control));
+				int mask = _mm_movemask_epi8(special);
+				if (mask)
+					return pos + first_set_bit(mask);
+				pos += 16;
+			}
+#endif
+			while (pos != end && !is_string_special(*pos))
+				pos++;
+			return pos;
+		}
+
+		/// \brief Returns the first character that is not whitespace, or end if there is none
+		static const char *skip_whitespace(const char *pos, const char *end)
+		{
+#ifdef __SSE2__
+			const __m128i space = _mm_set1_epi8(' ');
+			const __m128i tab = _mm_set1_epi8('\t');
+			const __m128i newline = _mm_set1_epi8('\n');
+			const __m128i carriage_return = _mm_set1_epi8('\r');
+			const __m128i form_feed = _mm_set1_epi8('\f');
+			while (end - pos >= 16)
+			{
+				__m128i data = _mm_loadu_si128((const __m128i*)pos);
+				__m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(data, space), _mm_cmpeq_epi8(data, tab));
+				whitespace = _mm_or_si128(whitespace, _mm_or_si128(_mm_cmpeq_epi8(data, newline), _mm_cmpeq_epi8(data, carriage_return)));
+				whitespace = _mm_or_si128(whitespace, _mm_cmpeq_epi8(data, form_feed));
+				int mask = _mm_movemask_epi8(whitespace) ^ 0xffff;
+				if (mask)
+					return pos + first_set_bit(mask);
+				pos += 16;
+			}
+#endif
+			while (pos != end && is_whitespace(*pos))
+				pos++;
+			return pos;
+		}
+
+		static bool is_string_special(char c)
+		{
+			return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+		}
+
+		static bool is_whitespace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+		}
+
+	private:
+		static int first_set_bit(int mask)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+	};
+}
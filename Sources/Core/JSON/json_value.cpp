@@ -28,469 +28,101 @@
 
 #include "Core/precomp.h"
 #include "API/Core/JSON/json_value.h"
-#include "API/Core/Text/string_help.h"
+#include "API/Core/JSON/json_reader.h"
+#include "API/Core/JSON/json_writer.h"
 
 namespace clan
 {
-	class JsonValueImpl
-	{
-	public:
-		static void write(const JsonValue &value, std::string &json);
-		static void write_array(const JsonValue &value, std::string &json);
-		static void write_object(const JsonValue &value, std::string &json);
-		static void write_string(const std::string &str, std::string &json);
-		static void write_number(const JsonValue &value, std::string &json);
-
-		static JsonValue read(const std::string &json, size_t &pos);
-		static JsonValue read_object(const std::string &json, size_t &pos);
-		static JsonValue read_array(const std::string &json, size_t &pos);
-		static std::string read_string(const std::string &json, size_t &pos);
-		static JsonValue read_number(const std::string &json, size_t &pos);
-		static JsonValue read_boolean(const std::string &json, size_t &pos);
-		static void read_whitespace(const std::string &json, size_t &pos);
-	};
-
 	std::string JsonValue::to_json() const
 	{
 		std::string result;
-		JsonValueImpl::write(*this, result);
-		return result;
-	}
-
-	JsonValue JsonValue::parse(const std::string &json)
-	{
-		size_t pos = 0;
-		return JsonValueImpl::read(json, pos);
-	}
-
-	/////////////////////////////////////////////////////////////////////////
-
-	void JsonValueImpl::write(const JsonValue &value, std::string &json)
-	{
-		switch (value.type())
-		{
-		case JsonType::null:
-			json += "null";
-			break;
-		case JsonType::object:
-			write_object(value, json);
-			break;
-		case JsonType::array:
-			write_array(value, json);
-			break;
-		case JsonType::string:
-			write_string(value.to_string(), json);
-			break;
-		case JsonType::number:
-			write_number(value, json);
-			break;
-		case JsonType::boolean:
-			json += value.to_boolean() ? "true" : "false";
-			break;
-		case JsonType::undefined:
-			break;
-		}
-	}
-
-	void JsonValueImpl::write_array(const JsonValue &value, std::string &json)
-	{
-		json += "[";
-		for (size_t i = 0; i < value.items().size(); i++)
+		if (!is_undefined())
 		{
-			if (i > 0)
-				json += ",";
-			write(value.items()[i], json);
+			JsonWriter writer(result);
+			writer.write_value(*this);
 		}
-		json += "]";
+		return result;
 	}
 
-	void JsonValueImpl::write_object(const JsonValue &value, std::string &json)
+	JsonValue JsonValue::parse(const std::string &json)
 	{
-		json += "{";
-		std::map<std::string, JsonValue>::const_iterator it;
-		for (it = value.properties().begin(); it != value.properties().end(); ++it)
-		{
-			if (it != value.properties().begin())
-				json += ",";
-			write_string(it->first, json);
-			json += ":";
-			write(it->second, json);
-		}
-		json += "}";
+		JsonReader reader(json.data(), json.size());
+		return parse(reader);
 	}
 
-	void JsonValueImpl::write_string(const std::string &str, std::string &json)
-	{
-		json.push_back('"');
-
-		for (auto c : str)
-		{
-			if (c == '"' || c == '\\')
-			{
-				json.push_back('\\');
-				json.push_back(c);
-			}
-			else if (c == '\b')
-			{
-				json.push_back('\\');
-				json.push_back('b');
-			}
-			else if (c == '\f')
-			{
-				json.push_back('\\');
-				json.push_back('f');
-			}
-			else if (c == '\n')
-			{
-				json.push_back('\\');
-				json.push_back('n');
-			}
-			else if (c == '\r')
-			{
-				json.push_back('\\');
-				json.push_back('r');
-			}
-			else if (c == '\t')
-			{
-				json.push_back('\\');
-				json.push_back('t');
-			}
-			else if (c < 32)
-			{
-				json.push_back('\\');
-				json.push_back('u');
-				json.push_back('0');
-				json.push_back('0');
-
-				if (c >= 16)
-				{
-					json.push_back('1');
-					c -= 16;
-				}
-				else
-				{
-					json.push_back('0');
-				}
-
-				if (c < 10)
-				{
-					json.push_back('0' + c);
-				}
-				else
-				{
-					json.push_back('a' + (c - 10));
-				}
-				}
-			else
-			{
-				json.push_back(c);
-			}
-			}
-
-		json.push_back('"');
-		}
-
-	void JsonValueImpl::write_number(const JsonValue &value, std::string &json)
+	JsonValue JsonValue::parse(IODevice &input)
 	{
-		char buf[64];
-		buf[0] = 0;
-		if (static_cast<double>(static_cast<int>(value.to_number())) == value.to_number())
-		{
-#ifdef WIN32
-			_snprintf(buf, 63, "%d", (int)value.to_number());
-#else
-			snprintf(buf, 63, "%d", (int)value.to_number());
-#endif
-		}
-		else
-		{
-#ifdef WIN32
-			_snprintf(buf, 63, "%f", value.to_number());
-#else
-			snprintf(buf, 63, "%f", value.to_number());
-#endif
-		}
-		buf[63] = 0;
-		json += buf;
+		JsonReader reader(input);
+		return parse(reader);
 	}
 
-	JsonValue JsonValueImpl::read(const std::string &json, size_t &pos)
+	JsonValue JsonValue::parse(JsonReader &reader)
 	{
-		read_whitespace(json, pos);
-
-		if (pos == json.length())
-			throw JsonException("Unexpected end of JSON data");
-
-		switch (json[pos])
+		// Finished values and property names of all open containers are kept on flat stacks.
+		// When a container ends its values are moved into place in one go, so item vectors get their exact size.
+		struct OpenContainer
 		{
-		case '{':
-			return read_object(json, pos);
-		case '[':
-			return read_array(json, pos);
-		case '"':
-			return JsonValue::string(read_string(json, pos));
-		case '-':
-		case '0':
-		case '1':
-		case '2':
-		case '3':
-		case '4':
-		case '5':
-		case '6':
-		case '7':
-		case '8':
-		case '9':
-			return read_number(json, pos);
-		case 'f':
-		case 't':
-			return read_boolean(json, pos);
-		default:
-			throw JsonException("Unexpected character in JSON data");
-		}
-	}
-
-	JsonValue JsonValueImpl::read_object(const std::string &json, size_t &pos)
-	{
-		JsonValue result = JsonValue::object();
-
-		pos++;
+			size_t first_value;
+			size_t first_name;
+		};
+		std::vector<OpenContainer> open;
+		std::vector<JsonValue> values;
+		std::vector<std::string> names;
 
-		read_whitespace(json, pos);
-
-		if (pos == json.length())
-			throw JsonException("Unexpected end of JSON data");
-
-		while (pos != json.length() && json[pos] != '}')
+		while (true)
 		{
-			std::string key = read_string(json, pos);
-
-			read_whitespace(json, pos);
-
-			if (pos == json.length())
-				throw JsonException("Unexpected end of JSON data");
-			else if (json[pos] != ':')
-				throw JsonException("Unexpected character in JSON data");
-			pos++;
-
-			read_whitespace(json, pos);
-
-			result.prop(key) = read(json, pos);
-
-			read_whitespace(json, pos);
-
-			if (pos == json.length())
+			switch (reader.next())
 			{
+			case JsonToken::end:
 				throw JsonException("Unexpected end of JSON data");
-			}
-			else if (json[pos] == '}')
-			{
+			case JsonToken::begin_object:
+			case JsonToken::begin_array:
+				open.push_back({ values.size(), names.size() });
+				continue;
+			case JsonToken::property_name:
+				names.emplace_back(reader.get_text(), reader.get_text_length());
+				continue;
+			case JsonToken::string:
+				values.push_back(JsonValue::string(std::string(reader.get_text(), reader.get_text_length())));
 				break;
-			}
-			else if (json[pos] == ',')
-			{
-				pos++;
-				read_whitespace(json, pos);
-			}
-			else
-			{
-				throw JsonException("Unexpected character in JSON data");
-			}
-		}
-		pos++;
-
-		return result;
-	}
-
-	JsonValue JsonValueImpl::read_array(const std::string &json, size_t &pos)
-	{
-		JsonValue result = JsonValue::array();
-
-		pos++;
-
-		read_whitespace(json, pos);
-
-		if (pos == json.length())
-			throw JsonException("Unexpected end of JSON data");
-
-		while (json[pos] != ']')
-		{
-			read_whitespace(json, pos);
-			result.items().push_back(read(json, pos));
-			read_whitespace(json, pos);
-
-			if (pos == json.length())
-			{
-				throw JsonException("Unexpected end of JSON data");
-			}
-			else if (json[pos] == ']')
-			{
+			case JsonToken::number:
+				values.push_back(JsonValue::number(reader.get_number()));
 				break;
-			}
-			else if (json[pos] == ',')
-			{
-				pos++;
-				read_whitespace(json, pos);
-			}
-			else
-			{
-				throw JsonException("Unexpected character in JSON data");
-			}
-		}
-		pos++;
-
-		return result;
-	}
-
-	std::string JsonValueImpl::read_string(const std::string &json, size_t &pos)
-	{
-		pos++;
-		if (pos == json.length())
-			throw JsonException("Unexpected end of JSON data");
-
-		std::string result;
-		while (true)
-		{
-			if (pos == json.length())
-			{
-				throw JsonException("Unexpected end of JSON data");
-			}
-			else if (json[pos] == '"')
-			{
+			case JsonToken::boolean:
+				values.push_back(JsonValue::boolean(reader.get_boolean()));
+				break;
+			case JsonToken::null:
+				values.push_back(JsonValue::null());
+				break;
+			case JsonToken::end_array:
+			{
+				JsonValue array = JsonValue::array();
+				size_t first = open.back().first_value;
+				array._items.reserve(values.size() - first);
+				for (size_t i = first; i < values.size(); i++)
+					array._items.push_back(std::move(values[i]));
+				values.erase(values.begin() + first, values.end());
+				open.pop_back();
+				values.push_back(std::move(array));
 				break;
 			}
-			else if (json[pos] == '\\')
-			{
-				pos++;
-				if (pos == json.length())
-					throw JsonException("Unexpected end of JSON data");
-
-				unsigned codepoint;
-				switch (json[pos])
-				{
-				case '"':
-					result.push_back('"');
-					break;
-				case '\\':
-					result.push_back('\\');
-					break;
-				case '/':
-					result.push_back('/');
-					break;
-				case 'b':
-					result.push_back('\b');
-					break;
-				case 'f':
-					result.push_back('\f');
-					break;
-				case 'n':
-					result.push_back('\n');
-					break;
-				case 'r':
-					result.push_back('\r');
-					break;
-				case 't':
-					result.push_back('\t');
-					break;
-				case 'u':
-					if (pos + 5 > json.length())
-						throw JsonException("Unexpected end of JSON data");
-
-					codepoint = 0;
-					for (int i = 0; i < 4; i++)
-					{
-						char c = json[pos + 1 + i];
-						if (c >= '0' && c <= '9')
-						{
-							codepoint <<= 4;
-							codepoint |= c - '0';
-						}
-						else if (c >= 'a' && c <= 'f')
-						{
-							codepoint <<= 4;
-							codepoint |= c - 'a' + 10;
-						}
-						else if (c >= 'A' && c <= 'F')
-						{
-							codepoint <<= 4;
-							codepoint |= c - 'A' + 10;
-						}
-						else
-						{
-							throw JsonException("Invalid unicode escape");
-						}
-					}
-					result += StringHelp::unicode_to_utf8(codepoint);
-					pos += 4;
-					break;
-				}
-				pos++;
+			case JsonToken::end_object:
+			{
+				JsonValue object = JsonValue::object();
+				size_t first = open.back().first_value;
+				size_t first_name = open.back().first_name;
+				for (size_t i = first; i < values.size(); i++)
+					object._properties[std::move(names[first_name + i - first])] = std::move(values[i]);
+				values.erase(values.begin() + first, values.end());
+				names.erase(names.begin() + first_name, names.end());
+				open.pop_back();
+				values.push_back(std::move(object));
+				break;
 			}
-			else
-			{
-				result.push_back(json[pos]);
-				pos++;
 			}
-		}
-
-		pos++;
-
-		return result;
-	}
 
-	JsonValue JsonValueImpl::read_number(const std::string &json, size_t &pos)
-	{
-		int start_pos = pos;
-		if (json[pos] == '-')
-			pos++;
-		while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-			pos++;
-		if (pos != json.length() && json[pos] == '.')
-			pos++;
-		while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-			pos++;
-		if (pos != json.length() && (json[pos] == 'e' || json[pos] == 'E'))
-		{
-			pos++;
-			if (pos != json.length() && (json[pos] == '+' || json[pos] == '-'))
-				pos++;
-			while (pos < json.length() && json[pos] >= '0' && json[pos] <= '9')
-				pos++;
+			if (open.empty())
+				return std::move(values.back());
 		}
-		int end_pos = pos;
-
-		std::string number_string = json.substr(start_pos, end_pos - start_pos);
-		if (number_string.empty())
-			throw JsonException("Unexpected character in JSON data");
-
-		double result = 0.0;
-		sscanf(number_string.c_str(), "%lf", &result);
-		return JsonValue::number(result);
 	}
-
-	JsonValue JsonValueImpl::read_boolean(const std::string &json, size_t &pos)
-	{
-		if (json[pos] == 't')
-		{
-			if (pos + 4 > json.length() || memcmp(&json[pos], "true", 4) != 0)
-				throw JsonException("Unexpected character in JSON data");
-			pos += 4;
-			return JsonValue::boolean(true);
-		}
-		else
-		{
-			if (pos + 5 > json.length() || memcmp(&json[pos], "false", 5) != 0)
-				throw JsonException("Unexpected character in JSON data");
-			pos += 5;
-			return JsonValue::boolean(false);
-		}
-	}
-
-	void JsonValueImpl::read_whitespace(const std::string &json, size_t &pos)
-	{
-		while (pos != json.length() && (json[pos] == ' ' || json[pos] == '\r' || json[pos] == '\n' || json[pos] == '\t' || json[pos] == '\f'))
-			pos++;
-	}
-	
 }
-
-
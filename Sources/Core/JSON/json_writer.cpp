@@ -0,0 +1,342 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/JSON/json_writer.h"
+#include "API/Core/JSON/json_value.h"
+#include "API/Core/IOData/iodevice.h"
+#include "json_scan.h"
+#include <cmath>
+#include <vector>
+
+namespace clan
+{
+	class JsonWriter_Impl
+	{
+	public:
+		JsonWriter_Impl(IODevice *device, std::string *target, size_t flush_threshold);
+		~JsonWriter_Impl();
+
+		void begin_value();
+		void begin_container(char c);
+		void end_container(char c);
+		void write_name(const char *name, size_t length);
+		void write_escaped(const char *data, size_t length);
+		void write_number(double value);
+		void write_value(const JsonValue &value);
+		void flush();
+
+		void check_flush()
+		{
+			if (streaming && buffer.size() >= flush_threshold)
+				flush();
+		}
+
+		std::string *output;
+
+	private:
+		IODevice device;
+		bool streaming;
+		std::string buffer;
+		size_t flush_threshold;
+		std::vector<bool> first_in_container;
+		bool after_name = false;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonWriter::JsonWriter()
+	{
+	}
+
+	JsonWriter::JsonWriter(IODevice &output, size_t flush_threshold) : impl(std::make_shared<JsonWriter_Impl>(&output, nullptr, flush_threshold))
+	{
+	}
+
+	JsonWriter::JsonWriter(std::string &output) : impl(std::make_shared<JsonWriter_Impl>(nullptr, &output, 0))
+	{
+	}
+
+	JsonWriter::~JsonWriter()
+	{
+	}
+
+	void JsonWriter::begin_object()
+	{
+		impl->begin_container('{');
+	}
+
+	void JsonWriter::end_object()
+	{
+		impl->end_container('}');
+	}
+
+	void JsonWriter::begin_array()
+	{
+		impl->begin_container('[');
+	}
+
+	void JsonWriter::end_array()
+	{
+		impl->end_container(']');
+	}
+
+	void JsonWriter::write_property_name(const std::string &name)
+	{
+		write_property_name(name.data(), name.size());
+	}
+
+	void JsonWriter::write_property_name(const char *name, size_t length)
+	{
+		impl->write_name(name, length);
+	}
+
+	void JsonWriter::write_string(const std::string &value)
+	{
+		write_string(value.data(), value.size());
+	}
+
+	void JsonWriter::write_string(const char *value, size_t length)
+	{
+		impl->begin_value();
+		impl->write_escaped(value, length);
+		impl->check_flush();
+	}
+
+	void JsonWriter::write_number(double value)
+	{
+		impl->begin_value();
+		impl->write_number(value);
+		impl->check_flush();
+	}
+
+	void JsonWriter::write_boolean(bool value)
+	{
+		impl->begin_value();
+		impl->output->append(value ? "true" : "false");
+		impl->check_flush();
+	}
+
+	void JsonWriter::write_null()
+	{
+		impl->begin_value();
+		impl->output->append("null");
+		impl->check_flush();
+	}
+
+	void JsonWriter::write_value(const JsonValue &value)
+	{
+		impl->write_value(value);
+		impl->check_flush();
+	}
+
+	void JsonWriter::flush()
+	{
+		impl->flush();
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	JsonWriter_Impl::JsonWriter_Impl(IODevice *output_device, std::string *target, size_t flush_threshold) : streaming(output_device != nullptr), flush_threshold(flush_threshold)
+	{
+		if (streaming)
+		{
+			device = *output_device;
+			buffer.reserve(flush_threshold + 1024);
+			output = &buffer;
+		}
+		else
+		{
+			output = target;
+		}
+	}
+
+	JsonWriter_Impl::~JsonWriter_Impl()
+	{
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	void JsonWriter_Impl::flush()
+	{
+		if (streaming && !buffer.empty())
+		{
+			device.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+
+	void JsonWriter_Impl::begin_value()
+	{
+		if (after_name)
+		{
+			after_name = false;
+		}
+		else if (!first_in_container.empty())
+		{
+			if (!first_in_container.back())
+				output->push_back(',');
+			first_in_container.back() = false;
+		}
+	}
+
+	void JsonWriter_Impl::begin_container(char c)
+	{
+		begin_value();
+		output->push_back(c);
+		first_in_container.push_back(true);
+	}
+
+	void JsonWriter_Impl::end_container(char c)
+	{
+		if (first_in_container.empty() || after_name)
+			throw JsonException("Unexpected end of container in JsonWriter");
+		first_in_container.pop_back();
+		output->push_back(c);
+		check_flush();
+	}
+
+	void JsonWriter_Impl::write_name(const char *name, size_t length)
+	{
+		if (first_in_container.empty() || after_name)
+			throw JsonException("Unexpected property name in JsonWriter");
+		begin_value();
+		write_escaped(name, length);
+		output->push_back(':');
+		after_name = true;
+	}
+
+	void JsonWriter_Impl::write_escaped(const char *data, size_t length)
+	{
+		static const char hex[] = "0123456789abcdef";
+
+		const char *end = data + length;
+		output->push_back('"');
+		while (true)
+		{
+			const char *special = JsonScan::find_string_special(data, end);
+			output->append(data, special);
+			if (special == end)
+				break;
+
+			unsigned char c = *special;
+			switch (c)
+			{
+			case '"': output->append("\\\"", 2); break;
+			case '\\': output->append("\\\\", 2); break;
+			case '\b': output->append("\\b", 2); break;
+			case '\f': output->append("\\f", 2); break;
+			case '\n': output->append("\\n", 2); break;
+			case '\r': output->append("\\r", 2); break;
+			case '\t': output->append("\\t", 2); break;
+			default:
+				{
+					char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+					output->append(escape, 6);
+				}
+				break;
+			}
+			data = special + 1;
+		}
+		output->push_back('"');
+	}
+
+	void JsonWriter_Impl::write_number(double value)
+	{
+		char buf[64];
+		if (!std::isfinite(value))
+		{
+			// JSON has no representation for infinity or NaN
+			output->append("null");
+			return;
+		}
+		else if (value == std::floor(value) && std::abs(value) < 1e15)
+		{
+			snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(value));
+		}
+		else
+		{
+			// Use the shortest precision that survives a round trip
+			snprintf(buf, sizeof(buf), "%.15g", value);
+			if (strtod(buf, nullptr) != value)
+				snprintf(buf, sizeof(buf), "%.17g", value);
+		}
+		output->append(buf);
+	}
+
+	void JsonWriter_Impl::write_value(const JsonValue &value)
+	{
+		switch (value.type())
+		{
+		case JsonType::null:
+		case JsonType::undefined:
+			// Undefined properties are left out by the object case below
+			begin_value();
+			output->append("null");
+			break;
+		case JsonType::object:
+			begin_container('{');
+			for (const auto &it : value.properties())
+			{
+				if (it.second.is_undefined())
+					continue;
+				write_name(it.first.data(), it.first.size());
+				write_value(it.second);
+				check_flush();
+			}
+			end_container('}');
+			break;
+		case JsonType::array:
+			begin_container('[');
+			for (const auto &item : value.items())
+			{
+				write_value(item);
+				check_flush();
+			}
+			end_container(']');
+			break;
+		case JsonType::string:
+			begin_value();
+			write_escaped(value.to_string().data(), value.to_string().size());
+			break;
+		case JsonType::number:
+			begin_value();
+			write_number(value.to_number());
+			break;
+		case JsonType::boolean:
+			begin_value();
+			output->append(value.to_boolean() ? "true" : "false");
+			break;
+		}
+	}
+}
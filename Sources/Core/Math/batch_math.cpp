@@ -0,0 +1,673 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/Math/batch_math.h"
+#include "API/Core/Math/aabb.h"
+#include "API/Core/Math/obb.h"
+#include "API/Core/Math/frustum_planes.h"
+#include "API/Core/Math/intersection_test.h"
+#include "API/Core/System/system.h"
+
+#if !defined(ARM_PLATFORM) && !defined(CL_ARM) && !defined(CL_DISABLE_SSE2)
+#define CL_BATCH_MATH_SIMD
+#include <immintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for the instructions they use, independent of the flags the library is built with.
+// They are only called after detect_cpu_extension confirmed the CPU supports them.
+#if defined(__GNUC__)
+#define BATCH_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define BATCH_AVX2_TARGET
+#endif
+
+namespace clan
+{
+	static_assert(sizeof(Vec3f) == 3 * sizeof(float) && sizeof(Vec4f) == 4 * sizeof(float), "Vectors must be tightly packed");
+	static_assert(sizeof(Quaternionf) == 4 * sizeof(float), "Quaternions must be tightly packed");
+	static_assert(sizeof(AxisAlignedBoundingBox) == 6 * sizeof(float) && sizeof(OrientedBoundingBox) == 15 * sizeof(float), "Boxes must be tightly packed");
+
+	namespace
+	{
+		void clear_mask(uint32_t *mask, size_t count)
+		{
+			if (mask)
+				memset(mask, 0, (count + 31) / 32 * sizeof(uint32_t));
+		}
+
+		void set_mask_bits(uint32_t *mask, size_t index, uint32_t bits)
+		{
+			mask[index >> 5] |= bits << (index & 31);
+		}
+
+		void frustum_aabb_scalar(const FrustumPlanes &frustum, const AxisAlignedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			for (size_t i = start; i < count; i++)
+			{
+				IntersectionTest::Result result = IntersectionTest::frustum_aabb(frustum, boxes[i]);
+				if (result != IntersectionTest::outside)
+					set_mask_bits(out_visible, i, 1);
+				if (out_inside && result == IntersectionTest::inside)
+					set_mask_bits(out_inside, i, 1);
+			}
+		}
+
+		void frustum_obb_scalar(const FrustumPlanes &frustum, const OrientedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			for (size_t i = start; i < count; i++)
+			{
+				IntersectionTest::Result result = IntersectionTest::frustum_obb(frustum, boxes[i]);
+				if (result != IntersectionTest::outside)
+					set_mask_bits(out_visible, i, 1);
+				if (out_inside && result == IntersectionTest::inside)
+					set_mask_bits(out_inside, i, 1);
+			}
+		}
+
+		void slerp_scalar(const Quaternionf *initial, const Quaternionf *final, const float *time, float uniform_time, Quaternionf *out, size_t start, size_t count)
+		{
+			for (size_t i = start; i < count; i++)
+				out[i] = Quaternionf::slerp(initial[i], final[i], time ? time[i] : uniform_time);
+		}
+
+#ifdef CL_BATCH_MATH_SIMD
+
+		bool is_avx2_supported()
+		{
+			static bool supported = System::detect_cpu_extension(System::avx2) && System::detect_cpu_extension(System::fma3);
+			return supported;
+		}
+
+		/////////////////////////////////////////////////////////////////////////
+		// SSE2 kernels
+
+		void transform_points_sse2(const Mat4f &matrix, const Vec3f *in, Vec4f *out, size_t count)
+		{
+			__m128 col0 = _mm_loadu_ps(matrix.matrix);
+			__m128 col1 = _mm_loadu_ps(matrix.matrix + 4);
+			__m128 col2 = _mm_loadu_ps(matrix.matrix + 8);
+			__m128 col3 = _mm_loadu_ps(matrix.matrix + 12);
+			for (size_t i = 0; i < count; i++)
+			{
+				__m128 result = _mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(in[i].x)), col3);
+				result = _mm_add_ps(_mm_mul_ps(col1, _mm_set1_ps(in[i].y)), result);
+				result = _mm_add_ps(_mm_mul_ps(col2, _mm_set1_ps(in[i].z)), result);
+				_mm_storeu_ps(&out[i].x, result);
+			}
+		}
+
+		void transform_points_sse2(const Mat4f &matrix, const Vec4f *in, Vec4f *out, size_t count)
+		{
+			__m128 col0 = _mm_loadu_ps(matrix.matrix);
+			__m128 col1 = _mm_loadu_ps(matrix.matrix + 4);
+			__m128 col2 = _mm_loadu_ps(matrix.matrix + 8);
+			__m128 col3 = _mm_loadu_ps(matrix.matrix + 12);
+			for (size_t i = 0; i < count; i++)
+			{
+				__m128 v = _mm_loadu_ps(&in[i].x);
+				__m128 result = _mm_mul_ps(col0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm_add_ps(_mm_mul_ps(col1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))), result);
+				result = _mm_add_ps(_mm_mul_ps(col2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))), result);
+				result = _mm_add_ps(_mm_mul_ps(col3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))), result);
+				_mm_storeu_ps(&out[i].x, result);
+			}
+		}
+
+		// The box tests process four boxes per iteration, one in each lane, and do the arithmetic in the same order
+		// as IntersectionTest so that the batch and single box results are identical.
+		struct PlanesSSE2
+		{
+			PlanesSSE2(const FrustumPlanes &frustum)
+			{
+				for (int i = 0; i < 6; i++)
+				{
+					x[i] = _mm_set1_ps(frustum.planes[i].x);
+					y[i] = _mm_set1_ps(frustum.planes[i].y);
+					z[i] = _mm_set1_ps(frustum.planes[i].z);
+					w[i] = _mm_set1_ps(frustum.planes[i].w);
+					abs_x[i] = _mm_set1_ps(std::abs(frustum.planes[i].x));
+					abs_y[i] = _mm_set1_ps(std::abs(frustum.planes[i].y));
+					abs_z[i] = _mm_set1_ps(std::abs(frustum.planes[i].z));
+				}
+			}
+
+			__m128 x[6], y[6], z[6], w[6], abs_x[6], abs_y[6], abs_z[6];
+		};
+
+		inline __m128 dot3_sse2(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+		}
+
+		inline __m128 load4_sse2(const float *base, size_t stride)
+		{
+			return _mm_setr_ps(base[0], base[stride], base[stride * 2], base[stride * 3]);
+		}
+
+		void frustum_aabb_sse2(const FrustumPlanes &frustum, const AxisAlignedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			PlanesSSE2 planes(frustum);
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 zero = _mm_setzero_ps();
+			const size_t stride = sizeof(AxisAlignedBoundingBox) / sizeof(float);
+
+			size_t i = start;
+			for (; i + 4 <= count; i += 4)
+			{
+				const float *min = &boxes[i].aabb_min.x;
+				const float *max = &boxes[i].aabb_max.x;
+				__m128 min_x = load4_sse2(min, stride), min_y = load4_sse2(min + 1, stride), min_z = load4_sse2(min + 2, stride);
+				__m128 max_x = load4_sse2(max, stride), max_y = load4_sse2(max + 1, stride), max_z = load4_sse2(max + 2, stride);
+
+				__m128 center_x = _mm_mul_ps(_mm_add_ps(max_x, min_x), half);
+				__m128 center_y = _mm_mul_ps(_mm_add_ps(max_y, min_y), half);
+				__m128 center_z = _mm_mul_ps(_mm_add_ps(max_z, min_z), half);
+				__m128 extents_x = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+				__m128 extents_y = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+				__m128 extents_z = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+				__m128 outside = _mm_setzero_ps();
+				__m128 inside = _mm_cmpeq_ps(zero, zero);
+				for (int p = 0; p < 6; p++)
+				{
+					__m128 e = dot3_sse2(extents_x, extents_y, extents_z, planes.abs_x[p], planes.abs_y[p], planes.abs_z[p]);
+					__m128 s = _mm_add_ps(dot3_sse2(center_x, center_y, center_z, planes.x[p], planes.y[p], planes.z[p]), planes.w[p]);
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(s, e), zero));
+					inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_sub_ps(s, e), zero));
+				}
+
+				set_mask_bits(out_visible, i, ~_mm_movemask_ps(outside) & 0xf);
+				if (out_inside)
+					set_mask_bits(out_inside, i, _mm_movemask_ps(_mm_andnot_ps(outside, inside)));
+			}
+
+			frustum_aabb_scalar(frustum, boxes, i, count, out_visible, out_inside);
+		}
+
+		void frustum_obb_sse2(const FrustumPlanes &frustum, const OrientedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			PlanesSSE2 planes(frustum);
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 sign_mask = _mm_set1_ps(-0.0f);
+			const size_t stride = sizeof(OrientedBoundingBox) / sizeof(float);
+
+			size_t i = start;
+			for (; i + 4 <= count; i += 4)
+			{
+				const float *box = &boxes[i].center.x;
+				__m128 center[3], extents[3], axis_x[3], axis_y[3], axis_z[3];
+				for (int c = 0; c < 3; c++)
+				{
+					center[c] = load4_sse2(box + c, stride);
+					extents[c] = load4_sse2(box + 3 + c, stride);
+					axis_x[c] = load4_sse2(box + 6 + c, stride);
+					axis_y[c] = load4_sse2(box + 9 + c, stride);
+					axis_z[c] = load4_sse2(box + 12 + c, stride);
+				}
+
+				__m128 outside = _mm_setzero_ps();
+				__m128 inside = _mm_cmpeq_ps(zero, zero);
+				for (int p = 0; p < 6; p++)
+				{
+					__m128 dot_x = _mm_andnot_ps(sign_mask, dot3_sse2(axis_x[0], axis_x[1], axis_x[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m128 dot_y = _mm_andnot_ps(sign_mask, dot3_sse2(axis_y[0], axis_y[1], axis_y[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m128 dot_z = _mm_andnot_ps(sign_mask, dot3_sse2(axis_z[0], axis_z[1], axis_z[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m128 e = dot3_sse2(extents[0], extents[1], extents[2], dot_x, dot_y, dot_z);
+					__m128 s = _mm_add_ps(dot3_sse2(center[0], center[1], center[2], planes.x[p], planes.y[p], planes.z[p]), planes.w[p]);
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(s, e), zero));
+					inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_sub_ps(s, e), zero));
+				}
+
+				set_mask_bits(out_visible, i, ~_mm_movemask_ps(outside) & 0xf);
+				if (out_inside)
+					set_mask_bits(out_inside, i, _mm_movemask_ps(_mm_andnot_ps(outside, inside)));
+			}
+
+			frustum_obb_scalar(frustum, boxes, i, count, out_visible, out_inside);
+		}
+
+		// acos for x in the range 0 to 1, using the asin approximation from the Cephes library
+		inline __m128 acos_sse2(__m128 x)
+		{
+			const __m128 half = _mm_set1_ps(0.5f);
+			__m128 large = _mm_cmpgt_ps(x, half);
+			__m128 z_large = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), x), half);
+			__m128 z = _mm_or_ps(_mm_and_ps(large, z_large), _mm_andnot_ps(large, _mm_mul_ps(x, x)));
+			__m128 a = _mm_or_ps(_mm_and_ps(large, _mm_sqrt_ps(z_large)), _mm_andnot_ps(large, x));
+
+			__m128 p = _mm_set1_ps(4.2163199048e-2f);
+			p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(2.4181311049e-2f));
+			p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(4.5470025998e-2f));
+			p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(7.4953002686e-2f));
+			p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(1.6666752422e-1f));
+			__m128 asin_a = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, z), a), a);
+
+			__m128 result_large = _mm_add_ps(asin_a, asin_a);
+			__m128 result_small = _mm_sub_ps(_mm_set1_ps(1.5707963267948966f), asin_a);
+			return _mm_or_ps(_mm_and_ps(large, result_large), _mm_andnot_ps(large, result_small));
+		}
+
+		// sin for x in the range 0 to pi/2, using its Taylor series to the x^11 term
+		inline __m128 sin_sse2(__m128 x)
+		{
+			__m128 x2 = _mm_mul_ps(x, x);
+			__m128 p = _mm_set1_ps(-2.5052108e-8f);
+			p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.7557319e-6f));
+			p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.9841270e-4f));
+			p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(8.3333333e-3f));
+			p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.6666667e-1f));
+			return _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, x2), x), x);
+		}
+
+		void slerp_sse2(const Quaternionf *initial, const Quaternionf *final, const float *time, float uniform_time, Quaternionf *out, size_t count)
+		{
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 sign_mask = _mm_set1_ps(-0.0f);
+			const __m128 threshold = _mm_set1_ps(0.001f);
+
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				// Members are stored w, x, y, z. After the transpose a[0] holds w of all four quaternions, a[1] x, and so on
+				__m128 a[4], b[4];
+				for (int j = 0; j < 4; j++)
+				{
+					a[j] = _mm_loadu_ps(&initial[i + j].w);
+					b[j] = _mm_loadu_ps(&final[i + j].w);
+				}
+				_MM_TRANSPOSE4_PS(a[0], a[1], a[2], a[3]);
+				_MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+				__m128 t = time ? _mm_loadu_ps(time + i) : _mm_set1_ps(uniform_time);
+
+				__m128 cos_theta = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(a[1], b[1]), _mm_mul_ps(a[2], b[2])), _mm_mul_ps(a[3], b[3])), _mm_mul_ps(a[0], b[0]));
+
+				// Take the shortest path by negating the final quaternion when the dot product is negative
+				__m128 sign = _mm_and_ps(cos_theta, sign_mask);
+				cos_theta = _mm_xor_ps(cos_theta, sign);
+				for (int j = 0; j < 4; j++)
+					b[j] = _mm_xor_ps(b[j], sign);
+
+				__m128 beta = _mm_sub_ps(one, t);
+				__m128 alpha = t;
+
+				// Fall back to linear interpolation when the quaternions are close
+				__m128 use_slerp = _mm_cmpgt_ps(_mm_sub_ps(one, cos_theta), threshold);
+				if (_mm_movemask_ps(use_slerp))
+				{
+					__m128 theta = acos_sse2(cos_theta);
+					__m128 inv_sin_theta = _mm_div_ps(one, sin_sse2(theta));
+					__m128 slerp_beta = _mm_mul_ps(sin_sse2(_mm_mul_ps(theta, beta)), inv_sin_theta);
+					__m128 slerp_alpha = _mm_mul_ps(sin_sse2(_mm_mul_ps(theta, alpha)), inv_sin_theta);
+					beta = _mm_or_ps(_mm_and_ps(use_slerp, slerp_beta), _mm_andnot_ps(use_slerp, beta));
+					alpha = _mm_or_ps(_mm_and_ps(use_slerp, slerp_alpha), _mm_andnot_ps(use_slerp, alpha));
+				}
+
+				__m128 result[4];
+				for (int j = 0; j < 4; j++)
+					result[j] = _mm_add_ps(_mm_mul_ps(beta, a[j]), _mm_mul_ps(alpha, b[j]));
+				_MM_TRANSPOSE4_PS(result[0], result[1], result[2], result[3]);
+				for (int j = 0; j < 4; j++)
+					_mm_storeu_ps(&out[i + j].w, result[j]);
+			}
+
+			slerp_scalar(initial, final, time, uniform_time, out, i, count);
+		}
+
+		/////////////////////////////////////////////////////////////////////////
+		// AVX2 and FMA3 kernels
+
+		BATCH_AVX2_TARGET void transform_points_avx2(const Mat4f &matrix, const Vec3f *in, Vec4f *out, size_t count)
+		{
+			__m256 col0 = _mm256_broadcast_ps((const __m128*)matrix.matrix);
+			__m256 col1 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 4));
+			__m256 col2 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 8));
+			__m256 col3 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 12));
+			const __m256i index_x = _mm256_setr_epi32(0, 0, 0, 0, 3, 3, 3, 3);
+			const __m256i index_y = _mm256_setr_epi32(1, 1, 1, 1, 4, 4, 4, 4);
+			const __m256i index_z = _mm256_setr_epi32(2, 2, 2, 2, 5, 5, 5, 5);
+
+			// Two points per iteration. The load reads eight floats, so the loop stops while a third point remains
+			size_t i = 0;
+			for (; i + 3 <= count; i += 2)
+			{
+				__m256 v = _mm256_loadu_ps(&in[i].x);
+				__m256 result = _mm256_fmadd_ps(col0, _mm256_permutevar8x32_ps(v, index_x), col3);
+				result = _mm256_fmadd_ps(col1, _mm256_permutevar8x32_ps(v, index_y), result);
+				result = _mm256_fmadd_ps(col2, _mm256_permutevar8x32_ps(v, index_z), result);
+				_mm256_storeu_ps(&out[i].x, result);
+			}
+
+			transform_points_sse2(matrix, in + i, out + i, count - i);
+		}
+
+		BATCH_AVX2_TARGET void transform_points_avx2(const Mat4f &matrix, const Vec4f *in, Vec4f *out, size_t count)
+		{
+			__m256 col0 = _mm256_broadcast_ps((const __m128*)matrix.matrix);
+			__m256 col1 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 4));
+			__m256 col2 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 8));
+			__m256 col3 = _mm256_broadcast_ps((const __m128*)(matrix.matrix + 12));
+
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+			{
+				__m256 v = _mm256_loadu_ps(&in[i].x);
+				__m256 result = _mm256_mul_ps(col0, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm256_fmadd_ps(col1, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), result);
+				result = _mm256_fmadd_ps(col2, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), result);
+				result = _mm256_fmadd_ps(col3, _mm256_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), result);
+				_mm256_storeu_ps(&out[i].x, result);
+			}
+
+			transform_points_sse2(matrix, in + i, out + i, count - i);
+		}
+
+		// The box tests use separate multiplies and adds rather than FMA, to give the same results as IntersectionTest
+		struct PlanesAVX2
+		{
+			BATCH_AVX2_TARGET PlanesAVX2(const FrustumPlanes &frustum)
+			{
+				for (int i = 0; i < 6; i++)
+				{
+					x[i] = _mm256_set1_ps(frustum.planes[i].x);
+					y[i] = _mm256_set1_ps(frustum.planes[i].y);
+					z[i] = _mm256_set1_ps(frustum.planes[i].z);
+					w[i] = _mm256_set1_ps(frustum.planes[i].w);
+					abs_x[i] = _mm256_set1_ps(std::abs(frustum.planes[i].x));
+					abs_y[i] = _mm256_set1_ps(std::abs(frustum.planes[i].y));
+					abs_z[i] = _mm256_set1_ps(std::abs(frustum.planes[i].z));
+				}
+			}
+
+			__m256 x[6], y[6], z[6], w[6], abs_x[6], abs_y[6], abs_z[6];
+		};
+
+		BATCH_AVX2_TARGET inline __m256 dot3_avx2(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+		{
+			return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+		}
+
+		BATCH_AVX2_TARGET void frustum_aabb_avx2(const FrustumPlanes &frustum, const AxisAlignedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			PlanesAVX2 planes(frustum);
+			const __m256 half = _mm256_set1_ps(0.5f);
+			const __m256 zero = _mm256_setzero_ps();
+			const int stride = sizeof(AxisAlignedBoundingBox) / sizeof(float);
+			const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+
+			size_t i = start;
+			for (; i + 8 <= count; i += 8)
+			{
+				const float *min = &boxes[i].aabb_min.x;
+				const float *max = &boxes[i].aabb_max.x;
+				__m256 min_x = _mm256_i32gather_ps(min, offsets, 4), min_y = _mm256_i32gather_ps(min + 1, offsets, 4), min_z = _mm256_i32gather_ps(min + 2, offsets, 4);
+				__m256 max_x = _mm256_i32gather_ps(max, offsets, 4), max_y = _mm256_i32gather_ps(max + 1, offsets, 4), max_z = _mm256_i32gather_ps(max + 2, offsets, 4);
+
+				__m256 center_x = _mm256_mul_ps(_mm256_add_ps(max_x, min_x), half);
+				__m256 center_y = _mm256_mul_ps(_mm256_add_ps(max_y, min_y), half);
+				__m256 center_z = _mm256_mul_ps(_mm256_add_ps(max_z, min_z), half);
+				__m256 extents_x = _mm256_mul_ps(_mm256_sub_ps(max_x, min_x), half);
+				__m256 extents_y = _mm256_mul_ps(_mm256_sub_ps(max_y, min_y), half);
+				__m256 extents_z = _mm256_mul_ps(_mm256_sub_ps(max_z, min_z), half);
+
+				__m256 outside = _mm256_setzero_ps();
+				__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+				for (int p = 0; p < 6; p++)
+				{
+					__m256 e = dot3_avx2(extents_x, extents_y, extents_z, planes.abs_x[p], planes.abs_y[p], planes.abs_z[p]);
+					__m256 s = _mm256_add_ps(dot3_avx2(center_x, center_y, center_z, planes.x[p], planes.y[p], planes.z[p]), planes.w[p]);
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(s, e), zero, _CMP_LT_OQ));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(s, e), zero, _CMP_GT_OQ));
+				}
+
+				set_mask_bits(out_visible, i, ~_mm256_movemask_ps(outside) & 0xff);
+				if (out_inside)
+					set_mask_bits(out_inside, i, _mm256_movemask_ps(_mm256_andnot_ps(outside, inside)));
+			}
+
+			frustum_aabb_sse2(frustum, boxes, i, count, out_visible, out_inside);
+		}
+
+		BATCH_AVX2_TARGET void frustum_obb_avx2(const FrustumPlanes &frustum, const OrientedBoundingBox *boxes, size_t start, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+		{
+			PlanesAVX2 planes(frustum);
+			const __m256 zero = _mm256_setzero_ps();
+			const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+			const int stride = sizeof(OrientedBoundingBox) / sizeof(float);
+			const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+
+			size_t i = start;
+			for (; i + 8 <= count; i += 8)
+			{
+				const float *box = &boxes[i].center.x;
+				__m256 center[3], extents[3], axis_x[3], axis_y[3], axis_z[3];
+				for (int c = 0; c < 3; c++)
+				{
+					center[c] = _mm256_i32gather_ps(box + c, offsets, 4);
+					extents[c] = _mm256_i32gather_ps(box + 3 + c, offsets, 4);
+					axis_x[c] = _mm256_i32gather_ps(box + 6 + c, offsets, 4);
+					axis_y[c] = _mm256_i32gather_ps(box + 9 + c, offsets, 4);
+					axis_z[c] = _mm256_i32gather_ps(box + 12 + c, offsets, 4);
+				}
+
+				__m256 outside = _mm256_setzero_ps();
+				__m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+				for (int p = 0; p < 6; p++)
+				{
+					__m256 dot_x = _mm256_andnot_ps(sign_mask, dot3_avx2(axis_x[0], axis_x[1], axis_x[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m256 dot_y = _mm256_andnot_ps(sign_mask, dot3_avx2(axis_y[0], axis_y[1], axis_y[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m256 dot_z = _mm256_andnot_ps(sign_mask, dot3_avx2(axis_z[0], axis_z[1], axis_z[2], planes.x[p], planes.y[p], planes.z[p]));
+					__m256 e = dot3_avx2(extents[0], extents[1], extents[2], dot_x, dot_y, dot_z);
+					__m256 s = _mm256_add_ps(dot3_avx2(center[0], center[1], center[2], planes.x[p], planes.y[p], planes.z[p]), planes.w[p]);
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(s, e), zero, _CMP_LT_OQ));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(s, e), zero, _CMP_GT_OQ));
+				}
+
+				set_mask_bits(out_visible, i, ~_mm256_movemask_ps(outside) & 0xff);
+				if (out_inside)
+					set_mask_bits(out_inside, i, _mm256_movemask_ps(_mm256_andnot_ps(outside, inside)));
+			}
+
+			frustum_obb_sse2(frustum, boxes, i, count, out_visible, out_inside);
+		}
+
+		BATCH_AVX2_TARGET inline __m256 acos_avx2(__m256 x)
+		{
+			const __m256 half = _mm256_set1_ps(0.5f);
+			__m256 large = _mm256_cmp_ps(x, half, _CMP_GT_OQ);
+			__m256 z_large = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), x), half);
+			__m256 z = _mm256_blendv_ps(_mm256_mul_ps(x, x), z_large, large);
+			__m256 a = _mm256_blendv_ps(x, _mm256_sqrt_ps(z_large), large);
+
+			__m256 p = _mm256_set1_ps(4.2163199048e-2f);
+			p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(2.4181311049e-2f));
+			p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(4.5470025998e-2f));
+			p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(7.4953002686e-2f));
+			p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(1.6666752422e-1f));
+			__m256 asin_a = _mm256_fmadd_ps(_mm256_mul_ps(p, z), a, a);
+
+			return _mm256_blendv_ps(_mm256_sub_ps(_mm256_set1_ps(1.5707963267948966f), asin_a), _mm256_add_ps(asin_a, asin_a), large);
+		}
+
+		BATCH_AVX2_TARGET inline __m256 sin_avx2(__m256 x)
+		{
+			__m256 x2 = _mm256_mul_ps(x, x);
+			__m256 p = _mm256_set1_ps(-2.5052108e-8f);
+			p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(2.7557319e-6f));
+			p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-1.9841270e-4f));
+			p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(8.3333333e-3f));
+			p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-1.6666667e-1f));
+			return _mm256_fmadd_ps(_mm256_mul_ps(p, x2), x, x);
+		}
+
+		// 4x4 transpose within each 128 bit half, turning two quaternions per register into one member per register
+		BATCH_AVX2_TARGET inline void transpose4_avx2(__m256 &r0, __m256 &r1, __m256 &r2, __m256 &r3)
+		{
+			__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+			__m256 t1 = _mm256_unpackhi_ps(r0, r1);
+			__m256 t2 = _mm256_unpacklo_ps(r2, r3);
+			__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+			r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+
+		BATCH_AVX2_TARGET void slerp_avx2(const Quaternionf *initial, const Quaternionf *final, const float *time, float uniform_time, Quaternionf *out, size_t count)
+		{
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+			const __m256 threshold = _mm256_set1_ps(0.001f);
+
+			// Register j holds quaternions i + 2 * j and i + 2 * j + 1, so after the transpose the lanes are in the order 0, 2, 4, 6, 1, 3, 5, 7
+			const __m256i time_order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+			size_t i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 a[4], b[4];
+				for (int j = 0; j < 4; j++)
+				{
+					a[j] = _mm256_loadu_ps(&initial[i + j * 2].w);
+					b[j] = _mm256_loadu_ps(&final[i + j * 2].w);
+				}
+				transpose4_avx2(a[0], a[1], a[2], a[3]);
+				transpose4_avx2(b[0], b[1], b[2], b[3]);
+				__m256 t = time ? _mm256_permutevar8x32_ps(_mm256_loadu_ps(time + i), time_order) : _mm256_set1_ps(uniform_time);
+
+				__m256 cos_theta = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a[1], b[1]), _mm256_mul_ps(a[2], b[2])), _mm256_mul_ps(a[3], b[3])), _mm256_mul_ps(a[0], b[0]));
+
+				__m256 sign = _mm256_and_ps(cos_theta, sign_mask);
+				cos_theta = _mm256_xor_ps(cos_theta, sign);
+				for (int j = 0; j < 4; j++)
+					b[j] = _mm256_xor_ps(b[j], sign);
+
+				__m256 beta = _mm256_sub_ps(one, t);
+				__m256 alpha = t;
+
+				__m256 use_slerp = _mm256_cmp_ps(_mm256_sub_ps(one, cos_theta), threshold, _CMP_GT_OQ);
+				if (_mm256_movemask_ps(use_slerp))
+				{
+					__m256 theta = acos_avx2(cos_theta);
+					__m256 inv_sin_theta = _mm256_div_ps(one, sin_avx2(theta));
+					beta = _mm256_blendv_ps(beta, _mm256_mul_ps(sin_avx2(_mm256_mul_ps(theta, beta)), inv_sin_theta), use_slerp);
+					alpha = _mm256_blendv_ps(alpha, _mm256_mul_ps(sin_avx2(_mm256_mul_ps(theta, alpha)), inv_sin_theta), use_slerp);
+				}
+
+				__m256 result[4];
+				for (int j = 0; j < 4; j++)
+					result[j] = _mm256_fmadd_ps(beta, a[j], _mm256_mul_ps(alpha, b[j]));
+				transpose4_avx2(result[0], result[1], result[2], result[3]);
+				for (int j = 0; j < 4; j++)
+					_mm256_storeu_ps(&out[i + j * 2].w, result[j]);
+			}
+
+			slerp_sse2(initial + i, final + i, time ? time + i : nullptr, uniform_time, out + i, count - i);
+		}
+
+#endif
+	}
+
+	void BatchMath::transform_points(const Mat4f &matrix, const Vec3f *in, Vec4f *out, size_t count)
+	{
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			transform_points_avx2(matrix, in, out, count);
+		else
+			transform_points_sse2(matrix, in, out, count);
+#else
+		for (size_t i = 0; i < count; i++)
+			out[i] = matrix * Vec4f(in[i], 1.0f);
+#endif
+	}
+
+	void BatchMath::transform_points(const Mat4f &matrix, const Vec4f *in, Vec4f *out, size_t count)
+	{
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			transform_points_avx2(matrix, in, out, count);
+		else
+			transform_points_sse2(matrix, in, out, count);
+#else
+		for (size_t i = 0; i < count; i++)
+			out[i] = matrix * in[i];
+#endif
+	}
+
+	void BatchMath::frustum_aabb(const FrustumPlanes &frustum, const AxisAlignedBoundingBox *boxes, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+	{
+		clear_mask(out_visible, count);
+		clear_mask(out_inside, count);
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			frustum_aabb_avx2(frustum, boxes, 0, count, out_visible, out_inside);
+		else
+			frustum_aabb_sse2(frustum, boxes, 0, count, out_visible, out_inside);
+#else
+		frustum_aabb_scalar(frustum, boxes, 0, count, out_visible, out_inside);
+#endif
+	}
+
+	void BatchMath::frustum_obb(const FrustumPlanes &frustum, const OrientedBoundingBox *boxes, size_t count, uint32_t *out_visible, uint32_t *out_inside)
+	{
+		clear_mask(out_visible, count);
+		clear_mask(out_inside, count);
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			frustum_obb_avx2(frustum, boxes, 0, count, out_visible, out_inside);
+		else
+			frustum_obb_sse2(frustum, boxes, 0, count, out_visible, out_inside);
+#else
+		frustum_obb_scalar(frustum, boxes, 0, count, out_visible, out_inside);
+#endif
+	}
+
+	void BatchMath::slerp(const Quaternionf *initial, const Quaternionf *final, const float *time, Quaternionf *out, size_t count)
+	{
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			slerp_avx2(initial, final, time, 0.0f, out, count);
+		else
+			slerp_sse2(initial, final, time, 0.0f, out, count);
+#else
+		slerp_scalar(initial, final, time, 0.0f, out, 0, count);
+#endif
+	}
+
+	void BatchMath::slerp(const Quaternionf *initial, const Quaternionf *final, float time, Quaternionf *out, size_t count)
+	{
+#ifdef CL_BATCH_MATH_SIMD
+		if (is_avx2_supported())
+			slerp_avx2(initial, final, nullptr, time, out, count);
+		else
+			slerp_sse2(initial, final, nullptr, time, out, count);
+#else
+		slerp_scalar(initial, final, nullptr, time, out, 0, count);
+#endif
+	}
+}
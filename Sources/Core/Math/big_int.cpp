@@ -336,9 +336,9 @@ namespace clan
 		return impl->cmp(b->impl.get());
 	}
 
-	void BigInt::exptmod(const BigInt *b, const BigInt *m, BigInt *c) const
+	void BigInt::exptmod(const BigInt *b, const BigInt *m, BigInt *c, bool constant_time) const
 	{
-		impl->exptmod(b->impl.get(), m->impl.get(), c->impl.get());
+		impl->exptmod(b->impl.get(), m->impl.get(), c->impl.get(), constant_time);
 	}
 
 	bool BigInt::fermat(uint32_t w) const
@@ -47,7 +47,10 @@
 
 #include "Core/precomp.h"
 #include "big_int_impl.h"
+#include "big_int_limbs.h"
+#include "big_int_montgomery.h"
 #include "API/Core/Math/big_int.h"
+#include <algorithm>
 #include <cstdlib>
 
 namespace clan
@@ -1314,6 +1317,21 @@ namespace clan
 	void BigInt_Impl::internal_mul(const BigInt_Impl *b)
 	{
 		// Compute a = |a| * |b|
+		if (digits_used >= limb_mul_threshold && b->digits_used >= limb_mul_threshold)
+		{
+			int na = (digits_used + 1) / 2;
+			int nb = (b->digits_used + 1) / 2;
+			std::vector<uint64_t> limbs(2 * (na + nb) + BigInt_Limbs::scratch_size(std::max(na, nb)));
+			uint64_t *la = limbs.data();
+			uint64_t *lb = la + na;
+			uint64_t *product = lb + nb;
+			internal_to_limbs(la, na);
+			b->internal_to_limbs(lb, nb);
+			BigInt_Limbs::mul(product, la, na, lb, nb, product + na + nb);
+			internal_from_limbs(product, na + nb);
+			return;
+		}
+
 		uint64_t   w, k = 0;
 		unsigned int   ix, jx, ua = digits_used, ub = b->digits_used;
 		uint32_t *pa;
@@ -1506,6 +1524,16 @@ namespace clan
 		// step is a bit more complicated, but we save a fair number of
 		// iterations of the multiplication loop.
 
+		if (digits_used >= limb_mul_threshold)
+		{
+			int n = (digits_used + 1) / 2;
+			std::vector<uint64_t> limbs(3 * n + BigInt_Limbs::scratch_size(n));
+			internal_to_limbs(limbs.data(), n);
+			BigInt_Limbs::sqr(limbs.data() + n, limbs.data(), n, limbs.data() + 3 * n);
+			internal_from_limbs(limbs.data() + n, 2 * n);
+			return;
+		}
+
 		uint64_t  w, k = 0;
 		unsigned int  ix, jx, kx, used = digits_used;
 		uint32_t *pa1, *pa2, *pt, *pbt;
@@ -1599,7 +1627,7 @@ namespace clan
 		tmp_impl.internal_exch(this);
 	}
 
-	void BigInt_Impl::exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const
+	void BigInt_Impl::exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c, bool constant_time) const
 	{
 		BigInt_Impl s, mu;
 		uint32_t d;
@@ -1611,6 +1639,16 @@ namespace clan
 		if (b->cmp_z() < 0 || m->cmp_z() <= 0)
 			throw Exception("Divide by zero");
 
+		// Odd moduli (all RSA moduli and primes) use Montgomery multiplication. Barrett reduction below handles the rest
+		if (m->isodd())
+		{
+			internal_exptmod_montgomery(b, m, c, constant_time);
+			return;
+		}
+
+		if (constant_time)
+			throw Exception("Constant time exptmod requires an odd modulus");
+
 		BigInt_Impl x(*this);
 
 		x.mod(m, &x);
@@ -1662,6 +1700,73 @@ namespace clan
 		s.internal_exch(c);
 	}
 
+	void BigInt_Impl::internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c, bool constant_time) const
+	{
+		int num_limbs = (m->digits_used + 1) / 2;
+
+		// Only a negative base needs a division to bring it into range. The others are reduced
+		// by the Montgomery context, whose timing only depends on the number of limbs
+		BigInt_Impl x(*this);
+		if (x.digits_negative)
+			x.mod(m, &x);
+		int num_base_limbs = std::max((int)(x.digits_used + 1) / 2, 1);
+
+		std::vector<uint64_t> limbs(3 * num_limbs + num_base_limbs);
+		uint64_t *modulus = limbs.data();
+		uint64_t *base = modulus + num_limbs;
+		uint64_t *result = base + num_limbs;
+		uint64_t *wide_base = result + num_limbs;
+		m->internal_to_limbs(modulus, num_limbs);
+		x.internal_to_limbs(wide_base, num_base_limbs);
+
+		BigInt_Montgomery montgomery(modulus, num_limbs);
+		montgomery.mod(base, wide_base, num_base_limbs);
+
+		// In constant time mode all exponents below the modulus are processed as the same number of bits
+		int exponent_bits = b->significant_bits();
+		if (constant_time)
+			exponent_bits = std::max(exponent_bits, m->significant_bits());
+		std::vector<uint32_t> exponent((exponent_bits + num_bits_in_digit - 1) / num_bits_in_digit);
+		for (unsigned int i = 0; i < b->digits_used && i < exponent.size(); i++)
+			exponent[i] = b->digits[i];
+
+		montgomery.exptmod(result, base, exponent.data(), exponent_bits, constant_time);
+		c->internal_from_limbs(result, num_limbs);
+
+		// Do not leave copies of a private exponent or message behind
+		std::fill(exponent.begin(), exponent.end(), 0);
+		std::fill(limbs.begin(), limbs.end(), 0);
+	}
+
+	void BigInt_Impl::internal_to_limbs(uint64_t *limbs, int num_limbs) const
+	{
+		for (int i = 0; i < num_limbs; i++)
+		{
+			unsigned int digit = i * 2;
+			uint64_t low = digit < digits_used ? digits[digit] : 0;
+			uint64_t high = digit + 1 < digits_used ? digits[digit + 1] : 0;
+			limbs[i] = low | (high << num_bits_in_digit);
+		}
+	}
+
+	void BigInt_Impl::internal_from_limbs(const uint64_t *limbs, int num_limbs)
+	{
+		unsigned int old_used = digits_used;
+		internal_pad(num_limbs * 2);
+		for (int i = 0; i < num_limbs; i++)
+		{
+			digits[i * 2] = (uint32_t)limbs[i];
+			digits[i * 2 + 1] = (uint32_t)(limbs[i] >> num_bits_in_digit);
+		}
+
+		// Digits above the used ones must stay zero
+		for (unsigned int i = num_limbs * 2; i < old_used; i++)
+			digits[i] = 0;
+		digits_used = num_limbs * 2;
+		digits_negative = false;
+		internal_clamp();
+	}
+
 	bool BigInt_Impl::fermat(uint32_t w) const
 	{
 		BigInt_Impl  base, test;
@@ -1669,7 +1774,7 @@ namespace clan
 		base.set(w);
 
 		// Compute test = base^a (mod a)
-		base.exptmod(this, this, &test);
+		base.exptmod(this, this, &test, false);
 
 		if(base.cmp(&test) == 0)
 			return true;
@@ -1849,7 +1954,7 @@ namespace clan
 			}
 
 			// Compute z = (x ** m) mod a
-			x.exptmod(&m, this, &z);
+			x.exptmod(&m, this, &z, false);
 
 			if(z.cmp_d(1) == 0 || z.cmp(&amo) == 0)
 			{
@@ -81,7 +81,7 @@ namespace clan
 		void get(int32_t &d);
 		void get(uint64_t &d);
 		void get(int64_t &d);
-		void exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c) const;
+		void exptmod(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c, bool constant_time) const;
 		void mod(const BigInt_Impl *m, BigInt_Impl *c) const;
 		void div(const BigInt_Impl *b, BigInt_Impl *q, BigInt_Impl *r) const;
 		void add(const BigInt_Impl *b, BigInt_Impl *c) const;
@@ -116,6 +116,9 @@ namespace clan
 		static const uint32_t digit_half_radix = 1U << (8 * sizeof(uint32_t) - 1);
 		static const uint64_t word_maximim_value = ~0;
 
+		// Multiplications where both operands have at least this many digits are done on 64-bit limbs
+		static const unsigned int limb_mul_threshold = 16;
+
 		static const int prime_tab_size = 6542;
 		static std::vector<uint32_t> prime_tab;
 
@@ -168,6 +171,12 @@ namespace clan
 		void internal_reduce(const BigInt_Impl *m, BigInt_Impl *mu);
 		void internal_sqr();
 
+		// Conversion of |a| to and from 64-bit limbs, zero padded to num_limbs
+		void internal_to_limbs(uint64_t *limbs, int num_limbs) const;
+		void internal_from_limbs(const uint64_t *limbs, int num_limbs);
+
+		void internal_exptmod_montgomery(const BigInt_Impl *b, const BigInt_Impl *m, BigInt_Impl *c, bool constant_time) const;
+
 		bool digits_negative;	// True if the value is negative
 		unsigned int digits_alloc;		// How many digits allocated
 		unsigned int digits_used;		// How many digits used
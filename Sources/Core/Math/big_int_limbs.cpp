@@ -0,0 +1,224 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "big_int_limbs.h"
+#include <cstring>
+
+namespace clan
+{
+	uint64_t BigInt_Limbs::mul_add(uint64_t *r, const uint64_t *a, int n, uint64_t b)
+	{
+		uint64_t carry = 0;
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t lo;
+			uint64_t hi = mul_64x64(a[i], b, lo);
+			lo += carry;
+			hi += (lo < carry);
+			lo += r[i];
+			hi += (lo < r[i]);
+			r[i] = lo;
+			carry = hi;
+		}
+		return carry;
+	}
+
+	uint64_t BigInt_Limbs::add(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+	{
+		uint64_t carry = 0;
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t bi = b[i];
+			uint64_t sum = a[i] + carry;
+			carry = (sum < carry);
+			sum += bi;
+			carry += (sum < bi);
+			r[i] = sum;
+		}
+		return carry;
+	}
+
+	uint64_t BigInt_Limbs::sub(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+	{
+		uint64_t borrow = 0;
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t ai = a[i];
+			uint64_t bi = b[i];
+			uint64_t difference = ai - bi;
+			uint64_t borrow_out = (ai < bi);
+			r[i] = difference - borrow;
+			borrow = borrow_out | (difference < borrow);
+		}
+		return borrow;
+	}
+
+	int BigInt_Limbs::scratch_size(int n)
+	{
+		if (n < karatsuba_threshold)
+			return 0;
+		int k = n - n / 2 + 1;
+		return 4 * k + scratch_size(k);
+	}
+
+	void BigInt_Limbs::mul(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb, uint64_t *scratch)
+	{
+		if (na == nb)
+			karatsuba_mul(r, a, b, na, scratch);
+		else
+			mul_basecase(r, a, na, b, nb);
+	}
+
+	void BigInt_Limbs::sqr(uint64_t *r, const uint64_t *a, int n, uint64_t *scratch)
+	{
+		karatsuba_sqr(r, a, n, scratch);
+	}
+
+	void BigInt_Limbs::mul_basecase(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb)
+	{
+		memset(r, 0, na * sizeof(uint64_t));
+		for (int i = 0; i < nb; i++)
+			r[na + i] = mul_add(r + i, a, na, b[i]);
+	}
+
+	void BigInt_Limbs::sqr_basecase(uint64_t *r, const uint64_t *a, int n)
+	{
+		// Sum the products a[i] * a[j] for i < j once, double them and add the squares a[i] * a[i]
+		memset(r, 0, 2 * n * sizeof(uint64_t));
+		for (int i = 0; i < n - 1; i++)
+			r[i + n] = mul_add(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+
+		uint64_t top_bit = 0;
+		for (int i = 0; i < 2 * n; i++)
+		{
+			uint64_t value = r[i];
+			r[i] = (value << 1) | top_bit;
+			top_bit = value >> 63;
+		}
+
+		uint64_t carry = 0;
+		for (int i = 0; i < n; i++)
+		{
+			uint64_t lo;
+			uint64_t hi = mul_64x64(a[i], a[i], lo);
+
+			uint64_t sum = r[2 * i] + carry;
+			carry = (sum < carry);
+			sum += lo;
+			carry += (sum < lo);
+			r[2 * i] = sum;
+
+			sum = r[2 * i + 1] + carry;
+			carry = (sum < carry);
+			sum += hi;
+			carry += (sum < hi);
+			r[2 * i + 1] = sum;
+		}
+	}
+
+	void BigInt_Limbs::karatsuba_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, int n, uint64_t *scratch)
+	{
+		if (n < karatsuba_threshold)
+		{
+			mul_basecase(r, a, n, b, n);
+			return;
+		}
+
+		// a * b = z2 * B^2m + z1 * B^m + z0, where z1 = (a_lo + a_hi) * (b_lo + b_hi) - z0 - z2
+		int m = n / 2;
+		int h = n - m;
+		int k = h + 1;
+		uint64_t *sum_a = scratch;
+		uint64_t *sum_b = scratch + k;
+		uint64_t *z1 = scratch + 2 * k;
+		uint64_t *next_scratch = scratch + 4 * k;
+
+		karatsuba_mul(r, a, b, m, next_scratch);
+		karatsuba_mul(r + 2 * m, a + m, b + m, h, next_scratch);
+
+		sum_a[h] = add_padded(sum_a, a + m, h, a, m);
+		sum_b[h] = add_padded(sum_b, b + m, h, b, m);
+		karatsuba_mul(z1, sum_a, sum_b, k, next_scratch);
+
+		sub_padded(z1, z1, 2 * k, r, 2 * m);
+		sub_padded(z1, z1, 2 * k, r + 2 * m, 2 * h);
+		add_padded(r + m, r + m, 2 * n - m, z1, 2 * k);
+	}
+
+	void BigInt_Limbs::karatsuba_sqr(uint64_t *r, const uint64_t *a, int n, uint64_t *scratch)
+	{
+		if (n < karatsuba_threshold)
+		{
+			sqr_basecase(r, a, n);
+			return;
+		}
+
+		int m = n / 2;
+		int h = n - m;
+		int k = h + 1;
+		uint64_t *sum_a = scratch;
+		uint64_t *z1 = scratch + 2 * k;
+		uint64_t *next_scratch = scratch + 4 * k;
+
+		karatsuba_sqr(r, a, m, next_scratch);
+		karatsuba_sqr(r + 2 * m, a + m, h, next_scratch);
+
+		sum_a[h] = add_padded(sum_a, a + m, h, a, m);
+		karatsuba_sqr(z1, sum_a, k, next_scratch);
+
+		sub_padded(z1, z1, 2 * k, r, 2 * m);
+		sub_padded(z1, z1, 2 * k, r + 2 * m, 2 * h);
+		add_padded(r + m, r + m, 2 * n - m, z1, 2 * k);
+	}
+
+	uint64_t BigInt_Limbs::add_padded(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb)
+	{
+		// na >= nb. b is treated as zero above nb
+		uint64_t carry = add(r, a, b, nb);
+		for (int i = nb; i < na; i++)
+		{
+			uint64_t sum = a[i] + carry;
+			carry = (sum < carry);
+			r[i] = sum;
+		}
+		return carry;
+	}
+
+	uint64_t BigInt_Limbs::sub_padded(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb)
+	{
+		uint64_t borrow = sub(r, a, b, nb);
+		for (int i = nb; i < na; i++)
+		{
+			uint64_t ai = a[i];
+			r[i] = ai - borrow;
+			borrow = (ai < borrow);
+		}
+		return borrow;
+	}
+}
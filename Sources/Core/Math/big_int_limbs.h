@@ -0,0 +1,99 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace clan
+{
+	/// \brief Arithmetic on little endian arrays of 64-bit limbs
+	///
+	/// The loops only depend on the lengths of the operands, never on their values,
+	/// so they can be used for operations that must run in constant time.
+	class BigInt_Limbs
+	{
+	public:
+		/// \brief Operands with at least this many limbs are multiplied with Karatsuba's method
+		static const int karatsuba_threshold = 24;
+
+		/// \brief r[0..n) += a[0..n) * b, returns the carry limb
+		static uint64_t mul_add(uint64_t *r, const uint64_t *a, int n, uint64_t b);
+
+		/// \brief r[0..n) = a[0..n) + b[0..n), returns the carry
+		static uint64_t add(uint64_t *r, const uint64_t *a, const uint64_t *b, int n);
+
+		/// \brief r[0..n) = a[0..n) - b[0..n), returns the borrow
+		static uint64_t sub(uint64_t *r, const uint64_t *a, const uint64_t *b, int n);
+
+		/// \brief Returns the number of scratch limbs mul() and sqr() need for n limb operands
+		static int scratch_size(int n);
+
+		/// \brief r[0..na+nb) = a[0..na) * b[0..nb). scratch must hold scratch_size(max(na, nb)) limbs
+		static void mul(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb, uint64_t *scratch);
+
+		/// \brief r[0..2n) = a[0..n) squared. scratch must hold scratch_size(n) limbs
+		static void sqr(uint64_t *r, const uint64_t *a, int n, uint64_t *scratch);
+
+		/// \brief Returns the high 64 bits of a * b and stores the low 64 bits in lo
+		static inline uint64_t mul_64x64(uint64_t a, uint64_t b, uint64_t &lo)
+		{
+#if defined(__SIZEOF_INT128__)
+			unsigned __int128 product = (unsigned __int128)a * b;
+			lo = (uint64_t)product;
+			return (uint64_t)(product >> 64);
+#elif defined(_M_X64)
+			uint64_t hi;
+			lo = _umul128(a, b, &hi);
+			return hi;
+#else
+			uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+			uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+			uint64_t p0 = a_lo * b_lo;
+			uint64_t p1 = a_lo * b_hi;
+			uint64_t p2 = a_hi * b_lo;
+			uint64_t p3 = a_hi * b_hi;
+			uint64_t middle = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+			lo = (middle << 32) | (uint32_t)p0;
+			return p3 + (p1 >> 32) + (p2 >> 32) + (middle >> 32);
+#endif
+		}
+
+	private:
+		static void mul_basecase(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb);
+		static void sqr_basecase(uint64_t *r, const uint64_t *a, int n);
+		static void karatsuba_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, int n, uint64_t *scratch);
+		static void karatsuba_sqr(uint64_t *r, const uint64_t *a, int n, uint64_t *scratch);
+		static uint64_t add_padded(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb);
+		static uint64_t sub_padded(uint64_t *r, const uint64_t *a, int na, const uint64_t *b, int nb);
+	};
+}
@@ -0,0 +1,282 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "big_int_montgomery.h"
+#include "big_int_limbs.h"
+#include <algorithm>
+#include <cstring>
+
+namespace clan
+{
+	BigInt_Montgomery::BigInt_Montgomery(const uint64_t *modulus_limbs, int num_limbs)
+		: num_limbs(num_limbs), modulus(modulus_limbs, modulus_limbs + num_limbs), r2(num_limbs), product(2 * num_limbs), scratch(BigInt_Limbs::scratch_size(num_limbs))
+	{
+		// Newton's iteration doubles the number of correct low bits of the inverse each step.
+		// Any odd number is its own inverse modulo 8
+		uint64_t inverse = modulus[0];
+		for (int i = 0; i < 5; i++)
+			inverse *= 2 - modulus[0] * inverse;
+		n0_inverse = 0 - inverse;
+
+		calculate_r2();
+	}
+
+	void BigInt_Montgomery::calculate_r2()
+	{
+		// A division would depend on the modulus, which may be a secret prime, so instead double 1
+		// up to 2 * R mod m with a masked subtraction after each step. That is 2 in Montgomery form
+		std::vector<uint64_t> two(num_limbs);
+		std::vector<uint64_t> difference(num_limbs);
+		two[0] = 1;
+		for (int step = 0; step <= 64 * num_limbs; step++)
+		{
+			uint64_t carry = 0;
+			for (int i = 0; i < num_limbs; i++)
+			{
+				uint64_t limb = two[i];
+				two[i] = (limb << 1) | carry;
+				carry = limb >> 63;
+			}
+
+			uint64_t borrow = BigInt_Limbs::sub(difference.data(), two.data(), modulus.data(), num_limbs);
+			uint64_t keep_difference = 0 - (carry | (borrow ^ 1));
+			for (int i = 0; i < num_limbs; i++)
+				two[i] = (difference[i] & keep_difference) | (two[i] & ~keep_difference);
+		}
+
+		// 2^(64 * n) in Montgomery form is R * R mod m. The exponent only depends on the size
+		int exponent = 64 * num_limbs;
+		int top_bit = 0;
+		while ((exponent >> (top_bit + 1)) != 0)
+			top_bit++;
+		r2 = two;
+		for (int bit = top_bit - 1; bit >= 0; bit--)
+		{
+			sqr(r2.data(), r2.data());
+			if ((exponent >> bit) & 1)
+				mul(r2.data(), r2.data(), two.data());
+		}
+	}
+
+	void BigInt_Montgomery::mul(uint64_t *r, const uint64_t *a, const uint64_t *b)
+	{
+		BigInt_Limbs::mul(product.data(), a, num_limbs, b, num_limbs, scratch.data());
+		reduce(r);
+	}
+
+	void BigInt_Montgomery::sqr(uint64_t *r, const uint64_t *a)
+	{
+		BigInt_Limbs::sqr(product.data(), a, num_limbs, scratch.data());
+		reduce(r);
+	}
+
+	void BigInt_Montgomery::to_montgomery(uint64_t *r, const uint64_t *a)
+	{
+		mul(r, a, r2.data());
+	}
+
+	void BigInt_Montgomery::from_montgomery(uint64_t *r, const uint64_t *a)
+	{
+		memcpy(product.data(), a, num_limbs * sizeof(uint64_t));
+		memset(product.data() + num_limbs, 0, num_limbs * sizeof(uint64_t));
+		reduce(r);
+	}
+
+	void BigInt_Montgomery::mod(uint64_t *r, const uint64_t *a, int num_a_limbs)
+	{
+		// Horner's method on n limb chunks, starting with the most significant one.
+		// acc * R + chunk is below m * R, so one reduction gives (acc * R + chunk) / R mod m,
+		// and multiplying by R^2 brings it back to (acc * R + chunk) mod m
+		std::vector<uint64_t> acc(num_limbs);
+		int num_chunks = (num_a_limbs + num_limbs - 1) / num_limbs;
+		for (int chunk = num_chunks - 1; chunk >= 0; chunk--)
+		{
+			for (int i = 0; i < num_limbs; i++)
+			{
+				int index = chunk * num_limbs + i;
+				product[i] = index < num_a_limbs ? a[index] : 0;
+			}
+			memcpy(product.data() + num_limbs, acc.data(), num_limbs * sizeof(uint64_t));
+			reduce(acc.data());
+			mul(acc.data(), acc.data(), r2.data());
+		}
+		memcpy(r, acc.data(), num_limbs * sizeof(uint64_t));
+	}
+
+	void BigInt_Montgomery::reduce(uint64_t *r)
+	{
+		// Montgomery reduction (REDC) of the 2n limb product: add multiples of the modulus that
+		// clear the low limbs one at a time, then the high half is product / R mod m (or that plus m)
+		uint64_t *t = product.data();
+		uint64_t top = 0;
+		for (int i = 0; i < num_limbs; i++)
+		{
+			uint64_t carry = BigInt_Limbs::mul_add(t + i, modulus.data(), num_limbs, t[i] * n0_inverse);
+			uint64_t sum = t[i + num_limbs] + carry;
+			uint64_t carry_out = (sum < carry);
+			sum += top;
+			carry_out += (sum < top);
+			t[i + num_limbs] = sum;
+			top = carry_out;
+		}
+
+		// Subtract the modulus if the result is too large, selecting with a mask rather than a branch
+		uint64_t borrow = BigInt_Limbs::sub(r, t + num_limbs, modulus.data(), num_limbs);
+		uint64_t keep_difference = 0 - (top | (borrow ^ 1));
+		for (int i = 0; i < num_limbs; i++)
+			r[i] = (r[i] & keep_difference) | (t[i + num_limbs] & ~keep_difference);
+	}
+
+	void BigInt_Montgomery::exptmod(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits, bool constant_time)
+	{
+		if (constant_time)
+			exptmod_fixed_window(r, base, exponent, exponent_bits);
+		else
+			exptmod_sliding_window(r, base, exponent, exponent_bits);
+	}
+
+	void BigInt_Montgomery::exptmod_sliding_window(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits)
+	{
+		// Window sizes as used by OpenSSL (BN_window_bits_for_exponent_size)
+		int window_bits = exponent_bits > 671 ? 6 : exponent_bits > 239 ? 5 : exponent_bits > 79 ? 4 : exponent_bits > 23 ? 3 : 1;
+		int n = num_limbs;
+
+		// Odd powers base^1, base^3, ..., base^(2^window_bits - 1)
+		int table_size = 1 << (window_bits - 1);
+		std::vector<uint64_t> table(table_size * n);
+		std::vector<uint64_t> base_squared(n);
+		to_montgomery(table.data(), base);
+		sqr(base_squared.data(), table.data());
+		for (int i = 1; i < table_size; i++)
+			mul(table.data() + i * n, table.data() + (i - 1) * n, base_squared.data());
+
+		std::vector<uint64_t> result(n);
+		bool started = false;
+		int bit = exponent_bits - 1;
+		while (bit >= 0)
+		{
+			if (!get_bit(exponent, bit))
+			{
+				if (started)
+					sqr(result.data(), result.data());
+				bit--;
+				continue;
+			}
+
+			// Longest window of at most window_bits bits that starts and ends with a one
+			int window_end = std::max(bit - window_bits + 1, 0);
+			while (!get_bit(exponent, window_end))
+				window_end++;
+
+			int value = 0;
+			for (int i = bit; i >= window_end; i--)
+			{
+				value = (value << 1) | get_bit(exponent, i);
+				if (started)
+					sqr(result.data(), result.data());
+			}
+
+			if (started)
+			{
+				mul(result.data(), result.data(), table.data() + (value >> 1) * n);
+			}
+			else
+			{
+				memcpy(result.data(), table.data() + (value >> 1) * n, n * sizeof(uint64_t));
+				started = true;
+			}
+			bit = window_end - 1;
+		}
+
+		if (started)
+		{
+			from_montgomery(r, result.data());
+		}
+		else
+		{
+			// base^0 = 1, reduced in case the modulus is 1
+			std::vector<uint64_t> one(n);
+			one[0] = 1;
+			to_montgomery(result.data(), one.data());
+			from_montgomery(r, result.data());
+		}
+	}
+
+	void BigInt_Montgomery::exptmod_fixed_window(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits)
+	{
+		int window_bits = exponent_bits > 512 ? 5 : 4;
+		int n = num_limbs;
+
+		// All powers base^0 ... base^(2^window_bits - 1)
+		int table_size = 1 << window_bits;
+		std::vector<uint64_t> table(table_size * n);
+		std::vector<uint64_t> one(n);
+		one[0] = 1;
+		to_montgomery(table.data(), one.data());
+		to_montgomery(table.data() + n, base);
+		for (int i = 2; i < table_size; i++)
+			mul(table.data() + i * n, table.data() + (i - 1) * n, table.data() + n);
+
+		std::vector<uint64_t> result(n);
+		std::vector<uint64_t> selected(n);
+		int num_windows = (exponent_bits + window_bits - 1) / window_bits;
+		for (int window = num_windows - 1; window >= 0; window--)
+		{
+			uint64_t value = 0;
+			for (int i = window_bits - 1; i >= 0; i--)
+			{
+				int bit = window * window_bits + i;
+				value = (value << 1) | (bit < exponent_bits ? get_bit(exponent, bit) : 0);
+			}
+
+			// Read every table entry, keeping the wanted one with a mask, so the memory access pattern does not depend on the exponent
+			memset(selected.data(), 0, n * sizeof(uint64_t));
+			for (int entry = 0; entry < table_size; entry++)
+			{
+				uint64_t difference = (uint64_t)entry ^ value;
+				uint64_t mask = ((difference | (0 - difference)) >> 63) - 1;
+				for (int i = 0; i < n; i++)
+					selected[i] |= table[entry * n + i] & mask;
+			}
+
+			if (window == num_windows - 1)
+			{
+				result = selected;
+			}
+			else
+			{
+				for (int i = 0; i < window_bits; i++)
+					sqr(result.data(), result.data());
+				mul(result.data(), result.data(), selected.data());
+			}
+		}
+
+		from_montgomery(r, result.data());
+	}
+}
@@ -0,0 +1,85 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/cl_platform.h"
+#include <vector>
+
+namespace clan
+{
+	/// \brief Montgomery arithmetic modulo an odd number, on 64-bit limbs
+	///
+	/// Values are n limbs long and reduced modulo the modulus. In Montgomery form a value x is
+	/// stored as x * R mod m, where R = 2^(64 * n), which turns the reductions into shifts.
+	class BigInt_Montgomery
+	{
+	public:
+		/// \brief Prepares the context, calculating R^2 mod modulus in constant time
+		BigInt_Montgomery(const uint64_t *modulus, int num_limbs);
+
+		int get_num_limbs() const { return num_limbs; }
+
+		/// \brief r = a * b / R mod m. r may be the same as a or b
+		void mul(uint64_t *r, const uint64_t *a, const uint64_t *b);
+
+		/// \brief r = a * a / R mod m. r may be the same as a
+		void sqr(uint64_t *r, const uint64_t *a);
+
+		void to_montgomery(uint64_t *r, const uint64_t *a);
+		void from_montgomery(uint64_t *r, const uint64_t *a);
+
+		/// \brief r = a mod m, for an a of num_a_limbs limbs. Only the lengths affect the timing
+		void mod(uint64_t *r, const uint64_t *a, int num_a_limbs);
+
+		/// \brief r = base^exponent mod m, with base and r in normal form
+		///
+		/// exponent holds exponent_bits bits in 32-bit little endian digits.
+		/// With constant_time the sequence of operations and memory accesses only depends on exponent_bits,
+		/// not on the bits themselves. Otherwise a faster sliding window is used.
+		void exptmod(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits, bool constant_time);
+
+	private:
+		void reduce(uint64_t *r);
+		void calculate_r2();
+		void exptmod_sliding_window(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits);
+		void exptmod_fixed_window(uint64_t *r, const uint64_t *base, const uint32_t *exponent, int exponent_bits);
+
+		static int get_bit(const uint32_t *exponent, int bit)
+		{
+			return (exponent[bit / 32] >> (bit % 32)) & 1;
+		}
+
+		int num_limbs;
+		uint64_t n0_inverse;	// -modulus^-1 mod 2^64
+		std::vector<uint64_t> modulus;
+		std::vector<uint64_t> r2;
+		std::vector<uint64_t> product;
+		std::vector<uint64_t> scratch;
+	};
+}
@@ -115,7 +115,6 @@ namespace clan
 				return outside;
 			else if (result == intersecting)
 				is_intersecting = true;
-			break;
 		}
 		if (is_intersecting)
 			return intersecting;
@@ -36,8 +36,8 @@ namespace clan
 	{
 	}
 
-	RectPacker::RectPacker(const Size &max_group_size, AllocationPolicy policy)
-		: impl(std::make_shared<RectPacker_Impl>(max_group_size))
+	RectPacker::RectPacker(const Size &max_group_size, AllocationPolicy policy, PackingAlgorithm algorithm)
+		: impl(std::make_shared<RectPacker_Impl>(max_group_size, algorithm))
 	{
 		set_allocation_policy(policy);
 	}
@@ -57,6 +57,11 @@ namespace clan
 		return impl->allocation_policy;
 	}
 
+	RectPacker::PackingAlgorithm RectPacker::get_packing_algorithm() const
+	{
+		return impl->packing_algorithm;
+	}
+
 	Size RectPacker::get_max_group_size() const
 	{
 		return impl->max_group_size;
@@ -74,7 +79,17 @@ namespace clan
 
 	int RectPacker::get_group_count() const
 	{
-		return impl->root_nodes.size();
+		return impl->groups.size();
+	}
+
+	int RectPacker::get_used_area(unsigned int group_index) const
+	{
+		return impl->get_used_area(group_index);
+	}
+
+	float RectPacker::get_packing_efficiency() const
+	{
+		return impl->get_packing_efficiency();
 	}
 
 	void RectPacker::set_allocation_policy(AllocationPolicy policy)
@@ -86,4 +101,20 @@ namespace clan
 	{
 		return impl->add_new_node(size);
 	}
+
+	bool RectPacker::try_add(const Size &size, AllocatedRect &out_rect)
+	{
+		std::string error;
+		return impl->try_add_new_node(size, out_rect, error);
+	}
+
+	void RectPacker::remove(const AllocatedRect &rect)
+	{
+		impl->remove(rect);
+	}
+
+	std::vector<RectPacker::Relocation> RectPacker::defragment()
+	{
+		return impl->defragment();
+	}
 }
@@ -0,0 +1,490 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#include "Core/precomp.h"
+#include "API/Core/Math/rect.h"
+#include "rect_packer_bin.h"
+#include <algorithm>
+#include <climits>
+
+namespace clan
+{
+	RectPackerBin::RectPackerBin(const Size &bin_size)
+		: bin_size(bin_size), used_area(0)
+	{
+	}
+
+	RectPackerBin::~RectPackerBin()
+	{
+	}
+
+	std::unique_ptr<RectPackerBin> RectPackerBin::create(RectPacker::PackingAlgorithm algorithm, const Size &bin_size)
+	{
+		switch (algorithm)
+		{
+		case RectPacker::max_rects:
+			return std::unique_ptr<RectPackerBin>(new RectPackerMaxRectsBin(bin_size));
+		case RectPacker::skyline:
+			return std::unique_ptr<RectPackerBin>(new RectPackerSkylineBin(bin_size));
+		case RectPacker::guillotine:
+		default:
+			return std::unique_ptr<RectPackerBin>(new RectPackerGuillotineBin(bin_size));
+		}
+	}
+
+	bool RectPackerBin::insert(const Size &rect_size, Rect &out_rect)
+	{
+		if (rect_size.width < 0 || rect_size.height < 0 || rect_size.width > bin_size.width || rect_size.height > bin_size.height)
+			return false;
+
+		if (!place(rect_size, out_rect))
+			return false;
+
+		rects.push_back(out_rect);
+		used_area += rect_size.width * rect_size.height;
+		return true;
+	}
+
+	bool RectPackerBin::remove(const Rect &rect)
+	{
+		auto it = std::find(rects.begin(), rects.end(), rect);
+		if (it == rects.end())
+			return false;
+
+		*it = rects.back();
+		rects.pop_back();
+		used_area -= rect.get_width() * rect.get_height();
+
+		release(rect);
+		return true;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// RectPackerGuillotineBin:
+
+	RectPackerGuillotineBin::RectPackerGuillotineBin(const Size &bin_size)
+		: RectPackerBin(bin_size), root(Rect(Point(0, 0), bin_size))
+	{
+	}
+
+	bool RectPackerGuillotineBin::place(const Size &rect_size, Rect &out_rect)
+	{
+		Node *node = root.insert(rect_size);
+		if (node == nullptr)
+			return false;
+		out_rect = node->node_rect;
+		return true;
+	}
+
+	void RectPackerGuillotineBin::release(const Rect &rect)
+	{
+		root.remove(rect);
+	}
+
+	RectPackerGuillotineBin::Node::Node()
+		: used(false)
+	{
+		child[0] = nullptr;
+		child[1] = nullptr;
+	}
+
+	RectPackerGuillotineBin::Node::Node(const Rect &new_rect)
+		: node_rect(new_rect), used(false)
+	{
+		child[0] = nullptr;
+		child[1] = nullptr;
+	}
+
+	RectPackerGuillotineBin::Node::~Node()
+	{
+		clear();
+	}
+
+	void RectPackerGuillotineBin::Node::clear()
+	{
+		delete child[0];
+		delete child[1];
+		child[0] = nullptr;
+		child[1] = nullptr;
+		used = false;
+	}
+
+	RectPackerGuillotineBin::Node *RectPackerGuillotineBin::Node::insert(const Size &rect_size)
+	{
+		// If we're not a leaf
+		if (child[0] && child[1])
+		{
+			// Try inserting into first child
+			Node *new_node = child[0]->insert(rect_size);
+			if (new_node != nullptr)
+				return new_node;
+
+			// No room, insert into second
+			return child[1]->insert(rect_size);
+		}
+		else
+		{
+			// If there's already a rect here, return
+			if (used)
+				return nullptr;
+
+			// If we're too small, return
+			if (rect_size.width > node_rect.get_width() || rect_size.height > node_rect.get_height())
+				return nullptr;
+
+			// If we're just right, accept
+			if (rect_size.width == node_rect.get_width() && rect_size.height == node_rect.get_height())
+			{
+				used = true;
+				return this;
+			}
+
+			// Otherwise, decide which way to split
+			int dw = node_rect.get_width() - rect_size.width;
+			int dh = node_rect.get_height() - rect_size.height;
+
+			if (dw > dh)
+			{
+				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.left + rect_size.width, node_rect.bottom));
+				child[1] = new Node(Rect(node_rect.left + rect_size.width, node_rect.top, node_rect.right, node_rect.bottom));
+			}
+			else
+			{
+				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.right, node_rect.top + rect_size.height));
+				child[1] = new Node(Rect(node_rect.left, node_rect.top + rect_size.height, node_rect.right, node_rect.bottom));
+			}
+
+			// Insert into first child we created
+			return child[0]->insert(rect_size);
+		}
+	}
+
+	bool RectPackerGuillotineBin::Node::remove(const Rect &rect)
+	{
+		if (!node_rect.is_inside(rect))
+			return false;
+
+		if (child[0])
+		{
+			if (!child[0]->remove(rect) && !child[1]->remove(rect))
+				return false;
+
+			// Merge the cut back once both halves are free again
+			if (child[0]->is_free_leaf() && child[1]->is_free_leaf())
+				clear();
+			return true;
+		}
+
+		if (used && node_rect == rect)
+		{
+			used = false;
+			return true;
+		}
+		return false;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// RectPackerMaxRectsBin:
+
+	RectPackerMaxRectsBin::RectPackerMaxRectsBin(const Size &bin_size)
+		: RectPackerBin(bin_size)
+	{
+		free_rects.push_back(Rect(Point(0, 0), bin_size));
+	}
+
+	bool RectPackerMaxRectsBin::place(const Size &rect_size, Rect &out_rect)
+	{
+		int best_short_side = INT_MAX;
+		int best_long_side = INT_MAX;
+		size_t best_index = free_rects.size();
+
+		for (size_t i = 0; i < free_rects.size(); i++)
+		{
+			const Rect &free_rect = free_rects[i];
+			int leftover_x = free_rect.get_width() - rect_size.width;
+			int leftover_y = free_rect.get_height() - rect_size.height;
+			if (leftover_x < 0 || leftover_y < 0)
+				continue;
+
+			int short_side = std::min(leftover_x, leftover_y);
+			int long_side = std::max(leftover_x, leftover_y);
+			if (short_side < best_short_side || (short_side == best_short_side && long_side < best_long_side))
+			{
+				best_short_side = short_side;
+				best_long_side = long_side;
+				best_index = i;
+			}
+		}
+
+		if (best_index == free_rects.size())
+			return false;
+
+		out_rect = Rect(free_rects[best_index].get_top_left(), rect_size);
+		if (rect_size.width > 0 && rect_size.height > 0)
+		{
+			split_free_rects(out_rect);
+			prune_free_rects();
+		}
+		return true;
+	}
+
+	void RectPackerMaxRectsBin::release(const Rect &rect)
+	{
+		if (get_rect_count() == 0)
+		{
+			free_rects.clear();
+			free_rects.push_back(Rect(Point(0, 0), bin_size));
+			return;
+		}
+
+		if (rect.get_width() > 0 && rect.get_height() > 0)
+		{
+			free_rects.push_back(rect);
+			merge_free_rects();
+			prune_free_rects();
+		}
+	}
+
+	void RectPackerMaxRectsBin::split_free_rects(const Rect &used_rect)
+	{
+		size_t count = free_rects.size();
+		for (size_t i = 0; i < count; )
+		{
+			Rect free_rect = free_rects[i];
+			if (!free_rect.is_overlapped(used_rect))
+			{
+				i++;
+				continue;
+			}
+
+			// Replace the free rect with the (up to four) maximal rects around the used area
+			free_rects[i] = free_rects[count - 1];
+			free_rects[count - 1] = free_rects.back();
+			free_rects.pop_back();
+			count--;
+
+			if (used_rect.left > free_rect.left)
+				free_rects.push_back(Rect(free_rect.left, free_rect.top, used_rect.left, free_rect.bottom));
+			if (used_rect.right < free_rect.right)
+				free_rects.push_back(Rect(used_rect.right, free_rect.top, free_rect.right, free_rect.bottom));
+			if (used_rect.top > free_rect.top)
+				free_rects.push_back(Rect(free_rect.left, free_rect.top, free_rect.right, used_rect.top));
+			if (used_rect.bottom < free_rect.bottom)
+				free_rects.push_back(Rect(free_rect.left, used_rect.bottom, free_rect.right, free_rect.bottom));
+		}
+	}
+
+	void RectPackerMaxRectsBin::merge_free_rects()
+	{
+		// Join free rects that share a full edge until no more joins are possible
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			for (size_t i = 0; i < free_rects.size() && !merged; i++)
+			{
+				for (size_t j = i + 1; j < free_rects.size(); j++)
+				{
+					Rect &a = free_rects[i];
+					const Rect &b = free_rects[j];
+					bool joined = false;
+					if (a.top == b.top && a.bottom == b.bottom && (a.right == b.left || b.right == a.left))
+					{
+						a = Rect(std::min(a.left, b.left), a.top, std::max(a.right, b.right), a.bottom);
+						joined = true;
+					}
+					else if (a.left == b.left && a.right == b.right && (a.bottom == b.top || b.bottom == a.top))
+					{
+						a = Rect(a.left, std::min(a.top, b.top), a.right, std::max(a.bottom, b.bottom));
+						joined = true;
+					}
+
+					if (joined)
+					{
+						free_rects[j] = free_rects.back();
+						free_rects.pop_back();
+						merged = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	void RectPackerMaxRectsBin::prune_free_rects()
+	{
+		for (size_t i = 0; i < free_rects.size(); i++)
+		{
+			for (size_t j = i + 1; j < free_rects.size(); )
+			{
+				if (free_rects[j].is_inside(free_rects[i]))
+				{
+					free_rects.erase(free_rects.begin() + i);
+					i--;
+					break;
+				}
+				if (free_rects[i].is_inside(free_rects[j]))
+					free_rects.erase(free_rects.begin() + j);
+				else
+					j++;
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// RectPackerSkylineBin:
+
+	RectPackerSkylineBin::RectPackerSkylineBin(const Size &bin_size)
+		: RectPackerBin(bin_size)
+	{
+		skyline.push_back(Segment(0, 0, bin_size.width));
+	}
+
+	bool RectPackerSkylineBin::fit(size_t index, const Size &rect_size, int &out_y) const
+	{
+		int x = skyline[index].x;
+		if (x + rect_size.width > bin_size.width)
+			return false;
+
+		int y = skyline[index].y;
+		int width_left = rect_size.width;
+		while (width_left > 0)
+		{
+			y = std::max(y, skyline[index].y);
+			if (y + rect_size.height > bin_size.height)
+				return false;
+			width_left -= skyline[index].width;
+			index++;
+		}
+		out_y = y;
+		return true;
+	}
+
+	bool RectPackerSkylineBin::place(const Size &rect_size, Rect &out_rect)
+	{
+		int best_bottom = INT_MAX;
+		int best_width = INT_MAX;
+		size_t best_index = skyline.size();
+		int best_y = 0;
+
+		for (size_t i = 0; i < skyline.size(); i++)
+		{
+			int y;
+			if (fit(i, rect_size, y))
+			{
+				int bottom = y + rect_size.height;
+				if (bottom < best_bottom || (bottom == best_bottom && skyline[i].width < best_width))
+				{
+					best_bottom = bottom;
+					best_width = skyline[i].width;
+					best_index = i;
+					best_y = y;
+				}
+			}
+		}
+
+		if (best_index == skyline.size())
+			return false;
+
+		out_rect = Rect(Point(skyline[best_index].x, best_y), rect_size);
+		if (rect_size.width == 0)
+			return true;
+
+		// Raise the skyline over the placed rect and trim the segments it now covers
+		skyline.insert(skyline.begin() + best_index, Segment(out_rect.left, out_rect.bottom, rect_size.width));
+		for (size_t i = best_index + 1; i < skyline.size(); )
+		{
+			Segment &segment = skyline[i];
+			int overlap = out_rect.right - segment.x;
+			if (overlap <= 0)
+				break;
+
+			if (overlap >= segment.width)
+			{
+				skyline.erase(skyline.begin() + i);
+			}
+			else
+			{
+				segment.x += overlap;
+				segment.width -= overlap;
+				break;
+			}
+		}
+		merge_segments();
+		return true;
+	}
+
+	void RectPackerSkylineBin::release(const Rect &rect)
+	{
+		if (get_rect_count() == 0)
+		{
+			skyline.clear();
+			skyline.push_back(Segment(0, 0, bin_size.width));
+			return;
+		}
+
+		// Lower the parts of the skyline that sit directly on top of the released rect
+		std::vector<Segment> new_skyline;
+		new_skyline.reserve(skyline.size() + 2);
+		for (const Segment &segment : skyline)
+		{
+			int left = std::max(segment.x, rect.left);
+			int right = std::min(segment.x + segment.width, rect.right);
+			if (left >= right || segment.y != rect.bottom)
+			{
+				new_skyline.push_back(segment);
+				continue;
+			}
+
+			if (segment.x < left)
+				new_skyline.push_back(Segment(segment.x, segment.y, left - segment.x));
+			new_skyline.push_back(Segment(left, rect.top, right - left));
+			if (right < segment.x + segment.width)
+				new_skyline.push_back(Segment(right, segment.y, segment.x + segment.width - right));
+		}
+		skyline.swap(new_skyline);
+		merge_segments();
+	}
+
+	void RectPackerSkylineBin::merge_segments()
+	{
+		for (size_t i = 0; i + 1 < skyline.size(); )
+		{
+			if (skyline[i].y == skyline[i + 1].y)
+			{
+				skyline[i].width += skyline[i + 1].width;
+				skyline.erase(skyline.begin() + i + 1);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+}
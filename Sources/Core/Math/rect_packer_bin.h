@@ -0,0 +1,141 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+
+#pragma once
+
+#include "API/Core/Math/rect_packer.h"
+
+namespace clan
+{
+	/// \brief Space allocator for a single rect packer group.
+	class RectPackerBin
+	{
+	public:
+		RectPackerBin(const Size &bin_size);
+		virtual ~RectPackerBin();
+
+		static std::unique_ptr<RectPackerBin> create(RectPacker::PackingAlgorithm algorithm, const Size &bin_size);
+
+		/// \brief Finds space for a rect. Returns false if it does not fit.
+		bool insert(const Size &rect_size, Rect &out_rect);
+
+		/// \brief Releases a rect allocated by insert. Returns false if the rect is not allocated in this bin.
+		bool remove(const Rect &rect);
+
+		Size get_size() const { return bin_size; }
+		int get_rect_count() const { return (int)rects.size(); }
+		int get_used_area() const { return used_area; }
+		const std::vector<Rect> &get_rects() const { return rects; }
+
+	protected:
+		virtual bool place(const Size &rect_size, Rect &out_rect) = 0;
+		virtual void release(const Rect &rect) = 0;
+
+		Size bin_size;
+
+	private:
+		std::vector<Rect> rects;
+		int used_area;
+	};
+
+	/// \brief Binary tree of guillotine cuts. Released nodes are merged back into their parent.
+	class RectPackerGuillotineBin : public RectPackerBin
+	{
+	public:
+		RectPackerGuillotineBin(const Size &bin_size);
+
+	protected:
+		bool place(const Size &rect_size, Rect &out_rect) override;
+		void release(const Rect &rect) override;
+
+	private:
+		class Node
+		{
+		public:
+			Node();
+			Node(const Rect &rect);
+			~Node();
+
+			Node *insert(const Size &rect_size);
+			bool remove(const Rect &rect);
+			bool is_free_leaf() const { return !child[0] && !used; }
+
+			void clear();
+
+			Node *child[2];
+			Rect node_rect;
+			bool used;
+		};
+
+		Node root;
+	};
+
+	/// \brief Maximal free rectangles packer using the best short side fit heuristic.
+	class RectPackerMaxRectsBin : public RectPackerBin
+	{
+	public:
+		RectPackerMaxRectsBin(const Size &bin_size);
+
+	protected:
+		bool place(const Size &rect_size, Rect &out_rect) override;
+		void release(const Rect &rect) override;
+
+	private:
+		void split_free_rects(const Rect &used_rect);
+		void merge_free_rects();
+		void prune_free_rects();
+
+		std::vector<Rect> free_rects;
+	};
+
+	/// \brief Bottom-left skyline packer.
+	///
+	/// Space below the skyline is only reclaimed when the released rect touches the skyline, or when the bin becomes empty.
+	class RectPackerSkylineBin : public RectPackerBin
+	{
+	public:
+		RectPackerSkylineBin(const Size &bin_size);
+
+	protected:
+		bool place(const Size &rect_size, Rect &out_rect) override;
+		void release(const Rect &rect) override;
+
+	private:
+		struct Segment
+		{
+			Segment(int x, int y, int width) : x(x), y(y), width(width) { }
+			int x, y, width;
+		};
+
+		bool fit(size_t index, const Size &rect_size, int &out_y) const;
+		void merge_segments();
+
+		std::vector<Segment> skyline;
+	};
+}
@@ -26,221 +26,181 @@
 **    Kenneth Gangstoe
 */
 
+
 #include "Core/precomp.h"
 #include "API/Core/Math/rect.h"
 #include "rect_packer_impl.h"
+#include <algorithm>
 
 namespace clan
 {
-	RectPacker_Impl::RectPacker_Impl(const Size &max_group_size)
-		: active_root_node(nullptr), next_node_id(0), max_group_size(max_group_size)
+	RectPacker_Impl::RectPacker_Impl(const Size &max_group_size, RectPacker::PackingAlgorithm algorithm)
+		: active_group(-1), allocation_policy(RectPacker::create_new_group), packing_algorithm(algorithm), max_group_size(max_group_size)
 	{
 	}
 
 	RectPacker_Impl::~RectPacker_Impl()
 	{
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
-		{
-			root_nodes[index]->node.clear();
-			delete root_nodes[index];
-		}
 	}
 
 	int RectPacker_Impl::get_total_rect_count() const
 	{
 		int count = 0;
-
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
-			count += root_nodes[index]->node.get_rect_count();
-
+		for (const auto &group : groups)
+			count += group->get_rect_count();
 		return count;
 	}
 
 	int RectPacker_Impl::get_rect_count(unsigned int group_index) const
 	{
-		int count = 0;
+		if (group_index < groups.size())
+			return groups[group_index]->get_rect_count();
+		return 0;
+	}
+
+	int RectPacker_Impl::get_used_area(unsigned int group_index) const
+	{
+		if (group_index < groups.size())
+			return groups[group_index]->get_used_area();
+		return 0;
+	}
 
-		if (group_index < root_nodes.size())
-			count = root_nodes[group_index]->node.get_rect_count();
+	float RectPacker_Impl::get_packing_efficiency() const
+	{
+		double used_area = 0.0;
+		for (const auto &group : groups)
+			used_area += group->get_used_area();
 
-		return count;
+		double total_area = (double)max_group_size.width * max_group_size.height * groups.size();
+		return total_area > 0.0 ? (float)(used_area / total_area) : 0.0f;
 	}
 
-	RectPacker::AllocatedRect RectPacker_Impl::add_new_node(const Size &rect_size)
+	bool RectPacker_Impl::try_add_new_node(const Size &rect_size, RectPacker::AllocatedRect &out_rect, std::string &out_error)
 	{
-		// Try inserting in current active group
-		Node *node;
-		if (!active_root_node)
+		if (rect_size.width > max_group_size.width || rect_size.height > max_group_size.height)
 		{
-			// Create an initial root, if it does not exist
-			node = nullptr;
-			next_node_id = 1;
+			out_error = "Unable to pack rect into group: Larger than max_group_size";
+			return false;
 		}
-		else
+
+		// Try inserting in current active group
+		Rect rect;
+		if (active_group >= 0 && groups[active_group]->insert(rect_size, rect))
 		{
-			node = active_root_node->node.insert(rect_size, next_node_id);
+			out_rect = RectPacker::AllocatedRect(active_group, rect);
+			return true;
 		}
 
-		if (node == nullptr) // Couldn't find a fit in current active group
+		if (allocation_policy == RectPacker::fail_if_full && !groups.empty())
 		{
-			if (allocation_policy == RectPacker::fail_if_full && root_nodes.size() > 0)
-			{
-				throw Exception("Unable to pack rect into group: full");
-			}
-
-			if (allocation_policy == RectPacker::search_previous_groups)
-			{
-				std::vector<RootNode *>::size_type index, size;
-				size = root_nodes.size();
-				for (index = 0; index < size; ++index)
-				{
-					node = root_nodes[index]->node.insert(rect_size, next_node_id);
-					if (node)	// We found space in a previous group
-						break;
-				}
-			}
+			out_error = "Unable to pack rect into group: full";
+			return false;
+		}
 
-			if (node == nullptr) // Couldn't find a fit, so create a new group
+		if (allocation_policy == RectPacker::search_previous_groups)
+		{
+			for (size_t index = 0; index < groups.size(); ++index)
 			{
-				if (rect_size.width <= max_group_size.width && rect_size.height <= max_group_size.height)
-				{
-					node = add_new_root()->node.insert(rect_size, next_node_id);
-				}
-				else
+				if ((int)index != active_group && groups[index]->insert(rect_size, rect))
 				{
-					throw Exception("Unable to pack rect into group: Larger than max_group_size");
+					// We found space in a previous group
+					out_rect = RectPacker::AllocatedRect((int)index, rect);
+					return true;
 				}
 			}
-
-			if (node == nullptr)
-				throw Exception("Unable to pack rect into group: Unknown reason");
 		}
 
-		next_node_id++;
-
-		return RectPacker::AllocatedRect(active_root_node->group_id, node->node_rect);
-	}
-
-	RectPacker_Impl::RootNode *RectPacker_Impl::add_new_root()
-	{
-		Node node(Rect(Point(0, 0), max_group_size));
-
-		active_root_node = new RootNode();
-		active_root_node->group_id = (int)root_nodes.size();
-		active_root_node->node = node;
-
-		root_nodes.push_back(active_root_node);
-
-		return active_root_node;
-	}
-
-	/////////////////////////////////////////////////////////////////////////////
-	// RectPacker_Impl::Node:
-
-	RectPacker_Impl::Node::Node()
-	{
-		child[0] = nullptr;
-		child[1] = nullptr;
+		// Couldn't find a fit, so create a new group
+		int group_index = add_new_group();
+		if (!groups[group_index]->insert(rect_size, rect))
+		{
+			out_error = "Unable to pack rect into group: Unknown reason";
+			return false;
+		}
 
-		id = 0;
+		out_rect = RectPacker::AllocatedRect(group_index, rect);
+		return true;
 	}
 
-	RectPacker_Impl::Node::Node(const Rect &new_rect)
+	RectPacker::AllocatedRect RectPacker_Impl::add_new_node(const Size &rect_size)
 	{
-		node_rect = new_rect;
-
-		child[0] = nullptr;
-		child[1] = nullptr;
-
-		id = 0;
+		RectPacker::AllocatedRect allocated_rect(0, Rect());
+		std::string error;
+		if (!try_add_new_node(rect_size, allocated_rect, error))
+			throw Exception(error);
+		return allocated_rect;
 	}
 
-	RectPacker_Impl::Node::~Node()
+	void RectPacker_Impl::remove(const RectPacker::AllocatedRect &rect)
 	{
-		clear();
+		if (rect.group_index < 0 || rect.group_index >= (int)groups.size() || !groups[rect.group_index]->remove(rect.rect))
+			throw Exception("Cannot find the rect in the RectPacker");
 	}
 
-	int RectPacker_Impl::Node::get_rect_count() const
+	std::vector<RectPacker::Relocation> RectPacker_Impl::defragment()
 	{
-		int count = 0;
-
-		if (child[0])
-			count += child[0]->get_rect_count();
-		if (child[1])
-			count += child[1]->get_rect_count();
-
-		if (id)
-			count++;
-
-		return count;
-	}
+		std::vector<RectPacker::Relocation> relocations;
+		if (groups.size() < 2)
+			return relocations;
 
-	void RectPacker_Impl::Node::clear()
-	{
-		if (child[0])
-		{
-			delete child[0];
-			child[0] = nullptr;
-		}
-		if (child[1])
+		int source_index = 0;
+		for (int index = 1; index < (int)groups.size(); index++)
 		{
-			delete child[1];
-			child[1] = nullptr;
+			if (groups[index]->get_used_area() < groups[source_index]->get_used_area())
+				source_index = index;
 		}
-		id = 0;
-	}
 
-	RectPacker_Impl::Node *RectPacker_Impl::Node::insert(const Size &rect_size, int rect_id)
-	{
-		// If we're not a leaf
-		if (child[0] && child[1])
+		// Rects in the groups after the source group only change group index
+		std::vector<RectPacker::Relocation> shifted;
+		for (int index = source_index + 1; index < (int)groups.size(); index++)
 		{
-			// Try inserting into first child
-			Node *new_node = child[0]->insert(rect_size, rect_id);
-			if (new_node != nullptr)
-				return new_node;
-
-			// No room, insert into second
-			return child[1]->insert(rect_size, rect_id);
+			for (const Rect &rect : groups[index]->get_rects())
+				shifted.push_back(RectPacker::Relocation(RectPacker::AllocatedRect(index, rect), RectPacker::AllocatedRect(index - 1, rect)));
 		}
-		else
-		{
-			// If there's already a rect here, return
-			if (id)
-				return nullptr;
 
-			// If we're too small, return
-			if (rect_size.width > node_rect.get_width() || rect_size.height > node_rect.get_height())
-				return nullptr;
+		// Place the largest rects first; they are the hardest to fit
+		std::vector<Rect> rects = groups[source_index]->get_rects();
+		std::sort(rects.begin(), rects.end(), [](const Rect &a, const Rect &b) { return a.get_width() * a.get_height() > b.get_width() * b.get_height(); });
 
-			// If we're just right, accept
-			if (rect_size.width == node_rect.get_width() && rect_size.height == node_rect.get_height())
+		for (const Rect &old_rect : rects)
+		{
+			Rect new_rect;
+			int target_index = -1;
+			for (int index = 0; index < (int)groups.size() && target_index == -1; index++)
 			{
-				id = rect_id;
-				return this;
+				if (index != source_index && groups[index]->insert(old_rect.get_size(), new_rect))
+					target_index = index;
 			}
 
-			// Otherwise, decide which way to split
-			int dw = node_rect.get_width() - rect_size.width;
-			int dh = node_rect.get_height() - rect_size.height;
-
-			if (dw > dh)
-			{
-				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.left + rect_size.width, node_rect.bottom));
-				child[1] = new Node(Rect(node_rect.left + rect_size.width, node_rect.top, node_rect.right, node_rect.bottom));
-			}
-			else
+			if (target_index == -1)
 			{
-				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.right, node_rect.top + rect_size.height));
-				child[1] = new Node(Rect(node_rect.left, node_rect.top + rect_size.height, node_rect.right, node_rect.bottom));
+				// The group cannot be emptied; undo the moves made so far
+				for (const auto &relocation : relocations)
+					groups[relocation.to.group_index]->remove(relocation.to.rect);
+				relocations.clear();
+				return relocations;
 			}
 
-			// Insert into first child we created
-			return child[0]->insert(rect_size, rect_id);
+			relocations.push_back(RectPacker::Relocation(RectPacker::AllocatedRect(source_index, old_rect), RectPacker::AllocatedRect(target_index, new_rect)));
 		}
+
+		groups.erase(groups.begin() + source_index);
+		active_group = (int)groups.size() - 1;
+
+		for (auto &relocation : relocations)
+		{
+			if (relocation.to.group_index > source_index)
+				relocation.to.group_index--;
+		}
+		relocations.insert(relocations.end(), shifted.begin(), shifted.end());
+
+		return relocations;
+	}
+
+	int RectPacker_Impl::add_new_group()
+	{
+		groups.push_back(RectPackerBin::create(packing_algorithm, max_group_size));
+		active_group = (int)groups.size() - 1;
+		return active_group;
 	}
 }
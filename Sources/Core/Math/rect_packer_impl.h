@@ -26,58 +26,39 @@
 **    Kenneth Gangstoe
 */
 
+
 #pragma once
 
 #include "API/Core/Math/rect_packer.h"
+#include "rect_packer_bin.h"
 
 namespace clan
 {
 	class RectPacker_Impl
 	{
 	public:
-		class Node
-		{
-		public:
-			Node();
-			Node(const Rect &rect);
-			~Node();
-
-			int get_rect_count() const;
-
-			Node *insert(const Size &rect_size, int rect_id);
-
-			void clear();
-
-			Node *child[2];
-			Rect node_rect;
-
-			int id;
-		};
-
-		struct RootNode
-		{
-		public:
-			int group_id;
-			Node node;
-		};
-
-	public:
-		RectPacker_Impl(const Size &max_group_size);
+		RectPacker_Impl(const Size &max_group_size, RectPacker::PackingAlgorithm algorithm);
 		~RectPacker_Impl();
 
 		int get_total_rect_count() const;
 		int get_rect_count(unsigned int group_index) const;
+		int get_used_area(unsigned int group_index) const;
+		float get_packing_efficiency() const;
 
+		bool try_add_new_node(const Size &rect_size, RectPacker::AllocatedRect &out_rect, std::string &out_error);
 		RectPacker::AllocatedRect add_new_node(const Size &rect_size);
-		RootNode *add_new_root();
+		void remove(const RectPacker::AllocatedRect &rect);
+		std::vector<RectPacker::Relocation> defragment();
 
-		std::vector<RootNode *> root_nodes;
-		RootNode *active_root_node;
-
-		int next_node_id;
+		std::vector<std::unique_ptr<RectPackerBin> > groups;
+		int active_group;
 
 		RectPacker::AllocationPolicy allocation_policy;
+		RectPacker::PackingAlgorithm packing_algorithm;
 
 		Size max_group_size;
+
+	private:
+		int add_new_group();
 	};
 }
@@ -54,6 +54,8 @@ namespace clan
 
 #define __cpuid(out, infoType)\
 	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
+#define __cpuidex(out, infoType, subInfoType)\
+	asm("cpuid": "=a" ((out)[0]), "=b" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subInfoType));
 #else
 
 #define __cpuid(out, infoType) \
@@ -63,10 +65,31 @@ namespace clan
 			"popl %%ebx" \
 		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType));
 
+#define __cpuidex(out, infoType, subInfoType) \
+	asm volatile(	"pushl %%ebx \n" \
+			"cpuid \n" \
+			"movl %%ebx, %1 \n" \
+			"popl %%ebx" \
+		: "=a" ((out)[0]), "=r" ((out)[1]), "=c" ((out)[2]), "=d" ((out)[3]): "a" (infoType), "c" (subInfoType));
+
 #endif
 
 #endif
 
+	namespace
+	{
+		unsigned int read_xcr0()
+		{
+#if defined(__GNUC__)
+			unsigned int eax, edx;
+			asm volatile("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+			return eax;
+#else
+			return (unsigned int)_xgetbv(0);
+#endif
+		}
+	}
+
 	bool System::detect_cpu_extension(CPU_ExtensionPPC ext)
 	{
 		throw ("Congratulations, you've just been selected to code this feature!");
@@ -167,6 +190,11 @@ namespace clan
 			__cpuid((int*)cpuinfo, 0x1);
 			return ((cpuinfo[2] & (1 << 25)) != 0);
 		}
+		else if (ext == pclmul)
+		{
+			__cpuid((int*)cpuinfo, 0x1);
+			return ((cpuinfo[2] & (1 << 1)) != 0);
+		}
 		else if (ext == fma3)
 		{
 			__cpuid((int*)cpuinfo, 0x1);
@@ -181,6 +209,29 @@ namespace clan
 			__cpuid((int*)cpuinfo, 0x80000001);
 			return ((cpuinfo[2] & (1 << 16)) != 0);
 		}
+		else if (ext == sha)
+		{
+			__cpuid((int*)cpuinfo, 0);
+			if (cpuinfo[0] < 7)
+				return false;
+
+			__cpuidex((int*)cpuinfo, 7, 0);
+			return ((cpuinfo[1] & (1 << 29)) != 0);
+		}
+		else if (ext == avx2)
+		{
+			__cpuid((int*)cpuinfo, 0);
+			if (cpuinfo[0] < 7)
+				return false;
+
+			// The operating system must also save the YMM registers on context switches (OSXSAVE and XCR0 bits 1 and 2)
+			__cpuid((int*)cpuinfo, 0x1);
+			if ((cpuinfo[2] & (1 << 27)) == 0 || (read_xcr0() & 6) != 6)
+				return false;
+
+			__cpuidex((int*)cpuinfo, 7, 0);
+			return ((cpuinfo[1] & (1 << 5)) != 0);
+		}
 		return false;
 	}
 
@@ -0,0 +1,295 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/task_group.h"
+#include "work_queue_impl.h"
+#include <exception>
+
+namespace clan
+{
+	class Task_Impl
+	{
+	public:
+		Task_Impl(const std::shared_ptr<TaskGroup_Impl> &group, const std::function<void()> &func) : group(group), func(func), dependencies_left(1) { }
+
+		std::shared_ptr<TaskGroup_Impl> group;
+		std::function<void()> func;
+
+		std::atomic_int dependencies_left;
+		std::mutex mutex;
+		bool finished = false;
+		std::vector<std::shared_ptr<Task_Impl>> continuations;
+	};
+
+	class TaskGroup_Impl : public std::enable_shared_from_this<TaskGroup_Impl>
+	{
+	public:
+		TaskGroup_Impl(WorkQueue &work_queue) : work_queue(work_queue.impl), tasks_pending(0), generation(0), waiting_threads(0) { }
+
+		Task run(const std::function<void()> &func, const std::vector<Task> &dependencies);
+		void wait();
+
+		void dependency_finished(const std::shared_ptr<Task_Impl> &task);
+		void task_finished(const std::shared_ptr<Task_Impl> &task);
+		void set_exception(std::exception_ptr exception);
+		void signal_waiters();
+
+		static int get_num_threads(WorkQueue &work_queue) { return work_queue.impl->get_num_threads(); }
+
+		std::shared_ptr<WorkQueue_Impl> work_queue;
+		std::atomic_int tasks_pending;
+		std::atomic_int generation;
+		std::atomic_int waiting_threads;
+		std::mutex mutex;
+		std::condition_variable event;
+		std::exception_ptr first_exception;
+	};
+
+	class TaskWorkItem : public WorkItem
+	{
+	public:
+		TaskWorkItem(const std::shared_ptr<Task_Impl> &task) : task(task) { }
+
+		void process_work() override
+		{
+			try
+			{
+				task->func();
+			}
+			catch (...)
+			{
+				task->group->set_exception(std::current_exception());
+			}
+			task->func = std::function<void()>();
+
+			std::shared_ptr<Task_Impl> finished_task;
+			finished_task.swap(task);
+			finished_task->group->task_finished(finished_task);
+		}
+
+	private:
+		std::shared_ptr<Task_Impl> task;
+	};
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	Task::Task()
+	{
+	}
+
+	Task::Task(const std::shared_ptr<Task_Impl> &impl) : impl(impl)
+	{
+	}
+
+	bool Task::is_finished() const
+	{
+		if (!impl)
+			return true;
+		std::unique_lock<std::mutex> lock(impl->mutex);
+		return impl->finished;
+	}
+
+	Task Task::then(const std::function<void()> &func) const
+	{
+		if (!impl)
+			throw Exception("Task is null");
+		return impl->group->run(func, { *this });
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	TaskGroup::TaskGroup(WorkQueue &work_queue) : impl(std::make_shared<TaskGroup_Impl>(work_queue))
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+	}
+
+	Task TaskGroup::run(const std::function<void()> &func)
+	{
+		return impl->run(func, std::vector<Task>());
+	}
+
+	Task TaskGroup::run(const std::function<void()> &func, const std::vector<Task> &dependencies)
+	{
+		return impl->run(func, dependencies);
+	}
+
+	int TaskGroup::get_tasks_pending() const
+	{
+		return impl->tasks_pending;
+	}
+
+	void TaskGroup::wait()
+	{
+		impl->wait();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	Task TaskGroup_Impl::run(const std::function<void()> &func, const std::vector<Task> &dependencies)
+	{
+		auto task = std::make_shared<Task_Impl>(shared_from_this(), func);
+		++tasks_pending;
+
+		// dependencies_left starts at one so the task can't be started before all edges are in place
+		for (const auto &dependency : dependencies)
+		{
+			if (dependency.is_null())
+				continue;
+
+			std::unique_lock<std::mutex> lock(dependency.impl->mutex);
+			if (!dependency.impl->finished)
+			{
+				++task->dependencies_left;
+				dependency.impl->continuations.push_back(task);
+			}
+		}
+
+		dependency_finished(task);
+		return Task(task);
+	}
+
+	void TaskGroup_Impl::dependency_finished(const std::shared_ptr<Task_Impl> &task)
+	{
+		if (--task->dependencies_left == 0)
+		{
+			work_queue->queue(new TaskWorkItem(task));
+			signal_waiters();
+		}
+	}
+
+	void TaskGroup_Impl::task_finished(const std::shared_ptr<Task_Impl> &task)
+	{
+		std::unique_lock<std::mutex> lock(task->mutex);
+		task->finished = true;
+		std::vector<std::shared_ptr<Task_Impl>> continuations;
+		continuations.swap(task->continuations);
+		lock.unlock();
+
+		for (auto &continuation : continuations)
+			continuation->group->dependency_finished(continuation);
+
+		--tasks_pending;
+		signal_waiters();
+	}
+
+	void TaskGroup_Impl::set_exception(std::exception_ptr exception)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!first_exception)
+			first_exception = exception;
+	}
+
+	void TaskGroup_Impl::signal_waiters()
+	{
+		++generation;
+		if (waiting_threads.load() > 0)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			lock.unlock();
+			event.notify_all();
+		}
+	}
+
+	void TaskGroup_Impl::wait()
+	{
+		while (tasks_pending.load() > 0)
+		{
+			int wait_generation = generation.load();
+			if (work_queue->process_queued_item())
+				continue;
+
+			// Nothing to help with. Sleep until a task finishes or new work is queued.
+			std::unique_lock<std::mutex> lock(mutex);
+			++waiting_threads;
+			event.wait(lock, [&]() { return tasks_pending.load() == 0 || generation.load() != wait_generation; });
+			--waiting_threads;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		std::exception_ptr exception = first_exception;
+		first_exception = std::exception_ptr();
+		lock.unlock();
+
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	void parallel_for(WorkQueue &work_queue, int begin, int end, int grain_size, const std::function<void(int range_begin, int range_end)> &func)
+	{
+		if (end <= begin)
+			return;
+
+		grain_size = std::max(grain_size, 1);
+		int num_chunks = (end - begin + grain_size - 1) / grain_size;
+		if (num_chunks == 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		// One task per thread pulling chunks from a shared counter balances uneven chunks without a task per chunk
+		std::atomic_int next_chunk(0);
+		auto process_chunks = [&]()
+		{
+			while (true)
+			{
+				int chunk = next_chunk++;
+				if (chunk >= num_chunks)
+					break;
+				int range_begin = begin + chunk * grain_size;
+				func(range_begin, std::min(range_begin + grain_size, end));
+			}
+		};
+
+		TaskGroup group(work_queue);
+		int num_tasks = std::min(TaskGroup_Impl::get_num_threads(work_queue), num_chunks - 1);
+		for (int i = 0; i < num_tasks; i++)
+			group.run(process_chunks);
+
+		std::exception_ptr exception;
+		try
+		{
+			process_chunks();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+			next_chunk = num_chunks;
+		}
+
+		group.wait();
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+}
@@ -1,214 +1,471 @@
-/*
-**  ClanLib SDK
-**  Copyright (c) 1997-2016 The ClanLib Team
-**
-**  This software is provided 'as-is', without any express or implied
-**  warranty.  In no event will the authors be held liable for any damages
-**  arising from the use of this software.
-**
-**  Permission is granted to anyone to use this software for any purpose,
-**  including commercial applications, and to alter it and redistribute it
-**  freely, subject to the following restrictions:
-**
-**  1. The origin of this software must not be misrepresented; you must not
-**     claim that you wrote the original software. If you use this software
-**     in a product, an acknowledgment in the product documentation would be
-**     appreciated but is not required.
-**  2. Altered source versions must be plainly marked as such, and must not be
-**     misrepresented as being the original software.
-**  3. This notice may not be removed or altered from any source distribution.
-**
-**  Note: Some of the libraries ClanLib may link to may have additional
-**  requirements or restrictions.
-**
-**  File Author(s):
-**
-**    Magnus Norddahl
-*/
-
-#include "Core/precomp.h"
-#include "API/Core/System/work_queue.h"
-#include "API/Core/System/system.h"
-#include <algorithm>
-#include "API/Core/Math/cl_math.h"
-#include <atomic>
-#include <thread>
-#include <condition_variable>
-
-namespace clan
-{
-	class WorkItemProcess : public WorkItem
-	{
-	public:
-		WorkItemProcess(const std::function<void()> &func) : func(func) { }
-
-		void process_work() override { func(); }
-
-	private:
-		std::function<void()> func;
-	};
-
-	class WorkItemWorkCompleted : public WorkItem
-	{
-	public:
-		WorkItemWorkCompleted(const std::function<void()> &func) : func(func) { }
-
-		void process_work() override { }
-		void work_completed() override { func(); }
-
-	private:
-		std::function<void()> func;
-	};
-
-	class WorkQueue_Impl
-	{
-	public:
-		WorkQueue_Impl(bool serial_queue);
-		~WorkQueue_Impl();
-
-		void queue(WorkItem *item); // transfers ownership
-		void work_completed(WorkItem *item); // transfers ownership
-
-		int get_items_queued() const { return items_queued; }
-
-		void process_work_completed();
-
-	private:
-		void worker_main();
-
-		bool serial_queue = false;
-		std::vector<std::thread> threads;
-		std::mutex mutex;
-		std::condition_variable worker_event;
-		bool stop_flag = false;
-		std::vector<WorkItem *> queued_items;
-		std::vector<WorkItem *> finished_items;
-		std::atomic_int items_queued;
-	};
-
-	WorkQueue::WorkQueue(bool serial_queue)
-		: impl(std::make_shared<WorkQueue_Impl>(serial_queue))
-	{
-	}
-
-	WorkQueue::~WorkQueue()
-	{
-	}
-
-	void WorkQueue::queue(WorkItem *item) // transfers ownership
-	{
-		impl->queue(item);
-	}
-
-	void WorkQueue::queue(const std::function<void()> &func)
-	{
-		impl->queue(new WorkItemProcess(func));
-	}
-
-	void WorkQueue::work_completed(const std::function<void()> &func)
-	{
-		impl->work_completed(new WorkItemWorkCompleted(func));
-	}
-
-	int WorkQueue::get_items_queued() const
-	{
-		return impl->get_items_queued();
-	}
-
-	void WorkQueue::process_work_completed()
-	{
-		impl->process_work_completed();
-	}
-
-	/////////////////////////////////////////////////////////////////////////////
-
-	WorkQueue_Impl::WorkQueue_Impl(bool serial_queue)
-		: serial_queue(serial_queue)
-	{
-	}
-
-	WorkQueue_Impl::~WorkQueue_Impl()
-	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		stop_flag = true;
-		mutex_lock.unlock();
-		worker_event.notify_all();
-
-		for (auto & elem : threads)
-			elem.join();
-		for (auto & elem : queued_items)
-			delete elem;
-		for (auto & elem : finished_items)
-			delete elem;
-	}
-
-	void WorkQueue_Impl::queue(WorkItem *item) // transfers ownership
-	{
-		if (threads.empty())
-		{
-			int num_cores = serial_queue ? 1 : clan::max(System::get_num_cores() - 1, 1);
-			for (int i = 0; i < num_cores; i++)
-			{
-				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this));
-			}
-		}
-
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		queued_items.push_back(item);
-		++items_queued;
-		mutex_lock.unlock();
-		worker_event.notify_one();
-	}
-
-	void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
-	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		finished_items.push_back(item);
-		++items_queued;
-	}
-
-	void WorkQueue_Impl::process_work_completed()
-	{
-		std::unique_lock<std::mutex> mutex_lock(mutex);
-		std::vector<WorkItem *> items;
-		items.swap(finished_items);
-		mutex_lock.unlock();
-		for (size_t i = 0; i < items.size(); i++)
-		{
-			try
-			{
-				items[i]->work_completed();
-			}
-			catch (...)
-			{
-				mutex_lock.lock();
-				finished_items.insert(finished_items.begin(), items.begin() + i, items.end());
-				throw;
-			}
-			delete items[i];
-			--items_queued;
-		}
-	}
-
-	void WorkQueue_Impl::worker_main()
-	{
-		while (true)
-		{
-			std::unique_lock<std::mutex> mutex_lock(mutex);
-			worker_event.wait(mutex_lock, [&]() { return stop_flag || !queued_items.empty(); });
-
-			if (stop_flag)
-				break;
-
-			WorkItem *item = queued_items.front();
-			queued_items.erase(queued_items.begin());
-			mutex_lock.unlock();
-
-			item->process_work();
-
-			mutex_lock.lock();
-			finished_items.push_back(item);
-			mutex_lock.unlock();
-		}
-	}
-}
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/thread_local_storage.h"
+#include <algorithm>
+#include "API/Core/Math/cl_math.h"
+#include "work_queue_impl.h"
+
+namespace clan
+{
+	class WorkItemWorkCompleted : public WorkItem
+	{
+	public:
+		WorkItemWorkCompleted(const std::function<void()> &func) : func(func) { }
+
+		void process_work() override { }
+		void work_completed() override { func(); }
+
+	private:
+		std::function<void()> func;
+	};
+
+	static cl_tls_variable WorkQueueWorker *cl_current_work_queue_worker = nullptr;
+
+	WorkQueue::WorkQueue(bool serial_queue)
+		: impl(std::make_shared<WorkQueue_Impl>(serial_queue, work_queue_shared, 0))
+	{
+	}
+
+	WorkQueue::WorkQueue(WorkQueueScheduler scheduler, int num_threads)
+		: impl(std::make_shared<WorkQueue_Impl>(false, scheduler, num_threads))
+	{
+	}
+
+	WorkQueue::~WorkQueue()
+	{
+	}
+
+	void WorkQueue::queue(WorkItem *item) // transfers ownership
+	{
+		impl->queue(item);
+	}
+
+	void WorkQueue::queue(const std::function<void()> &func)
+	{
+		impl->queue(func);
+	}
+
+	void WorkQueue::work_completed(const std::function<void()> &func)
+	{
+		impl->work_completed(new WorkItemWorkCompleted(func));
+	}
+
+	int WorkQueue::get_items_queued() const
+	{
+		return impl->get_items_queued();
+	}
+
+	void WorkQueue::process_work_completed()
+	{
+		impl->process_work_completed();
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	WorkQueue_Impl::WorkQueue_Impl(bool serial_queue, WorkQueueScheduler scheduler, int num_threads)
+		: serial_queue(serial_queue), scheduler(serial_queue ? work_queue_shared : scheduler), num_threads(num_threads),
+		items_queued(0), pending_items(0), sleeping_workers(0), stealing_stop_flag(false)
+	{
+	}
+
+	WorkQueue_Impl::~WorkQueue_Impl()
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		stop_flag = true;
+		mutex_lock.unlock();
+		worker_event.notify_all();
+
+		std::unique_lock<std::mutex> sleep_lock(sleep_mutex);
+		stealing_stop_flag = true;
+		sleep_lock.unlock();
+		sleep_event.notify_all();
+
+		for (auto & elem : threads)
+			elem.join();
+		for (auto & elem : workers)
+			elem->thread.join();
+
+		for (auto & elem : queued_items)
+			delete elem;
+		for (auto & elem : finished_items)
+			delete elem;
+		for (auto & elem : injected_items)
+			delete elem;
+		for (auto & worker : workers)
+		{
+			while (WorkItem *item = worker->deque.pop())
+				delete item;
+			for (auto & elem : worker->finished_items)
+				delete elem;
+			for (auto & elem : worker->free_items)
+				delete elem;
+		}
+	}
+
+	void WorkQueue_Impl::start_threads()
+	{
+		int num_cores = num_threads > 0 ? num_threads : clan::max(System::get_num_cores() - 1, 1);
+		if (serial_queue)
+			num_cores = 1;
+
+		if (scheduler == work_queue_stealing)
+		{
+			// All workers must exist before any of them starts stealing from the others
+			for (int i = 0; i < num_cores; i++)
+			{
+				workers.push_back(std::unique_ptr<WorkQueueWorker>(new WorkQueueWorker(this, 0x9e3779b9u * (i + 1))));
+				workers.back()->finished_items.reserve(finished_batch_size);
+				workers.back()->free_items.reserve(max_free_items);
+			}
+			for (auto & worker : workers)
+				worker->thread = std::thread(&WorkQueue_Impl::worker_main_stealing, this, worker.get());
+		}
+		else
+		{
+			for (int i = 0; i < num_cores; i++)
+			{
+				threads.push_back(std::thread(&WorkQueue_Impl::worker_main, this));
+			}
+		}
+	}
+
+	void WorkQueue_Impl::queue(WorkItem *item) // transfers ownership
+	{
+		std::call_once(start_threads_flag, [this]() { start_threads(); });
+
+		++items_queued;
+
+		if (scheduler == work_queue_stealing)
+		{
+			WorkQueueWorker *worker = get_current_worker();
+			if (worker)
+			{
+				worker->deque.push(item);
+			}
+			else
+			{
+				std::unique_lock<std::mutex> injected_lock(injected_mutex);
+				injected_items.push_back(item);
+			}
+			++pending_items;
+			wake_worker();
+		}
+		else
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			queued_items.push_back(item);
+			mutex_lock.unlock();
+			worker_event.notify_one();
+		}
+	}
+
+	void WorkQueue_Impl::queue(const std::function<void()> &func)
+	{
+		// Workers reuse the function items they finished, so submitting from a worker only allocates
+		// when the function object itself does not fit in std::function's local storage
+		WorkQueueWorker *worker = scheduler == work_queue_stealing ? get_current_worker() : nullptr;
+		if (worker && !worker->free_items.empty())
+		{
+			WorkItemProcess *item = worker->free_items.back();
+			worker->free_items.pop_back();
+			item->func = func;
+			queue(item);
+		}
+		else
+		{
+			queue(new WorkItemProcess(func));
+		}
+	}
+
+	void WorkQueue_Impl::work_completed(WorkItem *item) // transfers ownership
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		finished_items.push_back(item);
+		++items_queued;
+	}
+
+	void WorkQueue_Impl::process_work_completed()
+	{
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		std::vector<WorkItem *> items;
+		items.swap(finished_items);
+		mutex_lock.unlock();
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			try
+			{
+				items[i]->work_completed();
+			}
+			catch (...)
+			{
+				mutex_lock.lock();
+				finished_items.insert(finished_items.begin(), items.begin() + i, items.end());
+				throw;
+			}
+			delete items[i];
+			--items_queued;
+		}
+	}
+
+	bool WorkQueue_Impl::process_queued_item()
+	{
+		// Running items out of order on another thread would break the guarantee of a serial queue
+		if (serial_queue)
+			return false;
+
+		std::call_once(start_threads_flag, [this]() { start_threads(); });
+
+		if (scheduler == work_queue_stealing)
+		{
+			WorkQueueWorker *worker = get_current_worker();
+			if (worker)
+			{
+				WorkItem *item = find_work(worker);
+				if (!item)
+					return false;
+
+				item->process_work();
+				finish_item(worker, item);
+				return true;
+			}
+
+			WorkItem *item = nullptr;
+			std::unique_lock<std::mutex> injected_lock(injected_mutex);
+			if (!injected_items.empty())
+			{
+				item = injected_items.front();
+				injected_items.pop_front();
+			}
+			injected_lock.unlock();
+
+			if (!item)
+				item = steal_work(nullptr);
+			if (!item)
+				return false;
+			--pending_items;
+
+			item->process_work();
+
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			finished_items.push_back(item);
+			return true;
+		}
+		else
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			if (queued_items.empty())
+				return false;
+
+			WorkItem *item = queued_items.front();
+			queued_items.erase(queued_items.begin());
+			mutex_lock.unlock();
+
+			item->process_work();
+
+			mutex_lock.lock();
+			finished_items.push_back(item);
+			return true;
+		}
+	}
+
+	int WorkQueue_Impl::get_num_threads()
+	{
+		std::call_once(start_threads_flag, [this]() { start_threads(); });
+		return scheduler == work_queue_stealing ? (int)workers.size() : (int)threads.size();
+	}
+
+	void WorkQueue_Impl::worker_main()
+	{
+		while (true)
+		{
+			std::unique_lock<std::mutex> mutex_lock(mutex);
+			worker_event.wait(mutex_lock, [&]() { return stop_flag || !queued_items.empty(); });
+
+			if (stop_flag)
+				break;
+
+			WorkItem *item = queued_items.front();
+			queued_items.erase(queued_items.begin());
+			mutex_lock.unlock();
+
+			item->process_work();
+
+			mutex_lock.lock();
+			finished_items.push_back(item);
+			mutex_lock.unlock();
+		}
+	}
+
+	void WorkQueue_Impl::worker_main_stealing(WorkQueueWorker *worker)
+	{
+		worker->thread_id = std::this_thread::get_id();
+		cl_current_work_queue_worker = worker;
+
+		while (true)
+		{
+			WorkItem *item = find_work(worker);
+			if (item)
+			{
+				item->process_work();
+				finish_item(worker, item);
+			}
+			else
+			{
+				flush_finished_items(worker);
+				if (!wait_for_work())
+					break;
+			}
+		}
+
+		cl_current_work_queue_worker = nullptr;
+	}
+
+	WorkQueueWorker *WorkQueue_Impl::get_current_worker() const
+	{
+		// The thread id check protects platforms where cl_tls_variable is not truly thread local
+		WorkQueueWorker *worker = cl_current_work_queue_worker;
+		if (worker && worker->work_queue == this && worker->thread_id == std::this_thread::get_id())
+			return worker;
+		else
+			return nullptr;
+	}
+
+	WorkItem *WorkQueue_Impl::find_work(WorkQueueWorker *worker)
+	{
+		WorkItem *item = worker->deque.pop();
+
+		if (!item)
+		{
+			std::unique_lock<std::mutex> injected_lock(injected_mutex);
+			if (!injected_items.empty())
+			{
+				item = injected_items.front();
+				injected_items.pop_front();
+			}
+		}
+
+		if (!item)
+			item = steal_work(worker);
+
+		if (item)
+			--pending_items;
+		return item;
+	}
+
+	WorkItem *WorkQueue_Impl::steal_work(WorkQueueWorker *worker)
+	{
+		size_t num_workers = workers.size();
+		if (num_workers < (worker ? 2u : 1u))
+			return nullptr;
+
+		// xorshift32 picks a random victim to start from
+		static cl_tls_variable unsigned int cl_external_random_seed = 0x2545f491u;
+		unsigned int x = worker ? worker->random_seed : cl_external_random_seed;
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		if (worker)
+			worker->random_seed = x;
+		else
+			cl_external_random_seed = x;
+
+		size_t start = x % num_workers;
+		for (size_t i = 0; i < num_workers; i++)
+		{
+			WorkQueueWorker *victim = workers[(start + i) % num_workers].get();
+			if (victim == worker)
+				continue;
+
+			WorkItem *item = victim->deque.steal();
+			if (item)
+				return item;
+		}
+		return nullptr;
+	}
+
+	void WorkQueue_Impl::finish_item(WorkQueueWorker *worker, WorkItem *item)
+	{
+		// Function items have nothing to do on the WorkQueue thread. The worker keeps them for its next submits.
+		WorkItemProcess *process_item = dynamic_cast<WorkItemProcess *>(item);
+		if (process_item && worker->free_items.size() < max_free_items)
+		{
+			process_item->func = nullptr;
+			worker->free_items.push_back(process_item);
+			--items_queued;
+			return;
+		}
+
+		// Finished items are handed over in batches to keep the completion mutex out of the hot path
+		worker->finished_items.push_back(item);
+		if (worker->finished_items.size() >= finished_batch_size)
+			flush_finished_items(worker);
+	}
+
+	void WorkQueue_Impl::flush_finished_items(WorkQueueWorker *worker)
+	{
+		if (worker->finished_items.empty())
+			return;
+
+		std::unique_lock<std::mutex> mutex_lock(mutex);
+		finished_items.insert(finished_items.end(), worker->finished_items.begin(), worker->finished_items.end());
+		mutex_lock.unlock();
+		worker->finished_items.clear();
+	}
+
+	bool WorkQueue_Impl::wait_for_work()
+	{
+		// A steal can fail spuriously while other threads race for the same item.
+		// Only go to sleep once nothing is pending anywhere.
+		if (pending_items.load() > 0)
+		{
+			std::this_thread::yield();
+			return !stealing_stop_flag;
+		}
+
+		std::unique_lock<std::mutex> sleep_lock(sleep_mutex);
+		++sleeping_workers;
+		sleep_event.wait(sleep_lock, [&]() { return stealing_stop_flag || pending_items.load() > 0; });
+		--sleeping_workers;
+		return !stealing_stop_flag;
+	}
+
+	void WorkQueue_Impl::wake_worker()
+	{
+		if (sleeping_workers.load() > 0)
+		{
+			// Taking the mutex guarantees the sleeper is either waiting or will see the new pending count
+			std::unique_lock<std::mutex> sleep_lock(sleep_mutex);
+			sleep_lock.unlock();
+			sleep_event.notify_one();
+		}
+	}
+}
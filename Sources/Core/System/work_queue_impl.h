@@ -0,0 +1,124 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Core/System/work_queue.h"
+#include "work_stealing_deque.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+namespace clan
+{
+	class WorkQueue_Impl;
+
+	class WorkItemProcess : public WorkItem
+	{
+	public:
+		WorkItemProcess(const std::function<void()> &func) : func(func) { }
+
+		void process_work() override { func(); }
+
+		std::function<void()> func;
+	};
+
+	class WorkQueueWorker
+	{
+	public:
+		WorkQueueWorker(WorkQueue_Impl *work_queue, unsigned int random_seed) : work_queue(work_queue), random_seed(random_seed) { }
+
+		WorkQueue_Impl *work_queue;
+		std::thread thread;
+		std::thread::id thread_id;
+		WorkStealingDeque deque;
+		std::vector<WorkItem *> finished_items;
+		std::vector<WorkItemProcess *> free_items;
+		unsigned int random_seed;
+	};
+
+	class WorkQueue_Impl
+	{
+	public:
+		WorkQueue_Impl(bool serial_queue, WorkQueueScheduler scheduler, int num_threads);
+		~WorkQueue_Impl();
+
+		void queue(WorkItem *item); // transfers ownership
+		void queue(const std::function<void()> &func);
+		void work_completed(WorkItem *item); // transfers ownership
+
+		int get_items_queued() const { return items_queued; }
+
+		void process_work_completed();
+
+		bool process_queued_item(); // runs one queued item on the calling thread, returns false if there was nothing to run
+
+		int get_num_threads();
+
+	private:
+		void start_threads();
+		void worker_main();
+
+		void worker_main_stealing(WorkQueueWorker *worker);
+		WorkQueueWorker *get_current_worker() const;
+		WorkItem *find_work(WorkQueueWorker *worker);
+		WorkItem *steal_work(WorkQueueWorker *worker);
+		void finish_item(WorkQueueWorker *worker, WorkItem *item);
+		void flush_finished_items(WorkQueueWorker *worker);
+		bool wait_for_work();
+		void wake_worker();
+
+		bool serial_queue = false;
+		WorkQueueScheduler scheduler = work_queue_shared;
+		int num_threads = 0;
+		std::once_flag start_threads_flag;
+		std::vector<std::thread> threads;
+		std::mutex mutex;
+		std::condition_variable worker_event;
+		bool stop_flag = false;
+		std::vector<WorkItem *> queued_items;
+		std::vector<WorkItem *> finished_items;
+		std::atomic_int items_queued;
+
+		// Work stealing scheduler state
+		std::vector<std::unique_ptr<WorkQueueWorker>> workers;
+		std::mutex injected_mutex;
+		std::deque<WorkItem *> injected_items;
+		std::atomic_int pending_items;
+		std::atomic_int sleeping_workers;
+		std::atomic_bool stealing_stop_flag;
+		std::mutex sleep_mutex;
+		std::condition_variable sleep_event;
+
+		static const size_t finished_batch_size = 64;
+		static const size_t max_free_items = 256;
+	};
+}
@@ -0,0 +1,173 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	class WorkItem;
+
+	/// \brief Chase-Lev work stealing deque
+	///
+	/// Only the owning worker thread may call push() and pop(). Any thread may call steal().
+	/// The owner works in LIFO order on the bottom end while thieves take the oldest items from the top.
+	/// When the ring buffer is full, push() swaps in one twice the size. A thief may still be reading from
+	/// the old buffer, so replaced buffers are kept until the deque is destroyed. Together they are always
+	/// smaller than the current buffer.
+	class WorkStealingDeque
+	{
+	public:
+		static const int64_t initial_capacity = 1024;
+
+		WorkStealingDeque() : top(0), bottom(0), array(new Array(initial_capacity))
+		{
+		}
+
+		~WorkStealingDeque()
+		{
+			delete array.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Pushes an item onto the bottom of the deque
+		///
+		/// Only allocates when the deque has to grow.
+		void push(WorkItem *item)
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed);
+			int64_t t = top.load(std::memory_order_acquire);
+			Array *a = array.load(std::memory_order_relaxed);
+			if (b - t >= a->capacity)
+				a = grow(a, t, b);
+
+			a->put(b, item);
+			std::atomic_thread_fence(std::memory_order_release);
+			bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		/// \brief Pops the most recently pushed item, or nullptr if the deque is empty
+		WorkItem *pop()
+		{
+			int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+			Array *a = array.load(std::memory_order_relaxed);
+			bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t t = top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			WorkItem *item = a->get(b);
+			if (t == b)
+			{
+				// Last item - race against any thieves for it
+				if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+					item = nullptr;
+				bottom.store(b + 1, std::memory_order_relaxed);
+			}
+			return item;
+		}
+
+		/// \brief Steals the oldest item, or nullptr if the deque is empty or another thread won the race
+		WorkItem *steal()
+		{
+			int64_t t = top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t b = bottom.load(std::memory_order_acquire);
+			if (t >= b)
+				return nullptr;
+
+			Array *a = array.load(std::memory_order_acquire);
+			WorkItem *item = a->get(t);
+			if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return nullptr;
+			return item;
+		}
+
+		/// \brief Returns true if the deque looked empty at the time of the call
+		bool empty() const
+		{
+			return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+		}
+
+		/// \brief Returns the capacity of the current ring buffer
+		int64_t get_capacity() const
+		{
+			return array.load(std::memory_order_relaxed)->capacity;
+		}
+
+	private:
+		WorkStealingDeque(const WorkStealingDeque &) = delete;
+		WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+		class Array
+		{
+		public:
+			Array(int64_t capacity) : capacity(capacity), items(new std::atomic<WorkItem *>[capacity])
+			{
+				for (int64_t i = 0; i < capacity; i++)
+					items[i].store(nullptr, std::memory_order_relaxed);
+			}
+
+			WorkItem *get(int64_t index) const { return items[index & (capacity - 1)].load(std::memory_order_relaxed); }
+			void put(int64_t index, WorkItem *item) { items[index & (capacity - 1)].store(item, std::memory_order_relaxed); }
+
+			const int64_t capacity;
+
+		private:
+			std::unique_ptr<std::atomic<WorkItem *>[]> items;
+		};
+
+		Array *grow(Array *old_array, int64_t t, int64_t b)
+		{
+			Array *new_array = new Array(old_array->capacity * 2);
+			for (int64_t i = t; i < b; i++)
+				new_array->put(i, old_array->get(i));
+
+			retired_arrays.push_back(std::unique_ptr<Array>(old_array));
+			array.store(new_array, std::memory_order_release);
+			return new_array;
+		}
+
+		// Padding keeps the owner and thief ends on separate cache lines
+		char padding0[64];
+		std::atomic<int64_t> top;
+		char padding1[64 - sizeof(std::atomic<int64_t>)];
+		std::atomic<int64_t> bottom;
+		char padding2[64 - sizeof(std::atomic<int64_t>)];
+		std::atomic<Array *> array;
+		std::vector<std::unique_ptr<Array>> retired_arrays;
+	};
+}
@@ -43,6 +43,8 @@
 #include "zip_iodevice_fileentry.h"
 #include "zip_compression_method.h"
 #include "zip_digital_signature.h"
+#include "zip_mapped_file.h"
+#include "zip_seek_index.h"
 #include <ctime>
 #include <mutex>
 
@@ -59,6 +61,15 @@ namespace clan
 		IODevice input = File(filename);
 		impl->input = input;
 		load(input);
+
+		// Serve entries from a mapping of the archive when the platform allows it
+		try
+		{
+			impl->mapping = std::make_shared<ZipMappedFile>(filename);
+		}
+		catch (const Exception &)
+		{
+		}
 	}
 
 	ZipArchive::ZipArchive(IODevice &input)
@@ -142,39 +153,44 @@ namespace clan
 
 	IODevice ZipArchive::open_file(const std::string &filename)
 	{
-		int size = impl->files.size();
-		for (int i = 0; i < size; i++)
-		{
-			ZipFileEntry &entry = impl->files[i];
+		auto it = impl->file_index.find(filename);
+		if (it == impl->file_index.end())
+			throw Exception(string_format("Unable to find zip index %1", filename));
 
-			std::string entry_filename = entry.impl->record.filename;
-			if (entry_filename[0] == '/')
-				entry_filename = entry_filename.substr(1, std::string::npos);
-
-			if (entry_filename == filename)
+		ZipFileEntry &entry = impl->files[it->second];
+		switch (entry.impl->type)
+		{
+		case ZipFileEntry_Impl::type_file:
+			if (impl->mapping)
+				return IODevice(new ZipIODevice_FileEntry(IODevice(), entry, impl->mapping));
+			else
 			{
-				switch (entry.impl->type)
-				{
-				case ZipFileEntry_Impl::type_file:
-				{
-					IODevice dupe = impl->input.duplicate();
-					return IODevice(new ZipIODevice_FileEntry(dupe, entry));
-				}
+				IODevice dupe = impl->input.duplicate();
+				return IODevice(new ZipIODevice_FileEntry(dupe, entry));
+			}
 
-				case ZipFileEntry_Impl::type_removed:
-					throw Exception(string_format("Unable to zip open file entry %1. The entry has been removed!", filename));
-					break;
+		case ZipFileEntry_Impl::type_removed:
+			throw Exception(string_format("Unable to zip open file entry %1. The entry has been removed!", filename));
+			break;
 
-				case ZipFileEntry_Impl::type_added_memory:
-					return MemoryDevice(entry.impl->data);
+		case ZipFileEntry_Impl::type_added_memory:
+			return MemoryDevice(entry.impl->data);
 
-				case ZipFileEntry_Impl::type_added_file:
-					return File(entry.impl->filename);
-				}
-				throw Exception(string_format("Unknown zip file entry type %1", filename));
-			}
+		case ZipFileEntry_Impl::type_added_file:
+			return File(entry.impl->filename);
+		}
+		throw Exception(string_format("Unknown zip file entry type %1", filename));
+	}
+
+	void ZipArchive::set_seek_index_interval(int interval)
+	{
+		impl->seek_index_interval = interval;
+		for (auto &entry : impl->files)
+		{
+			entry.impl->seek_index.reset();
+			if (interval > 0 && entry.impl->record.compression_method == zip_compress_deflate && (uint32_t)entry.impl->record.uncompressed_size > (uint32_t)interval)
+				entry.impl->seek_index = std::make_shared<ZipSeekIndex>(interval);
 		}
-		throw Exception(string_format("Unable to find zip index %1", filename));
 	}
 
 	std::string ZipArchive::get_pathname(const std::string &filename)
@@ -193,6 +209,7 @@ namespace clan
 		file_entry.set_input_filename(input_filename);
 		file_entry.set_archive_filename(archive_filename);
 		impl->files.push_back(file_entry);
+		impl->add_to_index(impl->files.size() - 1);
 	}
 
 	void ZipArchive::save()
@@ -359,22 +376,57 @@ namespace clan
 
 		// Load central directory records:
 
-		if (zip64) input.seek(int(zip64_end_of_directory.offset_to_start_of_central_directory), IODevice::seek_set);
-		else input.seek(int(end_of_directory.offset_to_start_of_central_directory), IODevice::seek_set);
-
+		int64_t central_directory_offset = end_of_directory.offset_to_start_of_central_directory;
+		int64_t central_directory_size = end_of_directory.size_of_central_directory;
 		int64_t num_entries = end_of_directory.number_of_entries_in_central_directory;
-		if (zip64) num_entries = zip64_end_of_directory.number_of_entries_in_central_directory;
+		if (zip64)
+		{
+			central_directory_offset = zip64_end_of_directory.offset_to_start_of_central_directory;
+			central_directory_size = zip64_end_of_directory.size_of_central_directory;
+			num_entries = zip64_end_of_directory.number_of_entries_in_central_directory;
+		}
 
+		// Read the whole directory at once rather than a field at a time from the device
+		if (central_directory_offset < 0 || central_directory_size < 0 || central_directory_offset + central_directory_size > size_file)
+			throw Exception("Zip central directory is out of range");
+		DataBuffer central_directory((size_t)central_directory_size);
+		input.seek(int(central_directory_offset), IODevice::seek_set);
+		input.read(central_directory.get_data(), central_directory.get_size());
+		MemoryDevice directory_input(central_directory);
+		directory_input.set_little_endian_mode();
+
+		impl->files.clear();
+		impl->files.reserve(size_t(num_entries));
+		impl->file_index.clear();
+		impl->file_index.reserve(size_t(num_entries));
 		for (int i = 0; i < num_entries; i++)
 		{
 			ZipFileEntry entry;
-			entry.impl->record.load(input);
+			entry.impl->record.load(directory_input);
 			impl->files.push_back(entry);
+			impl->add_to_index(impl->files.size() - 1);
 		}
+
+		if (impl->seek_index_interval > 0)
+			set_seek_index_interval(impl->seek_index_interval);
 	}
 
 	/////////////////////////////////////////////////////////////////////////////
 
+	void ZipArchive_Impl::add_to_index(size_t index)
+	{
+		// The first entry wins if the archive contains duplicate names
+		file_index.insert(std::make_pair(get_index_key(files[index].get_archive_filename()), index));
+	}
+
+	std::string ZipArchive_Impl::get_index_key(const std::string &filename)
+	{
+		if (!filename.empty() && filename[0] == '/')
+			return filename.substr(1);
+		else
+			return filename;
+	}
+
 	void ZipArchive_Impl::calc_time_and_date(int16_t &out_date, int16_t &out_time)
 	{
 		uint32_t day_of_month = 0;
@@ -31,15 +31,30 @@
 #include "API/Core/Zip/zip_file_entry.h"
 #include "API/Core/IOData/iodevice.h"
 #include "zip_flags.h"
+#include <unordered_map>
 
 namespace clan
 {
+	class ZipMappedFile;
+
 	class ZipArchive_Impl
 	{
 	public:
 		std::vector<ZipFileEntry> files;
 		IODevice input;
 
+		/// \brief Index into files for each archive filename, without leading slash.
+		std::unordered_map<std::string, size_t> file_index;
+
+		/// \brief Mapping of the archive file, if it was opened by filename and could be mapped.
+		std::shared_ptr<ZipMappedFile> mapping;
+
+		/// \brief Distance between inflate checkpoints for deflated entries, or 0 if disabled.
+		int seek_index_interval = 0;
+
+		void add_to_index(size_t index);
+		static std::string get_index_key(const std::string &filename);
+
 		static uint32_t calc_crc32(const void *data, int64_t size, uint32_t crc = ZIP_CRC_START_VALUE, bool last_block = true);
 		static void calc_time_and_date(int16_t &out_date, int16_t &out_time);
 
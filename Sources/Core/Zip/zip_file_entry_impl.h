@@ -31,9 +31,12 @@
 #include "API/Core/System/cl_platform.h"
 #include "API/Core/System/databuffer.h"
 #include "zip_file_header.h"
+#include <memory>
 
 namespace clan
 {
+	class ZipSeekIndex;
+
 	class ZipFileEntry_Impl
 	{
 	public:
@@ -63,5 +66,8 @@ namespace clan
 
 		/// \brief True, if this entry is a directory.
 		bool is_directory;
+
+		/// \brief Inflate checkpoints, if a seek index is enabled for the archive (type_file).
+		std::shared_ptr<ZipSeekIndex> seek_index;
 	};
 }
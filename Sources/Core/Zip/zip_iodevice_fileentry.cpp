@@ -30,22 +30,34 @@
 #include "zip_iodevice_fileentry.h"
 #include "zip_file_entry_impl.h"
 #include "zip_compression_method.h"
+#include "zip_mapped_file.h"
+#include "zip_seek_index.h"
 #include "zip_flags.h"
 #include "API/Core/IOData/file.h"
 #include "API/Core/Math/cl_math.h"
 #include "API/Core/Text/string_format.h"
+#include <algorithm>
 
 namespace clan
 {
-	ZipIODevice_FileEntry::ZipIODevice_FileEntry(IODevice iodevice, const ZipFileEntry &entry)
-		: iodevice(iodevice), file_entry(entry), zstream_open(false), peeked_data(0)
+	static unsigned int zip_read_uint16(const unsigned char *data)
+	{
+		return data[0] | (data[1] << 8);
+	}
+
+	static unsigned int zip_read_uint32(const unsigned char *data)
+	{
+		return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+	}
+
+	ZipIODevice_FileEntry::ZipIODevice_FileEntry(IODevice iodevice, const ZipFileEntry &entry, std::shared_ptr<ZipMappedFile> mapping)
+		: iodevice(iodevice), mapping(mapping), seek_index(entry.impl->seek_index), file_entry(entry), peeked_data(0)
 	{
 		init();
 	}
 
 	ZipIODevice_FileEntry::~ZipIODevice_FileEntry()
 	{
-		deinit();
 	}
 
 	size_t ZipIODevice_FileEntry::get_size() const
@@ -55,7 +67,7 @@ namespace clan
 
 	size_t ZipIODevice_FileEntry::get_position() const
 	{
-		return size_t(pos);
+		return size_t(pos) - peeked_data.get_size();
 	}
 
 	size_t ZipIODevice_FileEntry::send(const void *data, size_t len, bool send_all)
@@ -116,34 +128,28 @@ namespace clan
 			break;
 
 		case IODevice::seek_cur:
-			absolute_pos = pos + seek_pos;
+			absolute_pos = pos - (int64_t)peeked_data.get_size() + seek_pos;
 			break;
 
 		case IODevice::seek_end:
 			absolute_pos = file_header.uncompressed_size + seek_pos;
 			break;
 		}
+		absolute_pos = clamp(absolute_pos, (int64_t)0, (int64_t)file_header.uncompressed_size);
 
 		switch (file_header.compression_method)
 		{
 		case zip_compress_store: // no compression
-			iodevice.seek(int(absolute_pos - pos), IODevice::seek_cur);
+			if (!mapping)
+				iodevice.seek(int(data_offset + absolute_pos), IODevice::seek_set);
+			pos = absolute_pos;
 			break;
 
 		case zip_compress_deflate:
-			// if backward seeking, restart at beginning of stream.
-			if (absolute_pos < pos)
-			{
-				deinit();
-				init();
-			}
-
-			char buffer[1024];
-			while (absolute_pos > pos)
-			{
-				size_t received = receive(buffer, size_t(min(absolute_pos - pos, (int64_t)1024)), true);
-				if (received == 0) break;
-			}
+			// Continue from the closest checkpoint if it is ahead of us, or restart the stream if seeking backwards
+			if (!restore_checkpoint(absolute_pos) && absolute_pos < pos)
+				restart_inflate();
+			inflate_read(nullptr, size_t(absolute_pos - pos));
 			break;
 
 		case zip_compress_shrunk:
@@ -157,20 +163,42 @@ namespace clan
 		case zip_compress_pkware_implode:
 			return false;
 		}
+		peeked_data.set_size(0);
 		return true;
 	}
 
 	IODeviceProvider *ZipIODevice_FileEntry::duplicate()
 	{
-		ZipIODevice_FileEntry *new_provider = new ZipIODevice_FileEntry(this, file_entry);
-		return new_provider;
+		return new ZipIODevice_FileEntry(mapping ? IODevice() : iodevice.duplicate(), file_entry, mapping);
 	}
 
-
 	void ZipIODevice_FileEntry::init()
 	{
-		iodevice.seek(file_entry.impl->record.relative_offset_of_local_header, IODevice::seek_set);
-		file_header.load(iodevice);
+		if (mapping)
+		{
+			// Only the fields needed for reading are taken from the local header
+			int64_t header_offset = (uint32_t)file_entry.impl->record.relative_offset_of_local_header;
+			if (header_offset + 30 > mapping->get_size())
+				throw Exception("Incorrect Local File Header offset");
+
+			const unsigned char *header = mapping->get_data() + header_offset;
+			if (zip_read_uint32(header) != 0x04034b50)
+				throw Exception("Incorrect Local File Header signature");
+			file_header.general_purpose_bit_flag = zip_read_uint16(header + 6);
+			file_header.compression_method = zip_read_uint16(header + 8);
+			file_header.crc32 = zip_read_uint32(header + 14);
+			file_header.compressed_size = zip_read_uint32(header + 18);
+			file_header.uncompressed_size = zip_read_uint32(header + 22);
+			file_header.file_name_length = zip_read_uint16(header + 26);
+			file_header.extra_field_length = zip_read_uint16(header + 28);
+			data_offset = header_offset + 30 + (uint16_t)file_header.file_name_length + (uint16_t)file_header.extra_field_length;
+		}
+		else
+		{
+			iodevice.seek(file_entry.impl->record.relative_offset_of_local_header, IODevice::seek_set);
+			file_header.load(iodevice);
+			data_offset = iodevice.get_position();
+		}
 
 		//This fix allows OS X created .zips to be opened - SAR
 		if (file_header.general_purpose_bit_flag  & ZIP_CRC32_IN_FILE_DESCRIPTOR) //if this bit is set, it means the local header data for sizes was not
@@ -180,27 +208,21 @@ namespace clan
 			file_header.uncompressed_size = file_entry.get_uncompressed_size();
 		}
 
+		if (mapping && data_offset + file_header.compressed_size > mapping->get_size())
+			throw Exception("Zip file entry extends past the end of the archive");
+
 		pos = 0;
 		compressed_pos = 0;
 
 		// Initialize decompression:
-		int result = 0;
 		switch (file_header.compression_method)
 		{
 		case zip_compress_store: // no compression
 			break;
 
 		case zip_compress_deflate:
-			memset(&zs, 0, sizeof(mz_stream));
-			zs.next_in = nullptr;
-			zs.avail_in = 0;
-			zs.zalloc = nullptr;
-			zs.zfree = nullptr;
-			zs.opaque = nullptr;
-			//result = inflateInit(&zs);
-			result = mz_inflateInit2(&zs, -15); // Undocumented: if wbits is negative, zlib skips header check
-			if (result != MZ_OK) throw Exception("Zlib inflateInit failed for zip index!");
-			zstream_open = true;
+			dict.reset(new unsigned char[TINFL_LZ_DICT_SIZE]);
+			restart_inflate();
 			break;
 
 		case zip_compress_shrunk:
@@ -217,19 +239,28 @@ namespace clan
 		}
 	}
 
-	void ZipIODevice_FileEntry::deinit()
+	size_t ZipIODevice_FileEntry::lowlevel_read(void *data, size_t size, bool read_all)
 	{
-		// Clean up decompression:
 		switch (file_header.compression_method)
 		{
 		case zip_compress_store: // no compression
-			break;
+		{
+			size_t available = size_t(min((int64_t)size, file_header.uncompressed_size - pos));
+			if (mapping)
+			{
+				memcpy(data, mapping->get_data() + data_offset + pos, available);
+				pos += available;
+				return available;
+			}
+
+			size_t received = iodevice.receive(data, available, read_all);
+			pos += received;
+			return received;
+		}
+		break;
 
 		case zip_compress_deflate:
-			if (zstream_open)
-				mz_inflateEnd(&zs);
-			zstream_open = false;
-			break;
+			return inflate_read(static_cast<unsigned char *>(data), size);
 
 		case zip_compress_shrunk:
 		case zip_compress_expand_factor_1:
@@ -242,67 +273,143 @@ namespace clan
 		case zip_compress_pkware_implode:
 			break;
 		}
+
+		return 0;
 	}
 
-	size_t ZipIODevice_FileEntry::lowlevel_read(void *data, size_t size, bool read_all)
+	void ZipIODevice_FileEntry::restart_inflate()
 	{
-		switch (file_header.compression_method)
-		{
-		case zip_compress_store: // no compression
+		tinfl_init(&decompressor);
+		inflate_status = TINFL_STATUS_NEEDS_MORE_INPUT;
+		dict_offset = 0;
+		dict_avail = 0;
+		input_next = nullptr;
+		input_avail = 0;
+		pos = 0;
+		compressed_pos = 0;
+		next_checkpoint = seek_index ? seek_index->interval : 0;
+		if (!mapping)
+			iodevice.seek(int(data_offset), IODevice::seek_set);
+	}
+
+	bool ZipIODevice_FileEntry::restore_checkpoint(int64_t position)
+	{
+		if (!seek_index)
+			return false;
+
+		std::shared_ptr<ZipInflateCheckpoint> checkpoint;
 		{
-			size_t received = iodevice.receive(data, size_t(min((int64_t)size, file_header.uncompressed_size - pos)), read_all);
-			pos += received;
-			return received;
+			std::unique_lock<std::mutex> lock(seek_index->mutex);
+			auto &checkpoints = seek_index->checkpoints;
+			auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), position, [](int64_t position, const std::shared_ptr<ZipInflateCheckpoint> &checkpoint) { return position < checkpoint->position; });
+			if (it == checkpoints.begin())
+				return false;
+			checkpoint = *(it - 1);
 		}
-		break;
 
-		case zip_compress_deflate:
-			zs.next_out = (unsigned char *)data;
-			zs.avail_out = (unsigned int)size;
-			// Continue feeding zlib data until we get our data:
-			while (zs.avail_out > 0)
+		// Only worth it if the checkpoint is ahead of the current position, or we are seeking backwards
+		if (checkpoint->position <= pos && position >= pos)
+			return false;
+
+		decompressor = checkpoint->decompressor;
+		inflate_status = TINFL_STATUS_NEEDS_MORE_INPUT;
+		memcpy(dict.get(), checkpoint->dict.get(), TINFL_LZ_DICT_SIZE);
+		dict_offset = checkpoint->dict_offset;
+		dict_avail = 0;
+		input_next = nullptr;
+		input_avail = 0;
+		pos = checkpoint->position;
+		compressed_pos = checkpoint->compressed_position;
+		next_checkpoint = (pos / seek_index->interval + 1) * seek_index->interval;
+		if (!mapping)
+			iodevice.seek(int(data_offset + compressed_pos), IODevice::seek_set);
+		return true;
+	}
+
+	void ZipIODevice_FileEntry::add_checkpoint()
+	{
+		int64_t interval = seek_index->interval;
+		next_checkpoint = (pos / interval + 1) * interval;
+
+		std::unique_lock<std::mutex> lock(seek_index->mutex);
+
+		// Keep one checkpoint per interval, whichever device got there first
+		auto &checkpoints = seek_index->checkpoints;
+		auto it = std::lower_bound(checkpoints.begin(), checkpoints.end(), pos, [](const std::shared_ptr<ZipInflateCheckpoint> &checkpoint, int64_t position) { return checkpoint->position < position; });
+		if (it != checkpoints.end() && (*it)->position / interval == pos / interval)
+			return;
+		if (it != checkpoints.begin() && (*(it - 1))->position / interval == pos / interval)
+			return;
+
+		auto checkpoint = std::make_shared<ZipInflateCheckpoint>();
+		checkpoint->position = pos;
+		checkpoint->compressed_position = compressed_pos - input_avail;
+		checkpoint->decompressor = decompressor;
+		checkpoint->dict_offset = dict_offset;
+		checkpoint->dict.reset(new unsigned char[TINFL_LZ_DICT_SIZE]);
+		memcpy(checkpoint->dict.get(), dict.get(), TINFL_LZ_DICT_SIZE);
+		checkpoints.insert(it, checkpoint);
+	}
+
+	size_t ZipIODevice_FileEntry::inflate_read(unsigned char *data, size_t size)
+	{
+		// Decompressed data goes through the 32 KB window, data == nullptr discards it
+		size_t total = 0;
+		while (total < size)
+		{
+			if (dict_avail > 0)
 			{
-				// zlib needs more data:
-				if (zs.avail_in == 0 && compressed_pos < file_header.compressed_size)
-				{
-					// Read some compressed data:
-					size_t received_input = 0;
-					while (received_input < 16 * 1024)
-					{
-						received_input += iodevice.receive(zbuffer, size_t(min((int64_t)16 * 1024, file_header.compressed_size - compressed_pos)), true);
-						if (compressed_pos + received_input == file_header.compressed_size) break;
-					}
-					compressed_pos += received_input;
-
-					zs.next_in = (unsigned char *)zbuffer;
-					zs.avail_in = (unsigned int)received_input;
-				}
-
-				// Decompress data:
-				int result = mz_inflate(&zs, 0);
-				if (result == MZ_STREAM_END) break;
-				if (result == MZ_NEED_DICT) throw Exception("Zlib inflate wants a dictionary!");
-				if (result == MZ_DATA_ERROR) throw Exception("Zip data stream is corrupted");
-				if (result == MZ_STREAM_ERROR) throw Exception("Zip stream structure was inconsistent!");
-				if (result == MZ_MEM_ERROR) throw Exception("Zlib did not have enough memory to decompress file!");
-				if (result == MZ_BUF_ERROR) throw Exception("Not enough data in buffer when Z_FINISH was used");
-				if (result != MZ_OK) throw Exception("Zlib inflate failed while decompressing zip file!");
+				size_t length = min(dict_avail, size - total);
+				if (data)
+					memcpy(data + total, dict.get() + dict_offset, length);
+				total += length;
+				pos += length;
+				dict_offset = (dict_offset + length) & (TINFL_LZ_DICT_SIZE - 1);
+				dict_avail -= length;
+
+				if (dict_avail == 0 && seek_index && pos >= next_checkpoint)
+					add_checkpoint();
+				continue;
 			}
-			pos += size - size_t(zs.avail_out);
-			return size - size_t(zs.avail_out);
 
-		case zip_compress_shrunk:
-		case zip_compress_expand_factor_1:
-		case zip_compress_expand_factor_2:
-		case zip_compress_expand_factor_3:
-		case zip_compress_expand_factor_4:
-		case zip_compress_implode:
-		case zip_compress_tokenize:
-		case zip_compress_deflate64:
-		case zip_compress_pkware_implode:
-			break;
+			if (inflate_status == TINFL_STATUS_DONE)
+				break;
+
+			if (input_avail == 0 && compressed_pos < file_header.compressed_size)
+				read_compressed();
+
+			size_t in_bytes = input_avail;
+			size_t out_bytes = TINFL_LZ_DICT_SIZE - dict_offset;
+			mz_uint32 flags = compressed_pos < file_header.compressed_size ? TINFL_FLAG_HAS_MORE_INPUT : 0;
+			inflate_status = tinfl_decompress(&decompressor, input_next, &in_bytes, dict.get(), dict.get() + dict_offset, &out_bytes, flags);
+			input_next += in_bytes;
+			input_avail -= in_bytes;
+			dict_avail = out_bytes;
+
+			if (inflate_status < TINFL_STATUS_DONE)
+				throw Exception("Zip data stream is corrupted");
+			if (in_bytes == 0 && out_bytes == 0 && inflate_status == TINFL_STATUS_NEEDS_MORE_INPUT)
+				throw Exception("Zip data stream ended early");
 		}
+		return total;
+	}
 
-		return 0;
+	void ZipIODevice_FileEntry::read_compressed()
+	{
+		// Mapped archives inflate straight from the mapping
+		if (mapping)
+		{
+			input_next = mapping->get_data() + data_offset + compressed_pos;
+			input_avail = size_t(file_header.compressed_size - compressed_pos);
+			compressed_pos = file_header.compressed_size;
+			return;
+		}
+
+		size_t received = iodevice.receive(zbuffer, size_t(min((int64_t)sizeof(zbuffer), file_header.compressed_size - compressed_pos)), true);
+		if (received == 0)
+			throw Exception("Zip data stream ended early");
+		input_next = zbuffer;
+		input_avail = received;
+		compressed_pos += received;
 	}
 }
@@ -32,15 +32,19 @@
 #include "API/Core/Zip/zip_file_entry.h"
 #include "API/Core/System/databuffer.h"
 #include "zip_local_file_header.h"
-#include <stack>
 #include "Core/Zip/miniz.h"
+#include <memory>
 
 namespace clan
 {
+	class ZipMappedFile;
+	class ZipSeekIndex;
+
 	class ZipIODevice_FileEntry : public IODeviceProvider
 	{
 	public:
-		ZipIODevice_FileEntry(IODevice iodevice, const ZipFileEntry &entry);
+		/// \brief Reads the entry from iodevice, or from mapping if it is set.
+		ZipIODevice_FileEntry(IODevice iodevice, const ZipFileEntry &entry, std::shared_ptr<ZipMappedFile> mapping = std::shared_ptr<ZipMappedFile>());
 		~ZipIODevice_FileEntry();
 
 		virtual size_t get_size() const override;
@@ -56,16 +60,30 @@ namespace clan
 
 	private:
 		void init();
-		void deinit();
 		size_t lowlevel_read(void *buffer, size_t size, bool read_all);
 
+		void restart_inflate();
+		bool restore_checkpoint(int64_t position);
+		void add_checkpoint();
+		size_t inflate_read(unsigned char *data, size_t size);
+		void read_compressed();
+
 		IODevice iodevice;
+		std::shared_ptr<ZipMappedFile> mapping;
+		std::shared_ptr<ZipSeekIndex> seek_index;
 		ZipFileEntry file_entry;
 		ZipLocalFileHeader file_header;
+		int64_t data_offset;
 		int64_t pos, compressed_pos;
-		mz_stream zs;
-		char zbuffer[16 * 1024];
-		bool zstream_open;
 		DataBuffer peeked_data;
+
+		tinfl_decompressor decompressor;
+		tinfl_status inflate_status;
+		std::unique_ptr<unsigned char[]> dict;
+		size_t dict_offset, dict_avail;
+		const unsigned char *input_next;
+		size_t input_avail;
+		int64_t next_checkpoint;
+		unsigned char zbuffer[16 * 1024];
 	};
 }
@@ -0,0 +1,101 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Core/precomp.h"
+#include "zip_mapped_file.h"
+#include "API/Core/Text/string_help.h"
+#include "API/Core/Text/string_format.h"
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace clan
+{
+#ifdef WIN32
+	ZipMappedFile::ZipMappedFile(const std::string &filename)
+	{
+		file_handle = CreateFile(StringHelp::utf8_to_ucs2(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+		if (file_handle == INVALID_HANDLE_VALUE)
+			throw Exception(string_format("Unable to open zip file '%1'", filename));
+
+		LARGE_INTEGER file_size;
+		if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0)
+		{
+			mapping_handle = CreateFileMapping(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping_handle)
+				data = static_cast<const unsigned char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+		}
+
+		if (!data)
+		{
+			if (mapping_handle)
+				CloseHandle(mapping_handle);
+			CloseHandle(file_handle);
+			throw Exception(string_format("Unable to map zip file '%1'", filename));
+		}
+		size = file_size.QuadPart;
+	}
+
+	ZipMappedFile::~ZipMappedFile()
+	{
+		UnmapViewOfFile(data);
+		CloseHandle(mapping_handle);
+		CloseHandle(file_handle);
+	}
+#else
+	ZipMappedFile::ZipMappedFile(const std::string &filename)
+	{
+		int handle = ::open(filename.c_str(), O_RDONLY);
+		if (handle == -1)
+			throw Exception(string_format("Unable to open zip file '%1'", filename));
+
+		struct stat file_stat;
+		void *mapped = MAP_FAILED;
+		if (fstat(handle, &file_stat) == 0 && file_stat.st_size > 0)
+			mapped = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, handle, 0);
+
+		// The mapping stays valid after the descriptor is closed
+		::close(handle);
+
+		if (mapped == MAP_FAILED)
+			throw Exception(string_format("Unable to map zip file '%1'", filename));
+
+		data = static_cast<const unsigned char *>(mapped);
+		size = file_stat.st_size;
+	}
+
+	ZipMappedFile::~ZipMappedFile()
+	{
+		munmap(const_cast<unsigned char *>(data), size);
+	}
+#endif
+}
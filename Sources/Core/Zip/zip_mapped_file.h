@@ -0,0 +1,58 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace clan
+{
+	/// \brief Read-only memory mapping of a zip archive file.
+	class ZipMappedFile
+	{
+	public:
+		/// \brief Maps the file. Throws if the file cannot be opened or mapped.
+		ZipMappedFile(const std::string &filename);
+		~ZipMappedFile();
+
+		const unsigned char *get_data() const { return data; }
+		int64_t get_size() const { return size; }
+
+	private:
+		ZipMappedFile(const ZipMappedFile &) = delete;
+		ZipMappedFile &operator=(const ZipMappedFile &) = delete;
+
+#ifdef WIN32
+		HANDLE file_handle = INVALID_HANDLE_VALUE;
+		HANDLE mapping_handle = nullptr;
+#endif
+		const unsigned char *data = nullptr;
+		int64_t size = 0;
+	};
+}
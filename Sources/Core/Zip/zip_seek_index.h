@@ -0,0 +1,66 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "Core/Zip/miniz.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Snapshot of the inflate state at a position in a deflated entry.
+	struct ZipInflateCheckpoint
+	{
+		/// \brief Uncompressed position the snapshot was taken at.
+		int64_t position;
+
+		/// \brief Offset into the compressed data where inflate continues.
+		int64_t compressed_position;
+
+		tinfl_decompressor decompressor;
+		size_t dict_offset;
+		std::unique_ptr<unsigned char[]> dict;
+	};
+
+	/// \brief Inflate checkpoints for a deflated entry, shared by all devices opened on it.
+	class ZipSeekIndex
+	{
+	public:
+		ZipSeekIndex(int64_t interval) : interval(interval) { }
+
+		/// \brief Distance in uncompressed bytes between checkpoints.
+		const int64_t interval;
+
+		std::mutex mutex;
+
+		/// \brief Checkpoints sorted by position.
+		std::vector<std::shared_ptr<ZipInflateCheckpoint>> checkpoints;
+	};
+}
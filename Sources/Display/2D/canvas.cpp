@@ -237,6 +237,16 @@ namespace clan
 		impl->flush();
 	}
 
+	CanvasBatchStatistics Canvas::get_batch_statistics() const
+	{
+		return impl->batcher.get_triangle_batcher()->get_statistics();
+	}
+
+	void Canvas::reset_batch_statistics()
+	{
+		impl->batcher.get_triangle_batcher()->reset_statistics();
+	}
+
 	void Canvas::set_transform(const Mat4f &matrix)
 	{
 		impl->set_transform(matrix);
@@ -33,6 +33,11 @@
 #include "../Font/font_impl.h"
 #include "canvas_impl.h"
 #include "render_batch_path.h"
+#include "path_rasterizer.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Core/System/exception.h"
+#include <algorithm>
+#include <cmath>
 
 namespace clan
 {
@@ -216,6 +221,92 @@ namespace clan
 		batcher->fill(canvas, *this, brush);
 	}
 
+	// Rounded division by 255 for values up to 255 * 255
+	static inline unsigned int div255(unsigned int value)
+	{
+		return ((value + 128) * 257) >> 16;
+	}
+
+	void Path::fill(PixelBuffer &pixels, const Colorf &color)
+	{
+		TextureFormat format = pixels.get_format();
+		if (format != tf_rgba8 && format != tf_bgra8)
+			throw Exception("Path::fill only supports tf_rgba8 and tf_bgra8 pixel buffers");
+
+		// Only rasterize the part of the pixel buffer covered by the path. The curve control points bound the curves.
+		Rectf bounds(1e30f, 1e30f, -1e30f, -1e30f);
+		for (const auto &subpath : impl->subpaths)
+		{
+			for (const auto &point : subpath.points)
+			{
+				bounds.left = std::min(bounds.left, point.x);
+				bounds.top = std::min(bounds.top, point.y);
+				bounds.right = std::max(bounds.right, point.x);
+				bounds.bottom = std::max(bounds.bottom, point.y);
+			}
+		}
+
+		int x0 = std::max(static_cast<int>(std::floor(bounds.left)), 0);
+		int y0 = std::max(static_cast<int>(std::floor(bounds.top)), 0);
+		int x1 = std::min(static_cast<int>(std::ceil(bounds.right)) + 1, pixels.get_width());
+		int y1 = std::min(static_cast<int>(std::ceil(bounds.bottom)) + 1, pixels.get_height());
+		if (x0 >= x1 || y0 >= y1)
+			return;
+
+		PathRasterizer rasterizer;
+		rasterizer.set_size(x1 - x0, y1 - y0);
+		PathRasterizerRenderer renderer(&rasterizer, static_cast<float>(x0), static_cast<float>(y0));
+		renderer.render(*this);
+
+		Colorf clamped(clamp(color.r, 0.0f, 1.0f), clamp(color.g, 0.0f, 1.0f), clamp(color.b, 0.0f, 1.0f), clamp(color.a, 0.0f, 1.0f));
+		unsigned int red = static_cast<unsigned int>(clamped.r * 255.0f + 0.5f);
+		unsigned int green = static_cast<unsigned int>(clamped.g * 255.0f + 0.5f);
+		unsigned int blue = static_cast<unsigned int>(clamped.b * 255.0f + 0.5f);
+		unsigned int alpha = static_cast<unsigned int>(clamped.a * 255.0f + 0.5f);
+		unsigned int src[4];
+		if (format == tf_rgba8)
+		{
+			src[0] = red; src[1] = green; src[2] = blue;
+		}
+		else
+		{
+			src[0] = blue; src[1] = green; src[2] = red;
+		}
+		src[3] = 255;
+
+		std::vector<unsigned char> coverage(rasterizer.get_width());
+		for (int y = rasterizer.get_first_row(); y < rasterizer.get_last_row(); y++)
+		{
+			int left, right;
+			rasterizer.find_extent(y, y + 1, left, right);
+			if (left >= right)
+				continue;
+			left = left / 16 * 16;
+			right = std::min((right + 15) / 16 * 16, rasterizer.get_width());
+
+			float carry = 0.0f;
+			rasterizer.sweep_span(y, left, right, impl->fill_mode, carry, coverage.data());
+			rasterizer.clear_rows(y, y + 1, right);
+
+			int end = std::min(right, x1 - x0);
+			unsigned char *line = pixels.get_data_uint8() + pixels.get_pitch() * (y0 + y) + (x0 + left) * 4;
+			for (int x = left; x < end; x++, line += 4)
+			{
+				unsigned int a = div255(coverage[x - left] * alpha);
+				if (a == 255)
+				{
+					line[0] = src[0]; line[1] = src[1]; line[2] = src[2]; line[3] = 255;
+				}
+				else if (a != 0)
+				{
+					unsigned int inv_a = 255 - a;
+					for (int c = 0; c < 4; c++)
+						line[c] = div255(src[c] * a + line[c] * inv_a);
+				}
+			}
+		}
+	}
+
 	void Path::fill_and_stroke(Canvas &canvas, const Pen &pen, const Brush &brush)
 	{
 		RenderBatchPath *batcher = canvas.impl->batcher.get_path_batcher();
@@ -62,77 +62,32 @@ namespace clan
 		{
 			width = new_width;
 			height = new_height;
-			scanlines.resize(height * antialias_level);
-			first_scanline = scanlines.size();
-			last_scanline = 0;
+			rasterizer.set_size(width, height);
 		}
 	}
 
 	void PathFillRenderer::clear()
 	{
-		for (size_t y = first_scanline; y < last_scanline; y++)
-		{
-			auto &scanline = scanlines[y];
-			if (!scanline.edges.empty())
-			{
-				scanline.edges.clear();
-			}
-		}
-
-		first_scanline = scanlines.size();
-		last_scanline = 0;
+		rasterizer.clear();
 	}
 
-	void PathFillRenderer::end(bool close)
+	void PathFillRenderer::end(bool /*close*/)
 	{
-		if (close)
-		{
-			line(start_x, start_y);
-		}
+		// Filling always treats a subpath as closed
+		line(start_x, start_y);
 	}
 
 	void PathFillRenderer::line(float x1, float y1)
 	{
-		float x0 = last_x;
-		float y0 = last_y;
+		rasterizer.line(last_x, last_y, x1, y1);
 
 		last_x = x1;
 		last_y = y1;
-
-		x0 *= static_cast<float>(antialias_level);
-		x1 *= static_cast<float>(antialias_level);
-		y0 *= static_cast<float>(antialias_level);
-		y1 *= static_cast<float>(antialias_level);
-
-		bool up_direction = y1 < y0;
-		float dy = y1 - y0;
-
-		const float epsilon = std::numeric_limits<float>::epsilon();
-		if (dy < -epsilon || dy > epsilon)
-		{
-			int start_y = static_cast<int>(std::floor(min(y0, y1) + 0.5f));
-			int end_y = static_cast<int>(std::floor(max(y0, y1) - 0.5f)) + 1;
-
-			start_y = max(start_y, 0);
-			end_y = min(end_y, height * antialias_level);
-
-			float rcp_dy = 1.0f / dy;
-
-			first_scanline = std::min(first_scanline, start_y);
-			last_scanline = std::max(last_scanline, end_y);
-
-			for (int y = start_y; y < end_y; y++)
-			{
-				float ypos = y + 0.5f;
-				float x = x0 + (x1 - x0) * (ypos - y0) * rcp_dy;
-				scanlines[y].insert_sorted(PathScanlineEdge(x, up_direction));
-			}
-		}
 	}
 
 	void PathFillRenderer::fill(Canvas &canvas, PathFillMode mode, const Brush &brush, const Mat4f &transform)
 	{
-		if (scanlines.empty()) return;
+		if (rasterizer.is_empty()) return;
 
 		initialise_buffers(canvas);
 		current_instance_offset = instances.push(canvas, brush, transform);
@@ -143,17 +98,20 @@ namespace clan
 			current_instance_offset = instances.push(canvas, brush, transform);
 		}
 
-		int max_width = canvas.get_gc().get_width() * antialias_level;
+		int max_width = min(canvas.get_gc().get_width(), width);
 
-		int start_y = first_scanline / scanline_block_size * scanline_block_size;
-		int end_y = (last_scanline + scanline_block_size - 1) / scanline_block_size * scanline_block_size;
+		int start_y = rasterizer.get_first_row() / mask_block_size * mask_block_size;
+		int end_y = rasterizer.get_last_row();
 
-		for (size_t y = start_y; y < end_y; y += scanline_block_size)
+		for (int y = start_y; y < end_y; y += mask_block_size)
 		{
-			mask_blocks.begin_row(&scanlines[y], mode);
-			Extent extent = find_extent(&scanlines[y], max_width);
+			int left, right;
+			rasterizer.find_extent(y, y + mask_block_size, left, right);
+			left = left / mask_block_size * mask_block_size;
+			right = min(right, max_width);
 
-			for (int xpos = extent.left; xpos < extent.right; xpos += scanline_block_size)
+			mask_blocks.begin_row(&rasterizer, y, mode);
+			for (int xpos = left; xpos < right; xpos += mask_block_size)
 			{
 				if (vertices.is_full() || mask_blocks.is_full())
 				{
@@ -164,33 +122,13 @@ namespace clan
 
 				if (mask_blocks.fill_block(xpos))
 				{
-					vertices.push(xpos / antialias_level, y / antialias_level, current_instance_offset, mask_blocks.block_index);
+					vertices.push(xpos, y, current_instance_offset, mask_blocks.block_index);
 				}
 			}
-		}
-	}
-
-	PathFillRenderer::Extent PathFillRenderer::find_extent(const PathScanline *scanline, int max_width)
-	{
-		// Find scanline extents
-		Extent extent;
-		for (unsigned int cnt = 0; cnt < scanline_block_size; cnt++, scanline++)
-		{
-			if (scanline->edges.empty())
-				continue;
-
-			if (scanline->edges[0].x < extent.left)
-				extent.left = scanline->edges[0].x;
 
-			if (scanline->edges[scanline->edges.size() - 1].x > extent.right)
-				extent.right = scanline->edges[scanline->edges.size() - 1].x;
+			// Forget whatever lies beyond the right edge of the canvas
+			rasterizer.clear_rows(y, y + mask_block_size, right);
 		}
-		if (extent.left < 0)
-			extent.left = 0;
-		if (extent.right > max_width)
-			extent.right = max_width;
-
-		return extent;
 	}
 
 	void PathFillRenderer::flush(GraphicContext &gc)
@@ -274,55 +212,6 @@ namespace clan
 
 	/////////////////////////////////////////////////////////////////////////////
 
-	void PathRasterRange::begin(const PathScanline *new_scanline, PathFillMode new_mode)
-	{
-		scanline = new_scanline;
-		mode = new_mode;
-		found = false;
-		i = 0;
-		nonzero_rule = 0;
-		next();
-	}
-
-	void PathRasterRange::next()
-	{
-		if (i + 1 >= scanline->edges.size())
-		{
-			found = false;
-			return;
-		}
-
-		if (mode == PathFillMode::alternate)
-		{
-			x0 = static_cast<int>(scanline->edges[i].x + 0.5f);
-			x1 = static_cast<int>(scanline->edges[i + 1].x - 0.5f) + 1;
-			i += 2;
-			found = true;
-		}
-		else
-		{
-			x0 = static_cast<int>(scanline->edges[i].x + 0.5f);
-			nonzero_rule += scanline->edges[i].up_direction ? 1 : -1;
-			i++;
-
-			while (i < scanline->edges.size())
-			{
-				nonzero_rule += scanline->edges[i].up_direction ? 1 : -1;
-				x1 = static_cast<int>(scanline->edges[i].x - 0.5f) + 1;
-				i++;
-
-				if (nonzero_rule == 0)
-				{
-					found = true;
-					return;
-				}
-			}
-			found = false;
-		}
-	}
-
-	/////////////////////////////////////////////////////////////////////////
-
 	PathMaskBuffer::PathMaskBuffer()
 	{
 #ifdef __SSE2__
@@ -372,211 +261,80 @@ namespace clan
 #endif
 	}
 
-	void PathMaskBuffer::begin_row(PathScanline *scanlines, PathFillMode mode)
+	void PathMaskBuffer::begin_row(PathRasterizer *new_rasterizer, int new_ypos, PathFillMode new_mode)
 	{
-		for (unsigned int cnt = 0; cnt < scanline_block_size; cnt++)
-		{
-			range[cnt].begin(&scanlines[cnt], mode);
-		}
+		rasterizer = new_rasterizer;
+		ypos = new_ypos;
+		mode = new_mode;
+		for (auto &elem : carry)
+			elem = 0.0f;
 	}
 
-#ifdef __SSE2__
 	bool PathMaskBuffer::fill_block(int xpos)
 	{
-		if (is_full_block(xpos))
-		{
-			fill_full_block();
-			return true;
-		}
-
-		const int block_size = mask_block_size / 16 * mask_block_size;
-		__m128i block[block_size];
-
-		for (auto & elem : block)
-			elem = _mm_setzero_si128();
-
-		for (unsigned int cnt = 0; cnt < scanline_block_size; cnt++)
-		{
-			__m128i *line = &block[mask_block_size / 16 * (cnt / antialias_level)];
-
-			while (range[cnt].found)
-			{
-				int x0 = range[cnt].x0;
-				if (x0 >= xpos + scanline_block_size)
-					break;
-				int x1 = range[cnt].x1;
-
-				x0 = max(x0, xpos);
-				x1 = min(x1, xpos + scanline_block_size);
-
-				if (x0 >= x1)	// Done segment
-				{
-					range[cnt].next();
-				}
-				else
-				{
-					for (int sse_block = 0; sse_block < mask_block_size / 16; sse_block++)
-					{
-						for (int alias_cnt = 0; alias_cnt < (antialias_level); alias_cnt++)
-						{
-							__m128i start = _mm_set1_epi8((x0 + alias_cnt - xpos) / antialias_level - 16 * sse_block);
-							__m128i end = _mm_set1_epi8((x1 + alias_cnt - xpos) / antialias_level - 16 * sse_block);
-							__m128i x = _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
-
-							__m128i left = _mm_cmplt_epi8(x, start);
-							__m128i right = _mm_cmplt_epi8(x, end);
-							__m128i mask = _mm_andnot_si128(left, right);
-							__m128i add_value = _mm_and_si128(mask, _mm_set1_epi8(256 / (antialias_level*antialias_level)));
-
-							line[sse_block] = _mm_adds_epu8(line[sse_block], add_value);
-						}
-					}
-
-					range[cnt].x0 = x1;	// For next time
-				}
-			}
-		}
-
-		__m128i empty_status = _mm_setzero_si128();
-		for (auto & elem : block)
-			empty_status = _mm_or_si128(empty_status, elem);
-
-		bool empty_block = _mm_movemask_epi8(_mm_cmpeq_epi32(empty_status, _mm_setzero_si128())) == 0xffff;
-		if (empty_block) return false;
-
 		int block_x = (next_block * mask_block_size) % mask_texture_size;
-		int block_y = ((next_block * mask_block_size) / mask_texture_size)* mask_block_size;
 
+#ifdef __SSE2__
+		unsigned char *block = mask_row_block_data + block_x;
+		int pitch = mask_texture_size;
+
+		__m128i any_coverage = _mm_setzero_si128();
+		__m128i full_coverage = _mm_set1_epi32(-1);
 		for (unsigned int cnt = 0; cnt < mask_block_size; cnt++)
 		{
-			__m128i *input = &block[mask_block_size / 16 * cnt];
-			__m128i *output = (__m128i*)(mask_row_block_data + cnt * mask_texture_size + block_x);
-
+			unsigned char *line = block + pitch * cnt;
+			rasterizer->sweep_span(ypos + cnt, xpos, xpos + mask_block_size, mode, carry[cnt], line);
 			for (int sse_block = 0; sse_block < mask_block_size / 16; sse_block++)
-				_mm_store_si128(&output[sse_block], input[sse_block]);
-		}
-
-		if (((next_block + 1) % (mask_texture_size / mask_block_size) == 0))
-			flush_block();
-
-		block_index = next_block++;
-		return true;
-	}
-
-	void PathMaskBuffer::fill_full_block()
-	{
-		if (!found_filled_block)
-		{
-			int block_x = (next_block * mask_block_size) % mask_texture_size;
-
-			for (unsigned int cnt = 0; cnt < mask_block_size; cnt++)
 			{
-				__m128i *line = (__m128i*)(mask_row_block_data + mask_texture_size * cnt + block_x);
-				for (int sse_block = 0; sse_block < mask_block_size / 16; sse_block++)
-				{
-					_mm_store_si128(&line[sse_block], _mm_set1_epi32(-1));
-				}
+				__m128i value = _mm_load_si128((__m128i*)line + sse_block);
+				any_coverage = _mm_or_si128(any_coverage, value);
+				full_coverage = _mm_and_si128(full_coverage, value);
 			}
-			if (((next_block + 1) % (mask_texture_size / mask_block_size) == 0))
-				flush_block();
-
-			found_filled_block = true;
-			filled_block_index = next_block++;
 		}
 
-		block_index = filled_block_index;
-	}
-
+		bool empty_block = _mm_movemask_epi8(_mm_cmpeq_epi8(any_coverage, _mm_setzero_si128())) == 0xffff;
+		bool full_block = _mm_movemask_epi8(_mm_cmpeq_epi8(full_coverage, _mm_set1_epi32(-1))) == 0xffff;
 #else
-	bool PathMaskBuffer::fill_block(int xpos)
-	{
-		if (is_full_block(xpos))
-		{
-			fill_full_block();
-			return true;
-		}
-
-		int block_x = (next_block * mask_block_size) % mask_texture_size;
-		int block_y = ((next_block * mask_block_size) / mask_texture_size)* mask_block_size;
+		int block_y = ((next_block * mask_block_size) / mask_texture_size) * mask_block_size;
+		unsigned char *block = mask_buffer_data + mask_buffer_pitch * block_y + block_x;
+		int pitch = mask_buffer_pitch;
 
+		unsigned char any_coverage = 0;
+		unsigned char full_coverage = 255;
 		for (unsigned int cnt = 0; cnt < mask_block_size; cnt++)
 		{
-			unsigned char *line = mask_buffer_data + mask_buffer_pitch * (block_y + cnt) + block_x;
-			memset(line, 0, mask_block_size);
-		}
-
-		bool empty_block = true;
-		for (unsigned int cnt = 0; cnt < scanline_block_size; cnt++)
-		{
-			unsigned char *line = mask_buffer_data + mask_buffer_pitch * (block_y + cnt / antialias_level) + block_x;
-			while (range[cnt].found)
+			unsigned char *line = block + pitch * cnt;
+			rasterizer->sweep_span(ypos + cnt, xpos, xpos + mask_block_size, mode, carry[cnt], line);
+			for (int i = 0; i < mask_block_size; i++)
 			{
-				int x0 = range[cnt].x0;
-				if (x0 >= xpos + scanline_block_size)
-					break;
-				int x1 = range[cnt].x1;
-
-				x0 = max(x0, xpos);
-				x1 = min(x1, xpos + scanline_block_size);
-
-				if (x0 >= x1)	// Done segment
-				{
-					range[cnt].next();
-				}
-				else
-				{
-					empty_block = false;
-					for (int x = x0 - xpos; x < x1 - xpos; x++)
-					{
-						int pixel = line[x / antialias_level];
-						pixel = min(pixel + (256 / (antialias_level*antialias_level)), 255);
-						line[x / antialias_level] = pixel;
-					}
-					range[cnt].x0 = x1;	// For next time
-				}
+				any_coverage |= line[i];
+				full_coverage &= line[i];
 			}
 		}
 
-		if (!empty_block)
-			block_index = next_block++;
-		return !empty_block;
-	}
+		bool empty_block = any_coverage == 0;
+		bool full_block = full_coverage == 255;
+#endif
 
-	void PathMaskBuffer::fill_full_block()
-	{
-		if (!found_filled_block)
-		{
-			int block_x = (next_block * mask_block_size) % mask_texture_size;
-			int block_y = ((next_block * mask_block_size) / mask_texture_size)* mask_block_size;
+		// Empty blocks are skipped and a block slot with full coverage is shared by all filled blocks
+		if (empty_block)
+			return false;
 
-			for (unsigned int cnt = 0; cnt < mask_block_size; cnt++)
+		if (full_block)
+		{
+			if (found_filled_block)
 			{
-				unsigned char *line = mask_buffer_data + mask_buffer_pitch * (block_y + cnt) + block_x;
-				for (unsigned int i = 0; i < mask_block_size; i++)
-					line[i] = 255;
+				block_index = filled_block_index;
+				return true;
 			}
-
 			found_filled_block = true;
-			filled_block_index = next_block++;
+			filled_block_index = next_block;
 		}
 
-		block_index = filled_block_index;
-	}
-#endif
+		if (((next_block + 1) % (mask_texture_size / mask_block_size) == 0))
+			flush_block();
 
-	bool PathMaskBuffer::is_full_block(int xpos) const
-	{
-		for (auto & elem : range)
-		{
-			if (!elem.found)
-			{
-				return false;
-			}
-			if ((elem.x0 > xpos) || (elem.x1 < (xpos + scanline_block_size - 1)))
-			{
-				return false;
-			}
-		}
+		block_index = next_block++;
 		return true;
 	}
 
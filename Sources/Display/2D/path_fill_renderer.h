@@ -43,43 +43,14 @@
 #include "API/Display/Render/program_object.h"
 #include "render_batch_buffer.h"
 #include "path_renderer.h"
+#include "path_rasterizer.h"
 
 namespace clan
 {
 	enum class PathFillMode;
 	class Brush;
-	class PathRasterRange;
 	class PathMaskBuffer;
 
-	class PathScanlineEdge
-	{
-	public:
-		PathScanlineEdge() { }
-		PathScanlineEdge(float x, bool up_direction) : x(x), up_direction(up_direction) { }
-
-		float x = 0.0f;
-		bool up_direction = false;
-	};
-
-	class PathScanline
-	{
-	public:
-		std::vector<PathScanlineEdge> edges;
-		std::vector<unsigned char> pixels;
-
-		void insert_sorted(PathScanlineEdge edge)
-		{
-			edges.push_back(edge);
-
-			for (size_t pos = edges.size() - 1; pos > 0 && edges[pos - 1].x >= edge.x; pos--)
-			{
-				PathScanlineEdge temp = edges[pos - 1];
-				edges[pos - 1] = edges[pos];
-				edges[pos] = temp;
-			}
-		}
-	};
-
 	class PathInstanceBuffer
 	{
 	public:
@@ -134,32 +105,13 @@ namespace clan
 
 	namespace PathConstants
 	{
-		static const int antialias_level = 2;
 		static const int mask_block_size = 16;		// *** If changing this, remember to modify the path shaders ***
-		static const int scanline_block_size = mask_block_size * antialias_level;
 		static const int mask_texture_size = RenderBatchBuffer::r8_size;
 		static const int max_blocks = (mask_texture_size / mask_block_size) * (mask_texture_size / mask_block_size);
 		static const int instance_buffer_width = RenderBatchBuffer::rgba32f_width;   // In rgbaf blocks
 		static const int instance_buffer_height = RenderBatchBuffer::rgba32f_height; // In rgbaf blocks
 	};
 
-	class PathRasterRange
-	{
-	public:
-		void begin(const PathScanline *scanline, PathFillMode mode);
-		void next();
-
-		bool found = false;
-		int x0;
-		int x1;
-
-	private:
-		const PathScanline *scanline = nullptr;
-		PathFillMode mode;
-		size_t i = 0;
-		int nonzero_rule = 0;
-	};
-
 	class PathMaskBuffer
 	{
 	public:
@@ -173,17 +125,17 @@ namespace clan
 		void reset(unsigned char *mask_buffer_data, int mask_buffer_pitch);
 		void flush_block();
 
-		void begin_row(PathScanline *scanlines, PathFillMode mode);
+		void begin_row(PathRasterizer *rasterizer, int ypos, PathFillMode mode);
 		bool fill_block(int xpos);
 
 		int block_index = 0;
 		int next_block = 0;
 
 	private:
-		bool is_full_block(int xpos) const;
-		void fill_full_block();
-
-		PathRasterRange range[PathConstants::scanline_block_size];
+		PathRasterizer *rasterizer = nullptr;
+		PathFillMode mode = PathFillMode::alternate;
+		int ypos = 0;
+		float carry[PathConstants::mask_block_size];
 
 		unsigned char *mask_buffer_data = nullptr;
 		int mask_buffer_pitch = 0;
@@ -213,27 +165,13 @@ namespace clan
 		const float rcp_mask_texture_size = 1.0f / (float)PathConstants::mask_texture_size;
 
 	private:
-		void insert_sorted(PathScanline &scanline, const PathScanlineEdge &edge);
-
 		void initialise_buffers(Canvas &canvas);
 
 		TextureImageYAxis image_yaxis = y_axis_top_down;
 
-		struct Extent
-		{
-			Extent() : left(INT_MAX), right(0){}
-			int left;
-			int right;
-		};
-
-		Extent find_extent(const PathScanline *scanline, int max_width);
-
-		int first_scanline = 0;
-		int last_scanline = 0;
-
 		int width = 0;
 		int height = 0;
-		std::vector<PathScanline> scanlines;
+		PathRasterizer rasterizer;
 
 		class Block
 		{
@@ -0,0 +1,331 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "path_rasterizer.h"
+#include "path_impl.h"
+#include "API/Core/System/system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if !defined __ANDROID__ && ! defined CL_DISABLE_SSE2
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+namespace clan
+{
+	PathRasterizer::PathRasterizer()
+	{
+	}
+
+	PathRasterizer::~PathRasterizer()
+	{
+		System::aligned_free(accumulation);
+	}
+
+	void PathRasterizer::set_size(int new_width, int new_height)
+	{
+		new_width = (std::max(new_width, 0) + 15) / 16 * 16;
+		new_height = std::max(new_height, 0);
+		if (accumulation && width == new_width && height == new_height)
+			return;
+
+		System::aligned_free(accumulation);
+		accumulation = nullptr;
+
+		width = new_width;
+		height = new_height;
+
+		// Lines on the right border write up to two cells past the width
+		stride = width + 16;
+		size_t size = sizeof(float) * stride * std::max(height, 1);
+		accumulation = static_cast<float*>(System::aligned_alloc(size));
+		memset(accumulation, 0, size);
+
+		row_min.assign(height, INT_MAX);
+		row_max.assign(height, 0);
+		first_row = height;
+		last_row = 0;
+	}
+
+	void PathRasterizer::line(float x0, float y0, float x1, float y1)
+	{
+		if (y0 == y1 || !accumulation)
+			return;
+
+		// Split the line where it crosses the left and right borders.
+		// The parts outside are moved onto the border, which keeps the winding correct for the pixels inside.
+		float w = static_cast<float>(width);
+		float t[4] = { 0.0f, 1.0f, 1.0f, 1.0f };
+		int count = 1;
+		float dx = x1 - x0;
+		if ((x0 < 0.0f) != (x1 < 0.0f))
+			t[count++] = -x0 / dx;
+		if ((x0 < w) != (x1 < w))
+			t[count++] = (w - x0) / dx;
+		if (count == 3 && t[2] < t[1])
+			std::swap(t[1], t[2]);
+
+		float dy = y1 - y0;
+		float last_x = std::min(std::max(x0, 0.0f), w);
+		float last_y = y0;
+		for (int i = 1; i <= count; i++)
+		{
+			float next_x = (i == count) ? x1 : x0 + dx * t[i];
+			float next_y = (i == count) ? y1 : y0 + dy * t[i];
+			next_x = std::min(std::max(next_x, 0.0f), w);
+			accumulate_line(last_x, last_y, next_x, next_y);
+			last_x = next_x;
+			last_y = next_y;
+		}
+	}
+
+	void PathRasterizer::accumulate_line(float x0, float y0, float x1, float y1)
+	{
+		if (y0 == y1)
+			return;
+
+		float dir = 1.0f;
+		if (y0 > y1)
+		{
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+			dir = -1.0f;
+		}
+
+		if (y1 <= 0.0f || y0 >= static_cast<float>(height))
+			return;
+
+		float w = static_cast<float>(width);
+		float dxdy = (x1 - x0) / (y1 - y0);
+		float x = x0;
+		if (y0 < 0.0f)
+			x -= y0 * dxdy;
+
+		int start_y = std::max(static_cast<int>(std::floor(y0)), 0);
+		int end_y = std::min(static_cast<int>(std::ceil(y1)), height);
+		first_row = std::min(first_row, start_y);
+		last_row = std::max(last_row, end_y);
+
+		for (int y = start_y; y < end_y; y++)
+		{
+			float *line = accumulation + y * stride;
+			float dy = std::min(static_cast<float>(y + 1), y1) - std::max(static_cast<float>(y), y0);
+			float xnext = std::min(std::max(x + dxdy * dy, 0.0f), w);
+			float d = dy * dir;
+
+			float left = std::min(x, xnext);
+			float right = std::max(x, xnext);
+			float left_floor = std::floor(left);
+			int left_i = static_cast<int>(left_floor);
+			float right_ceil = std::ceil(right);
+			int right_i = static_cast<int>(right_ceil);
+
+			if (right_i <= left_i + 1)
+			{
+				// The line stays within one cell
+				float xmf = 0.5f * (x + xnext) - left_floor;
+				line[left_i] += d - d * xmf;
+				line[left_i + 1] += d * xmf;
+				row_max[y] = std::max(row_max[y], left_i + 2);
+			}
+			else
+			{
+				float s = 1.0f / (right - left);
+				float left_f = left - left_floor;
+				float a0 = 0.5f * s * (1.0f - left_f) * (1.0f - left_f);
+				float right_f = right - right_ceil + 1.0f;
+				float am = 0.5f * s * right_f * right_f;
+
+				line[left_i] += d * a0;
+				if (right_i == left_i + 2)
+				{
+					line[left_i + 1] += d * (1.0f - a0 - am);
+				}
+				else
+				{
+					float a1 = s * (1.5f - left_f);
+					line[left_i + 1] += d * (a1 - a0);
+					for (int xi = left_i + 2; xi < right_i - 1; xi++)
+						line[xi] += d * s;
+					float a2 = a1 + (right_i - left_i - 3) * s;
+					line[right_i - 1] += d * (1.0f - a2 - am);
+				}
+				line[right_i] += d * am;
+				row_max[y] = std::max(row_max[y], right_i + 1);
+			}
+			row_min[y] = std::min(row_min[y], left_i);
+
+			x = xnext;
+		}
+	}
+
+	void PathRasterizer::find_extent(int y0, int y1, int &out_left, int &out_right) const
+	{
+		out_left = INT_MAX;
+		out_right = 0;
+		y0 = std::max(y0, first_row);
+		y1 = std::min(y1, last_row);
+		for (int y = y0; y < y1; y++)
+		{
+			out_left = std::min(out_left, row_min[y]);
+			out_right = std::max(out_right, row_max[y]);
+		}
+	}
+
+	void PathRasterizer::sweep_span(int y, int x0, int x1, PathFillMode mode, float &carry, unsigned char *out_coverage)
+	{
+		float *cells = accumulation + y * stride;
+
+#ifdef __SSE2__
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 sign_mask = _mm_set1_ps(-0.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		__m128 acc = _mm_set1_ps(carry);
+		for (int x = x0; x < x1; x += 16)
+		{
+			__m128i result[4];
+			for (int i = 0; i < 4; i++)
+			{
+				__m128 v = _mm_load_ps(cells + x + i * 4);
+				_mm_store_ps(cells + x + i * 4, zero);
+
+				// Prefix sum of the four cells, continuing from the previous value
+				v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+				v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+				v = _mm_add_ps(v, acc);
+				acc = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+
+				__m128 coverage = _mm_andnot_ps(sign_mask, v);
+				if (mode == PathFillMode::alternate)
+				{
+					// Fold the winding number into [0, 2) and then into a triangle wave
+					__m128 folds = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(coverage, half)));
+					coverage = _mm_sub_ps(coverage, _mm_mul_ps(folds, two));
+					coverage = _mm_sub_ps(one, _mm_andnot_ps(sign_mask, _mm_sub_ps(one, coverage)));
+				}
+				coverage = _mm_min_ps(coverage, one);
+				result[i] = _mm_cvtps_epi32(_mm_mul_ps(coverage, scale));
+			}
+
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(result[0], result[1]), _mm_packs_epi32(result[2], result[3]));
+			_mm_storeu_si128((__m128i*)(out_coverage + x - x0), packed);
+		}
+		_mm_store_ss(&carry, acc);
+#else
+		float acc = carry;
+		for (int x = x0; x < x1; x++)
+		{
+			acc += cells[x];
+			cells[x] = 0.0f;
+
+			float coverage = std::abs(acc);
+			if (mode == PathFillMode::alternate)
+			{
+				coverage -= 2.0f * static_cast<float>(static_cast<int>(coverage * 0.5f));
+				coverage = 1.0f - std::abs(1.0f - coverage);
+			}
+			coverage = std::min(coverage, 1.0f);
+			out_coverage[x - x0] = static_cast<unsigned char>(coverage * 255.0f + 0.5f);
+		}
+		carry = acc;
+#endif
+	}
+
+	void PathRasterizer::clear_rows(int y0, int y1, int x)
+	{
+		y0 = std::max(y0, first_row);
+		y1 = std::min(y1, last_row);
+		for (int y = y0; y < y1; y++)
+		{
+			int left = std::max(row_min[y], x);
+			if (left < row_max[y])
+				memset(accumulation + y * stride + left, 0, sizeof(float) * (row_max[y] - left));
+			row_min[y] = INT_MAX;
+			row_max[y] = 0;
+		}
+	}
+
+	void PathRasterizer::clear()
+	{
+		clear_rows(first_row, last_row);
+		first_row = height;
+		last_row = 0;
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	void PathRasterizerRenderer::line(float x, float y)
+	{
+		rasterizer->line(last_x - origin_x, last_y - origin_y, x - origin_x, y - origin_y);
+		last_x = x;
+		last_y = y;
+	}
+
+	void PathRasterizerRenderer::end(bool /*close*/)
+	{
+		// Filling always treats a subpath as closed
+		line(start_x, start_y);
+	}
+
+	void PathRasterizerRenderer::render(const Path &path)
+	{
+		for (const auto &subpath : path.get_impl()->subpaths)
+		{
+			begin(subpath.points[0].x, subpath.points[0].y);
+
+			size_t i = 1;
+			for (PathCommand command : subpath.commands)
+			{
+				if (command == PathCommand::line)
+				{
+					line(subpath.points[i].x, subpath.points[i].y);
+					i++;
+				}
+				else if (command == PathCommand::quadradic)
+				{
+					quadratic_bezier(subpath.points[i].x, subpath.points[i].y, subpath.points[i + 1].x, subpath.points[i + 1].y);
+					i += 2;
+				}
+				else if (command == PathCommand::cubic)
+				{
+					cubic_bezier(subpath.points[i].x, subpath.points[i].y, subpath.points[i + 1].x, subpath.points[i + 1].y, subpath.points[i + 2].x, subpath.points[i + 2].y);
+					i += 3;
+				}
+			}
+
+			end(subpath.closed);
+		}
+	}
+}
@@ -0,0 +1,111 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <climits>
+#include <vector>
+#include "API/Display/2D/path.h"
+#include "path_renderer.h"
+
+namespace clan
+{
+	/// \brief Signed area accumulation rasterizer
+	///
+	/// Every line adds its exact signed area contribution to an accumulation buffer with one float per pixel.
+	/// A prefix sum along each row then turns the accumulated values into winding numbers with analytic coverage.
+	/// Only cells touched by the path are visited, and they are zeroed while being read so the buffer is ready for the next path.
+	class PathRasterizer
+	{
+	public:
+		PathRasterizer();
+		~PathRasterizer();
+		PathRasterizer(const PathRasterizer &) = delete;
+		PathRasterizer &operator=(const PathRasterizer &) = delete;
+
+		/// \brief Resizes the accumulation buffer. Width is rounded up to a multiple of 16.
+		void set_size(int width, int height);
+
+		int get_width() const { return width; }
+		int get_height() const { return height; }
+
+		/// \brief Accumulates a line in pixel coordinates
+		void line(float x0, float y0, float x1, float y1);
+
+		bool is_empty() const { return first_row >= last_row; }
+		int get_first_row() const { return first_row; }
+		int get_last_row() const { return last_row; }
+
+		/// \brief Returns the touched cell range of rows [y0, y1) as [out_left, out_right)
+		void find_extent(int y0, int y1, int &out_left, int &out_right) const;
+
+		/// \brief Prefix sums the cells [x0, x1) of row y into 8 bit coverage values and zeroes the cells
+		///
+		/// carry holds the running winding value and must start at zero for each row.
+		/// x0 and x1 must be multiples of 16.
+		void sweep_span(int y, int x0, int x1, PathFillMode mode, float &carry, unsigned char *out_coverage);
+
+		/// \brief Zeroes the remaining cells of rows [y0, y1) from x and forgets them
+		void clear_rows(int y0, int y1, int x = 0);
+
+		/// \brief Zeroes all touched cells
+		void clear();
+
+	private:
+		void accumulate_line(float x0, float y0, float x1, float y1);
+
+		float *accumulation = nullptr;
+		int stride = 0;
+		int width = 0;
+		int height = 0;
+
+		std::vector<int> row_min;
+		std::vector<int> row_max;
+		int first_row = 0;
+		int last_row = 0;
+	};
+
+	/// \brief Path renderer feeding the lines of a path into a PathRasterizer
+	class PathRasterizerRenderer : public PathRenderer
+	{
+	public:
+		/// \brief Constructs the renderer. The origin is subtracted from all path coordinates.
+		PathRasterizerRenderer(PathRasterizer *rasterizer, float origin_x = 0.0f, float origin_y = 0.0f) : rasterizer(rasterizer), origin_x(origin_x), origin_y(origin_y) { }
+
+		void line(float x, float y) override;
+		void end(bool close) override;
+
+		/// \brief Renders all subpaths of a path
+		void render(const Path &path);
+
+	private:
+		PathRasterizer *rasterizer;
+		float origin_x;
+		float origin_y;
+	};
+}
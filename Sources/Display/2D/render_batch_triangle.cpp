@@ -44,18 +44,16 @@ namespace clan
 		: batch_buffer(batch_buffer)
 	{
 		vertices = (SpriteVertex *)batch_buffer->buffer;
+		quad_vertices = (QuadVertex *)batch_buffer->buffer;
+
+		// The fixed function target cannot draw indexed primitives
+		quad_format_supported = gc.get_shader_language() != shader_fixed_function;
 	}
 
 	void RenderBatchTriangle::draw_sprite(Canvas &canvas, const Pointf texture_position[4], const Pointf dest_position[4], const Texture2D &texture, const Colorf &color)
 	{
-		int texindex = set_batcher_active(canvas, texture);
-
-		to_sprite_vertex(texture_position[0], dest_position[0], vertices[position++], texindex, color);
-		to_sprite_vertex(texture_position[1], dest_position[1], vertices[position++], texindex, color);
-		to_sprite_vertex(texture_position[2], dest_position[2], vertices[position++], texindex, color);
-		to_sprite_vertex(texture_position[1], dest_position[1], vertices[position++], texindex, color);
-		to_sprite_vertex(texture_position[3], dest_position[3], vertices[position++], texindex, color);
-		to_sprite_vertex(texture_position[2], dest_position[2], vertices[position++], texindex, color);
+		int texindex = set_batcher_active(canvas, texture, select_format(texture_position, color));
+		add_quad(dest_position, texture_position, color, texindex);
 	}
 
 	void RenderBatchTriangle::fill_triangle(Canvas &canvas, const Vec2f *triangle_positions, const Vec4f *triangle_colors, int num_vertices)
@@ -92,7 +90,7 @@ namespace clan
 
 	void RenderBatchTriangle::fill_triangles(Canvas &canvas, const Vec2f *positions, const Vec2f *texture_positions, int num_vertices, const Texture2D &texture, const Colorf &color)
 	{
-		int texindex = set_batcher_active(canvas, texture);
+		int texindex = set_batcher_active(canvas, texture, format_sprite);
 
 		for (; num_vertices > 0; num_vertices--)
 		{
@@ -108,7 +106,7 @@ namespace clan
 
 	void RenderBatchTriangle::fill_triangles(Canvas &canvas, const Vec2f *positions, const Vec2f *texture_positions, int num_vertices, const Texture2D &texture, const Colorf *colors)
 	{
-		int texindex = set_batcher_active(canvas, texture);
+		int texindex = set_batcher_active(canvas, texture, format_sprite);
 
 		for (; num_vertices > 0; num_vertices--)
 		{
@@ -131,105 +129,103 @@ namespace clan
 
 	void RenderBatchTriangle::draw_image(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture)
 	{
-		int texindex = set_batcher_active(canvas, texture);
-
-		vertices[position + 0].position = to_position(dest.left, dest.top);
-		vertices[position + 1].position = to_position(dest.right, dest.top);
-		vertices[position + 2].position = to_position(dest.left, dest.bottom);
-		vertices[position + 3].position = to_position(dest.right, dest.top);
-		vertices[position + 4].position = to_position(dest.right, dest.bottom);
-		vertices[position + 5].position = to_position(dest.left, dest.bottom);
-		float src_left = (src.left) / tex_sizes[texindex].width;
-		float src_top = (src.top) / tex_sizes[texindex].height;
-		float src_right = (src.right) / tex_sizes[texindex].width;
-		float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-		vertices[position + 0].texcoord = Vec2f(src_left, src_top);
-		vertices[position + 1].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 2].texcoord = Vec2f(src_left, src_bottom);
-		vertices[position + 3].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 4].texcoord = Vec2f(src_right, src_bottom);
-		vertices[position + 5].texcoord = Vec2f(src_left, src_bottom);
-		for (int i = 0; i < 6; i++)
-		{
-			vertices[position + i].color = Vec4f(color.r, color.g, color.b, color.a);
-			vertices[position + i].texindex = texindex;
-		}
-		position += 6;
+		Pointf texture_positions[4];
+		to_texture_positions(src, texture, texture_positions);
+		Pointf dest_positions[4] = { Pointf(dest.left, dest.top), Pointf(dest.right, dest.top), Pointf(dest.left, dest.bottom), Pointf(dest.right, dest.bottom) };
+
+		int texindex = set_batcher_active(canvas, texture, select_format(texture_positions, color));
+		add_quad(dest_positions, texture_positions, color, texindex);
 	}
 
 	void RenderBatchTriangle::draw_image(Canvas &canvas, const Rectf &src, const Quadf &dest, const Colorf &color, const Texture2D &texture)
 	{
-		int texindex = set_batcher_active(canvas, texture);
-
-		vertices[position + 0].position = to_position(dest.p.x, dest.p.y);
-		vertices[position + 1].position = to_position(dest.q.x, dest.q.y);
-		vertices[position + 2].position = to_position(dest.s.x, dest.s.y);
-		vertices[position + 3].position = to_position(dest.q.x, dest.q.y);
-		vertices[position + 4].position = to_position(dest.r.x, dest.r.y);
-		vertices[position + 5].position = to_position(dest.s.x, dest.s.y);
-		float src_left = (src.left) / tex_sizes[texindex].width;
-		float src_top = (src.top) / tex_sizes[texindex].height;
-		float src_right = (src.right) / tex_sizes[texindex].width;
-		float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-		vertices[position + 0].texcoord = Vec2f(src_left, src_top);
-		vertices[position + 1].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 2].texcoord = Vec2f(src_left, src_bottom);
-		vertices[position + 3].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 4].texcoord = Vec2f(src_right, src_bottom);
-		vertices[position + 5].texcoord = Vec2f(src_left, src_bottom);
-		for (int i = 0; i < 6; i++)
-		{
-			vertices[position + i].color = Vec4f(color.r, color.g, color.b, color.a);
-			vertices[position + i].texindex = texindex;
-		}
-		position += 6;
+		Pointf texture_positions[4];
+		to_texture_positions(src, texture, texture_positions);
+		Pointf dest_positions[4] = { dest.p, dest.q, dest.s, dest.r };
+
+		int texindex = set_batcher_active(canvas, texture, select_format(texture_positions, color));
+		add_quad(dest_positions, texture_positions, color, texindex);
 	}
 
 	void RenderBatchTriangle::draw_glyph_subpixel(Canvas &canvas, const Rectf &src, const Rectf &dest, const Colorf &color, const Texture2D &texture)
 	{
-		int texindex = set_batcher_active(canvas, texture, true, color);
-
-		vertices[position + 0].position = to_position(dest.left, dest.top);
-		vertices[position + 1].position = to_position(dest.right, dest.top);
-		vertices[position + 2].position = to_position(dest.left, dest.bottom);
-		vertices[position + 3].position = to_position(dest.right, dest.top);
-		vertices[position + 4].position = to_position(dest.right, dest.bottom);
-		vertices[position + 5].position = to_position(dest.left, dest.bottom);
-		float src_left = (src.left) / tex_sizes[texindex].width;
-		float src_top = (src.top) / tex_sizes[texindex].height;
-		float src_right = (src.right) / tex_sizes[texindex].width;
-		float src_bottom = (src.bottom) / tex_sizes[texindex].height;
-		vertices[position + 0].texcoord = Vec2f(src_left, src_top);
-		vertices[position + 1].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 2].texcoord = Vec2f(src_left, src_bottom);
-		vertices[position + 3].texcoord = Vec2f(src_right, src_top);
-		vertices[position + 4].texcoord = Vec2f(src_right, src_bottom);
-		vertices[position + 5].texcoord = Vec2f(src_left, src_bottom);
-		for (int i = 0; i < 6; i++)
+		Pointf texture_positions[4];
+		to_texture_positions(src, texture, texture_positions);
+		Pointf dest_positions[4] = { Pointf(dest.left, dest.top), Pointf(dest.right, dest.top), Pointf(dest.left, dest.bottom), Pointf(dest.right, dest.bottom) };
+
+		int texindex = set_batcher_active(canvas, texture, select_format(texture_positions, StandardColorf::white()), true, color);
+		add_quad(dest_positions, texture_positions, StandardColorf::white(), texindex);
+	}
+
+	void RenderBatchTriangle::fill(Canvas &canvas, float x1, float y1, float x2, float y2, const Colorf &color)
+	{
+		Pointf texture_positions[4];
+		Pointf dest_positions[4] = { Pointf(x1, y1), Pointf(x2, y1), Pointf(x1, y2), Pointf(x2, y2) };
+
+		int texindex = set_batcher_active(canvas, select_format(texture_positions, color));
+		add_quad(dest_positions, texture_positions, color, texindex);
+	}
+
+	inline void RenderBatchTriangle::to_texture_positions(const Rectf &src, const Texture2D &texture, Pointf texture_positions[4]) const
+	{
+		float width = (float)texture.get_width();
+		float height = (float)texture.get_height();
+		float src_left = src.left / width;
+		float src_top = src.top / height;
+		float src_right = src.right / width;
+		float src_bottom = src.bottom / height;
+		texture_positions[0] = Pointf(src_left, src_top);
+		texture_positions[1] = Pointf(src_right, src_top);
+		texture_positions[2] = Pointf(src_left, src_bottom);
+		texture_positions[3] = Pointf(src_right, src_bottom);
+	}
+
+	RenderBatchTriangle::VertexFormat RenderBatchTriangle::select_format(const Pointf texture_positions[4], const Colorf &color) const
+	{
+		if (!quad_format_supported || !quad_format_matrix)
+			return format_sprite;
+
+		// Normalized texture coordinates and colors can only hold values in the 0-1 range
+		for (int i = 0; i < 4; i++)
 		{
-			vertices[position + i].color = Vec4f(1.0f, 1.0f, 1.0f, 1.0f);
-			vertices[position + i].texindex = texindex;
+			if (texture_positions[i].x < 0.0f || texture_positions[i].x > 1.0f || texture_positions[i].y < 0.0f || texture_positions[i].y > 1.0f)
+				return format_sprite;
 		}
-		position += 6;
+		if (color.r < 0.0f || color.r > 1.0f || color.g < 0.0f || color.g > 1.0f || color.b < 0.0f || color.b > 1.0f || color.a < 0.0f || color.a > 1.0f)
+			return format_sprite;
+
+		return format_quad;
 	}
 
-	void RenderBatchTriangle::fill(Canvas &canvas, float x1, float y1, float x2, float y2, const Colorf &color)
+	void RenderBatchTriangle::add_quad(const Pointf dest_positions[4], const Pointf texture_positions[4], const Colorf &color, int texindex)
 	{
-		int texindex = set_batcher_active(canvas);
-
-		vertices[position + 0].position = to_position(x1, y1);
-		vertices[position + 1].position = to_position(x2, y1);
-		vertices[position + 2].position = to_position(x1, y2);
-		vertices[position + 3].position = to_position(x2, y1);
-		vertices[position + 4].position = to_position(x2, y2);
-		vertices[position + 5].position = to_position(x1, y2);
-		for (int i = 0; i < 6; i++)
+		if (vertex_format == format_quad)
+		{
+			Vec4ub packed_color(
+				(unsigned char)(color.r * 255.0f + 0.5f),
+				(unsigned char)(color.g * 255.0f + 0.5f),
+				(unsigned char)(color.b * 255.0f + 0.5f),
+				(unsigned char)(color.a * 255.0f + 0.5f));
+
+			for (int i = 0; i < 4; i++)
+			{
+				QuadVertex &v = quad_vertices[position + i];
+				v.position = to_position_2d(dest_positions[i].x, dest_positions[i].y);
+				v.texcoord = Vec2us((unsigned short)(texture_positions[i].x * 65535.0f + 0.5f), (unsigned short)(texture_positions[i].y * 65535.0f + 0.5f));
+				v.color = packed_color;
+				v.texindex = (signed char)texindex;
+			}
+			position += 4;
+		}
+		else
 		{
-			vertices[position + i].color = Vec4f(color.r, color.g, color.b, color.a);
-			vertices[position + i].texcoord = Vec2f(0.0f, 0.0f);
-			vertices[position + i].texindex = texindex;
+			to_sprite_vertex(texture_positions[0], dest_positions[0], vertices[position++], texindex, color);
+			to_sprite_vertex(texture_positions[1], dest_positions[1], vertices[position++], texindex, color);
+			to_sprite_vertex(texture_positions[2], dest_positions[2], vertices[position++], texindex, color);
+			to_sprite_vertex(texture_positions[1], dest_positions[1], vertices[position++], texindex, color);
+			to_sprite_vertex(texture_positions[3], dest_positions[3], vertices[position++], texindex, color);
+			to_sprite_vertex(texture_positions[2], dest_positions[2], vertices[position++], texindex, color);
 		}
-		position += 6;
 	}
 
 	inline Vec4f RenderBatchTriangle::to_position(float x, float y) const
@@ -242,7 +238,31 @@ namespace clan
 	}
 
 
-	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program, const Colorf &new_constant_color)
+	inline Vec2f RenderBatchTriangle::to_position_2d(float x, float y) const
+	{
+		return Vec2f(
+			modelview_projection_matrix.matrix[0 * 4 + 0] * x + modelview_projection_matrix.matrix[1 * 4 + 0] * y + modelview_projection_matrix.matrix[3 * 4 + 0],
+			modelview_projection_matrix.matrix[0 * 4 + 1] * x + modelview_projection_matrix.matrix[1 * 4 + 1] * y + modelview_projection_matrix.matrix[3 * 4 + 1]);
+	}
+
+	void RenderBatchTriangle::set_vertex_format(Canvas &canvas, VertexFormat format)
+	{
+		if (vertex_format != format)
+		{
+			canvas.flush();
+			vertex_format = format;
+		}
+	}
+
+	bool RenderBatchTriangle::is_batch_full() const
+	{
+		if (vertex_format == format_quad)
+			return position + 4 > max_quad_vertices;
+		else
+			return position + 6 > max_vertices;
+	}
+
+	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, const Texture2D &texture, VertexFormat format, bool glyph_program, const Colorf &new_constant_color)
 	{
 		if (use_glyph_program != glyph_program || constant_color != new_constant_color)
 		{
@@ -250,6 +270,7 @@ namespace clan
 			use_glyph_program = glyph_program;
 			constant_color = new_constant_color;
 		}
+		set_vertex_format(canvas, format);
 
 		int texindex = -1;
 		for (int i = 0; i < num_current_textures; i++)
@@ -267,7 +288,7 @@ namespace clan
 			tex_sizes[texindex] = Sizef((float)current_textures[texindex].get_width(), (float)current_textures[texindex].get_height());
 		}
 
-		if (position == 0 || position + 6 > max_vertices || texindex == -1)
+		if (position == 0 || is_batch_full() || texindex == -1)
 		{
 			canvas.flush();
 			texindex = 0;
@@ -279,15 +300,16 @@ namespace clan
 		return texindex;
 	}
 
-	int RenderBatchTriangle::set_batcher_active(Canvas &canvas)
+	int RenderBatchTriangle::set_batcher_active(Canvas &canvas, VertexFormat format)
 	{
 		if (use_glyph_program != false)
 		{
 			canvas.flush();
 			use_glyph_program = false;
 		}
+		set_vertex_format(canvas, format);
 
-		if (position == 0 || position + 6 > max_vertices)
+		if (position == 0 || is_batch_full())
 			canvas.flush();
 		canvas.set_batcher(this);
 		return RenderBatchTriangle::max_textures;
@@ -300,6 +322,7 @@ namespace clan
 			canvas.flush();
 			use_glyph_program = false;
 		}
+		set_vertex_format(canvas, format_sprite);
 
 		if (position + num_vertices > max_vertices)
 			canvas.flush();
@@ -317,46 +340,35 @@ namespace clan
 		{
 			gc.set_program_object(program_sprite);
 
-			int gpu_index;
-			VertexArrayVector<SpriteVertex> gpu_vertices(batch_buffer->get_vertex_buffer(gc, gpu_index));
-
-			if (prim_array[gpu_index].is_null())
+			if (glyph_blend.is_null())
 			{
-				prim_array[gpu_index] = PrimitivesArray(gc);
-				prim_array[gpu_index].set_attributes(0, gpu_vertices, cl_offsetof(SpriteVertex, position));
-				prim_array[gpu_index].set_attributes(1, gpu_vertices, cl_offsetof(SpriteVertex, color));
-				prim_array[gpu_index].set_attributes(2, gpu_vertices, cl_offsetof(SpriteVertex, texcoord));
-				prim_array[gpu_index].set_attributes(3, gpu_vertices, cl_offsetof(SpriteVertex, texindex));
-
-				if (glyph_blend.is_null())
-				{
-					BlendStateDescription blend_desc;
-					blend_desc.set_blend_function(blend_constant_color, blend_one_minus_src_color, blend_zero, blend_one);
-					glyph_blend = BlendState(gc, blend_desc);
-				}
+				BlendStateDescription blend_desc;
+				blend_desc.set_blend_function(blend_constant_color, blend_one_minus_src_color, blend_zero, blend_one);
+				glyph_blend = BlendState(gc, blend_desc);
 			}
 
-			gpu_vertices.upload_data(gc, 0, vertices, position);
-
 			for (int i = 0; i < num_current_textures; i++)
 				gc.set_texture(i, current_textures[i]);
 
 			if (use_glyph_program)
-			{
 				gc.set_blend_state(glyph_blend, constant_color);
-				gc.draw_primitives(type_triangles, position, prim_array[gpu_index]);
+
+			int bytes = (vertex_format == format_quad) ? flush_quads(gc) : flush_sprites(gc);
+
+			if (use_glyph_program)
 				gc.reset_blend_state();
-			}
-			else
-			{
-				gc.draw_primitives(type_triangles, position, prim_array[gpu_index]);
-			}
 
 			for (int i = 0; i < num_current_textures; i++)
 				gc.reset_texture(i);
 
 			gc.reset_program_object();
 
+			statistics.last_flush_vertices = position;
+			statistics.last_flush_bytes = bytes;
+			statistics.flushes++;
+			statistics.total_vertices += position;
+			statistics.total_bytes += bytes;
+
 			position = 0;
 			for (int i = 0; i < num_current_textures; i++)
 				current_textures[i] = Texture2D();
@@ -365,8 +377,71 @@ namespace clan
 		}
 	}
 
+	int RenderBatchTriangle::flush_sprites(GraphicContext &gc)
+	{
+		int gpu_index;
+		VertexArrayVector<SpriteVertex> gpu_vertices(batch_buffer->get_vertex_buffer(gc, gpu_index));
+
+		if (prim_array[gpu_index].is_null())
+		{
+			prim_array[gpu_index] = PrimitivesArray(gc);
+			prim_array[gpu_index].set_attributes(0, gpu_vertices, cl_offsetof(SpriteVertex, position));
+			prim_array[gpu_index].set_attributes(1, gpu_vertices, cl_offsetof(SpriteVertex, color));
+			prim_array[gpu_index].set_attributes(2, gpu_vertices, cl_offsetof(SpriteVertex, texcoord));
+			prim_array[gpu_index].set_attributes(3, gpu_vertices, cl_offsetof(SpriteVertex, texindex));
+		}
+
+		gpu_vertices.upload_data(gc, 0, vertices, position);
+		gc.draw_primitives(type_triangles, position, prim_array[gpu_index]);
+
+		return position * sizeof(SpriteVertex);
+	}
+
+	int RenderBatchTriangle::flush_quads(GraphicContext &gc)
+	{
+		int gpu_index;
+		VertexArrayVector<QuadVertex> gpu_vertices(batch_buffer->get_vertex_buffer(gc, gpu_index));
+
+		if (quad_prim_array[gpu_index].is_null())
+		{
+			// Missing position components default to z = 0 and w = 1
+			quad_prim_array[gpu_index] = PrimitivesArray(gc);
+			quad_prim_array[gpu_index].set_attributes(0, gpu_vertices, cl_offsetof(QuadVertex, position));
+			quad_prim_array[gpu_index].set_attributes(1, gpu_vertices, cl_offsetof(QuadVertex, color), true);
+			quad_prim_array[gpu_index].set_attributes(2, gpu_vertices, cl_offsetof(QuadVertex, texcoord), true);
+			quad_prim_array[gpu_index].set_attributes(3, gpu_vertices, cl_offsetof(QuadVertex, texindex));
+		}
+
+		if (quad_indices.is_null())
+		{
+			std::vector<unsigned short> indices(max_quad_vertices / 4 * 6);
+			for (int quad = 0; quad < max_quad_vertices / 4; quad++)
+			{
+				unsigned short base = (unsigned short)(quad * 4);
+				indices[quad * 6 + 0] = base + 0;
+				indices[quad * 6 + 1] = base + 1;
+				indices[quad * 6 + 2] = base + 2;
+				indices[quad * 6 + 3] = base + 1;
+				indices[quad * 6 + 4] = base + 3;
+				indices[quad * 6 + 5] = base + 2;
+			}
+			quad_indices = ElementArrayVector<unsigned short>(gc, indices);
+		}
+
+		gpu_vertices.upload_data(gc, 0, quad_vertices, position);
+		gc.set_primitives_array(quad_prim_array[gpu_index]);
+		gc.draw_primitives_elements(type_triangles, position / 4 * 6, quad_indices);
+		gc.reset_primitives_array();
+
+		return position * sizeof(QuadVertex);
+	}
+
 	void RenderBatchTriangle::matrix_changed(const Mat4f &new_modelview, const Mat4f &new_projection, TextureImageYAxis image_yaxis, float pixel_ratio)
 	{
 		modelview_projection_matrix = new_projection * new_modelview;
+
+		// The quad format only stores x and y, so the transform must leave z = 0 and w = 1 for every 2D point
+		const float *m = modelview_projection_matrix.matrix;
+		quad_format_matrix = m[2] == 0.0f && m[6] == 0.0f && m[14] == 0.0f && m[3] == 0.0f && m[7] == 0.0f && m[15] == 1.0f;
 	}
 }
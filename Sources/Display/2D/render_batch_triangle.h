@@ -34,6 +34,8 @@
 #include "API/Display/Render/blend_state.h"
 #include "API/Display/Render/render_batcher.h"
 #include "API/Display/Render/texture_2d.h"
+#include "API/Display/Render/element_array_vector.h"
+#include "API/Display/2D/canvas.h"
 #include "render_batch_buffer.h"
 
 namespace clan
@@ -56,6 +58,9 @@ namespace clan
 		void fill_triangles(Canvas &canvas, const Vec2f *positions, const Vec2f *texture_positions, int num_vertices, const Texture2D &texture, const Colorf *colors);
 		void fill(Canvas &canvas, float x1, float y1, float x2, float y2, const Colorf &color);
 
+		const CanvasBatchStatistics &get_statistics() const { return statistics; }
+		void reset_statistics() { statistics = CanvasBatchStatistics(); }
+
 	public:
 		static int max_textures;	// For use by the GL1 target, so it can reduce the number of textures
 
@@ -68,20 +73,55 @@ namespace clan
 			int texindex;
 		};
 
-		int set_batcher_active(Canvas &canvas, const Texture2D &texture, bool glyph_program = false, const Colorf &constant_color = StandardColorf::black());
-		int set_batcher_active(Canvas &canvas);
+		// Compact vertex used for axis aligned and transformed quads. Four of these plus the shared index buffer replace six SpriteVertex
+		struct QuadVertex
+		{
+			Vec2f position;
+			Vec2us texcoord;
+			Vec4ub color;
+			signed char texindex;
+			unsigned char padding[3];
+		};
+
+		enum VertexFormat
+		{
+			format_sprite,
+			format_quad
+		};
+
+		int set_batcher_active(Canvas &canvas, const Texture2D &texture, VertexFormat format, bool glyph_program = false, const Colorf &constant_color = StandardColorf::black());
+		int set_batcher_active(Canvas &canvas, VertexFormat format);
 		int set_batcher_active(Canvas &canvas, int num_vertices);
+		void set_vertex_format(Canvas &canvas, VertexFormat format);
+		bool is_batch_full() const;
+		VertexFormat select_format(const Pointf texture_positions[4], const Colorf &color) const;
+		void add_quad(const Pointf dest_positions[4], const Pointf texture_positions[4], const Colorf &color, int texindex);
+		int flush_sprites(GraphicContext &gc);
+		int flush_quads(GraphicContext &gc);
 		void flush(GraphicContext &gc) override;
 		void matrix_changed(const Mat4f &modelview, const Mat4f &projection, TextureImageYAxis image_yaxis, float pixel_ratio) override;
 
+		inline void to_texture_positions(const Rectf &src, const Texture2D &texture, Pointf texture_positions[4]) const;
 		inline void to_sprite_vertex(const Pointf &texture_position, const Pointf &dest_position, RenderBatchTriangle::SpriteVertex &v, int texindex, const Colorf &color) const;
 		inline Vec4f to_position(float x, float y) const;
+		inline Vec2f to_position_2d(float x, float y) const;
 
 		Mat4f modelview_projection_matrix;
 		int position = 0;
 		enum { max_vertices = RenderBatchBuffer::vertex_buffer_size / sizeof(SpriteVertex) };
 		SpriteVertex *vertices;
 
+		// Both vertex formats share the batch buffer. Quads are limited by what 16-bit indices can address
+		enum { max_quad_vertices = (RenderBatchBuffer::vertex_buffer_size / sizeof(QuadVertex) < 65536 ? RenderBatchBuffer::vertex_buffer_size / sizeof(QuadVertex) : 65536) / 4 * 4 };
+		QuadVertex *quad_vertices;
+		VertexFormat vertex_format = format_sprite;
+		bool quad_format_supported = false;
+		bool quad_format_matrix = false;
+		ElementArrayVector<unsigned short> quad_indices;
+		PrimitivesArray quad_prim_array[RenderBatchBuffer::num_vertex_buffers];
+
+		CanvasBatchStatistics statistics;
+
 		RenderBatchBuffer *batch_buffer;
 
 		PrimitivesArray prim_array[RenderBatchBuffer::num_vertex_buffers];
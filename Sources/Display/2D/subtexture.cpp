@@ -30,25 +30,10 @@
 #include "API/Display/2D/subtexture.h"
 #include "API/Display/Render/texture_2d.h"
 #include "API/Core/Math/rect.h"
+#include "subtexture_impl.h"
 
 namespace clan
 {
-	class Subtexture_Impl
-	{
-	public:
-		Subtexture_Impl()
-		{
-		}
-
-		~Subtexture_Impl()
-		{
-		}
-
-		Texture2D texture;
-
-		Rect geometry;
-	};
-
 	Subtexture::Subtexture()
 	{
 	}
@@ -37,8 +37,8 @@ namespace clan
 	{
 	}
 
-	TextureGroup::TextureGroup(const Size &texture_sizes)
-		: impl(std::make_shared<TextureGroup_Impl>(texture_sizes))
+	TextureGroup::TextureGroup(const Size &texture_sizes, RectPacker::PackingAlgorithm algorithm)
+		: impl(std::make_shared<TextureGroup_Impl>(texture_sizes, algorithm))
 	{
 		set_texture_allocation_policy(create_new_texture);
 	}
@@ -83,6 +83,16 @@ namespace clan
 		return impl->get_textures();
 	}
 
+	RectPacker::PackingAlgorithm TextureGroup::get_packing_algorithm() const
+	{
+		return impl->packing_algorithm;
+	}
+
+	float TextureGroup::get_packing_efficiency() const
+	{
+		return impl->get_packing_efficiency();
+	}
+
 	Subtexture TextureGroup::add(GraphicContext &context, const Size &size)
 	{
 		return impl->add_new_node(context, size);
@@ -93,6 +103,11 @@ namespace clan
 		impl->remove(subtexture);
 	}
 
+	int TextureGroup::defragment(GraphicContext &context, int max_textures)
+	{
+		return impl->defragment(context, max_textures);
+	}
+
 	void TextureGroup::set_texture_allocation_policy(TextureAllocationPolicy policy)
 	{
 		impl->texture_allocation_policy = policy;
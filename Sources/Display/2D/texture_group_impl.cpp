@@ -28,312 +28,237 @@
 
 #include "Display/precomp.h"
 #include "API/Display/2D/subtexture.h"
+#include "API/Display/Render/graphic_context.h"
+#include "API/Display/Render/frame_buffer.h"
 #include "API/Core/Math/point.h"
 #include "API/Core/Math/rect.h"
 #include "texture_group_impl.h"
+#include "subtexture_impl.h"
+#include <algorithm>
 
 namespace clan
 {
-	TextureGroup_Impl::TextureGroup_Impl(const Size &texture_sizes)
-		: initial_texture_size(texture_sizes), active_root(nullptr), next_id(0)
+	TextureGroup_Impl::TextureGroup_Impl(const Size &texture_sizes, RectPacker::PackingAlgorithm algorithm)
+		: initial_texture_size(texture_sizes), texture_allocation_policy(TextureGroup::create_new_texture), packing_algorithm(algorithm), active_root(nullptr)
 	{
 	}
 
 	TextureGroup_Impl::~TextureGroup_Impl()
 	{
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
-		{
-			root_nodes[index]->node.clear();
-			delete root_nodes[index];
-		}
 	}
 
 	int TextureGroup_Impl::get_subtexture_count() const
 	{
 		int count = 0;
-
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
-			count += root_nodes[index]->node.get_subtexture_count();
-
+		for (const auto &root : root_nodes)
+			count += (int)root->subtextures.size();
 		return count;
 	}
 
 	int TextureGroup_Impl::get_subtexture_count(unsigned int texture_index) const
 	{
-		int count = 0;
-
 		if (texture_index < root_nodes.size())
-			count = root_nodes[texture_index]->node.get_subtexture_count();
-
-		return count;
+			return (int)root_nodes[texture_index]->subtextures.size();
+		return 0;
 	}
 
-	std::vector<Texture2D> TextureGroup_Impl::get_textures() const
+	float TextureGroup_Impl::get_packing_efficiency() const
 	{
-		std::vector<Texture2D> textures;
-
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
+		double used_area = 0.0;
+		double total_area = 0.0;
+		for (const auto &root : root_nodes)
 		{
-			textures.push_back(root_nodes[index]->texture);
+			used_area += root->packer.get_used_area();
+			total_area += (double)root->texture_rect.get_width() * root->texture_rect.get_height();
 		}
+		return total_area > 0.0 ? (float)(used_area / total_area) : 0.0f;
+	}
 
+	std::vector<Texture2D> TextureGroup_Impl::get_textures() const
+	{
+		std::vector<Texture2D> textures;
+		for (const auto &root : root_nodes)
+			textures.push_back(root->texture);
 		return textures;
 	}
 
 	Subtexture TextureGroup_Impl::add_new_node(GraphicContext &context, const Size &texture_size)
 	{
 		// Try inserting in current active texture
-		Node *node;
-		if (!active_root)
-		{
-			// Create an initial root, if it does not exist
-			node = nullptr;
-			next_id = 1;
-		}
-		else
-		{
-			node = active_root->node.insert(texture_size, next_id);
-		}
+		RootNode *root = nullptr;
+		Rect rect;
+		if (active_root && insert(active_root, texture_size, rect))
+			root = active_root;
 
-		if (node == nullptr) // Couldn't find a fit in current active texture
+		// Search previous textures if policy says so
+		if (!root && texture_allocation_policy == TextureGroup::search_previous_textures)
 		{
-			// Search previous textures if policy says so
-			if (texture_allocation_policy == TextureGroup::search_previous_textures)
+			for (auto &elem : root_nodes)
 			{
-				std::vector<RootNode *>::size_type index, size;
-				size = root_nodes.size();
-				for (index = 0; index < size; ++index)
+				if (elem.get() != active_root && insert(elem.get(), texture_size, rect))
 				{
-					node = root_nodes[index]->node.insert(texture_size, next_id);
-					if (node)	// We found space in a previous texture
-						break;
-				}
-			}
-
-			if (node == nullptr) // Couldn't find a fit, so create a new texture
-			{
-				if (texture_size.width > initial_texture_size.width || texture_size.height > initial_texture_size.height)
-				{
-					// If the specified size is greater than the initial size,  then create a texture using the specified size
-					node = add_new_root(context, texture_size)->node.insert(texture_size, next_id);
-				}
-				else
-				{
-					node = add_new_root(context, initial_texture_size)->node.insert(texture_size, next_id);
+					root = elem.get();
+					break;
 				}
 			}
+		}
 
-			if (node == nullptr)
+		if (!root) // Couldn't find a fit, so create a new texture
+		{
+			// If the specified size is greater than the initial size, then create a texture using the specified size
+			if (texture_size.width > initial_texture_size.width || texture_size.height > initial_texture_size.height)
+				root = add_new_root(context, texture_size);
+			else
+				root = add_new_root(context, initial_texture_size);
+			if (!insert(root, texture_size, rect))
 				throw Exception("Unable to pack Texture into TextureGroup");
 		}
 
-		next_id++;
-
-		return Subtexture(active_root->texture, node->image_rect);
+		Subtexture subtexture(root->texture, rect);
+		root->subtextures.push_back(subtexture);
+		return subtexture;
 	}
 
-	TextureGroup_Impl::RootNode *TextureGroup_Impl::add_new_root(GraphicContext &context, const Size &texture_size)
+	bool TextureGroup_Impl::insert(RootNode *root, const Size &texture_size, Rect &out_rect)
 	{
-		Rect rect(Point(0, 0), texture_size);
-		Node node(rect);
-
-		active_root = new RootNode();
-		active_root->texture = Texture2D(context, texture_size);
-		active_root->node = node;
+		RectPacker::AllocatedRect allocated_rect(0, Rect());
+		if (!root->packer.try_add(texture_size, allocated_rect))
+			return false;
 
-		root_nodes.push_back(active_root);
+		out_rect = allocated_rect.rect;
+		out_rect.translate(root->texture_rect.left, root->texture_rect.top);
+		return true;
+	}
 
+	TextureGroup_Impl::RootNode *TextureGroup_Impl::add_new_root(GraphicContext &context, const Size &texture_size)
+	{
+		root_nodes.push_back(std::unique_ptr<RootNode>(new RootNode(Texture2D(context, texture_size), Rect(Point(0, 0), texture_size), packing_algorithm)));
+		active_root = root_nodes.back().get();
 		return active_root;
 	}
 
 	void TextureGroup_Impl::insert_texture(Texture2D &texture, const Rect &texture_rect)
 	{
-		Node node(texture_rect);
-
-		active_root = new RootNode();
-		active_root->texture = texture;
-		active_root->node = node;
-
-		root_nodes.push_back(active_root);
+		root_nodes.push_back(std::unique_ptr<RootNode>(new RootNode(texture, texture_rect, packing_algorithm)));
+		active_root = root_nodes.back().get();
 	}
 
 	void TextureGroup_Impl::remove(Subtexture &subtexture)
 	{
-		// Find the texture
-		Node *node = nullptr;
 		Texture2D texture = subtexture.get_texture();
 		Rect rect = subtexture.get_geometry();
 
-		std::vector<RootNode *>::size_type index, size;
-		size = root_nodes.size();
-		for (index = 0; index < size; ++index)
+		for (size_t index = 0; index < root_nodes.size(); ++index)
 		{
 			// Find a texture match
-			if (root_nodes[index]->texture == texture)
-			{
-				node = root_nodes[index]->node.find_image_rect(rect);
+			RootNode *root = root_nodes[index].get();
+			if (root->texture != texture)
+				continue;
+
+			auto it = std::find_if(root->subtextures.begin(), root->subtextures.end(), [&](const Subtexture &elem) { return elem.get_geometry() == rect; });
+			if (it == root->subtextures.end())
 				break;
-			}
-		}
-		if (node)
-		{
-			node->clear();
-			if (root_nodes[index]->node.get_subtexture_count() <= 0)
+
+			root->subtextures.erase(it);
+			Rect packer_rect = rect;
+			packer_rect.translate(-root->texture_rect.left, -root->texture_rect.top);
+			root->packer.remove(RectPacker::AllocatedRect(0, packer_rect));
+
+			if (root->subtextures.empty())
 			{
-				root_nodes[index]->node.clear();
-				delete root_nodes[index];
 				root_nodes.erase(root_nodes.begin() + index);
+				active_root = root_nodes.empty() ? nullptr : root_nodes.back().get();
 			}
-			if (root_nodes.empty())
-			{
-				active_root = nullptr;
-			}
-			else
-			{
-				active_root = root_nodes.back();
-			}
+			return;
 		}
-		else
-		{
-			throw Exception("Cannot find the Subtexture in the TextureGroup");
-		}
-	}
-
-	/////////////////////////////////////////////////////////////////////////////
 
-	TextureGroup_Impl::Node::Node()
-	{
-		child[0] = nullptr;
-		child[1] = nullptr;
-
-		id = 0;
+		throw Exception("Cannot find the Subtexture in the TextureGroup");
 	}
 
-	TextureGroup_Impl::Node::Node(const Rect &new_rect)
+	int TextureGroup_Impl::defragment(GraphicContext &context, int max_textures)
 	{
-		node_rect = new_rect;
-
-		child[0] = nullptr;
-		child[1] = nullptr;
-
-		id = 0;
-	}
-
-	TextureGroup_Impl::Node::~Node()
-	{
-		clear();
-	}
-
-	int TextureGroup_Impl::Node::get_subtexture_count() const
-	{
-		int count = 0;
-
-		if (child[0])
-			count += child[0]->get_subtexture_count();
-		if (child[1])
-			count += child[1]->get_subtexture_count();
-
-		if (id)
-			count++;
-
-		return count;
-	}
-
-	void TextureGroup_Impl::Node::clear()
-	{
-		if (child[0])
+		int released = 0;
+		while (released < max_textures && root_nodes.size() > 1)
 		{
-			delete child[0];
-			child[0] = nullptr;
-		}
-		if (child[1])
-		{
-			delete child[1];
-			child[1] = nullptr;
+			size_t source_index = 0;
+			for (size_t index = 1; index < root_nodes.size(); index++)
+			{
+				if (root_nodes[index]->packer.get_used_area() < root_nodes[source_index]->packer.get_used_area())
+					source_index = index;
+			}
+
+			if (!release_root(source_index, context))
+				break;
+			released++;
 		}
-		id = 0;
+		return released;
 	}
 
-	TextureGroup_Impl::Node *TextureGroup_Impl::Node::insert(const Size &texture_size, int texture_id)
+	bool TextureGroup_Impl::release_root(size_t source_index, GraphicContext &context)
 	{
-		// If we're not a leaf
-		if (child[0] && child[1])
-		{
-			// Try inserting into first child
-			Node *new_node = child[0]->insert(texture_size, texture_id);
-			if (new_node != nullptr)
-				return new_node;
+		RootNode *source = root_nodes[source_index].get();
 
-			// No room, insert into second
-			return child[1]->insert(texture_size, texture_id);
-		}
-		else
+		// Place the largest sub-textures first; they are the hardest to fit
+		std::vector<Subtexture> subtextures = source->subtextures;
+		std::sort(subtextures.begin(), subtextures.end(), [](const Subtexture &a, const Subtexture &b)
 		{
-			// If there's already a texture here, return
-			if (id)
-				return nullptr;
-
-			// If we're too small, return
-			if (texture_size.width > node_rect.get_width() || texture_size.height > node_rect.get_height())
-				return nullptr;
+			Size size_a = a.get_geometry().get_size(), size_b = b.get_geometry().get_size();
+			return size_a.width * size_a.height > size_b.width * size_b.height;
+		});
 
-			// If we're just right, accept
-			if (texture_size.width == node_rect.get_width() && texture_size.height == node_rect.get_height())
+		std::vector<std::pair<RootNode *, Rect> > targets;
+		for (const Subtexture &subtexture : subtextures)
+		{
+			Rect new_rect;
+			RootNode *target = nullptr;
+			for (auto &root : root_nodes)
 			{
-				id = texture_id;
-				image_rect = node_rect;
-				return this;
+				if (root.get() != source && insert(root.get(), subtexture.get_geometry().get_size(), new_rect))
+				{
+					target = root.get();
+					break;
+				}
 			}
 
-			// Otherwise, decide which way to split
-			int dw = node_rect.get_width() - texture_size.width;
-			int dh = node_rect.get_height() - texture_size.height;
-
-			if (dw > dh)
+			if (!target)
 			{
-				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.left + texture_size.width, node_rect.bottom));
-				child[1] = new Node(Rect(node_rect.left + texture_size.width, node_rect.top, node_rect.right, node_rect.bottom));
-			}
-			else
-			{
-				child[0] = new Node(Rect(node_rect.left, node_rect.top, node_rect.right, node_rect.top + texture_size.height));
-				child[1] = new Node(Rect(node_rect.left, node_rect.top + texture_size.height, node_rect.right, node_rect.bottom));
+				// The texture cannot be emptied; give back the space reserved so far
+				for (auto &placed : targets)
+				{
+					Rect packer_rect = placed.second;
+					packer_rect.translate(-placed.first->texture_rect.left, -placed.first->texture_rect.top);
+					placed.first->packer.remove(RectPacker::AllocatedRect(0, packer_rect));
+				}
+				return false;
 			}
-
-			// Insert into first child we created
-			return child[0]->insert(texture_size, texture_id);
+			targets.push_back(std::make_pair(target, new_rect));
 		}
-	}
 
-	TextureGroup_Impl::Node *TextureGroup_Impl::Node::find_image_rect(const Rect &new_rect)
-	{
-		// Check leaf
-		if (child[0])
-		{
-			Node *node = child[0]->find_image_rect(new_rect);
-			if (node)
-				return node;
-		}
+		FrameBuffer write_frame_buffer = context.get_write_frame_buffer();
+		FrameBuffer read_frame_buffer = context.get_read_frame_buffer();
+
+		FrameBuffer source_frame_buffer(context);
+		source_frame_buffer.attach_color(0, source->texture);
+		context.set_frame_buffer(source_frame_buffer);
 
-		if (child[1])
+		for (size_t i = 0; i < subtextures.size(); i++)
 		{
-			Node *node = child[1]->find_image_rect(new_rect);
-			if (node)
-				return node;
-		}
+			RootNode *target = targets[i].first;
+			const Rect &new_rect = targets[i].second;
+			target->texture.copy_subimage_from(context, new_rect.get_top_left(), subtextures[i].get_geometry());
 
-		if (id == 0)
-			return nullptr;
+			subtextures[i].impl->texture = target->texture;
+			subtextures[i].impl->geometry = new_rect;
+			target->subtextures.push_back(subtextures[i]);
+		}
 
-		if (image_rect == new_rect)
-			return this;
+		if (write_frame_buffer.is_null())
+			context.reset_frame_buffer();
+		else
+			context.set_frame_buffer(write_frame_buffer, read_frame_buffer);
 
-		return nullptr;
+		root_nodes.erase(root_nodes.begin() + source_index);
+		active_root = root_nodes.back().get();
+		return true;
 	}
 }
@@ -28,9 +28,9 @@
 
 #pragma once
 
-#include <list>
 #include "API/Display/Render/texture_2d.h"
 #include "API/Display/2D/texture_group.h"
+#include "API/Display/2D/subtexture.h"
 
 namespace clan
 {
@@ -40,55 +40,45 @@ namespace clan
 	class TextureGroup_Impl
 	{
 	public:
-		class Node
-		{
-		public:
-			Node();
-			Node(const Rect &rect);
-			~Node();
-
-			int get_subtexture_count() const;
-
-			Node *insert(const Size &texture_size, int texture_id);
-			Node *find_image_rect(const Rect &new_rect);
-
-			void clear();
-
-			Node *child[2];
-			Rect node_rect;
-
-			int id;
-			Rect image_rect;
-		};
-
 		struct RootNode
 		{
 		public:
+			RootNode(const Texture2D &texture, const Rect &texture_rect, RectPacker::PackingAlgorithm algorithm)
+				: texture(texture), texture_rect(texture_rect), packer(texture_rect.get_size(), RectPacker::fail_if_full, algorithm)
+			{
+			}
+
 			Texture2D texture;
-			Node node;
+			Rect texture_rect;
+			RectPacker packer;
+			std::vector<Subtexture> subtextures;
 		};
 
-		TextureGroup_Impl(const Size &texture_sizes);
+		TextureGroup_Impl(const Size &texture_sizes, RectPacker::PackingAlgorithm algorithm);
 		~TextureGroup_Impl();
 
 		int get_subtexture_count() const;
 		int get_subtexture_count(unsigned int texture_index) const;
+		float get_packing_efficiency() const;
 		void insert_texture(Texture2D &texture, const Rect &texture_rect);
 		void remove(Subtexture &subtexture);
+		int defragment(GraphicContext &context, int max_textures);
 
 		std::vector<Texture2D> get_textures() const;
 
 		Subtexture add_new_node(GraphicContext &context, const Size &texture_size);
 
-		std::vector<RootNode *> root_nodes;
+		std::vector<std::unique_ptr<RootNode> > root_nodes;
 
 		Size initial_texture_size;
 		TextureGroup::TextureAllocationPolicy texture_allocation_policy;
+		RectPacker::PackingAlgorithm packing_algorithm;
 
 	private:
 		RootNode *add_new_root(GraphicContext &context, const Size &texture_size);
+		bool insert(RootNode *root, const Size &texture_size, Rect &out_rect);
+		bool release_root(size_t index, GraphicContext &context);
 
 		RootNode *active_root;
-		int next_id;
 	};
 }
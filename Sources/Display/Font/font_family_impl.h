@@ -86,7 +86,8 @@ namespace clan
 		void font_face_load(const FontDescription &desc, DataBuffer &font_databuffer, float pixel_ratio);
 
 		std::string family_name;
-		TextureGroup texture_group;		// Shared texture group between glyph cache's
+		std::shared_ptr<GlyphAtlas> glyph_atlas;		// Shared texture atlas between glyph cache's
+		static const int max_glyph_atlas_pages = 32;
 		std::vector<Font_Cache> font_cache;
 		std::vector<FontFamily_Definition> font_definitions;
 	};
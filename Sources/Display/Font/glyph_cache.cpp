@@ -46,25 +46,116 @@
 #include "API/Core/Text/utf8_reader.h"
 #include "Display/2D/render_batch_triangle.h"
 #include "Display/Render/graphic_context_impl.h"
+#include <algorithm>
 
 namespace clan
 {
+	GlyphAtlas::GlyphAtlas(const Size &texture_size, int max_pages) : texture_group(texture_size), max_pages(max_pages)
+	{
+	}
+
+	GlyphAtlas::~GlyphAtlas()
+	{
+	}
+
+	Subtexture GlyphAtlas::add(GraphicContext &gc, GlyphCache *cache, unsigned int glyph, const Size &size, GlyphAtlasPage *&out_page)
+	{
+		Subtexture sub_texture = texture_group.add(gc, size);
+		Texture2D texture = sub_texture.get_texture();
+
+		GlyphAtlasPage *page = nullptr;
+		for (auto &elem : pages)
+		{
+			if (elem->texture == texture)
+			{
+				page = elem.get();
+				break;
+			}
+		}
+
+		if (!page)
+		{
+			pages.push_back(std::unique_ptr<GlyphAtlasPage>(new GlyphAtlasPage()));
+			page = pages.back().get();
+			page->texture = texture;
+
+			// A new texture was created. Evict the least recently used pages to stay within budget.
+			while (max_pages > 0 && (int)pages.size() > max_pages)
+			{
+				size_t lru_index = 0;
+				for (size_t i = 1; i < pages.size(); i++)
+				{
+					if (pages[i]->last_used < pages[lru_index]->last_used)
+						lru_index = i;
+				}
+				if (pages[lru_index].get() == page)
+					break;
+				evict_page(lru_index);
+			}
+		}
+
+		page->entries.push_back(GlyphAtlasEntry(cache, glyph, sub_texture.get_geometry()));
+		touch(page);
+		out_page = page;
+		return sub_texture;
+	}
+
+	void GlyphAtlas::remove_cache(GlyphCache *cache)
+	{
+		for (size_t page_index = 0; page_index < pages.size(); )
+		{
+			GlyphAtlasPage *page = pages[page_index].get();
+			auto it = std::remove_if(page->entries.begin(), page->entries.end(), [&](const GlyphAtlasEntry &entry)
+			{
+				if (entry.cache != cache)
+					return false;
+				Subtexture sub_texture(page->texture, entry.rect);
+				texture_group.remove(sub_texture);
+				return true;
+			});
+			page->entries.erase(it, page->entries.end());
+
+			// The texture group releases textures that no longer contain any sub textures
+			if (page->entries.empty())
+				pages.erase(pages.begin() + page_index);
+			else
+				page_index++;
+		}
+	}
+
+	void GlyphAtlas::evict_page(size_t page_index)
+	{
+		std::unique_ptr<GlyphAtlasPage> page = std::move(pages[page_index]);
+		pages.erase(pages.begin() + page_index);
+
+		for (auto &entry : page->entries)
+		{
+			entry.cache->evict_glyph(entry.glyph);
+			Subtexture sub_texture(page->texture, entry.rect);
+			texture_group.remove(sub_texture);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
 	GlyphCache::GlyphCache()
 	{
-		glyph_list.reserve(256);
 	}
 
 	GlyphCache::~GlyphCache()
 	{
+		if (glyph_atlas)
+			glyph_atlas->remove_cache(this);
 	}
 
 	Font_TextureGlyph *GlyphCache::get_glyph(Canvas &canvas, FontEngine *font_engine, unsigned int glyph)
 	{
-		auto size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
+		Font_TextureGlyph *font_glyph = glyph_table.find(glyph);
+		if (font_glyph)
 		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
+			if (font_glyph->atlas_page)
+				glyph_atlas->touch(font_glyph->atlas_page);
+			return font_glyph;
 		}
 
 		// If glyph does not exist, create one automatically
@@ -72,20 +163,19 @@ namespace clan
 		if (pb.glyph)	// Ignore invalid glyphs
 			insert_glyph(canvas, pb);
 
-		// Search for the glyph again
-		size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
-		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
-		}
+		return glyph_table.find(glyph);
+	}
 
-		return nullptr;
+	void GlyphCache::set_glyph_atlas(const std::shared_ptr<GlyphAtlas> &new_glyph_atlas)
+	{
+		if (glyph_atlas)
+			glyph_atlas->remove_cache(this);
+		glyph_atlas = new_glyph_atlas;
 	}
 
-	void GlyphCache::set_texture_group(TextureGroup &new_texture_group)
+	void GlyphCache::evict_glyph(unsigned int glyph)
 	{
-		texture_group = new_texture_group;
+		glyph_table.erase(glyph);
 	}
 
 	GlyphMetrics GlyphCache::get_metrics(FontEngine *font_engine, Canvas &canvas, unsigned int glyph)
@@ -108,16 +198,19 @@ namespace clan
 
 		if (!pb.empty_buffer)
 		{
+			if (!glyph_atlas)
+				throw Exception("GlyphCache has no glyph atlas");
+
 			PixelBuffer buffer_with_border = PixelBufferHelp::add_border(pb.buffer, glyph_border_size, pb.buffer_rect);
 			GraphicContext gc = canvas.get_gc();
-			Subtexture sub_texture = texture_group.add(gc, buffer_with_border.get_size());
+			Subtexture sub_texture = glyph_atlas->add(gc, this, pb.glyph, buffer_with_border.get_size(), font_glyph->atlas_page);
 			font_glyph->texture = sub_texture.get_texture();
 			font_glyph->geometry = Rect(sub_texture.get_geometry().left + glyph_border_size, sub_texture.get_geometry().top + glyph_border_size, pb.buffer_rect.get_size());
 			font_glyph->size = pb.size;
 			sub_texture.get_texture().set_subimage(gc, sub_texture.get_geometry().left, sub_texture.get_geometry().top, buffer_with_border, buffer_with_border.get_size());
 		}
 
-		glyph_list.push_back(std::move(font_glyph));
+		glyph_table.insert(font_glyph->glyph, std::move(font_glyph));
 	}
 
 	void GlyphCache::insert_glyph(Canvas &canvas, unsigned int glyph, Subtexture &sub_texture, const Pointf &offset, const Sizef &size, const GlyphMetrics &glyph_metrics)
@@ -135,6 +228,6 @@ namespace clan
 			font_glyph->geometry = sub_texture.get_geometry();
 		}
 
-		glyph_list.push_back(std::move(font_glyph));
+		glyph_table.insert(glyph, std::move(font_glyph));
 	}
 }
@@ -35,6 +35,7 @@
 #include "API/Display/2D/texture_group.h"
 #include "API/Display/2D/subtexture.h"
 #include "API/Display/Render/texture_2d.h"
+#include "glyph_lookup_table.h"
 #include <list>
 #include <map>
 
@@ -48,6 +49,8 @@ namespace clan
 	class FontPixelBuffer;
 	class Path;
 	class RenderBatchTriangle;
+	class GlyphCache;
+	class GlyphAtlasPage;
 
 	/// \brief Font texture format (holds a pixel buffer containing a glyph)
 	class Font_TextureGlyph
@@ -76,6 +79,57 @@ namespace clan
 		Sizef size;
 
 		GlyphMetrics metrics;
+
+		/// \brief Atlas page holding the glyph, or null if the glyph is not owned by a GlyphAtlas
+		GlyphAtlasPage *atlas_page = nullptr;
+	};
+
+	class GlyphAtlasEntry
+	{
+	public:
+		GlyphAtlasEntry(GlyphCache *cache, unsigned int glyph, const Rect &rect) : cache(cache), glyph(glyph), rect(rect) { }
+
+		GlyphCache *cache;
+		unsigned int glyph;
+		Rect rect;
+	};
+
+	class GlyphAtlasPage
+	{
+	public:
+		Texture2D texture;
+		uint64_t last_used = 0;
+		std::vector<GlyphAtlasEntry> entries;
+	};
+
+	/// \brief Texture atlas shared by the glyph caches of a font family
+	///
+	/// Once more than max_pages textures are in use the least recently used page is evicted,
+	/// together with every glyph stored on it. Evicted glyphs are rasterized again on their next use.
+	class GlyphAtlas
+	{
+	public:
+		GlyphAtlas(const Size &texture_size, int max_pages);
+		~GlyphAtlas();
+
+		int get_page_count() const { return (int)pages.size(); }
+
+		/// \brief Allocates space for a glyph. Might evict the least recently used page.
+		Subtexture add(GraphicContext &gc, GlyphCache *cache, unsigned int glyph, const Size &size, GlyphAtlasPage *&out_page);
+
+		/// \brief Marks a page as used by the current draw
+		void touch(GlyphAtlasPage *page) { page->last_used = ++use_counter; }
+
+		/// \brief Frees all glyphs owned by a cache
+		void remove_cache(GlyphCache *cache);
+
+	private:
+		void evict_page(size_t page_index);
+
+		TextureGroup texture_group;
+		int max_pages;
+		uint64_t use_counter = 0;
+		std::vector<std::unique_ptr<GlyphAtlasPage>> pages;
 	};
 
 	class GlyphCache
@@ -92,11 +146,14 @@ namespace clan
 		void insert_glyph(Canvas &canvas, unsigned int glyph, Subtexture &sub_texture, const Pointf &offset, const Sizef &size, const GlyphMetrics &glyph_metrics);
 		void insert_glyph(Canvas &canvas, FontPixelBuffer &pb);
 
-		void set_texture_group(TextureGroup &new_texture_group);
+		void set_glyph_atlas(const std::shared_ptr<GlyphAtlas> &new_glyph_atlas);
+
+		/// \brief Called by GlyphAtlas when the page holding the glyph is evicted
+		void evict_glyph(unsigned int glyph);
 
 	private:
-		std::vector<std::unique_ptr<Font_TextureGlyph>> glyph_list;
-		TextureGroup texture_group;
+		GlyphLookupTable<Font_TextureGlyph> glyph_table;
+		std::shared_ptr<GlyphAtlas> glyph_atlas;
 
 		static const int glyph_border_size = 1;
 	};
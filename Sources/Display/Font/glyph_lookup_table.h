@@ -0,0 +1,153 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+namespace clan
+{
+	/// \brief Open addressing hash table mapping glyph indices to cached glyphs
+	///
+	/// Linear probing with backward shift deletion, so erase() never leaves tombstones behind.
+	/// Pointers returned by find() stay valid until the glyph is erased.
+	template<typename Value>
+	class GlyphLookupTable
+	{
+	public:
+		GlyphLookupTable() : slots(initial_capacity) { }
+
+		size_t size() const { return count; }
+
+		Value *find(unsigned int glyph) const
+		{
+			size_t mask = slots.size() - 1;
+			for (size_t index = hash(glyph) & mask; ; index = (index + 1) & mask)
+			{
+				const Slot &slot = slots[index];
+				if (!slot.value)
+					return nullptr;
+				if (slot.glyph == glyph)
+					return slot.value.get();
+			}
+		}
+
+		Value *insert(unsigned int glyph, std::unique_ptr<Value> value)
+		{
+			if ((count + 1) * 2 > slots.size())
+				rehash(slots.size() * 2);
+
+			size_t mask = slots.size() - 1;
+			for (size_t index = hash(glyph) & mask; ; index = (index + 1) & mask)
+			{
+				Slot &slot = slots[index];
+				if (!slot.value)
+				{
+					slot.glyph = glyph;
+					slot.value = std::move(value);
+					count++;
+					return slot.value.get();
+				}
+				if (slot.glyph == glyph)
+				{
+					slot.value = std::move(value);
+					return slot.value.get();
+				}
+			}
+		}
+
+		void erase(unsigned int glyph)
+		{
+			size_t mask = slots.size() - 1;
+			size_t index = hash(glyph) & mask;
+			while (true)
+			{
+				if (!slots[index].value)
+					return;
+				if (slots[index].glyph == glyph)
+					break;
+				index = (index + 1) & mask;
+			}
+
+			slots[index].value.reset();
+			count--;
+
+			// Shift following entries of the probe sequence back into the hole
+			size_t hole = index;
+			for (size_t next = (hole + 1) & mask; slots[next].value; next = (next + 1) & mask)
+			{
+				size_t home = hash(slots[next].glyph) & mask;
+				bool movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+				if (movable)
+				{
+					slots[hole].glyph = slots[next].glyph;
+					slots[hole].value = std::move(slots[next].value);
+					hole = next;
+				}
+			}
+		}
+
+		void clear()
+		{
+			slots.clear();
+			slots.resize(initial_capacity);
+			count = 0;
+		}
+
+	private:
+		struct Slot
+		{
+			unsigned int glyph = 0;
+			std::unique_ptr<Value> value;
+		};
+
+		static size_t hash(unsigned int glyph)
+		{
+			// Fibonacci hashing spreads the clustered code points of a script over the table
+			return (size_t)((glyph * 2654435769u) >> 7);
+		}
+
+		void rehash(size_t new_capacity)
+		{
+			std::vector<Slot> old_slots(new_capacity);
+			old_slots.swap(slots);
+			count = 0;
+			for (auto &slot : old_slots)
+			{
+				if (slot.value)
+					insert(slot.glyph, std::move(slot.value));
+			}
+		}
+
+		static const size_t initial_capacity = 256;
+
+		std::vector<Slot> slots;
+		size_t count = 0;
+	};
+}
@@ -51,38 +51,22 @@ namespace clan
 {
 	PathCache::PathCache()
 	{
-		glyph_list.reserve(256);
 	}
 
 	PathCache::~PathCache()
 	{
-		for (auto & elem : glyph_list)
-			delete elem;
 	}
 
 	Font_PathGlyph *PathCache::get_glyph(Canvas &canvas, FontEngine *font_engine, unsigned int glyph)
 	{
-		std::vector< Font_PathGlyph * >::size_type size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
-		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
-		}
+		Font_PathGlyph *font_glyph = glyph_table.find(glyph);
+		if (font_glyph)
+			return font_glyph;
 
-		auto font_glyph = new Font_PathGlyph();
-		glyph_list.push_back(font_glyph);
+		font_glyph = glyph_table.insert(glyph, std::unique_ptr<Font_PathGlyph>(new Font_PathGlyph()));
 		font_glyph->glyph = glyph;
 		font_engine->load_glyph_path(glyph, font_glyph->path, font_glyph->metrics);
-
-		// Search for the glyph again
-		size = glyph_list.size();
-		for (int cnt = 0; cnt < size; cnt++)
-		{
-			if (glyph_list[cnt]->glyph == glyph)
-				return &(*glyph_list[cnt]);
-		}
-
-		return nullptr;
+		return font_glyph;
 	}
 
 	GlyphMetrics PathCache::get_metrics(FontEngine *font_engine, Canvas &canvas, unsigned int glyph)
@@ -33,6 +33,7 @@
 #include "API/Display/Font/font_metrics.h"
 #include "API/Display/Render/texture.h"
 #include "API/Display/2D/path.h"
+#include "glyph_lookup_table.h"
 #include <list>
 #include <map>
 
@@ -70,6 +71,6 @@ namespace clan
 		GlyphMetrics get_metrics(FontEngine *font_engine, Canvas &canvas, unsigned int glyph);
 
 	private:
-		std::vector<Font_PathGlyph* > glyph_list;
+		GlyphLookupTable<Font_PathGlyph> glyph_table;
 	};
 }
@@ -0,0 +1,768 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "API/Display/Image/pixel_resampler.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Display/Image/pixel_buffer_set.h"
+#include "API/Display/Image/pixel_converter.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/task_group.h"
+#include <cmath>
+#include <vector>
+
+#if !defined(ARM_PLATFORM) && !defined(CL_ARM) && !defined(CL_DISABLE_SSE2) && !defined(__ANDROID__)
+#define CL_RESAMPLER_SIMD
+#include <immintrin.h>
+#endif
+
+// The AVX2 kernels are compiled for the instructions they use, independent of the flags the library is built with.
+// They are only called after detect_cpu_extension confirmed the CPU supports them.
+#if defined(__GNUC__)
+#define RESAMPLER_AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define RESAMPLER_AVX2_TARGET
+#endif
+
+namespace clan
+{
+	namespace
+	{
+		/////////////////////////////////////////////////////////////////////////
+		// Filters
+
+		double filter_support(PixelResampleFilter filter)
+		{
+			return filter == resample_box ? 0.5 : 3.0;
+		}
+
+		double sinc(double x)
+		{
+			x *= 3.14159265358979323846;
+			return (std::abs(x) < 1e-9) ? 1.0 : std::sin(x) / x;
+		}
+
+		double bessel_i0(double x)
+		{
+			double sum = 1.0;
+			double term = 1.0;
+			double half_x = x * 0.5;
+			for (int k = 1; k < 32; k++)
+			{
+				term *= (half_x / k) * (half_x / k);
+				sum += term;
+				if (term < sum * 1e-12)
+					break;
+			}
+			return sum;
+		}
+
+		double filter_weight(PixelResampleFilter filter, double x)
+		{
+			switch (filter)
+			{
+			case resample_box:
+				return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+			case resample_lanczos3:
+				return (std::abs(x) < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+			case resample_kaiser:
+			default:
+			{
+				const double width = 3.0;
+				const double alpha = 4.0;
+				if (std::abs(x) >= width)
+					return 0.0;
+				double w = x / width;
+				return sinc(x) * bessel_i0(alpha * std::sqrt(1.0 - w * w)) / bessel_i0(alpha);
+			}
+			}
+		}
+
+		/// \brief Weights of the source pixels contributing to each destination pixel along one axis
+		///
+		/// Every destination pixel reads num_taps source pixels starting at first[i]. Windows that are shorter
+		/// are padded with zero weights, and windows crossing the edge of the image are folded back onto the edge pixel.
+		class ResampleTaps
+		{
+		public:
+			ResampleTaps(PixelResampleFilter filter, int src_size, int dest_size)
+				: first(dest_size)
+			{
+				std::vector<int> window_start(dest_size);
+				std::vector<std::vector<float>> windows(dest_size);
+
+				double scale = src_size / (double)dest_size;
+				double filter_scale = std::max(scale, 1.0);
+				double support = filter_support(filter) * filter_scale;
+
+				for (int i = 0; i < dest_size; i++)
+				{
+					double center = (i + 0.5) * scale;
+					int low = (int)std::floor(center - support);
+					int high = (int)std::ceil(center + support);
+					int start = clamp(low, 0, src_size - 1);
+					int end = clamp(high, 0, src_size - 1);
+
+					std::vector<double> values(end - start + 1, 0.0);
+					for (int j = low; j <= high; j++)
+						values[clamp(j, 0, src_size - 1) - start] += filter_weight(filter, (j + 0.5 - center) / filter_scale);
+
+					int skip_front = 0;
+					int skip_back = 0;
+					while (skip_front + 1 < (int)values.size() && values[skip_front] == 0.0)
+						skip_front++;
+					while (skip_back + skip_front + 1 < (int)values.size() && values[values.size() - 1 - skip_back] == 0.0)
+						skip_back++;
+
+					double total = 0.0;
+					for (double value : values)
+						total += value;
+
+					if (total == 0.0)
+					{
+						// Only possible with degenerate sizes. Use the nearest pixel
+						window_start[i] = clamp((int)center, 0, src_size - 1);
+						windows[i].push_back(1.0f);
+					}
+					else
+					{
+						window_start[i] = start + skip_front;
+						for (size_t k = skip_front; k < values.size() - skip_back; k++)
+							windows[i].push_back((float)(values[k] / total));
+					}
+
+					num_taps = std::max(num_taps, (int)windows[i].size());
+				}
+
+				weights.resize(dest_size * num_taps, 0.0f);
+				for (int i = 0; i < dest_size; i++)
+				{
+					first[i] = std::min(window_start[i], src_size - num_taps);
+					float *dest = weights.data() + i * num_taps + (window_start[i] - first[i]);
+					for (size_t k = 0; k < windows[i].size(); k++)
+						dest[k] = windows[i][k];
+				}
+			}
+
+			int num_taps = 0;
+			std::vector<int> first;
+			std::vector<float> weights;
+		};
+
+		/////////////////////////////////////////////////////////////////////////
+		// Color space
+
+		float srgb_to_linear(float v)
+		{
+			return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+		}
+
+		float linear_to_srgb(float v)
+		{
+			return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+		}
+
+		class SRGBTables
+		{
+		public:
+			static const int encode_segments = 4096;
+
+			static const SRGBTables &get()
+			{
+				static SRGBTables tables;
+				return tables;
+			}
+
+			// Exact for 8 bit channels
+			float decode_8bit(float v) const
+			{
+				return decode[clamp((int)(v * 255.0f + 0.5f), 0, 255)];
+			}
+
+			float encode_linear(float v) const
+			{
+				v = clamp(v, 0.0f, 1.0f) * encode_segments;
+				int index = std::min((int)v, encode_segments - 1);
+				float t = v - index;
+				return encode[index] + (encode[index + 1] - encode[index]) * t;
+			}
+
+		private:
+			SRGBTables()
+			{
+				for (int i = 0; i < 256; i++)
+					decode[i] = srgb_to_linear(i / 255.0f);
+				for (int i = 0; i <= encode_segments; i++)
+					encode[i] = linear_to_srgb(i / (float)encode_segments);
+			}
+
+			float decode[256];
+			float encode[encode_segments + 1];
+		};
+
+		/// \brief How the pixels of a format are converted to and from the filtering space
+		struct ResampleColorSpace
+		{
+			bool srgb = false;
+			bool srgb_8bit = false;
+			bool alpha_weighted = false;
+		};
+
+		bool is_8bit_format(TextureFormat format)
+		{
+			switch (format)
+			{
+			case tf_r8:
+			case tf_rg8:
+			case tf_rgb8:
+			case tf_rgba8:
+			case tf_bgr8:
+			case tf_bgra8:
+			case tf_srgb8:
+			case tf_srgb8_alpha8:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		void to_filter_space(float *pixels, size_t count, const ResampleColorSpace &color_space)
+		{
+			if (color_space.srgb)
+			{
+				const SRGBTables &tables = SRGBTables::get();
+				for (size_t i = 0; i < count; i++)
+				{
+					float *p = pixels + i * 4;
+					for (int c = 0; c < 3; c++)
+						p[c] = color_space.srgb_8bit ? tables.decode_8bit(p[c]) : srgb_to_linear(clamp(p[c], 0.0f, 1.0f));
+				}
+			}
+
+			if (color_space.alpha_weighted)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					float *p = pixels + i * 4;
+					p[0] *= p[3];
+					p[1] *= p[3];
+					p[2] *= p[3];
+				}
+			}
+		}
+
+		void from_filter_space(float *pixels, size_t count, const ResampleColorSpace &color_space)
+		{
+			if (color_space.alpha_weighted)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					float *p = pixels + i * 4;
+					p[3] = clamp(p[3], 0.0f, 1.0f);
+					float scale = p[3] > 0.0f ? 1.0f / p[3] : 0.0f;
+					p[0] *= scale;
+					p[1] *= scale;
+					p[2] *= scale;
+				}
+			}
+
+			if (color_space.srgb)
+			{
+				const SRGBTables &tables = SRGBTables::get();
+				for (size_t i = 0; i < count; i++)
+				{
+					float *p = pixels + i * 4;
+					for (int c = 0; c < 3; c++)
+						p[c] = tables.encode_linear(p[c]);
+				}
+			}
+		}
+
+		/////////////////////////////////////////////////////////////////////////
+		// Filter kernels
+		//
+		// Pixels are RGBA floats. The horizontal kernel calculates count destination pixels of one row, where
+		// first[x] - src_x is the source pixel of the first tap of destination pixel x. The vertical kernel
+		// calculates count floats of one row from num_taps rows that are src_pitch floats apart.
+
+		void filter_horizontal_scalar(const float *src, int src_x, const int *first, const float *weights, int num_taps, int count, float *dest)
+		{
+			for (int x = 0; x < count; x++)
+			{
+				const float *s = src + (first[x] - src_x) * 4;
+				const float *w = weights + x * num_taps;
+				float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (int k = 0; k < num_taps; k++)
+				{
+					for (int c = 0; c < 4; c++)
+						sum[c] += w[k] * s[k * 4 + c];
+				}
+				for (int c = 0; c < 4; c++)
+					dest[x * 4 + c] = sum[c];
+			}
+		}
+
+		void filter_vertical_scalar(const float *src, int src_pitch, const float *weights, int num_taps, int count, float *dest)
+		{
+			for (int i = 0; i < count; i++)
+			{
+				float sum = 0.0f;
+				for (int k = 0; k < num_taps; k++)
+					sum += weights[k] * src[k * src_pitch + i];
+				dest[i] = sum;
+			}
+		}
+
+#ifdef CL_RESAMPLER_SIMD
+
+		bool is_avx2_supported()
+		{
+			static bool supported = System::detect_cpu_extension(System::avx2) && System::detect_cpu_extension(System::fma3);
+			return supported;
+		}
+
+		void filter_horizontal_sse2(const float *src, int src_x, const int *first, const float *weights, int num_taps, int count, float *dest)
+		{
+			for (int x = 0; x < count; x++)
+			{
+				const float *s = src + (first[x] - src_x) * 4;
+				const float *w = weights + x * num_taps;
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(s + k * 4)));
+				_mm_storeu_ps(dest + x * 4, sum);
+			}
+		}
+
+		void filter_vertical_sse2(const float *src, int src_pitch, const float *weights, int num_taps, int count, float *dest)
+		{
+			int i = 0;
+			for (; i + 8 <= count; i += 8)
+			{
+				__m128 sum0 = _mm_setzero_ps();
+				__m128 sum1 = _mm_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+				{
+					__m128 w = _mm_set1_ps(weights[k]);
+					const float *s = src + k * src_pitch + i;
+					sum0 = _mm_add_ps(sum0, _mm_mul_ps(w, _mm_loadu_ps(s)));
+					sum1 = _mm_add_ps(sum1, _mm_mul_ps(w, _mm_loadu_ps(s + 4)));
+				}
+				_mm_storeu_ps(dest + i, sum0);
+				_mm_storeu_ps(dest + i + 4, sum1);
+			}
+			for (; i < count; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + k * src_pitch + i)));
+				_mm_storeu_ps(dest + i, sum);
+			}
+		}
+
+		// Two taps per iteration: each 256 bit load holds two neighbouring source pixels
+		RESAMPLER_AVX2_TARGET void filter_horizontal_avx2(const float *src, int src_x, const int *first, const float *weights, int num_taps, int count, float *dest)
+		{
+			const __m256i weight_index = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+			for (int x = 0; x < count; x++)
+			{
+				const float *s = src + (first[x] - src_x) * 4;
+				const float *w = weights + x * num_taps;
+				__m256 sum2 = _mm256_setzero_ps();
+				int k = 0;
+				for (; k + 2 <= num_taps; k += 2)
+				{
+					__m256 w2 = _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_castpd_ps(_mm_load_sd((const double*)(w + k)))), weight_index);
+					sum2 = _mm256_fmadd_ps(w2, _mm256_loadu_ps(s + k * 4), sum2);
+				}
+				__m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum2), _mm256_extractf128_ps(sum2, 1));
+				if (k < num_taps)
+					sum = _mm_fmadd_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(s + k * 4), sum);
+				_mm_storeu_ps(dest + x * 4, sum);
+			}
+		}
+
+		RESAMPLER_AVX2_TARGET void filter_vertical_avx2(const float *src, int src_pitch, const float *weights, int num_taps, int count, float *dest)
+		{
+			int i = 0;
+			for (; i + 16 <= count; i += 16)
+			{
+				__m256 sum0 = _mm256_setzero_ps();
+				__m256 sum1 = _mm256_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+				{
+					__m256 w = _mm256_set1_ps(weights[k]);
+					const float *s = src + k * src_pitch + i;
+					sum0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(s), sum0);
+					sum1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(s + 8), sum1);
+				}
+				_mm256_storeu_ps(dest + i, sum0);
+				_mm256_storeu_ps(dest + i + 8, sum1);
+			}
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 sum = _mm256_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+					sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(src + k * src_pitch + i), sum);
+				_mm256_storeu_ps(dest + i, sum);
+			}
+			for (; i < count; i += 4)
+			{
+				__m128 sum = _mm_setzero_ps();
+				for (int k = 0; k < num_taps; k++)
+					sum = _mm_fmadd_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(src + k * src_pitch + i), sum);
+				_mm_storeu_ps(dest + i, sum);
+			}
+		}
+
+#endif
+
+		typedef void (*FilterHorizontalFunc)(const float *src, int src_x, const int *first, const float *weights, int num_taps, int count, float *dest);
+		typedef void (*FilterVerticalFunc)(const float *src, int src_pitch, const float *weights, int num_taps, int count, float *dest);
+
+		/////////////////////////////////////////////////////////////////////////
+		// Sources
+
+		/// \brief Image data in the filtering space, RGBA floats
+		class LinearImage
+		{
+		public:
+			LinearImage() { }
+			LinearImage(int width, int height) : width(width), height(height), pixels((size_t)width * height * 4) { }
+
+			int width = 0;
+			int height = 0;
+			std::vector<float> pixels;
+		};
+
+		class ResampleSource
+		{
+		public:
+			virtual ~ResampleSource() { }
+			virtual int get_width() const = 0;
+			virtual int get_height() const = 0;
+
+			/// \brief Returns the pixels of a block of the source in the filtering space
+			///
+			/// \param out_pitch = Receives the number of floats between the rows of the block
+			virtual const float *read(int x, int y, int width, int height, std::vector<float> &scratch, int &out_pitch) const = 0;
+		};
+
+		class PixelBufferSource : public ResampleSource
+		{
+		public:
+			PixelBufferSource(const PixelBuffer &image, const ResampleColorSpace &color_space)
+				: image(image), color_space(color_space), bytes_per_pixel(image.get_bytes_per_pixel())
+			{
+			}
+
+			int get_width() const override { return image.get_width(); }
+			int get_height() const override { return image.get_height(); }
+
+			const float *read(int x, int y, int width, int height, std::vector<float> &scratch, int &out_pitch) const override
+			{
+				scratch.resize((size_t)width * height * 4);
+				out_pitch = width * 4;
+
+				const unsigned char *src = image.get_data_uint8() + y * image.get_pitch() + x * bytes_per_pixel;
+				PixelConverter converter;
+				converter.convert(scratch.data(), out_pitch * sizeof(float), tf_rgba32f, src, image.get_pitch(), image.get_format(), width, height);
+				to_filter_space(scratch.data(), (size_t)width * height, color_space);
+				return scratch.data();
+			}
+
+		private:
+			const PixelBuffer &image;
+			ResampleColorSpace color_space;
+			int bytes_per_pixel;
+		};
+
+		class LinearImageSource : public ResampleSource
+		{
+		public:
+			LinearImageSource(const LinearImage &image) : image(image) { }
+
+			int get_width() const override { return image.width; }
+			int get_height() const override { return image.height; }
+
+			const float *read(int x, int y, int /*width*/, int /*height*/, std::vector<float> &/*scratch*/, int &out_pitch) const override
+			{
+				out_pitch = image.width * 4;
+				return image.pixels.data() + ((size_t)y * image.width + x) * 4;
+			}
+
+		private:
+			const LinearImage &image;
+		};
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	class PixelResampler_Impl
+	{
+	public:
+		PixelResampler_Impl(WorkQueue *work_queue) : work_queue(work_queue)
+		{
+#ifdef CL_RESAMPLER_SIMD
+			if (is_avx2_supported())
+			{
+				filter_horizontal = filter_horizontal_avx2;
+				filter_vertical = filter_vertical_avx2;
+			}
+			else
+			{
+				filter_horizontal = filter_horizontal_sse2;
+				filter_vertical = filter_vertical_sse2;
+			}
+#endif
+		}
+
+		ResampleColorSpace get_color_space(const PixelBuffer &image) const;
+		void check_image(const PixelBuffer &image) const;
+		void generate_chain(const PixelBuffer &level0, const std::function<void(int level, const PixelBuffer &image)> &store) const;
+		void process(const ResampleSource &source, const ResampleColorSpace &color_space, PixelBuffer *dest, LinearImage *dest_linear) const;
+
+		WorkQueue *work_queue;
+		PixelResampleFilter filter = resample_box;
+		bool srgb = false;
+		bool premultiplied_alpha = false;
+
+		FilterHorizontalFunc filter_horizontal = filter_horizontal_scalar;
+		FilterVerticalFunc filter_vertical = filter_vertical_scalar;
+
+		// Size of the destination blocks filtered by one task
+		static const int tile_width = 256;
+		static const int tile_height = 64;
+	};
+
+	/////////////////////////////////////////////////////////////////////////
+
+	PixelResampler::PixelResampler() : impl(std::make_shared<PixelResampler_Impl>(nullptr))
+	{
+	}
+
+	PixelResampler::PixelResampler(WorkQueue &work_queue) : impl(std::make_shared<PixelResampler_Impl>(&work_queue))
+	{
+	}
+
+	PixelResampler::~PixelResampler()
+	{
+	}
+
+	PixelResampleFilter PixelResampler::get_filter() const
+	{
+		return impl->filter;
+	}
+
+	bool PixelResampler::get_srgb() const
+	{
+		return impl->srgb;
+	}
+
+	bool PixelResampler::get_premultiplied_alpha() const
+	{
+		return impl->premultiplied_alpha;
+	}
+
+	void PixelResampler::set_filter(PixelResampleFilter filter)
+	{
+		impl->filter = filter;
+	}
+
+	void PixelResampler::set_srgb(bool enable)
+	{
+		impl->srgb = enable;
+	}
+
+	void PixelResampler::set_premultiplied_alpha(bool enable)
+	{
+		impl->premultiplied_alpha = enable;
+	}
+
+	PixelBuffer PixelResampler::resample(const PixelBuffer &image, int width, int height)
+	{
+		impl->check_image(image);
+		if (width <= 0 || height <= 0)
+			throw Exception("Invalid resample size");
+
+		ResampleColorSpace color_space = impl->get_color_space(image);
+		PixelBuffer dest(width, height, image.get_format());
+		impl->process(PixelBufferSource(image, color_space), color_space, &dest, nullptr);
+		return dest;
+	}
+
+	PixelBufferSet PixelResampler::create_mipmaps(const PixelBuffer &image)
+	{
+		impl->check_image(image);
+		PixelBufferSet image_set(image);
+		generate_mipmaps(image_set);
+		return image_set;
+	}
+
+	void PixelResampler::generate_mipmaps(PixelBufferSet &image_set)
+	{
+		image_set.throw_if_null();
+		if (image_set.get_dimensions() == texture_3d)
+			throw Exception("PixelResampler cannot generate mipmaps for 3D textures");
+
+		for (int slice = 0; slice < image_set.get_slice_count(); slice++)
+		{
+			PixelBuffer level0 = image_set.get_image(slice, 0);
+			if (level0.is_null())
+				throw Exception("Level 0 missing from pixel buffer set");
+			impl->check_image(level0);
+
+			impl->generate_chain(level0, [&](int level, const PixelBuffer &image)
+			{
+				image_set.set_image(slice, level, image);
+			});
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	ResampleColorSpace PixelResampler_Impl::get_color_space(const PixelBuffer &image) const
+	{
+		TextureFormat format = image.get_format();
+
+		ResampleColorSpace color_space;
+		color_space.srgb = srgb || format == tf_srgb8 || format == tf_srgb8_alpha8;
+		color_space.srgb_8bit = is_8bit_format(format);
+		color_space.alpha_weighted = !premultiplied_alpha && image.has_transparency();
+		return color_space;
+	}
+
+	void PixelResampler_Impl::check_image(const PixelBuffer &image) const
+	{
+		image.throw_if_null();
+		if (image.is_gpu())
+			throw Exception("PixelResampler requires a CPU pixel buffer");
+		if (image.is_compressed())
+			throw Exception("PixelResampler does not support compressed pixel buffers");
+	}
+
+	void PixelResampler_Impl::generate_chain(const PixelBuffer &level0, const std::function<void(int level, const PixelBuffer &image)> &store) const
+	{
+		ResampleColorSpace color_space = get_color_space(level0);
+
+		// Each level is filtered from the previous one, kept in the filtering space so that the rounding
+		// to the texture format does not accumulate down the chain
+		LinearImage previous;
+		int width = level0.get_width();
+		int height = level0.get_height();
+		for (int level = 1; width > 1 || height > 1; level++)
+		{
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+			bool last_level = (width == 1 && height == 1);
+
+			PixelBuffer dest(width, height, level0.get_format());
+			LinearImage next;
+			if (!last_level)
+				next = LinearImage(width, height);
+
+			if (level == 1)
+				process(PixelBufferSource(level0, color_space), color_space, &dest, last_level ? nullptr : &next);
+			else
+				process(LinearImageSource(previous), color_space, &dest, last_level ? nullptr : &next);
+
+			store(level, dest);
+			previous = std::move(next);
+		}
+	}
+
+	void PixelResampler_Impl::process(const ResampleSource &source, const ResampleColorSpace &color_space, PixelBuffer *dest, LinearImage *dest_linear) const
+	{
+		int dest_width = dest->get_width();
+		int dest_height = dest->get_height();
+		ResampleTaps horizontal_taps(filter, source.get_width(), dest_width);
+		ResampleTaps vertical_taps(filter, source.get_height(), dest_height);
+
+		unsigned char *dest_data = dest->get_data_uint8();
+		int dest_pitch = dest->get_pitch();
+		int dest_bytes_per_pixel = dest->get_bytes_per_pixel();
+		TextureFormat dest_format = dest->get_format();
+
+		int tiles_x = (dest_width + tile_width - 1) / tile_width;
+		int tiles_y = (dest_height + tile_height - 1) / tile_height;
+
+		auto process_tiles = [&](int tile_begin, int tile_end)
+		{
+			std::vector<float> source_scratch, horizontal, output;
+			PixelConverter converter;
+
+			for (int tile = tile_begin; tile < tile_end; tile++)
+			{
+				int x0 = (tile % tiles_x) * tile_width;
+				int y0 = (tile / tiles_x) * tile_height;
+				int x1 = std::min(x0 + tile_width, dest_width);
+				int y1 = std::min(y0 + tile_height, dest_height);
+
+				// Source block covered by the filter windows of the tile
+				int src_x0 = horizontal_taps.first[x0];
+				int src_x1 = horizontal_taps.first[x1 - 1] + horizontal_taps.num_taps;
+				int src_y0 = vertical_taps.first[y0];
+				int src_y1 = vertical_taps.first[y1 - 1] + vertical_taps.num_taps;
+
+				int src_pitch = 0;
+				const float *src = source.read(src_x0, src_y0, src_x1 - src_x0, src_y1 - src_y0, source_scratch, src_pitch);
+
+				// Filter horizontally first, so the vertical pass works on the narrower rows
+				int tile_pitch = (x1 - x0) * 4;
+				horizontal.resize((size_t)(src_y1 - src_y0) * tile_pitch);
+				for (int y = src_y0; y < src_y1; y++)
+				{
+					filter_horizontal(src + (y - src_y0) * src_pitch, src_x0, &horizontal_taps.first[x0], &horizontal_taps.weights[x0 * horizontal_taps.num_taps],
+						horizontal_taps.num_taps, x1 - x0, horizontal.data() + (y - src_y0) * tile_pitch);
+				}
+
+				output.resize((size_t)(y1 - y0) * tile_pitch);
+				for (int y = y0; y < y1; y++)
+				{
+					filter_vertical(horizontal.data() + (vertical_taps.first[y] - src_y0) * tile_pitch, tile_pitch, &vertical_taps.weights[y * vertical_taps.num_taps],
+						vertical_taps.num_taps, tile_pitch, output.data() + (y - y0) * tile_pitch);
+				}
+
+				if (dest_linear)
+				{
+					for (int y = y0; y < y1; y++)
+						memcpy(dest_linear->pixels.data() + ((size_t)y * dest_width + x0) * 4, output.data() + (y - y0) * tile_pitch, tile_pitch * sizeof(float));
+				}
+
+				from_filter_space(output.data(), output.size() / 4, color_space);
+				converter.convert(dest_data + y0 * dest_pitch + x0 * dest_bytes_per_pixel, dest_pitch, dest_format, output.data(), tile_pitch * sizeof(float), tf_rgba32f, x1 - x0, y1 - y0);
+			}
+		};
+
+		int num_tiles = tiles_x * tiles_y;
+		if (work_queue && num_tiles > 1)
+			parallel_for(*work_queue, 0, num_tiles, 1, process_tiles);
+		else
+			process_tiles(0, num_tiles);
+	}
+}
@@ -47,6 +47,7 @@ namespace clan
 			Vec4ub *d = static_cast<Vec4ub *>(output);
 
 			__m128 value255f = _mm_set1_ps(255.0f);
+			__m128 half = _mm_set1_ps(0.5f);
 			int sse_length = (num_pixels / 4) * 4;
 			for (int i = 0; i < sse_length; i += 4)
 			{
@@ -55,10 +56,10 @@ namespace clan
 				__m128 pixel2 = _mm_loadu_ps(reinterpret_cast<const float*>(input + i + 2));
 				__m128 pixel3 = _mm_loadu_ps(reinterpret_cast<const float*>(input + i + 3));
 
-				pixel0 = _mm_mul_ps(pixel0, value255f);
-				pixel1 = _mm_mul_ps(pixel1, value255f);
-				pixel2 = _mm_mul_ps(pixel2, value255f);
-				pixel3 = _mm_mul_ps(pixel3, value255f);
+				pixel0 = _mm_add_ps(_mm_mul_ps(pixel0, value255f), half);
+				pixel1 = _mm_add_ps(_mm_mul_ps(pixel1, value255f), half);
+				pixel2 = _mm_add_ps(_mm_mul_ps(pixel2, value255f), half);
+				pixel3 = _mm_add_ps(_mm_mul_ps(pixel3, value255f), half);
 
 				__m128i ushort_pixel0 = _mm_packs_epi32(_mm_cvttps_epi32(pixel0), _mm_cvttps_epi32(pixel1));
 				__m128i ushort_pixel1 = _mm_packs_epi32(_mm_cvttps_epi32(pixel2), _mm_cvttps_epi32(pixel3));
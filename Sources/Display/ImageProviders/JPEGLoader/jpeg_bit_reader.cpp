@@ -33,49 +33,68 @@
 namespace clan
 {
 	JPEGBitReader::JPEGBitReader(JPEGFileReader *reader)
-		: reader(reader), length(0), pos(0), bitpos(0)
+		: reader(reader), data(nullptr), length(0), pos(0), end_of_data(false), bit_buffer(0), bit_count(0), padding_bits(0)
 	{
 		buffer.resize(16 * 1024);
+		data = &buffer[0];
 	}
 
-	void JPEGBitReader::reset()
+	JPEGBitReader::JPEGBitReader(const unsigned char *data, int length)
+		: reader(nullptr), data(data), length(length), pos(0), end_of_data(false), bit_buffer(0), bit_count(0), padding_bits(0)
 	{
-		length = 0;
-		pos = 0;
-		bitpos = 0;
-		buffer.resize(16 * 1024);
 	}
 
-	unsigned int JPEGBitReader::get_bit()
+	void JPEGBitReader::reset()
 	{
-		if (bitpos == 8)
-		{
-			pos++;
-			bitpos = 0;
-		}
-		if (pos == length)
+		// Any bits left belong to the segment that just ended
+		if (reader)
 		{
-			length = reader->read_entropy_data(&buffer[0], buffer.size());
-			if (length == 0)
-			{
-				//JPEGMarker marker = reader->read_marker();
-				throw Exception("Premature end of JPEG entropy data");
-			}
+			length = 0;
 			pos = 0;
 		}
-
-		unsigned int v = (buffer[pos] >> (7 - bitpos)) & 0x01;
-		bitpos++;
-		return v;
+		end_of_data = false;
+		bit_buffer = 0;
+		bit_count = 0;
+		padding_bits = 0;
 	}
 
-	unsigned int JPEGBitReader::get_bits(int count)
+	void JPEGBitReader::fill_bits()
 	{
-		int v = 0;
-		for (int i = 0; i < count; i++)
+		if (pos + 8 <= length)
+		{
+			// Load eight bytes and keep the whole ones that fit. The bits of the partial byte are
+			// identical to the ones shifted in when it is loaded again by the next refill.
+			const unsigned char *p = data + pos;
+			uint64_t v =
+				(static_cast<uint64_t>(p[0]) << 56) | (static_cast<uint64_t>(p[1]) << 48) | (static_cast<uint64_t>(p[2]) << 40) | (static_cast<uint64_t>(p[3]) << 32) |
+				(static_cast<uint64_t>(p[4]) << 24) | (static_cast<uint64_t>(p[5]) << 16) | (static_cast<uint64_t>(p[6]) << 8) | static_cast<uint64_t>(p[7]);
+			bit_buffer |= v >> bit_count;
+			int bytes = (63 - bit_count) >> 3;
+			pos += bytes;
+			bit_count += bytes * 8;
+			return;
+		}
+
+		while (bit_count <= 56)
 		{
-			v = (v << 1) | get_bit();
+			if (pos == length && !end_of_data && reader)
+			{
+				length = reader->read_entropy_data(&buffer[0], buffer.size());
+				pos = 0;
+				end_of_data = (length == 0);
+			}
+
+			if (pos < length)
+			{
+				bit_buffer |= static_cast<uint64_t>(data[pos++]) << (56 - bit_count);
+			}
+			else
+			{
+				// Pad with zeros after the end of the segment. Only an error if the padding gets consumed.
+				end_of_data = true;
+				padding_bits += 8;
+			}
+			bit_count += 8;
 		}
-		return v;
 	}
 }
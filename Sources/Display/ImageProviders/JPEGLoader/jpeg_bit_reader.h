@@ -32,20 +32,70 @@ namespace clan
 {
 	class JPEGFileReader;
 
+	/// \brief Reads the bits of entropy coded JPEG data
+	///
+	/// Bits are kept in a 64 bit buffer, refilled up to eight bytes at a time, so that a Huffman decoder can peek ahead.
+	/// Reading past the end of the entropy coded segment yields zero bits until more than the peeked bits are consumed.
 	class JPEGBitReader
 	{
 	public:
+		/// \brief Reads entropy data from the file up to the next marker
 		JPEGBitReader(JPEGFileReader *reader);
 
+		/// \brief Reads an entropy coded segment that has already been unstuffed into memory
+		JPEGBitReader(const unsigned char *data, int length);
+
 		void reset();
 		unsigned int get_bit();
 		unsigned int get_bits(int count);
 
+		/// \brief Returns the next count bits (at most 32) without consuming them
+		unsigned int peek_bits(int count);
+		void skip_bits(int count);
+
 	private:
+		void fill_bits();
+
 		JPEGFileReader *reader;
 		std::vector<unsigned char> buffer;
+		const unsigned char *data;
 		int length;
 		int pos;
-		int bitpos;
+		bool end_of_data;
+
+		uint64_t bit_buffer;
+		int bit_count;
+		int padding_bits;
 	};
+
+	inline unsigned int JPEGBitReader::peek_bits(int count)
+	{
+		if (bit_count < 32)
+			fill_bits();
+		return static_cast<unsigned int>(bit_buffer >> (64 - count));
+	}
+
+	inline void JPEGBitReader::skip_bits(int count)
+	{
+		bit_buffer <<= count;
+		bit_count -= count;
+		if (bit_count < padding_bits)
+			throw Exception("Premature end of JPEG entropy data");
+	}
+
+	inline unsigned int JPEGBitReader::get_bit()
+	{
+		unsigned int v = peek_bits(1);
+		skip_bits(1);
+		return v;
+	}
+
+	inline unsigned int JPEGBitReader::get_bits(int count)
+	{
+		if (count == 0)
+			return 0;
+		unsigned int v = peek_bits(count);
+		skip_bits(count);
+		return v;
+	}
 }
@@ -34,6 +34,7 @@ namespace clan
 	{
 	public:
 		void resize(size_t size);
+		void clear();
 		short *get(size_t index);
 
 	private:
@@ -45,6 +46,11 @@ namespace clan
 		dcts.resize(size * 64, 0);
 	}
 
+	inline void JPEGComponentDCTs::clear()
+	{
+		std::fill(dcts.begin(), dcts.end(), 0);
+	}
+
 	inline short *JPEGComponentDCTs::get(size_t index)
 	{
 		if (dcts.size() < (index + 1) * 64)
@@ -30,13 +30,11 @@
 
 namespace clan
 {
-	struct JPEGHuffmanNode;
-
 	class JPEGHuffmanTable
 	{
 	public:
-		JPEGHuffmanTable() : table_class(dc_table), table_index(0) { for (auto & elem : bits) elem = 0; }
-		void build_tree();
+		JPEGHuffmanTable() : table_class(dc_table), table_index(0), defined(false) { for (auto & elem : bits) elem = 0; }
+		void build_lookup();
 
 		enum TableClass
 		{
@@ -51,53 +49,54 @@ namespace clan
 		uint8_t bits[16];
 		std::vector<uint8_t> values;
 
-		std::vector<JPEGHuffmanNode> tree;
-	};
+		// Codes up to this length are decoded with a single lookup
+		enum { lookahead_bits = 9 };
 
-	typedef std::vector<JPEGHuffmanTable> JPEGDefineHuffmanTable;
+		// Length of the code in the high byte and its value in the low byte. Zero for longer codes.
+		uint16_t lookup[1 << lookahead_bits];
 
-	struct JPEGHuffmanNode
-	{
-		JPEGHuffmanNode() : leaf(false), value(0) { children[0] = 0; children[1] = 0; }
+		// Canonical code ranges for each code length, used for codes longer than lookahead_bits
+		int maxcode[17];
+		int mincode[17];
+		int valptr[17];
 
-		bool leaf;
-		int children[2];
-		unsigned int value;
+		bool defined;
 	};
 
-	inline void JPEGHuffmanTable::build_tree()
+	typedef std::vector<JPEGHuffmanTable> JPEGDefineHuffmanTable;
+
+	inline void JPEGHuffmanTable::build_lookup()
 	{
-		int num_levels;
-		for (num_levels = 16; num_levels > 0; num_levels--)
-		{
-			if (bits[num_levels - 1] != 0)
-				break;
-		}
+		for (auto & elem : lookup)
+			elem = 0;
 
-		tree.clear();
-		tree.push_back(JPEGHuffmanNode());
-		size_t nodes = 1;
-		size_t values_index = 0;
-		for (int level = 0; level < num_levels; level++)
+		int code = 0;
+		int values_index = 0;
+		for (int length = 1; length <= 16; length++)
 		{
-			size_t parents = tree.size() - nodes;
-			size_t child_nodes = nodes * 2;
-			for (size_t c = 0; c < child_nodes; c++)
+			int count = bits[length - 1];
+			if (values_index + count > (int)values.size() || code + count > (1 << length))
+				throw Exception("Invalid JPEG File");
+
+			mincode[length] = code;
+			valptr[length] = values_index;
+			maxcode[length] = count > 0 ? code + count - 1 : -1;
+
+			if (length <= lookahead_bits)
 			{
-				JPEGHuffmanNode child;
-				if (c < bits[level])
+				int shift = lookahead_bits - length;
+				for (int i = 0; i < count; i++)
 				{
-					if (values_index >= values.size())
-						throw Exception("Invalid JPEG File");
-					child.leaf = true;
-					child.value = values[values_index];
-					values_index++;
+					uint16_t entry = (length << 8) | values[values_index + i];
+					for (int j = (code + i) << shift; j < (code + i + 1) << shift; j++)
+						lookup[j] = entry;
 				}
-
-				tree[parents + c / 2].children[c % 2] = tree.size();
-				tree.push_back(child);
 			}
-			nodes = child_nodes - bits[level];
+
+			code = (code + count) << 1;
+			values_index += count;
 		}
+
+		defined = true;
 	}
 }
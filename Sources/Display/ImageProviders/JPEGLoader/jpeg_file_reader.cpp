@@ -244,7 +244,7 @@ namespace clan
 
 			p += 17 + bindings;
 
-			table.build_tree();
+			table.build_lookup();
 			tables.push_back(table);
 		}
 
@@ -33,29 +33,18 @@
 
 namespace clan
 {
-	unsigned int JPEGHuffmanDecoder::decode(JPEGBitReader &reader, const JPEGHuffmanTable &table)
+	unsigned int JPEGHuffmanDecoder::decode_long_code(JPEGBitReader &reader, const JPEGHuffmanTable &table)
 	{
-		int node = 0;
-		while (true)
+		unsigned int bits = reader.peek_bits(16);
+		for (int length = JPEGHuffmanTable::lookahead_bits + 1; length <= 16; length++)
 		{
-			unsigned int bit = reader.get_bit();
-			node = table.tree[node].children[bit];
-			if (node == 0 || node == table.tree.size())
-				break;
-			else if (table.tree[node].leaf)
-				return table.tree[node].value;
+			int code = bits >> (16 - length);
+			if (code <= table.maxcode[length])
+			{
+				reader.skip_bits(length);
+				return table.values[table.valptr[length] + code - table.mincode[length]];
+			}
 		}
 		throw Exception("Invalid JPEG Huffman encoding");
 	}
-
-	short JPEGHuffmanDecoder::decode_number(JPEGBitReader &reader, int length)
-	{
-		if (length == 0)
-			return 0;
-		int v = reader.get_bits(length);
-		if ((v) < (1 << ((length)-1)))
-			return (v)+(((-1) << (length)) + 1);
-		else
-			return v;
-	}
 }
@@ -32,53 +32,18 @@
 #include "jpeg_huffman_decoder.h"
 #include "jpeg_mcu_decoder.h"
 #include "jpeg_rgb_decoder.h"
+#include "API/Core/System/task_group.h"
 
 namespace clan
 {
-	PixelBuffer JPEGLoader::load(IODevice iodevice, bool srgb)
+	PixelBuffer JPEGLoader::load(IODevice iodevice, bool srgb, WorkQueue *work_queue)
 	{
-		JPEGLoader loader(iodevice);
-		JPEGMCUDecoder mcu_decoder(&loader);
-		JPEGRGBDecoder rgb_decoder(&loader);
-
-		int image_width = loader.start_of_frame.width;
-		int image_height = loader.start_of_frame.height;
-		PixelBuffer image(image_width, image_height, srgb ? tf_srgb8_alpha8 : tf_rgba8);
-		unsigned int *image_pixels = reinterpret_cast<unsigned int *>(image.get_data());
-
-		const unsigned int *block_pixels = rgb_decoder.get_pixels();
-		int block_width = rgb_decoder.get_width();
-		int block_height = rgb_decoder.get_height();
-
-		for (int curMcuY = 0, y = 0; curMcuY < loader.mcu_height; curMcuY++, y += block_height)
-		{
-			for (int curMcuX = 0, x = 0; curMcuX < loader.mcu_width; curMcuX++, x += block_width)
-			{
-				mcu_decoder.decode(curMcuX + curMcuY * loader.mcu_width);
-				rgb_decoder.decode(&mcu_decoder);
-
-				int w = min(block_width, image_width - x);
-				int h = min(block_height, image_height - y);
-				for (int yy = 0; yy < h; yy++)
-				{
-					for (int xx = 0; xx < w; xx++)
-					{
-						unsigned int p = block_pixels[xx + yy*block_width];
-						unsigned int red = (p >> 16) & 0xff;
-						unsigned int green = (p >> 8) & 0xff;
-						unsigned int blue = p & 0xff;
-						unsigned int alpha = (p >> 24) & 0xff;
-						image_pixels[x + xx + (y + yy)*image_width] = (alpha << 24) | (blue << 16) | (green << 8) | red;
-					}
-				}
-			}
-		}
-
-		return image;
+		JPEGLoader loader(iodevice, srgb, work_queue);
+		return loader.image;
 	}
 
-	JPEGLoader::JPEGLoader(IODevice iodevice)
-		: progressive(false), scan_count(0), mcu_x(0), mcu_y(0), mcu_width(0), mcu_height(0), restart_interval(0), eobrun(0), is_jfif_jpeg(false), is_adobe_jpeg(false), adobe_app14_transform(1)
+	JPEGLoader::JPEGLoader(IODevice iodevice, bool srgb, WorkQueue *work_queue)
+		: srgb(srgb), work_queue(work_queue), image_decoded(false), progressive(false), scan_count(0), mcu_x(0), mcu_y(0), mcu_width(0), mcu_height(0), restart_interval(0), eobrun(0), is_jfif_jpeg(false), is_adobe_jpeg(false), adobe_app14_transform(1)
 	{
 		JPEGFileReader reader(iodevice);
 
@@ -139,6 +104,63 @@ namespace clan
 
 		if (scan_count == 0 || start_of_frame.height == 0)
 			throw Exception("Invalid JPEG Image");
+
+		if (!image_decoded)
+		{
+			create_image();
+			decode_image();
+		}
+	}
+
+	void JPEGLoader::create_image()
+	{
+		image = PixelBuffer(start_of_frame.width, start_of_frame.height, srgb ? tf_srgb8_alpha8 : tf_rgba8);
+	}
+
+	void JPEGLoader::decode_image()
+	{
+		JPEGMCUDecoder mcu_decoder(this);
+		JPEGRGBDecoder rgb_decoder(this);
+
+		for (int curMcuY = 0; curMcuY < mcu_height; curMcuY++)
+		{
+			for (int curMcuX = 0; curMcuX < mcu_width; curMcuX++)
+			{
+				mcu_decoder.decode(curMcuX + curMcuY * mcu_width);
+				rgb_decoder.decode(&mcu_decoder);
+				write_mcu(rgb_decoder, curMcuX, curMcuY);
+			}
+		}
+
+		image_decoded = true;
+	}
+
+	void JPEGLoader::write_mcu(const JPEGRGBDecoder &rgb_decoder, int mcu_block_x, int mcu_block_y)
+	{
+		const unsigned int *block_pixels = rgb_decoder.get_pixels();
+		int block_width = rgb_decoder.get_width();
+		int block_height = rgb_decoder.get_height();
+
+		int x = mcu_block_x * block_width;
+		int y = mcu_block_y * block_height;
+		int w = min(block_width, (int)start_of_frame.width - x);
+		int h = min(block_height, (int)start_of_frame.height - y);
+
+		unsigned char *image_data = static_cast<unsigned char *>(image.get_data());
+		int image_pitch = image.get_pitch();
+		for (int yy = 0; yy < h; yy++)
+		{
+			unsigned int *image_pixels = reinterpret_cast<unsigned int *>(image_data + (size_t)(y + yy) * image_pitch) + x;
+			for (int xx = 0; xx < w; xx++)
+			{
+				unsigned int p = block_pixels[xx + yy*block_width];
+				unsigned int red = (p >> 16) & 0xff;
+				unsigned int green = (p >> 8) & 0xff;
+				unsigned int blue = p & 0xff;
+				unsigned int alpha = (p >> 24) & 0xff;
+				image_pixels[xx] = (alpha << 24) | (blue << 16) | (green << 8) | red;
+			}
+		}
 	}
 
 	void JPEGLoader::process_app0(JPEGFileReader &reader)
@@ -184,7 +206,6 @@ namespace clan
 			progressive = (marker == marker_sof2);
 
 			start_of_frame = reader.read_sof();
-			component_dcts.resize(start_of_frame.components.size());
 
 			for (auto & elem : start_of_frame.components)
 			{
@@ -195,9 +216,6 @@ namespace clan
 			mcu_width = (start_of_frame.width + (mcu_x * 8 - 1)) / (mcu_x * 8);
 			mcu_height = (start_of_frame.height + (mcu_y * 8 - 1)) / (mcu_y * 8);
 
-			for (size_t c = 0; c < component_dcts.size(); c++)
-				component_dcts[c].resize(mcu_width*mcu_height*start_of_frame.components[c].horz_sampling_factor*start_of_frame.components[c].vert_sampling_factor);
-
 			last_dc_values.resize(start_of_frame.components.size());
 		}
 		else
@@ -249,10 +267,28 @@ namespace clan
 				throw Exception("Invalid JPEG file");
 		}
 
-		if (progressive)
-			process_sos_progressive(start_of_scan, component_to_sof, reader);
+		if (!progressive && is_streamable_scan(start_of_scan))
+		{
+			// The scan holds the complete image, so MCUs go straight to the IDCT and colour conversion
+			verify_dc_table_selector(start_of_scan);
+			verify_ac_table_selector(start_of_scan);
+			create_image();
+			if (work_queue && restart_interval != 0)
+				process_sos_restart_segments(start_of_scan, component_to_sof, reader);
+			else
+				process_sos_streaming(start_of_scan, component_to_sof, reader);
+			image_decoded = true;
+		}
 		else
-			process_sos_sequential(start_of_scan, component_to_sof, reader);
+		{
+			if (component_dcts.empty())
+				allocate_component_dcts();
+
+			if (progressive)
+				process_sos_progressive(start_of_scan, component_to_sof, reader);
+			else
+				process_sos_sequential(start_of_scan, component_to_sof, reader);
+		}
 
 		scan_count++;
 	}
@@ -261,7 +297,7 @@ namespace clan
 	{
 		for (auto & elem : start_of_scan.components)
 		{
-			if (huffman_dc_tables[elem.dc_table_selector].tree.empty())
+			if (!huffman_dc_tables[elem.dc_table_selector].defined)
 				throw Exception("Invalid JPEG file");
 		}
 	}
@@ -270,7 +306,7 @@ namespace clan
 	{
 		for (auto & elem : start_of_scan.components)
 		{
-			if (huffman_ac_tables[elem.ac_table_selector].tree.empty())
+			if (!huffman_ac_tables[elem.ac_table_selector].defined)
 				throw Exception("Invalid JPEG file");
 		}
 	}
@@ -311,11 +347,7 @@ namespace clan
 		{
 			if (restart_interval != 0 && restart_counter == restart_interval)
 			{
-				JPEGMarker marker = reader.read_marker();
-				if (marker < marker_rst0 || marker > marker_rst7)
-				{
-					throw Exception("Restart marker missing between JPEG entropy data");
-				}
+				read_restart_marker(reader);
 				restart_counter = 0;
 				for (auto & elem : last_dc_values)
 					elem = 0;
@@ -324,52 +356,227 @@ namespace clan
 			}
 			restart_counter++;
 
-			for (size_t c = 0; c < start_of_scan.components.size(); c++)
+			decode_sequential_mcu(bit_reader, start_of_scan, component_to_sof, last_dc_values.data(), component_dcts, mcu_block);
+		}
+	}
+
+	bool JPEGLoader::is_streamable_scan(const JPEGStartOfScan &start_of_scan) const
+	{
+		// A baseline scan with every component interleaved and the full spectrum is the only scan of the image
+		return scan_count == 0 &&
+			start_of_frame.height > 0 &&
+			start_of_scan.components.size() == start_of_frame.components.size() &&
+			start_of_scan.start_dct_coefficient == 0 &&
+			start_of_scan.end_dct_coefficient == 63 &&
+			start_of_scan.point_transform == 0;
+	}
+
+	void JPEGLoader::read_restart_marker(JPEGFileReader &reader)
+	{
+		JPEGMarker marker = reader.read_marker();
+		if (marker < marker_rst0 || marker > marker_rst7)
+		{
+			throw Exception("Restart marker missing between JPEG entropy data");
+		}
+	}
+
+	void JPEGLoader::decode_sequential_mcu(JPEGBitReader &bit_reader, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, short *dc_values, std::vector<JPEGComponentDCTs> &dcts, int mcu_block) const
+	{
+		for (size_t c = 0; c < start_of_scan.components.size(); c++)
+		{
+			int c_sof = component_to_sof[c];
+			const JPEGHuffmanTable &dc_table = huffman_dc_tables[start_of_scan.components[c].dc_table_selector];
+			const JPEGHuffmanTable &ac_table = huffman_ac_tables[start_of_scan.components[c].ac_table_selector];
+			int scale_x = start_of_frame.components[c_sof].horz_sampling_factor;
+			int scale_y = start_of_frame.components[c_sof].vert_sampling_factor;
+			for (int i = 0; i < scale_x * scale_y; i++)
 			{
-				int c_sof = component_to_sof[c];
-				const JPEGHuffmanTable &dc_table = huffman_dc_tables[start_of_scan.components[c].dc_table_selector];
-				const JPEGHuffmanTable &ac_table = huffman_ac_tables[start_of_scan.components[c].ac_table_selector];
-				int scale_x = start_of_frame.components[c_sof].horz_sampling_factor;
-				int scale_y = start_of_frame.components[c_sof].vert_sampling_factor;
-				for (int i = 0; i < scale_x * scale_y; i++)
+				short *dct = dcts[c_sof].get(mcu_block*scale_x*scale_y + i);
+				for (int j = start_of_scan.start_dct_coefficient; j <= start_of_scan.end_dct_coefficient; j++)
 				{
-					short *dct = component_dcts[c_sof].get(mcu_block*scale_x*scale_y + i);
-					for (int j = start_of_scan.start_dct_coefficient; j <= start_of_scan.end_dct_coefficient; j++)
+					if (j == 0) // DCT DC coefficient
 					{
-						if (j == 0) // DCT DC coefficient
-						{
-							unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, dc_table);
-							if (code != huffman_eob)
-								dct[0] = JPEGHuffmanDecoder::decode_number(bit_reader, code);
-							dct[0] <<= start_of_scan.point_transform;
+						unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, dc_table);
+						if (code != huffman_eob)
+							dct[0] = JPEGHuffmanDecoder::decode_number(bit_reader, code);
+						dct[0] <<= start_of_scan.point_transform;
 
-							dct[0] += last_dc_values[c_sof];
-							last_dc_values[c_sof] = dct[0];
-						}
-						else // DCT AC coefficient
+						dct[0] += dc_values[c_sof];
+						dc_values[c_sof] = dct[0];
+					}
+					else // DCT AC coefficient
+					{
+						unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, ac_table);
+						if (code != huffman_eob)
 						{
-							unsigned int code = JPEGHuffmanDecoder::decode(bit_reader, ac_table);
-							if (code != huffman_eob)
-							{
-								unsigned int zeros = (code >> 4);
-								j += zeros;
-								if (j <= start_of_scan.end_dct_coefficient)
-								{
-									dct[zigzag_map[j]] = JPEGHuffmanDecoder::decode_number(bit_reader, code & 0x0f);
-									dct[zigzag_map[j]] <<= start_of_scan.point_transform;
-								}
-							}
-							else
+							unsigned int zeros = (code >> 4);
+							j += zeros;
+							if (j <= start_of_scan.end_dct_coefficient)
 							{
-								break;
+								dct[zigzag_map[j]] = JPEGHuffmanDecoder::decode_number(bit_reader, code & 0x0f);
+								dct[zigzag_map[j]] <<= start_of_scan.point_transform;
 							}
 						}
+						else
+						{
+							break;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void JPEGLoader::process_sos_streaming(const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader)
+	{
+		// Coefficients are only kept for one MCU row while it is transformed, plus the row being decoded when a worker does the transform
+		std::vector<JPEGComponentDCTs> row_dcts[2] = { create_mcu_dcts(mcu_width), create_mcu_dcts(mcu_width) };
+
+		std::unique_ptr<TaskGroup> tasks;
+		if (work_queue)
+			tasks.reset(new TaskGroup(*work_queue));
+
+		try
+		{
+			JPEGBitReader bit_reader(&reader);
+			std::vector<short> dc_values(start_of_frame.components.size());
+			int restart_counter = 0;
+			for (int mcu_row = 0; mcu_row < mcu_height; mcu_row++)
+			{
+				std::vector<JPEGComponentDCTs> &dcts = row_dcts[mcu_row % 2];
+				for (auto & elem : dcts)
+					elem.clear();
+
+				for (int mcu_col = 0; mcu_col < mcu_width; mcu_col++)
+				{
+					if (restart_interval != 0 && restart_counter == restart_interval)
+					{
+						read_restart_marker(reader);
+						restart_counter = 0;
+						for (auto & elem : dc_values)
+							elem = 0;
+						bit_reader.reset();
 					}
+					restart_counter++;
+
+					decode_sequential_mcu(bit_reader, start_of_scan, component_to_sof, dc_values.data(), dcts, mcu_col);
+				}
+
+				if (tasks)
+				{
+					tasks->wait();
+					std::vector<JPEGComponentDCTs> *row = &dcts;
+					tasks->run([=]() { decode_mcu_row(*row, mcu_row); });
+				}
+				else
+				{
+					decode_mcu_row(dcts, mcu_row);
+				}
+			}
+
+			if (tasks)
+				tasks->wait();
+		}
+		catch (...)
+		{
+			// Queued tasks reference the row coefficients and must finish before they are freed
+			if (tasks)
+			{
+				try { tasks->wait(); } catch (...) { }
+			}
+			throw;
+		}
+	}
+
+	void JPEGLoader::process_sos_restart_segments(const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader)
+	{
+		// Restart markers reset the DC predictions, so every segment between them can be decoded independently.
+		// Segments are read on this thread and entropy decoded, transformed and colour converted on the workers.
+		int mcu_count = mcu_width * mcu_height;
+		int segment_count = (mcu_count + restart_interval - 1) / restart_interval;
+
+		TaskGroup tasks(*work_queue);
+		try
+		{
+			for (int segment_index = 0; segment_index < segment_count; segment_index++)
+			{
+				auto segment = std::make_shared<std::vector<unsigned char>>();
+				while (true)
+				{
+					size_t size = segment->size();
+					segment->resize(size + 16 * 1024);
+					int length = reader.read_entropy_data(segment->data() + size, 16 * 1024);
+					segment->resize(size + length);
+					if (length == 0)
+						break;
 				}
+
+				if (segment_index + 1 < segment_count)
+					read_restart_marker(reader);
+
+				int first_mcu = segment_index * restart_interval;
+				int segment_mcu_count = min((int)restart_interval, mcu_count - first_mcu);
+				tasks.run([=]() { decode_restart_segment(*segment, start_of_scan, component_to_sof, first_mcu, segment_mcu_count); });
 			}
+
+			tasks.wait();
+		}
+		catch (...)
+		{
+			// Queued tasks write into the image
+			try { tasks.wait(); } catch (...) { }
+			throw;
+		}
+	}
+
+	void JPEGLoader::decode_restart_segment(const std::vector<unsigned char> &segment, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, int first_mcu, int mcu_count)
+	{
+		JPEGBitReader bit_reader(segment.data(), segment.size());
+		std::vector<short> dc_values(start_of_frame.components.size());
+		std::vector<JPEGComponentDCTs> dcts = create_mcu_dcts(1);
+
+		JPEGMCUDecoder mcu_decoder(this);
+		JPEGRGBDecoder rgb_decoder(this);
+
+		for (int mcu_block = first_mcu; mcu_block < first_mcu + mcu_count; mcu_block++)
+		{
+			for (auto & elem : dcts)
+				elem.clear();
+
+			decode_sequential_mcu(bit_reader, start_of_scan, component_to_sof, dc_values.data(), dcts, 0);
+
+			mcu_decoder.decode(dcts, 0);
+			rgb_decoder.decode(&mcu_decoder);
+			write_mcu(rgb_decoder, mcu_block % mcu_width, mcu_block / mcu_width);
+		}
+	}
+
+	void JPEGLoader::decode_mcu_row(std::vector<JPEGComponentDCTs> &dcts, int mcu_row)
+	{
+		JPEGMCUDecoder mcu_decoder(this);
+		JPEGRGBDecoder rgb_decoder(this);
+
+		for (int mcu_col = 0; mcu_col < mcu_width; mcu_col++)
+		{
+			mcu_decoder.decode(dcts, mcu_col);
+			rgb_decoder.decode(&mcu_decoder);
+			write_mcu(rgb_decoder, mcu_col, mcu_row);
 		}
 	}
 
+	std::vector<JPEGComponentDCTs> JPEGLoader::create_mcu_dcts(int mcu_count) const
+	{
+		std::vector<JPEGComponentDCTs> dcts(start_of_frame.components.size());
+		for (size_t c = 0; c < dcts.size(); c++)
+			dcts[c].resize(mcu_count*start_of_frame.components[c].horz_sampling_factor*start_of_frame.components[c].vert_sampling_factor);
+		return dcts;
+	}
+
+	void JPEGLoader::allocate_component_dcts()
+	{
+		component_dcts = create_mcu_dcts(mcu_width*mcu_height);
+	}
+
 	void JPEGLoader::process_sos_progressive(JPEGStartOfScan &start_of_scan, std::vector<int> component_to_sof, JPEGFileReader &reader)
 	{
 		JPEGBitReader bit_reader(&reader);
@@ -382,11 +589,7 @@ namespace clan
 			{
 				if (restart_interval != 0 && restart_counter == restart_interval)
 				{
-					JPEGMarker marker = reader.read_marker();
-					if (marker < marker_rst0 || marker > marker_rst7)
-					{
-						throw Exception("Restart marker missing between JPEG entropy data");
-					}
+					read_restart_marker(reader);
 					restart_counter = 0;
 					for (auto & elem : last_dc_values)
 						elem = 0;
@@ -445,11 +648,7 @@ namespace clan
 			{
 				if (restart_interval != 0 && restart_counter == restart_interval)
 				{
-					JPEGMarker marker = reader.read_marker();
-					if (marker < marker_rst0 || marker > marker_rst7)
-					{
-						throw Exception("Restart marker missing between JPEG entropy data");
-					}
+					read_restart_marker(reader);
 					restart_counter = 0;
 					for (auto & elem : last_dc_values)
 						elem = 0;
@@ -41,11 +41,13 @@
 namespace clan
 {
 	class JPEGBitReader;
+	class JPEGRGBDecoder;
+	class WorkQueue;
 
 	class JPEGLoader
 	{
 	public:
-		static PixelBuffer load(IODevice iodevice, bool srgb);
+		static PixelBuffer load(IODevice iodevice, bool srgb, WorkQueue *work_queue = nullptr);
 
 	private:
 		enum ColorSpace
@@ -57,7 +59,7 @@ namespace clan
 			colorspace_grayscale
 		};
 
-		JPEGLoader(IODevice iodevice);
+		JPEGLoader(IODevice iodevice, bool srgb, WorkQueue *work_queue);
 
 		void process_app0(JPEGFileReader &reader);
 		void process_app14(JPEGFileReader &reader);
@@ -65,6 +67,18 @@ namespace clan
 		void process_sos(JPEGFileReader &reader);
 		void process_sos_sequential(JPEGStartOfScan &start_of_scan, std::vector<int> component_to_sof, JPEGFileReader &reader);
 		void process_sos_progressive(JPEGStartOfScan &start_of_scan, std::vector<int> component_to_sof, JPEGFileReader &reader);
+		void process_sos_streaming(const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader);
+		void process_sos_restart_segments(const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, JPEGFileReader &reader);
+		bool is_streamable_scan(const JPEGStartOfScan &start_of_scan) const;
+		void read_restart_marker(JPEGFileReader &reader);
+		void decode_sequential_mcu(JPEGBitReader &bit_reader, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, short *dc_values, std::vector<JPEGComponentDCTs> &dcts, int mcu_block) const;
+		void decode_mcu_row(std::vector<JPEGComponentDCTs> &dcts, int mcu_row);
+		void decode_restart_segment(const std::vector<unsigned char> &segment, const JPEGStartOfScan &start_of_scan, const std::vector<int> &component_to_sof, int first_mcu, int mcu_count);
+		void decode_image();
+		void create_image();
+		void write_mcu(const JPEGRGBDecoder &rgb_decoder, int mcu_block_x, int mcu_block_y);
+		void allocate_component_dcts();
+		std::vector<JPEGComponentDCTs> create_mcu_dcts(int mcu_count) const;
 		void process_dqt(JPEGFileReader &reader);
 		void process_dht(JPEGFileReader &reader);
 		void process_sof(JPEGMarker marker, JPEGFileReader &reader);
@@ -72,6 +86,11 @@ namespace clan
 		void verify_ac_table_selector(const JPEGStartOfScan &start_of_scan);
 		ColorSpace get_colorspace() const;
 
+		bool srgb;
+		WorkQueue *work_queue;
+		PixelBuffer image;
+		bool image_decoded;
+
 		JPEGStartOfFrame start_of_frame;
 		JPEGHuffmanTable huffman_dc_tables[4];
 		JPEGHuffmanTable huffman_ac_tables[4];
@@ -87,6 +87,11 @@ namespace clan
 	}
 
 	void JPEGMCUDecoder::decode(int block)
+	{
+		decode(loader->component_dcts, block);
+	}
+
+	void JPEGMCUDecoder::decode(std::vector<JPEGComponentDCTs> &component_dcts, int block)
 	{
 		for (size_t c = 0; c < channels.size(); c++)
 		{
@@ -97,7 +102,7 @@ namespace clan
 			{
 				for (int dct_x = 0; dct_x < scale_x; dct_x++)
 				{
-					short *dct = loader->component_dcts[c].get(block * block_size + dct_x + dct_y * scale_x);
+					short *dct = component_dcts[c].get(block * block_size + dct_x + dct_y * scale_x);
 
 #ifdef CL_DISABLE_SSE2
 					idct(dct, channels[c]+dct_x*8+dct_y*scale_x*64, scale_x*8, quant[c]);
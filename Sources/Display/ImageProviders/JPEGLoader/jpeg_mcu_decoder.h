@@ -31,6 +31,7 @@
 namespace clan
 {
 	class JPEGLoader;
+	class JPEGComponentDCTs;
 
 	class JPEGMCUDecoder
 	{
@@ -39,6 +40,7 @@ namespace clan
 		~JPEGMCUDecoder();
 
 		void decode(int block);
+		void decode(std::vector<JPEGComponentDCTs> &component_dcts, int block);
 		int get_channel_count() const { return (int)channels.size(); }
 		const unsigned char *get_channel(int c) const { return channels[c]; }
 
@@ -29,20 +29,132 @@
 #include "Display/precomp.h"
 #include "png_loader.h"
 #include "API/Display/Image/pixel_buffer_lock.h"
-#include "API/Core/Zip/zlib_compression.h"
 #include "API/Core/System/system.h"
+#include "API/Core/System/task_group.h"
 #include "Display/ImageProviders/PNGWriter/png_writer.h"
+#include <algorithm>
+
+#if !defined __ANDROID__ && ! defined CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace clan
 {
-	PixelBuffer PNGLoader::load(IODevice iodevice, bool srgb)
+#ifdef __SSE2__
+	namespace
+	{
+		// The Sub, Average and Paeth predictors depend on the previous pixel of the same scanline, so these
+		// process one pixel per iteration with all of its channels in one register.
+
+		template<int bytes_per_pixel>
+		inline __m128i load_pixel(const unsigned char *p)
+		{
+			uint64_t v = 0;
+			memcpy(&v, p, bytes_per_pixel);
+			return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&v));
+		}
+
+		template<int bytes_per_pixel>
+		inline void store_pixel(unsigned char *p, __m128i pixel)
+		{
+			uint64_t v;
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(&v), pixel);
+			memcpy(p, &v, bytes_per_pixel);
+		}
+
+		template<int bytes_per_pixel>
+		void predictor_sub_sse2(unsigned char *scanline, int byte_length)
+		{
+			__m128i a = _mm_setzero_si128();
+			int i = 0;
+			if (bytes_per_pixel == 4 || bytes_per_pixel == 8)
+			{
+				// Prefix sum of the pixels in a block, plus the last pixel of the previous block broadcast to all of them
+				for (; i + 16 <= byte_length; i += 16)
+				{
+					__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scanline + i));
+					if (bytes_per_pixel == 4)
+						x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+					x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+					x = _mm_add_epi8(x, a);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(scanline + i), x);
+					a = (bytes_per_pixel == 4) ? _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)) : _mm_unpackhi_epi64(x, x);
+				}
+			}
+
+			for (; i < byte_length; i += bytes_per_pixel)
+			{
+				a = _mm_add_epi8(load_pixel<bytes_per_pixel>(scanline + i), a);
+				store_pixel<bytes_per_pixel>(scanline + i, a);
+			}
+		}
+
+		template<int bytes_per_pixel>
+		void predictor_average_sse2(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length)
+		{
+			__m128i one = _mm_set1_epi8(1);
+			__m128i a = _mm_setzero_si128();
+			for (int i = 0; i < byte_length; i += bytes_per_pixel)
+			{
+				__m128i b = load_pixel<bytes_per_pixel>(prev_scanline + i);
+				__m128i x = load_pixel<bytes_per_pixel>(scanline + i);
+
+				// _mm_avg_epu8 rounds up, the predictor rounds down
+				__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+				a = _mm_add_epi8(x, average);
+				store_pixel<bytes_per_pixel>(scanline + i, a);
+			}
+		}
+
+		inline __m128i abs_epi16(__m128i v)
+		{
+			return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+		}
+
+		inline __m128i select_si128(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		template<int bytes_per_pixel>
+		void predictor_paeth_sse2(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length)
+		{
+			__m128i zero = _mm_setzero_si128();
+			__m128i a = zero;
+			__m128i c = zero;
+			for (int i = 0; i < byte_length; i += bytes_per_pixel)
+			{
+				__m128i b = _mm_unpacklo_epi8(load_pixel<bytes_per_pixel>(prev_scanline + i), zero);
+				__m128i x = _mm_unpacklo_epi8(load_pixel<bytes_per_pixel>(scanline + i), zero);
+
+				// With p = a + b - c: p - a = b - c, p - b = a - c and p - c = (b - c) + (a - c)
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = abs_epi16(pa);
+				pb = abs_epi16(pb);
+				pc = abs_epi16(pc);
+
+				// Ties are broken in the order a, b, c
+				__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				__m128i predictor = select_si128(_mm_cmpeq_epi16(smallest, pa), a, select_si128(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+				a = _mm_and_si128(_mm_add_epi16(x, predictor), _mm_set1_epi16(0xff));
+				store_pixel<bytes_per_pixel>(scanline + i, _mm_packus_epi16(a, a));
+				c = b;
+			}
+		}
+	}
+#endif
+
+	PixelBuffer PNGLoader::load(IODevice iodevice, bool srgb, WorkQueue *work_queue)
 	{
-		PNGLoader loader(iodevice, srgb);
+		PNGLoader loader(iodevice, srgb, work_queue);
 		return loader.image;
 	}
 
-	PNGLoader::PNGLoader(IODevice iodevice, bool force_srgb)
-		: file(iodevice), force_srgb(force_srgb), scanline(nullptr), prev_scanline(nullptr), scanline_4ub(nullptr), scanline_4us(nullptr), palette(nullptr)
+	PNGLoader::PNGLoader(IODevice iodevice, bool force_srgb, WorkQueue *work_queue)
+		: file(iodevice), force_srgb(force_srgb), work_queue(work_queue), zstream(), zstream_initialized(false), zero_scanline(nullptr), palette(nullptr)
 	{
 		read_magic();
 		read_chunks();
@@ -50,14 +162,14 @@ namespace clan
 		decode_palette();
 		decode_colorkey();
 		decode_image();
+		read_trailing_chunks();
 	}
 
 	PNGLoader::~PNGLoader()
 	{
-		System::aligned_free(scanline);
-		System::aligned_free(prev_scanline);
-		System::aligned_free(scanline_4ub);
-		System::aligned_free(scanline_4us);
+		if (zstream_initialized)
+			mz_inflateEnd(&zstream);
+		System::aligned_free(zero_scanline);
 		System::aligned_free(palette);
 	}
 
@@ -70,53 +182,51 @@ namespace clan
 			throw Exception("Invalid PNG image file");
 	}
 
+	void PNGLoader::read_chunk(std::string &name, DataBuffer &data)
+	{
+		unsigned int length = file.read_uint32();
+		char chunk_name[5];
+		chunk_name[4] = 0;
+		file.read(chunk_name, 4);
+
+		if (length >= (1u << 31))
+			throw Exception("PNG image file too big!");
+
+		data.set_size(length);
+		file.read(data.get_data(), data.get_size());
+
+		unsigned int crc32 = file.read_uint32();
+
+		unsigned int compare_crc32 = PNGCRC32::crc(chunk_name, data.get_data(), data.get_size());
+		if (crc32 != compare_crc32)
+			throw Exception("CRC32 error");
+
+		name = chunk_name;
+	}
+
 	void PNGLoader::read_chunks()
 	{
 		file.set_big_endian_mode();
 
 		std::map<std::string, DataBuffer> chunks;
 
-		std::vector<DataBuffer> idat_chunks;
-		uint64_t total_idat_size = 0;
-
+		// Read everything up to the first image data chunk. The image data itself is inflated while decoding.
 		while (true)
 		{
-			unsigned int length = file.read_uint32();
-			char name[5];
-			name[4] = 0;
-			file.read(name, 4);
-
-			DataBuffer data(length);
-			file.read(data.get_data(), data.get_size());
+			std::string name;
+			DataBuffer data;
+			read_chunk(name, data);
 
-			unsigned int crc32 = file.read_uint32();
-
-			unsigned int compare_crc32 = PNGCRC32::crc(name, data.get_data(), data.get_size());
-			if (crc32 != compare_crc32)
-				throw Exception("CRC32 error");
-
-			if (name == std::string("IDAT")) // Concatenate all IDAT chunks to one big
-			{
-				total_idat_size += length;
-				idat_chunks.push_back(data);
-			}
-			else
+			if (name == "IDAT")
 			{
-				chunks[name] = data;
-				if (name == std::string("IEND")) // image trailer, which is the last chunk in a PNG datastream.
-					break;
+				idat = data;
+				break;
 			}
-		}
 
-		if (total_idat_size >= (1 << 31))
-			throw Exception("PNG image file too big!");
+			if (name == "IEND") // image trailer, which is the last chunk in a PNG datastream.
+				throw Exception("Invalid PNG image file");
 
-		idat = DataBuffer((int)total_idat_size);
-		int idat_pos = 0;
-		for (auto & idat_chunk : idat_chunks)
-		{
-			memcpy(idat.get_data() + idat_pos, idat_chunk.get_data(), idat_chunk.get_size());
-			idat_pos += idat_chunk.get_size();
+			chunks[name] = data;
 		}
 
 		ihdr = chunks["IHDR"];
@@ -129,10 +239,48 @@ namespace clan
 		sbit = chunks["sBIT"];
 		srgb = chunks["sRGB"];
 
-		if (ihdr.is_null() || idat_chunks.empty() || ihdr.get_size() != 13) // Always required chunks
+		if (ihdr.is_null() || ihdr.get_size() != 13) // Always required chunks
 			throw Exception("Invalid PNG image file");
 	}
 
+	void PNGLoader::read_trailing_chunks()
+	{
+		// Skip any image data left after the last scanline and the ancillary chunks following it
+		std::string name;
+		DataBuffer data;
+		do
+		{
+			read_chunk(name, data);
+		} while (name != "IEND");
+	}
+
+	void PNGLoader::read_next_idat()
+	{
+		std::string name;
+		read_chunk(name, idat);
+		if (name != "IDAT") // Image data ended before the last scanline
+			throw Exception("Invalid PNG image file");
+
+		zstream.next_in = idat.get_data<unsigned char>();
+		zstream.avail_in = idat.get_size();
+	}
+
+	void PNGLoader::read_image_data(void *data, int size)
+	{
+		zstream.next_out = static_cast<unsigned char*>(data);
+		zstream.avail_out = size;
+		while (zstream.avail_out > 0)
+		{
+			int result = mz_inflate(&zstream, MZ_NO_FLUSH);
+			if (result == MZ_BUF_ERROR && zstream.avail_in == 0)
+				read_next_idat();
+			else if (result == MZ_STREAM_END && zstream.avail_out > 0)
+				throw Exception("Invalid PNG image file");
+			else if (result != MZ_OK && result != MZ_STREAM_END)
+				throw Exception("Invalid PNG image file");
+		}
+	}
+
 	void PNGLoader::decode_header()
 	{
 		image_width = from_network_order(*reinterpret_cast<unsigned int*>(ihdr.get_data()));
@@ -144,6 +292,8 @@ namespace clan
 		interlace_method = *reinterpret_cast<unsigned char*>(ihdr.get_data() + 12);
 
 		// Verify image is valid according to the PNG standard (Table 11.1 in http://www.w3.org/TR/PNG/)
+		if (image_width == 0 || image_height == 0)
+			throw Exception("Invalid PNG image file");
 		if (color_type == 1 || color_type == 5 || color_type > 6)
 			throw Exception("Invalid PNG image file");
 		if (bit_depth == 0 || bit_depth == 3 || (bit_depth >= 5 && bit_depth <= 7) || (bit_depth >= 9 && bit_depth <= 15) || bit_depth > 16)
@@ -178,6 +328,8 @@ namespace clan
 			palette = static_cast<Vec4ub *>(System::aligned_alloc(256 * sizeof(Vec4ub)));
 			for (int i = 0; i < num_entries; i++)
 				palette[i] = Vec4ub(entries[i * 3], entries[i * 3 + 1], entries[i * 3 + 2], 255);
+			for (int i = num_entries; i < 256; i++)
+				palette[i] = Vec4ub(0, 0, 0, 255);
 
 			if (!trns.is_null())
 			{
@@ -219,18 +371,25 @@ namespace clan
 
 	void PNGLoader::decode_image()
 	{
-		DataBuffer image_data = ZLibCompression::decompress(idat, false);
-
 		create_image();
-		create_scanline_buffers();
+
+		int scanline_size = get_scanline_size(image_width);
+		zero_scanline = static_cast<unsigned char *>(System::aligned_alloc(scanline_size));
+		memset(zero_scanline, 0, scanline_size);
+
+		if (mz_inflateInit2(&zstream, 15) != MZ_OK)
+			throw Exception("Zlib inflateInit failed");
+		zstream_initialized = true;
+		zstream.next_in = idat.get_data<unsigned char>();
+		zstream.avail_in = idat.get_size();
 
 		if (interlace_method == 0)
 		{
-			decode_interlace_none(reinterpret_cast<const unsigned char*>(image_data.get_data()), image_data.get_size());
+			decode_interlace_none();
 		}
 		else if (interlace_method == 1)
 		{
-			decode_interlace_adam7(reinterpret_cast<const unsigned char*>(image_data.get_data()), image_data.get_size());
+			decode_interlace_adam7();
 		}
 		else
 		{
@@ -246,16 +405,7 @@ namespace clan
 			image = PixelBuffer(image_width, image_height, tf_rgba16);
 	}
 
-	void PNGLoader::create_scanline_buffers()
-	{
-		int size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
-		scanline = static_cast<unsigned char *>(System::aligned_alloc(size));
-		prev_scanline = static_cast<unsigned char *>(System::aligned_alloc(size));
-		scanline_4ub = static_cast<Vec4ub *>(System::aligned_alloc(image_width * sizeof(Vec4ub)));
-		scanline_4us = static_cast<Vec4us *>(System::aligned_alloc(image_width * sizeof(Vec4us)));
-	}
-
-	int PNGLoader::get_image_data_channels()
+	int PNGLoader::get_image_data_channels() const
 	{
 		switch (color_type)
 		{
@@ -268,131 +418,234 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::decode_interlace_none(const unsigned char *data, int data_length)
+	int PNGLoader::get_bytes_per_pixel() const
 	{
-		int scanline_size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
-		if ((1 + scanline_size) * image_height > data_length)
-			throw Exception("Invalid PNG image file");
+		return get_image_data_channels() * ((bit_depth + 7) / 8);
+	}
 
-		for (size_t i = 0; i < scanline_size; i++)
-			scanline[i] = 0;
+	int PNGLoader::get_scanline_size(int pixel_length) const
+	{
+		return (pixel_length * bit_depth * get_image_data_channels() + 7) / 8;
+	}
+
+	void PNGLoader::decode_interlace_none()
+	{
+		// Every row in the image data is a filter type byte followed by the filtered scanline
+		int row_size = 1 + get_scanline_size(image_width);
+		int strip_height = std::max(std::min(strip_byte_size / row_size, (int)image_height), 1);
 
-		int data_pos = 0;
 		PixelBufferLockAny pixels(image);
-		for (int y = 0; y < image_height; y++)
-		{
-			unsigned char *tmp = scanline;
-			scanline = prev_scanline;
-			prev_scanline = tmp;
+		unsigned char *output = pixels.get_data();
+		int output_pitch = pixels.get_pitch();
 
-			int predictor_type = data[data_pos++];
-			memcpy(scanline, data + data_pos, scanline_size);
-			data_pos += scanline_size;
+		std::unique_ptr<TaskGroup> tasks;
+		if (work_queue)
+			tasks.reset(new TaskGroup(*work_queue));
 
-			filter_scanline(predictor_type, scanline_size);
+		// The previous strip holds the prior scanline of the strip being decoded. On a work queue a third strip is
+		// inflated while the task decoding the current one still reads from the previous one.
+		const int num_strips = tasks ? 3 : 2;
+		DataBuffer strips[3];
+		for (int i = 0; i < num_strips; i++)
+			strips[i].set_size(strip_height * row_size);
 
-			if (bit_depth <= 8)
-				convert_scanline_4ub(image_width);
-			else
-				convert_scanline_4us(image_width);
+		try
+		{
+			const unsigned char *prev_scanline = zero_scanline;
+			for (int y = 0, strip = 0; y < (int)image_height; y += strip_height, strip++)
+			{
+				int row_count = std::min(strip_height, (int)image_height - y);
+				unsigned char *rows = strips[strip % num_strips].get_data<unsigned char>();
+				read_image_data(rows, row_count * row_size);
 
-			unsigned char *output_line = pixels.get_row(y);
-			if (bit_depth <= 8)
-				memcpy(output_line, scanline_4ub, image_width * 4);
-			else
-				memcpy(output_line, scanline_4us, image_width * 8);
+				unsigned char *strip_output = output + (size_t)y * output_pitch;
+				if (tasks)
+				{
+					// Scanlines are unfiltered from the one above, so the strips are decoded in order
+					tasks->wait();
+					tasks->run([=]() { decode_rows(rows, prev_scanline, row_count, row_size, strip_output, output_pitch); });
+				}
+				else
+				{
+					decode_rows(rows, prev_scanline, row_count, row_size, strip_output, output_pitch);
+				}
+
+				prev_scanline = rows + (row_count - 1) * row_size + 1;
+			}
+
+			if (tasks)
+				tasks->wait();
+		}
+		catch (...)
+		{
+			// Queued tasks reference the strips and must finish before they are freed
+			if (tasks)
+			{
+				try { tasks->wait(); } catch (...) { }
+			}
+			throw;
 		}
 	}
 
-	void PNGLoader::decode_interlace_adam7(const unsigned char *data, int data_length)
+	void PNGLoader::decode_interlace_adam7()
 	{
-		int scanline_size = (image_width * bit_depth * get_image_data_channels() + 7) / 8;
-
-		int data_pos = 0;
-		int channels = get_image_data_channels();
-
-		int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
-		int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
-		int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
-		int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
-		//int block_height[7]  = { 8, 8, 4, 4, 2, 2, 1 };
-		//int block_width[7]   = { 8, 4, 4, 2, 2, 1, 1 };
+		static const int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
+		static const int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
+		static const int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
+		static const int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
 
 		PixelBufferLockAny pixels(image);
 		unsigned char *output = pixels.get_data();
 		int output_pitch = pixels.get_pitch();
-		for (int pass = 0; pass < 7; pass++)
-		{
-			for (size_t i = 0; i < scanline_size; i++)
-				scanline[i] = 0;
 
-			for (int y = starting_row[pass]; y < image_height; y += row_increment[pass])
+		std::unique_ptr<TaskGroup> tasks;
+		if (work_queue)
+			tasks.reset(new TaskGroup(*work_queue));
+
+		try
+		{
+			for (int pass = 0; pass < 7; pass++)
 			{
-				if (starting_col[pass] < image_width)
+				if (starting_row[pass] >= (int)image_height || starting_col[pass] >= (int)image_width)
+					continue; // Empty passes have no scanlines in the image data
+
+				int pass_width = (image_width - starting_col[pass] + col_increment[pass] - 1) / col_increment[pass];
+				int pass_height = (image_height - starting_row[pass] + row_increment[pass] - 1) / row_increment[pass];
+				int row_size = 1 + get_scanline_size(pass_width);
+
+				DataBuffer pass_data(pass_height * row_size);
+				read_image_data(pass_data.get_data(), pass_data.get_size());
+
+				// The passes cover disjoint pixels and each starts over from a zero prior scanline, so a pass can be
+				// decoded while the next one is inflated
+				unsigned char *pass_output = output + (size_t)starting_row[pass] * output_pitch;
+				int pass_output_pitch = output_pitch * row_increment[pass];
+				int start_col = starting_col[pass];
+				int col_inc = col_increment[pass];
+				auto decode = [=]() mutable
 				{
-					unsigned char *tmp = scanline;
-					scanline = prev_scanline;
-					prev_scanline = tmp;
-
-					int scanline_pixel_length = (image_width - starting_col[pass] + col_increment[pass] - 1) / col_increment[pass];
-					int scanline_byte_length = (scanline_pixel_length * bit_depth * channels + 7) / 8;
-
-					if (data_pos + scanline_byte_length > data_length)
-						throw Exception("Invalid PNG image file");
-
-					int predictor_type = data[data_pos++];
-					memcpy(scanline, data + data_pos, scanline_byte_length);
-					data_pos += scanline_byte_length;
-
-					filter_scanline(predictor_type, scanline_byte_length);
-
-					if (bit_depth <= 8)
-						convert_scanline_4ub(scanline_pixel_length);
-					else
-						convert_scanline_4us(scanline_pixel_length);
-
-					int scanline_pos = 0;
-					for (int x = starting_col[pass]; x < image_width; x += col_increment[pass])
-					{
-						if (bit_depth <= 8)
-							*reinterpret_cast<Vec4ub*>(output + y * output_pitch + x * 4) = scanline_4ub[scanline_pos++];
-						else
-							*reinterpret_cast<Vec4us*>(output + y * output_pitch + x * 8) = scanline_4us[scanline_pos++];
-					}
-				}
+					decode_pass(pass_data.get_data<unsigned char>(), pass_height, row_size, pass_width, pass_output, pass_output_pitch, start_col, col_inc);
+				};
+
+				if (tasks)
+					tasks->run(decode);
+				else
+					decode();
 			}
+
+			if (tasks)
+				tasks->wait();
+		}
+		catch (...)
+		{
+			// Queued tasks write into the locked pixel buffer and must finish before it is unlocked
+			if (tasks)
+			{
+				try { tasks->wait(); } catch (...) { }
+			}
+			throw;
 		}
 	}
 
-	void PNGLoader::filter_scanline(int predictor_type, int scanline_byte_length)
+	void PNGLoader::decode_rows(unsigned char *rows, const unsigned char *prev_scanline, int row_count, int row_size, unsigned char *output, int output_pitch) const
 	{
-		int channels = get_image_data_channels();
+		for (int y = 0; y < row_count; y++)
+		{
+			unsigned char *row = rows + y * row_size;
+			unsigned char *scanline = row + 1;
+			filter_scanline(row[0], scanline, prev_scanline, row_size - 1);
+
+			if (bit_depth <= 8)
+				convert_scanline_4ub(scanline, reinterpret_cast<Vec4ub*>(output), image_width);
+			else
+				convert_scanline_4us(scanline, reinterpret_cast<Vec4us*>(output), image_width);
+
+			prev_scanline = scanline;
+			output += output_pitch;
+		}
+	}
+
+	void PNGLoader::decode_pass(unsigned char *rows, int row_count, int row_size, int pixel_length, unsigned char *output, int output_pitch, int start_col, int col_increment) const
+	{
+		std::vector<Vec4ub> scanline_4ub;
+		std::vector<Vec4us> scanline_4us;
+		if (bit_depth <= 8)
+			scanline_4ub.resize(pixel_length);
+		else
+			scanline_4us.resize(pixel_length);
+
+		const unsigned char *prev_scanline = zero_scanline;
+		for (int y = 0; y < row_count; y++)
+		{
+			unsigned char *row = rows + y * row_size;
+			unsigned char *scanline = row + 1;
+			filter_scanline(row[0], scanline, prev_scanline, row_size - 1);
+
+			if (bit_depth <= 8)
+			{
+				convert_scanline_4ub(scanline, scanline_4ub.data(), pixel_length);
+				Vec4ub *line = reinterpret_cast<Vec4ub*>(output) + start_col;
+				for (int i = 0; i < pixel_length; i++)
+					line[i * col_increment] = scanline_4ub[i];
+			}
+			else
+			{
+				convert_scanline_4us(scanline, scanline_4us.data(), pixel_length);
+				Vec4us *line = reinterpret_cast<Vec4us*>(output) + start_col;
+				for (int i = 0; i < pixel_length; i++)
+					line[i * col_increment] = scanline_4us[i];
+			}
+
+			prev_scanline = scanline;
+			output += output_pitch;
+		}
+	}
+
+	void PNGLoader::filter_scanline(int predictor_type, unsigned char *scanline, const unsigned char *prev_scanline, int scanline_byte_length) const
+	{
+		int bytes_per_pixel = get_bytes_per_pixel();
 		switch (predictor_type)
 		{
 		case 0: break; // none
-		case 1: predictor_sub(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 2: predictor_up(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 3: predictor_average(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
-		case 4: predictor_paeth(scanline, prev_scanline, scanline_byte_length, channels, bit_depth); break;
+		case 1: predictor_sub(scanline, prev_scanline, scanline_byte_length, bytes_per_pixel); break;
+		case 2: predictor_up(scanline, prev_scanline, scanline_byte_length, bytes_per_pixel); break;
+		case 3: predictor_average(scanline, prev_scanline, scanline_byte_length, bytes_per_pixel); break;
+		case 4: predictor_paeth(scanline, prev_scanline, scanline_byte_length, bytes_per_pixel); break;
 		default: throw Exception("Invalid PNG image file");
 		}
 	}
 
-	void PNGLoader::predictor_sub(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth)
+	void PNGLoader::predictor_sub(unsigned char *scanline, const unsigned char * /*prev_scanline*/, int byte_length, int bytes_per_pixel)
 	{
-		int bytes_per_pixel = channels * ((bit_depth + 7) / 8);
-		for (int i = 0; i < byte_length; i++)
+#ifdef __SSE2__
+		switch (bytes_per_pixel)
+		{
+		case 3: predictor_sub_sse2<3>(scanline, byte_length); return;
+		case 4: predictor_sub_sse2<4>(scanline, byte_length); return;
+		case 6: predictor_sub_sse2<6>(scanline, byte_length); return;
+		case 8: predictor_sub_sse2<8>(scanline, byte_length); return;
+		}
+#endif
+		for (int i = bytes_per_pixel; i < byte_length; i++)
 		{
 			int x = scanline[i];
-			int a = i >= bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+			int a = scanline[i - bytes_per_pixel];
 			scanline[i] = x + a;
 		}
 	}
 
-	void PNGLoader::predictor_up(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth)
+	void PNGLoader::predictor_up(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int /*bytes_per_pixel*/)
 	{
-		//int bytes_per_pixel = channels * ((bit_depth + 7) / 8);
-		for (int i = 0; i < byte_length; i++)
+		int i = 0;
+#ifdef __SSE2__
+		for (; i + 16 <= byte_length; i += 16)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scanline + i));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev_scanline + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(scanline + i), _mm_add_epi8(x, b));
+		}
+#endif
+		for (; i < byte_length; i++)
 		{
 			int x = scanline[i];
 			int b = prev_scanline[i];
@@ -400,27 +653,57 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::predictor_average(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth)
+	void PNGLoader::predictor_average(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel)
 	{
-		int bytes_per_pixel = channels * ((bit_depth + 7) / 8);
-		for (int i = 0; i < byte_length; i++)
+#ifdef __SSE2__
+		switch (bytes_per_pixel)
+		{
+		case 3: predictor_average_sse2<3>(scanline, prev_scanline, byte_length); return;
+		case 4: predictor_average_sse2<4>(scanline, prev_scanline, byte_length); return;
+		case 6: predictor_average_sse2<6>(scanline, prev_scanline, byte_length); return;
+		case 8: predictor_average_sse2<8>(scanline, prev_scanline, byte_length); return;
+		}
+#endif
+		int first = std::min(bytes_per_pixel, byte_length);
+		for (int i = 0; i < first; i++)
+		{
+			int x = scanline[i];
+			int b = prev_scanline[i];
+			scanline[i] = x + b / 2;
+		}
+		for (int i = bytes_per_pixel; i < byte_length; i++)
 		{
 			int x = scanline[i];
-			int a = i >= bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+			int a = scanline[i - bytes_per_pixel];
 			int b = prev_scanline[i];
 			scanline[i] = x + (a + b) / 2;
 		}
 	}
 
-	void PNGLoader::predictor_paeth(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth)
+	void PNGLoader::predictor_paeth(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel)
 	{
-		int bytes_per_pixel = channels * ((bit_depth + 7) / 8);
-		for (int i = 0; i < byte_length; i++)
+#ifdef __SSE2__
+		switch (bytes_per_pixel)
+		{
+		case 3: predictor_paeth_sse2<3>(scanline, prev_scanline, byte_length); return;
+		case 4: predictor_paeth_sse2<4>(scanline, prev_scanline, byte_length); return;
+		case 6: predictor_paeth_sse2<6>(scanline, prev_scanline, byte_length); return;
+		case 8: predictor_paeth_sse2<8>(scanline, prev_scanline, byte_length); return;
+		}
+#endif
+		int first = std::min(bytes_per_pixel, byte_length);
+		for (int i = 0; i < first; i++) // a and c are zero, so the predictor is b
+		{
+			int x = scanline[i];
+			int b = prev_scanline[i];
+			scanline[i] = x + b;
+		}
+		for (int i = bytes_per_pixel; i < byte_length; i++)
 		{
 			int x = scanline[i];
-			int a = i >= bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+			int a = scanline[i - bytes_per_pixel];
 			int b = prev_scanline[i];
-			int c = i >= bytes_per_pixel ? prev_scanline[i - bytes_per_pixel] : 0;
+			int c = prev_scanline[i - bytes_per_pixel];
 			int p = a + b - c;
 			int pa = abs((p - a));
 			int pb = abs((p - b));
@@ -436,124 +719,71 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::convert_scanline_4ub(int scanline_pixel_length)
+	void PNGLoader::convert_scanline_4ub(const unsigned char *input, Vec4ub *output, int scanline_pixel_length) const
 	{
 		switch (color_type)
 		{
-		case 0: grayscale_to_4ub(scanline_pixel_length); break;
-		case 2: truecolor_to_4ub(scanline_pixel_length); break;
-		case 3: indexed_to_4ub(scanline_pixel_length); break;
-		case 4: grayscale_alpha_to_4ub(scanline_pixel_length); break;
-		case 6: truecolor_alpha_to_4ub(scanline_pixel_length); break;
+		case 0: grayscale_to_4ub(input, output, scanline_pixel_length); break;
+		case 2: truecolor_to_4ub(input, output, scanline_pixel_length); break;
+		case 3: indexed_to_4ub(input, output, scanline_pixel_length); break;
+		case 4: grayscale_alpha_to_4ub(input, output, scanline_pixel_length); break;
+		case 6: truecolor_alpha_to_4ub(input, output, scanline_pixel_length); break;
 		default: throw Exception("Invalid PNG image file");
 		}
 	}
 
-	void PNGLoader::convert_scanline_4us(int scanline_pixel_length)
+	void PNGLoader::convert_scanline_4us(const unsigned char *input, Vec4us *output, int scanline_pixel_length) const
 	{
 		switch (color_type)
 		{
-		case 0: grayscale_to_4us(scanline_pixel_length); break;
-		case 2: truecolor_to_4us(scanline_pixel_length); break;
-		case 4: grayscale_alpha_to_4us(scanline_pixel_length); break;
-		case 6: truecolor_alpha_to_4us(scanline_pixel_length); break;
+		case 0: grayscale_to_4us(input, output, scanline_pixel_length); break;
+		case 2: truecolor_to_4us(input, output, scanline_pixel_length); break;
+		case 4: grayscale_alpha_to_4us(input, output, scanline_pixel_length); break;
+		case 6: truecolor_alpha_to_4us(input, output, scanline_pixel_length); break;
 		default: throw Exception("Invalid PNG image file");
 		}
 	}
 
-	void PNGLoader::grayscale_to_4ub(int count)
+	unsigned char PNGLoader::get_packed_sample(const unsigned char *input, int index) const
 	{
-		unsigned char *input = scanline;
-		if (bit_depth == 1)
-		{
-			if (!has_colorkey)
-			{
-				for (int i = 0; i < count; i++)
-				{
-					int shift = i % 8;
-					unsigned char value = (input[i / 8] >> shift) & 1;
-					value = static_cast<int>(value)* 255;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
-				}
-			}
-			else
-			{
-				for (int i = 0; i < count; i++)
-				{
-					int shift = i % 8;
-					unsigned char value = (input[i / 8] >> shift) & 1;
-					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					value = static_cast<int>(value)* 255;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
-				}
-			}
-		}
-		else if (bit_depth == 2)
-		{
-			if (!has_colorkey)
-			{
-				for (int i = 0; i < count; i++)
-				{
-					int shift = (i % 4) * 2;
-					unsigned char value = (input[i / 4] >> shift) & 3;
-					value = (static_cast<int>(value)* 255 + 1) / 2;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
-				}
-			}
-			else
-			{
-				for (int i = 0; i < count; i++)
-				{
-					int shift = (i % 4) * 2;
-					unsigned char value = (input[i / 4] >> shift) & 3;
-					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					value = (static_cast<int>(value)* 255 + 1) / 2;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
-				}
-			}
-		}
-		else if (bit_depth == 4)
+		// Samples smaller than a byte are packed starting at the most significant bit
+		int samples_per_byte = 8 / bit_depth;
+		int shift = (samples_per_byte - 1 - index % samples_per_byte) * bit_depth;
+		return (input[index / samples_per_byte] >> shift) & ((1 << bit_depth) - 1);
+	}
+
+	void PNGLoader::grayscale_to_4ub(const unsigned char *input, Vec4ub *output, int count) const
+	{
+		if (bit_depth == 8)
 		{
 			if (!has_colorkey)
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 2) * 4;
-					unsigned char value = (input[i / 4] >> shift) & 15;
-					value = (static_cast<int>(value)* 255 + 8) / 16;
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
+					unsigned char value = input[i];
+					output[i] = Vec4ub(value, value, value, 255);
 				}
 			}
 			else
 			{
 				for (int i = 0; i < count; i++)
 				{
-					int shift = (i % 2) * 4;
-					unsigned char value = (input[i / 4] >> shift) & 15;
+					unsigned char value = input[i];
 					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					value = (static_cast<int>(value)* 255 + 8) / 16;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+					output[i] = Vec4ub(value, value, value, alpha);
 				}
 			}
 		}
-		else if (bit_depth == 8)
+		else if (bit_depth < 8)
 		{
-			if (!has_colorkey)
-			{
-				for (int i = 0; i < count; i++)
-				{
-					unsigned char value = input[i];
-					scanline_4ub[i] = Vec4ub(value, value, value, 255);
-				}
-			}
-			else
+			// Scale 1, 2 and 4 bit samples up to the full range
+			int scale = 255 / ((1 << bit_depth) - 1);
+			for (int i = 0; i < count; i++)
 			{
-				for (int i = 0; i < count; i++)
-				{
-					unsigned char value = input[i];
-					unsigned char alpha = (value != colorkey.r) ? 255 : 0;
-					scanline_4ub[i] = Vec4ub(value, value, value, alpha);
-				}
+				unsigned char sample = get_packed_sample(input, i);
+				unsigned char value = sample * scale;
+				unsigned char alpha = (!has_colorkey || sample != colorkey.r) ? 255 : 0;
+				output[i] = Vec4ub(value, value, value, alpha);
 			}
 		}
 		else
@@ -562,13 +792,11 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::truecolor_to_4ub(int count)
+	void PNGLoader::truecolor_to_4ub(const unsigned char *input, Vec4ub *output, int count) const
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
 
-		unsigned char *input = scanline;
-
 		if (!has_colorkey)
 		{
 			for (int i = 0; i < count; i++)
@@ -576,7 +804,7 @@ namespace clan
 				unsigned char red = input[i * 3 + 0];
 				unsigned char green = input[i * 3 + 1];
 				unsigned char blue = input[i * 3 + 2];
-				scanline_4ub[i] = Vec4ub(red, green, blue, 255);
+				output[i] = Vec4ub(red, green, blue, 255);
 			}
 		}
 		else
@@ -589,48 +817,22 @@ namespace clan
 				unsigned char alpha = 255;
 				if (red == colorkey.r && green == colorkey.g && blue == colorkey.b)
 					alpha = 0;
-				scanline_4ub[i] = Vec4ub(red, green, blue, alpha);
+				output[i] = Vec4ub(red, green, blue, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::indexed_to_4ub(int count)
+	void PNGLoader::indexed_to_4ub(const unsigned char *input, Vec4ub *output, int count) const
 	{
-		unsigned char *input = scanline;
-		if (bit_depth == 1)
-		{
-			for (int i = 0; i < count; i++)
-			{
-				int shift = i % 8;
-				unsigned char value = (input[i / 8] >> shift) & 1;
-				scanline_4ub[i] = palette[value];
-			}
-		}
-		else if (bit_depth == 2)
-		{
-			for (int i = 0; i < count; i++)
-			{
-				int shift = (i % 4) * 2;
-				unsigned char value = (input[i / 4] >> shift) & 3;
-				scanline_4ub[i] = palette[value];
-			}
-		}
-		else if (bit_depth == 4)
+		if (bit_depth == 8)
 		{
 			for (int i = 0; i < count; i++)
-			{
-				int shift = (i % 2) * 4;
-				unsigned char value = (input[i / 4] >> shift) & 15;
-				scanline_4ub[i] = palette[value];
-			}
+				output[i] = palette[input[i]];
 		}
-		else if (bit_depth == 8)
+		else if (bit_depth < 8)
 		{
 			for (int i = 0; i < count; i++)
-			{
-				unsigned char value = input[i];
-				scanline_4ub[i] = palette[value];
-			}
+				output[i] = palette[get_packed_sample(input, i)];
 		}
 		else
 		{
@@ -638,119 +840,117 @@ namespace clan
 		}
 	}
 
-	void PNGLoader::grayscale_alpha_to_4ub(int count)
+	void PNGLoader::grayscale_alpha_to_4ub(const unsigned char *input, Vec4ub *output, int count) const
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
 
-		unsigned char *input = scanline;
 		for (int i = 0; i < count; i++)
 		{
 			unsigned char value = input[i * 2];
 			unsigned char alpha = input[i * 2 + 1];
-			scanline_4ub[i] = Vec4ub(value, value, value, alpha);
+			output[i] = Vec4ub(value, value, value, alpha);
 		}
 	}
 
-	void PNGLoader::truecolor_alpha_to_4ub(int count)
+	void PNGLoader::truecolor_alpha_to_4ub(const unsigned char *input, Vec4ub *output, int count) const
 	{
 		if (bit_depth != 8)
 			throw Exception("Invalid PNG image file");
 
-		unsigned char *input = scanline;
-		for (int i = 0; i < count; i++)
-		{
-			unsigned char red = input[i * 4 + 0];
-			unsigned char green = input[i * 4 + 1];
-			unsigned char blue = input[i * 4 + 2];
-			unsigned char alpha = input[i * 4 + 3];
-			scanline_4ub[i] = Vec4ub(red, green, blue, alpha);
-		}
+		// Same channel order as the pixel buffer
+		memcpy(static_cast<void*>(output), input, count * sizeof(Vec4ub));
 	}
 
-	void PNGLoader::grayscale_to_4us(int count)
+	void PNGLoader::grayscale_to_4us(const unsigned char *input, Vec4us *output, int count) const
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
 
-		unsigned short *input = reinterpret_cast<unsigned short*>(scanline);
 		if (!has_colorkey)
 		{
 			for (int i = 0; i < count; i++)
 			{
-				unsigned short value = from_network_order(input[i]);
-				scanline_4us[i] = Vec4us(value, value, value, 65535);
+				unsigned short value = get_sample16(input, i);
+				output[i] = Vec4us(value, value, value, 65535);
 			}
 		}
 		else
 		{
 			for (int i = 0; i < count; i++)
 			{
-				unsigned short value = from_network_order(input[i]);
+				unsigned short value = get_sample16(input, i);
 				unsigned short alpha = (value != colorkey.r) ? 65535 : 0;
-				scanline_4us[i] = Vec4us(value, value, value, alpha);
+				output[i] = Vec4us(value, value, value, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::truecolor_to_4us(int count)
+	void PNGLoader::truecolor_to_4us(const unsigned char *input, Vec4us *output, int count) const
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
 
-		unsigned short *input = reinterpret_cast<unsigned short*>(scanline);
 		if (!has_colorkey)
 		{
 			for (int i = 0; i < count; i++)
 			{
-				unsigned short red = from_network_order(input[i * 3 + 0]);
-				unsigned short green = from_network_order(input[i * 3 + 1]);
-				unsigned short blue = from_network_order(input[i * 3 + 2]);
-				scanline_4us[i] = Vec4us(red, green, blue, 65535);
+				unsigned short red = get_sample16(input, i * 3 + 0);
+				unsigned short green = get_sample16(input, i * 3 + 1);
+				unsigned short blue = get_sample16(input, i * 3 + 2);
+				output[i] = Vec4us(red, green, blue, 65535);
 			}
 		}
 		else
 		{
 			for (int i = 0; i < count; i++)
 			{
-				unsigned short red = from_network_order(input[i * 3 + 0]);
-				unsigned short green = from_network_order(input[i * 3 + 1]);
-				unsigned short blue = from_network_order(input[i * 3 + 2]);
+				unsigned short red = get_sample16(input, i * 3 + 0);
+				unsigned short green = get_sample16(input, i * 3 + 1);
+				unsigned short blue = get_sample16(input, i * 3 + 2);
 				unsigned short alpha = 65535;
 				if (red == colorkey.r && green == colorkey.g && blue == colorkey.b)
 					alpha = 0;
-				scanline_4us[i] = Vec4us(red, green, blue, alpha);
+				output[i] = Vec4us(red, green, blue, alpha);
 			}
 		}
 	}
 
-	void PNGLoader::grayscale_alpha_to_4us(int count)
+	void PNGLoader::grayscale_alpha_to_4us(const unsigned char *input, Vec4us *output, int count) const
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
 
-		unsigned short *input = reinterpret_cast<unsigned short*>(scanline);
 		for (int i = 0; i < count; i++)
 		{
-			unsigned short value = from_network_order(input[i * 2]);
-			unsigned short alpha = from_network_order(input[i * 2 + 1]);
-			scanline_4us[i] = Vec4us(value, value, value, alpha);
+			unsigned short value = get_sample16(input, i * 2);
+			unsigned short alpha = get_sample16(input, i * 2 + 1);
+			output[i] = Vec4us(value, value, value, alpha);
 		}
 	}
 
-	void PNGLoader::truecolor_alpha_to_4us(int count)
+	void PNGLoader::truecolor_alpha_to_4us(const unsigned char *input, Vec4us *output, int count) const
 	{
 		if (bit_depth != 16)
 			throw Exception("Invalid PNG image file");
 
-		unsigned short *input = reinterpret_cast<unsigned short*>(scanline);
-		for (int i = 0; i < count; i++)
+		int i = 0;
+#ifdef __SSE2__
+		// Swap the bytes of two pixels at a time
+		for (; i + 2 <= count; i += 2)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 8));
+			x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), x);
+		}
+#endif
+		for (; i < count; i++)
 		{
-			unsigned short red = from_network_order(input[i * 4 + 0]);
-			unsigned short green = from_network_order(input[i * 4 + 1]);
-			unsigned short blue = from_network_order(input[i * 4 + 2]);
-			unsigned short alpha = from_network_order(input[i * 4 + 3]);
-			scanline_4us[i] = Vec4us(red, green, blue, alpha);
+			unsigned short red = get_sample16(input, i * 4 + 0);
+			unsigned short green = get_sample16(input, i * 4 + 1);
+			unsigned short blue = get_sample16(input, i * 4 + 2);
+			unsigned short alpha = get_sample16(input, i * 4 + 3);
+			output[i] = Vec4us(red, green, blue, alpha);
 		}
 	}
 }
@@ -31,73 +31,101 @@
 #include "API/Core/IOData/iodevice.h"
 #include "API/Display/Image/pixel_buffer.h"
 #include "API/Core/System/databuffer.h"
+#include "Core/Zip/miniz.h"
 #include <map>
 
 namespace clan
 {
+	class WorkQueue;
+
+	/// \brief PNG decoder
+	///
+	/// Image data is inflated incrementally while the IDAT chunks are read, and is unfiltered in strips
+	/// directly into the target pixel buffer. When a work queue is supplied, unfiltering and colour conversion
+	/// of each strip (or each Adam7 pass) runs on the worker threads while the next part of the stream is inflated.
 	class PNGLoader
 	{
 	public:
-		static PixelBuffer load(IODevice iodevice, bool srgb);
+		static PixelBuffer load(IODevice iodevice, bool srgb, WorkQueue *work_queue = nullptr);
 
 	private:
-		PNGLoader(IODevice iodevice, bool force_srgb);
+		PNGLoader(IODevice iodevice, bool force_srgb, WorkQueue *work_queue);
 		~PNGLoader();
 		void read_magic();
+		void read_chunk(std::string &name, DataBuffer &data);
 		void read_chunks();
+		void read_trailing_chunks();
 		void decode_header();
 		void decode_palette();
 		void decode_colorkey();
 		void decode_image();
-		void decode_interlace_none(const unsigned char *data, int data_length);
-		void decode_interlace_adam7(const unsigned char *data, int data_length);
+		void decode_interlace_none();
+		void decode_interlace_adam7();
+
+		void read_image_data(void *data, int size);
+		void read_next_idat();
 
 		void create_image();
-		void create_scanline_buffers();
-		int get_image_data_channels();
+		int get_image_data_channels() const;
+		int get_bytes_per_pixel() const;
+		int get_scanline_size(int pixel_length) const;
+
+		void decode_rows(unsigned char *rows, const unsigned char *prev_row, int row_count, int row_size, unsigned char *output, int output_pitch) const;
+		void decode_pass(unsigned char *rows, int row_count, int row_size, int pixel_length, unsigned char *output, int output_pitch, int start_col, int col_increment) const;
 
-		void filter_scanline(int predictor_type, int scanline_byte_length);
-		static void predictor_sub(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
-		static void predictor_up(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
-		static void predictor_average(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
-		static void predictor_paeth(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int channels, int bit_depth);
+		void filter_scanline(int predictor_type, unsigned char *scanline, const unsigned char *prev_scanline, int scanline_byte_length) const;
+		static void predictor_sub(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel);
+		static void predictor_up(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel);
+		static void predictor_average(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel);
+		static void predictor_paeth(unsigned char *scanline, const unsigned char *prev_scanline, int byte_length, int bytes_per_pixel);
 
-		void convert_scanline_4ub(int scanline_pixel_length);
-		void convert_scanline_4us(int scanline_pixel_length);
+		void convert_scanline_4ub(const unsigned char *input, Vec4ub *output, int scanline_pixel_length) const;
+		void convert_scanline_4us(const unsigned char *input, Vec4us *output, int scanline_pixel_length) const;
 
-		void grayscale_to_4ub(int count);
-		void truecolor_to_4ub(int count);
-		void indexed_to_4ub(int count);
-		void grayscale_alpha_to_4ub(int count);
-		void truecolor_alpha_to_4ub(int count);
+		void grayscale_to_4ub(const unsigned char *input, Vec4ub *output, int count) const;
+		void truecolor_to_4ub(const unsigned char *input, Vec4ub *output, int count) const;
+		void indexed_to_4ub(const unsigned char *input, Vec4ub *output, int count) const;
+		void grayscale_alpha_to_4ub(const unsigned char *input, Vec4ub *output, int count) const;
+		void truecolor_alpha_to_4ub(const unsigned char *input, Vec4ub *output, int count) const;
 
-		void grayscale_to_4us(int count);
-		void truecolor_to_4us(int count);
-		void grayscale_alpha_to_4us(int count);
-		void truecolor_alpha_to_4us(int count);
+		void grayscale_to_4us(const unsigned char *input, Vec4us *output, int count) const;
+		void truecolor_to_4us(const unsigned char *input, Vec4us *output, int count) const;
+		void grayscale_alpha_to_4us(const unsigned char *input, Vec4us *output, int count) const;
+		void truecolor_alpha_to_4us(const unsigned char *input, Vec4us *output, int count) const;
+
+		unsigned char get_packed_sample(const unsigned char *input, int index) const;
 
 		static int abs(int a) { return a >= 0 ? a : -a; }
 
-		inline unsigned int from_network_order(unsigned int v)
+		static inline unsigned short get_sample16(const unsigned char *input, int index)
+		{
+			return (static_cast<unsigned int>(input[index * 2]) << 8) | input[index * 2 + 1];
+		}
+
+		static inline unsigned int from_network_order(unsigned int v)
 		{
 			unsigned char *p = reinterpret_cast<unsigned char *>(&v);
 			return (static_cast<unsigned int>(p[0]) << 24) | (static_cast<unsigned int>(p[1]) << 16) | (static_cast<unsigned int>(p[2]) << 8) | p[3];
 		}
 
-		inline unsigned short from_network_order(unsigned short v)
+		static inline unsigned short from_network_order(unsigned short v)
 		{
 			unsigned char *p = reinterpret_cast<unsigned char *>(&v);
 			return (static_cast<unsigned int>(p[0]) << 8) | p[1];
 		}
 
+		/// \brief Approximate size in bytes of the row strips inflated and decoded at a time
+		static const int strip_byte_size = 256 * 1024;
+
 		IODevice file;
 		bool force_srgb;
+		WorkQueue *work_queue;
 
 		PixelBuffer image;
 
 		DataBuffer ihdr; // image header, which is the first chunk in a PNG datastream.
 		DataBuffer plte; // palette table associated with indexed PNG images.
-		DataBuffer idat; // image data chunks.
+		DataBuffer idat; // current image data chunk. Reused for every IDAT chunk while the stream is inflated.
 
 		DataBuffer trns; // Transparency information
 		DataBuffer chrm; // Colour space information (5 chunks)
@@ -114,10 +142,10 @@ namespace clan
 		unsigned char filter_method;
 		unsigned char interlace_method;
 
-		unsigned char *scanline;
-		unsigned char *prev_scanline;
-		Vec4ub *scanline_4ub;
-		Vec4us *scanline_4us;
+		mz_stream zstream;
+		bool zstream_initialized;
+
+		unsigned char *zero_scanline;
 
 		Vec4ub *palette;
 		Vec3us colorkey;
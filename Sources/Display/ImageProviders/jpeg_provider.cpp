@@ -54,6 +54,23 @@ namespace clan
 		return JPEGLoader::load(file, srgb);
 	}
 
+	PixelBuffer JPEGProvider::load(
+		IODevice &file,
+		bool srgb,
+		WorkQueue &work_queue)
+	{
+		return JPEGLoader::load(file, srgb, &work_queue);
+	}
+
+	PixelBuffer JPEGProvider::load(
+		const std::string &fullname,
+		bool srgb,
+		WorkQueue &work_queue)
+	{
+		File file(fullname);
+		return JPEGLoader::load(file, srgb, &work_queue);
+	}
+
 	PixelBuffer JPEGProvider::load(
 		const std::string &fullname,
 		bool srgb)
@@ -92,7 +109,7 @@ namespace clan
 
 		clan_jpge::params desc;
 		desc.m_quality = quality;
-		bool result = clan_jpge::compress_image_to_jpeg_file_in_memory(output.get_data(), size, buffer.get_width(), buffer.get_height(), 3, output.get_data<clan_jpge::uint8>(), desc);
+		bool result = clan_jpge::compress_image_to_jpeg_file_in_memory(output.get_data(), size, buffer.get_width(), buffer.get_height(), 3, buffer.get_data<clan_jpge::uint8>(), desc);
 		if (!result)
 			throw Exception("Unable to compress JPEG image");
 
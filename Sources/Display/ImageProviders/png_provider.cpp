@@ -62,6 +62,20 @@ namespace clan
 		return PNGLoader::load(file, srgb);
 	}
 
+	PixelBuffer PNGProvider::load(IODevice &file, bool srgb, WorkQueue &work_queue)
+	{
+		return PNGLoader::load(file, srgb, &work_queue);
+	}
+
+	PixelBuffer PNGProvider::load(
+		const std::string &fullname,
+		bool srgb,
+		WorkQueue &work_queue)
+	{
+		File file(fullname);
+		return PNGLoader::load(file, srgb, &work_queue);
+	}
+
 	void PNGProvider::save(
 		PixelBuffer buffer,
 		const std::string &filename,
@@ -0,0 +1,107 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_buffer_provider.h"
+#include "API/Display/Render/transfer_buffer.h"
+#include "API/Core/Text/string_format.h"
+
+namespace clan
+{
+	RecordingBufferData::RecordingBufferData(const std::shared_ptr<RecordingLog> &log, const char *name)
+		: log(log), name(name)
+	{
+	}
+
+	void RecordingBufferData::create(const void *new_data, int size)
+	{
+		data.resize(size);
+		log->statistics.resources_created++;
+		if (new_data)
+		{
+			memcpy(data.data(), new_data, size);
+			log->statistics.buffer_uploads++;
+			log->statistics.buffer_bytes += size;
+		}
+		if (log->is_logging())
+			log->log(string_format("create_%1 %2", name, size));
+	}
+
+	void RecordingBufferData::upload_data(int offset, const void *new_data, int size)
+	{
+		if (offset < 0 || size < 0 || offset + size > (int)data.size())
+			throw Exception("Upload data size exceeds buffer size");
+
+		memcpy(data.data() + offset, new_data, size);
+		log->statistics.buffer_uploads++;
+		log->statistics.buffer_bytes += size;
+		if (log->is_logging())
+			log->log(string_format("upload_%1 %2 %3", name, offset, size));
+	}
+
+	void RecordingBufferData::copy_from(TransferBuffer &buffer, int dest_pos, int src_pos, int size)
+	{
+		if (dest_pos < 0 || size < 0 || dest_pos + size > (int)data.size())
+			throw Exception("Copy size exceeds buffer size");
+
+		memcpy(data.data() + dest_pos, static_cast<const unsigned char *>(buffer.get_provider()->get_data()) + src_pos, size);
+		log->statistics.buffer_uploads++;
+		log->statistics.buffer_bytes += size;
+		if (log->is_logging())
+			log->log(string_format("copy_%1_from_transfer_buffer %2 %3", name, dest_pos, size));
+	}
+
+	void RecordingBufferData::copy_to(TransferBuffer &buffer, int dest_pos, int src_pos, int size)
+	{
+		if (src_pos < 0 || size < 0 || src_pos + size > (int)data.size())
+			throw Exception("Copy size exceeds buffer size");
+
+		memcpy(static_cast<unsigned char *>(buffer.get_provider()->get_data()) + dest_pos, data.data() + src_pos, size);
+		if (log->is_logging())
+			log->log(string_format("copy_%1_to_transfer_buffer %2 %3", name, src_pos, size));
+	}
+
+	void RecordingPixelBufferProvider::create(const void *data, const Size &new_size, PixelBufferDirection direction, TextureFormat new_format, BufferUsage usage)
+	{
+		size = new_size;
+		texture_format = new_format;
+		buffer.create(data, PixelBuffer::get_data_size(new_size, new_format));
+	}
+
+	void RecordingPixelBufferProvider::upload_data(GraphicContext &gc, const Rect &dest_rect, const void *data)
+	{
+		if (dest_rect.left < 0 || dest_rect.top < 0 || dest_rect.right > size.width || dest_rect.bottom > size.height)
+			throw Exception("Upload rectangle out of bounds");
+
+		int bytes_per_pixel = PixelBuffer::get_bytes_per_pixel(texture_format);
+		int pitch = get_pitch();
+		int row_bytes = dest_rect.get_width() * bytes_per_pixel;
+		for (int y = 0; y < dest_rect.get_height(); y++)
+			buffer.upload_data((dest_rect.top + y) * pitch + dest_rect.left * bytes_per_pixel, static_cast<const unsigned char *>(data) + y * row_bytes, row_bytes);
+	}
+}
@@ -0,0 +1,157 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/vertex_array_buffer_provider.h"
+#include "API/Display/TargetProviders/element_array_buffer_provider.h"
+#include "API/Display/TargetProviders/uniform_buffer_provider.h"
+#include "API/Display/TargetProviders/storage_buffer_provider.h"
+#include "API/Display/TargetProviders/transfer_buffer_provider.h"
+#include "API/Display/TargetProviders/pixel_buffer_provider.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "recording_log.h"
+#include <vector>
+
+namespace clan
+{
+	/// \brief Memory backing a recorded buffer object
+	class RecordingBufferData
+	{
+	public:
+		RecordingBufferData(const std::shared_ptr<RecordingLog> &log, const char *name);
+
+		void create(const void *data, int size);
+		void upload_data(int offset, const void *data, int size);
+		void copy_from(TransferBuffer &buffer, int dest_pos, int src_pos, int size);
+		void copy_to(TransferBuffer &buffer, int dest_pos, int src_pos, int size);
+
+		std::shared_ptr<RecordingLog> log;
+		const char *name;
+		std::vector<unsigned char> data;
+	};
+
+	class RecordingVertexArrayBufferProvider : public VertexArrayBufferProvider
+	{
+	public:
+		RecordingVertexArrayBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "vertex_array_buffer") { }
+
+		void create(int size, BufferUsage usage) override { buffer.create(nullptr, size); }
+		void create(void *data, int size, BufferUsage usage) override { buffer.create(data, size); }
+		void upload_data(GraphicContext &gc, int offset, const void *data, int size) override { buffer.upload_data(offset, data, size); }
+		void copy_from(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_from(transfer, dest_pos, src_pos, size); }
+		void copy_to(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_to(transfer, dest_pos, src_pos, size); }
+
+	private:
+		RecordingBufferData buffer;
+	};
+
+	class RecordingElementArrayBufferProvider : public ElementArrayBufferProvider
+	{
+	public:
+		RecordingElementArrayBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "element_array_buffer") { }
+
+		void create(int size, BufferUsage usage) override { buffer.create(nullptr, size); }
+		void create(void *data, int size, BufferUsage usage) override { buffer.create(data, size); }
+		void upload_data(GraphicContext &gc, const void *data, int size) override { buffer.upload_data(0, data, size); }
+		void copy_from(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_from(transfer, dest_pos, src_pos, size); }
+		void copy_to(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_to(transfer, dest_pos, src_pos, size); }
+
+	private:
+		RecordingBufferData buffer;
+	};
+
+	class RecordingUniformBufferProvider : public UniformBufferProvider
+	{
+	public:
+		RecordingUniformBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "uniform_buffer") { }
+
+		void create(int size, BufferUsage usage) override { buffer.create(nullptr, size); }
+		void create(const void *data, int size, BufferUsage usage) override { buffer.create(data, size); }
+		void upload_data(GraphicContext &gc, const void *data, int size) override { buffer.upload_data(0, data, size); }
+		void copy_from(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_from(transfer, dest_pos, src_pos, size); }
+		void copy_to(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_to(transfer, dest_pos, src_pos, size); }
+
+	private:
+		RecordingBufferData buffer;
+	};
+
+	class RecordingStorageBufferProvider : public StorageBufferProvider
+	{
+	public:
+		RecordingStorageBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "storage_buffer") { }
+
+		void create(int size, int stride, BufferUsage usage) override { buffer.create(nullptr, size); }
+		void create(const void *data, int size, int stride, BufferUsage usage) override { buffer.create(data, size); }
+		void upload_data(GraphicContext &gc, const void *data, int size) override { buffer.upload_data(0, data, size); }
+		void copy_from(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_from(transfer, dest_pos, src_pos, size); }
+		void copy_to(GraphicContext &gc, TransferBuffer &transfer, int dest_pos, int src_pos, int size) override { buffer.copy_to(transfer, dest_pos, src_pos, size); }
+
+	private:
+		RecordingBufferData buffer;
+	};
+
+	class RecordingTransferBufferProvider : public TransferBufferProvider
+	{
+	public:
+		RecordingTransferBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "transfer_buffer") { }
+
+		void create(int size, BufferUsage usage) override { buffer.create(nullptr, size); }
+		void create(void *data, int size, BufferUsage usage) override { buffer.create(data, size); }
+		void *get_data() override { return buffer.data.data(); }
+		void lock(GraphicContext &gc, BufferAccess access) override { }
+		void unlock() override { }
+		void upload_data(GraphicContext &gc, int offset, const void *data, int size) override { buffer.upload_data(offset, data, size); }
+
+	private:
+		RecordingBufferData buffer;
+	};
+
+	class RecordingPixelBufferProvider : public PixelBufferProvider
+	{
+	public:
+		RecordingPixelBufferProvider(const std::shared_ptr<RecordingLog> &log) : buffer(log, "pixel_buffer") { }
+
+		void create(const void *data, const Size &new_size, PixelBufferDirection direction, TextureFormat new_format, BufferUsage usage) override;
+
+		void *get_data() override { return buffer.data.data(); }
+		int get_pitch() const override { return size.width * PixelBuffer::get_bytes_per_pixel(texture_format); }
+		Size get_size() const override { return size; }
+		bool is_gpu() const override { return true; }
+		TextureFormat get_format() const override { return texture_format; }
+
+		void lock(GraphicContext &gc, BufferAccess access) override { }
+		void unlock() override { }
+		void upload_data(GraphicContext &gc, const Rect &dest_rect, const void *data) override;
+
+	private:
+		RecordingBufferData buffer;
+		Size size;
+		TextureFormat texture_format = tf_rgba8;
+	};
+}
@@ -0,0 +1,142 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_frame_buffer_provider.h"
+#include "API/Display/Render/render_buffer.h"
+#include "API/Display/Render/texture_1d.h"
+#include "API/Display/Render/texture_1d_array.h"
+#include "API/Display/Render/texture_2d.h"
+#include "API/Display/Render/texture_2d_array.h"
+#include "API/Display/Render/texture_3d.h"
+#include "API/Display/Render/texture_cube.h"
+#include "API/Core/Text/string_format.h"
+
+namespace clan
+{
+	RecordingFrameBufferProvider::RecordingFrameBufferProvider(const std::shared_ptr<RecordingLog> &log)
+		: log(log)
+	{
+		log->statistics.resources_created++;
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const RenderBuffer &render_buffer)
+	{
+		attach("color", render_buffer.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const Texture1D &texture, int level)
+	{
+		attach("color", Size(texture.get_size(), 1));
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const Texture1DArray &texture, int array_index, int level)
+	{
+		attach("color", Size(texture.get_size(), 1));
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const Texture2D &texture, int level)
+	{
+		attach("color", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const Texture2DArray &texture, int array_index, int level)
+	{
+		attach("color", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const Texture3D &texture, int depth, int level)
+	{
+		Vec3i texture_size = texture.get_size();
+		attach("color", Size(texture_size.x, texture_size.y));
+	}
+
+	void RecordingFrameBufferProvider::attach_color(int attachment_index, const TextureCube &texture, TextureSubtype subtype, int level)
+	{
+		attach("color", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_stencil(const RenderBuffer &render_buffer)
+	{
+		attach("stencil", render_buffer.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_stencil(const Texture2D &texture, int level)
+	{
+		attach("stencil", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_stencil(const TextureCube &texture, TextureSubtype subtype, int level)
+	{
+		attach("stencil", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth(const RenderBuffer &render_buffer)
+	{
+		attach("depth", render_buffer.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth(const Texture2D &texture, int level)
+	{
+		attach("depth", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth(const TextureCube &texture, TextureSubtype subtype, int level)
+	{
+		attach("depth", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth_stencil(const RenderBuffer &render_buffer)
+	{
+		attach("depth_stencil", render_buffer.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth_stencil(const Texture2D &texture, int level)
+	{
+		attach("depth_stencil", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach_depth_stencil(const TextureCube &texture, TextureSubtype subtype, int level)
+	{
+		attach("depth_stencil", texture.get_size());
+	}
+
+	void RecordingFrameBufferProvider::attach(const char *attachment, const Size &attachment_size)
+	{
+		size = attachment_size;
+		if (log->is_logging())
+			log->log(string_format("attach_%1 %2x%3", attachment, attachment_size.width, attachment_size.height));
+	}
+
+	void RecordingRenderBufferProvider::create(int width, int height, TextureFormat texture_format, int multisample_samples)
+	{
+		log->statistics.resources_created++;
+		if (log->is_logging())
+			log->log(string_format("create_render_buffer %1x%2 samples=%3", width, height, multisample_samples));
+	}
+}
@@ -0,0 +1,108 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/frame_buffer_provider.h"
+#include "API/Display/TargetProviders/render_buffer_provider.h"
+#include "API/Display/TargetProviders/occlusion_query_provider.h"
+#include "API/Core/Math/size.h"
+#include "recording_log.h"
+
+namespace clan
+{
+	class RecordingFrameBufferProvider : public FrameBufferProvider
+	{
+	public:
+		RecordingFrameBufferProvider(const std::shared_ptr<RecordingLog> &log);
+
+		Size get_size() const override { return size; }
+		FrameBufferBindTarget get_bind_target() const override { return bind_target; }
+
+		void attach_color(int attachment_index, const RenderBuffer &render_buffer) override;
+		void attach_color(int attachment_index, const Texture1D &texture, int level) override;
+		void attach_color(int attachment_index, const Texture1DArray &texture, int array_index, int level) override;
+		void attach_color(int attachment_index, const Texture2D &texture, int level) override;
+		void attach_color(int attachment_index, const Texture2DArray &texture, int array_index, int level) override;
+		void attach_color(int attachment_index, const Texture3D &texture, int depth, int level) override;
+		void attach_color(int attachment_index, const TextureCube &texture, TextureSubtype subtype, int level) override;
+		void detach_color(int attachment_index) override { log->log("detach_color"); }
+
+		void attach_stencil(const RenderBuffer &render_buffer) override;
+		void attach_stencil(const Texture2D &texture, int level) override;
+		void attach_stencil(const TextureCube &texture, TextureSubtype subtype, int level) override;
+		void detach_stencil() override { log->log("detach_stencil"); }
+
+		void attach_depth(const RenderBuffer &render_buffer) override;
+		void attach_depth(const Texture2D &texture, int level) override;
+		void attach_depth(const TextureCube &texture, TextureSubtype subtype, int level) override;
+		void detach_depth() override { log->log("detach_depth"); }
+
+		void attach_depth_stencil(const RenderBuffer &render_buffer) override;
+		void attach_depth_stencil(const Texture2D &texture, int level) override;
+		void attach_depth_stencil(const TextureCube &texture, TextureSubtype subtype, int level) override;
+		void detach_depth_stencil() override { log->log("detach_depth_stencil"); }
+
+		void set_bind_target(FrameBufferBindTarget target) override { bind_target = target; }
+
+		RecordingLog *get_log() const { return log.get(); }
+
+	private:
+		void attach(const char *attachment, const Size &attachment_size);
+
+		std::shared_ptr<RecordingLog> log;
+		Size size;
+		FrameBufferBindTarget bind_target = framebuffer_draw;
+	};
+
+	class RecordingRenderBufferProvider : public RenderBufferProvider
+	{
+	public:
+		RecordingRenderBufferProvider(const std::shared_ptr<RecordingLog> &log) : log(log) { }
+
+		void create(int width, int height, TextureFormat texture_format, int multisample_samples) override;
+
+	private:
+		std::shared_ptr<RecordingLog> log;
+	};
+
+	class RecordingOcclusionQueryProvider : public OcclusionQueryProvider
+	{
+	public:
+		RecordingOcclusionQueryProvider(const std::shared_ptr<RecordingLog> &log) : log(log) { }
+
+		bool is_result_ready() const override { return true; }
+		int get_result() const override { return 0; }
+		void begin() override { log->log("begin_occlusion_query"); }
+		void end() override { log->log("end_occlusion_query"); }
+		void create() override { log->statistics.resources_created++; }
+
+	private:
+		std::shared_ptr<RecordingLog> log;
+	};
+}
@@ -0,0 +1,411 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_graphic_context_provider.h"
+#include "recording_buffer_provider.h"
+#include "recording_texture_provider.h"
+#include "recording_program_object_provider.h"
+#include "recording_frame_buffer_provider.h"
+#include "recording_primitives_array_provider.h"
+#include "API/Display/Render/frame_buffer.h"
+#include "API/Display/Render/primitives_array.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Core/Text/string_format.h"
+
+namespace clan
+{
+	namespace
+	{
+		class RecordingRasterizerState : public RasterizerStateProvider { };
+		class RecordingBlendState : public BlendStateProvider { };
+		class RecordingDepthStencilState : public DepthStencilStateProvider { };
+
+		const char *primitives_type_names[] = { "points", "line_strip", "line_loop", "lines", "triangle_strip", "triangle_fan", "triangles" };
+	}
+
+	RecordingGraphicContextProvider::RecordingGraphicContextProvider(const Size &window_size, float pixel_ratio)
+		: log(std::make_shared<RecordingLog>()), window_size(window_size), pixel_ratio(pixel_ratio)
+	{
+		for (auto &program : standard_programs)
+		{
+			program = ProgramObject(new RecordingProgramObjectProvider(log));
+			program.link();
+		}
+	}
+
+	RecordingGraphicContextProvider::~RecordingGraphicContextProvider()
+	{
+	}
+
+	void RecordingGraphicContextProvider::set_window_size(const Size &size, float new_pixel_ratio)
+	{
+		if (window_size != size || pixel_ratio != new_pixel_ratio)
+		{
+			window_size = size;
+			pixel_ratio = new_pixel_ratio;
+			window_resized_signal(window_size);
+		}
+	}
+
+	ProgramObject RecordingGraphicContextProvider::get_program_object(StandardProgram standard_program) const
+	{
+		return standard_programs[standard_program];
+	}
+
+	PixelBuffer RecordingGraphicContextProvider::get_pixeldata(const Rect& rect, TextureFormat texture_format, bool clamp) const
+	{
+		PixelBuffer buffer(rect.get_width(), rect.get_height(), texture_format);
+		memset(buffer.get_data(), 0, buffer.get_data_size());
+		log->log("get_pixeldata");
+		return buffer;
+	}
+
+	TextureProvider *RecordingGraphicContextProvider::alloc_texture(TextureDimensions texture_dimensions)
+	{
+		return new RecordingTextureProvider(log, texture_dimensions);
+	}
+
+	OcclusionQueryProvider *RecordingGraphicContextProvider::alloc_occlusion_query()
+	{
+		return new RecordingOcclusionQueryProvider(log);
+	}
+
+	ProgramObjectProvider *RecordingGraphicContextProvider::alloc_program_object()
+	{
+		return new RecordingProgramObjectProvider(log);
+	}
+
+	ShaderObjectProvider *RecordingGraphicContextProvider::alloc_shader_object()
+	{
+		return new RecordingShaderObjectProvider(log);
+	}
+
+	FrameBufferProvider *RecordingGraphicContextProvider::alloc_frame_buffer()
+	{
+		return new RecordingFrameBufferProvider(log);
+	}
+
+	RenderBufferProvider *RecordingGraphicContextProvider::alloc_render_buffer()
+	{
+		return new RecordingRenderBufferProvider(log);
+	}
+
+	VertexArrayBufferProvider *RecordingGraphicContextProvider::alloc_vertex_array_buffer()
+	{
+		return new RecordingVertexArrayBufferProvider(log);
+	}
+
+	UniformBufferProvider *RecordingGraphicContextProvider::alloc_uniform_buffer()
+	{
+		return new RecordingUniformBufferProvider(log);
+	}
+
+	StorageBufferProvider *RecordingGraphicContextProvider::alloc_storage_buffer()
+	{
+		return new RecordingStorageBufferProvider(log);
+	}
+
+	ElementArrayBufferProvider *RecordingGraphicContextProvider::alloc_element_array_buffer()
+	{
+		return new RecordingElementArrayBufferProvider(log);
+	}
+
+	TransferBufferProvider *RecordingGraphicContextProvider::alloc_transfer_buffer()
+	{
+		return new RecordingTransferBufferProvider(log);
+	}
+
+	PixelBufferProvider *RecordingGraphicContextProvider::alloc_pixel_buffer()
+	{
+		return new RecordingPixelBufferProvider(log);
+	}
+
+	PrimitivesArrayProvider *RecordingGraphicContextProvider::alloc_primitives_array()
+	{
+		return new RecordingPrimitivesArrayProvider(log);
+	}
+
+	std::shared_ptr<RasterizerStateProvider> RecordingGraphicContextProvider::create_rasterizer_state(const RasterizerStateDescription &desc)
+	{
+		return std::make_shared<RecordingRasterizerState>();
+	}
+
+	std::shared_ptr<BlendStateProvider> RecordingGraphicContextProvider::create_blend_state(const BlendStateDescription &desc)
+	{
+		return std::make_shared<RecordingBlendState>();
+	}
+
+	std::shared_ptr<DepthStencilStateProvider> RecordingGraphicContextProvider::create_depth_stencil_state(const DepthStencilStateDescription &desc)
+	{
+		return std::make_shared<RecordingDepthStencilState>();
+	}
+
+	void RecordingGraphicContextProvider::set_rasterizer_state(RasterizerStateProvider *state)
+	{
+		log->state_change("set_rasterizer_state");
+	}
+
+	void RecordingGraphicContextProvider::set_blend_state(BlendStateProvider *state, const Colorf &blend_color, unsigned int sample_mask)
+	{
+		log->state_change("set_blend_state");
+	}
+
+	void RecordingGraphicContextProvider::set_depth_stencil_state(DepthStencilStateProvider *state, int stencil_ref)
+	{
+		log->state_change("set_depth_stencil_state");
+	}
+
+	void RecordingGraphicContextProvider::set_program_object(StandardProgram standard_program)
+	{
+		log->state_change("set_program_object");
+	}
+
+	void RecordingGraphicContextProvider::set_program_object(const ProgramObject &program)
+	{
+		log->state_change("set_program_object");
+	}
+
+	void RecordingGraphicContextProvider::reset_program_object()
+	{
+		log->state_change("reset_program_object");
+	}
+
+	void RecordingGraphicContextProvider::set_uniform_buffer(int index, const UniformBuffer &buffer)
+	{
+		log->state_change("set_uniform_buffer");
+	}
+
+	void RecordingGraphicContextProvider::reset_uniform_buffer(int index)
+	{
+		log->state_change("reset_uniform_buffer");
+	}
+
+	void RecordingGraphicContextProvider::set_storage_buffer(int index, const StorageBuffer &buffer)
+	{
+		log->state_change("set_storage_buffer");
+	}
+
+	void RecordingGraphicContextProvider::reset_storage_buffer(int index)
+	{
+		log->state_change("reset_storage_buffer");
+	}
+
+	void RecordingGraphicContextProvider::set_texture(int unit_index, const Texture &texture)
+	{
+		log->state_change("set_texture");
+	}
+
+	void RecordingGraphicContextProvider::reset_texture(int unit_index)
+	{
+		log->state_change("reset_texture");
+	}
+
+	void RecordingGraphicContextProvider::set_image_texture(int unit_index, const Texture &texture)
+	{
+		log->state_change("set_image_texture");
+	}
+
+	void RecordingGraphicContextProvider::reset_image_texture(int unit_index)
+	{
+		log->state_change("reset_image_texture");
+	}
+
+	bool RecordingGraphicContextProvider::is_frame_buffer_owner(const FrameBuffer &fb)
+	{
+		RecordingFrameBufferProvider *fb_provider = dynamic_cast<RecordingFrameBufferProvider *>(fb.get_provider());
+		if (fb_provider)
+			return fb_provider->get_log() == log.get();
+		else
+			return false;
+	}
+
+	void RecordingGraphicContextProvider::set_frame_buffer(const FrameBuffer &write_buffer, const FrameBuffer &read_buffer)
+	{
+		log->state_change("set_frame_buffer");
+	}
+
+	void RecordingGraphicContextProvider::reset_frame_buffer()
+	{
+		log->state_change("reset_frame_buffer");
+	}
+
+	void RecordingGraphicContextProvider::set_draw_buffer(DrawBuffer buffer)
+	{
+		log->state_change("set_draw_buffer");
+	}
+
+	bool RecordingGraphicContextProvider::is_primitives_array_owner(const PrimitivesArray &primitives_array)
+	{
+		RecordingPrimitivesArrayProvider *prim_array_provider = dynamic_cast<RecordingPrimitivesArrayProvider *>(primitives_array.get_provider());
+		if (prim_array_provider)
+			return prim_array_provider->get_log() == log.get();
+		else
+			return false;
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives(PrimitivesType type, int num_vertices, const PrimitivesArray &primitives_array)
+	{
+		set_primitives_array(primitives_array);
+		draw_primitives_array(type, 0, num_vertices);
+		reset_primitives_array();
+	}
+
+	void RecordingGraphicContextProvider::set_primitives_array(const PrimitivesArray &primitives_array)
+	{
+		primitives_array_set = true;
+		log->state_change("set_primitives_array");
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_array(PrimitivesType type, int offset, int num_vertices)
+	{
+		draw("draw_primitives_array", type, num_vertices, 1);
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_array_instanced(PrimitivesType type, int offset, int num_vertices, int instance_count)
+	{
+		draw("draw_primitives_array_instanced", type, num_vertices, instance_count);
+	}
+
+	void RecordingGraphicContextProvider::set_primitives_elements(ElementArrayBufferProvider *array_provider)
+	{
+		primitives_elements_set = true;
+		log->state_change("set_primitives_elements");
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_elements(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset)
+	{
+		if (!primitives_elements_set)
+			throw Exception("No element array set");
+		draw("draw_primitives_elements", type, count, 1);
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_elements_instanced(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset, int instance_count)
+	{
+		if (!primitives_elements_set)
+			throw Exception("No element array set");
+		draw("draw_primitives_elements_instanced", type, count, instance_count);
+	}
+
+	void RecordingGraphicContextProvider::reset_primitives_elements()
+	{
+		primitives_elements_set = false;
+		log->state_change("reset_primitives_elements");
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_elements(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset)
+	{
+		draw("draw_primitives_elements", type, count, 1);
+	}
+
+	void RecordingGraphicContextProvider::draw_primitives_elements_instanced(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset, int instance_count)
+	{
+		draw("draw_primitives_elements_instanced", type, count, instance_count);
+	}
+
+	void RecordingGraphicContextProvider::reset_primitives_array()
+	{
+		primitives_array_set = false;
+		log->state_change("reset_primitives_array");
+	}
+
+	void RecordingGraphicContextProvider::set_scissor(const Rect &rect)
+	{
+		log->statistics.state_changes++;
+		if (log->is_logging())
+			log->log(string_format("set_scissor %1,%2 %3x%4", rect.left, rect.top, rect.get_width(), rect.get_height()));
+	}
+
+	void RecordingGraphicContextProvider::reset_scissor()
+	{
+		log->state_change("reset_scissor");
+	}
+
+	void RecordingGraphicContextProvider::dispatch(int x, int y, int z)
+	{
+		log->statistics.draw_calls++;
+		if (log->is_logging())
+			log->log(string_format("dispatch %1 %2 %3", x, y, z));
+	}
+
+	void RecordingGraphicContextProvider::clear(const Colorf &color)
+	{
+		log->statistics.clears++;
+		log->log("clear");
+	}
+
+	void RecordingGraphicContextProvider::clear_depth(float value)
+	{
+		log->statistics.clears++;
+		log->log("clear_depth");
+	}
+
+	void RecordingGraphicContextProvider::clear_stencil(int value)
+	{
+		log->statistics.clears++;
+		log->log("clear_stencil");
+	}
+
+	void RecordingGraphicContextProvider::set_viewport(const Rectf &viewport)
+	{
+		log->statistics.state_changes++;
+		if (log->is_logging())
+			log->log(string_format("set_viewport %1,%2 %3x%4", viewport.left, viewport.top, viewport.get_width(), viewport.get_height()));
+	}
+
+	void RecordingGraphicContextProvider::set_viewport(int index, const Rectf &viewport)
+	{
+		set_viewport(viewport);
+	}
+
+	void RecordingGraphicContextProvider::set_depth_range(float n, float f)
+	{
+		log->state_change("set_depth_range");
+	}
+
+	void RecordingGraphicContextProvider::set_depth_range(int viewport, float n, float f)
+	{
+		log->state_change("set_depth_range");
+	}
+
+	void RecordingGraphicContextProvider::flush()
+	{
+		log->log("flush");
+	}
+
+	void RecordingGraphicContextProvider::draw(const char *command, PrimitivesType type, int count, int instance_count)
+	{
+		if (!primitives_array_set)
+			throw Exception("No primitives array set");
+
+		log->statistics.draw_calls++;
+		log->statistics.vertices += (uint64_t)count * instance_count;
+		if (log->is_logging())
+			log->log(string_format("%1 %2 %3 instances=%4", command, primitives_type_names[type], count, instance_count));
+	}
+}
@@ -0,0 +1,129 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/graphic_context_provider.h"
+#include "API/Display/Render/program_object.h"
+#include "API/Core/Signals/signal.h"
+#include "recording_log.h"
+
+namespace clan
+{
+	class RecordingGraphicContextProvider : public GraphicContextProvider
+	{
+	public:
+		RecordingGraphicContextProvider(const Size &window_size, float pixel_ratio);
+		~RecordingGraphicContextProvider();
+
+		RecordingLog &get_log() { return *log; }
+		void set_window_size(const Size &size, float pixel_ratio);
+
+		int get_max_attributes() override { return 16; }
+		Size get_max_texture_size() const override { return Size(16384, 16384); }
+		Size get_display_window_size() const override { return window_size; }
+		float get_pixel_ratio() const override { return pixel_ratio; }
+		Signal<void(const Size &)> &sig_window_resized() override { return window_resized_signal; }
+		ProgramObject get_program_object(StandardProgram standard_program) const override;
+		ClipZRange get_clip_z_range() const override { return clip_negative_positive_w; }
+		TextureImageYAxis get_texture_image_y_axis() const override { return y_axis_bottom_up; }
+		ShaderLanguage get_shader_language() const override { return shader_glsl; }
+		int get_major_version() const override { return 3; }
+		int get_minor_version() const override { return 3; }
+		bool has_compute_shader_support() const override { return false; }
+		PixelBuffer get_pixeldata(const Rect& rect, TextureFormat texture_format, bool clamp) const override;
+		TextureProvider *alloc_texture(TextureDimensions texture_dimensions) override;
+		OcclusionQueryProvider *alloc_occlusion_query() override;
+		ProgramObjectProvider *alloc_program_object() override;
+		ShaderObjectProvider *alloc_shader_object() override;
+		FrameBufferProvider *alloc_frame_buffer() override;
+		RenderBufferProvider *alloc_render_buffer() override;
+		VertexArrayBufferProvider *alloc_vertex_array_buffer() override;
+		UniformBufferProvider *alloc_uniform_buffer() override;
+		StorageBufferProvider *alloc_storage_buffer() override;
+		ElementArrayBufferProvider *alloc_element_array_buffer() override;
+		TransferBufferProvider *alloc_transfer_buffer() override;
+		PixelBufferProvider *alloc_pixel_buffer() override;
+		PrimitivesArrayProvider *alloc_primitives_array() override;
+		std::shared_ptr<RasterizerStateProvider> create_rasterizer_state(const RasterizerStateDescription &desc) override;
+		std::shared_ptr<BlendStateProvider> create_blend_state(const BlendStateDescription &desc) override;
+		std::shared_ptr<DepthStencilStateProvider> create_depth_stencil_state(const DepthStencilStateDescription &desc) override;
+		void set_rasterizer_state(RasterizerStateProvider *state) override;
+		void set_blend_state(BlendStateProvider *state, const Colorf &blend_color, unsigned int sample_mask) override;
+		void set_depth_stencil_state(DepthStencilStateProvider *state, int stencil_ref) override;
+		void set_program_object(StandardProgram standard_program) override;
+		void set_program_object(const ProgramObject &program) override;
+		void reset_program_object() override;
+		void set_uniform_buffer(int index, const UniformBuffer &buffer) override;
+		void reset_uniform_buffer(int index) override;
+		void set_storage_buffer(int index, const StorageBuffer &buffer) override;
+		void reset_storage_buffer(int index) override;
+		void set_texture(int unit_index, const Texture &texture) override;
+		void reset_texture(int unit_index) override;
+		void set_image_texture(int unit_index, const Texture &texture) override;
+		void reset_image_texture(int unit_index) override;
+		bool is_frame_buffer_owner(const FrameBuffer &fb) override;
+		void set_frame_buffer(const FrameBuffer &write_buffer, const FrameBuffer &read_buffer) override;
+		void reset_frame_buffer() override;
+		void set_draw_buffer(DrawBuffer buffer) override;
+		bool is_primitives_array_owner(const PrimitivesArray &primitives_array) override;
+		void draw_primitives(PrimitivesType type, int num_vertices, const PrimitivesArray &primitives_array) override;
+		void set_primitives_array(const PrimitivesArray &primitives_array) override;
+		void draw_primitives_array(PrimitivesType type, int offset, int num_vertices) override;
+		void draw_primitives_array_instanced(PrimitivesType type, int offset, int num_vertices, int instance_count) override;
+		void set_primitives_elements(ElementArrayBufferProvider *array_provider) override;
+		void draw_primitives_elements(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset = 0) override;
+		void draw_primitives_elements_instanced(PrimitivesType type, int count, VertexAttributeDataType indices_type, size_t offset, int instance_count) override;
+		void reset_primitives_elements() override;
+		void draw_primitives_elements(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset) override;
+		void draw_primitives_elements_instanced(PrimitivesType type, int count, ElementArrayBufferProvider *array_provider, VertexAttributeDataType indices_type, void *offset, int instance_count) override;
+		void reset_primitives_array() override;
+		void set_scissor(const Rect &rect) override;
+		void reset_scissor() override;
+		void dispatch(int x, int y, int z) override;
+		void clear(const Colorf &color) override;
+		void clear_depth(float value) override;
+		void clear_stencil(int value) override;
+		void set_viewport(const Rectf &viewport) override;
+		void set_viewport(int index, const Rectf &viewport) override;
+		void set_depth_range(float n, float f) override;
+		void set_depth_range(int viewport, float n, float f) override;
+		void flush() override;
+
+	private:
+		void draw(const char *command, PrimitivesType type, int count, int instance_count);
+
+		std::shared_ptr<RecordingLog> log;
+		Size window_size;
+		float pixel_ratio;
+		Signal<void(const Size &)> window_resized_signal;
+		ProgramObject standard_programs[4];
+		bool primitives_array_set = false;
+		bool primitives_elements_set = false;
+	};
+}
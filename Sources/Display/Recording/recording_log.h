@@ -0,0 +1,65 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/Recording/recording_target.h"
+#include <memory>
+
+namespace clan
+{
+	/// \brief Statistics and command log shared by a recording graphic context and its resources
+	class RecordingLog
+	{
+	public:
+		bool is_logging() const { return log_enabled; }
+
+		void log(const std::string &command)
+		{
+			if (log_enabled)
+				commands.push_back(command);
+		}
+
+		void state_change(const char *command)
+		{
+			statistics.state_changes++;
+			if (log_enabled)
+				commands.push_back(command);
+		}
+
+		void reset()
+		{
+			statistics = RecordingStatistics();
+			commands.clear();
+		}
+
+		RecordingStatistics statistics;
+		bool log_enabled = false;
+		std::vector<std::string> commands;
+	};
+}
@@ -0,0 +1,49 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_primitives_array_provider.h"
+#include "API/Core/Text/string_format.h"
+
+namespace clan
+{
+	RecordingPrimitivesArrayProvider::RecordingPrimitivesArrayProvider(const std::shared_ptr<RecordingLog> &log)
+		: log(log)
+	{
+		log->statistics.resources_created++;
+	}
+
+	void RecordingPrimitivesArrayProvider::set_attribute(int index, const VertexData &data, bool normalize)
+	{
+		if (index < 0)
+			throw Exception("Invalid attribute index");
+
+		if (log->is_logging())
+			log->log(string_format("set_attribute %1 size=%2 offset=%3 stride=%4%5", index, data.size, (unsigned int)data.offset, data.stride, normalize ? " normalized" : ""));
+	}
+}
@@ -0,0 +1,139 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_program_object_provider.h"
+#include "API/Core/Text/string_format.h"
+#include <algorithm>
+
+namespace clan
+{
+	RecordingShaderObjectProvider::RecordingShaderObjectProvider(const std::shared_ptr<RecordingLog> &log)
+		: log(log)
+	{
+	}
+
+	void RecordingShaderObjectProvider::create(ShaderType type, const std::string &new_source)
+	{
+		shader_type = type;
+		source = new_source;
+		log->statistics.resources_created++;
+		log->log("create_shader");
+	}
+
+	void RecordingShaderObjectProvider::create(ShaderType type, const void *bytecode, int bytecode_size)
+	{
+		shader_type = type;
+		source.clear();
+		log->statistics.resources_created++;
+		log->log("create_shader");
+	}
+
+	void RecordingShaderObjectProvider::create(ShaderType type, const std::vector<std::string> &sources)
+	{
+		shader_type = type;
+		source.clear();
+		for (const auto &text : sources)
+			source += text;
+		log->statistics.resources_created++;
+		log->log("create_shader");
+	}
+
+	void RecordingShaderObjectProvider::compile()
+	{
+		compiled = true;
+		log->log("compile_shader");
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+	RecordingProgramObjectProvider::RecordingProgramObjectProvider(const std::shared_ptr<RecordingLog> &log)
+		: log(log)
+	{
+		log->statistics.resources_created++;
+	}
+
+	int RecordingProgramObjectProvider::get_attribute_location(const std::string &name) const
+	{
+		return find_location(attribute_locations, name);
+	}
+
+	int RecordingProgramObjectProvider::get_uniform_location(const std::string &name) const
+	{
+		return find_location(uniform_locations, name);
+	}
+
+	int RecordingProgramObjectProvider::get_uniform_buffer_index(const std::string &block_name) const
+	{
+		return find_location(block_indexes, block_name);
+	}
+
+	int RecordingProgramObjectProvider::get_storage_buffer_index(const std::string &name) const
+	{
+		return find_location(block_indexes, name);
+	}
+
+	void RecordingProgramObjectProvider::attach(const ShaderObject &obj)
+	{
+		shaders.push_back(obj);
+	}
+
+	void RecordingProgramObjectProvider::detach(const ShaderObject &obj)
+	{
+		shaders.erase(std::remove(shaders.begin(), shaders.end(), obj), shaders.end());
+	}
+
+	void RecordingProgramObjectProvider::bind_attribute_location(int index, const std::string &name)
+	{
+		attribute_locations[name] = index;
+	}
+
+	void RecordingProgramObjectProvider::link()
+	{
+		linked = true;
+		log->log("link_program");
+	}
+
+	int RecordingProgramObjectProvider::find_location(std::map<std::string, int> &locations, const std::string &name) const
+	{
+		auto it = locations.find(name);
+		if (it != locations.end())
+			return it->second;
+
+		int location = (int)locations.size();
+		locations[name] = location;
+		return location;
+	}
+
+	void RecordingProgramObjectProvider::set_uniform(int location)
+	{
+		log->statistics.state_changes++;
+		if (log->is_logging())
+			log->log(string_format("set_uniform %1", location));
+	}
+}
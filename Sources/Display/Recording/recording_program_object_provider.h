@@ -0,0 +1,110 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/TargetProviders/program_object_provider.h"
+#include "API/Display/TargetProviders/shader_object_provider.h"
+#include "API/Display/Render/shader_object.h"
+#include "recording_log.h"
+#include <map>
+
+namespace clan
+{
+	class RecordingShaderObjectProvider : public ShaderObjectProvider
+	{
+	public:
+		RecordingShaderObjectProvider(const std::shared_ptr<RecordingLog> &log);
+
+		void create(ShaderType type, const std::string &source) override;
+		void create(ShaderType type, const void *source, int source_size) override;
+		void create(ShaderType type, const std::vector<std::string> &sources) override;
+		unsigned int get_handle() const override { return 0; }
+		bool get_compile_status() const override { return compiled; }
+		ShaderType get_shader_type() const override { return shader_type; }
+		std::string get_info_log() const override { return std::string(); }
+		std::string get_shader_source() const override { return source; }
+		void compile() override;
+
+	private:
+		std::shared_ptr<RecordingLog> log;
+		ShaderType shader_type = shadertype_vertex;
+		std::string source;
+		bool compiled = false;
+	};
+
+	class RecordingProgramObjectProvider : public ProgramObjectProvider
+	{
+	public:
+		RecordingProgramObjectProvider(const std::shared_ptr<RecordingLog> &log);
+
+		unsigned int get_handle() const override { return 0; }
+		bool get_link_status() const override { return linked; }
+		bool get_validate_status() const override { return linked; }
+		std::string get_info_log() const override { return std::string(); }
+		std::vector<ShaderObject> get_shaders() const override { return shaders; }
+		int get_attribute_location(const std::string &name) const override;
+		int get_uniform_location(const std::string &name) const override;
+		int get_uniform_buffer_size(int block_index) const override { return 0; }
+		int get_uniform_buffer_index(const std::string &block_name) const override;
+		int get_storage_buffer_index(const std::string &name) const override;
+
+		void attach(const ShaderObject &obj) override;
+		void detach(const ShaderObject &obj) override;
+		void bind_attribute_location(int index, const std::string &name) override;
+		void bind_frag_data_location(int color_number, const std::string &name) override { }
+		void link() override;
+		void validate() override { }
+		void set_uniform1i(int location, int value_a) override { set_uniform(location); }
+		void set_uniform2i(int location, int value_a, int value_b) override { set_uniform(location); }
+		void set_uniform3i(int location, int value_a, int value_b, int value_c) override { set_uniform(location); }
+		void set_uniform4i(int location, int value_a, int value_b, int value_c, int value_d) override { set_uniform(location); }
+		void set_uniformiv(int location, int size, int count, const int *data) override { set_uniform(location); }
+		void set_uniform1f(int location, float value_a) override { set_uniform(location); }
+		void set_uniform2f(int location, float value_a, float value_b) override { set_uniform(location); }
+		void set_uniform3f(int location, float value_a, float value_b, float value_c) override { set_uniform(location); }
+		void set_uniform4f(int location, float value_a, float value_b, float value_c, float value_d) override { set_uniform(location); }
+		void set_uniformfv(int location, int size, int count, const float *data) override { set_uniform(location); }
+		void set_uniform_matrix(int location, int size, int count, bool transpose, const float *data) override { set_uniform(location); }
+		void set_uniform_buffer_index(int block_index, int bind_index) override { set_uniform(block_index); }
+		void set_storage_buffer_index(int buffer_index, int bind_unit_index) override { set_uniform(buffer_index); }
+
+	private:
+		int find_location(std::map<std::string, int> &locations, const std::string &name) const;
+		void set_uniform(int location);
+
+		std::shared_ptr<RecordingLog> log;
+		std::vector<ShaderObject> shaders;
+		bool linked = false;
+
+		// Names are assigned locations the first time they are queried
+		mutable std::map<std::string, int> attribute_locations;
+		mutable std::map<std::string, int> uniform_locations;
+		mutable std::map<std::string, int> block_indexes;
+	};
+}
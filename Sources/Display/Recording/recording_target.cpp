@@ -0,0 +1,79 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "API/Display/Recording/recording_target.h"
+#include "API/Display/display_target.h"
+#include "API/Display/Render/graphic_context.h"
+#include "recording_target_provider.h"
+#include "recording_graphic_context_provider.h"
+
+namespace clan
+{
+	namespace
+	{
+		RecordingLog &get_recording_log(const GraphicContext &gc)
+		{
+			const RecordingGraphicContextProvider *provider = dynamic_cast<const RecordingGraphicContextProvider *>(gc.get_provider());
+			if (provider == nullptr)
+				throw Exception("Graphic Context is not from a recording target");
+			return const_cast<RecordingGraphicContextProvider *>(provider)->get_log();
+		}
+	}
+
+	bool RecordingTarget::is_current()
+	{
+		return std::dynamic_pointer_cast<RecordingTargetProvider>(DisplayTarget::get_current_target()) ? true : false;
+	}
+
+	void RecordingTarget::set_current()
+	{
+		static std::shared_ptr<RecordingTargetProvider> provider = std::make_shared<RecordingTargetProvider>();
+		DisplayTarget::set_current_target(provider);
+	}
+
+	RecordingStatistics RecordingTarget::get_statistics(const GraphicContext &gc)
+	{
+		return get_recording_log(gc).statistics;
+	}
+
+	void RecordingTarget::reset_statistics(const GraphicContext &gc)
+	{
+		get_recording_log(gc).reset();
+	}
+
+	void RecordingTarget::set_command_log_enabled(const GraphicContext &gc, bool enable)
+	{
+		get_recording_log(gc).log_enabled = enable;
+	}
+
+	std::vector<std::string> RecordingTarget::get_command_log(const GraphicContext &gc)
+	{
+		return get_recording_log(gc).commands;
+	}
+}
@@ -0,0 +1,113 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_texture_provider.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Core/Text/string_format.h"
+#include "API/Core/Math/cl_math.h"
+
+namespace clan
+{
+	RecordingTextureProvider::RecordingTextureProvider(const std::shared_ptr<RecordingLog> &log, TextureDimensions texture_dimensions)
+		: log(log), texture_dimensions(texture_dimensions)
+	{
+	}
+
+	RecordingTextureProvider::~RecordingTextureProvider()
+	{
+	}
+
+	void RecordingTextureProvider::create(int new_width, int new_height, int new_depth, int new_array_size, TextureFormat new_format, int new_levels)
+	{
+		width = new_width;
+		height = new_height;
+		depth = new_depth;
+		array_size = new_array_size;
+		texture_format = new_format;
+		levels = new_levels;
+
+		log->statistics.resources_created++;
+		if (log->is_logging())
+			log->log(string_format("create_texture %1x%2x%3 array_size=%4 levels=%5", width, height, depth, array_size, levels));
+	}
+
+	PixelBuffer RecordingTextureProvider::get_pixeldata(GraphicContext &gc, TextureFormat format, int level) const
+	{
+		int level_width = max(width >> level, 1);
+		int level_height = max(height >> level, 1);
+
+		PixelBuffer buffer(level_width, level_height, format);
+		memset(buffer.get_data(), 0, buffer.get_data_size());
+
+		if (log->is_logging())
+			log->log(string_format("get_texture_pixeldata %1x%2 level=%3", level_width, level_height, level));
+		return buffer;
+	}
+
+	void RecordingTextureProvider::generate_mipmap()
+	{
+		log->log("generate_mipmap");
+	}
+
+	void RecordingTextureProvider::copy_from(GraphicContext &gc, int x, int y, int slice, int level, const PixelBuffer &src, const Rect &src_rect)
+	{
+		if (src_rect.left < 0 || src_rect.top < 0 || src_rect.right > src.get_width() || src_rect.bottom > src.get_height())
+			throw Exception("Rectangle out of bounds");
+
+		log->statistics.texture_uploads++;
+		log->statistics.texture_bytes += PixelBuffer::get_data_size(src_rect.get_size(), src.get_format());
+		if (log->is_logging())
+			log->log(string_format("upload_texture %1,%2 %3x%4 slice=%5 level=%6", x, y, src_rect.get_width(), src_rect.get_height(), slice, level));
+	}
+
+	void RecordingTextureProvider::copy_image_from(int x, int y, int new_width, int new_height, int level, TextureFormat new_format, GraphicContextProvider *gc)
+	{
+		create(new_width, new_height, 1, 1, new_format, level + 1);
+		if (log->is_logging())
+			log->log(string_format("copy_image_from_frame_buffer %1,%2 %3x%4", x, y, new_width, new_height));
+	}
+
+	void RecordingTextureProvider::copy_subimage_from(int offset_x, int offset_y, int x, int y, int copy_width, int copy_height, int level, GraphicContextProvider *gc)
+	{
+		if (log->is_logging())
+			log->log(string_format("copy_subimage_from_frame_buffer %1,%2 %3x%4 to %5,%6", x, y, copy_width, copy_height, offset_x, offset_y));
+	}
+
+	TextureProvider *RecordingTextureProvider::create_view(TextureDimensions view_dimensions, TextureFormat view_format, int min_level, int num_levels, int min_layer, int num_layers)
+	{
+		RecordingTextureProvider *view = new RecordingTextureProvider(log, view_dimensions);
+		view->width = max(width >> min_level, 1);
+		view->height = max(height >> min_level, 1);
+		view->depth = depth;
+		view->array_size = num_layers;
+		view->texture_format = view_format;
+		view->levels = num_levels;
+		return view;
+	}
+}
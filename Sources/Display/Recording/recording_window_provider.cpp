@@ -0,0 +1,137 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Display/precomp.h"
+#include "recording_window_provider.h"
+#include "recording_graphic_context_provider.h"
+#include "recording_input_device_provider.h"
+#include "API/Display/Window/display_window_description.h"
+
+namespace clan
+{
+	RecordingWindowProvider::RecordingWindowProvider()
+	{
+	}
+
+	RecordingWindowProvider::~RecordingWindowProvider()
+	{
+		if (site)
+			site->sig_window_destroy();
+	}
+
+	void RecordingWindowProvider::create(DisplayWindowSite *new_site, const DisplayWindowDescription &description)
+	{
+		site = new_site;
+
+		Rectf position = description.get_position();
+		client_area = Rect((int)position.left, (int)position.top, (int)position.right, (int)position.bottom);
+		title = description.get_title();
+		visible = description.is_visible();
+
+		gc_provider = new RecordingGraphicContextProvider(client_area.get_size(), pixel_ratio);
+		gc = GraphicContext(gc_provider);
+		keyboard = InputDevice(new RecordingInputDeviceProvider(InputDevice::keyboard));
+		mouse = InputDevice(new RecordingInputDeviceProvider(InputDevice::pointer));
+	}
+
+	void RecordingWindowProvider::request_repaint()
+	{
+		if (site)
+			site->sig_paint();
+	}
+
+	void RecordingWindowProvider::set_position(const Rect &pos, bool client_area_pos)
+	{
+		bool resized = client_area.get_size() != pos.get_size();
+		client_area = pos;
+		if (site)
+			site->sig_window_moved();
+		if (resized)
+			on_resized();
+	}
+
+	void RecordingWindowProvider::set_size(int width, int height, bool client_area_size)
+	{
+		if (client_area.get_width() != width || client_area.get_height() != height)
+		{
+			client_area.right = client_area.left + width;
+			client_area.bottom = client_area.top + height;
+			on_resized();
+		}
+	}
+
+	void RecordingWindowProvider::set_pixel_ratio(float ratio)
+	{
+		if (pixel_ratio != ratio)
+		{
+			pixel_ratio = ratio;
+			on_resized();
+		}
+	}
+
+	void RecordingWindowProvider::minimize()
+	{
+		minimized = true;
+		maximized = false;
+		if (site)
+			site->sig_window_minimized();
+	}
+
+	void RecordingWindowProvider::restore()
+	{
+		minimized = false;
+		maximized = false;
+		if (site)
+			site->sig_window_restored();
+	}
+
+	void RecordingWindowProvider::maximize()
+	{
+		minimized = false;
+		maximized = true;
+		if (site)
+			site->sig_window_maximized();
+	}
+
+	void RecordingWindowProvider::flip(int interval)
+	{
+		gc.flush();
+
+		RecordingLog &log = gc_provider->get_log();
+		log.statistics.frames++;
+		log.log("flip");
+	}
+
+	void RecordingWindowProvider::on_resized()
+	{
+		if (gc_provider)
+			gc_provider->set_window_size(client_area.get_size(), pixel_ratio);
+		if (site)
+			site->sig_resize(client_area.get_width() / pixel_ratio, client_area.get_height() / pixel_ratio);
+	}
+}
@@ -39,13 +39,19 @@
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "API/Core/IOData/path_help.h"
+#include "API/Core/IOData/memory_device.h"
+#include "API/Core/System/databuffer.h"
+#include "API/Core/System/system.h"
+#include "API/Core/System/exception.h"
+#include "API/Core/Math/cl_math.h"
+#include "API/Display/ImageProviders/provider_factory.h"
 #include "file_display_cache.h"
 #include "../Font/font_impl.h"
 
 namespace clan
 {
 	FileDisplayCache::FileDisplayCache(const FileResourceDocument &doc)
-		: doc(doc)
+		: doc(doc), loader(std::make_shared<FileDisplayCacheLoader>(doc.get_file_system()))
 	{
 	}
 
@@ -63,7 +69,10 @@ namespace clan
 			return sprite;
 		}
 
-		Resource<Sprite> sprite = Sprite(canvas, id, doc.get_file_system());
+		Sprite new_sprite(canvas);
+		new_sprite.add_frame(load_texture(canvas, id));
+		new_sprite.restart();
+		Resource<Sprite> sprite = new_sprite;
 		sprites[id] = sprite;
 		sprite.get() = sprite.get().clone();
 		return sprite;
@@ -79,7 +88,8 @@ namespace clan
 			return image;
 		}
 
-		Resource<Image> image = Image(canvas, id, doc.get_file_system());
+		Texture2D texture = load_texture(canvas, id);
+		Resource<Image> image = Image(texture, texture.get_size());
 		images[id] = image;
 		image.get() = image.get().clone();
 		return image;
@@ -91,7 +101,7 @@ namespace clan
 		if (it != textures.end())
 			return it->second;
 
-		Resource<Texture> texture = Texture2D(gc, id, doc.get_file_system());
+		Resource<Texture> texture = load_texture(gc, id);
 		textures[id] = texture;
 		return texture;
 	}
@@ -111,4 +121,343 @@ namespace clan
 
 		return font;
 	}
+
+	Resource<Sprite> FileDisplayCache::get_sprite_async(Canvas &canvas, const std::string &id, int priority)
+	{
+		if (sprites.find(id) != sprites.end())
+			return get_sprite(canvas, id);
+
+		Texture2D texture = find_texture(id);
+		if (!texture.is_null())
+		{
+			Sprite sprite(canvas);
+			sprite.add_frame(texture);
+			sprites[id] = sprite;
+			return get_sprite(canvas, id);
+		}
+
+		Resource<Sprite> sprite;
+		std::shared_ptr<FileDisplayCacheLoad> load = request(id, priority);
+		load->canvas = canvas;
+		load->sprites.push_back(sprite);
+		return sprite;
+	}
+
+	Resource<Image> FileDisplayCache::get_image_async(Canvas &canvas, const std::string &id, int priority)
+	{
+		if (images.find(id) != images.end())
+			return get_image(canvas, id);
+
+		Texture2D texture = find_texture(id);
+		if (!texture.is_null())
+		{
+			images[id] = Image(texture, texture.get_size());
+			return get_image(canvas, id);
+		}
+
+		Resource<Image> image;
+		request(id, priority)->images.push_back(image);
+		return image;
+	}
+
+	Resource<Texture> FileDisplayCache::get_texture_async(GraphicContext & /*gc*/, const std::string &id, int priority)
+	{
+		auto it = textures.find(id);
+		if (it != textures.end())
+			return it->second;
+
+		std::shared_ptr<FileDisplayCacheLoad> load = request(id, priority);
+		if (load->textures.empty())
+			load->textures.push_back(Resource<Texture>());
+		return load->textures.front();
+	}
+
+	void FileDisplayCache::prefetch(GraphicContext & /*gc*/, const std::vector<std::string> &ids, int priority)
+	{
+		for (const auto &id : ids)
+		{
+			if (textures.find(id) == textures.end())
+				request(id, priority);
+		}
+	}
+
+	void FileDisplayCache::set_priority(const std::string &id, int priority)
+	{
+		auto it = loads.find(id);
+		if (it == loads.end())
+			return;
+
+		FileDisplayCacheLoad &load = *it->second;
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		if (load.state != ResourceLoadState::pending || load.priority == priority)
+			return;
+
+		auto key = FileDisplayCacheLoader::get_key(load);
+		load.priority = priority;
+		for (auto queue : { &loader->decode_queue, &loader->upload_queue })
+		{
+			auto entry = queue->find(key);
+			if (entry != queue->end())
+			{
+				queue->erase(entry);
+				(*queue)[FileDisplayCacheLoader::get_key(load)] = it->second;
+			}
+		}
+	}
+
+	void FileDisplayCache::cancel(const std::string &id)
+	{
+		auto it = loads.find(id);
+		if (it == loads.end())
+			return;
+
+		FileDisplayCacheLoad &load = *it->second;
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		if (load.state != ResourceLoadState::pending)
+			return;
+
+		auto key = FileDisplayCacheLoader::get_key(load);
+		loader->decode_queue.erase(key);
+		loader->upload_queue.erase(key);
+		load.state = ResourceLoadState::cancelled;
+		load.pixels = PixelBuffer();
+		loader->pending_loads--;
+		lock.unlock();
+
+		load.texture = Texture2D();
+		load.canvas = Canvas();
+		load.textures.clear();
+		load.images.clear();
+		load.sprites.clear();
+	}
+
+	ResourceLoadState FileDisplayCache::get_load_state(const std::string &id) const
+	{
+		auto it = loads.find(id);
+		if (it == loads.end())
+			return ResourceLoadState::none;
+
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		return it->second->state;
+	}
+
+	int FileDisplayCache::get_pending_loads() const
+	{
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		return loader->pending_loads;
+	}
+
+	void FileDisplayCache::process_loads(GraphicContext &gc, int budget_microseconds)
+	{
+		std::unique_lock<std::mutex> failed_lock(loader->mutex);
+		std::vector<std::shared_ptr<FileDisplayCacheLoad> > failed_loads;
+		failed_loads.swap(loader->failed_loads);
+		for (auto &load : failed_loads)
+		{
+			// Cancelled after the decode failed
+			if (load->state != ResourceLoadState::pending)
+				continue;
+			load->state = ResourceLoadState::failed;
+			loader->pending_loads--;
+		}
+		failed_lock.unlock();
+
+		for (auto &load : failed_loads)
+			fail_load(*load);
+
+		uint64_t start_time = System::get_microseconds();
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(loader->mutex);
+			if (loader->upload_queue.empty())
+				break;
+			std::shared_ptr<FileDisplayCacheLoad> load = loader->upload_queue.begin()->second;
+			lock.unlock();
+
+			if (upload_step(gc, *load))
+			{
+				lock.lock();
+				loader->upload_queue.erase(FileDisplayCacheLoader::get_key(*load));
+				load->state = ResourceLoadState::loaded;
+				load->pixels = PixelBuffer();
+				loader->pending_loads--;
+				lock.unlock();
+
+				finish_load(*load);
+			}
+
+			if (System::get_microseconds() - start_time >= (uint64_t)budget_microseconds)
+				break;
+		}
+	}
+
+	std::shared_ptr<FileDisplayCacheLoad> FileDisplayCache::request(const std::string &id, int priority)
+	{
+		auto it = loads.find(id);
+		if (it != loads.end())
+		{
+			std::unique_lock<std::mutex> lock(loader->mutex);
+			ResourceLoadState state = it->second->state;
+			lock.unlock();
+
+			if (state == ResourceLoadState::pending)
+			{
+				if (priority > it->second->priority)
+					set_priority(id, priority);
+				return it->second;
+			}
+		}
+
+		// Cancelled and failed requests are retried from scratch
+		auto load = std::make_shared<FileDisplayCacheLoad>();
+		load->id = id;
+		load->priority = priority;
+		load->sequence = next_sequence++;
+		loads[id] = load;
+
+		std::unique_lock<std::mutex> lock(loader->mutex);
+		loader->decode_queue[FileDisplayCacheLoader::get_key(*load)] = load;
+		loader->pending_loads++;
+		lock.unlock();
+
+		// Each work item decodes whichever request has the highest priority when a worker gets to it
+		std::shared_ptr<FileDisplayCacheLoader> shared_loader = loader;
+		work_queue.queue([shared_loader]() { shared_loader->decode_next(); });
+		return load;
+	}
+
+	bool FileDisplayCache::upload_step(GraphicContext &gc, FileDisplayCacheLoad &load)
+	{
+		// Loaded synchronously in the mean time
+		if (load.texture.is_null() && textures.find(load.id) != textures.end())
+		{
+			load.texture = find_texture(load.id);
+			return true;
+		}
+
+		const PixelBuffer &pixels = load.pixels;
+		if (load.texture.is_null())
+		{
+			load.texture = Texture2D(gc, pixels.get_width(), pixels.get_height(), tf_rgba8);
+			load.texture.set_pixel_ratio(pixels.get_pixel_ratio());
+		}
+
+		// Large images are uploaded in bands so a single texture can't blow the frame budget
+		int rows = min(upload_band_rows, pixels.get_height() - load.uploaded_rows);
+		if (rows > 0)
+			load.texture.set_subimage(gc, Point(0, load.uploaded_rows), pixels, Rect(0, load.uploaded_rows, pixels.get_width(), load.uploaded_rows + rows), 0);
+		load.uploaded_rows += rows;
+
+		return load.uploaded_rows >= pixels.get_height();
+	}
+
+	void FileDisplayCache::finish_load(FileDisplayCacheLoad &load)
+	{
+		Texture2D texture = load.texture;
+		if (textures.find(load.id) == textures.end())
+			textures[load.id] = Resource<Texture>(texture);
+		if (images.find(load.id) == images.end())
+			images[load.id] = Image(texture, texture.get_size());
+		if (!load.canvas.is_null() && sprites.find(load.id) == sprites.end())
+		{
+			Sprite sprite(load.canvas);
+			sprite.add_frame(texture);
+			sprites[load.id] = sprite;
+		}
+
+		for (auto &resource : load.textures)
+			resource.set(textures[load.id].get());
+		for (auto &resource : load.images)
+			resource.set(images[load.id].get().clone());
+		for (auto &resource : load.sprites)
+			resource.set(sprites[load.id].get().clone());
+
+		load.texture = Texture2D();
+		load.canvas = Canvas();
+		load.textures.clear();
+		load.images.clear();
+		load.sprites.clear();
+	}
+
+	void FileDisplayCache::fail_load(FileDisplayCacheLoad &load)
+	{
+		// Setting the null value lets Resource::updated() tell the caller the request is done
+		for (auto &resource : load.textures)
+			resource.set(Texture());
+		for (auto &resource : load.images)
+			resource.set(Image());
+		for (auto &resource : load.sprites)
+			resource.set(Sprite());
+
+		load.canvas = Canvas();
+		load.textures.clear();
+		load.images.clear();
+		load.sprites.clear();
+	}
+
+	Texture2D FileDisplayCache::find_texture(const std::string &id)
+	{
+		auto it = textures.find(id);
+		if (it != textures.end())
+			return it->second.get().to_texture_2d();
+		else
+			return Texture2D();
+	}
+
+	Texture2D FileDisplayCache::load_texture(GraphicContext &gc, const std::string &id)
+	{
+		// The worker threads may be reading from the same file system
+		DataBuffer data = loader->read_file(id);
+		MemoryDevice device(data);
+		return Texture2D(gc, device, PathHelp::get_extension(id));
+	}
+
+	DataBuffer FileDisplayCacheLoader::read_file(const std::string &filename)
+	{
+		std::unique_lock<std::mutex> file_lock(file_mutex);
+		IODevice file = fs.open_file(filename);
+		DataBuffer data(file.get_size());
+		file.read(data.get_data(), data.get_size());
+		return data;
+	}
+
+	void FileDisplayCacheLoader::decode_next()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (decode_queue.empty())
+			return;
+		std::shared_ptr<FileDisplayCacheLoad> load = decode_queue.begin()->second;
+		decode_queue.erase(decode_queue.begin());
+		lock.unlock();
+
+		PixelBuffer pixels;
+		try
+		{
+			// Decoding from memory is thread safe
+			DataBuffer data = read_file(load->id);
+			MemoryDevice device(data);
+			pixels = ImageProviderFactory::load(device, PathHelp::get_extension(load->id));
+			if (pixels.get_format() != tf_rgba8)
+				pixels = pixels.to_format(tf_rgba8);
+		}
+		catch (const Exception &)
+		{
+			pixels = PixelBuffer();
+		}
+
+		lock.lock();
+		if (load->state != ResourceLoadState::pending)
+			return;
+
+		if (pixels.is_null())
+		{
+			// The placeholders belong to the thread calling process_loads, so it reports the failure
+			failed_loads.push_back(load);
+		}
+		else
+		{
+			load->pixels = pixels;
+			upload_queue[get_key(*load)] = load;
+		}
+	}
 }
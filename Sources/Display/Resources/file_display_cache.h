@@ -30,12 +30,65 @@
 #pragma once
 
 #include "API/Display/Resources/display_cache.h"
+#include "API/Display/Render/texture_2d.h"
+#include "API/Display/Image/pixel_buffer.h"
+#include "API/Display/2D/canvas.h"
 #include "API/Core/Resources/file_resource_document.h"
+#include "API/Core/System/work_queue.h"
+#include "API/Core/System/databuffer.h"
+#include <map>
+#include <mutex>
 
 namespace clan
 {
 	class FontFamily;
 
+	/// \brief An asynchronous request for an image file
+	class FileDisplayCacheLoad
+	{
+	public:
+		std::string id;
+
+		// Protected by FileDisplayCacheLoader::mutex
+		int priority = 0;
+		uint64_t sequence = 0;
+		ResourceLoadState state = ResourceLoadState::pending;
+		PixelBuffer pixels;
+
+		// Only accessed by the thread calling process_loads
+		Texture2D texture;
+		int uploaded_rows = 0;
+		Canvas canvas;
+		std::vector<Resource<Sprite> > sprites;
+		std::vector<Resource<Image> > images;
+		std::vector<Resource<Texture> > textures;
+	};
+
+	/// \brief Decode and upload queues shared between the cache and its worker threads
+	class FileDisplayCacheLoader
+	{
+	public:
+		FileDisplayCacheLoader(const FileSystem &fs) : fs(fs) { }
+
+		/// \brief Reads and decodes the highest priority request. Called on a worker thread.
+		void decode_next();
+
+		/// \brief Reads a whole file. File systems are not thread safe, so every read goes through here.
+		DataBuffer read_file(const std::string &filename);
+
+		typedef std::pair<int, uint64_t> QueueKey; // Negated priority, then request order
+		static QueueKey get_key(const FileDisplayCacheLoad &load) { return QueueKey(-load.priority, load.sequence); }
+
+		std::mutex mutex;
+		std::map<QueueKey, std::shared_ptr<FileDisplayCacheLoad> > decode_queue;
+		std::map<QueueKey, std::shared_ptr<FileDisplayCacheLoad> > upload_queue;
+		std::vector<std::shared_ptr<FileDisplayCacheLoad> > failed_loads; // Reported by the next process_loads
+		int pending_loads = 0;
+
+		std::mutex file_mutex;
+		FileSystem fs;
+	};
+
 	class FileDisplayCache : public DisplayCache
 	{
 	public:
@@ -47,12 +100,38 @@ namespace clan
 		Resource<Texture> get_texture(GraphicContext &gc, const std::string &id) override;
 		Resource<Font> get_font(Canvas &canvas, const std::string &family_name, const FontDescription &desc) override;
 
+		Resource<Sprite> get_sprite_async(Canvas &canvas, const std::string &id, int priority) override;
+		Resource<Image> get_image_async(Canvas &canvas, const std::string &id, int priority) override;
+		Resource<Texture> get_texture_async(GraphicContext &gc, const std::string &id, int priority) override;
+		void prefetch(GraphicContext &gc, const std::vector<std::string> &ids, int priority) override;
+		void set_priority(const std::string &id, int priority) override;
+		void cancel(const std::string &id) override;
+		ResourceLoadState get_load_state(const std::string &id) const override;
+		int get_pending_loads() const override;
+		void process_loads(GraphicContext &gc, int budget_microseconds) override;
+
 	private:
+		std::shared_ptr<FileDisplayCacheLoad> request(const std::string &id, int priority);
+		bool upload_step(GraphicContext &gc, FileDisplayCacheLoad &load);
+		void finish_load(FileDisplayCacheLoad &load);
+		void fail_load(FileDisplayCacheLoad &load);
+		Texture2D find_texture(const std::string &id);
+		Texture2D load_texture(GraphicContext &gc, const std::string &id);
+
 		FileResourceDocument doc;
 
 		std::map<std::string, Resource<Sprite> > sprites;
 		std::map<std::string, Resource<Image> > images;
 		std::map<std::string, Resource<Texture> > textures;
 		std::map<std::string, FontFamily > fonts;
+
+		std::shared_ptr<FileDisplayCacheLoader> loader;
+		std::map<std::string, std::shared_ptr<FileDisplayCacheLoad> > loads;
+		uint64_t next_sequence = 0;
+
+		// Declared last so the worker threads are joined before anything else is destroyed
+		WorkQueue work_queue;
+
+		static const int upload_band_rows = 64;
 	};
 }
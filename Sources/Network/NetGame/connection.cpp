@@ -47,6 +47,12 @@ namespace clan
 		impl->start(this, site, socket_name);
 	}
 
+	NetGameConnection::NetGameConnection(NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor)
+		: impl(new NetGameConnection_Impl)
+	{
+		impl->start(this, site, connection, reactor);
+	}
+
 	NetGameConnection::~NetGameConnection()
 	{
 		delete impl;
@@ -34,10 +34,11 @@
 #include "network_event.h"
 #include "network_data.h"
 #include "connection_impl.h"
+#include "reactor.h"
 
 namespace clan
 {
-	NetGameConnection_Impl::NetGameConnection_Impl()
+	NetGameConnection_Impl::NetGameConnection_Impl() : write_scheduled(false)
 	{
 	}
 
@@ -60,8 +61,33 @@ namespace clan
 		thread = std::thread(&NetGameConnection_Impl::connection_main, this);
 	}
 
+	void NetGameConnection_Impl::start(NetGameConnection *xbase, NetGameConnectionSite *xsite, const TCPConnection &xconnection, NetGameReactor *xreactor)
+	{
+#if defined(__linux__)
+		if (xreactor)
+		{
+			base = xbase;
+			site = xsite;
+			connection = xconnection;
+			socket_name = connection.get_remote_name();
+			is_connected = true;
+			reactor = xreactor;
+			reactor->add(this);
+			return;
+		}
+#endif
+		start(xbase, xsite, xconnection);
+	}
+
 	NetGameConnection_Impl::~NetGameConnection_Impl()
 	{
+#if defined(__linux__)
+		if (reactor)
+		{
+			reactor->remove(this);
+			return;
+		}
+#endif
 		std::unique_lock<std::mutex> mutex_lock(mutex);
 		stop_flag = true;
 		mutex_lock.unlock();
@@ -104,7 +130,7 @@ namespace clan
 		message.event = game_event;
 		send_queue.push_back(message);
 		mutex_lock.unlock();
-		worker_event.notify();
+		notify_worker();
 	}
 
 	void NetGameConnection_Impl::disconnect()
@@ -114,6 +140,18 @@ namespace clan
 		message.type = Message::type_disconnect;
 		send_queue.push_back(message);
 		mutex_lock.unlock();
+		notify_worker();
+	}
+
+	void NetGameConnection_Impl::notify_worker()
+	{
+#if defined(__linux__)
+		if (reactor)
+		{
+			reactor->schedule_write(this);
+			return;
+		}
+#endif
 		worker_event.notify();
 	}
 
@@ -227,7 +265,7 @@ namespace clan
 		while (bytes_consumed != size)
 		{
 			int bytes = 0;
-			NetGameEvent incoming_event = NetGameNetworkData::receive_data(static_cast<const char*>(data)+bytes_consumed, size - bytes_consumed, bytes);
+			NetGameEvent incoming_event = NetGameNetworkData::receive_data(static_cast<const char*>(data)+bytes_consumed, size - bytes_consumed, bytes, receive_names);
 			bytes_consumed += bytes;
 
 			if (bytes == 0)
@@ -254,11 +292,7 @@ namespace clan
 		{
 			if (elem.type == Message::type_message)
 			{
-				DataBuffer packet = NetGameNetworkData::send_data(elem.event);
-
-				int pos = buffer.get_size();
-				buffer.set_size(pos + packet.get_size());
-				memcpy(buffer.get_data() + pos, packet.get_data(), packet.get_size());
+				NetGameNetworkData::send_data(buffer, elem.event, send_names);
 			}
 			else if (elem.type == Message::type_disconnect)
 			{
@@ -29,13 +29,17 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <thread>
 #include "API/Network/Socket/tcp_connection.h"
 #include "API/Network/Socket/socket_name.h"
+#include "network_data.h"
 
 namespace clan
 {
+	class NetGameReactor;
+
 	class NetGameConnection_Impl
 	{
 	public:
@@ -43,6 +47,7 @@ namespace clan
 		~NetGameConnection_Impl();
 		void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection);
 		void start(NetGameConnection *base, NetGameConnectionSite *site, const SocketName &socket_name);
+		void start(NetGameConnection *base, NetGameConnectionSite *site, const TCPConnection &connection, NetGameReactor *reactor);
 		void set_data(const std::string &name, void *data);
 		void *get_data(const std::string &name) const;
 		void send_event(const NetGameEvent &game_event);
@@ -51,6 +56,7 @@ namespace clan
 
 	private:
 		void connection_main();
+		void notify_worker();
 
 		bool read_connection_data(DataBuffer &receive_buffer, int &bytes_received);
 		bool write_connection_data(DataBuffer &send_buffer, int &bytes_sent, bool &send_graceful_close);
@@ -87,5 +93,15 @@ namespace clan
 			void *data;
 		};
 		std::vector<AttachedData> data;
+
+		NetGameEventNames send_names;
+		NetGameEventNames receive_names;
+
+		NetGameReactor *reactor = nullptr;
+		int reactor_thread = 0;
+		uint64_t reactor_id = 0;
+		std::atomic<bool> write_scheduled;
+
+		friend class NetGameReactor;
 	};
 }
@@ -35,7 +35,7 @@
 
 namespace clan
 {
-	NetGameEvent NetGameNetworkData::receive_data(const void *data, int size, int &out_bytes_consumed)
+	NetGameEvent NetGameNetworkData::receive_data(const void *data, int size, int &out_bytes_consumed, NetGameEventNames &names)
 	{
 		if (size >= 2)
 		{
@@ -46,8 +46,7 @@ namespace clan
 			if (size >= 2 + payload_size)
 			{
 				out_bytes_consumed = 2 + payload_size;
-				DataBuffer buffer(static_cast<const char*>(data)+2, payload_size);
-				return decode_event(buffer);
+				return decode_event(static_cast<const unsigned char*>(data) + 2, payload_size, names);
 			}
 		}
 
@@ -55,28 +54,43 @@ namespace clan
 		return NetGameEvent(std::string());
 	}
 
-	DataBuffer NetGameNetworkData::send_data(const NetGameEvent &e)
+	void NetGameNetworkData::send_data(DataBuffer &buffer, const NetGameEvent &e, NetGameEventNames &names)
 	{
-		DataBuffer buffer = encode_event(e);
-		if (buffer.get_size() > packet_limit + 2)
-			throw Exception("Outgoing message too big");
-		return buffer;
+		unsigned int packet_size = get_packet_size(e, names);
+
+		size_t pos = buffer.get_size();
+		if (pos + packet_size > buffer.get_capacity())
+			buffer.set_capacity(std::max(pos + packet_size, buffer.get_capacity() * 2));
+		buffer.set_size(pos + packet_size);
+
+		encode_packet(buffer.get_data<unsigned char>() + pos, packet_size, e, names);
 	}
 
-	NetGameEvent NetGameNetworkData::decode_event(const DataBuffer &data)
+	NetGameEvent NetGameNetworkData::decode_event(const unsigned char *d, unsigned int length, NetGameEventNames &names)
 	{
-		const unsigned char *d = data.get_data<unsigned char>();
-		unsigned int length = data.get_size();
 		if (length < 3)
 			throw Exception("Invalid network data");
 
-		unsigned int name_length = *reinterpret_cast<const unsigned short*>(d);
-		if (length < 2 + name_length + 1)
-			throw Exception("Invalid network data");
-		std::string name = std::string(reinterpret_cast<const char*>(d + 2), name_length);
+		unsigned int pos = 2;
+		unsigned int name_field = *reinterpret_cast<const unsigned short*>(d);
+
+		NetGameEvent e((std::string()));
+		if (name_field & name_id_flag)
+		{
+			int name_id = name_field & ~name_id_flag;
+			if (name_id >= names.size())
+				throw Exception("Invalid network data");
+			e.name = names.get(name_id);
+		}
+		else
+		{
+			if (length < 2 + name_field + 1)
+				throw Exception("Invalid network data");
+			e.name.assign(reinterpret_cast<const char*>(d + 2), name_field);
+			names.add(e.name);
+			pos += name_field;
+		}
 
-		NetGameEvent e(name);
-		unsigned int pos = 2 + name_length;
 		while (true)
 		{
 			if (pos >= length)
@@ -84,7 +98,7 @@ namespace clan
 			unsigned char type = d[pos++];
 			if (type == 0)
 				break;
-			e.add_argument(decode_value(type, d, length, pos));
+			e.arguments.push_back(decode_value(type, d, length, pos));
 		}
 		return e;
 	}
@@ -145,7 +159,7 @@ namespace clan
 				unsigned char type = d[pos++];
 				if (type == 0)
 					break;
-				value.add_member(decode_value(type, d, length, pos));
+				value.value_complex.push_back(decode_value(type, d, length, pos));
 			}
 			return value;
 		}
@@ -182,32 +196,47 @@ namespace clan
 		}
 	}
 
-	DataBuffer NetGameNetworkData::encode_event(const NetGameEvent &e)
+	unsigned int NetGameNetworkData::get_packet_size(const NetGameEvent &e, const NetGameEventNames &names)
 	{
-		unsigned int length = 3 + e.get_name().length();
-		for (unsigned int i = 0; i < e.get_argument_count(); i++)
-			length += get_encoded_length(e.get_argument(i));
+		unsigned int length = 3;
+		if (names.find(e.name) == -1)
+			length += e.name.length();
+		for (const auto &argument : e.arguments)
+			length += get_encoded_length(argument);
 
-		DataBuffer data(length + 2);
-
-		*data.get_data<unsigned short>() = length;
+		if (length > packet_limit)
+			throw Exception("Outgoing message too big");
 
-		unsigned char *d = data.get_data<unsigned char>() + 2;
+		return 2 + length;
+	}
 
-		// Write name (2 + name length)
-		unsigned int name_length = e.get_name().length();
-		*reinterpret_cast<unsigned short*>(d) = name_length;
+	void NetGameNetworkData::encode_packet(unsigned char *d, unsigned int packet_size, const NetGameEvent &e, NetGameEventNames &names)
+	{
+		*reinterpret_cast<unsigned short*>(d) = packet_size - 2;
 		d += 2;
-		memcpy(d, e.get_name().data(), name_length);
-		d += name_length;
 
-		for (unsigned int i = 0; i < e.get_argument_count(); i++)
-			d += encode_value(d, e.get_argument(i));
+		// Write name (2 byte name id, or 2 + name length)
+		int name_id = names.find(e.name);
+		if (name_id != -1)
+		{
+			*reinterpret_cast<unsigned short*>(d) = name_id_flag | name_id;
+			d += 2;
+		}
+		else
+		{
+			unsigned int name_length = e.name.length();
+			*reinterpret_cast<unsigned short*>(d) = name_length;
+			d += 2;
+			memcpy(d, e.name.data(), name_length);
+			d += name_length;
+			names.add(e.name);
+		}
+
+		for (const auto &argument : e.arguments)
+			d += encode_value(d, argument);
 
 		// Write end marker
 		*d = 0;
-
-		return data;
 	}
 
 	unsigned int NetGameNetworkData::encode_value(unsigned char *d, const NetGameEventValue &value)
@@ -234,7 +263,7 @@ namespace clan
 			return 1;
 		case NetGameEventValue::string:
 		{
-			std::string s = value.get_string();
+			const std::string &s = value.value_string;
 			*d = 7;
 			*reinterpret_cast<unsigned short*>(d + 1) = s.length();
 			memcpy(d + 3, s.data(), s.length());
@@ -244,8 +273,8 @@ namespace clan
 		{
 			d[0] = 8;
 			unsigned l = 1;
-			for (unsigned int i = 0; i < value.get_member_count(); i++)
-				l += encode_value(d + l, value.get_member(i));
+			for (const auto &member : value.value_complex)
+				l += encode_value(d + l, member);
 			d[l] = 0;
 			l++;
 			return l;
@@ -260,7 +289,7 @@ namespace clan
 			return 2;
 		case NetGameEventValue::binary:
 		{
-			DataBuffer s = value.get_binary();
+			const DataBuffer &s = value.value_binary;
 			*d = 11;
 			*reinterpret_cast<unsigned short*>(d + 1) = s.get_size();
 			memcpy(d + 3, s.get_data(), s.get_size());
@@ -286,14 +315,14 @@ namespace clan
 		case NetGameEventValue::number:
 			return 5;
 		case NetGameEventValue::string:
-			return 1 + 2 + value.get_string().length();
+			return 1 + 2 + value.value_string.length();
 		case NetGameEventValue::binary:
-			return 1 + 2 + value.get_binary().get_size();
+			return 1 + 2 + value.value_binary.get_size();
 		case NetGameEventValue::complex:
 		{
 			unsigned l = 2;
-			for (unsigned int i = 0; i < value.get_member_count(); i++)
-				l += get_encoded_length(value.get_member(i));
+			for (const auto &member : value.value_complex)
+				l += get_encoded_length(member);
 			return l;
 		}
 		default:
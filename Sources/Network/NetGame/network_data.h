@@ -31,20 +31,68 @@
 #include "API/Network/NetGame/event.h"
 #include "API/Network/Socket/tcp_connection.h"
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace clan
 {
 	class DataBuffer;
 
+	/// \brief Event names interned for one direction of a connection
+	///
+	/// The first time a name is sent it goes over the wire as a string, and both ends append it to their table.
+	/// After that the name is sent as its table index. TCP delivers in order, so the sender and receiver tables stay identical without a separate handshake.
+	class NetGameEventNames
+	{
+	public:
+		/// \brief Returns the id of an interned name, or -1 if it is not interned
+		int find(const std::string &name) const
+		{
+			auto it = ids.find(name);
+			return it != ids.end() ? it->second : -1;
+		}
+
+		/// \brief Interns a name unless it already is or the table is full
+		void add(const std::string &name)
+		{
+			if (names.size() < max_names && ids.find(name) == ids.end())
+			{
+				ids[name] = (int)names.size();
+				names.push_back(name);
+			}
+		}
+
+		const std::string &get(int id) const { return names[id]; }
+		int size() const { return (int)names.size(); }
+
+		enum { max_names = 1024 };
+
+	private:
+		std::unordered_map<std::string, int> ids;
+		std::vector<std::string> names;
+	};
+
 	class NetGameNetworkData
 	{
 	public:
-		static NetGameEvent receive_data(const void *data, int size, int &out_bytes_consumed);
-		static DataBuffer send_data(const NetGameEvent &e);
+		/// \brief Decodes the first packet in data, reading directly from the buffer
+		///
+		/// out_bytes_consumed is 0 if data does not contain a complete packet yet.
+		static NetGameEvent receive_data(const void *data, int size, int &out_bytes_consumed, NetGameEventNames &names);
+
+		/// \brief Appends the packet for an event to the end of buffer
+		///
+		/// The buffer is meant to be reused between writes; its capacity grows geometrically and is kept when the size is reset.
+		static void send_data(DataBuffer &buffer, const NetGameEvent &e, NetGameEventNames &names);
+
+		/// \brief Returns the number of bytes encode_packet will write for an event, including the length header
+		static unsigned int get_packet_size(const NetGameEvent &e, const NetGameEventNames &names);
+
+		/// \brief Encodes an event into d, which must have room for get_packet_size bytes
+		static void encode_packet(unsigned char *d, unsigned int packet_size, const NetGameEvent &e, NetGameEventNames &names);
 
 	private:
-		static NetGameEvent decode_event(const DataBuffer &data);
-		static DataBuffer encode_event(const NetGameEvent &e);
+		static NetGameEvent decode_event(const unsigned char *d, unsigned int length, NetGameEventNames &names);
 
 		static unsigned int get_encoded_length(const NetGameEventValue &value);
 		static unsigned int encode_value(unsigned char *d, const NetGameEventValue &value);
@@ -52,5 +100,6 @@ namespace clan
 		static NetGameEventValue decode_value(unsigned char type, const unsigned char *d, unsigned int length, unsigned int &pos);
 
 		enum { packet_limit = 32000 };
+		enum { name_id_flag = 0x8000 };
 	};
 }
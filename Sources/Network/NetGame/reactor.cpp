@@ -0,0 +1,444 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Network/precomp.h"
+
+#if defined(__linux__)
+
+#include "API/Network/NetGame/connection.h"
+#include "API/Network/NetGame/connection_site.h"
+#include "API/Core/System/databuffer.h"
+#include "Network/Socket/tcp_socket.h"
+#include "network_data.h"
+#include "connection_impl.h"
+#include "reactor.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace clan
+{
+	NetGameReactor::NetGameReactor(int num_io_threads) : next_thread(0), next_id(1), stop_flag(false)
+	{
+		if (num_io_threads <= 0)
+			num_io_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		for (int i = 0; i < num_io_threads; i++)
+		{
+			std::unique_ptr<IOThread> io_thread(new IOThread());
+
+			io_thread->epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+			if (io_thread->epoll_handle == -1)
+				throw Exception("Unable to create epoll handle");
+
+			io_thread->wakeup_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (io_thread->wakeup_handle == -1)
+			{
+				::close(io_thread->epoll_handle);
+				throw Exception("Unable to create eventfd handle");
+			}
+
+			epoll_event event;
+			memset(&event, 0, sizeof(epoll_event));
+			event.events = EPOLLIN;
+			event.data.u64 = wakeup_id;
+			epoll_ctl(io_thread->epoll_handle, EPOLL_CTL_ADD, io_thread->wakeup_handle, &event);
+
+			io_threads.push_back(std::move(io_thread));
+		}
+
+		for (auto &io_thread : io_threads)
+			io_thread->thread = std::thread(&NetGameReactor::thread_main, this, io_thread.get());
+	}
+
+	NetGameReactor::~NetGameReactor()
+	{
+		stop_flag = true;
+		for (auto &io_thread : io_threads)
+		{
+			wake(io_thread.get());
+			if (io_thread->thread.joinable())
+				io_thread->thread.join();
+			::close(io_thread->wakeup_handle);
+			::close(io_thread->epoll_handle);
+		}
+	}
+
+	void NetGameReactor::add(NetGameConnection_Impl *impl)
+	{
+		uint64_t id = next_id++;
+		int thread_index = next_thread++ % io_threads.size();
+		IOThread *io_thread = io_threads[thread_index].get();
+
+		impl->reactor_id = id;
+		impl->reactor_thread = thread_index;
+
+		std::unique_ptr<Connection> connection(new Connection());
+		connection->impl = impl;
+		NetworkEvent *socket_event = &impl->connection;
+		connection->handle = static_cast<TCPSocket*>(socket_event->get_socket_handle())->handle;
+
+		epoll_event event;
+		memset(&event, 0, sizeof(epoll_event));
+		event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.u64 = id;
+
+		std::unique_lock<std::mutex> lock(io_thread->mutex);
+		int handle = connection->handle;
+		io_thread->connections[id] = std::move(connection);
+		if (epoll_ctl(io_thread->epoll_handle, EPOLL_CTL_ADD, handle, &event) == -1)
+		{
+			io_thread->connections.erase(id);
+			throw Exception("Unable to add connection to epoll handle");
+		}
+		lock.unlock();
+
+		// Make sure the connected event gets posted even if the socket stays silent
+		schedule_write(impl);
+	}
+
+	void NetGameReactor::remove(NetGameConnection_Impl *impl)
+	{
+		IOThread *io_thread = io_threads[impl->reactor_thread].get();
+
+		std::unique_lock<std::mutex> lock(io_thread->mutex);
+		auto it = io_thread->connections.find(impl->reactor_id);
+		if (it != io_thread->connections.end())
+		{
+			epoll_ctl(io_thread->epoll_handle, EPOLL_CTL_DEL, it->second->handle, nullptr);
+			io_thread->connections.erase(it);
+		}
+	}
+
+	void NetGameReactor::schedule_write(NetGameConnection_Impl *impl)
+	{
+		if (impl->write_scheduled.exchange(true))
+			return;
+
+		IOThread *io_thread = io_threads[impl->reactor_thread].get();
+
+		std::unique_lock<std::mutex> lock(io_thread->pending_mutex);
+		bool was_empty = io_thread->pending_writes.empty();
+		io_thread->pending_writes.push_back(impl->reactor_id);
+		lock.unlock();
+
+		if (was_empty)
+			wake(io_thread);
+	}
+
+	void NetGameReactor::wake(IOThread *io_thread)
+	{
+		uint64_t value = 1;
+		ssize_t result = ::write(io_thread->wakeup_handle, &value, sizeof(uint64_t));
+		(void)result;
+	}
+
+	void NetGameReactor::thread_main(IOThread *io_thread)
+	{
+		const int max_events = 256;
+		epoll_event events[max_events];
+
+		while (!stop_flag)
+		{
+			int count = epoll_wait(io_thread->epoll_handle, events, max_events, -1);
+			if (count == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+
+			std::unique_lock<std::mutex> lock(io_thread->mutex);
+			for (int i = 0; i < count; i++)
+			{
+				uint64_t id = events[i].data.u64;
+				if (id == wakeup_id)
+				{
+					process_wakeup(io_thread);
+					continue;
+				}
+
+				// The connection may have been removed or closed earlier in this batch
+				auto it = io_thread->connections.find(id);
+				if (it == io_thread->connections.end())
+					continue;
+
+				Connection *connection = it->second.get();
+				announce(io_thread, connection);
+
+				uint32_t flags = events[i].events;
+				bool closed = false;
+				if (flags & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+					closed = read_connection(io_thread, id, connection);
+				if (!closed && (flags & EPOLLOUT))
+					write_connection(io_thread, id, connection);
+			}
+
+			std::vector<PostedEvent> posted_events;
+			posted_events.swap(io_thread->posted_events);
+			lock.unlock();
+
+			// Posting takes the server lock, which may be held while a connection is being removed from us
+			for (auto &posted : posted_events)
+				posted.site->add_network_event(posted.event);
+		}
+	}
+
+	void NetGameReactor::process_wakeup(IOThread *io_thread)
+	{
+		uint64_t value = 0;
+		ssize_t result = ::read(io_thread->wakeup_handle, &value, sizeof(uint64_t));
+		(void)result;
+
+		std::unique_lock<std::mutex> pending_lock(io_thread->pending_mutex);
+		std::vector<uint64_t> pending_writes;
+		pending_writes.swap(io_thread->pending_writes);
+		pending_lock.unlock();
+
+		for (uint64_t id : pending_writes)
+		{
+			auto it = io_thread->connections.find(id);
+			if (it == io_thread->connections.end())
+				continue;
+
+			Connection *connection = it->second.get();
+			connection->impl->write_scheduled = false;
+			announce(io_thread, connection);
+			write_connection(io_thread, id, connection);
+		}
+	}
+
+	void NetGameReactor::announce(IOThread *io_thread, Connection *connection)
+	{
+		if (connection->announce_connected)
+		{
+			connection->announce_connected = false;
+			NetGameConnection_Impl *impl = connection->impl;
+			io_thread->posted_events.push_back(PostedEvent(impl->site, NetGameNetworkEvent(impl->base, NetGameNetworkEvent::client_connected)));
+		}
+	}
+
+	bool NetGameReactor::read_connection(IOThread *io_thread, uint64_t id, Connection *connection)
+	{
+		NetGameRingBuffer &buffer = connection->receive_buffer;
+		while (true)
+		{
+			// A full buffer here means an incomplete packet larger than the current capacity
+			if (buffer.get_free() == 0)
+				buffer.reserve(buffer.get_capacity());
+
+			char *segments[2];
+			int sizes[2];
+			int segment_count = buffer.get_write_segments(segments, sizes);
+
+			iovec iov[2];
+			for (int i = 0; i < segment_count; i++)
+			{
+				iov[i].iov_base = segments[i];
+				iov[i].iov_len = sizes[i];
+			}
+
+			ssize_t bytes = ::readv(connection->handle, iov, segment_count);
+			if (bytes == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					return false;
+
+				close_connection(io_thread, id, connection, "Error reading from server");
+				return true;
+			}
+			else if (bytes == 0)
+			{
+				close_connection(io_thread, id, connection, std::string());
+				return true;
+			}
+
+			buffer.commit(bytes);
+
+			if (dispatch_packets(io_thread, id, connection))
+				return true;
+		}
+	}
+
+	bool NetGameReactor::dispatch_packets(IOThread *io_thread, uint64_t id, Connection *connection)
+	{
+		NetGameRingBuffer &buffer = connection->receive_buffer;
+		NetGameConnection_Impl *impl = connection->impl;
+		try
+		{
+			while (buffer.get_size() >= 2)
+			{
+				unsigned short payload_size = 0;
+				buffer.peek(&payload_size, 2);
+
+				int packet_size = 2 + payload_size;
+				if (buffer.get_size() < packet_size)
+					break;
+
+				const char *packet = buffer.get_contiguous(packet_size);
+				if (packet == nullptr)
+				{
+					io_thread->scratch_buffer.resize(packet_size);
+					buffer.peek(io_thread->scratch_buffer.data(), packet_size);
+					packet = io_thread->scratch_buffer.data();
+				}
+
+				int bytes_consumed = 0;
+				NetGameEvent incoming_event = NetGameNetworkData::receive_data(packet, packet_size, bytes_consumed, impl->receive_names);
+				buffer.consume(packet_size);
+
+				if (incoming_event.get_name() == "_close")
+				{
+					close_connection(io_thread, id, connection, std::string());
+					return true;
+				}
+
+				io_thread->posted_events.push_back(PostedEvent(impl->site, NetGameNetworkEvent(impl->base, incoming_event)));
+			}
+		}
+		catch (const Exception &e)
+		{
+			close_connection(io_thread, id, connection, e.message);
+			return true;
+		}
+		return false;
+	}
+
+	bool NetGameReactor::write_connection(IOThread *io_thread, uint64_t id, Connection *connection)
+	{
+		NetGameConnection_Impl *impl = connection->impl;
+		NetGameRingBuffer &buffer = connection->send_buffer;
+
+		if (!connection->graceful_close)
+		{
+			std::unique_lock<std::mutex> mutex_lock(impl->mutex);
+			std::vector<NetGameConnection_Impl::Message> send_queue;
+			send_queue.swap(impl->send_queue);
+			mutex_lock.unlock();
+
+			try
+			{
+				for (auto &message : send_queue)
+				{
+					if (message.type == NetGameConnection_Impl::Message::type_disconnect)
+					{
+						connection->graceful_close = true;
+						break;
+					}
+
+					// Encode straight into the ring when the packet fits before the wrap point
+					int packet_size = NetGameNetworkData::get_packet_size(message.event, impl->send_names);
+					buffer.reserve(packet_size);
+
+					char *segments[2];
+					int sizes[2];
+					buffer.get_write_segments(segments, sizes);
+					if (sizes[0] >= packet_size)
+					{
+						NetGameNetworkData::encode_packet(reinterpret_cast<unsigned char*>(segments[0]), packet_size, message.event, impl->send_names);
+						buffer.commit(packet_size);
+					}
+					else
+					{
+						io_thread->scratch_buffer.resize(packet_size);
+						NetGameNetworkData::encode_packet(reinterpret_cast<unsigned char*>(io_thread->scratch_buffer.data()), packet_size, message.event, impl->send_names);
+						buffer.write(io_thread->scratch_buffer.data(), packet_size);
+					}
+				}
+			}
+			catch (const Exception &e)
+			{
+				close_connection(io_thread, id, connection, e.message);
+				return true;
+			}
+		}
+
+		while (!buffer.is_empty())
+		{
+			char *segments[2];
+			int sizes[2];
+			int segment_count = buffer.get_read_segments(segments, sizes);
+
+			iovec iov[2];
+			for (int i = 0; i < segment_count; i++)
+			{
+				iov[i].iov_base = segments[i];
+				iov[i].iov_len = sizes[i];
+			}
+
+			msghdr message;
+			memset(&message, 0, sizeof(msghdr));
+			message.msg_iov = iov;
+			message.msg_iovlen = segment_count;
+
+			ssize_t bytes = ::sendmsg(connection->handle, &message, MSG_NOSIGNAL);
+			if (bytes == -1)
+			{
+				if (errno == EINTR)
+					continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					return false; // EPOLLOUT fires once the socket drains
+
+				close_connection(io_thread, id, connection, "Error writing to server");
+				return true;
+			}
+
+			buffer.consume(bytes);
+		}
+
+		if (connection->graceful_close)
+		{
+			close_connection(io_thread, id, connection, std::string());
+			return true;
+		}
+
+		return false;
+	}
+
+	void NetGameReactor::close_connection(IOThread *io_thread, uint64_t id, Connection *connection, const std::string &reason)
+	{
+		NetGameConnection_Impl *impl = connection->impl;
+
+		epoll_ctl(io_thread->epoll_handle, EPOLL_CTL_DEL, connection->handle, nullptr);
+		impl->connection.close();
+
+		if (reason.empty())
+			io_thread->posted_events.push_back(PostedEvent(impl->site, NetGameNetworkEvent(impl->base, NetGameNetworkEvent::client_disconnected)));
+		else
+			io_thread->posted_events.push_back(PostedEvent(impl->site, NetGameNetworkEvent(impl->base, NetGameNetworkEvent::client_disconnected, NetGameEvent(reason))));
+
+		io_thread->connections.erase(id);
+	}
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ring_buffer.h"
+#include "network_event.h"
+
+namespace clan
+{
+	class NetGameConnection_Impl;
+	class NetGameConnectionSite;
+
+	/// \brief Epoll driven I/O loop multiplexing NetGameServer connections on a few threads
+	///
+	/// Each connection is pinned to one I/O thread and registered edge-triggered on that thread's epoll instance.
+	/// Incoming and outgoing bytes go through per-connection ring buffers; send_event wakes the owning thread through an eventfd.
+	class NetGameReactor
+	{
+	public:
+		NetGameReactor(int num_io_threads);
+		~NetGameReactor();
+
+		/// \brief Starts monitoring a connection. The connected event is posted by the I/O thread.
+		void add(NetGameConnection_Impl *connection);
+
+		/// \brief Stops monitoring a connection. No I/O thread touches it after this returns.
+		void remove(NetGameConnection_Impl *connection);
+
+		/// \brief Asks the owning I/O thread to flush the send queue of a connection
+		void schedule_write(NetGameConnection_Impl *connection);
+
+	private:
+		struct Connection
+		{
+			NetGameConnection_Impl *impl = nullptr;
+			int handle = -1;
+			bool announce_connected = true;
+			bool graceful_close = false;
+			NetGameRingBuffer receive_buffer;
+			NetGameRingBuffer send_buffer;
+		};
+
+		struct PostedEvent
+		{
+			PostedEvent(NetGameConnectionSite *site, const NetGameNetworkEvent &event) : site(site), event(event) { }
+
+			NetGameConnectionSite *site;
+			NetGameNetworkEvent event;
+		};
+
+		struct IOThread
+		{
+			int epoll_handle = -1;
+			int wakeup_handle = -1;
+			std::thread thread;
+
+			std::mutex mutex;
+			std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+			std::vector<PostedEvent> posted_events;
+			std::vector<char> scratch_buffer;
+
+			std::mutex pending_mutex;
+			std::vector<uint64_t> pending_writes;
+		};
+
+		void thread_main(IOThread *io_thread);
+		void process_wakeup(IOThread *io_thread);
+		void announce(IOThread *io_thread, Connection *connection);
+		bool read_connection(IOThread *io_thread, uint64_t id, Connection *connection);
+		bool dispatch_packets(IOThread *io_thread, uint64_t id, Connection *connection);
+		bool write_connection(IOThread *io_thread, uint64_t id, Connection *connection);
+		void close_connection(IOThread *io_thread, uint64_t id, Connection *connection, const std::string &reason);
+		void wake(IOThread *io_thread);
+
+		std::vector<std::unique_ptr<IOThread>> io_threads;
+		std::atomic<unsigned int> next_thread;
+		std::atomic<uint64_t> next_id;
+		std::atomic<bool> stop_flag;
+
+		static const uint64_t wakeup_id = 0;
+	};
+}
+
+#endif
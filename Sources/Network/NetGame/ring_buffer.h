@@ -0,0 +1,139 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+namespace clan
+{
+	/// \brief Growable byte ring buffer used by the reactor connections
+	///
+	/// Capacity is always a power of two so positions can be wrapped with a mask.
+	/// Readers and writers get at most two contiguous segments, which map directly to readv/writev.
+	class NetGameRingBuffer
+	{
+	public:
+		NetGameRingBuffer(int initial_capacity = 4096) : buffer(initial_capacity), read_pos(0), length(0)
+		{
+		}
+
+		int get_size() const { return length; }
+		int get_capacity() const { return (int)buffer.size(); }
+		int get_free() const { return get_capacity() - length; }
+		bool is_empty() const { return length == 0; }
+
+		/// \brief Makes sure at least size bytes can be written without wrapping the content
+		void reserve(int size)
+		{
+			int needed = get_size() + size;
+			if (needed <= get_capacity())
+				return;
+
+			int new_capacity = get_capacity();
+			while (new_capacity < needed)
+				new_capacity *= 2;
+
+			std::vector<char> new_buffer(new_capacity);
+			peek(new_buffer.data(), length);
+			buffer.swap(new_buffer);
+			read_pos = 0;
+		}
+
+		/// \brief Returns up to two segments of free space (in write order)
+		int get_write_segments(char **data, int *sizes)
+		{
+			int mask = get_capacity() - 1;
+			int start = (read_pos + length) & mask;
+			int free_bytes = get_free();
+			int first = std::min(free_bytes, get_capacity() - start);
+			data[0] = buffer.data() + start;
+			sizes[0] = first;
+			data[1] = buffer.data();
+			sizes[1] = free_bytes - first;
+			return sizes[1] > 0 ? 2 : (first > 0 ? 1 : 0);
+		}
+
+		/// \brief Returns up to two segments of stored data (in read order)
+		int get_read_segments(char **data, int *sizes)
+		{
+			int first = std::min(length, get_capacity() - read_pos);
+			data[0] = buffer.data() + read_pos;
+			sizes[0] = first;
+			data[1] = buffer.data();
+			sizes[1] = length - first;
+			return sizes[1] > 0 ? 2 : (first > 0 ? 1 : 0);
+		}
+
+		/// \brief Marks size bytes written through get_write_segments as stored
+		void commit(int size) { length += size; }
+
+		/// \brief Discards size bytes from the front
+		void consume(int size)
+		{
+			length -= size;
+			read_pos = length > 0 ? ((read_pos + size) & (get_capacity() - 1)) : 0;
+		}
+
+		void write(const void *data, int size)
+		{
+			reserve(size);
+			char *segments[2];
+			int sizes[2];
+			get_write_segments(segments, sizes);
+			int first = std::min(size, sizes[0]);
+			memcpy(segments[0], data, first);
+			memcpy(segments[1], static_cast<const char*>(data) + first, size - first);
+			commit(size);
+		}
+
+		/// \brief Copies size bytes from the front without consuming them
+		void peek(void *data, int size) const
+		{
+			int first = std::min(size, get_capacity() - read_pos);
+			memcpy(data, buffer.data() + read_pos, first);
+			memcpy(static_cast<char*>(data) + first, buffer.data(), size - first);
+		}
+
+		/// \brief Returns a pointer to size contiguous bytes at the front, or nullptr if they wrap around
+		const char *get_contiguous(int size) const
+		{
+			if (read_pos + size <= get_capacity())
+				return buffer.data() + read_pos;
+			else
+				return nullptr;
+		}
+
+	private:
+		std::vector<char> buffer;
+		int read_pos;
+		int length;
+	};
+}
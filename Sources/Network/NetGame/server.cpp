@@ -37,9 +37,11 @@
 
 namespace clan
 {
-	NetGameServer::NetGameServer()
+	NetGameServer::NetGameServer(NetGameServerMode mode, int num_io_threads)
 		: impl(std::make_shared<NetGameServer_Impl>())
 	{
+		impl->mode = mode;
+		impl->num_io_threads = num_io_threads;
 	}
 
 	NetGameServer::~NetGameServer()
@@ -74,6 +76,10 @@ namespace clan
 		impl->stop_flag = false;
 		lock.unlock();
 		impl->tcp_listen.reset(new TCPListen(SocketName(port)));
+#if defined(__linux__)
+		if (impl->mode == netgame_server_reactor)
+			impl->reactor.reset(new NetGameReactor(impl->num_io_threads));
+#endif
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
@@ -84,6 +90,10 @@ namespace clan
 		impl->stop_flag = false;
 		lock.unlock();
 		impl->tcp_listen.reset(new TCPListen(SocketName(address, port)));
+#if defined(__linux__)
+		if (impl->mode == netgame_server_reactor)
+			impl->reactor.reset(new NetGameReactor(impl->num_io_threads));
+#endif
 		impl->listen_thread = std::thread(&NetGameServer::listen_thread_main, this);
 	}
 
@@ -102,6 +112,10 @@ namespace clan
 			delete elem;
 		}
 		impl->connections.clear();
+
+#if defined(__linux__)
+		impl->reactor.reset();
+#endif
 	}
 
 	void NetGameServer::listen_thread_main()
@@ -119,7 +133,11 @@ namespace clan
 			TCPConnection connection = impl->tcp_listen->accept(peer_endpoint);
 			if (!connection.is_null())
 			{
+#if defined(__linux__)
+				std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, connection, impl->reactor.get()));
+#else
 				std::unique_ptr<NetGameConnection> game_connection(new NetGameConnection(this, connection));
+#endif
 				impl->connections.push_back(game_connection.release());
 			}
 		}
@@ -32,6 +32,7 @@
 #include <memory>
 #include <mutex>
 #include <thread>
+#include "reactor.h"
 
 namespace clan
 {
@@ -40,6 +41,12 @@ namespace clan
 	public:
 		void process();
 
+		NetGameServerMode mode = netgame_server_thread_per_connection;
+		int num_io_threads = 0;
+#if defined(__linux__)
+		std::unique_ptr<NetGameReactor> reactor;
+#endif
+
 		std::unique_ptr<TCPListen> tcp_listen;
 		std::thread listen_thread;
 
@@ -34,6 +34,8 @@
 #ifndef WIN32
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #endif
 
 namespace clan
@@ -137,30 +139,37 @@ namespace clan
 
 	bool NetworkConditionVariable::wait_impl(int count, NetworkEvent **events, int timeout_ms)
 	{
-		int max_fd = impl->notify_handle[0];
+		// poll rather than select: select cannot watch descriptors above FD_SETSIZE
+		pollfd fds_local[8];
+		std::vector<pollfd> fds_heap;
+		pollfd *fds = fds_local;
+		if (count + 1 > 8)
+		{
+			fds_heap.resize(count + 1);
+			fds = fds_heap.data();
+		}
 
-		fd_set rfds, wfds;
-		FD_ZERO(&rfds);
-		FD_ZERO(&wfds);
-		FD_SET(impl->notify_handle[0], &rfds);
+		fds[0].fd = impl->notify_handle[0];
+		fds[0].events = POLLIN;
+		fds[0].revents = 0;
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->begin_wait(rfds, wfds, max_fd);
+			fds[i + 1].revents = 0;
+			events[i]->get_socket_handle()->begin_wait(fds[i + 1]);
 		}
 
-		timeval tv;
-		tv.tv_sec = timeout_ms / 1000;
-		tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-		//FIXME - Should this have: Use "!impl->can_write ? &wfds : 0" ??
-		int result = select(max_fd + 1, &rfds, 0, 0, timeout_ms >= 0 ? &tv : 0);
+		int result = poll(fds, count + 1, timeout_ms >= 0 ? timeout_ms : -1);
 		if (result == -1)
-			throw Exception("select failed");
+		{
+			if (errno != EINTR)
+				throw Exception("poll failed");
+			result = 0;
+		}
 
 		for (int i = 0; i < count; i++)
 		{
-			events[i]->get_socket_handle()->end_wait(rfds, wfds);
+			events[i]->get_socket_handle()->end_wait(fds[i + 1]);
 		}
 
 		impl->reset_notify();
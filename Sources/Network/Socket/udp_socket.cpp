@@ -149,13 +149,13 @@ namespace clan
 			}
 		}
 
-		void begin_wait(fd_set &rfds, fd_set &wfds, int &max_fd) override
+		void begin_wait(pollfd &fd) override
 		{
-			FD_SET(handle, &rfds);
-			max_fd = std::max(max_fd, handle);
+			fd.fd = handle;
+			fd.events = POLLIN;
 		}
 
-		void end_wait(fd_set &rfds, fd_set &wfds) override
+		void end_wait(const pollfd &fd) override
 		{
 		}
 
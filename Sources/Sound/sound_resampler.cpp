@@ -0,0 +1,348 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "Sound/precomp.h"
+#include "sound_resampler.h"
+#include "API/Sound/sound_sse.h"
+#include "API/Core/System/system.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+#ifndef CL_DISABLE_SSE2
+#include <immintrin.h>
+#endif
+
+// The AVX kernel is compiled for the instructions it uses, independent of the flags the library is built with.
+// It is only called after detect_cpu_extension confirmed the CPU supports them.
+#if defined(__GNUC__)
+#define SOUND_AVX_TARGET __attribute__((target("avx")))
+#else
+#define SOUND_AVX_TARGET
+#endif
+
+namespace clan
+{
+	/// \brief Polyphase windowed sinc filter bank
+	class SoundResamplerTable
+	{
+	public:
+		static const int taps = 16;
+		static const int phases = 256;
+
+		SoundResamplerTable(double cutoff);
+		~SoundResamplerTable();
+		SoundResamplerTable(const SoundResamplerTable &) = delete;
+		SoundResamplerTable &operator=(const SoundResamplerTable &) = delete;
+
+		/// \brief Returns the shared table for the given step, creating it if needed
+		static std::shared_ptr<SoundResamplerTable> get(double step);
+
+		/// \brief Filter coefficients for phase 0 to phases (inclusive)
+		float *coefficients;
+
+		/// \brief Difference from one phase to the next, used to interpolate between phases
+		float *deltas;
+
+	private:
+		static double bessel_i0(double x);
+	};
+
+	static_assert(SoundResamplerTable::taps / 2 - 1 <= SoundResampler::max_history, "Filter history does not fit");
+	static_assert(SoundResamplerTable::taps / 2 <= SoundResampler::max_lookahead, "Filter lookahead does not fit");
+
+	SoundResampler::SoundResampler()
+	{
+		use_avx = System::detect_cpu_extension(System::avx);
+	}
+
+	int SoundResampler::process(const float * const *input, int num_channels, int available, double &position, double step, float **output, int output_offset, int num_samples)
+	{
+		if (step == 1.0 && position == std::floor(position))
+		{
+			// Matching rates, nothing to interpolate
+			int count = count_output(0, available, position, step, num_samples);
+			process_copy(input, num_channels, static_cast<int>(position), output, output_offset, count);
+			position += count;
+			return count;
+		}
+		else if (quality == resample_sinc)
+		{
+			if (!table || table_step != step)
+			{
+				table = SoundResamplerTable::get(step);
+				table_step = step;
+			}
+
+			int count = count_output(SoundResamplerTable::taps / 2, available, position, step, num_samples);
+			process_sinc(input, num_channels, position, step, output, output_offset, count);
+			position += count * step;
+			return count;
+		}
+		else
+		{
+			int count = count_output(1, available, position, step, num_samples);
+			process_linear(input, num_channels, position, step, output, output_offset, count);
+			position += count * step;
+			return count;
+		}
+	}
+
+	int SoundResampler::count_output(int lookahead, int available, double position, double step, int num_samples) const
+	{
+		// Output sample i is possible while int(position + i * step) + lookahead < available
+		int max_index = available - 1 - lookahead;
+		double limit = max_index + 1.0 - position;
+		if (limit <= 0.0 || num_samples <= 0)
+			return 0;
+
+		double estimate = std::ceil(limit / step);
+		int count = estimate < num_samples ? static_cast<int>(estimate) : num_samples;
+		while (count > 0 && static_cast<int>(position + (count - 1) * step) > max_index)
+			count--;
+		return count;
+	}
+
+	void SoundResampler::process_copy(const float * const *input, int num_channels, int index, float **output, int output_offset, int count)
+	{
+		for (int chan = 0; chan < num_channels; chan++)
+			SoundSSE::copy_float(const_cast<float*>(input[chan]) + index, count, output[chan] + output_offset);
+	}
+
+	void SoundResampler::process_linear(const float * const *input, int num_channels, double position, double step, float **output, int output_offset, int count)
+	{
+		int i = 0;
+#ifndef CL_DISABLE_SSE2
+		for (; i + 4 <= count; i += 4)
+		{
+			int index[4];
+			float fraction[4];
+			for (int j = 0; j < 4; j++)
+			{
+				double pos = position + (i + j) * step;
+				index[j] = static_cast<int>(pos);
+				fraction[j] = static_cast<float>(pos - index[j]);
+			}
+			__m128 t = _mm_loadu_ps(fraction);
+
+			for (int chan = 0; chan < num_channels; chan++)
+			{
+				const float *in = input[chan];
+				__m128 a = _mm_set_ps(in[index[3]], in[index[2]], in[index[1]], in[index[0]]);
+				__m128 b = _mm_set_ps(in[index[3] + 1], in[index[2] + 1], in[index[1] + 1], in[index[0] + 1]);
+				_mm_storeu_ps(output[chan] + output_offset + i, _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a))));
+			}
+		}
+#endif
+		for (; i < count; i++)
+		{
+			double pos = position + i * step;
+			int index = static_cast<int>(pos);
+			float t = static_cast<float>(pos - index);
+			for (int chan = 0; chan < num_channels; chan++)
+			{
+				const float *in = input[chan];
+				output[chan][output_offset + i] = in[index] + t * (in[index + 1] - in[index]);
+			}
+		}
+	}
+
+#ifndef CL_DISABLE_SSE2
+	SOUND_AVX_TARGET static void process_sinc_avx(const SoundResamplerTable *table, const float * const *input, int num_channels, double position, double step, float **output, int output_offset, int count)
+	{
+		const int taps = SoundResamplerTable::taps;
+		const int phases = SoundResamplerTable::phases;
+		const int first_tap = taps / 2 - 1;
+
+		for (int i = 0; i < count; i++)
+		{
+			double pos = position + i * step;
+			int index = static_cast<int>(pos);
+			float phase_position = static_cast<float>(pos - index) * phases;
+			int phase = std::min(static_cast<int>(phase_position), phases - 1);
+			float t = phase_position - phase;
+
+			const float *coefficients = table->coefficients + phase * taps;
+			const float *deltas = table->deltas + phase * taps;
+			int start = index - first_tap;
+
+			__m256 tv = _mm256_set1_ps(t);
+			__m256 c0 = _mm256_add_ps(_mm256_load_ps(coefficients), _mm256_mul_ps(tv, _mm256_load_ps(deltas)));
+			__m256 c1 = _mm256_add_ps(_mm256_load_ps(coefficients + 8), _mm256_mul_ps(tv, _mm256_load_ps(deltas + 8)));
+			for (int chan = 0; chan < num_channels; chan++)
+			{
+				const float *in = input[chan] + start;
+				__m256 sum = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in), c0), _mm256_mul_ps(_mm256_loadu_ps(in + 8), c1));
+				__m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+				sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+				sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, _MM_SHUFFLE(1, 1, 1, 1)));
+				_mm_store_ss(output[chan] + output_offset + i, sum4);
+			}
+		}
+	}
+#endif
+
+	void SoundResampler::process_sinc(const float * const *input, int num_channels, double position, double step, float **output, int output_offset, int count)
+	{
+#ifndef CL_DISABLE_SSE2
+		if (use_avx)
+		{
+			process_sinc_avx(table.get(), input, num_channels, position, step, output, output_offset, count);
+			return;
+		}
+#endif
+
+		const int taps = SoundResamplerTable::taps;
+		const int phases = SoundResamplerTable::phases;
+		const int first_tap = taps / 2 - 1;
+
+		for (int i = 0; i < count; i++)
+		{
+			double pos = position + i * step;
+			int index = static_cast<int>(pos);
+			float phase_position = static_cast<float>(pos - index) * phases;
+			int phase = std::min(static_cast<int>(phase_position), phases - 1);
+			float t = phase_position - phase;
+
+			const float *coefficients = table->coefficients + phase * taps;
+			const float *deltas = table->deltas + phase * taps;
+			int start = index - first_tap;
+
+#ifndef CL_DISABLE_SSE2
+			// Interpolate the coefficients between the two nearest phases once for all channels
+			__m128 tv = _mm_set1_ps(t);
+			__m128 c0 = _mm_add_ps(_mm_load_ps(coefficients), _mm_mul_ps(tv, _mm_load_ps(deltas)));
+			__m128 c1 = _mm_add_ps(_mm_load_ps(coefficients + 4), _mm_mul_ps(tv, _mm_load_ps(deltas + 4)));
+			__m128 c2 = _mm_add_ps(_mm_load_ps(coefficients + 8), _mm_mul_ps(tv, _mm_load_ps(deltas + 8)));
+			__m128 c3 = _mm_add_ps(_mm_load_ps(coefficients + 12), _mm_mul_ps(tv, _mm_load_ps(deltas + 12)));
+			for (int chan = 0; chan < num_channels; chan++)
+			{
+				const float *in = input[chan] + start;
+				__m128 sum0 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in), c0), _mm_mul_ps(_mm_loadu_ps(in + 4), c1));
+				__m128 sum1 = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(in + 8), c2), _mm_mul_ps(_mm_loadu_ps(in + 12), c3));
+				__m128 sum = _mm_add_ps(sum0, sum1);
+				sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+				sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+				_mm_store_ss(output[chan] + output_offset + i, sum);
+			}
+#else
+			float c[taps];
+			for (int k = 0; k < taps; k++)
+				c[k] = coefficients[k] + t * deltas[k];
+			for (int chan = 0; chan < num_channels; chan++)
+			{
+				const float *in = input[chan] + start;
+				float sum = 0.0f;
+				for (int k = 0; k < taps; k++)
+					sum += in[k] * c[k];
+				output[chan][output_offset + i] = sum;
+			}
+#endif
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////
+
+	SoundResamplerTable::SoundResamplerTable(double cutoff)
+	{
+		// 32 byte alignment allows AVX loads of the rows
+		coefficients = static_cast<float*>(System::aligned_alloc(sizeof(float) * taps * (phases + 1), 32));
+		deltas = static_cast<float*>(System::aligned_alloc(sizeof(float) * taps * phases, 32));
+
+		const double pi = 3.14159265358979323846;
+		const double beta = 6.0;
+		const double half_width = taps / 2;
+		const double window_scale = 1.0 / bessel_i0(beta);
+
+		for (int phase = 0; phase <= phases; phase++)
+		{
+			double fraction = phase / static_cast<double>(phases);
+			float *row = coefficients + phase * taps;
+
+			double values[taps];
+			double total = 0.0;
+			for (int k = 0; k < taps; k++)
+			{
+				// Distance from the output position to the input sample of this tap
+				double distance = (k - (taps / 2 - 1)) - fraction;
+				double x = pi * cutoff * distance;
+				double sinc = (std::abs(x) < 1e-9) ? 1.0 : std::sin(x) / x;
+				double w = distance / half_width;
+				double window = (std::abs(w) >= 1.0) ? 0.0 : bessel_i0(beta * std::sqrt(1.0 - w * w)) * window_scale;
+				values[k] = cutoff * sinc * window;
+				total += values[k];
+			}
+
+			// Normalize for unity gain at DC
+			for (int k = 0; k < taps; k++)
+				row[k] = static_cast<float>(values[k] / total);
+		}
+
+		for (int i = 0; i < taps * phases; i++)
+			deltas[i] = coefficients[i + taps] - coefficients[i];
+	}
+
+	SoundResamplerTable::~SoundResamplerTable()
+	{
+		System::aligned_free(coefficients);
+		System::aligned_free(deltas);
+	}
+
+	std::shared_ptr<SoundResamplerTable> SoundResamplerTable::get(double step)
+	{
+		static std::mutex mutex;
+		static std::map<int, std::shared_ptr<SoundResamplerTable>> tables;
+
+		// Lower the cutoff below the output Nyquist frequency when downsampling. Steps are quantized
+		// so sessions playing at nearby frequencies share a table.
+		double cutoff = 0.9 * std::min(1.0, 1.0 / step);
+		int key = std::max(static_cast<int>(cutoff * 64.0 + 0.5), 1);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		auto &table = tables[key];
+		if (!table)
+			table = std::make_shared<SoundResamplerTable>(key / 64.0);
+		return table;
+	}
+
+	double SoundResamplerTable::bessel_i0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		double half_x = x * 0.5;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (half_x / k) * (half_x / k);
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+}
@@ -0,0 +1,76 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Sound/soundbuffer_session.h"
+#include <memory>
+
+namespace clan
+{
+	class SoundResamplerTable;
+
+	/// \brief Converts sample data from one frequency to another
+	///
+	/// Input is processed in blocks. All channels share the same positions, so per sample setup such as
+	/// interpolating the filter coefficients is only done once for all channels.
+	class SoundResampler
+	{
+	public:
+		SoundResampler();
+
+		/// \brief Samples before the integer part of a position the resampler may read
+		static const int max_history = 7;
+
+		/// \brief Samples after the integer part of a position the resampler may read
+		static const int max_lookahead = 8;
+
+		SoundResampleQuality get_quality() const { return quality; }
+		void set_quality(SoundResampleQuality new_quality) { quality = new_quality; }
+
+		/// \brief Resamples input into output
+		///
+		/// Input channels must be readable from index -max_history. Output is produced for as long as the input
+		/// covers the filter, and position is advanced by step for each output sample.
+		///
+		/// \return Number of samples written to each output channel, starting at output_offset
+		int process(const float * const *input, int num_channels, int available, double &position, double step, float **output, int output_offset, int num_samples);
+
+	private:
+		int count_output(int lookahead, int available, double position, double step, int num_samples) const;
+		void process_copy(const float * const *input, int num_channels, int index, float **output, int output_offset, int count);
+		void process_linear(const float * const *input, int num_channels, double position, double step, float **output, int output_offset, int count);
+		void process_sinc(const float * const *input, int num_channels, double position, double step, float **output, int output_offset, int count);
+
+		SoundResampleQuality quality = resample_linear;
+		bool use_avx = false;
+
+		double table_step = 0.0;
+		std::shared_ptr<SoundResamplerTable> table;
+	};
+}
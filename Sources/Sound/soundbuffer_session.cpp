@@ -220,6 +220,28 @@ namespace clan
 			impl->frequency = new_frequency;
 	}
 
+	SoundResampleQuality SoundBuffer_Session::get_resample_quality() const
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			return impl->resampler.get_quality();
+		}
+		else
+		{
+			return resample_linear;
+		}
+	}
+
+	void SoundBuffer_Session::set_resample_quality(SoundResampleQuality quality)
+	{
+		if (impl)
+		{
+			std::unique_lock<std::recursive_mutex> mutex_lock(impl->mutex);
+			impl->resampler.set_quality(quality);
+		}
+	}
+
 	void SoundBuffer_Session::set_pan(float new_pan)
 	{
 		if (impl)
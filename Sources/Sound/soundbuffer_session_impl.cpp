@@ -35,6 +35,8 @@
 #include "API/Sound/SoundProviders/soundprovider.h"
 #include "API/Sound/SoundProviders/soundprovider_session.h"
 #include "API/Core/Text/logger.h"
+#include <algorithm>
+#include <cstring>
 
 namespace clan
 {
@@ -51,9 +53,14 @@ namespace clan
 		num_buffer_channels = provider_session->get_num_channels();
 		buffer_position = 0.0;
 		buffer_samples_written = 0;
+		end_of_stream_padded = false;
 
 		float_buffer_data = new float*[num_buffer_channels];
-		for (int i = 0; i < num_buffer_channels; i++) float_buffer_data[i] = new float[num_buffer_samples];
+		for (int i = 0; i < num_buffer_channels; i++)
+		{
+			float_buffer_data[i] = new float[SoundResampler::max_history + num_buffer_samples] + SoundResampler::max_history;
+			SoundSSE::set_float(float_buffer_data[i] - SoundResampler::max_history, SoundResampler::max_history, 0.0f);
+		}
 
 		float_buffer_data_offsetted.resize(num_buffer_channels);
 	}
@@ -65,7 +72,7 @@ namespace clan
 			soundbuffer.get_provider()->end_session(provider_session);
 		}
 
-		for (int j = 0; j < num_buffer_channels; ++j) delete[] float_buffer_data[j];
+		for (int j = 0; j < num_buffer_channels; ++j) delete[] (float_buffer_data[j] - SoundResampler::max_history);
 		delete[] float_buffer_data;
 	}
 
@@ -78,19 +85,22 @@ namespace clan
 		return playing;
 	}
 
-	void SoundBuffer_Session_Impl::get_data()
+	int SoundBuffer_Session_Impl::get_data()
 	{
 		int num_session_channels = provider_session->get_num_channels();
 		if (num_session_channels != num_buffer_channels)
 		{
 			log_event("mixer", "Number of session channels does not match the number of buffers");
-			return;
+			return 0;
 		}
 
+		discard_played_samples();
+
+		int samples_added = 0;
 		if (num_session_channels > 0)
 		{
 			// Copy stream data to working buffer:
-			int samples_left = num_buffer_samples;
+			int samples_left = num_buffer_samples - buffer_samples_written;
 			while (samples_left > 0)
 			{
 				for (int i = 0; i < num_session_channels; i++)
@@ -98,6 +108,7 @@ namespace clan
 
 				int written = provider_session->get_data(&float_buffer_data_offsetted[0], samples_left);
 				samples_left -= written;
+				samples_added += written;
 
 				if (samples_left > 0 && provider_session->eof())
 				{
@@ -128,51 +139,71 @@ namespace clan
 
 			buffer_samples_written = num_buffer_samples - samples_left;
 		}
+
+		if (samples_added > 0)
+			end_of_stream_padded = false;
+		return samples_added;
+	}
+
+	void SoundBuffer_Session_Impl::discard_played_samples()
+	{
+		int keep_from = std::min(static_cast<int>(buffer_position), buffer_samples_written);
+		if (keep_from > 0)
+		{
+			int keep = buffer_samples_written - keep_from + SoundResampler::max_history;
+			for (int i = 0; i < num_buffer_channels; i++)
+			{
+				float *start = float_buffer_data[i] - SoundResampler::max_history;
+				memmove(start, start + keep_from, keep * sizeof(float));
+			}
+			buffer_position -= keep_from;
+			buffer_samples_written -= keep_from;
+		}
+	}
+
+	void SoundBuffer_Session_Impl::pad_end_of_stream()
+	{
+		discard_played_samples();
+
+		int padding = std::min(SoundResampler::max_lookahead, num_buffer_samples - buffer_samples_written);
+		for (int i = 0; i < num_buffer_channels; i++)
+			SoundSSE::set_float(float_buffer_data[i] + buffer_samples_written, padding, 0.0f);
+		buffer_samples_written += padding;
+		end_of_stream_padded = true;
 	}
 
 	void SoundBuffer_Session_Impl::get_data_in_mixer_frequency(int num_samples, float **temp_data)
 	{
 		// Convert from session frequency to mixer frequency:
-		// This is done by copying data from the temporary session buffers (buffer_data) to
-		// the temporary mixing buffers (temp_data), and if buffer_data is exhausted, calling
-		// get_data() to fill it with new data from the soundprovider session object.
+		// The resampler converts as much as it can from the temporary session buffers (float_buffer_data) to
+		// the temporary mixing buffers (temp_data). When float_buffer_data is exhausted, get_data() is
+		// called to fill it with new data from the soundprovider session object.
 		double speed = frequency / double(output.get_mixing_frequency());
-		int sample_count;
-		for (sample_count = 0; sample_count < num_samples; sample_count++)
+		int sample_count = 0;
+		while (sample_count < num_samples)
 		{
-			if (buffer_position < buffer_samples_written)
-			{
-				for (int chan = 0; chan < num_buffer_channels; chan++)
-				{
-					temp_data[chan][sample_count] = float_buffer_data[chan][int(buffer_position)];
-				}
-			}
-			else
-			{
-				if (provider_session->eof())
-				{
-					playing = false;
-					break;
-				}
+			sample_count += resampler.process(float_buffer_data, num_buffer_channels, buffer_samples_written, buffer_position, speed, temp_data, sample_count, num_samples - sample_count);
+			if (sample_count == num_samples)
+				break;
 
-				// Out of data, get more from provider:
-				buffer_position -= buffer_samples_written;
-				get_data();
-				sample_count--;
+			// Out of data, get more from provider:
+			if ((looping || !provider_session->eof()) && get_data() > 0)
 				continue;
-			}
 
-			buffer_position += speed;
-		}
+			if (!provider_session->eof())
+				break;
 
-		// Clear the remaining samples (if any)
-		for (; sample_count < num_samples; sample_count++)
-		{
-			for (int chan = 0; chan < num_buffer_channels; chan++)
+			if (end_of_stream_padded)
 			{
-				temp_data[chan][sample_count] = 0.0f;
+				playing = false;
+				break;
 			}
+			pad_end_of_stream();
 		}
+
+		// Clear the remaining samples (if any)
+		for (int chan = 0; chan < num_buffer_channels; chan++)
+			SoundSSE::set_float(temp_data[chan] + sample_count, num_samples - sample_count, 0.0f);
 	}
 
 	void SoundBuffer_Session_Impl::run_filters(float **temp_data, int num_samples)
@@ -32,6 +32,7 @@
 #include "API/Sound/soundformat.h"
 #include "API/Sound/soundoutput.h"
 #include "API/Sound/soundbuffer.h"
+#include "sound_resampler.h"
 #include <memory>
 #include <mutex>
 
@@ -61,6 +62,7 @@ namespace clan
 		bool looping;
 		bool playing;
 		std::vector<SoundFilter> filters;
+		SoundResampler resampler;
 		mutable std::recursive_mutex mutex;
 
 		bool mix_to(float **sample_data, float **temp_data, int num_samples, int num_channels);
@@ -79,9 +81,19 @@ namespace clan
 		void run_filters(float ** temp_data, int num_samples);
 
 		/// \brief Fills temporary buffers with data from provider.
-		void get_data();
+		///
+		/// \return Number of new samples added to the buffers
+		int get_data();
+
+		/// \brief Appends silence after the end of the stream so the resampler can output the last samples
+		void pad_end_of_stream();
+
+		/// \brief Moves the samples still needed by the resampler to the start of the buffers
+		void discard_played_samples();
 
 		/// \brief Temporary channel buffers containing sound data in provider frequency.
+		///
+		/// Each buffer starts with SoundResampler::max_history samples of history before float_buffer_data[i].
 		float **float_buffer_data;
 
 		std::vector<float*> float_buffer_data_offsetted;
@@ -97,5 +109,8 @@ namespace clan
 
 		/// \brief Number of samples currently written to buffer_data.
 		int buffer_samples_written;
+
+		/// \brief True if silence has been appended after the end of the stream
+		bool end_of_stream_padded;
 	};
 }
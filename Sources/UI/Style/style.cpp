@@ -70,6 +70,11 @@ namespace clan
 	{
 	}
 
+	uint64_t Style::generation() const
+	{
+		return impl->generation;
+	}
+
 	void Style::set(const std::string &properties)
 	{
 		StyleProperty::parse(impl.get(), properties);
@@ -28,6 +28,7 @@
 
 #include "UI/precomp.h"
 #include "style_background_renderer.h"
+#include "style_display_list.h"
 #include "API/UI/View/view_geometry.h"
 #include "API/UI/Style/style_cascade.h"
 #include "API/UI/Style/style_get_value.h"
@@ -42,7 +43,7 @@
 
 namespace clan
 {
-	StyleBackgroundRenderer::StyleBackgroundRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style) : canvas(canvas), geometry(geometry), style(style)
+	StyleBackgroundRenderer::StyleBackgroundRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style, StyleDisplayList &display_list) : canvas(canvas), geometry(geometry), style(style), display_list(display_list)
 	{
 	}
 
@@ -73,7 +74,7 @@ namespace clan
 			// To do: take get_layer_clip(num_layers - 1) into account
 
 			Path background_area = get_border_area_path(border_points);
-			background_area.fill(canvas, Brush(bg_color.color()));
+			display_list.fill(background_area, Brush(bg_color.color()), geometry.border_box());
 		}
 
 		for (int index = num_layers - 1; index >= 0; index--)
@@ -157,7 +158,7 @@ namespace clan
 						image_dest.bottom += delta;
 					}
 
-					image.draw(canvas, image_source, image_dest);
+					display_list.draw(image, image_source, image_dest);
 
 					if (repeat_x.is_keyword("no-repeat"))
 					{
@@ -318,7 +319,7 @@ namespace clan
 			brush.stops.push_back(BrushGradientStop(prop_color.color(), position));
 		}
 
-		border_area_path.fill(canvas, brush);
+		display_list.fill(border_area_path, brush, geometry.border_box());
 	}
 
 	void StyleBackgroundRenderer::render_background_radial_gradient(int index)
@@ -351,7 +352,7 @@ namespace clan
 				auto border_points = get_border_points();
 				auto padding_points = get_padding_points(border_points);
 				Path border_path = get_border_stroke_path(border_points, padding_points);
-				border_path.fill(canvas, Brush(color));
+				display_list.fill(border_path, Brush(color), geometry.border_box());
 			}
 		}
 	}
@@ -847,6 +848,9 @@ namespace clan
 
 			if (shadow_blur_radius != 0.0f)
 			{
+				Rectf shadow_box = border_box;
+				shadow_box.expand(shadow_blur_radius, shadow_blur_radius);
+
 				Path top_left;
 				top_left.move_to(Pointf(border_box.left - shadow_blur_radius, border_box.top - shadow_blur_radius));
 				top_left.line_to(Pointf(border_points[0].x, border_points[0].y - shadow_blur_radius));
@@ -931,10 +935,10 @@ namespace clan
 				brush_bottom_left.center_point = Pointf(border_box.left + bottom_left_x, border_box.bottom - bottom_left_y);
 				brush_bottom_left.stops = shadow_blur_stops(shadow_color, shadow_blur_radius, bottom_left_x / brush_bottom_left.radius_x);
 
-				top_left.fill(canvas, brush_top_left);
-				top_right.fill(canvas, brush_top_right);
-				bottom_right.fill(canvas, brush_bottom_right);
-				bottom_left.fill(canvas, brush_bottom_left);
+				display_list.fill(top_left, brush_top_left, shadow_box);
+				display_list.fill(top_right, brush_top_right, shadow_box);
+				display_list.fill(bottom_right, brush_bottom_right, shadow_box);
+				display_list.fill(bottom_left, brush_bottom_left, shadow_box);
 
 				Brush brush_linear;
 				brush_linear.type = BrushType::linear;
@@ -970,19 +974,19 @@ namespace clan
 
 				brush_linear.start_point = border_points[0];
 				brush_linear.end_point = Pointf(border_points[0].x, border_points[0].y - shadow_blur_radius);
-				top.fill(canvas, brush_linear);
+				display_list.fill(top, brush_linear, shadow_box);
 
 				brush_linear.start_point = border_points[2];
 				brush_linear.end_point = Pointf(border_points[2].x + shadow_blur_radius, border_points[2].y);
-				right.fill(canvas, brush_linear);
+				display_list.fill(right, brush_linear, shadow_box);
 
 				brush_linear.start_point = border_points[4];
 				brush_linear.end_point = Pointf(border_points[4].x, border_points[4].y + shadow_blur_radius);
-				bottom.fill(canvas, brush_linear);
+				display_list.fill(bottom, brush_linear, shadow_box);
 
 				brush_linear.start_point = border_points[6];
 				brush_linear.end_point = Pointf(border_points[6].x - shadow_blur_radius, border_points[6].y);
-				left.fill(canvas, brush_linear);
+				display_list.fill(left, brush_linear, shadow_box);
 			}
 		}
 	}
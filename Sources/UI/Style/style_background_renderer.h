@@ -44,11 +44,12 @@ namespace clan
 	class StyleCascade;
 	class StyleGetValue;
 	class ViewGeometry;
+	class StyleDisplayList;
 
 	class StyleBackgroundRenderer
 	{
 	public:
-		StyleBackgroundRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style);
+		StyleBackgroundRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style, StyleDisplayList &display_list);
 		void render_background();
 		void render_border();
 
@@ -94,6 +95,7 @@ namespace clan
 		Canvas &canvas;
 		const ViewGeometry &geometry;
 		const StyleCascade &style;
+		StyleDisplayList &display_list;
 
 		//Rectf initial_containing_box;
 		//bool is_root = false;
@@ -28,6 +28,7 @@
 
 #include "UI/precomp.h"
 #include "style_border_image_renderer.h"
+#include "style_display_list.h"
 #include "API/UI/View/view_geometry.h"
 #include "API/UI/Style/style.h"
 #include "API/UI/Style/style_cascade.h"
@@ -39,7 +40,7 @@
 
 namespace clan
 {
-	StyleBorderImageRenderer::StyleBorderImageRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style) : canvas(canvas), geometry(geometry), style(style)
+	StyleBorderImageRenderer::StyleBorderImageRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style, StyleDisplayList &display_list) : canvas(canvas), geometry(geometry), style(style), display_list(display_list)
 	{
 	}
 
@@ -152,7 +153,7 @@ namespace clan
 				
 				Rectf src_clipped(mix(src.left, src.right, tleft), mix(src.top, src.bottom, ttop), mix(src.left, src.right, tright), mix(src.top, src.bottom, tbottom));
 				
-				image.draw(canvas, src_clipped, dest_clipped);
+				display_list.draw(image, src_clipped, dest_clipped);
 			}
 		}
 	}
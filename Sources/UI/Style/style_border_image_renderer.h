@@ -39,11 +39,12 @@ namespace clan
 	class StyleCascade;
 	class StyleGetValue;
 	class ViewGeometry;
+	class StyleDisplayList;
 
 	class StyleBorderImageRenderer
 	{
 	public:
-		StyleBorderImageRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style);
+		StyleBorderImageRenderer(Canvas &canvas, const ViewGeometry &geometry, const StyleCascade &style, StyleDisplayList &display_list);
 		void render();
 
 	private:
@@ -71,5 +72,6 @@ namespace clan
 		Canvas &canvas;
 		const ViewGeometry &geometry;
 		const StyleCascade &style;
+		StyleDisplayList &display_list;
 	};
 }
@@ -36,6 +36,7 @@
 #include "API/Core/Text/string_help.h"
 #include "style_background_renderer.h"
 #include "style_border_image_renderer.h"
+#include "style_display_list.h"
 #include "style_impl.h"
 
 namespace clan
@@ -171,17 +172,21 @@ namespace clan
 
 	void StyleCascade::render_background(Canvas &canvas, const ViewGeometry &geometry) const
 	{
-		StyleBackgroundRenderer renderer(canvas, geometry, *this);
+		StyleDisplayList display_list;
+		StyleBackgroundRenderer renderer(canvas, geometry, *this, display_list);
 		renderer.render_background();
+		display_list.render(canvas);
 	}
 
 	void StyleCascade::render_border(Canvas &canvas, const ViewGeometry &geometry) const
 	{
-		StyleBackgroundRenderer renderer(canvas, geometry, *this);
+		StyleDisplayList display_list;
+		StyleBackgroundRenderer renderer(canvas, geometry, *this, display_list);
 		renderer.render_border();
 
-		StyleBorderImageRenderer image_renderer(canvas, geometry, *this);
+		StyleBorderImageRenderer image_renderer(canvas, geometry, *this, display_list);
 		image_renderer.render();
+		display_list.render(canvas);
 	}
 
 	Font StyleCascade::font(Canvas &canvas) const
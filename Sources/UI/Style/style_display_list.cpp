@@ -0,0 +1,78 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#include "UI/precomp.h"
+#include "style_display_list.h"
+#include "API/Display/2D/canvas.h"
+
+namespace clan
+{
+	void StyleDisplayList::fill(const Path &path, const Brush &brush, const Rectf &bounds)
+	{
+		Command command;
+		command.path = path;
+		command.brush = brush;
+		commands.push_back(command);
+		add_bounds(bounds);
+	}
+
+	void StyleDisplayList::draw(const Image &image, const Rectf &src, const Rectf &dest)
+	{
+		Command command;
+		command.image = image;
+		command.src = src;
+		command.dest = dest;
+		commands.push_back(command);
+		add_bounds(dest);
+	}
+
+	void StyleDisplayList::render(Canvas &canvas)
+	{
+		for (auto &command : commands)
+		{
+			if (command.image)
+				command.image.draw(canvas, command.src, command.dest);
+			else
+				command.path.fill(canvas, command.brush);
+		}
+	}
+
+	void StyleDisplayList::clear()
+	{
+		commands.clear();
+		ink_bounds = Rectf();
+	}
+
+	void StyleDisplayList::add_bounds(const Rectf &box)
+	{
+		if (commands.size() == 1)
+			ink_bounds = box;
+		else
+			ink_bounds.bounding_rect(box);
+	}
+}
@@ -0,0 +1,74 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/Display/2D/path.h"
+#include "API/Display/2D/brush.h"
+#include "API/Display/2D/image.h"
+#include "API/Core/Math/rect.h"
+#include <vector>
+
+namespace clan
+{
+	class Canvas;
+
+	/// \brief Retained drawing commands produced by the style renderers
+	///
+	/// Coordinates are in the space of the view's parent content box, so the list stays valid
+	/// when only the canvas transform changes.
+	class StyleDisplayList
+	{
+	public:
+		void fill(const Path &path, const Brush &brush, const Rectf &bounds);
+		void draw(const Image &image, const Rectf &src, const Rectf &dest);
+
+		void render(Canvas &canvas);
+		void clear();
+
+		bool empty() const { return commands.empty(); }
+
+		/// \brief Bounding box of everything drawn by the list
+		const Rectf &bounds() const { return ink_bounds; }
+
+	private:
+		void add_bounds(const Rectf &box);
+
+		struct Command
+		{
+			Path path;
+			Brush brush;
+			Image image;
+			Rectf src;
+			Rectf dest;
+		};
+
+		std::vector<Command> commands;
+		Rectf ink_bounds;
+	};
+}
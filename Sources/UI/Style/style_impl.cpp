@@ -30,11 +30,16 @@
 #include "API/UI/Style/style.h"
 #include "API/Core/Text/string_help.h"
 #include "style_impl.h"
+#include <atomic>
 
 namespace clan
 {
 	void StyleImpl::set_value(const std::string &name, const StyleSetValue &value)
 	{
+		// Generations are unique across all styles so a recycled Style can never match an old cache entry
+		static std::atomic<uint64_t> next_generation(0);
+		generation = ++next_generation;
+
 		auto type_it = prop_type.find(name);
 		if (type_it != prop_type.end() && type_it->second != value.type)
 		{
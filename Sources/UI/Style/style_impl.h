@@ -149,5 +149,7 @@ namespace clan
 		std::unordered_map<StyleString, float, StyleString::hash> prop_number;
 		std::unordered_map<StyleString, StyleDimension, StyleString::hash> prop_dimension;
 		std::unordered_map<StyleString, Colorf, StyleString::hash> prop_color;
+
+		uint64_t generation = 0;
 	};
 }
@@ -51,11 +51,15 @@ namespace clan
 	void TextureWindow::set_background_color(const Colorf &background_color)
 	{
 		impl->background_color = background_color;
+		impl->needs_full_render = true;
+		set_needs_render();
 	}
 
 	void TextureWindow::set_clear_background(bool enable)
 	{
 		impl->clear_background_enable = enable;
+		impl->needs_full_render = true;
+		set_needs_render();
 	}
 
 	Canvas TextureWindow::canvas() const
@@ -93,6 +97,7 @@ namespace clan
 		if (rect != impl->canvas_rect)
 		{
 			impl->canvas_rect = rect;
+			impl->needs_full_render = true;
 			set_needs_render();
 		}
 	}
@@ -73,19 +73,33 @@ namespace clan
 	{
 		if (needs_render || always_render)
 		{
-			ClipRectState cliprect_state(&canvas);
-			canvas.set_cliprect(canvas_rect);
+			// Only the damaged regions are rendered again, the canvas keeps the rest from the previous update
+			std::vector<Rectf> regions = window_view->update_damage(canvas, canvas_rect);
+			if (always_render || needs_full_render)
+				regions.assign(1, canvas_rect);
 
-			if (clear_background_enable)
+			needs_render = false;
+			needs_full_render = false;
+
+			for (Rectf region : regions)
 			{
-				canvas.set_blend_state(opaque_blend);
-				canvas.fill_rect(canvas_rect, background_color);
-				canvas.reset_blend_state();
-				//canvas.clear(background_color);	<--- On d3d, this clears the entire canvas - It does not recognise the cliprect
-			}
+				region.clip(canvas_rect);
+				if (region.get_width() <= 0.0f || region.get_height() <= 0.0f)
+					continue;
 
-			needs_render = false;
-			window_view->render(canvas, canvas_rect);
+				ClipRectState cliprect_state(&canvas);
+				canvas.set_cliprect(region);
+
+				if (clear_background_enable)
+				{
+					canvas.set_blend_state(opaque_blend);
+					canvas.fill_rect(region, background_color);
+					canvas.reset_blend_state();
+					//canvas.clear(background_color);	<--- On d3d, this clears the entire canvas - It does not recognise the cliprect
+				}
+
+				window_view->render(canvas, canvas_rect);
+			}
 		}
 	}
 	
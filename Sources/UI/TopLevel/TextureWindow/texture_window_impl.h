@@ -49,6 +49,7 @@ namespace clan
 		Canvas canvas;
 
 		bool needs_render = false;
+		bool needs_full_render = true;
 		Rectf canvas_rect;
 		DisplayWindow display_window;
 		SlotContainer slots;
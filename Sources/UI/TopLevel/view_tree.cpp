@@ -30,32 +30,20 @@
 #include "API/UI/TopLevel/view_tree.h"
 #include "API/UI/Events/event.h"
 #include "API/UI/Events/focus_change_event.h"
+#include "API/Display/2D/canvas.h"
 #include "../View/view_impl.h"
+#include "view_tree_impl.h"
 #include "../View/positioned_layout.h"
 #include <algorithm>
+#include <cmath>
 
 namespace clan
 {
-	class ViewTreeImpl
-	{
-	public:
-		static void dispatch_activation_change(View *view, ActivationChangeType type)
-		{
-			ActivationChangeEvent change(type);
-			View::dispatch_event(view, &change, true);
-			for (const auto &child : view->children())
-			{
-				dispatch_activation_change(child.get(), type);
-			}
-		}
-
-		View *focus_view = nullptr;
-		std::shared_ptr<View> root;
-	};
-
 	ViewTree::ViewTree() : impl(new ViewTreeImpl)
 	{
-		set_root_view(std::make_shared<View>());
+		// Not using set_root_view here as set_needs_render can't be called during construction
+		impl->root = std::make_shared<View>();
+		impl->root->impl->view_tree = this;
 	}
 
 	ViewTree::~ViewTree()
@@ -79,6 +67,10 @@ namespace clan
 		impl->root = view;
 		if (impl->root)
 			impl->root->impl->view_tree = this;
+		impl->damage_all();
+		impl->boxes_changed = true;
+		if (impl->root)
+			impl->root->set_needs_layout();
 	}
 
 	void ViewTree::set_focus_view(View *new_focus_view)
@@ -104,6 +96,18 @@ namespace clan
 	}
 
 	void ViewTree::render(Canvas &canvas, const Rectf &margin_box)
+	{
+		update_damage(canvas, margin_box);
+
+		Rectf region = canvas.get_cliprect();
+		impl->statistics.damage_rects++;
+		impl->statistics.damage_area += region.get_width() * region.get_height();
+
+		View *view = impl->root.get();
+		view->impl->render(view, canvas);
+	}
+
+	std::vector<Rectf> ViewTree::update_damage(Canvas &canvas, const Rectf &margin_box)
 	{
 		View *view = impl->root.get();
 
@@ -113,14 +117,83 @@ namespace clan
 		{
 			view->layout_children(canvas);
 			PositionedLayout::layout_children(canvas, view);
+			impl->statistics.views_laid_out++;
+			impl->boxes_changed = true;
 		}
 		view->impl->needs_layout = false;
 
-		view->impl->render(view, canvas);
+		if (impl->boxes_changed)
+		{
+			impl->boxes_changed = false;
+			view->impl->update_render_box(view, canvas.get_transform(), impl.get(), false);
+		}
+
+		std::vector<Rectf> damage;
+		if (impl->full_damage)
+		{
+			Mat4f transform = canvas.get_transform();
+			Vec4f tl_point = transform * Vec4f(margin_box.left, margin_box.top, 0.0f, 1.0f);
+			Vec4f br_point = transform * Vec4f(margin_box.right, margin_box.bottom, 0.0f, 1.0f);
+			damage.push_back(Rectf(std::min(tl_point.x, br_point.x), std::min(tl_point.y, br_point.y), std::max(tl_point.x, br_point.x), std::max(tl_point.y, br_point.y)));
+		}
+		else
+		{
+			damage.swap(impl->damage);
+		}
+		impl->full_damage = false;
+		impl->damage.clear();
+
+		// Round outwards so anti-aliased edges along the region border are rendered again too
+		for (auto &box : damage)
+			box = Rectf(std::floor(box.left) - 1.0f, std::floor(box.top) - 1.0f, std::ceil(box.right) + 1.0f, std::ceil(box.bottom) + 1.0f);
+
+		return damage;
+	}
+
+	const ViewRenderStatistics &ViewTree::render_statistics() const
+	{
+		return impl->statistics;
+	}
+
+	void ViewTree::reset_render_statistics()
+	{
+		impl->statistics = ViewRenderStatistics();
 	}
 
 	void ViewTree::dispatch_activation_change(ActivationChangeType type)
 	{
 		ViewTreeImpl::dispatch_activation_change(impl->root.get(), type);
 	}
+
+	void ViewTreeImpl::add_damage(const Rectf &box)
+	{
+		if (full_damage || box.get_width() <= 0.0f || box.get_height() <= 0.0f)
+			return;
+
+		Rectf merged = box;
+		bool found_overlap = true;
+		while (found_overlap)
+		{
+			found_overlap = false;
+			for (auto it = damage.begin(); it != damage.end(); ++it)
+			{
+				if (it->is_overlapped(merged))
+				{
+					merged.bounding_rect(*it);
+					damage.erase(it);
+					found_overlap = true;
+					break;
+				}
+			}
+		}
+		damage.push_back(merged);
+
+		if (damage.size() > (size_t)max_damage_rects)
+		{
+			Rectf bounds = damage.front();
+			for (const auto &rect : damage)
+				bounds.bounding_rect(rect);
+			damage.assign(1, bounds);
+		}
+	}
 }
@@ -0,0 +1,74 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#include "API/UI/TopLevel/view_tree.h"
+#include "API/UI/View/view.h"
+#include <vector>
+
+namespace clan
+{
+	class ViewTreeImpl
+	{
+	public:
+		static void dispatch_activation_change(View *view, ActivationChangeType type)
+		{
+			ActivationChangeEvent change(type);
+			View::dispatch_event(view, &change, true);
+			for (const auto &child : view->children())
+			{
+				dispatch_activation_change(child.get(), type);
+			}
+		}
+
+		/// Marks a region of the canvas as needing to be rendered again
+		void add_damage(const Rectf &box);
+
+		/// Marks the entire tree as needing to be rendered again
+		void damage_all()
+		{
+			full_damage = true;
+			damage.clear();
+		}
+
+		View *focus_view = nullptr;
+		std::shared_ptr<View> root;
+
+		std::vector<Rectf> damage;
+		bool full_damage = true;
+
+		// Set when layout or view transforms may have moved views, so their canvas boxes must be recalculated
+		bool boxes_changed = true;
+
+		ViewRenderStatistics statistics;
+
+		// Beyond this many separate regions it is cheaper to render their bounding box in one pass
+		static const int max_damage_rects = 8;
+	};
+}
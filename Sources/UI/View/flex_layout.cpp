@@ -81,7 +81,8 @@ namespace clan
 					Rectf box = Rectf(tl.x, tl.y, br.x, br.y);
 
 					item.view->set_geometry(ViewGeometry::from_content_box(item.view->style_cascade(), box));
-					item.view->layout_children(canvas);
+					if (item.view->needs_layout())
+						item.view->layout_children(canvas);
 				}
 			}
 		}
@@ -96,7 +97,8 @@ namespace clan
 					Rectf box = Rectf(tl.x, tl.y, br.x, br.y);
 
 					item.view->set_geometry(ViewGeometry::from_content_box(item.view->style_cascade(), box));
-					item.view->layout_children(canvas);
+					if (item.view->needs_layout())
+						item.view->layout_children(canvas);
 				}
 			}
 		}
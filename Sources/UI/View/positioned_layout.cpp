@@ -29,14 +29,25 @@
 #include "UI/precomp.h"
 #include "API/Display/2D/canvas.h"
 #include "positioned_layout.h"
+#include "view_impl.h"
+#include "../TopLevel/view_tree_impl.h"
 #include <algorithm>
 
 namespace clan
 {
 	void PositionedLayout::layout_children(Canvas &canvas, View *view)
+	{
+		layout_children(canvas, view, false);
+	}
+
+	void PositionedLayout::layout_children(Canvas &canvas, View *view, bool moved)
 	{
 		for (const std::shared_ptr<View> &child : view->children())
 		{
+			bool laid_out = child->needs_layout();
+			bool child_moved = moved || child->impl->moved;
+			child->impl->moved = false;
+
 			if (child->hidden())
 			{
 				continue;
@@ -45,6 +56,7 @@ namespace clan
 			{
 				// To do: decide how we determine the containing box used for absolute positioning. For now, use the parent padding box.
 				layout_from_containing_box(canvas, child.get(), view->geometry().padding_box().translate(-view->geometry().content_pos()));
+				laid_out = true;
 			}
 			else if (child->style_cascade().computed_value("position").is_keyword("fixed"))
 			{
@@ -63,6 +75,7 @@ namespace clan
 							offset_initial_containing_box.set_top_left(offset_initial_containing_box.get_top_left() - offset);
 							break;
 						}
+						current = parent;
 					}
 				}
 				else
@@ -71,9 +84,21 @@ namespace clan
 				}
 
 				layout_from_containing_box(canvas, child.get(), offset_initial_containing_box);
+				laid_out = true;
 			}
+			else if (!laid_out && !child_moved)
+			{
+				// Neither the size nor the position of the view nor anything below it changed
+				continue;
+			}
+
+			// Below a moved view only fixed positioned descendants need a new geometry
+			layout_children(canvas, child.get(), child_moved);
+			child->impl->needs_layout = false;
 
-			layout_children(canvas, child.get());
+			ViewTree *tree = child->view_tree();
+			if (tree && laid_out)
+				tree->impl->statistics.views_laid_out++;
 		}
 	}
 
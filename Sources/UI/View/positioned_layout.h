@@ -39,6 +39,7 @@ namespace clan
 		static ViewGeometry get_geometry(Canvas &canvas, View *view, const Rectf &containing_box);
 
 	private:
+		static void layout_children(Canvas &canvas, View *view, bool moved);
 		static void layout_from_containing_box(Canvas &canvas, View *view, const Rectf &containing_box);
 		static float resolve_percentage(const StyleGetValue &computed_value, float size);
 	};
@@ -46,6 +46,9 @@
 #include "API/Core/Text/string_help.h"
 #include "view_impl.h"
 #include "view_action_impl.h"
+#include "../TopLevel/view_tree_impl.h"
+#include "../Style/style_background_renderer.h"
+#include "../Style/style_border_image_renderer.h"
 #include "flex_layout.h"
 #include "custom_layout.h"
 #include <algorithm>
@@ -103,6 +106,7 @@ namespace clan
 		{
 			impl->states[name] = ViewImpl::StyleState(false, value);
 			impl->update_style_cascade();
+			set_needs_render();
 		}
 	}
 	void View::set_state_cascade(const std::string &name, bool value)
@@ -112,6 +116,7 @@ namespace clan
 			impl->states[name] = ViewImpl::StyleState(false, value);
 			impl->update_style_cascade();
 			impl->set_state_cascade_children(name, value);
+			set_needs_render();
 		}
 	}
 
@@ -125,6 +130,7 @@ namespace clan
 				impl->states[name] = ViewImpl::StyleState(true, value);
 				impl->update_style_cascade();
 				impl->set_state_cascade_children(name, value);
+				view->set_needs_render();
 			}
 		}
 	}
@@ -164,6 +170,10 @@ namespace clan
 
 			// To do: clear owner_view, focus_view, if it is this view or a child
 
+			ViewTreeImpl *tree = impl->tree_impl(this);
+			if (tree)
+				impl->damage_render_boxes(tree);
+
 			auto it = std::find_if(super->impl->_children.begin(), super->impl->_children.end(), [&](const std::shared_ptr<View> &view) { return view.get() == this; });
 			if (it != super->impl->_children.end())
 				super->impl->_children.erase(it);
@@ -222,9 +232,15 @@ namespace clan
 
 		View *super = parent();
 		if (super)
+		{
 			super->set_needs_layout();
-		else
-			set_needs_render();
+		}
+		else if (impl->view_tree)
+		{
+			// The render boxes are compared after layout to find what moved
+			impl->view_tree->impl->boxes_changed = true;
+			impl->view_tree->set_needs_render();
+		}
 	}
 
 	Canvas View::canvas() const
@@ -240,7 +256,13 @@ namespace clan
 	{
 		ViewTree *tree = view_tree();
 		if (tree)
+		{
+			tree->impl->add_damage(impl->render_box);
+
+			// A new style can change what is drawn outside the border box
+			tree->impl->boxes_changed = true;
 			tree->set_needs_render();
+		}
 	}
 
 	const ViewGeometry &View::geometry() const
@@ -252,8 +274,18 @@ namespace clan
 	{
 		if (impl->_geometry.content_box() != geometry.content_box())
 		{
+			bool resized = impl->_geometry.content_width != geometry.content_width || impl->_geometry.content_height != geometry.content_height;
 			impl->_geometry = geometry;
-			set_needs_layout();
+
+			// The parent assigns the geometry while laying out its children. Children are positioned
+			// relative to the content box, so only a new size requires laying them out again.
+			// Fixed positioned descendants are placed relative to the root and have to follow a move.
+			if (!parent())
+				set_needs_layout();
+			else if (resized)
+				impl->needs_layout = true;
+			else
+				impl->moved = true;
 		}
 	}
 
@@ -279,6 +311,10 @@ namespace clan
 	void View::set_view_transform(const Mat4f &transform)
 	{
 		impl->view_transform = transform;
+
+		ViewTreeImpl *tree = impl->tree_impl(this);
+		if (tree)
+			tree->boxes_changed = true;
 		set_needs_render();
 	}
 
@@ -292,6 +328,10 @@ namespace clan
 		if (impl->content_clipped != clipped)
 		{
 			impl->content_clipped = clipped;
+
+			ViewTreeImpl *tree = impl->tree_impl(this);
+			if (tree)
+				impl->damage_render_boxes(tree);
 			set_needs_render();
 		}
 	}
@@ -352,35 +392,35 @@ namespace clan
 
 	float View::preferred_height(Canvas &canvas, float width)
 	{
-		auto it = impl->layout_cache.preferred_height.find(width);
-		if (it != impl->layout_cache.preferred_height.end())
-			return it->second;
-
-		float height = calculate_preferred_height(canvas, width);
-		impl->layout_cache.preferred_height[width] = height;
-		return height;
+		ViewLayoutCacheEntry &entry = impl->layout_cache.entry(width);
+		if (!entry.preferred_height_calculated)
+		{
+			entry.preferred_height = calculate_preferred_height(canvas, width);
+			entry.preferred_height_calculated = true;
+		}
+		return entry.preferred_height;
 	}
 
 	float View::first_baseline_offset(Canvas &canvas, float width)
 	{
-		auto it = impl->layout_cache.first_baseline_offset.find(width);
-		if (it != impl->layout_cache.first_baseline_offset.end())
-			return it->second;
-
-		float baseline_offset = calculate_first_baseline_offset(canvas, width);
-		impl->layout_cache.first_baseline_offset[width] = baseline_offset;
-		return baseline_offset;
+		ViewLayoutCacheEntry &entry = impl->layout_cache.entry(width);
+		if (!entry.first_baseline_offset_calculated)
+		{
+			entry.first_baseline_offset = calculate_first_baseline_offset(canvas, width);
+			entry.first_baseline_offset_calculated = true;
+		}
+		return entry.first_baseline_offset;
 	}
 
 	float View::last_baseline_offset(Canvas &canvas, float width)
 	{
-		auto it = impl->layout_cache.last_baseline_offset.find(width);
-		if (it != impl->layout_cache.last_baseline_offset.end())
-			return it->second;
-
-		float baseline_offset = calculate_last_baseline_offset(canvas, width);
-		impl->layout_cache.last_baseline_offset[width] = baseline_offset;
-		return baseline_offset;
+		ViewLayoutCacheEntry &entry = impl->layout_cache.entry(width);
+		if (!entry.last_baseline_offset_calculated)
+		{
+			entry.last_baseline_offset = calculate_last_baseline_offset(canvas, width);
+			entry.last_baseline_offset_calculated = true;
+		}
+		return entry.last_baseline_offset;
 	}
 
 	float View::calculate_preferred_width(Canvas &canvas)
@@ -870,14 +910,18 @@ namespace clan
 
 	void View::render_border(Canvas &canvas)
 	{
-		// Renders the border of a view
-		impl->style_cascade.render_border(canvas, impl->_geometry);
+		// Renders the border of a view from the display list validated by ViewImpl::render
+		if (!impl->render_cache.valid)
+			impl->update_render_cache(this, canvas, nullptr);
+		impl->render_cache.border.render(canvas);
 	}
 
 	void View::render_background(Canvas &canvas)
 	{
-		// Renders the background of a view
-		impl->style_cascade.render_background(canvas, impl->_geometry);
+		// Renders the background of a view from the display list validated by ViewImpl::render
+		if (!impl->render_cache.valid)
+			impl->update_render_cache(this, canvas, nullptr);
+		impl->render_cache.background.render(canvas);
 	}
 
 	/////////////////////////////////////////////////////////////////////////
@@ -897,6 +941,12 @@ namespace clan
 
 	void ViewImpl::render(View *self, Canvas &canvas)
 	{
+		ViewTreeImpl *tree = tree_impl(self);
+		if (tree)
+			tree->statistics.views_rendered++;
+
+		update_render_cache(self, canvas, tree);
+
 		// Draw the background.
 		self->render_background(canvas);
 
@@ -962,6 +1012,152 @@ namespace clan
 		}
 	}
 
+	void ViewImpl::update_render_cache(View *self, Canvas &canvas, ViewTreeImpl *tree)
+	{
+		uint64_t signature = style_signature();
+		ViewRenderCache &cache = render_cache;
+		if (cache.valid &&
+			cache.style_signature == signature &&
+			cache.border_box == _geometry.border_box() &&
+			cache.padding_box == _geometry.padding_box() &&
+			cache.content_box == _geometry.content_box())
+		{
+			if (tree)
+				tree->statistics.cache_hits++;
+			return;
+		}
+
+		cache.valid = false;
+		cache.background.clear();
+		cache.border.clear();
+
+		StyleBackgroundRenderer background_renderer(canvas, _geometry, style_cascade, cache.background);
+		background_renderer.render_background();
+
+		StyleBackgroundRenderer border_renderer(canvas, _geometry, style_cascade, cache.border);
+		border_renderer.render_border();
+
+		StyleBorderImageRenderer border_image_renderer(canvas, _geometry, style_cascade, cache.border);
+		border_image_renderer.render();
+
+		cache.valid = true;
+		cache.style_signature = signature;
+		cache.border_box = _geometry.border_box();
+		cache.padding_box = _geometry.padding_box();
+		cache.content_box = _geometry.content_box();
+
+		if (tree)
+			tree->statistics.cache_misses++;
+	}
+
+	uint64_t ViewImpl::style_signature() const
+	{
+		// FNV-1a over every style in the cascade and its ancestors, as inherited values affect the output too
+		const uint64_t prime = 1099511628211ULL;
+		uint64_t signature = 14695981039346656037ULL;
+		for (const StyleCascade *cascade = &style_cascade; cascade; cascade = cascade->parent)
+		{
+			for (const Style *style : cascade->cascade)
+			{
+				signature = (signature ^ (uint64_t)(uintptr_t)style) * prime;
+				signature = (signature ^ style->generation()) * prime;
+			}
+			signature = (signature ^ 0xff) * prime;
+		}
+		return signature;
+	}
+
+	Rectf ViewImpl::ink_box()
+	{
+		// Calculated from the style rather than the display lists, as those are only updated once the view renders
+		uint64_t signature = style_signature();
+		Rectf border_box = _geometry.border_box();
+		if (ink_box_valid && ink_box_signature == signature && ink_box_border_box == border_box)
+			return ink_box_cache;
+
+		Rectf box = border_box;
+
+		int num_shadows = style_cascade.array_size("box-shadow-style");
+		for (int index = 0; index < num_shadows; index++)
+		{
+			std::string suffix = "[" + StringHelp::int_to_text(index) + "]";
+			if (!style_cascade.computed_value("box-shadow-style" + suffix).is_keyword("outset"))
+				continue;
+			if (style_cascade.computed_value("box-shadow-color" + suffix).color().a <= 0.0f)
+				continue;
+
+			float offset_x = style_cascade.computed_value("box-shadow-horizontal-offset" + suffix).number();
+			float offset_y = style_cascade.computed_value("box-shadow-vertical-offset" + suffix).number();
+			float blur_radius = style_cascade.computed_value("box-shadow-blur-radius" + suffix).number();
+			float spread_distance = style_cascade.computed_value("box-shadow-spread_distance" + suffix).number(); // Name used by the box-shadow parser
+
+			Rectf shadow_box = border_box;
+			shadow_box.expand(std::max(blur_radius, 0.0f) + std::max(spread_distance, 0.0f));
+			box.bounding_rect(shadow_box); // StyleBackgroundRenderer does not apply the offset yet
+			box.bounding_rect(shadow_box.translate(offset_x, offset_y));
+		}
+
+		StyleGetValue outset_left = style_cascade.computed_value("border-image-outset-left");
+		StyleGetValue outset_top = style_cascade.computed_value("border-image-outset-top");
+		StyleGetValue outset_right = style_cascade.computed_value("border-image-outset-right");
+		StyleGetValue outset_bottom = style_cascade.computed_value("border-image-outset-bottom");
+		Rectf border_image_area = border_box;
+		border_image_area.expand(
+			std::max(outset_left.number(), 0.0f), std::max(outset_top.number(), 0.0f),
+			std::max(outset_right.number(), 0.0f), std::max(outset_bottom.number(), 0.0f));
+		box.bounding_rect(border_image_area);
+
+		ink_box_valid = true;
+		ink_box_signature = signature;
+		ink_box_border_box = border_box;
+		ink_box_cache = box;
+		return box;
+	}
+
+	void ViewImpl::update_render_box(View *self, const Mat4f &transform, ViewTreeImpl *tree, bool hide)
+	{
+		hide = hide || hidden;
+
+		Rectf box;
+		if (!hide)
+		{
+			// Note: this code isn't correct for rotated transforms, same as the culling in render
+			Rectf ink_box = this->ink_box();
+			Vec4f tl_point = transform * Vec4f(ink_box.left, ink_box.top, 0.0f, 1.0f);
+			Vec4f br_point = transform * Vec4f(ink_box.right, ink_box.bottom, 0.0f, 1.0f);
+			box = Rectf(std::min(tl_point.x, br_point.x), std::min(tl_point.y, br_point.y), std::max(tl_point.x, br_point.x), std::max(tl_point.y, br_point.y));
+		}
+
+		if (box != render_box)
+		{
+			tree->add_damage(render_box);
+			tree->add_damage(box);
+			render_box = box;
+		}
+
+		Pointf translate = _geometry.content_pos();
+		Mat4f child_transform = transform * Mat4f::translate(translate.x, translate.y, 0) * view_transform;
+		for (std::shared_ptr<View> &view : _children)
+		{
+			view->impl->update_render_box(view.get(), child_transform, tree, hide);
+		}
+	}
+
+	void ViewImpl::damage_render_boxes(ViewTreeImpl *tree)
+	{
+		tree->add_damage(render_box);
+		for (std::shared_ptr<View> &view : _children)
+		{
+			view->impl->damage_render_boxes(tree);
+		}
+	}
+
+	ViewTreeImpl *ViewImpl::tree_impl(View *self)
+	{
+		ViewTree *tree = self->view_tree();
+		return tree ? tree->impl.get() : nullptr;
+	}
+
 	void ViewImpl::update_style_cascade() const
 	{
 		std::vector<std::pair<Style *, size_t>> matches;
@@ -35,20 +35,43 @@
 #include "../Animation/animation_group.h"
 #include "view_layout.h"
 #include "flex_layout.h"
+#include "../Style/style_display_list.h"
 #include <map>
+#include <algorithm>
 
 namespace clan
 {
 	class ViewLayout;
+	class ViewTreeImpl;
+
+	/// Sizes calculated for one width constraint
+	class ViewLayoutCacheEntry
+	{
+	public:
+		float width = 0.0f;
+
+		bool preferred_height_calculated = false;
+		float preferred_height = 0.0f;
+
+		bool first_baseline_offset_calculated = false;
+		float first_baseline_offset = 0.0f;
+
+		bool last_baseline_offset_calculated = false;
+		float last_baseline_offset = 0.0f;
+	};
 
 	class ViewLayoutCache
 	{
 	public:
 		bool preferred_width_calculated = false;
 		float preferred_width = 0.0f;
-		std::map<float, float> preferred_height;
-		std::map<float, float> first_baseline_offset;
-		std::map<float, float> last_baseline_offset;
+
+		// A flex item is typically measured at its preferred width and then at its used width,
+		// so a few entries replaced round robin cover the constraints seen in one layout pass
+		enum { max_entries = 4 };
+		ViewLayoutCacheEntry entries[max_entries];
+		int num_entries = 0;
+		int next_entry = 0;
 
 		bool definite_width_calculated = false;
 		bool is_width_definite = false;
@@ -62,9 +85,8 @@ namespace clan
 		{
 			preferred_width_calculated = false;
 			preferred_width = 0.0f;
-			preferred_height.clear();
-			first_baseline_offset.clear();
-			last_baseline_offset.clear();
+			num_entries = 0;
+			next_entry = 0;
 			definite_width_calculated = false;
 			is_width_definite = false;
 			definite_width = 0.0f;
@@ -72,6 +94,36 @@ namespace clan
 			is_height_definite = false;
 			definite_height = 0.0f;
 		}
+
+		ViewLayoutCacheEntry &entry(float width)
+		{
+			for (int i = 0; i < num_entries; i++)
+			{
+				if (entries[i].width == width)
+					return entries[i];
+			}
+
+			ViewLayoutCacheEntry &entry = entries[next_entry];
+			entry = ViewLayoutCacheEntry();
+			entry.width = width;
+			next_entry = (next_entry + 1) % max_entries;
+			num_entries = std::max(num_entries, next_entry == 0 ? (int)max_entries : next_entry);
+			return entry;
+		}
+	};
+
+	/// Background and border drawing retained between frames
+	class ViewRenderCache
+	{
+	public:
+		bool valid = false;
+		uint64_t style_signature = 0;
+		Rectf border_box;
+		Rectf padding_box;
+		Rectf content_box;
+
+		StyleDisplayList background;
+		StyleDisplayList border;
 	};
 
 	class ViewImpl
@@ -80,6 +132,13 @@ namespace clan
 		ViewLayout *active_layout(View *self);
 
 		void render(View *self, Canvas &canvas);
+		void update_render_cache(View *self, Canvas &canvas, ViewTreeImpl *tree);
+		uint64_t style_signature() const;
+
+		Rectf ink_box();
+		void update_render_box(View *self, const Mat4f &transform, ViewTreeImpl *tree, bool hide);
+		void damage_render_boxes(ViewTreeImpl *tree);
+		ViewTreeImpl *tree_impl(View *self);
 		void process_event(View *self, EventUI *e, bool use_capture);
 		void process_action(ViewAction *action, EventUI *e);
 		void update_style_cascade() const;
@@ -125,6 +184,7 @@ namespace clan
 		bool exception_encountered = false;
 
 		bool needs_layout = true;
+		bool moved = false;
 
 		Signal<void(ActivationChangeEvent &)> _sig_activated[2];
 		Signal<void(ActivationChangeEvent &)> _sig_deactivated[2];
@@ -154,6 +214,17 @@ namespace clan
 
 		ViewLayoutCache layout_cache;
 
+		ViewRenderCache render_cache;
+
+		// Canvas space bounding box of the view as of the last time the render boxes were updated
+		Rectf render_box;
+
+		// Border box grown by what the style draws outside it, for the style signature and border box it was calculated for
+		bool ink_box_valid = false;
+		uint64_t ink_box_signature = 0;
+		Rectf ink_box_border_box;
+		Rectf ink_box_cache;
+
 		FlexLayout flex;
 
 	private:
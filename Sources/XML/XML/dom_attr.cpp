@@ -42,9 +42,8 @@ namespace clan
 	DomAttr::DomAttr(DomDocument doc, const DomString &name, const DomString &namespace_uri)
 		: DomNode(doc, ATTRIBUTE_NODE)
 	{
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		impl->get_tree_node()->set_node_name(doc_impl, name);
-		impl->get_tree_node()->set_namespace_uri(doc_impl, namespace_uri);
+		impl->get_tree_node().set_node_name(name);
+		impl->get_tree_node().set_namespace_uri(namespace_uri);
 	}
 
 	DomAttr::DomAttr(const std::shared_ptr<DomNode_Impl> &impl) : DomNode(impl)
@@ -58,7 +57,7 @@ namespace clan
 	DomString DomAttr::get_name() const
 	{
 		if (impl)
-			return impl->get_tree_node()->get_node_name();
+			return impl->get_tree_node().get_node_name();
 		return DomString();
 	}
 
@@ -70,7 +69,7 @@ namespace clan
 	DomString DomAttr::get_value() const
 	{
 		if (impl)
-			return impl->get_tree_node()->get_node_value();
+			return impl->get_tree_node().get_node_value();
 		return DomString();
 	}
 
@@ -78,8 +77,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			impl->get_tree_node()->set_node_value(doc_impl, value);
+			impl->get_tree_node().set_node_value(value);
 		}
 	}
 
@@ -40,8 +40,7 @@ namespace clan
 	DomCDATASection::DomCDATASection(DomDocument &doc, const DomString &data)
 		: DomText(doc, CDATA_SECTION_NODE)
 	{
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		impl->get_tree_node()->set_node_value(doc_impl, data);
+		impl->get_tree_node().set_node_value(data);
 	}
 
 	DomCDATASection::DomCDATASection(const std::shared_ptr<DomNode_Impl> &impl) : DomText(impl)
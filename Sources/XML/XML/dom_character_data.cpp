@@ -68,8 +68,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString value = impl->get_tree_node()->get_node_value();
-			impl->get_tree_node()->node_value += arg;
+			impl->get_tree_node().append_node_value(arg);
 		}
 	}
 
@@ -77,10 +76,10 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString value = impl->get_tree_node()->get_node_value();
+			DomString value = impl->get_tree_node().get_node_value();
 			if (offset > value.length())
 				offset = value.length();
-			impl->get_tree_node()->node_value = value.substr(0, offset) + arg + value.substr(offset);
+			impl->get_tree_node().set_node_value(value.substr(0, offset) + arg + value.substr(offset));
 		}
 	}
 
@@ -88,7 +87,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString value = impl->get_tree_node()->get_node_value();
+			DomString value = impl->get_tree_node().get_node_value();
 			if (offset > value.length())
 				offset = value.length();
 			if (offset + count > value.length())
@@ -104,7 +103,7 @@ namespace clan
 			{
 				value = DomString();
 			}
-			impl->get_tree_node()->node_value = value;
+			impl->get_tree_node().set_node_value(value);
 		}
 	}
 
@@ -40,8 +40,7 @@ namespace clan
 	DomComment::DomComment(DomDocument &doc, const DomString &data)
 		: DomCharacterData(doc, COMMENT_NODE)
 	{
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		impl->get_tree_node()->set_node_value(doc_impl, data);
+		impl->get_tree_node().set_node_value(data);
 	}
 
 	DomComment::DomComment(const std::shared_ptr<DomNode_Impl> &impl) : DomCharacterData(impl)
@@ -36,19 +36,17 @@
 namespace clan
 {
 	DomDocument_Impl::DomDocument_Impl()
+		: unused_value_bytes(0)
 	{
+		strings.push_back(std::string());
+		string_ids[std::string()] = 0;
+
 		node_index = DomDocument_Impl::allocate_tree_node();
-		nodes[node_index]->node_type = DomNode::DOCUMENT_NODE;
+		node_types[node_index] = DomNode::DOCUMENT_NODE;
 	}
 
 	DomDocument_Impl::~DomDocument_Impl()
 	{
-		std::vector<DomNode_Impl *>::size_type pos, size;
-
-		size = nodes.size();
-		for (pos = 0; pos < size; pos++)
-			delete nodes[pos];
-
 		while (!free_dom_nodes.empty())
 		{
 			delete free_dom_nodes.back();
@@ -93,18 +91,120 @@ namespace clan
 		return search_node.find_namespace_uri(qualified_name);
 	}
 
+	unsigned int DomDocument_Impl::intern_string(const DomString &str)
+	{
+		auto it = string_ids.find(str);
+		if (it != string_ids.end())
+			return it->second;
+
+		unsigned int id = (unsigned int)strings.size();
+		strings.push_back(str);
+		string_ids[str] = id;
+		return id;
+	}
+
+	unsigned int DomDocument_Impl::find_string(const DomString &str) const
+	{
+		auto it = string_ids.find(str);
+		return it != string_ids.end() ? it->second : cl_null_node_index;
+	}
+
+	std::string DomDocument_Impl::get_value(unsigned int node_index) const
+	{
+		unsigned int length = value_lengths[node_index];
+		if (length == 0)
+			return std::string();
+		return std::string(value_arena.data() + value_offsets[node_index], length);
+	}
+
+	bool DomDocument_Impl::value_equals(unsigned int node_index, const DomString &str) const
+	{
+		unsigned int length = value_lengths[node_index];
+		return str.length() == length && (length == 0 || memcmp(value_arena.data() + value_offsets[node_index], str.data(), length) == 0);
+	}
+
+	void DomDocument_Impl::set_value(unsigned int node_index, const DomString &str)
+	{
+		unsigned int old_length = value_lengths[node_index];
+		unsigned int new_length = (unsigned int)str.length();
+
+		// Shrinking values are rewritten in place; growing ones move to the end of the arena.
+		if (new_length <= old_length)
+		{
+			if (new_length > 0)
+				memcpy(value_arena.data() + value_offsets[node_index], str.data(), new_length);
+			unused_value_bytes += old_length - new_length;
+		}
+		else
+		{
+			unused_value_bytes += old_length;
+			value_offsets[node_index] = (unsigned int)value_arena.size();
+			value_arena.insert(value_arena.end(), str.begin(), str.end());
+		}
+		value_lengths[node_index] = new_length;
+
+		if (unused_value_bytes > 64 * 1024 && unused_value_bytes > value_arena.size() / 2)
+			compact_values();
+	}
+
+	void DomDocument_Impl::append_value(unsigned int node_index, const DomString &str)
+	{
+		unsigned int old_length = value_lengths[node_index];
+		if (old_length == 0 || value_offsets[node_index] + old_length == value_arena.size())
+		{
+			if (old_length == 0)
+				value_offsets[node_index] = (unsigned int)value_arena.size();
+			value_arena.insert(value_arena.end(), str.begin(), str.end());
+			value_lengths[node_index] = old_length + (unsigned int)str.length();
+		}
+		else
+		{
+			set_value(node_index, get_value(node_index) + str);
+		}
+	}
+
+	void DomDocument_Impl::compact_values()
+	{
+		std::vector<char> new_arena;
+		new_arena.reserve(value_arena.size() - unused_value_bytes);
+
+		unsigned int count = get_node_count();
+		for (unsigned int index = 0; index < count; index++)
+		{
+			unsigned int length = value_lengths[index];
+			if (length > 0)
+			{
+				const char *value = value_arena.data() + value_offsets[index];
+				value_offsets[index] = (unsigned int)new_arena.size();
+				new_arena.insert(new_arena.end(), value, value + length);
+			}
+		}
+
+		value_arena.swap(new_arena);
+		unused_value_bytes = 0;
+	}
+
 	unsigned int DomDocument_Impl::allocate_tree_node()
 	{
 		if (free_nodes.empty())
 		{
-			auto node = new (&node_allocator) DomTreeNode();
-			nodes.push_back(node);
-			return nodes.size() - 1;
+			node_types.push_back(0);
+			node_names.push_back(0);
+			namespace_uris.push_back(0);
+			value_offsets.push_back(0);
+			value_lengths.push_back(0);
+			parents.push_back(cl_null_node_index);
+			first_children.push_back(cl_null_node_index);
+			last_children.push_back(cl_null_node_index);
+			previous_siblings.push_back(cl_null_node_index);
+			next_siblings.push_back(cl_null_node_index);
+			first_attributes.push_back(cl_null_node_index);
+			return get_node_count() - 1;
 		}
 		else
 		{
 			unsigned index = free_nodes.back();
-			nodes[index]->reset();
+			reset_tree_node(index);
 			free_nodes.pop_back();
 			return index;
 		}
@@ -115,6 +215,22 @@ namespace clan
 		free_nodes.push_back(node_index);
 	}
 
+	void DomDocument_Impl::reset_tree_node(unsigned int node_index)
+	{
+		unused_value_bytes += value_lengths[node_index];
+		node_types[node_index] = 0;
+		node_names[node_index] = 0;
+		namespace_uris[node_index] = 0;
+		value_offsets[node_index] = 0;
+		value_lengths[node_index] = 0;
+		parents[node_index] = cl_null_node_index;
+		first_children[node_index] = cl_null_node_index;
+		last_children[node_index] = cl_null_node_index;
+		previous_siblings[node_index] = cl_null_node_index;
+		next_siblings[node_index] = cl_null_node_index;
+		first_attributes[node_index] = cl_null_node_index;
+	}
+
 	DomNode_Impl *DomDocument_Impl::allocate_dom_node()
 	{
 		if (free_dom_nodes.empty())
@@ -144,7 +260,7 @@ namespace clan
 	{
 		if (free_named_node_maps.empty())
 		{
-			auto map = new (&node_allocator) DomNamedNodeMap_Impl();
+			auto map = new DomNamedNodeMap_Impl();
 			map->owner_document = owner_document;
 			return map;
 		}
@@ -29,9 +29,9 @@
 #pragma once
 
 #include "dom_node_generic.h"
-#include "API/Core/System/block_allocator.h"
 #include <vector>
 #include <stack>
+#include <unordered_map>
 
 namespace clan
 {
@@ -49,12 +49,42 @@ namespace clan
 		std::string public_id;
 		std::string system_id;
 		std::string internal_subset;
-		BlockAllocator node_allocator;
-		std::vector<DomTreeNode *> nodes;
 		std::vector<int> free_nodes;
 		std::vector<DomNode_Impl *> free_dom_nodes;
 		std::vector<DomNamedNodeMap_Impl *> free_named_node_maps;
 
+		/// \brief Node storage, one entry per node index in each array.
+		std::vector<unsigned short> node_types;
+		std::vector<unsigned int> node_names;
+		std::vector<unsigned int> namespace_uris;
+		std::vector<unsigned int> value_offsets;
+		std::vector<unsigned int> value_lengths;
+		std::vector<unsigned int> parents;
+		std::vector<unsigned int> first_children;
+		std::vector<unsigned int> last_children;
+		std::vector<unsigned int> previous_siblings;
+		std::vector<unsigned int> next_siblings;
+		std::vector<unsigned int> first_attributes;
+
+		/// \brief Node and namespace names interned once per document. Id 0 is the empty string.
+		std::vector<std::string> strings;
+		std::unordered_map<std::string, unsigned int> string_ids;
+
+		/// \brief Node values packed back to back, addressed by value_offsets and value_lengths.
+		std::vector<char> value_arena;
+		size_t unused_value_bytes;
+
+		unsigned int get_node_count() const { return (unsigned int)node_types.size(); }
+
+		unsigned int intern_string(const DomString &str);
+		unsigned int find_string(const DomString &str) const;
+		const std::string &get_string(unsigned int id) const { return strings[id]; }
+
+		std::string get_value(unsigned int node_index) const;
+		bool value_equals(unsigned int node_index, const DomString &str) const;
+		void set_value(unsigned int node_index, const DomString &str);
+		void append_value(unsigned int node_index, const DomString &str);
+
 		static DomString find_namespace_uri(
 			const DomString &qualified_name,
 			const XMLToken &search_token,
@@ -82,5 +112,9 @@ namespace clan
 			NamedNodeMapDeleter(DomDocument_Impl *doc) : doc(doc) { }
 			void operator()(DomNamedNodeMap_Impl *map) { doc->free_named_node_map(map); }
 		};
+
+	private:
+		void reset_tree_node(unsigned int node_index);
+		void compact_values();
 	};
 }
@@ -49,9 +49,8 @@ namespace clan
 		const DomString &namespace_uri)
 		: DomNode(doc, ELEMENT_NODE)
 	{
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		impl->get_tree_node()->set_node_name(doc_impl, tag_name);
-		impl->get_tree_node()->set_namespace_uri(doc_impl, namespace_uri);
+		impl->get_tree_node().set_node_name(tag_name);
+		impl->get_tree_node().set_namespace_uri(namespace_uri);
 	}
 
 	DomElement::DomElement(const std::shared_ptr<DomNode_Impl> &impl) : DomNode(impl)
@@ -72,16 +71,16 @@ namespace clan
 		if (impl)
 		{
 			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			unsigned int cur_index = tree_node->first_attribute;
-			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+			unsigned int name_id = doc_impl->find_string(name);
+			if (name_id == cl_null_node_index)
+				return false;
+
+			DomTreeNode cur_attribute = impl->get_tree_node().get_first_attribute();
 			while (cur_attribute)
 			{
-				if (cur_attribute->get_node_name() == name)
+				if (cur_attribute.get_node_name_id() == name_id)
 					return true;
-
-				cur_index = cur_attribute->next_sibling;
-				cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+				cur_attribute = cur_attribute.get_next_sibling();
 			}
 			return false;
 		}
@@ -105,16 +104,16 @@ namespace clan
 		if (impl)
 		{
 			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			unsigned int cur_index = tree_node->first_attribute;
-			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+			unsigned int name_id = doc_impl->find_string(name);
+			if (name_id == cl_null_node_index)
+				return DomString();
+
+			DomTreeNode cur_attribute = impl->get_tree_node().get_first_attribute();
 			while (cur_attribute)
 			{
-				if (cur_attribute->get_node_name() == name)
-					return cur_attribute->get_node_value();
-
-				cur_index = cur_attribute->next_sibling;
-				cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+				if (cur_attribute.get_node_name_id() == name_id)
+					return cur_attribute.get_node_value();
+				cur_attribute = cur_attribute.get_next_sibling();
 			}
 			return DomString();
 		}
@@ -126,16 +125,16 @@ namespace clan
 		if (impl)
 		{
 			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			unsigned int cur_index = tree_node->first_attribute;
-			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+			unsigned int name_id = doc_impl->find_string(name);
+			if (name_id == cl_null_node_index)
+				return default_value;
+
+			DomTreeNode cur_attribute = impl->get_tree_node().get_first_attribute();
 			while (cur_attribute)
 			{
-				if (cur_attribute->get_node_name() == name)
-					return cur_attribute->get_node_value();
-
-				cur_index = cur_attribute->next_sibling;
-				cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+				if (cur_attribute.get_node_name_id() == name_id)
+					return cur_attribute.get_node_value();
+				cur_attribute = cur_attribute.get_next_sibling();
 			}
 			return default_value;
 		}
@@ -148,22 +147,19 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			unsigned int cur_index = tree_node->first_attribute;
-			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode cur_attribute = tree_node.get_first_attribute();
 			while (cur_attribute)
 			{
-				std::string lname = cur_attribute->get_node_name();
+				std::string lname = cur_attribute.get_node_name();
 				std::string::size_type lpos = lname.find_first_of(':');
 				if (lpos != std::string::npos)
 					lname = lname.substr(lpos + 1);
 
-				if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
-					return cur_attribute->get_node_value();
+				if (cur_attribute.get_namespace_uri() == namespace_uri && lname == local_name)
+					return cur_attribute.get_node_value();
 
-				cur_index = cur_attribute->next_sibling;
-				cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+				cur_attribute = cur_attribute.get_next_sibling();
 			}
 			return DomString();
 		}
@@ -177,22 +173,19 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			unsigned int cur_index = tree_node->first_attribute;
-			const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode cur_attribute = tree_node.get_first_attribute();
 			while (cur_attribute)
 			{
-				std::string lname = cur_attribute->get_node_name();
+				std::string lname = cur_attribute.get_node_name();
 				std::string::size_type lpos = lname.find_first_of(':');
 				if (lpos != std::string::npos)
 					lname = lname.substr(lpos + 1);
 
-				if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
-					return cur_attribute->get_node_value();
+				if (cur_attribute.get_namespace_uri() == namespace_uri && lname == local_name)
+					return cur_attribute.get_node_value();
 
-				cur_index = cur_attribute->next_sibling;
-				cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+				cur_attribute = cur_attribute.get_next_sibling();
 			}
 			return default_value;
 		}
@@ -59,14 +59,13 @@ namespace clan
 	{
 		if (!impl)
 			return 0;
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		const DomTreeNode *tree_node = impl->get_tree_node();
-		const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		unsigned long length = 0;
 		while (cur_attribute)
 		{
 			length++;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		return length;
 	}
@@ -76,19 +75,19 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		const DomTreeNode *tree_node = impl->get_tree_node();
-		unsigned int cur_index = tree_node->first_attribute;
-		const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		unsigned int cur_index = tree_node.first_attribute();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			if (cur_attribute->get_node_name() == name)
+			if (cur_attribute.get_node_name() == name)
 			{
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 				dom_node->node_index = cur_index;
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		return DomNode();
 	}
@@ -100,24 +99,24 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		const DomTreeNode *tree_node = impl->get_tree_node();
-		unsigned int cur_index = tree_node->first_attribute;
-		const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		unsigned int cur_index = tree_node.first_attribute();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
+			std::string lname = cur_attribute.get_node_name();
 			std::string::size_type lpos = lname.find_first_of(':');
 			if (lpos != std::string::npos)
 				lname = lname.substr(lpos + 1);
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (cur_attribute.get_namespace_uri() == namespace_uri && lname == local_name)
 			{
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 				dom_node->node_index = cur_index;
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		return DomNode();
 	}
@@ -128,48 +127,48 @@ namespace clan
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 		DomString name = node.get_node_name();
-		DomTreeNode *new_tree_node = (DomTreeNode *)node.impl->get_tree_node();
-		DomTreeNode *tree_node = impl->get_tree_node();
+		DomTreeNode new_tree_node = node.impl->get_tree_node();
+		DomTreeNode tree_node = impl->get_tree_node();
 		if (new_tree_node == tree_node)
 			return node;
-		unsigned int cur_index = tree_node->first_attribute;
+		unsigned int cur_index = tree_node.first_attribute();
 		unsigned int last_index = cl_null_node_index;
-		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			if (cur_attribute->get_node_name() == name)
+			if (cur_attribute.get_node_name() == name)
 			{
-				new_tree_node->parent = cur_attribute->parent;
-				new_tree_node->previous_sibling = cur_attribute->previous_sibling;
-				new_tree_node->next_sibling = cur_attribute->next_sibling;
-				if (cur_attribute->previous_sibling == cl_null_node_index)
-					tree_node->first_attribute = node.impl->node_index;
+				new_tree_node.parent() = cur_attribute.parent();
+				new_tree_node.previous_sibling() = cur_attribute.previous_sibling();
+				new_tree_node.next_sibling() = cur_attribute.next_sibling();
+				if (cur_attribute.previous_sibling() == cl_null_node_index)
+					tree_node.first_attribute() = node.impl->node_index;
 				else
-					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = node.impl->node_index;
-				if (cur_attribute->next_sibling != cl_null_node_index)
-					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = node.impl->node_index;
-				cur_attribute->parent = cl_null_node_index;
-				cur_attribute->previous_sibling = cl_null_node_index;
-				cur_attribute->next_sibling = cl_null_node_index;
+					cur_attribute.get_previous_sibling().next_sibling() = node.impl->node_index;
+				if (cur_attribute.next_sibling() != cl_null_node_index)
+					cur_attribute.get_next_sibling().previous_sibling() = node.impl->node_index;
+				cur_attribute.parent() = cl_null_node_index;
+				cur_attribute.previous_sibling() = cl_null_node_index;
+				cur_attribute.next_sibling() = cl_null_node_index;
 				return node;
 			}
 			last_index = cur_index;
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		if (last_index == cl_null_node_index)
 		{
-			tree_node->first_attribute = node.impl->node_index;
-			new_tree_node->parent = impl->node_index;
-			new_tree_node->previous_sibling = cl_null_node_index;
-			new_tree_node->next_sibling = cl_null_node_index;
+			tree_node.first_attribute() = node.impl->node_index;
+			new_tree_node.parent() = impl->node_index;
+			new_tree_node.previous_sibling() = cl_null_node_index;
+			new_tree_node.next_sibling() = cl_null_node_index;
 		}
 		else
 		{
-			new_tree_node->parent = impl->node_index;
-			new_tree_node->previous_sibling = last_index;
-			new_tree_node->next_sibling = cl_null_node_index;
-			doc_impl->nodes[last_index]->next_sibling = node.impl->node_index;
+			new_tree_node.parent() = impl->node_index;
+			new_tree_node.previous_sibling() = last_index;
+			new_tree_node.next_sibling() = cl_null_node_index;
+			doc_impl->next_siblings[last_index] = node.impl->node_index;
 		}
 		return node;
 	}
@@ -181,53 +180,53 @@ namespace clan
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 		DomString namespace_uri = node.get_namespace_uri();
 		DomString local_name = node.get_local_name();
-		DomTreeNode *new_tree_node = (DomTreeNode *)node.impl->get_tree_node();
-		DomTreeNode *tree_node = impl->get_tree_node();
+		DomTreeNode new_tree_node = node.impl->get_tree_node();
+		DomTreeNode tree_node = impl->get_tree_node();
 		if (new_tree_node == tree_node)
 			return node;
-		unsigned int cur_index = tree_node->first_attribute;
+		unsigned int cur_index = tree_node.first_attribute();
 		unsigned int last_index = cl_null_node_index;
-		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
+			std::string lname = cur_attribute.get_node_name();
 			std::string::size_type lpos = lname.find_first_of(':');
 			if (lpos != std::string::npos)
 				lname = lname.substr(lpos + 1);
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (cur_attribute.get_namespace_uri() == namespace_uri && lname == local_name)
 			{
-				new_tree_node->parent = cur_attribute->parent;
-				new_tree_node->previous_sibling = cur_attribute->previous_sibling;
-				new_tree_node->next_sibling = cur_attribute->next_sibling;
-				if (cur_attribute->previous_sibling == cl_null_node_index)
-					tree_node->first_attribute = node.impl->node_index;
+				new_tree_node.parent() = cur_attribute.parent();
+				new_tree_node.previous_sibling() = cur_attribute.previous_sibling();
+				new_tree_node.next_sibling() = cur_attribute.next_sibling();
+				if (cur_attribute.previous_sibling() == cl_null_node_index)
+					tree_node.first_attribute() = node.impl->node_index;
 				else
-					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = node.impl->node_index;
-				if (cur_attribute->next_sibling != cl_null_node_index)
-					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = node.impl->node_index;
-				cur_attribute->parent = cl_null_node_index;
-				cur_attribute->previous_sibling = cl_null_node_index;
-				cur_attribute->next_sibling = cl_null_node_index;
+					cur_attribute.get_previous_sibling().next_sibling() = node.impl->node_index;
+				if (cur_attribute.next_sibling() != cl_null_node_index)
+					cur_attribute.get_next_sibling().previous_sibling() = node.impl->node_index;
+				cur_attribute.parent() = cl_null_node_index;
+				cur_attribute.previous_sibling() = cl_null_node_index;
+				cur_attribute.next_sibling() = cl_null_node_index;
 				return node;
 			}
 			last_index = cur_index;
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		if (last_index == cl_null_node_index)
 		{
-			tree_node->first_attribute = node.impl->node_index;
-			new_tree_node->parent = impl->node_index;
-			new_tree_node->previous_sibling = cl_null_node_index;
-			new_tree_node->next_sibling = cl_null_node_index;
+			tree_node.first_attribute() = node.impl->node_index;
+			new_tree_node.parent() = impl->node_index;
+			new_tree_node.previous_sibling() = cl_null_node_index;
+			new_tree_node.next_sibling() = cl_null_node_index;
 		}
 		else
 		{
-			new_tree_node->parent = impl->node_index;
-			new_tree_node->previous_sibling = last_index;
-			new_tree_node->next_sibling = cl_null_node_index;
-			doc_impl->nodes[last_index]->next_sibling = node.impl->node_index;
+			new_tree_node.parent() = impl->node_index;
+			new_tree_node.previous_sibling() = last_index;
+			new_tree_node.next_sibling() = cl_null_node_index;
+			doc_impl->next_siblings[last_index] = node.impl->node_index;
 		}
 		return node;
 	}
@@ -237,31 +236,29 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		DomTreeNode *tree_node = impl->get_tree_node();
-		unsigned int cur_index = tree_node->first_attribute;
-		unsigned int last_index = cl_null_node_index;
-		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		unsigned int cur_index = tree_node.first_attribute();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			if (cur_attribute->get_node_name() == name)
+			if (cur_attribute.get_node_name() == name)
 			{
-				if (cur_attribute->previous_sibling == cl_null_node_index)
-					tree_node->first_attribute = cur_attribute->next_sibling;
+				if (cur_attribute.previous_sibling() == cl_null_node_index)
+					tree_node.first_attribute() = cur_attribute.next_sibling();
 				else
-					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = cur_attribute->next_sibling;
-				if (cur_attribute->next_sibling != cl_null_node_index)
-					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = cur_attribute->previous_sibling;
-				cur_attribute->parent = cl_null_node_index;
-				cur_attribute->previous_sibling = cl_null_node_index;
-				cur_attribute->next_sibling = cl_null_node_index;
+					cur_attribute.get_previous_sibling().next_sibling() = cur_attribute.next_sibling();
+				if (cur_attribute.next_sibling() != cl_null_node_index)
+					cur_attribute.get_next_sibling().previous_sibling() = cur_attribute.previous_sibling();
+				cur_attribute.parent() = cl_null_node_index;
+				cur_attribute.previous_sibling() = cl_null_node_index;
+				cur_attribute.next_sibling() = cl_null_node_index;
 
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 				dom_node->node_index = cur_index;
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
-			last_index = cur_index;
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 
 		return DomNode();
@@ -274,36 +271,34 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		DomTreeNode *tree_node = impl->get_tree_node();
-		unsigned int cur_index = tree_node->first_attribute;
-		unsigned int last_index = cl_null_node_index;
-		DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		unsigned int cur_index = tree_node.first_attribute();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		while (cur_attribute)
 		{
-			std::string lname = cur_attribute->get_node_name();
+			std::string lname = cur_attribute.get_node_name();
 			std::string::size_type lpos = lname.find_first_of(':');
 			if (lpos != std::string::npos)
 				lname = lname.substr(lpos + 1);
 
-			if (cur_attribute->get_namespace_uri() == namespace_uri && lname == local_name)
+			if (cur_attribute.get_namespace_uri() == namespace_uri && lname == local_name)
 			{
-				if (cur_attribute->previous_sibling == cl_null_node_index)
-					tree_node->first_attribute = cur_attribute->next_sibling;
+				if (cur_attribute.previous_sibling() == cl_null_node_index)
+					tree_node.first_attribute() = cur_attribute.next_sibling();
 				else
-					cur_attribute->get_previous_sibling(doc_impl)->next_sibling = cur_attribute->next_sibling;
-				if (cur_attribute->next_sibling != cl_null_node_index)
-					cur_attribute->get_next_sibling(doc_impl)->previous_sibling = cur_attribute->previous_sibling;
-				cur_attribute->parent = cl_null_node_index;
-				cur_attribute->previous_sibling = cl_null_node_index;
-				cur_attribute->next_sibling = cl_null_node_index;
+					cur_attribute.get_previous_sibling().next_sibling() = cur_attribute.next_sibling();
+				if (cur_attribute.next_sibling() != cl_null_node_index)
+					cur_attribute.get_next_sibling().previous_sibling() = cur_attribute.previous_sibling();
+				cur_attribute.parent() = cl_null_node_index;
+				cur_attribute.previous_sibling() = cl_null_node_index;
+				cur_attribute.next_sibling() = cl_null_node_index;
 
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
 				dom_node->node_index = cur_index;
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
-			last_index = cur_index;
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 
 		return DomNode();
@@ -314,9 +309,9 @@ namespace clan
 		if (!impl)
 			return DomNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		const DomTreeNode *tree_node = impl->get_tree_node();
-		unsigned int cur_index = tree_node->first_attribute;
-		const DomTreeNode *cur_attribute = tree_node->get_first_attribute(doc_impl);
+		DomTreeNode tree_node = impl->get_tree_node();
+		unsigned int cur_index = tree_node.first_attribute();
+		DomTreeNode cur_attribute = tree_node.get_first_attribute();
 		unsigned int pos = 0;
 		while (cur_attribute)
 		{
@@ -327,8 +322,8 @@ namespace clan
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 			pos++;
-			cur_index = cur_attribute->next_sibling;
-			cur_attribute = cur_attribute->get_next_sibling(doc_impl);
+			cur_index = cur_attribute.next_sibling();
+			cur_attribute = cur_attribute.get_next_sibling();
 		}
 		return DomNode();
 	}
@@ -344,19 +339,11 @@ namespace clan
 	{
 	}
 
-	inline DomTreeNode *DomNamedNodeMap_Impl::get_tree_node()
-	{
-		if (node_index == cl_null_node_index)
-			return nullptr;
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)owner_document.lock().get();
-		return doc_impl->nodes[node_index];
-	}
-
-	inline const DomTreeNode *DomNamedNodeMap_Impl::get_tree_node() const
+	inline DomTreeNode DomNamedNodeMap_Impl::get_tree_node() const
 	{
 		if (node_index == cl_null_node_index)
-			return nullptr;
+			return DomTreeNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)owner_document.lock().get();
-		return doc_impl->nodes[node_index];
+		return DomTreeNode(doc_impl, node_index);
 	}
 }
@@ -28,7 +28,6 @@
 
 #pragma once
 
-#include "API/Core/System/block_allocator.h"
 #include "API/XML/dom_node.h"
 #include <vector>
 #include <memory>
@@ -38,7 +37,7 @@ namespace clan
 	class DomNode_Impl;
 	class DomTreeNode;
 
-	class DomNamedNodeMap_Impl : public BlockAllocated
+	class DomNamedNodeMap_Impl
 	{
 	public:
 		DomNamedNodeMap_Impl();
@@ -56,7 +55,6 @@ namespace clan
 		unsigned int node_index;
 		std::weak_ptr<DomNode_Impl> owner_document;
 
-		DomTreeNode *get_tree_node();
-		const DomTreeNode *get_tree_node() const;
+		DomTreeNode get_tree_node() const;
 	};
 }
@@ -72,8 +72,8 @@ namespace clan
 		impl = std::shared_ptr<DomNode_Impl>(doc_impl->allocate_dom_node(), DomDocument_Impl::NodeDeleter(doc_impl));
 
 		impl->node_index = doc_impl->allocate_tree_node();
-		DomTreeNode *tree_node = impl->get_tree_node();
-		tree_node->node_type = node_type;
+		DomTreeNode tree_node = impl->get_tree_node();
+		tree_node.node_type() = node_type;
 	}
 
 	DomNode::~DomNode()
@@ -84,8 +84,8 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			switch (tree_node->node_type)
+			DomTreeNode tree_node = impl->get_tree_node();
+			switch (tree_node.node_type())
 			{
 			case CDATA_SECTION_NODE:
 				return "#cdata-section";
@@ -105,7 +105,7 @@ namespace clan
 			case NOTATION_NODE:
 			case PROCESSING_INSTRUCTION_NODE:
 			default:
-				return tree_node->get_node_name();
+				return tree_node.get_node_name();
 			}
 		}
 		return DomString();
@@ -115,8 +115,8 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			switch (tree_node->node_type)
+			DomTreeNode tree_node = impl->get_tree_node();
+			switch (tree_node.node_type())
 			{
 			case DOCUMENT_NODE:
 			case DOCUMENT_FRAGMENT_NODE:
@@ -131,7 +131,7 @@ namespace clan
 			case ATTRIBUTE_NODE:
 			case PROCESSING_INSTRUCTION_NODE:
 			default:
-				return tree_node->get_node_value();
+				return tree_node.get_node_value();
 			}
 		}
 		return DomString();
@@ -140,7 +140,7 @@ namespace clan
 	DomString DomNode::get_namespace_uri() const
 	{
 		if (impl)
-			return impl->get_tree_node()->get_namespace_uri();
+			return impl->get_tree_node().get_namespace_uri();
 		return DomString();
 	}
 
@@ -148,7 +148,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString node_name = impl->get_tree_node()->get_node_name();
+			DomString node_name = impl->get_tree_node().get_node_name();
 			DomString::size_type pos = node_name.find(':');
 			if (pos != DomString::npos)
 				return node_name.substr(0, pos);
@@ -160,13 +160,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			DomString node_name = impl->get_tree_node()->get_node_name();
+			DomString node_name = impl->get_tree_node().get_node_name();
 			DomString::size_type pos = node_name.find(':');
 			if (pos == DomString::npos)
-				impl->get_tree_node()->set_node_name(doc_impl, prefix + ':' + node_name);
+				impl->get_tree_node().set_node_name(prefix + ':' + node_name);
 			else
-				impl->get_tree_node()->set_node_name(doc_impl, prefix + node_name.substr(pos));
+				impl->get_tree_node().set_node_name(prefix + node_name.substr(pos));
 		}
 	}
 
@@ -174,7 +173,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomString node_name = impl->get_tree_node()->get_node_name();
+			DomString node_name = impl->get_tree_node().get_node_name();
 			DomString::size_type pos = node_name.find(':');
 			if (pos != DomString::npos)
 				return node_name.substr(pos + 1);
@@ -188,15 +187,14 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			impl->get_tree_node()->set_node_value(doc_impl, value);
+			impl->get_tree_node().set_node_value(value);
 		}
 	}
 
 	unsigned short DomNode::get_node_type() const
 	{
 		if (impl)
-			return impl->get_tree_node()->node_type;
+			return impl->get_tree_node().node_type();
 		return NULL_NODE;
 	}
 
@@ -204,12 +202,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			if (tree_node->parent != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			if (tree_node.parent() != cl_null_node_index)
 			{
 				DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
-				dom_node->node_index = tree_node->parent;
+				dom_node->node_index = tree_node.parent();
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 		}
@@ -232,12 +230,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			if (tree_node->first_child != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			if (tree_node.first_child() != cl_null_node_index)
 			{
 				DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
-				dom_node->node_index = tree_node->first_child;
+				dom_node->node_index = tree_node.first_child();
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 		}
@@ -248,12 +246,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			if (tree_node->last_child != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			if (tree_node.last_child() != cl_null_node_index)
 			{
 				DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
-				dom_node->node_index = tree_node->last_child;
+				dom_node->node_index = tree_node.last_child();
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 		}
@@ -264,12 +262,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			if (tree_node->previous_sibling != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			if (tree_node.previous_sibling() != cl_null_node_index)
 			{
 				DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
-				dom_node->node_index = tree_node->previous_sibling;
+				dom_node->node_index = tree_node.previous_sibling();
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 		}
@@ -280,12 +278,12 @@ namespace clan
 	{
 		if (impl)
 		{
-			const DomTreeNode *tree_node = impl->get_tree_node();
-			if (tree_node->next_sibling != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			if (tree_node.next_sibling() != cl_null_node_index)
 			{
 				DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 				DomNode_Impl *dom_node = doc_impl->allocate_dom_node();
-				dom_node->node_index = tree_node->next_sibling;
+				dom_node->node_index = tree_node.next_sibling();
 				return DomNode(std::shared_ptr<DomNode_Impl>(dom_node, DomDocument_Impl::NodeDeleter(doc_impl)));
 			}
 		}
@@ -294,7 +292,7 @@ namespace clan
 
 	DomNamedNodeMap DomNode::get_attributes() const
 	{
-		if (impl && impl->get_tree_node()->node_type == ELEMENT_NODE)
+		if (impl && impl->get_tree_node().node_type() == ELEMENT_NODE)
 		{
 			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
 			DomNamedNodeMap_Impl *map = doc_impl->allocate_named_node_map();
@@ -392,13 +390,13 @@ namespace clan
 	{
 		if (!impl)
 			return false;
-		return (impl->get_tree_node()->first_attribute != cl_null_node_index);
+		return (impl->get_tree_node().first_attribute() != cl_null_node_index);
 	}
 
 	bool DomNode::has_child_nodes() const
 	{
 		if (impl)
-			return (impl->get_tree_node()->first_child != cl_null_node_index);
+			return (impl->get_tree_node().first_child() != cl_null_node_index);
 		return false;
 	}
 
@@ -435,19 +433,18 @@ namespace clan
 
 		if (impl && new_child.impl && ref_child.impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			DomTreeNode *tree_node = impl->get_tree_node();
-			DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
-			DomTreeNode *ref_tree_node = ref_child.impl->get_tree_node();
-
-			new_tree_node->previous_sibling = ref_tree_node->previous_sibling;
-			new_tree_node->next_sibling = ref_child.impl->node_index;
-			ref_tree_node->previous_sibling = new_child.impl->node_index;
-			if (new_tree_node->previous_sibling != cl_null_node_index)
-				new_tree_node->get_previous_sibling(doc_impl)->next_sibling = new_child.impl->node_index;
-			if (tree_node->first_child == ref_child.impl->node_index)
-				tree_node->first_child = new_child.impl->node_index;
-			new_tree_node->parent = impl->node_index;
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode new_tree_node = new_child.impl->get_tree_node();
+			DomTreeNode ref_tree_node = ref_child.impl->get_tree_node();
+
+			new_tree_node.previous_sibling() = ref_tree_node.previous_sibling();
+			new_tree_node.next_sibling() = ref_child.impl->node_index;
+			ref_tree_node.previous_sibling() = new_child.impl->node_index;
+			if (new_tree_node.previous_sibling() != cl_null_node_index)
+				new_tree_node.get_previous_sibling().next_sibling() = new_child.impl->node_index;
+			if (tree_node.first_child() == ref_child.impl->node_index)
+				tree_node.first_child() = new_child.impl->node_index;
+			new_tree_node.parent() = impl->node_index;
 
 			return new_child;
 		}
@@ -458,20 +455,20 @@ namespace clan
 	{
 		if (impl && new_child.impl && old_child.impl)
 		{
-			DomTreeNode *tree_node = impl->get_tree_node();
-			DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
-			DomTreeNode *old_tree_node = old_child.impl->get_tree_node();
-
-			new_tree_node->previous_sibling = old_tree_node->previous_sibling;
-			new_tree_node->next_sibling = old_tree_node->next_sibling;
-			new_tree_node->parent = impl->node_index;
-			if (tree_node->first_child == old_child.impl->node_index)
-				tree_node->first_child = new_child.impl->node_index;
-			if (tree_node->last_child == old_child.impl->node_index)
-				tree_node->last_child = new_child.impl->node_index;
-			old_tree_node->previous_sibling = cl_null_node_index;
-			old_tree_node->next_sibling = cl_null_node_index;
-			old_tree_node->parent = cl_null_node_index;
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode new_tree_node = new_child.impl->get_tree_node();
+			DomTreeNode old_tree_node = old_child.impl->get_tree_node();
+
+			new_tree_node.previous_sibling() = old_tree_node.previous_sibling();
+			new_tree_node.next_sibling() = old_tree_node.next_sibling();
+			new_tree_node.parent() = impl->node_index;
+			if (tree_node.first_child() == old_child.impl->node_index)
+				tree_node.first_child() = new_child.impl->node_index;
+			if (tree_node.last_child() == old_child.impl->node_index)
+				tree_node.last_child() = new_child.impl->node_index;
+			old_tree_node.previous_sibling() = cl_null_node_index;
+			old_tree_node.next_sibling() = cl_null_node_index;
+			old_tree_node.parent() = cl_null_node_index;
 
 			return new_child;
 		}
@@ -482,24 +479,23 @@ namespace clan
 	{
 		if (impl && old_child.impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			DomTreeNode *tree_node = impl->get_tree_node();
-			DomTreeNode *old_tree_node = old_child.impl->get_tree_node();
-			unsigned int prev_index = old_tree_node->previous_sibling;
-			unsigned int next_index = old_tree_node->next_sibling;
-			DomTreeNode *prev = old_tree_node->get_previous_sibling(doc_impl);
-			DomTreeNode *next = old_tree_node->get_next_sibling(doc_impl);
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode old_tree_node = old_child.impl->get_tree_node();
+			unsigned int prev_index = old_tree_node.previous_sibling();
+			unsigned int next_index = old_tree_node.next_sibling();
+			DomTreeNode prev = old_tree_node.get_previous_sibling();
+			DomTreeNode next = old_tree_node.get_next_sibling();
 			if (next)
-				next->previous_sibling = prev_index;
+				next.previous_sibling() = prev_index;
 			if (prev)
-				prev->next_sibling = next_index;
-			if (tree_node->first_child == old_child.impl->node_index)
-				tree_node->first_child = next_index;
-			if (tree_node->last_child == old_child.impl->node_index)
-				tree_node->last_child = prev_index;
-			old_tree_node->previous_sibling = cl_null_node_index;
-			old_tree_node->next_sibling = cl_null_node_index;
-			old_tree_node->parent = cl_null_node_index;
+				prev.next_sibling() = next_index;
+			if (tree_node.first_child() == old_child.impl->node_index)
+				tree_node.first_child() = next_index;
+			if (tree_node.last_child() == old_child.impl->node_index)
+				tree_node.last_child() = prev_index;
+			old_tree_node.previous_sibling() = cl_null_node_index;
+			old_tree_node.next_sibling() = cl_null_node_index;
+			old_tree_node.parent() = cl_null_node_index;
 		}
 		return DomNode();
 	}
@@ -508,22 +504,21 @@ namespace clan
 	{
 		if (impl && new_child.impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			DomTreeNode *tree_node = impl->get_tree_node();
-			DomTreeNode *new_tree_node = new_child.impl->get_tree_node();
-			if (tree_node->last_child != cl_null_node_index)
+			DomTreeNode tree_node = impl->get_tree_node();
+			DomTreeNode new_tree_node = new_child.impl->get_tree_node();
+			if (tree_node.last_child() != cl_null_node_index)
 			{
-				DomTreeNode *last_tree_node = tree_node->get_last_child(doc_impl);
-				last_tree_node->next_sibling = new_child.impl->node_index;
-				new_tree_node->previous_sibling = tree_node->last_child;
-				tree_node->last_child = new_child.impl->node_index;
+				DomTreeNode last_tree_node = tree_node.get_last_child();
+				last_tree_node.next_sibling() = new_child.impl->node_index;
+				new_tree_node.previous_sibling() = tree_node.last_child();
+				tree_node.last_child() = new_child.impl->node_index;
 			}
 			else
 			{
-				tree_node->first_child = new_child.impl->node_index;
-				tree_node->last_child = new_child.impl->node_index;
+				tree_node.first_child() = new_child.impl->node_index;
+				tree_node.last_child() = new_child.impl->node_index;
 			}
-			new_tree_node->parent = impl->node_index;
+			new_tree_node.parent() = impl->node_index;
 			return new_child;
 		}
 		return DomNode();
@@ -661,27 +656,26 @@ namespace clan
 		else if (prefix == xmlns_xmlns || qualified_name == xmlns_xmlns)
 			return xmlns_xmlns;
 
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		const DomTreeNode *cur = impl->get_tree_node();
+		DomTreeNode cur = impl->get_tree_node();
 		while (cur)
 		{
-			const DomTreeNode *cur_attr = cur->get_first_attribute(doc_impl);
+			DomTreeNode cur_attr = cur.get_first_attribute();
 			while (cur_attr)
 			{
-				std::string node_name = cur_attr->get_node_name();
+				std::string node_name = cur_attr.get_node_name();
 				if (prefix.empty())
 				{
 					if (node_name == xmlns_xmlns)
-						return cur_attr->get_node_value();
+						return cur_attr.get_node_value();
 				}
 				else
 				{
 					if (node_name.substr(0, 6) == xmlns_prefix && node_name.substr(6) == prefix)
-						return cur_attr->get_node_value();
+						return cur_attr.get_node_value();
 				}
-				cur_attr = cur_attr->get_next_sibling(doc_impl);
+				cur_attr = cur_attr.get_next_sibling();
 			}
-			cur = cur->get_parent(doc_impl);
+			cur = cur.get_parent();
 		}
 		return DomString();
 	}
@@ -759,19 +753,11 @@ namespace clan
 	{
 	}
 
-	DomTreeNode *DomNode_Impl::get_tree_node()
-	{
-		if (node_index == cl_null_node_index)
-			return nullptr;
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)owner_document.lock().get();
-		return doc_impl->nodes[node_index];
-	}
-
-	const DomTreeNode *DomNode_Impl::get_tree_node() const
+	DomTreeNode DomNode_Impl::get_tree_node() const
 	{
 		if (node_index == cl_null_node_index)
-			return nullptr;
+			return DomTreeNode();
 		DomDocument_Impl *doc_impl = (DomDocument_Impl *)owner_document.lock().get();
-		return doc_impl->nodes[node_index];
+		return DomTreeNode(doc_impl, node_index);
 	}
 }
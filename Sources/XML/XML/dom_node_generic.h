@@ -46,7 +46,6 @@ namespace clan
 		unsigned int node_index;
 		std::weak_ptr<DomNode_Impl> owner_document;
 
-		DomTreeNode *get_tree_node();
-		const DomTreeNode *get_tree_node() const;
+		DomTreeNode get_tree_node() const;
 	};
 }
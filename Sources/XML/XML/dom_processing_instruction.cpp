@@ -41,9 +41,8 @@ namespace clan
 	DomProcessingInstruction::DomProcessingInstruction(DomDocument &doc, const DomString &target, const DomString &data)
 		: DomNode(doc, PROCESSING_INSTRUCTION_NODE)
 	{
-		DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-		impl->get_tree_node()->set_node_name(doc_impl, target);
-		impl->get_tree_node()->set_node_value(doc_impl, data);
+		impl->get_tree_node().set_node_name(target);
+		impl->get_tree_node().set_node_value(data);
 	}
 
 	DomProcessingInstruction::DomProcessingInstruction(const std::shared_ptr<DomNode_Impl> &impl) : DomNode(impl)
@@ -57,7 +56,7 @@ namespace clan
 	DomString DomProcessingInstruction::get_target() const
 	{
 		if (impl)
-			return impl->get_tree_node()->get_node_name();
+			return impl->get_tree_node().get_node_name();
 		else
 			return DomString();
 	}
@@ -65,7 +64,7 @@ namespace clan
 	DomString DomProcessingInstruction::get_data() const
 	{
 		if (impl)
-			return impl->get_tree_node()->get_node_value();
+			return impl->get_tree_node().get_node_value();
 		else
 			return DomString();
 	}
@@ -74,8 +73,7 @@ namespace clan
 	{
 		if (impl)
 		{
-			DomDocument_Impl *doc_impl = (DomDocument_Impl *)impl->owner_document.lock().get();
-			impl->get_tree_node()->set_node_value(doc_impl, data);
+			impl->get_tree_node().set_node_value(data);
 		}
 	}
 }
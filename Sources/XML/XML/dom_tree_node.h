@@ -28,7 +28,6 @@
 
 #pragma once
 
-#include "API/Core/System/block_allocator.h"
 #include "dom_document_generic.h"
 
 namespace clan
@@ -37,133 +36,86 @@ namespace clan
 
 	class DomDocument_Impl;
 
-	class DomTreeNode : public BlockAllocated
+	/// \brief Handle to one node in the document's node storage.
+	///
+	/// Link accessors return references into the storage arrays. They stay valid until the next node is allocated.
+	class DomTreeNode
 	{
 	public:
 		DomTreeNode()
-			: node_type(0), parent(cl_null_node_index), first_child(cl_null_node_index),
-			last_child(cl_null_node_index), previous_sibling(cl_null_node_index),
-			next_sibling(cl_null_node_index), first_attribute(cl_null_node_index)
+			: owner_document(nullptr), index(cl_null_node_index)
 		{
 		}
 
-		virtual ~DomTreeNode()
+		DomTreeNode(DomDocument_Impl *owner_document, unsigned int index)
+			: owner_document(owner_document), index(index)
 		{
 		}
 
-		std::string node_name;
-		std::string node_value;
-		std::string namespace_uri;
-		unsigned short node_type;
-		unsigned int parent;
-		unsigned int first_child;
-		unsigned int last_child;
-		unsigned int previous_sibling;
-		unsigned int next_sibling;
-		unsigned int first_attribute;
-
-		void reset()
-		{
-			node_name.clear();
-			node_value.clear();
-			namespace_uri.clear();
-			node_type = 0;
-			parent = cl_null_node_index;
-			first_child = cl_null_node_index;
-			last_child = cl_null_node_index;
-			previous_sibling = cl_null_node_index;
-			next_sibling = cl_null_node_index;
-			first_attribute = cl_null_node_index;
-		}
-
-		std::string get_node_name() const
-		{
-			return node_name;
-		}
-
-		std::string get_node_value() const
-		{
-			return node_value;
-		}
-
-		std::string get_namespace_uri() const
-		{
-			return namespace_uri;
-		}
-
-		void set_node_name(DomDocument_Impl *owner_document, const DomString &str)
-		{
-			node_name = str;
-		}
+		DomDocument_Impl *owner_document;
+		unsigned int index;
 
-		void set_node_value(DomDocument_Impl *owner_document, const DomString &str)
-		{
-			node_value = str;
-		}
+		bool is_null() const { return index == cl_null_node_index; }
+		explicit operator bool() const { return index != cl_null_node_index; }
+		bool operator==(const DomTreeNode &other) const { return index == other.index && owner_document == other.owner_document; }
+		bool operator!=(const DomTreeNode &other) const { return !(*this == other); }
 
-		void set_namespace_uri(DomDocument_Impl *owner_document, const DomString &str)
-		{
-			namespace_uri = str;
-		}
+		unsigned short &node_type() const { return owner_document->node_types[index]; }
+		unsigned int &parent() const { return owner_document->parents[index]; }
+		unsigned int &first_child() const { return owner_document->first_children[index]; }
+		unsigned int &last_child() const { return owner_document->last_children[index]; }
+		unsigned int &previous_sibling() const { return owner_document->previous_siblings[index]; }
+		unsigned int &next_sibling() const { return owner_document->next_siblings[index]; }
+		unsigned int &first_attribute() const { return owner_document->first_attributes[index]; }
 
-		DomTreeNode *get_parent(DomDocument_Impl *owner_document)
-		{
-			return parent != cl_null_node_index ? owner_document->nodes[parent] : nullptr;
-		}
+		unsigned int get_node_name_id() const { return owner_document->node_names[index]; }
+		unsigned int get_namespace_uri_id() const { return owner_document->namespace_uris[index]; }
 
-		const DomTreeNode *get_parent(DomDocument_Impl *owner_document) const
+		const std::string &get_node_name() const
 		{
-			return parent != cl_null_node_index ? owner_document->nodes[parent] : nullptr;
+			return owner_document->get_string(owner_document->node_names[index]);
 		}
 
-		DomTreeNode *get_first_child(DomDocument_Impl *owner_document)
-		{
-			return first_child != cl_null_node_index ? owner_document->nodes[first_child] : nullptr;
-		}
-
-		const DomTreeNode *get_first_child(DomDocument_Impl *owner_document) const
-		{
-			return first_child != cl_null_node_index ? owner_document->nodes[first_child] : nullptr;
-		}
-
-		DomTreeNode *get_last_child(DomDocument_Impl *owner_document)
+		std::string get_node_value() const
 		{
-			return last_child != cl_null_node_index ? owner_document->nodes[last_child] : nullptr;
+			return owner_document->get_value(index);
 		}
 
-		const DomTreeNode *get_last_child(DomDocument_Impl *owner_document) const
+		bool node_value_equals(const DomString &str) const
 		{
-			return last_child != cl_null_node_index ? owner_document->nodes[last_child] : nullptr;
+			return owner_document->value_equals(index, str);
 		}
 
-		DomTreeNode *get_previous_sibling(DomDocument_Impl *owner_document)
+		const std::string &get_namespace_uri() const
 		{
-			return previous_sibling != cl_null_node_index ? owner_document->nodes[previous_sibling] : nullptr;
+			return owner_document->get_string(owner_document->namespace_uris[index]);
 		}
 
-		const DomTreeNode *get_previous_sibling(DomDocument_Impl *owner_document) const
+		void set_node_name(const DomString &str)
 		{
-			return previous_sibling != cl_null_node_index ? owner_document->nodes[previous_sibling] : nullptr;
+			owner_document->node_names[index] = owner_document->intern_string(str);
 		}
 
-		DomTreeNode *get_next_sibling(DomDocument_Impl *owner_document)
+		void set_node_value(const DomString &str)
 		{
-			return next_sibling != cl_null_node_index ? owner_document->nodes[next_sibling] : nullptr;
+			owner_document->set_value(index, str);
 		}
 
-		const DomTreeNode *get_next_sibling(DomDocument_Impl *owner_document) const
+		void append_node_value(const DomString &str)
 		{
-			return next_sibling != cl_null_node_index ? owner_document->nodes[next_sibling] : nullptr;
+			owner_document->append_value(index, str);
 		}
 
-		DomTreeNode *get_first_attribute(DomDocument_Impl *owner_document)
+		void set_namespace_uri(const DomString &str)
 		{
-			return first_attribute != cl_null_node_index ? owner_document->nodes[first_attribute] : nullptr;
+			owner_document->namespace_uris[index] = owner_document->intern_string(str);
 		}
 
-		const DomTreeNode *get_first_attribute(DomDocument_Impl *owner_document) const
-		{
-			return first_attribute != cl_null_node_index ? owner_document->nodes[first_attribute] : nullptr;
-		}
+		DomTreeNode get_parent() const { return DomTreeNode(owner_document, parent()); }
+		DomTreeNode get_first_child() const { return DomTreeNode(owner_document, first_child()); }
+		DomTreeNode get_last_child() const { return DomTreeNode(owner_document, last_child()); }
+		DomTreeNode get_previous_sibling() const { return DomTreeNode(owner_document, previous_sibling()); }
+		DomTreeNode get_next_sibling() const { return DomTreeNode(owner_document, next_sibling()); }
+		DomTreeNode get_first_attribute() const { return DomTreeNode(owner_document, first_attribute()); }
 	};
 }
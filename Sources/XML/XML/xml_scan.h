@@ -0,0 +1,116 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Magnus Norddahl
+*/
+
+#pragma once
+
+#if !defined __ANDROID__ && ! defined CL_DISABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <cstring>
+
+namespace clan
+{
+	/// \brief Character scanning for the XML tokenizer
+	///
+	/// Looks at 16 bytes at a time while a full vector fits before the end pointer.
+	class XMLScan
+	{
+	public:
+		/// \brief Returns the first occurrence of stop, or end if there is none
+		///
+		/// Sets has_entity if an ampersand is passed on the way.
+		static const char *find(const char *pos, const char *end, char stop, bool &has_entity)
+		{
+#ifdef __SSE2__
+			const __m128i stop_char = _mm_set1_epi8(stop);
+			const __m128i ampersand = _mm_set1_epi8('&');
+			while (end - pos >= 16)
+			{
+				__m128i data = _mm_loadu_si128((const __m128i*)pos);
+				int stop_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, stop_char));
+				int entity_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, ampersand));
+				if (stop_mask)
+				{
+					int index = first_set_bit(stop_mask);
+					if (entity_mask & ((1 << index) - 1))
+						has_entity = true;
+					return pos + index;
+				}
+				if (entity_mask)
+					has_entity = true;
+				pos += 16;
+			}
+#endif
+			while (pos != end && *pos != stop)
+			{
+				if (*pos == '&')
+					has_entity = true;
+				pos++;
+			}
+			return pos;
+		}
+
+		/// \brief Returns the first character that is not XML whitespace, or end if there is none
+		static const char *skip_whitespace(const char *pos, const char *end)
+		{
+			while (pos != end && is_whitespace(*pos))
+				pos++;
+			return pos;
+		}
+
+		/// \brief Returns the first XML whitespace or one of the stop characters, or end if there is none
+		static const char *find_whitespace_or(const char *pos, const char *end, const char *stop_chars)
+		{
+			while (pos != end && !is_whitespace(*pos) && !(*pos && strchr(stop_chars, *pos)))
+				pos++;
+			return pos;
+		}
+
+		static bool is_whitespace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+	private:
+		static int first_set_bit(int mask)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else
+			return __builtin_ctz(mask);
+#endif
+		}
+	};
+}
@@ -29,10 +29,10 @@
 #include "XML/precomp.h"
 #include "API/XML/xml_tokenizer.h"
 #include "API/XML/xml_token.h"
-#include "API/Core/System/databuffer.h"
 #include "API/Core/Text/string_format.h"
 #include "API/Core/Text/string_help.h"
 #include "xml_tokenizer_generic.h"
+#include "xml_scan.h"
 #include <algorithm>
 #include <utility>
 
@@ -46,35 +46,12 @@ namespace clan
 	{
 	}
 
-	XMLTokenizer::XMLTokenizer(IODevice &input) : impl(std::make_shared<XMLTokenizer_Impl>())
+	XMLTokenizer::XMLTokenizer(IODevice &input) : impl(std::make_shared<XMLTokenizer_Impl>(input))
 	{
-		impl->input = input;
-		impl->size = input.get_size();
-		impl->pos = 0;
-
-		DataBuffer buffer(impl->size);
-		input.receive(buffer.get_data(), buffer.get_size(), true);
-
-		StringHelp::BOMType bom_type = StringHelp::detect_bom(buffer.get_data(), buffer.get_size());
-		switch (bom_type)
-		{
-		default:
-		case StringHelp::bom_none:
-			impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data(), buffer.get_size()));
-			break;
-		case StringHelp::bom_utf32_be:
-		case StringHelp::bom_utf32_le:
-			throw Exception("UTF-16 XML files not supported yet");
-			break;
-		case StringHelp::bom_utf16_be:
-		case StringHelp::bom_utf16_le:
-			throw Exception("UTF-32 XML files not supported yet");
-			break;
-		case StringHelp::bom_utf8:
-			impl->data = StringHelp::utf8_to_text(std::string(buffer.get_data() + 3, buffer.get_size() - 3));
-			break;
-		}
+	}
 
+	XMLTokenizer::XMLTokenizer(const void *data, size_t length) : impl(std::make_shared<XMLTokenizer_Impl>(static_cast<const char *>(data), length))
+	{
 	}
 
 	XMLTokenizer::~XMLTokenizer()
@@ -95,15 +72,37 @@ namespace clan
 	{
 		out_token->type = XMLToken::NULL_TOKEN;
 		out_token->variant = XMLToken::SINGLE;
-		//	out_token->attributes.clear();
-		while (!out_token->attributes.empty())
-			out_token->attributes.pop_back();
+		out_token->name.clear();
+		out_token->value.clear();
+		out_token->attributes.clear();
 
 		if (impl)
 		{
-			if (impl->next_text_node(out_token))
-				return;
-			impl->next_tag_node(out_token);
+			XMLTokenView &token = impl->token_view;
+			impl->next(&token);
+
+			out_token->type = token.type;
+			out_token->variant = token.variant;
+			out_token->name.assign(token.name.data, token.name.length);
+			out_token->value.assign(token.value.data, token.value.length);
+			out_token->attributes.resize(token.attributes.size());
+			for (size_t i = 0; i < token.attributes.size(); i++)
+			{
+				out_token->attributes[i].first.assign(token.attributes[i].first.data, token.attributes[i].first.length);
+				out_token->attributes[i].second.assign(token.attributes[i].second.data, token.attributes[i].second.length);
+			}
+		}
+	}
+
+	void XMLTokenizer::next(XMLTokenView *out_token)
+	{
+		if (impl)
+		{
+			impl->next(out_token);
+		}
+		else
+		{
+			*out_token = XMLTokenView();
 		}
 	}
 
@@ -116,40 +115,104 @@ namespace clan
 
 	/////////////////////////////////////////////////////////////////////////////
 
-	bool XMLTokenizer_Impl::next_text_node(XMLToken *out_token)
+	XMLTokenizer_Impl::XMLTokenizer_Impl(const char *data, size_t length) : data(data), size(length)
+	{
+		skip_bom();
+	}
+
+	XMLTokenizer_Impl::XMLTokenizer_Impl(IODevice &input) : input(input), streaming(true)
+	{
+		fill(4);
+		skip_bom();
+	}
+
+	void XMLTokenizer_Impl::skip_bom()
 	{
-		while (pos < size && data[pos] != '<')
+		StringHelp::BOMType bom_type = StringHelp::detect_bom(data + pos, size - pos);
+		switch (bom_type)
 		{
-			std::string::size_type start_pos = pos;
-			std::string::size_type end_pos = data.find('<', start_pos);
-			if (end_pos == data.npos) end_pos = size;
-			pos = end_pos;
+		default:
+		case StringHelp::bom_none:
+			break;
+		case StringHelp::bom_utf32_be:
+		case StringHelp::bom_utf32_le:
+			throw Exception("UTF-16 XML files not supported yet");
+			break;
+		case StringHelp::bom_utf16_be:
+		case StringHelp::bom_utf16_le:
+			throw Exception("UTF-32 XML files not supported yet");
+			break;
+		case StringHelp::bom_utf8:
+			pos += 3;
+			break;
+		}
+	}
 
-			std::string text;
-			std::string text_orig = data.substr(start_pos, end_pos - start_pos);
-			unescape(text, text_orig);
-			if (eat_whitespace)
+	void XMLTokenizer_Impl::next(XMLTokenView *out_token)
+	{
+		while (true)
+		{
+			out_token->type = XMLToken::NULL_TOKEN;
+			out_token->variant = XMLToken::SINGLE;
+			out_token->name = XMLStringView();
+			out_token->value = XMLStringView();
+			out_token->attributes.clear();
+			decoded_used = 0;
+
+			if (pos == size && !fill(1))
+				return;
+
+			size_t token_start = pos;
+			try
+			{
+				if (data[pos] != '<')
+				{
+					if (next_text_node(out_token))
+						return;
+				}
+				else
+				{
+					next_tag_node(out_token);
+					return;
+				}
+			}
+			catch (const NeedMoreData &)
 			{
-				text = trim_whitespace(text);
-				if (text.empty())
-					continue;
+				// Token continues past the buffered data. Read more and try again
+				pos = token_start;
+				fill(size - pos + 1);
 			}
-
-			out_token->type = XMLToken::TEXT_TOKEN;
-			out_token->value = text;
-			return true;
 		}
-		return false;
 	}
 
-	bool XMLTokenizer_Impl::next_tag_node(XMLToken *out_token)
+	bool XMLTokenizer_Impl::next_text_node(XMLTokenView *out_token)
 	{
-		if (pos == size || data[pos] != '<')
-			return false;
+		bool has_entity = false;
+		size_t start_pos = pos;
+		size_t end_pos = XMLScan::find(data + pos, data + size, '<', has_entity) - data;
+		if (end_pos == size && streaming && !eof)
+			throw NeedMoreData();
+		pos = end_pos;
+
+		if (eat_whitespace)
+		{
+			start_pos = skip_whitespace(start_pos);
+			while (end_pos > start_pos && XMLScan::is_whitespace(data[end_pos - 1]))
+				end_pos--;
+			if (start_pos == end_pos)
+				return false;
+		}
+
+		out_token->type = XMLToken::TEXT_TOKEN;
+		out_token->value = unescape(start_pos, end_pos, has_entity);
+		return true;
+	}
 
+	void XMLTokenizer_Impl::next_tag_node(XMLTokenView *out_token)
+	{
 		pos++;
 		if (pos == size)
-			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			premature_end();
 
 		// Try to early predict what sort of node it might be:
 		bool closing = (data[pos] == '/');
@@ -160,37 +223,37 @@ namespace clan
 		{
 			pos++;
 			if (pos == size)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				premature_end();
 		}
 
 		if (exclamationMark) // check for cdata section, comments or doctype
 		{
-			if (next_exclamation_mark_node(out_token))
-				return true;
+			next_exclamation_mark_node(out_token);
+			return;
 		}
 
 		// Extract the tag name:
-		std::string::size_type start_pos = pos;
-		std::string::size_type end_pos = data.find_first_of(" \r\n\t?/>", start_pos);
-		if (end_pos == data.npos)
-			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+		size_t start_pos = pos;
+		size_t end_pos = find_whitespace_or("?/>", start_pos);
+		if (end_pos == size)
+			premature_end();
 		pos = end_pos;
 
 		out_token->type = questionMark ? XMLToken::PROCESSING_INSTRUCTION_TOKEN : XMLToken::ELEMENT_TOKEN;
 		out_token->variant = closing ? XMLToken::END : XMLToken::BEGIN;
-		out_token->name = data.substr(start_pos, end_pos - start_pos);
+		out_token->name = view(start_pos, end_pos);
 
 		if (out_token->type == XMLToken::PROCESSING_INSTRUCTION_TOKEN)
 		{
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos);
-			if (pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-			end_pos = data.find_first_of("?", pos);
-			if (end_pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-			out_token->value = data.substr(pos, end_pos - pos);
+			pos = skip_whitespace(pos);
+			if (pos == size)
+				premature_end();
+
+			end_pos = find('?', pos);
+			if (end_pos == size)
+				premature_end();
+			out_token->value = view(pos, end_pos);
 			pos = end_pos;
 		}
 		else // out_token->type == XMLToken::ELEMENT_TOKEN
@@ -199,68 +262,64 @@ namespace clan
 			while (true)
 			{
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
-				if (pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				pos = skip_whitespace(pos);
+				if (pos == size)
+					premature_end();
 
 				// End of tag, stop searching for more attributes:
 				if (data[pos] == '/' || data[pos] == '?' || data[pos] == '>')
 					break;
 
 				// Extract attribute name:
-				std::string::size_type start_pos = pos;
-				std::string::size_type end_pos = data.find_first_of(" \r\n\t=", start_pos);
-				if (end_pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				size_t start_pos = pos;
+				size_t end_pos = find_whitespace_or("=", start_pos);
+				if (end_pos == size)
+					premature_end();
 				pos = end_pos;
 
-				std::string attributeName = data.substr(start_pos, end_pos - start_pos);
+				XMLStringView attribute_name = view(start_pos, end_pos);
 
 				// Find seperator:
-				pos = data.find_first_not_of(" \r\n\t", pos);
-				if (pos == data.npos || pos == size - 1)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				pos = skip_whitespace(pos);
+				if (pos == size || pos == size - 1)
+					premature_end();
 				if (data[pos++] != '=')
-					XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), out_token->name, attributeName));
+					XMLTokenizer_Impl::throw_exception(string_format("XML error(s), parser confused at line %1 (tag=%2, attributeName=%3)", get_line_number(), out_token->name.to_string(), attribute_name.to_string()));
 
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
-				if (pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				pos = skip_whitespace(pos);
+				if (pos == size)
+					premature_end();
 
 				// Extract attribute value:
-				std::string::value_type const * first_of = " \r\n\t";
-				if (data[pos] == '"')
+				char quote = 0;
+				if (data[pos] == '"' || data[pos] == '\'')
 				{
-					first_of = "\"";
+					quote = data[pos];
 					pos++;
 					if (pos == size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+						premature_end();
 				}
-				else
-					if (data[pos] == '\'')
-					{
-						first_of = "'";
-						pos++;
-						if (pos == size)
-							XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-					}
 
+				bool has_entity = false;
 				start_pos = pos;
-				end_pos = data.find_first_of(first_of, start_pos);
-				if (end_pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				if (quote)
+					end_pos = XMLScan::find(data + start_pos, data + size, quote, has_entity) - data;
+				else
+					end_pos = find_whitespace_or("", start_pos);
+				if (end_pos == size)
+					premature_end();
 
-				std::string attributeValue;
-				std::string attributeValueOrig = data.substr(start_pos, end_pos - start_pos);
-				unescape(attributeValue, attributeValueOrig);
+				if (!quote)
+					has_entity = memchr(data + start_pos, '&', end_pos - start_pos) != nullptr;
+				XMLStringView attribute_value = unescape(start_pos, end_pos, has_entity);
 
 				pos = end_pos + 1;
 				if (pos == size)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+					premature_end();
 
 				// Finally apply attribute to token:
-				out_token->attributes.push_back(XMLToken::Attribute(attributeName, attributeValue));
+				out_token->attributes.push_back(XMLTokenView::Attribute(attribute_name, attribute_value));
 			}
 		}
 
@@ -270,168 +329,114 @@ namespace clan
 			out_token->variant = XMLToken::SINGLE;
 			pos++;
 			if (pos == size)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				premature_end();
 		}
 
 		// Data stream should be ending now.
 		if (data[pos] != '>')
 			XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (expected end of tag)", get_line_number()));
 		pos++;
-
-		return true;
 	}
 
-	bool XMLTokenizer_Impl::next_exclamation_mark_node(XMLToken *out_token)
+	void XMLTokenizer_Impl::next_exclamation_mark_node(XMLTokenView *out_token)
 	{
 		if (pos + 2 >= size)
-			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			premature_end();
 
-		if (data.compare(pos, 2, "--") == 0) // comment block
+		if (compare(pos, "--")) // comment block
 		{
-			std::string::size_type start_pos = pos + 2;
-			std::string::size_type end_pos = data.find("-->", start_pos);
-			if (end_pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			size_t start_pos = pos + 2;
+			size_t end_pos = find("-->", start_pos);
+			if (end_pos == size)
+				premature_end();
 			pos = end_pos + 3;
 
-			std::string text;
-			std::string text_orig = data.substr(start_pos, end_pos - start_pos);
-			unescape(text, text_orig);
 			if (eat_whitespace)
-				text = trim_whitespace(text);
+			{
+				start_pos = skip_whitespace(start_pos);
+				while (end_pos > start_pos && XMLScan::is_whitespace(data[end_pos - 1]))
+					end_pos--;
+			}
 
 			out_token->type = XMLToken::COMMENT_TOKEN;
 			out_token->variant = XMLToken::SINGLE;
-			out_token->value = text;
-			return true;
+			out_token->value = unescape(start_pos, end_pos, memchr(data + start_pos, '&', end_pos - start_pos) != nullptr);
+			return;
 		}
 
 		if (pos + 7 >= size)
-			XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			premature_end();
 
-		if (data.compare(pos, 7, "DOCTYPE") == 0)
+		if (compare(pos, "DOCTYPE"))
 		{
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos + 7);
-			if (pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-			// Find doctype name:				
-			std::string::size_type name_start = pos;
-			std::string::size_type name_end = data.find_first_of(" \r\n\t?/>", name_start);
-			if (name_end == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			pos = skip_whitespace(pos + 7);
+			if (pos == size)
+				premature_end();
+
+			// Find doctype name:
+			size_t name_end = find_whitespace_or("?/>", pos);
+			if (name_end == size)
+				premature_end();
 			pos = name_end;
 
 			// Strip whitespace:
-			pos = data.find_first_not_of(" \r\n\t", pos);
-			if (pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-			std::string::size_type public_start = data.npos;
-			std::string::size_type public_end = data.npos;
-			std::string::size_type system_start = data.npos;
-			std::string::size_type system_end = data.npos;
-			std::string::size_type subset_start = data.npos;
-			std::string::size_type subset_end = data.npos;
+			pos = skip_whitespace(pos);
+			if (pos == size)
+				premature_end();
 
 			// Look for possible external id:
 			if (data[pos] != '[' && data[pos] != '>')
 			{
 				if (pos + 6 >= size)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-				if (data.compare(pos, 6, "SYSTEM") == 0)
-				{
-					pos += 6;
-					if (pos == size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+					premature_end();
 
-					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
-					if (pos == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-					// Read system literal:
-					std::string::value_type literal_char = data[pos];
-					if (literal_char != '\'' && literal_char != '"')
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				int literal_count = 0;
+				if (compare(pos, "SYSTEM"))
+					literal_count = 1;
+				else if (compare(pos, "PUBLIC"))
+					literal_count = 2;
+				else
+					XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (unknown external identifier type in DOCTYPE)", get_line_number()));
+				pos += 6;
 
-					system_start = pos + 1;
-					system_end = data.find(literal_char, system_start);
-					if (system_end == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-					pos = system_end + 1;
-					if (pos >= size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-				}
-				else if (data.compare(pos, 6, "PUBLIC") == 0)
+				// Read public and system literals:
+				for (int i = 0; i < literal_count; i++)
 				{
-					pos += 6;
-					if (pos == size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
-					if (pos == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-					// Read public literal:
-					std::string::value_type literal_char = data[pos];
-					if (literal_char != '\'' && literal_char != '"')
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-					public_start = pos + 1;
-					public_end = data.find(literal_char, public_start);
-					if (public_end == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-					pos = public_end + 1;
-					if (pos >= size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
 					// Strip whitespace:
-					pos = data.find_first_not_of(" \r\n\t", pos);
-					if (pos == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+					pos = skip_whitespace(pos);
+					if (pos == size)
+						premature_end();
 
-					// Read system literal:
-					literal_char = data[pos];
+					char literal_char = data[pos];
 					if (literal_char != '\'' && literal_char != '"')
 						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
 
-					system_start = pos + 1;
-					system_end = data.find(literal_char, system_start);
-					if (system_end == data.npos)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-					pos = system_end + 1;
+					size_t literal_end = find(literal_char, pos + 1);
+					if (literal_end == size)
+						premature_end();
+					pos = literal_end + 1;
 					if (pos >= size)
-						XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+						premature_end();
 				}
-				else
-					XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (unknown external identifier type in DOCTYPE)", get_line_number()));
 
 				// Strip whitespace:
-				pos = data.find_first_not_of(" \r\n\t", pos);
-				if (pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+				pos = skip_whitespace(pos);
+				if (pos == size)
+					premature_end();
 			}
 
 			// Look for possible internal subset:
 			if (data[pos] == '[')
 			{
-				subset_start = pos + 1;
-
-				// Search for the end of the internal subset:
-				// (to avoid parsing it, we search backwards)
-				std::string::size_type end_pos = data.find('>', pos + 1);
-				if (end_pos == data.npos)
-					XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
-
-				subset_end = data.rfind(']', end_pos);
-				if (subset_end == data.npos)
-					XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream, line %1 (expected end of internal subset in DOCTYPE)", get_line_number()));
+				// Search for the end of the internal subset without parsing it:
+				size_t subset_end = find(']', pos + 1);
+				if (subset_end == size)
+					premature_end();
 
-				pos = end_pos;
+				pos = skip_whitespace(subset_end + 1);
+				if (pos == size)
+					premature_end();
 			}
 
 			// Expect DOCTYPE tag to end now:
@@ -440,28 +445,60 @@ namespace clan
 			pos++;
 
 			out_token->type = XMLToken::DOCUMENT_TYPE_TOKEN;
-			return true;
 		}
-		else if (data.compare(pos, 7, "[CDATA[") == 0)
+		else if (compare(pos, "[CDATA["))
 		{
-			std::string::size_type start_pos = pos + 7;
-			std::string::size_type end_pos = data.find("]]>", start_pos);
-			if (end_pos == data.npos)
-				XMLTokenizer_Impl::throw_exception("Premature end of XML data!");
+			size_t start_pos = pos + 7;
+			size_t end_pos = find("]]>", start_pos);
+			if (end_pos == size)
+				premature_end();
 			pos = end_pos + 3;
 
-			std::string value = data.substr(start_pos, end_pos - start_pos);
-
 			out_token->type = XMLToken::CDATA_SECTION_TOKEN;
 			out_token->variant = XMLToken::SINGLE;
-			out_token->value = value;
-			return true;
+			out_token->value = view(start_pos, end_pos);
 		}
 		else
 		{
 			XMLTokenizer_Impl::throw_exception(string_format("Error in XML stream at position %1", static_cast<int>(pos)));
+		}
+	}
+
+	bool XMLTokenizer_Impl::fill(size_t count)
+	{
+		size_t available = size - pos;
+		if (available >= count)
+			return true;
+		if (!streaming || eof)
 			return false;
+
+		// Move the unread data to the front and make room for at least another chunk
+		discarded_lines += (int)std::count(data, data + pos, '\n');
+		if (available > 0 && pos != 0)
+			memmove(buffer.data(), data + pos, available);
+		size_t needed = std::max(count, available + chunk_size);
+		if (buffer.size() < needed)
+			buffer.resize(std::max(needed, buffer.size() * 2));
+
+		while (available < count && !eof)
+		{
+			size_t received = input.read(buffer.data() + available, buffer.size() - available, false);
+			if (received == 0)
+				eof = true;
+			available += received;
 		}
+
+		data = buffer.data();
+		pos = 0;
+		size = available;
+		return available >= count;
+	}
+
+	void XMLTokenizer_Impl::premature_end()
+	{
+		if (streaming && !eof)
+			throw NeedMoreData();
+		throw_exception("Premature end of XML data!");
 	}
 
 	void XMLTokenizer_Impl::throw_exception(const std::string &str)
@@ -471,66 +508,94 @@ namespace clan
 
 	int XMLTokenizer_Impl::get_line_number()
 	{
-		int line = 1;
-		std::string::size_type tmp_pos = 0;
+		return 1 + discarded_lines + (int)std::count(data, data + std::min(pos + 1, size), '\n');
+	}
 
-		std::string::const_iterator it;
-		for (it = data.begin(); it != data.end() && tmp_pos <= pos; ++it, tmp_pos++)
+	size_t XMLTokenizer_Impl::find(char c, size_t from) const
+	{
+		const void *found = memchr(data + from, c, size - from);
+		return found ? static_cast<const char *>(found) - data : size;
+	}
+
+	size_t XMLTokenizer_Impl::find(const char *str, size_t from) const
+	{
+		size_t length = strlen(str);
+		while (true)
 		{
-			if ((*it) == '\n')
-				line++;
+			from = find(str[0], from);
+			if (size - from < length)
+				return size;
+			if (memcmp(data + from, str, length) == 0)
+				return from;
+			from++;
 		}
+	}
 
-		return line;
+	size_t XMLTokenizer_Impl::find_whitespace_or(const char *stop_chars, size_t from) const
+	{
+		return XMLScan::find_whitespace_or(data + from, data + size, stop_chars) - data;
 	}
 
-	inline void XMLTokenizer_Impl::unescape(std::string &unescaped, const std::string &text)
+	size_t XMLTokenizer_Impl::skip_whitespace(size_t from) const
 	{
-		static const std::string quot("&quot;");
-		static const std::string apos("&apos;");
-		static const std::string lt("&lt;");
-		static const std::string gt("&gt;");
-		static const std::string amp("&amp;");
-
-		unescaped = text;
-		unescape(unescaped, quot, '"');
-		unescape(unescaped, apos, '\'');
-		unescape(unescaped, lt, '<');
-		unescape(unescaped, gt, '>');
-		unescape(unescaped, amp, '&');
+		return XMLScan::skip_whitespace(data + from, data + size) - data;
 	}
 
-	inline void XMLTokenizer_Impl::unescape(std::string &text, const std::string &search, std::string::value_type replace)
+	bool XMLTokenizer_Impl::compare(size_t from, const char *str) const
 	{
-		std::string::size_type read_pos = 0;
-		std::string::size_type length = text.length();
-		std::string::size_type search_length = search.length();
-		while (true)
+		size_t length = strlen(str);
+		return size - from >= length && memcmp(data + from, str, length) == 0;
+	}
+
+	XMLStringView XMLTokenizer_Impl::unescape(size_t start, size_t end, bool has_entity)
+	{
+		if (!has_entity)
+			return view(start, end);
+
+		static const struct { const char *name; size_t length; char replace; } entities[] =
+		{
+			{ "&quot;", 6, '"' },
+			{ "&apos;", 6, '\'' },
+			{ "&lt;", 4, '<' },
+			{ "&gt;", 4, '>' },
+			{ "&amp;", 5, '&' }
+		};
+
+		if (decoded_used == decoded.size())
+			decoded.emplace_back();
+		std::string &text = decoded[decoded_used++];
+		text.clear();
+
+		const char *read_pos = data + start;
+		const char *read_end = data + end;
+		while (read_pos != read_end)
 		{
-			std::string::size_type next_match = text.find(search, read_pos);
-			if (next_match == std::string::npos)
+			const char *ampersand = static_cast<const char *>(memchr(read_pos, '&', read_end - read_pos));
+			if (!ampersand)
+			{
+				text.append(read_pos, read_end);
 				break;
+			}
+			text.append(read_pos, ampersand);
+			read_pos = ampersand;
 
-			std::string::size_type copy_size = length - (next_match + search_length);
-			if (copy_size > 0)
-				memmove(&text[next_match + 1], &text[next_match + search_length], copy_size * sizeof(std::string::value_type));
-			text[next_match] = replace;
-			length -= search_length - 1;
-			read_pos = next_match + 1;
-			if (read_pos > length)
-				break;
+			bool found = false;
+			for (const auto &entity : entities)
+			{
+				if ((size_t)(read_end - read_pos) >= entity.length && memcmp(read_pos, entity.name, entity.length) == 0)
+				{
+					text.push_back(entity.replace);
+					read_pos += entity.length;
+					found = true;
+					break;
+				}
+			}
+			if (!found)
+			{
+				text.push_back('&');
+				read_pos++;
+			}
 		}
-		text.resize(length);
-	}
-
-	inline std::string XMLTokenizer_Impl::trim_whitespace(const std::string &text)
-	{
-		std::string::size_type pos_start = text.find_first_not_of(" \t\r\n");
-		if (pos_start == std::string::npos)
-			return std::string();
-		std::string::size_type pos_end = text.find_last_not_of(" \t\r\n");
-		if (pos_end == std::string::npos)
-			return std::string();
-		return text.substr(pos_start, pos_end - pos_start + 1);
+		return XMLStringView(text.data(), text.size());
 	}
 }
@@ -29,29 +29,63 @@
 #pragma once
 
 #include "API/Core/IOData/iodevice.h"
+#include "API/XML/xml_token.h"
+#include <deque>
+#include <vector>
 
 namespace clan
 {
 	class XMLTokenizer_Impl
 	{
 	public:
-		XMLTokenizer_Impl() : pos(0), size(0), eat_whitespace(true) { }
+		XMLTokenizer_Impl(const char *data, size_t length);
+		XMLTokenizer_Impl(IODevice &input);
 
-		IODevice input;
-		std::string::size_type pos, size;
-		std::string data;
-		bool eat_whitespace;
+		bool eat_whitespace = true;
+
+		/// \brief Token used when converting to XMLToken, kept to reuse its attribute list.
+		XMLTokenView token_view;
+
+		void next(XMLTokenView *out_token);
 
+	private:
+		/// \brief Thrown when a token continues past the end of the buffered input.
+		struct NeedMoreData { };
+
+		bool next_text_node(XMLTokenView *out_token);
+		void next_tag_node(XMLTokenView *out_token);
+		void next_exclamation_mark_node(XMLTokenView *out_token);
+
+		bool fill(size_t count);
+		void skip_bom();
+		void premature_end();
 		static void throw_exception(const std::string &str);
-		bool next_text_node(XMLToken *out_token);
-		bool next_tag_node(XMLToken *out_token);
-		bool next_exclamation_mark_node(XMLToken *out_token);
 
 		// used to get the line number when there is an error in the xml file
 		int get_line_number();
 
-		void unescape(std::string &text_out, const std::string &text_in);
-		void unescape(std::string &text, const std::string &search, std::string::value_type replace);
-		std::string trim_whitespace(const std::string &text);
+		size_t find(char c, size_t from) const;
+		size_t find(const char *str, size_t from) const;
+		size_t find_whitespace_or(const char *stop_chars, size_t from) const;
+		size_t skip_whitespace(size_t from) const;
+		bool compare(size_t from, const char *str) const;
+
+		XMLStringView view(size_t start, size_t end) const { return XMLStringView(data + start, end - start); }
+		XMLStringView unescape(size_t start, size_t end, bool has_entity);
+
+		IODevice input;
+		bool streaming = false;
+		bool eof = false;
+		std::vector<char> buffer;
+
+		const char *data = nullptr;
+		size_t pos = 0, size = 0;
+		int discarded_lines = 0;
+
+		// Decoded values, a deque so earlier values stay in place while adding more
+		std::deque<std::string> decoded;
+		size_t decoded_used = 0;
+
+		static const size_t chunk_size = 64 * 1024;
 	};
 }
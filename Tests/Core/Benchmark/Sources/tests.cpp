@@ -83,6 +83,10 @@ void Tests::Init(std::vector<TestInfo> &testlist)
 	testlist.push_back(TestInfo("{value_rad = fmod(value_rad, clan::PI*2.0f);...}", &Tests::test_normalization1));
 	testlist.push_back(TestInfo("value_rad -= (2.0f * PI) * std::floor...}", &Tests::test_normalization2));
 
+	testlist.push_back(TestInfo("{signal(int_value);}    : 1 slot connected", &Tests::test_signal_emit_1slot));
+	testlist.push_back(TestInfo("{signal(int_value);}    : 10 slots connected", &Tests::test_signal_emit_10slots));
+	testlist.push_back(TestInfo("{signal(int_value);}    : 100 slots connected", &Tests::test_signal_emit_100slots));
+
 }
 
 Tests::Tests()
@@ -101,6 +105,15 @@ Tests::Tests()
 
 	std_vector_int_size16.resize(16, 0);
 	string_15 = "123456789012345";
+
+	for (int cnt = 0; cnt < 100; cnt++)
+	{
+		if (cnt < 1)
+			signal_slots.connect(signal_1slot, [this](int value) { int_value += value; });
+		if (cnt < 10)
+			signal_slots.connect(signal_10slots, [this](int value) { int_value += value; });
+		signal_slots.connect(signal_100slots, [this](int value) { int_value += value; });
+	}
 }
 
 void Tests::test_empty()
@@ -319,3 +332,18 @@ void Tests::test_string_v8b()
 {
 	int_value += utils.test_string_v8(string_15);
 }
+
+void Tests::test_signal_emit_1slot()
+{
+	signal_1slot(int_seven);
+}
+
+void Tests::test_signal_emit_10slots()
+{
+	signal_10slots(int_seven);
+}
+
+void Tests::test_signal_emit_100slots()
+{
+	signal_100slots(int_seven);
+}
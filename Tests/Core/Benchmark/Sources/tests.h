@@ -99,6 +99,10 @@ public:
 	void test_normalization1();
 	void test_normalization2();
 
+	void test_signal_emit_1slot();
+	void test_signal_emit_10slots();
+	void test_signal_emit_100slots();
+
 
 	Utils utils;
 	std::string string;
@@ -118,4 +122,8 @@ public:
 	std::shared_ptr<int> int_shared_ptr;
 	std::vector<int> std_vector_int_size16;
 	std::string string_15;
+	clan::Signal<void(int)> signal_1slot;
+	clan::Signal<void(int)> signal_10slots;
+	clan::Signal<void(int)> signal_100slots;
+	clan::SlotContainer signal_slots;
 };
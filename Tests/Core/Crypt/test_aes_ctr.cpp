@@ -0,0 +1,125 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_aes_ctr()
+{
+	Console::write_line(" Header: aes_ctr.h");
+	Console::write_line("  Class: AES_CTR");
+
+	// Test data from http://csrc.nist.gov/publications/nistpubs/800-38a/sp800-38a.pdf
+
+	test_aes_ctr_helper(
+		"2b7e151628aed2a6abf7158809cf4f3c",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// IV
+		"6bc1bee22e409f96e93d7e117393172a"	// PLAINTEXT
+		"ae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52ef"
+		"f69f2445df4f9b17ad2b417be66c3710",
+		"874d6191b620e3261bef6864990db6ce"	// CIPHERTEXT
+		"9806f66b7970fdff8617187bb9fffdff"
+		"5ae4df3edbd5d35e5b4f09020db03eab"
+		"1e031dda2fbe03d1792170a0f3009cee"
+		);
+
+	test_aes_ctr_helper(
+		"603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",	// KEY
+		"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff",	// IV
+		"6bc1bee22e409f96e93d7e117393172a"	// PLAINTEXT
+		"ae2d8a571e03ac9c9eb76fac45af8e51"
+		"30c81c46a35ce411e5fbc1191a0a52ef"
+		"f69f2445df4f9b17ad2b417be66c3710",
+		"601ec313775789a5b7a7f504bbf3d228"	// CIPHERTEXT
+		"f443e3ca4d62b59aca84e990cacaf5c5"
+		"2b0930daa23de94ce87017ba2d84988d"
+		"dfc9c58db67aada613c2dd08457941a6"
+		);
+
+	// Adding the data in pieces of any size must give the same result as adding it at once
+	const int test_data_length = 1000;
+	std::vector<unsigned char> test_data(test_data_length);
+	for (int cnt = 0; cnt < test_data_length; cnt++)
+		test_data[cnt] = (unsigned char)(cnt * 7);
+
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	convert_ascii("2B7E151628AED2A6ABF7158809CF4F3C", key);
+	convert_ascii("F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF", iv);
+
+	AES_CTR aes_ctr;
+	aes_ctr.set_key(&key[0], key.size());
+	aes_ctr.set_iv(&iv[0]);
+	aes_ctr.add(&test_data[0], test_data_length);
+	DataBuffer expected = aes_ctr.get_data();
+
+	for (int piece_size = 1; piece_size < 40; piece_size += 3)
+	{
+		AES_CTR aes_ctr_pieces;
+		aes_ctr_pieces.set_key(&key[0], key.size());
+		aes_ctr_pieces.set_iv(&iv[0]);
+		for (int pos = 0; pos < test_data_length; pos += piece_size)
+			aes_ctr_pieces.add(&test_data[pos], min(piece_size, test_data_length - pos));
+		DataBuffer buffer = aes_ctr_pieces.get_data();
+		if (buffer.get_size() != expected.get_size())
+			fail();
+		if (memcmp(buffer.get_data(), expected.get_data(), expected.get_size()))
+			fail();
+
+		AES_CTR aes_ctr_decrypt;
+		aes_ctr_decrypt.set_key(&key[0], key.size());
+		aes_ctr_decrypt.set_iv(&iv[0]);
+		aes_ctr_decrypt.add(buffer);
+		if (memcmp(aes_ctr_decrypt.get_data().get_data(), &test_data[0], test_data_length))
+			fail();
+	}
+}
+
+void TestApp::test_aes_ctr_helper(const char *key_ptr, const char *iv_ptr, const char *plaintext_ptr, const char *ciphertext_ptr)
+{
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	std::vector<unsigned char> plaintext;
+	std::vector<unsigned char> ciphertext;
+
+	convert_ascii(key_ptr, key);
+	convert_ascii(iv_ptr, iv);
+	convert_ascii(plaintext_ptr, plaintext);
+	convert_ascii(ciphertext_ptr, ciphertext);
+
+	AES_CTR aes_ctr;
+	aes_ctr.set_key(&key[0], key.size());
+	aes_ctr.set_iv(&iv[0]);
+	aes_ctr.add(&plaintext[0], plaintext.size());
+	DataBuffer buffer = aes_ctr.get_data();
+	if (buffer.get_size() != ciphertext.size())
+		fail();
+	if (memcmp(buffer.get_data(), &ciphertext[0], ciphertext.size()))
+		fail();
+}
@@ -0,0 +1,224 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+void TestApp::test_aes_gcm()
+{
+	Console::write_line(" Header: aes_gcm_encrypt.h and aes_gcm_decrypt.h");
+	Console::write_line("  Class: AES_GCM_Encrypt and AES_GCM_Decrypt");
+
+	// Test data from "The Galois/Counter Mode of Operation (GCM)", McGrew and Viega
+
+	// Test Case 2
+	test_aes_gcm_helper(
+		"00000000000000000000000000000000",	// KEY
+		"000000000000000000000000",	// IV
+		"",	// AAD
+		"00000000000000000000000000000000",	// PLAINTEXT
+		"0388dace60b6a392f328c2b971b2fe78",	// CIPHERTEXT
+		"ab6e47d42cec13bdf53a67b21257bddf"	// TAG
+		);
+
+	// Test Case 3
+	test_aes_gcm_helper(
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"",
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b391aafd255",
+		"42831ec2217774244b7221b784d0d49c"
+		"e3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa05"
+		"1ba30b396a0aac973d58e091473f5985",
+		"4d5c2af327cd64a62cf35abd2ba6fab4"
+		);
+
+	// Test Case 4
+	test_aes_gcm_helper(
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbaddecaf888",
+		"feedfacedeadbeeffeedfacedeadbeef"
+		"abaddad2",
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39",
+		"42831ec2217774244b7221b784d0d49c"
+		"e3aa212f2c02a4e035c17e2329aca12e"
+		"21d514b25466931c7d8f6a5aac84aa05"
+		"1ba30b396a0aac973d58e091",
+		"5bc94fbc3221a5db94fae95ae7121a47"
+		);
+
+	// Test Case 5 (8 byte initialisation vector)
+	test_aes_gcm_helper(
+		"feffe9928665731c6d6a8f9467308308",
+		"cafebabefacedbad",
+		"feedfacedeadbeeffeedfacedeadbeef"
+		"abaddad2",
+		"d9313225f88406e5a55909c5aff5269a"
+		"86a7a9531534f7da2e4c303d8a318a72"
+		"1c3c0c95956809532fcf0e2449a6b525"
+		"b16aedf5aa0de657ba637b39",
+		"61353b4c2806934a777ff51fa22a4755"
+		"699b2a714fcdc6f83766e5f97b6c7423"
+		"73806900e49f24b22b097544d4896b42"
+		"4989b5e1ebac0f07c23f4598",
+		"3612d2e79e3b0785561be14aaca2fccb"
+		);
+
+	// Test Case 14
+	test_aes_gcm_helper(
+		"00000000000000000000000000000000"
+		"00000000000000000000000000000000",
+		"000000000000000000000000",
+		"",
+		"00000000000000000000000000000000",
+		"cea7403d4d606b6e074ec5d3baf39d18",
+		"d0d1c8a799996bf0265b98b5d48ab919"
+		);
+
+	// Adding the data in pieces must give the same result as adding it at once
+	const int test_data_length = 1000;
+	std::vector<unsigned char> test_data(test_data_length);
+	for (int cnt = 0; cnt < test_data_length; cnt++)
+		test_data[cnt] = (unsigned char)(cnt * 13);
+
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	convert_ascii("FEFFE9928665731C6D6A8F9467308308", key);
+	convert_ascii("CAFEBABEFACEDBADDECAF888", iv);
+
+	AES_GCM_Encrypt aes_gcm_encrypt;
+	aes_gcm_encrypt.set_key(&key[0], key.size());
+	aes_gcm_encrypt.set_iv(&iv[0], iv.size());
+	aes_gcm_encrypt.add_aad(&test_data[0], 77);
+	aes_gcm_encrypt.add(&test_data[0], test_data_length);
+	aes_gcm_encrypt.calculate();
+	DataBuffer expected = aes_gcm_encrypt.get_data();
+	unsigned char expected_tag[AES_GCM_Encrypt::tag_size];
+	aes_gcm_encrypt.get_tag(expected_tag);
+
+	for (int piece_size = 1; piece_size < 40; piece_size += 3)
+	{
+		// The key is kept, only the initialisation vector is set for each message
+		aes_gcm_encrypt.set_iv(&iv[0], iv.size());
+		for (int pos = 0; pos < 77; pos += piece_size)
+			aes_gcm_encrypt.add_aad(&test_data[pos], min(piece_size, 77 - pos));
+		for (int pos = 0; pos < test_data_length; pos += piece_size)
+			aes_gcm_encrypt.add(&test_data[pos], min(piece_size, test_data_length - pos));
+		aes_gcm_encrypt.calculate();
+
+		unsigned char tag[AES_GCM_Encrypt::tag_size];
+		aes_gcm_encrypt.get_tag(tag);
+		DataBuffer buffer = aes_gcm_encrypt.get_data();
+		if (buffer.get_size() != expected.get_size())
+			fail();
+		if (memcmp(buffer.get_data(), expected.get_data(), expected.get_size()))
+			fail();
+		if (memcmp(tag, expected_tag, AES_GCM_Encrypt::tag_size))
+			fail();
+	}
+
+	// Any modification must be detected
+	for (int modification = 0; modification < 3; modification++)
+	{
+		std::vector<unsigned char> aad(test_data.begin(), test_data.begin() + 77);
+		std::vector<unsigned char> ciphertext((unsigned char *)expected.get_data(), (unsigned char *)expected.get_data() + expected.get_size());
+		unsigned char tag[AES_GCM_Encrypt::tag_size];
+		memcpy(tag, expected_tag, AES_GCM_Encrypt::tag_size);
+
+		if (modification == 0)
+			aad[10] ^= 1;
+		else if (modification == 1)
+			ciphertext[500] ^= 0x80;
+		else
+			tag[15] ^= 1;
+
+		AES_GCM_Decrypt aes_gcm_decrypt;
+		aes_gcm_decrypt.set_key(&key[0], key.size());
+		aes_gcm_decrypt.set_iv(&iv[0], iv.size());
+		aes_gcm_decrypt.add_aad(&aad[0], aad.size());
+		aes_gcm_decrypt.add(&ciphertext[0], ciphertext.size());
+		if (aes_gcm_decrypt.calculate(tag))
+			fail();
+	}
+}
+
+void TestApp::test_aes_gcm_helper(const char *key_ptr, const char *iv_ptr, const char *aad_ptr, const char *plaintext_ptr, const char *ciphertext_ptr, const char *tag_ptr)
+{
+	std::vector<unsigned char> key;
+	std::vector<unsigned char> iv;
+	std::vector<unsigned char> aad;
+	std::vector<unsigned char> plaintext;
+	std::vector<unsigned char> ciphertext;
+	std::vector<unsigned char> tag;
+
+	convert_ascii(key_ptr, key);
+	convert_ascii(iv_ptr, iv);
+	convert_ascii(aad_ptr, aad);
+	convert_ascii(plaintext_ptr, plaintext);
+	convert_ascii(ciphertext_ptr, ciphertext);
+	convert_ascii(tag_ptr, tag);
+
+	AES_GCM_Encrypt aes_gcm_encrypt;
+	aes_gcm_encrypt.set_key(&key[0], key.size());
+	aes_gcm_encrypt.set_iv(&iv[0], iv.size());
+	if (!aad.empty())
+		aes_gcm_encrypt.add_aad(&aad[0], aad.size());
+	aes_gcm_encrypt.add(&plaintext[0], plaintext.size());
+	aes_gcm_encrypt.calculate();
+
+	DataBuffer buffer = aes_gcm_encrypt.get_data();
+	if (buffer.get_size() != ciphertext.size())
+		fail();
+	if (memcmp(buffer.get_data(), &ciphertext[0], ciphertext.size()))
+		fail();
+	unsigned char calculated_tag[AES_GCM_Encrypt::tag_size];
+	aes_gcm_encrypt.get_tag(calculated_tag);
+	if (memcmp(calculated_tag, &tag[0], AES_GCM_Encrypt::tag_size))
+		fail();
+
+	AES_GCM_Decrypt aes_gcm_decrypt;
+	aes_gcm_decrypt.set_key(&key[0], key.size());
+	aes_gcm_decrypt.set_iv(&iv[0], iv.size());
+	if (!aad.empty())
+		aes_gcm_decrypt.add_aad(&aad[0], aad.size());
+	aes_gcm_decrypt.add(&ciphertext[0], ciphertext.size());
+	if (!aes_gcm_decrypt.calculate(&tag[0]))
+		fail();
+	DataBuffer buffer2 = aes_gcm_decrypt.get_data();
+	if (buffer2.get_size() != plaintext.size())
+		fail();
+	if (memcmp(buffer2.get_data(), &plaintext[0], plaintext.size()))
+		fail();
+}
@@ -0,0 +1,148 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	void print_throughput(const char *name, uint64_t start, uint64_t end, int size, int iterations)
+	{
+		double seconds = max(end - start, (uint64_t)1) / 1000000.0;
+		double megabytes = (double)size * iterations / (1024.0 * 1024.0);
+		Console::write_line("   %1: %2 MB/s", name, (int)(megabytes / seconds));
+	}
+}
+
+void TestApp::test_aes_throughput()
+{
+	Console::write_line(" AES throughput (AES-NI %1, PCLMULQDQ %2)",
+		System::detect_cpu_extension(System::aes) ? "available" : "not available",
+		System::detect_cpu_extension(System::pclmul) ? "available" : "not available");
+
+	const int size = 4 * 1024 * 1024;
+	const int iterations = 4;
+	std::vector<unsigned char> data(size);
+	for (int cnt = 0; cnt < size; cnt++)
+		data[cnt] = (unsigned char)cnt;
+
+	unsigned char key[32];
+	unsigned char iv[16];
+	for (int cnt = 0; cnt < 32; cnt++)
+		key[cnt] = (unsigned char)(cnt * 3);
+	for (int cnt = 0; cnt < 16; cnt++)
+		iv[cnt] = (unsigned char)(cnt * 5);
+
+	DataBuffer ciphertext;
+	uint64_t start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		AES128_Encrypt aes128_encrypt;
+		aes128_encrypt.set_iv(iv);
+		aes128_encrypt.set_key(key);
+		aes128_encrypt.add(&data[0], size);
+		aes128_encrypt.calculate();
+		ciphertext = aes128_encrypt.get_data();
+	}
+	print_throughput("AES-128 CBC encrypt", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		AES128_Decrypt aes128_decrypt;
+		aes128_decrypt.set_iv(iv);
+		aes128_decrypt.set_key(key);
+		aes128_decrypt.add(ciphertext);
+		if (!aes128_decrypt.calculate())
+			fail();
+		if (aes128_decrypt.get_data().get_size() != size)
+			fail();
+	}
+	print_throughput("AES-128 CBC decrypt", start, System::get_microseconds(), size, iterations);
+
+	AES256_Encrypt aes256_encrypt;
+	aes256_encrypt.set_iv(iv);
+	aes256_encrypt.set_key(key);
+	aes256_encrypt.add(&data[0], size);
+	aes256_encrypt.calculate();
+	ciphertext = aes256_encrypt.get_data();
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		AES256_Decrypt aes256_decrypt;
+		aes256_decrypt.set_iv(iv);
+		aes256_decrypt.set_key(key);
+		aes256_decrypt.add(ciphertext);
+		if (!aes256_decrypt.calculate())
+			fail();
+		if (memcmp(aes256_decrypt.get_data().get_data(), &data[0], size))
+			fail();
+	}
+	print_throughput("AES-256 CBC decrypt", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		AES_CTR aes_ctr;
+		aes_ctr.set_key(key, 16);
+		aes_ctr.set_iv(iv);
+		aes_ctr.add(&data[0], size);
+		if (aes_ctr.get_data().get_size() != size)
+			fail();
+	}
+	print_throughput("AES-128 CTR", start, System::get_microseconds(), size, iterations);
+
+	AES_GCM_Encrypt aes_gcm_encrypt;
+	aes_gcm_encrypt.set_key(key, 16);
+	unsigned char tag[AES_GCM_Encrypt::tag_size];
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		aes_gcm_encrypt.set_iv(iv);
+		aes_gcm_encrypt.add(&data[0], size);
+		aes_gcm_encrypt.calculate();
+		aes_gcm_encrypt.get_tag(tag);
+	}
+	print_throughput("AES-128 GCM encrypt", start, System::get_microseconds(), size, iterations);
+
+	AES_GCM_Decrypt aes_gcm_decrypt;
+	aes_gcm_decrypt.set_key(key, 16);
+	ciphertext = aes_gcm_encrypt.get_data();
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		aes_gcm_decrypt.set_iv(iv);
+		aes_gcm_decrypt.add(ciphertext);
+		if (!aes_gcm_decrypt.calculate(tag))
+			fail();
+	}
+	print_throughput("AES-128 GCM decrypt", start, System::get_microseconds(), size, iterations);
+	if (memcmp(aes_gcm_decrypt.get_data().get_data(), &data[0], size))
+		fail();
+}
@@ -118,6 +118,38 @@ void TestApp::test_rsa()
 	if (memcmp(server.m_CryptKey.get_data(), client.m_CryptKey.get_data(), server.m_CryptKey.get_size()))
 		fail();
 
+	Console::write_line("   ... Running Test (Chinese remainder theorem)");
+
+	Random random;
+	Secret private_exponent, prime1, prime2, exponent1, exponent2, coefficient;
+	DataBuffer public_exponent, modulus;
+	RSA::create_keypair(random, private_exponent, prime1, prime2, exponent1, exponent2, coefficient, public_exponent, modulus, 2048);
+
+	Secret message(32);
+	random.get_random_bytes(message.get_data(), message.get_size());
+	DataBuffer encrypted = RSA::encrypt(2, random, public_exponent, modulus, message);
+
+	Secret decrypted = RSA::decrypt(private_exponent, modulus, encrypted);
+	Secret decrypted_crt = RSA::decrypt(prime1, prime2, exponent1, exponent2, coefficient, modulus, encrypted);
+	if (decrypted.get_size() != message.get_size() || decrypted_crt.get_size() != message.get_size())
+		fail();
+	if (memcmp(decrypted.get_data(), message.get_data(), message.get_size()))
+		fail();
+	if (memcmp(decrypted_crt.get_data(), message.get_data(), message.get_size()))
+		fail();
+
+	const int iterations = 10;
+	uint64_t start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+		RSA::decrypt(private_exponent, modulus, encrypted);
+	uint64_t time_plain = System::get_microseconds() - start;
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+		RSA::decrypt(prime1, prime2, exponent1, exponent2, coefficient, modulus, encrypted);
+	uint64_t time_crt = System::get_microseconds() - start;
+
+	Console::write_line("   ... 2048 bit decrypt: %1 us, with primes: %2 us", (int)(time_plain / iterations), (int)(time_crt / iterations));
 }
 
 
@@ -0,0 +1,197 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	void sha256_of(const std::vector<unsigned char> &data, unsigned char out_hash[32])
+	{
+		SHA256 sha256;
+		sha256.add(data.data(), data.size());
+		sha256.calculate();
+		sha256.get_hash(out_hash);
+	}
+
+	// Straightforward recursive definition of the tree hash to compare against
+	void reference_tree_hash(const unsigned char *data, int64_t size, unsigned char out_hash[32])
+	{
+		if (size <= TreeHash::chunk_size)
+		{
+			std::vector<unsigned char> leaf(data, data + size);
+			leaf.push_back(0x00);
+			sha256_of(leaf, out_hash);
+			return;
+		}
+
+		int64_t left_size = TreeHash::chunk_size;
+		while (left_size * 2 < size)
+			left_size *= 2;
+
+		std::vector<unsigned char> parent(65);
+		reference_tree_hash(data, left_size, &parent[0]);
+		reference_tree_hash(data + left_size, size - left_size, &parent[32]);
+		parent[64] = 0x01;
+		sha256_of(parent, out_hash);
+	}
+
+	void print_throughput(const char *name, uint64_t start, uint64_t end, int64_t size, int iterations)
+	{
+		double seconds = max(end - start, (uint64_t)1) / 1000000.0;
+		double gigabytes = (double)size * iterations / (1024.0 * 1024.0 * 1024.0);
+		Console::write_line("   %1: %2 GB/s", name, string_format("%1", gigabytes / seconds));
+	}
+}
+
+void TestApp::test_tree_hash()
+{
+	Console::write_line(" Header: tree_hash.h");
+	Console::write_line("  Class: TreeHash");
+
+	WorkQueue work_queue(work_queue_stealing);
+	WorkQueue single_thread(work_queue_stealing, 1);
+
+	std::vector<unsigned char> data(37 * TreeHash::chunk_size + 123);
+	for (size_t cnt = 0; cnt < data.size(); cnt++)
+		data[cnt] = (unsigned char)(cnt * 7 + (cnt >> 11));
+
+	const int64_t sizes[] = { 0, 100, TreeHash::chunk_size, TreeHash::chunk_size + 1, 3 * TreeHash::chunk_size + 5, 8 * TreeHash::chunk_size, (int64_t)data.size() };
+	for (int64_t size : sizes)
+	{
+		unsigned char expected[TreeHash::hash_size];
+		reference_tree_hash(data.data(), size, expected);
+
+		unsigned char hash[TreeHash::hash_size];
+		TreeHash tree_hash(work_queue);
+		tree_hash.add(data.data(), size);
+		tree_hash.calculate();
+		tree_hash.get_hash(hash);
+		if (memcmp(hash, expected, TreeHash::hash_size))
+			fail();
+
+		// The result must not depend on the number of threads or the size of the pieces added
+		TreeHash pieces(single_thread);
+		int64_t pos = 0;
+		for (int piece = 1; pos < size; piece = piece * 3 + 1)
+		{
+			int64_t piece_size = min((int64_t)piece, size - pos);
+			pieces.add(data.data() + pos, piece_size);
+			pos += piece_size;
+		}
+		pieces.calculate();
+		if (pieces.get_hash() != tree_hash.get_hash())
+			fail();
+	}
+
+	// A hash can be reused after calculate
+	TreeHash tree_hash(work_queue);
+	tree_hash.add(data.data(), 100);
+	tree_hash.calculate();
+	std::string hash_100 = tree_hash.get_hash();
+	tree_hash.add(data.data(), 100);
+	tree_hash.calculate();
+	if (tree_hash.get_hash() != hash_100 || tree_hash.get_hash(true) != StringHelp::text_to_upper(hash_100))
+		fail();
+
+	Console::write_line("   Function: add(IODevice &), add_file()");
+	DataBuffer buffer(data.data(), data.size());
+	tree_hash.add(buffer);
+	tree_hash.calculate();
+	std::string expected_hash = tree_hash.get_hash();
+
+	MemoryDevice device(buffer);
+	tree_hash.add(device);
+	tree_hash.calculate();
+	if (tree_hash.get_hash() != expected_hash)
+		fail();
+
+	std::string filename = "test_tree_hash.tmp";
+	File::write_bytes(filename, buffer);
+	tree_hash.add_file(filename);
+	tree_hash.calculate();
+	FileHelp::delete_file(filename);
+	if (tree_hash.get_hash() != expected_hash)
+		fail();
+
+	Console::write_line(" Hash throughput (SHA-NI %1, AVX2 %2, %3 cores)",
+		System::detect_cpu_extension(System::sha) ? "available" : "not available",
+		System::detect_cpu_extension(System::avx2) ? "available" : "not available",
+		System::get_num_cores());
+
+	const int64_t size = 64 * 1024 * 1024;
+	const int iterations = 4;
+	data.resize(size);
+	for (int64_t cnt = 0; cnt < size; cnt++)
+		data[cnt] = (unsigned char)(cnt * 7);
+
+	uint64_t start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		SHA1 sha1;
+		sha1.add(data.data(), size);
+		sha1.calculate();
+	}
+	print_throughput("SHA-1", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		SHA256 sha256;
+		sha256.add(data.data(), size);
+		sha256.calculate();
+	}
+	print_throughput("SHA-256", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		SHA512 sha512;
+		sha512.add(data.data(), size);
+		sha512.calculate();
+	}
+	print_throughput("SHA-512", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		TreeHash tree_hash(single_thread);
+		tree_hash.add(data.data(), size);
+		tree_hash.calculate();
+	}
+	print_throughput("Tree hash, 1 thread", start, System::get_microseconds(), size, iterations);
+
+	start = System::get_microseconds();
+	for (int i = 0; i < iterations; i++)
+	{
+		TreeHash tree_hash(work_queue);
+		tree_hash.add(data.data(), size);
+		tree_hash.calculate();
+	}
+	print_throughput("Tree hash, all threads", start, System::get_microseconds(), size, iterations);
+}
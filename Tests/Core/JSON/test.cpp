@@ -0,0 +1,241 @@
+
+#include "test.h"
+
+// Tests for JsonReader, JsonWriter and JsonValue.
+//
+// Also times parsing and scanning of a generated document of a few megabytes.
+
+// Write only device remembering the size of each write
+class RecordingDevice : public IODeviceProvider
+{
+public:
+	RecordingDevice(std::vector<size_t> &writes) : writes(writes) { }
+
+	size_t get_size() const override { return position; }
+	size_t get_position() const override { return position; }
+	size_t receive(void *, size_t, bool) override { throw Exception("Write-only device"); }
+	size_t peek(void *, size_t) override { throw Exception("Peek not supported"); }
+	IODeviceProvider *duplicate() override { return new RecordingDevice(writes); }
+
+	size_t send(const void *, size_t len, bool) override
+	{
+		writes.push_back(len);
+		position += len;
+		return len;
+	}
+
+private:
+	std::vector<size_t> &writes;
+	size_t position = 0;
+};
+
+void TestApp::test_round_trip()
+{
+	std::string json = "{ \"name\": \"caf\\u00e9 \\\"quoted\\\"\\n\", \"list\": [1, -2.5, 1e3, true, false, null, [], {}], \"emoji\": \"\\ud83d\\ude00\" }";
+	JsonValue value = JsonValue::parse(json);
+
+	if (value["name"].to_string() != "caf\xc3\xa9 \"quoted\"\n")
+		fail("escaped string");
+	if (value["list"].size() != 8)
+		fail("array size");
+	if (value["list"][1].to_number() != -2.5)
+		fail("negative number");
+	if (value["list"][2].to_number() != 1000.0)
+		fail("exponent");
+	if (!(value["list"][3].to_boolean() && !value["list"][4].to_boolean()))
+		fail("booleans");
+	if (!value["list"][5].is_null())
+		fail("null");
+	if (!(value["list"][6].is_array() && value["list"][7].is_object()))
+		fail("empty containers");
+	if (value["emoji"].to_string() != "\xf0\x9f\x98\x80")
+		fail("surrogate pair");
+
+	std::string written = value.to_json();
+	if (written != "{\"emoji\":\"\xf0\x9f\x98\x80\",\"list\":[1,-2.5,1000,true,false,null,[],{}],\"name\":\"caf\xc3\xa9 \\\"quoted\\\"\\n\"}")
+		fail("to_json output");
+	if (JsonValue::parse(written).to_json() != written)
+		fail("parse of to_json output");
+
+	JsonValue fraction = JsonValue::number(0.1);
+	if (JsonValue::parse(fraction.to_json()).to_number() != 0.1)
+		fail("fraction survives a round trip");
+}
+
+void TestApp::test_errors()
+{
+	const char *bad[] = { "", "{", "[1,]", "{\"a\" 1}", "[1 2]", "\"unterminated", "tru", "{\"a\":1}}" };
+	for (auto text : bad)
+	{
+		bool thrown = false;
+		try
+		{
+			JsonReader reader(text, strlen(text));
+			while (reader.next() != JsonToken::end)
+			{
+			}
+			if (*text == 0)
+				JsonValue::parse(text);
+		}
+		catch (JsonException &)
+		{
+			thrown = true;
+		}
+		if (!thrown)
+			fail(text);
+	}
+}
+
+void TestApp::test_reader()
+{
+	std::string json = "{\"skip\":{\"a\":[1,2,{\"b\":3}]},\"keep\":\"plain\"} [4]";
+	JsonReader reader(json.data(), json.size());
+
+	if (reader.next() != JsonToken::begin_object)
+		fail("begin object");
+	if (reader.next() != JsonToken::property_name || reader.get_string() != "skip")
+		fail("property name");
+	reader.skip_value();
+	if (reader.get_token() != JsonToken::end_object || reader.get_depth() != 1)
+		fail("skip value");
+	if (reader.next() != JsonToken::property_name || reader.get_string() != "keep")
+		fail("next property");
+	if (reader.next() != JsonToken::string)
+		fail("string token");
+	if (!(reader.get_text() >= json.data() && reader.get_text() < json.data() + json.size()))
+		fail("unescaped string is not copied");
+	if (reader.next() != JsonToken::end_object || reader.get_depth() != 0)
+		fail("end object");
+
+	JsonValue second = JsonValue::parse(reader);
+	if (!second.is_array() || second.at(0).to_int() != 4)
+		fail("second top level value");
+	if (reader.next() != JsonToken::end)
+		fail("end of input");
+}
+
+static std::string create_document(int count)
+{
+	std::string json;
+	JsonWriter writer(json);
+	writer.begin_array();
+	for (int i = 0; i < count; i++)
+	{
+		writer.begin_object();
+		writer.write_property_name("id");
+		writer.write_number(i);
+		writer.write_property_name("position");
+		writer.begin_array();
+		writer.write_number(i * 0.25);
+		writer.write_number(-i * 1.5);
+		writer.end_array();
+		writer.write_property_name("description");
+		writer.write_string(std::string(i % 200, 'x') + "\t\"tail\"");
+		writer.end_object();
+	}
+	writer.end_array();
+	return json;
+}
+
+void TestApp::test_streaming()
+{
+	const int count = 20000;
+	std::string json = create_document(count);
+
+	// The document is several times larger than the read chunk size, so tokens cross chunk boundaries
+	DataBuffer data(json.data(), json.size());
+	MemoryDevice device(data);
+	JsonValue value = JsonValue::parse(device);
+	if (value.size() != count)
+		fail("streamed document size");
+	if (value.at(count - 1)["id"].to_int() != count - 1)
+		fail("last element");
+	if (value.at(count - 1)["description"].to_string() != std::string((count - 1) % 200, 'x') + "\t\"tail\"")
+		fail("string across chunks");
+
+	DataBuffer output;
+	MemoryDevice output_device(output);
+	{
+		JsonWriter writer(output_device);
+		writer.write_value(value);
+	}
+	if (std::string(output_device.get_data().get_data(), output_device.get_data().get_size()) != value.to_json())
+		fail("streaming writer output");
+
+	// A value tree is written through to the device while it is being written, not in one piece at the end.
+	// The strings of a flat array leave no nested container ends to flush at.
+	JsonValue strings = JsonValue::array();
+	for (int i = 0; i < count; i++)
+		strings.items().push_back(JsonValue::string(std::string(i % 200, 'x')));
+
+	std::vector<size_t> writes;
+	{
+		IODevice recording_device(new RecordingDevice(writes));
+		JsonWriter writer(recording_device, 4096);
+		writer.write_value(strings);
+		if (writes.size() < 2)
+			fail("streaming writer flushes inside a value tree");
+	}
+	size_t total = 0;
+	for (size_t size : writes)
+	{
+		if (size > 4096 + 1024)
+			fail("streaming writer flushes after each element");
+		total += size;
+	}
+	if (total != strings.to_json().size())
+		fail("streaming writer writes the whole value tree");
+}
+
+static void benchmark()
+{
+	std::string json = create_document(100000);
+
+	uint64_t start = System::get_microseconds();
+	JsonValue value = JsonValue::parse(json);
+	uint64_t parsed = System::get_microseconds();
+
+	JsonReader reader(json.data(), json.size());
+	size_t tokens = 0;
+	while (reader.next() != JsonToken::end)
+		tokens++;
+	uint64_t scanned = System::get_microseconds();
+
+	std::string written = value.to_json();
+	uint64_t finished = System::get_microseconds();
+
+	double megabytes = json.size() / (1024.0 * 1024.0);
+	Console::write_line("%1 MB: JsonValue::parse %2 ms, JsonReader %3 ms (%4 tokens), to_json %5 ms",
+		megabytes, (parsed - start) / 1000.0, (scanned - parsed) / 1000.0, (int)tokens, (finished - scanned) / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	try
+	{
+		test_round_trip();
+		test_errors();
+		test_reader();
+		test_streaming();
+		benchmark();
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	Console::write_line("All tests passed");
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <cmath>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_round_trip();
+	void test_errors();
+	void test_reader();
+	void test_streaming();
+public:
+	void fail(const char *description) const;
+};
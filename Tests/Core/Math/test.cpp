@@ -56,6 +56,7 @@ int TestApp::main()
 		Console::write_line("Directory: API/Core/Math");
 
 		test_bigint();
+		test_bigint_exptmod();
 		test_angle();
 		test_quaternion_f();
 		test_quaternion_d();
@@ -71,6 +72,7 @@ int TestApp::main()
 		test_line_segment3();
 		test_triangle();
 		test_rect();
+		test_batch_math();
 	
 		Console::write_line("All Tests Complete");
 		console.display_close_message();
@@ -0,0 +1,318 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	class TestRandom
+	{
+	public:
+		float next(float min_value, float max_value)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			return min_value + (max_value - min_value) * ((seed >> 8) / 16777216.0f);
+		}
+
+		Vec3f next_vec3(float min_value, float max_value)
+		{
+			float x = next(min_value, max_value);
+			float y = next(min_value, max_value);
+			float z = next(min_value, max_value);
+			return Vec3f(x, y, z);
+		}
+
+		Quaternionf next_quaternion()
+		{
+			Quaternionf q(next(-1.0f, 1.0f), next(-1.0f, 1.0f), next(-1.0f, 1.0f), next(-1.0f, 1.0f));
+			q.normalize();
+			return q;
+		}
+
+	private:
+		uint32_t seed = 12345;
+	};
+
+	bool is_close(const Vec4f &a, const Vec4f &b, float epsilon)
+	{
+		float scale = max(1.0f, max(max(std::abs(b.x), std::abs(b.y)), max(std::abs(b.z), std::abs(b.w))));
+		return std::abs(a.x - b.x) <= epsilon * scale && std::abs(a.y - b.y) <= epsilon * scale && std::abs(a.z - b.z) <= epsilon * scale && std::abs(a.w - b.w) <= epsilon * scale;
+	}
+
+	bool is_close(const Quaternionf &a, const Quaternionf &b, float epsilon)
+	{
+		return std::abs(a.x - b.x) <= epsilon && std::abs(a.y - b.y) <= epsilon && std::abs(a.z - b.z) <= epsilon && std::abs(a.w - b.w) <= epsilon;
+	}
+
+	bool mask_bit(const std::vector<uint32_t> &mask, size_t index)
+	{
+		return (mask[index / 32] & (1u << (index % 32))) != 0;
+	}
+
+	FrustumPlanes test_frustum()
+	{
+		Mat4f projection = Mat4f::perspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f, handed_left, clip_negative_positive_w);
+		Mat4f view = Mat4f::look_at(Vec3f(3.0f, 2.0f, -10.0f), Vec3f(0.0f, 0.0f, 0.0f), Vec3f(0.0f, 1.0f, 0.0f));
+		return FrustumPlanes(projection * view);
+	}
+}
+
+void TestApp::test_batch_math()
+{
+	Console::write_line(" Header: batch_math.h");
+	Console::write_line("  Class: BatchMath");
+
+	TestRandom random;
+	const size_t count = 100003;
+
+	Mat4f matrix = Mat4f::perspective(60.0f, 1.5f, 0.1f, 100.0f, handed_left, clip_negative_positive_w) * Mat4f::look_at(1.0f, 2.0f, -5.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+
+	std::vector<Vec3f> points(count);
+	std::vector<Vec4f> points4(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		points[i] = random.next_vec3(-50.0f, 50.0f);
+		points4[i] = Vec4f(points[i], random.next(0.5f, 2.0f));
+	}
+
+	Console::write_line("   Function: transform_points()");
+	{
+		std::vector<Vec4f> result(count);
+		for (size_t n = 0; n < 20; n++)
+		{
+			BatchMath::transform_points(matrix, points.data(), result.data(), n);
+			for (size_t i = 0; i < n; i++)
+			{
+				if (!is_close(result[i], matrix * Vec4f(points[i], 1.0f), 1e-5f))
+					fail();
+			}
+		}
+
+		BatchMath::transform_points(matrix, points.data(), result.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!is_close(result[i], matrix * Vec4f(points[i], 1.0f), 1e-5f))
+				fail();
+		}
+
+		// In place
+		result = points4;
+		BatchMath::transform_points(matrix, result.data(), result.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!is_close(result[i], matrix * points4[i], 1e-5f))
+				fail();
+		}
+	}
+
+	FrustumPlanes frustum = test_frustum();
+
+	std::vector<AxisAlignedBoundingBox> aabbs(count);
+	std::vector<OrientedBoundingBox> obbs(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Vec3f center = random.next_vec3(-60.0f, 60.0f);
+		Vec3f extents = random.next_vec3(0.1f, 5.0f);
+		aabbs[i] = AxisAlignedBoundingBox(center - extents, center + extents);
+
+		Quaternionf rotation = random.next_quaternion();
+		obbs[i].center = center;
+		obbs[i].extents = extents;
+		obbs[i].axis_x = rotation.rotate_vector(Vec3f(1.0f, 0.0f, 0.0f));
+		obbs[i].axis_y = rotation.rotate_vector(Vec3f(0.0f, 1.0f, 0.0f));
+		obbs[i].axis_z = rotation.rotate_vector(Vec3f(0.0f, 0.0f, 1.0f));
+	}
+
+	Console::write_line("   Function: frustum_aabb()");
+	{
+		std::vector<uint32_t> visible((count + 31) / 32, 0xffffffff), inside((count + 31) / 32, 0xffffffff);
+		BatchMath::frustum_aabb(frustum, aabbs.data(), count, visible.data(), inside.data());
+
+		int num_outside = 0, num_inside = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			IntersectionTest::Result result = IntersectionTest::frustum_aabb(frustum, aabbs[i]);
+			if (mask_bit(visible, i) != (result != IntersectionTest::outside))
+				fail();
+			if (mask_bit(inside, i) != (result == IntersectionTest::inside))
+				fail();
+			num_outside += (result == IntersectionTest::outside) ? 1 : 0;
+			num_inside += (result == IntersectionTest::inside) ? 1 : 0;
+		}
+		if (num_outside == 0 || num_inside == 0 || num_outside + num_inside == count)
+			fail();
+
+		for (size_t i = count; i < visible.size() * 32; i++)
+		{
+			if (mask_bit(visible, i) || mask_bit(inside, i))
+				fail();
+		}
+
+		for (size_t n = 0; n < 40; n++)
+		{
+			BatchMath::frustum_aabb(frustum, aabbs.data(), n, visible.data());
+			for (size_t i = 0; i < n; i++)
+			{
+				if (mask_bit(visible, i) != (IntersectionTest::frustum_aabb(frustum, aabbs[i]) != IntersectionTest::outside))
+					fail();
+			}
+		}
+	}
+
+	Console::write_line("   Function: frustum_obb()");
+	{
+		std::vector<uint32_t> visible((count + 31) / 32), inside((count + 31) / 32);
+		BatchMath::frustum_obb(frustum, obbs.data(), count, visible.data(), inside.data());
+		for (size_t i = 0; i < count; i++)
+		{
+			IntersectionTest::Result result = IntersectionTest::frustum_obb(frustum, obbs[i]);
+			if (mask_bit(visible, i) != (result != IntersectionTest::outside))
+				fail();
+			if (mask_bit(inside, i) != (result == IntersectionTest::inside))
+				fail();
+		}
+	}
+
+	std::vector<Quaternionf> initial(count), final(count);
+	std::vector<float> times(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		initial[i] = random.next_quaternion();
+		times[i] = random.next(0.0f, 1.0f);
+		switch (i % 4)
+		{
+		case 0: // Close enough for linear interpolation
+			final[i] = Quaternionf(initial[i].w + 0.01f, initial[i].i, initial[i].j - 0.01f, initial[i].k);
+			final[i].normalize();
+			break;
+		case 1: // Opposite hemisphere
+			final[i] = Quaternionf(-initial[i].w, -initial[i].i + 0.5f, -initial[i].j, -initial[i].k);
+			final[i].normalize();
+			break;
+		default:
+			final[i] = random.next_quaternion();
+			break;
+		}
+	}
+
+	Console::write_line("   Function: slerp()");
+	{
+		std::vector<Quaternionf> result(count);
+		BatchMath::slerp(initial.data(), final.data(), times.data(), result.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!is_close(result[i], Quaternionf::slerp(initial[i], final[i], times[i]), 2e-5f))
+				fail();
+		}
+
+		BatchMath::slerp(initial.data(), final.data(), 0.25f, result.data(), count);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!is_close(result[i], Quaternionf::slerp(initial[i], final[i], 0.25f), 2e-5f))
+				fail();
+		}
+
+		for (size_t n = 0; n < 20; n++)
+		{
+			result.assign(initial.begin(), initial.begin() + n);
+			BatchMath::slerp(result.data(), final.data(), times.data(), result.data(), n);
+			for (size_t i = 0; i < n; i++)
+			{
+				if (!is_close(result[i], Quaternionf::slerp(initial[i], final[i], times[i]), 2e-5f))
+					fail();
+			}
+		}
+	}
+
+	Console::write_line("   Benchmark: scalar and batch (%1 elements)", (int)count);
+	{
+		const int iterations = 20;
+		std::vector<Vec4f> result(count);
+		std::vector<Quaternionf> result_quaternions(count);
+		std::vector<uint32_t> visible((count + 31) / 32);
+
+		uint64_t start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+		{
+			for (size_t i = 0; i < count; i++)
+				result[i] = matrix * Vec4f(points[i], 1.0f);
+		}
+		uint64_t scalar_time = System::get_microseconds() - start;
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+			BatchMath::transform_points(matrix, points.data(), result.data(), count);
+		uint64_t batch_time = System::get_microseconds() - start;
+		Console::write_line("    transform_points: %1 us scalar, %2 us batch", (int)(scalar_time / iterations), (int)(batch_time / iterations));
+
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (IntersectionTest::frustum_aabb(frustum, aabbs[i]) != IntersectionTest::outside)
+					visible[i / 32] |= 1u << (i % 32);
+			}
+		}
+		scalar_time = System::get_microseconds() - start;
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+			BatchMath::frustum_aabb(frustum, aabbs.data(), count, visible.data());
+		batch_time = System::get_microseconds() - start;
+		Console::write_line("    frustum_aabb: %1 us scalar, %2 us batch", (int)(scalar_time / iterations), (int)(batch_time / iterations));
+
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (IntersectionTest::frustum_obb(frustum, obbs[i]) != IntersectionTest::outside)
+					visible[i / 32] |= 1u << (i % 32);
+			}
+		}
+		scalar_time = System::get_microseconds() - start;
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+			BatchMath::frustum_obb(frustum, obbs.data(), count, visible.data());
+		batch_time = System::get_microseconds() - start;
+		Console::write_line("    frustum_obb: %1 us scalar, %2 us batch", (int)(scalar_time / iterations), (int)(batch_time / iterations));
+
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+		{
+			for (size_t i = 0; i < count; i++)
+				result_quaternions[i] = Quaternionf::slerp(initial[i], final[i], times[i]);
+		}
+		scalar_time = System::get_microseconds() - start;
+		start = System::get_microseconds();
+		for (int j = 0; j < iterations; j++)
+			BatchMath::slerp(initial.data(), final.data(), times.data(), result_quaternions.data(), count);
+		batch_time = System::get_microseconds() - start;
+		Console::write_line("    slerp: %1 us scalar, %2 us batch", (int)(scalar_time / iterations), (int)(batch_time / iterations));
+	}
+}
@@ -0,0 +1,241 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+
+namespace
+{
+	BigInt from_hex(const char *hex)
+	{
+		std::string text(hex);
+		if (text.length() % 2)
+			text = "0" + text;
+
+		std::vector<unsigned char> bytes;
+		for (size_t pos = 0; pos < text.length(); pos += 2)
+			bytes.push_back((unsigned char)strtoul(text.substr(pos, 2).c_str(), nullptr, 16));
+
+		BigInt value;
+		value.read_unsigned_octets(bytes.data(), bytes.size());
+		return value;
+	}
+
+	// Results calculated with Python: a = m // 3, pow(a, m - 2, m) and pow(a, 65537, m)
+	struct ExptmodVector
+	{
+		int bits;
+		const char *modulus;
+		const char *result_full_exponent;
+		const char *result_65537;
+	};
+
+	const ExptmodVector exptmod_vectors[] =
+	{
+		{
+			1056,
+			"bb3a6a06131db61884f42b4b548a84a5b43d43188b3890644f3d4e7b37d72e4af69787709d9b532aba4e6c3686ff0de26a7698065aab0a377f90ade7bc38d756"
+			"d0055979a2da95a83ec33dd6887e840043e58844c2354e2bb7740a63c1d8fac168fb90d7b938451ee325faa633406bc44dc2a627940eee3cba6f875c2e84496e"
+			"7857dd87",
+			"360bad16917a13152666c29f02c8f42473e672d7d8657b8842c5e9f88598930d23db30be3436d8e56a4f8285ca36e8abbe4af6a125ea7a380c1a95251b4bab7f"
+			"490d61e514cff143f94507e9b3fb6485a0058ad1ed55bd0c7ccaf1c6fc065a80d8909a8b47073ebeef4f4d3d6dd48290d1af0c266a290194019c7bc4147dd35d"
+			"ae454d2c",
+			"149ece7db0bf2998887242642a000a61fa0aa27b85b9518bb0cc1e04a27029c77bb28ea4a432dc7b05d7a8dba3198782827afff867396894ceb4c57bdbc4cca1"
+			"f3f8f9721d20bc3986ca27c4cfa8415ce3550977a10d6274e333c0ae1583b15e1873722be8df4eb1085511750dc7aa96486463695ffdcea8ac9bd7e771ccf696"
+			"40b3a5d7"
+		},
+		{
+			2048,
+			"ebc9e141b4852afbcdebefa791f68f88f5d93c67c5bc543b51b8a7af8171a4c3d80dad424245dc03dd8ba9d4f897181304f8c31cc30d0ea339a7ff57bffa0775"
+			"0a5d5bfe345986d33aa67f52682f860ede282d59e7b0dfa436cc71a5915405c0510323696a1510446d4337155352d63f337e6853cb2d34ea5865585254b1070f"
+			"63eb18aa53bdf64dc34797c42393446abe564059b9ae5c8f1fca7da27744001a6aa45fe0a0f09780597538cbc54be01c0ef8e010faaced226972f683de11ee00"
+			"366dadc088177abd25fbab1ba70b967adf354788d4dd79d3b5834f4cecb736d877f1caf0ba49c19fc0a9c8beb070e38434d57084ddfa7fa4ffe9ec11c63d5f77",
+			"debaf851b599561a7398ef160986479275832e45985775abb4e8f7ff5da4058588090379684b3f7ea7880cc27e61e7d037373368589f9e03025dc8ff72c77f6f"
+			"ccd62d0c91927256ed09253df052c2ddc9f2b4b2d02de2a1f0463b850e26e2dc9ca58ebb165a95451da3f4a6199ffe73fe30a59c74e329fea0bc16e565b5e0ee"
+			"7637b76856c6c9662d79d2b8e30c6be2dd7bf48431c214bad2da34e844062d135c1e918cbcab2d227c8d7dab500fb62f1783f4d08ce4cc283d96e8d105520f51"
+			"ee486e4e523f64bdc4fea5042a50fb89ba64f5122c9759c2f20d564d00670e1ad2bad14aa0feda9b8d64744c01514dd07588db9c3710f78f9e68b13c895ff9dc",
+			"d9aad3e96e6793385940d5e139843fe9ae288af8391ec5c90c56bfdb27e7d1e206a9c12e8f9d21655050e4c4398d308fed356c76f47835932bb08a1f07651d60"
+			"a0c7e752c2ae01a889d07d5066bbfc010bdc590ba496c37d6f5a8101859e8411eedd9ffb4eb17ec5c0e90e48624ea569b00be6d2c91f55d7bc1078aaa3b020ed"
+			"09b0a3cccf94aeb740eea9c502b07f01f897fe825d445907db15df3114d8ad82a02084b6f01970f6214aeff7fc30dc1b7b24b848da338a91f6c8736c3b7fb08c"
+			"93393ee55e6a7d84194df63f9f60316b75b4d0e4ff2dbda424ac8cd3d3ce371416362b8b19efc4ede372c0af559acaf1da26582441b37cb68285c13aba6d909e"
+		},
+		{
+			4096,
+			"810f5598f24a8cdc167edfdaec7ea1c99d6d1f17a28e6d2ae81b9fcc35d25ae0d45d1139f1f8665c201f0631848a58c50e46b5103ac3aeaf1e59552012c83c23"
+			"a22845d1f35b15bfb8703835bdcc489cefa65685608041f78b4e09dbad92c7d6ee99c03de6a2b384943014430bad1375ccbe3f3ee4337c1db3da03ffc0085a14"
+			"5ac7cd4d51e8217b39260d7ad9a4e1e983e89a8a2d16130c637b38b5c8c90052320862d1e4196f3537fbd4857ec6b10619c1ad8586fe0f194001c9e9bb373251"
+			"a95ee6299085ab8a22c1a23a4746df204d70bb5e4d26df2f12231373d7bd11c5337087006a373282f8d5f553a9f334346f9ed048e129131286111bad7b675e54"
+			"437cfbc79a094dea760ee1c3b1ee4a0a3d41c6df48c3fd37cd9201ff3215e84814d92cf93a81ea0b59ac4f533c55de74b42eddd27029d03d2691949ce65ddc49"
+			"011ae8e62c7a15bed7f35cebf0edeb0c1915ec2810c1525aafc3434b94bdca5e34f81895ecad86a154f1b97421cb664adc769927c48ff480b2122b13af1f7fa6"
+			"2b790602dc79e8e87707af4db6770b11ffc9492cb56211ccf0a737c355e3679f5656a72a9fa71a5963243c73430e07f524329a26a0cb0b17d625c18a9871d769"
+			"7e4ba5945e684f9633fddcd922d7bd7f5d9f348076da03a0febdf93a3c6fc1733b08c157c7c64d559b509fbea7193cf4d9f181ea54c4c0c31cae4e659d1a8c83",
+			"5b8e1886664a8994f796419e7af92cbe3c4e87475406a4cd0f0c17438ce58163151f6c51ed13210e37564db133e489797a76b680725f49a5366452e6f89e6609"
+			"155fc27d456e8537bf5ca3c943046f49f83277afbf698a8fe5bd9547e41bdb23ce3debc6686ae39a0005ae9f9f9c4fe3ad57c514051fdb6fde7a19e2c9b62c43"
+			"a2372e16727cb3d7b46688006908f6f6454373b57ee0fcf7cb845456c187600f77588beda57a6f87f9c463ff25a827e8b0531330cb2fc7facb4311d33219d6ad"
+			"a4e954a4c18f6aa526ae03ba9e2d33a4996721eaaadb476818c737e60299bb287146a322ac33e15ced9d26323bd951dd43378189d4d2a1db1628f622d1bf3b05"
+			"45fb212dc3d4c7aec0b35453339919ccdd3e069b1e8bf12e77d3484f1f15fb2fa9c61024e93797d4cccbd50d9b28f46817359ac26ba415b17e5bd3ac7bc2d400"
+			"fcb5de6f96da11785facbe5826834982a0cd24db4d0e81d1575ae2f983c049953beb8fb8c5ff7c6af01d0473bc71d88dbdf4eda7f6f65a9ba26ea85c15c3c8c9"
+			"9c21a88f988e0103cfac3a2bd5c43a1625ea264e99f71d8d88d2fcf70f618ea04a4dba8225657a3ec4fc70924a72005256067a8febab4356f2af5a52e41ca12a"
+			"239a72a21889fbb55b607a8f30f5f1a504bb228181d1810e025f7ced2385484f9be8ecb03fd0fdacee210913a779632be0f169008d547b3559944b156c0b107c",
+			"d3e0fdcb71cd5b4f9f884241d233de66b195c2af8f6892651efda8eb6d5151892c67d47132bfd061aee9dc438bc352c2c067bb23e335c83d752a54ef22b51040"
+			"ea03ce4568baf8faee2738d3dece3b0b9923e4baeb4ab1ee1428431d8565199e3b1c5d754c762da5587dcbb802da00980c35a2f8d870ea9dd4256bfaed945892"
+			"d5fbac76cadfb259f4fb63e557c9f99d742464922b1464cb92e3b09983bc10e7b36ca8024bba58af044d54cbd748c96bdc327fd92e0f02bd0ad156a1a175f893"
+			"b7de212e31c2bf1a351b38f81efd816884e640c7ee00f122e33e83c0c4cf7746d7e3905735ef49367edb33a1c213aea245e00ff46ec14e3fc1448d3a762acc87"
+			"4b9331590abb24d3c35f105f81e94bac3221c20b6beae997589a73443a2e6318be8b3ba52a935002a0792ca25bfc3786c7a08fbe56d5551d10cbc49a7c411d23"
+			"bee07962e74281f23029973e108bb6f419d896055a0e066c2611ddc612cb1ce110ca273a125db3fd96278d6d119dca8556f88d89ed392ede6512d275e6163e2b"
+			"41186df14cb0d1dfb189594fc02a11cb9200cfff3adf47ebf9235997cee99ae07e8c4b41989ef1b9907e2d35f5ce1f22a053762686ae0b1e695c35b17b2e2572"
+			"0e8fd64be41990dd001a333f62f683a0316939c0c13d6307d971a3240ccf2470e65680ec8a78b41f57de4475f397229e8caef93fd6efcf4471b6b2fc54a50ec"
+		}
+	};
+}
+
+void TestApp::test_bigint_exptmod()
+{
+	Console::write_line("   Function: exptmod()");
+	for (const auto &vector : exptmod_vectors)
+	{
+		BigInt modulus = from_hex(vector.modulus);
+		BigInt base = modulus / 3;
+		BigInt full_exponent = modulus - 2;
+		BigInt public_exponent((uint32_t)65537);
+		BigInt expected_full = from_hex(vector.result_full_exponent);
+		BigInt expected_65537 = from_hex(vector.result_65537);
+
+		BigInt result;
+		base.exptmod(&full_exponent, &modulus, &result);
+		if (result.cmp(&expected_full))
+			fail();
+		base.exptmod(&full_exponent, &modulus, &result, true);
+		if (result.cmp(&expected_full))
+			fail();
+		base.exptmod(&public_exponent, &modulus, &result);
+		if (result.cmp(&expected_65537))
+			fail();
+		base.exptmod(&public_exponent, &modulus, &result, true);
+		if (result.cmp(&expected_65537))
+			fail();
+
+		// A base several times wider than the modulus is reduced before the exponentiation
+		BigInt wide_base = modulus * modulus * modulus + base;
+		wide_base.exptmod(&public_exponent, &modulus, &result, true);
+		if (result.cmp(&expected_65537))
+			fail();
+		wide_base.exptmod(&public_exponent, &modulus, &result);
+		if (result.cmp(&expected_65537))
+			fail();
+	}
+
+	{
+		// Even modulus (Barrett reduction), zero exponent and a modulus of one
+		BigInt base((uint32_t)3), exponent((uint32_t)10), modulus((uint32_t)1000), result;
+		base.exptmod(&exponent, &modulus, &result);
+		uint32_t value;
+		result.get(value);
+		if (value != 49)
+			fail();
+
+		exponent.set((uint32_t)0);
+		modulus.set((uint32_t)7);
+		base.exptmod(&exponent, &modulus, &result, true);
+		result.get(value);
+		if (value != 1)
+			fail();
+
+		exponent.set((uint32_t)5);
+		modulus.set((uint32_t)1);
+		base.exptmod(&exponent, &modulus, &result);
+		result.get(value);
+		if (value != 0)
+			fail();
+	}
+
+	Console::write_line("   Function: operator * and sqr() (Karatsuba)");
+	{
+		BigInt a = from_hex(exptmod_vectors[2].modulus) / 3;
+		BigInt b = from_hex(exptmod_vectors[2].modulus) - 5;
+		BigInt c = from_hex(exptmod_vectors[1].modulus);
+
+		BigInt product = a * b;
+		BigInt quotient = product / a;
+		BigInt remainder = product % a;
+		if (quotient.cmp(&b) || remainder.cmp_z() != 0)
+			fail();
+
+		BigInt uneven = a * c;
+		quotient = uneven / c;
+		if (quotient.cmp(&a))
+			fail();
+
+		BigInt square_a, square_b, square_sum;
+		a.sqr(&square_a);
+		BigInt a_times_a = a * a;
+		if (square_a.cmp(&a_times_a))
+			fail();
+
+		// (a + b)^2 = a^2 + 2ab + b^2
+		b.sqr(&square_b);
+		BigInt sum = a + b;
+		sum.sqr(&square_sum);
+		BigInt expanded = square_a + square_b + product * 2;
+		if (square_sum.cmp(&expanded))
+			fail();
+	}
+
+	Console::write_line("   Benchmark: exptmod()");
+	for (const auto &vector : exptmod_vectors)
+	{
+		if (vector.bits < 2048)
+			continue;
+
+		BigInt modulus = from_hex(vector.modulus);
+		BigInt base = modulus / 3;
+		BigInt full_exponent = modulus - 2;
+		BigInt public_exponent((uint32_t)65537);
+		BigInt result;
+
+		const int iterations = vector.bits == 2048 ? 20 : 4;
+		uint64_t start = System::get_microseconds();
+		for (int i = 0; i < iterations; i++)
+			base.exptmod(&full_exponent, &modulus, &result);
+		uint64_t sliding_window = System::get_microseconds() - start;
+
+		start = System::get_microseconds();
+		for (int i = 0; i < iterations; i++)
+			base.exptmod(&full_exponent, &modulus, &result, true);
+		uint64_t constant_time = System::get_microseconds() - start;
+
+		const int public_iterations = iterations * 50;
+		start = System::get_microseconds();
+		for (int i = 0; i < public_iterations; i++)
+			base.exptmod(&public_exponent, &modulus, &result);
+		uint64_t public_time = System::get_microseconds() - start;
+
+		Console::write_line("    %1 bit: %2 ms (sliding window), %3 ms (constant time), %4 us (e = 65537)", vector.bits,
+			string_format("%1", sliding_window / 1000.0 / iterations), string_format("%1", constant_time / 1000.0 / iterations), (int)(public_time / public_iterations));
+	}
+}
@@ -1,7 +1,146 @@
-#include <ClanLib/core.h>
-using namespace clan;
+
+#include "test.h"
+
+static const char *algorithm_name(RectPacker::PackingAlgorithm algorithm)
+{
+	switch (algorithm)
+	{
+	case RectPacker::max_rects: return "max_rects";
+	case RectPacker::skyline: return "skyline";
+	default: return "guillotine";
+	}
+}
+
+static bool is_valid_packing(const std::vector<RectPacker::AllocatedRect> &rects, const Size &group_size)
+{
+	for (size_t i = 0; i < rects.size(); i++)
+	{
+		if (!Rect(Point(0, 0), group_size).is_inside(rects[i].rect))
+			return false;
+		for (size_t j = i + 1; j < rects.size(); j++)
+		{
+			if (rects[i].group_index == rects[j].group_index && rects[i].rect.is_overlapped(rects[j].rect))
+				return false;
+		}
+	}
+	return true;
+}
+
+static unsigned int next_random(unsigned int &seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static float FillGroup(RectPacker::PackingAlgorithm algorithm)
+{
+	RectPacker packer(Size(512, 512), RectPacker::fail_if_full, algorithm);
+	unsigned int seed = 777;
+	RectPacker::AllocatedRect rect(0, Rect());
+	int count = 0;
+	while (packer.try_add(Size(8 + next_random(seed) % 40, 16 + next_random(seed) % 16), rect))
+		count++;
+
+	std::cout << algorithm_name(algorithm) << ": " << count << " rects before the group was full, " << (int)(packer.get_packing_efficiency() * 100.0f) << "% efficiency" << std::endl;
+	return packer.get_packing_efficiency();
+}
+
+void TestApp::TestAlgorithm(RectPacker::PackingAlgorithm algorithm)
+{
+	const Size group_size(512, 512);
+	RectPacker packer(group_size, RectPacker::search_previous_groups, algorithm);
+
+	// Glyph-like sizes from a fixed seed so every algorithm gets the same input
+	unsigned int seed = 12345;
+	std::vector<RectPacker::AllocatedRect> rects;
+	for (int i = 0; i < 2000; i++)
+	{
+		int width = 8 + next_random(seed) % 40;
+		int height = 16 + next_random(seed) % 16;
+		rects.push_back(packer.add(Size(width, height)));
+	}
+	if (!is_valid_packing(rects, group_size))
+		fail("rects are inside their group and do not overlap");
+	if (packer.get_total_rect_count() != 2000)
+		fail("all rects are counted");
+
+	std::cout << algorithm_name(algorithm) << ": " << packer.get_group_count() << " groups, " << (int)(packer.get_packing_efficiency() * 100.0f) << "% efficiency" << std::endl;
+
+	// Release every other rect and fill the holes with rects of the same size
+	int groups_before = packer.get_group_count();
+	for (size_t i = 0; i < rects.size(); i += 2)
+		packer.remove(rects[i]);
+	if (packer.get_total_rect_count() != 1000)
+		fail("removed rects are no longer counted");
+	for (size_t i = 0; i < rects.size(); i += 2)
+		rects[i] = packer.add(rects[i].rect.get_size());
+	if (!is_valid_packing(rects, group_size))
+		fail("reused space does not overlap");
+	std::cout << algorithm_name(algorithm) << ": " << packer.get_group_count() << " groups after refilling released space" << std::endl;
+	if (algorithm != RectPacker::skyline)
+		if (!(packer.get_group_count() <= groups_before + 1))
+			fail("released space is reused");
+
+	// A full group can be emptied and refilled
+	RectPacker full(Size(256, 256), RectPacker::fail_if_full, algorithm);
+	std::vector<RectPacker::AllocatedRect> cells;
+	for (int i = 0; i < 16; i++)
+		cells.push_back(full.add(Size(64, 64)));
+	RectPacker::AllocatedRect extra(0, Rect());
+	if (full.try_add(Size(64, 64), extra))
+		fail("full group rejects more rects");
+	for (auto &cell : cells)
+		full.remove(cell);
+	if (full.get_used_area() != 0)
+		fail("empty group has no used area");
+	for (auto &cell : cells)
+		cell = full.add(Size(64, 64));
+	if (!is_valid_packing(cells, Size(256, 256)))
+		fail("refilled group is valid");
+}
+
+void TestApp::TestDefragment(RectPacker::PackingAlgorithm algorithm)
+{
+	RectPacker packer(Size(256, 256), RectPacker::create_new_group, algorithm);
+	std::vector<RectPacker::AllocatedRect> rects;
+	for (int i = 0; i < 20; i++)
+		rects.push_back(packer.add(Size(64, 64)));
+	if (packer.get_group_count() != 2)
+		fail("second group allocated");
+
+	// Release from the top down so the skyline can reclaim the space as well
+	for (int i = 15; i >= 6; i--)
+		packer.remove(rects[i]);
+	rects.erase(rects.begin() + 6, rects.begin() + 16);
+
+	std::vector<RectPacker::Relocation> relocations = packer.defragment();
+	if (packer.get_group_count() != 1)
+		fail("defragment releases a group");
+	if (relocations.size() != 4)
+		fail("defragment reports the moved rects");
+	for (auto &relocation : relocations)
+	{
+		for (auto &rect : rects)
+		{
+			if (rect.group_index == relocation.from.group_index && rect.rect == relocation.from.rect)
+				rect = relocation.to;
+		}
+	}
+	if (!is_valid_packing(rects, Size(256, 256)))
+		fail("defragmented rects are valid");
+	if (packer.get_total_rect_count() != 10)
+		fail("defragment keeps every rect");
+	if (!packer.defragment().empty())
+		fail("nothing to defragment with a single group");
+}
 
 int main(int argc, char** argv)
+{
+	TestApp program;
+	return program.main();
+}
+
+int TestApp::main()
 {
 	try
 	{
@@ -95,6 +234,33 @@ int main(int argc, char** argv)
 	{
 		std::cout << "Expected: " << e.message.c_str() << std::endl;		
 	}
+
+	try
+	{
+		std::cout << std::endl << "Testing packing algorithms:" << std::endl;
+		RectPacker::PackingAlgorithm algorithms[] = { RectPacker::guillotine, RectPacker::max_rects, RectPacker::skyline };
+		for (auto algorithm : algorithms)
+		{
+			TestAlgorithm(algorithm);
+			TestDefragment(algorithm);
+		}
+
+		float guillotine_efficiency = FillGroup(RectPacker::guillotine);
+		if (!(FillGroup(RectPacker::max_rects) >= guillotine_efficiency))
+			fail("max_rects packs at least as tight as guillotine");
+		if (!(FillGroup(RectPacker::skyline) >= guillotine_efficiency))
+			fail("skyline packs at least as tight as guillotine");
+	}
+	catch (Exception &e)
+	{
+		std::cout << "Did not expect: " << e.message.c_str() << std::endl;
+		return 1;
+	}
+
 	return 0;
 }
 
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <ClanLib/core.h>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main();
+private:
+	void TestAlgorithm(RectPacker::PackingAlgorithm algorithm);
+	void TestDefragment(RectPacker::PackingAlgorithm algorithm);
+public:
+	void fail(const char *description) const;
+};
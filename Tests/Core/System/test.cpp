@@ -55,6 +55,8 @@ int TestApp::main()
 		Console::write_line("Directory: API/Core/System");
 
 		test_datetime();
+		test_work_queue();
+		test_task_group();
 		
 		Console::write_line("All Tests Complete");
 		console.display_close_message();
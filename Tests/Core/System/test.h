@@ -72,6 +72,8 @@ public:
 	int main();
 private:
 	void test_datetime();
+	void test_work_queue();
+	void test_task_group();
 
 	std::string convert_time(DateTime &datetime);
 	void fail(void);
@@ -0,0 +1,107 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+
+void TestApp::test_task_group()
+{
+	Console::write_line(" Header: task_group.h");
+	Console::write_line("  Class: TaskGroup");
+
+	WorkQueueScheduler schedulers[] = { work_queue_shared, work_queue_stealing };
+	for (auto scheduler : schedulers)
+	{
+		WorkQueue work_queue(scheduler, 4);
+
+		Console::write_line("   Function: run() and wait()");
+		{
+			TaskGroup group(work_queue);
+			std::atomic_int counter(0);
+			for (int i = 0; i < 1000; i++)
+				group.run([&]() { ++counter; });
+			group.wait();
+			if (counter != 1000) fail();
+			if (group.get_tasks_pending() != 0) fail();
+		}
+
+		Console::write_line("   Function: run() with dependencies and Task::then()");
+		{
+			TaskGroup group(work_queue);
+			std::atomic_int sequence(0);
+			int culling = 0, batching = 0, upload = 0;
+			Task culling_task = group.run([&]() { culling = ++sequence; });
+			Task batching_task = culling_task.then([&]() { batching = ++sequence; });
+			Task upload_task = group.run([&]() { upload = ++sequence; }, { culling_task, batching_task });
+			group.wait();
+			if (culling != 1 || batching != 2 || upload != 3) fail();
+			if (!upload_task.is_finished()) fail();
+		}
+
+		Console::write_line("   Function: wait() rethrows task exceptions");
+		{
+			TaskGroup group(work_queue);
+			group.run([]() { throw Exception("Task failed"); });
+			bool caught = false;
+			try
+			{
+				group.wait();
+			}
+			catch (const Exception &)
+			{
+				caught = true;
+			}
+			if (!caught) fail();
+		}
+
+		Console::write_line("   Function: parallel_for()");
+		{
+			std::vector<int> values(10000, 0);
+			parallel_for(work_queue, 0, (int)values.size(), 64, [&](int range_begin, int range_end)
+			{
+				for (int i = range_begin; i < range_end; i++)
+					values[i] = i;
+			});
+			for (int i = 0; i < (int)values.size(); i++)
+			{
+				if (values[i] != i) fail();
+			}
+		}
+
+		Console::write_line("   Function: parallel_reduce()");
+		{
+			int64_t sum = parallel_reduce(work_queue, 0, 100000, 1000, (int64_t)0,
+				[](int range_begin, int range_end) { int64_t value = 0; for (int i = range_begin; i < range_end; i++) value += i; return value; },
+				[](int64_t a, int64_t b) { return a + b; });
+			if (sum != (int64_t)4999950000LL) fail();
+		}
+
+		work_queue.process_work_completed();
+	}
+}
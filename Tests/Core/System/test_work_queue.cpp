@@ -0,0 +1,141 @@
+/*
+**  ClanLib SDK
+**  Copyright (c) 1997-2016 The ClanLib Team
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+**  Note: Some of the libraries ClanLib may link to may have additional
+**  requirements or restrictions.
+**
+**  File Author(s):
+**
+**    Mark Page
+**    (if your name is missing here, please add it)
+*/
+
+#include "test.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	class CountingWorkItem : public WorkItem
+	{
+	public:
+		CountingWorkItem(std::atomic_int &processed, int &completed) : processed(processed), completed(completed) { }
+
+		void process_work() override { ++processed; }
+		void work_completed() override { ++completed; }
+
+	private:
+		std::atomic_int &processed;
+		int &completed;
+	};
+
+	void wait_for_queue(WorkQueue &work_queue)
+	{
+		while (work_queue.get_items_queued() > 0)
+		{
+			work_queue.process_work_completed();
+			std::this_thread::yield();
+		}
+	}
+}
+
+void TestApp::test_work_queue()
+{
+	Console::write_line(" Header: work_queue.h");
+	Console::write_line("  Class: WorkQueue");
+
+	WorkQueueScheduler schedulers[] = { work_queue_shared, work_queue_stealing };
+	for (auto scheduler : schedulers)
+	{
+		Console::write_line(scheduler == work_queue_shared ? "   Scheduler: work_queue_shared" : "   Scheduler: work_queue_stealing");
+
+		Console::write_line("   Function: queue(WorkItem *item)");
+		{
+			WorkQueue work_queue(scheduler, 4);
+			std::atomic_int processed(0);
+			int completed = 0;
+			for (int i = 0; i < 10000; i++)
+				work_queue.queue(new CountingWorkItem(processed, completed));
+			wait_for_queue(work_queue);
+			if (processed != 10000) fail();
+			if (completed != 10000) fail();
+		}
+
+		Console::write_line("   Function: queue(const std::function<void()> &func) from a worker thread");
+		{
+			WorkQueue work_queue(scheduler, 4);
+			std::atomic_int processed(0);
+			for (int i = 0; i < 100; i++)
+			{
+				work_queue.queue([&]()
+				{
+					for (int j = 0; j < 100; j++)
+						work_queue.queue([&]() { ++processed; });
+				});
+			}
+			wait_for_queue(work_queue);
+			if (processed != 10000) fail();
+		}
+
+		Console::write_line("   Function: work_completed()");
+		{
+			WorkQueue work_queue(scheduler, 2);
+			int completed = 0;
+			work_queue.work_completed([&]() { completed++; });
+			wait_for_queue(work_queue);
+			if (completed != 1) fail();
+		}
+	}
+
+	Console::write_line("   Benchmark: 100000 small work items");
+	const int num_items = 100000;
+	for (int num_threads = 1; num_threads <= 64; num_threads *= 2)
+	{
+		uint64_t results[2] = { 0, 0 };
+		for (int index = 0; index < 2; index++)
+		{
+			WorkQueue work_queue(schedulers[index], num_threads);
+			work_queue.queue([]() {});	// Starts the worker threads
+			wait_for_queue(work_queue);
+
+			std::atomic_int processed(0);
+			uint64_t start_time = System::get_microseconds();
+			// Submit from a worker thread so the work stealing scheduler takes its local deque path
+			work_queue.queue([&]()
+			{
+				for (int i = 0; i < num_items; i++)
+				{
+					work_queue.queue([&]()
+					{
+						volatile int value = 0;
+						for (int j = 0; j < 100; j++)
+							value = value + j;
+						++processed;
+					});
+				}
+			});
+			wait_for_queue(work_queue);
+			results[index] = System::get_microseconds() - start_time;
+			if (processed != num_items) fail();
+		}
+
+		Console::write_line("    %1 threads: shared %2 ms, stealing %3 ms", num_threads, results[0] / 1000, results[1] / 1000);
+	}
+}
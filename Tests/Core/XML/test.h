@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/xml.h>
+#include <cstring>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main();
+private:
+	void TestTokenizer();
+	void TestDom();
+	void BenchmarkDom();
+public:
+	void fail(const char *description) const;
+};
@@ -1,6 +1,266 @@
 
-#include <ClanLib/core.h>
-using namespace clan;
+#include "test.h"
+
+// Device returning the data a few bytes at a time, so tokens cross chunk boundaries
+class TrickleDevice : public IODeviceProvider
+{
+public:
+	TrickleDevice(const std::string &data, size_t max_chunk) : data(data), max_chunk(max_chunk) { }
+
+	size_t get_size() const override { return data.size(); }
+	size_t get_position() const override { return position; }
+	size_t send(const void *, size_t, bool) override { throw Exception("Read-only device"); }
+	size_t peek(void *, size_t) override { throw Exception("Peek not supported"); }
+	IODeviceProvider *duplicate() override { return new TrickleDevice(data, max_chunk); }
+
+	size_t receive(void *buffer, size_t len, bool receive_all) override
+	{
+		size_t length = std::min(std::min(len, data.size() - position), receive_all ? len : 1 + (position % max_chunk));
+		memcpy(buffer, data.data() + position, length);
+		position += length;
+		return length;
+	}
+
+private:
+	std::string data;
+	size_t max_chunk;
+	size_t position = 0;
+};
+
+static std::string describe(const XMLToken &token)
+{
+	std::string text = string_format("%1/%2 [%3] [%4]", (int)token.type, (int)token.variant, token.name, token.value);
+	for (const auto &attribute : token.attributes)
+		text += string_format(" %1=[%2]", attribute.first, attribute.second);
+	return text;
+}
+
+static std::vector<std::string> tokenize(XMLTokenizer tokenizer, bool eat_whitespace)
+{
+	tokenizer.set_eat_whitespace(eat_whitespace);
+	std::vector<std::string> tokens;
+	XMLToken token;
+	while (true)
+	{
+		tokenizer.next(&token);
+		if (token.type == XMLToken::NULL_TOKEN)
+			break;
+		tokens.push_back(describe(token));
+	}
+	return tokens;
+}
+
+static bool throws(const std::string &xml)
+{
+	try
+	{
+		IODevice device(new TrickleDevice(xml, 3));
+		tokenize(XMLTokenizer(device), true);
+		return false;
+	}
+	catch (Exception &)
+	{
+		return true;
+	}
+}
+
+void TestApp::TestTokenizer()
+{
+	std::string xml =
+		"\xef\xbb\xbf<?xml version=\"1.0\"?>\n"
+		"<!DOCTYPE root PUBLIC \"-//ClanLib//Test\" 'test.dtd' [ <!ENTITY x \"y\"> ]>\n"
+		"<root a=\"1\" b='two words' c=\"&lt;&amp;lt;&quot;&apos;&gt;&unknown;\" d=plain >\n"
+		"  <!-- comment &amp; note -->\n"
+		"  <item id=\"first\"/>\n"
+		"  text with &lt;entities&gt; and a long enough run to cross a sixteen byte vector &amp;\n"
+		"  <![CDATA[raw <data> &amp; ]]>\n"
+		"  <empty></empty>\n"
+		"</root>\n";
+
+	std::vector<std::string> expected =
+	{
+		"7/3 [xml] [version=\"1.0\"]",
+		"10/3 [] []",
+		"1/1 [root] [] a=[1] b=[two words] c=[<&lt;\"'>&unknown;] d=[plain]",
+		"8/3 [] [comment & note]",
+		"1/3 [item] [] id=[first]",
+		"3/3 [] [text with <entities> and a long enough run to cross a sixteen byte vector &]",
+		"4/3 [] [raw <data> &amp; ]",
+		"1/1 [empty] []",
+		"1/2 [empty] []",
+		"1/2 [root] []"
+	};
+
+	std::vector<std::string> from_memory = tokenize(XMLTokenizer(xml.data(), xml.size()), true);
+	if (from_memory != expected)
+		fail("tokens from memory");
+	for (size_t max_chunk = 1; max_chunk < 20; max_chunk += 3)
+	{
+		IODevice device(new TrickleDevice(xml, max_chunk));
+		if (tokenize(XMLTokenizer(device), true) != expected)
+			fail("tokens from chunked device");
+	}
+
+	IODevice device(new TrickleDevice(xml, 5));
+	if (tokenize(XMLTokenizer(device), false) != tokenize(XMLTokenizer(xml.data(), xml.size()), false))
+		fail("whitespace tokens from chunked device");
+
+	// Views refer to the input unless entities had to be decoded
+	XMLTokenizer tokenizer(xml.data(), xml.size());
+	XMLTokenView view;
+	tokenizer.next(&view);
+	tokenizer.next(&view);
+	tokenizer.next(&view);
+	if (!(view.name == "root" && view.name.data > xml.data() && view.name.data < xml.data() + xml.size()))
+		fail("element name view");
+	if (!(view.attributes.size() == 4 && view.attributes[1].second == "two words" && view.attributes[1].second.data > xml.data() && view.attributes[1].second.data < xml.data() + xml.size()))
+		fail("attribute value view");
+	if (view.attributes[2].second != std::string("<&lt;\"'>&unknown;"))
+		fail("decoded attribute value");
+
+	if (throws("<root a=\"1\">text"))
+		fail("text at the end of the document is accepted");
+	if (!throws("<root a=\"1"))
+		fail("unterminated attribute throws");
+	if (!throws("<!-- comment"))
+		fail("unterminated comment throws");
+	if (!throws("<root a 1/>"))
+		fail("missing equals throws");
+	if (throws("<root/>  "))
+		fail("trailing whitespace is accepted");
+}
+
+static std::string generate_resources(size_t size)
+{
+	std::string xml = "<resources>\n";
+	for (int i = 0; xml.size() < size; i++)
+		xml += string_format("\t<sprite name=\"sprite%1\" width=\"%2\" height=\"64\"><image file=\"images/sprite%1.png\" /><frame delay=\"50\">Frame &amp; text %1</frame></sprite>\n", i, i % 128);
+	xml += "</resources>\n";
+	return xml;
+}
+
+static void BenchmarkTokenizer()
+{
+	std::string xml = generate_resources(16 * 1024 * 1024);
+
+	uint64_t start = System::get_microseconds();
+	XMLTokenizer tokenizer(xml.data(), xml.size());
+	XMLTokenView view;
+	int count = 0;
+	do
+	{
+		tokenizer.next(&view);
+		count++;
+	} while (view.type != XMLToken::NULL_TOKEN);
+	uint64_t end = System::get_microseconds();
+	Console::write_line("Tokenized %1 MB into %2 token views: %3 ms", (int)(xml.size() >> 20), count, (int)((end - start) / 1000));
+
+	start = System::get_microseconds();
+	IODevice device(new TrickleDevice(xml, 64 * 1024));
+	XMLTokenizer stream_tokenizer(device);
+	XMLToken token;
+	count = 0;
+	do
+	{
+		stream_tokenizer.next(&token);
+		count++;
+	} while (token.type != XMLToken::NULL_TOKEN);
+	end = System::get_microseconds();
+	Console::write_line("Tokenized %1 MB into %2 tokens from a device: %3 ms", (int)(xml.size() >> 20), count, (int)((end - start) / 1000));
+}
+
+void TestApp::TestDom()
+{
+	std::string xml = "<root xmlns:a=\"urn:a\"><item id=\"1\" a:kind=\"x\">one</item><item id=\"2\">two</item><!--c--></root>";
+	DataBuffer buffer(xml.data(), xml.size());
+	MemoryDevice device(buffer);
+	DomDocument document(device);
+
+	DomElement root = document.get_document_element();
+	if (root.get_tag_name() != "root")
+		fail("document element name");
+	DomElement first = root.get_first_child_element();
+	DomElement second = first.get_next_sibling_element();
+	if (first.get_attribute("id") != "1" || second.get_attribute("id") != "2")
+		fail("attributes by name");
+	if (first.get_attribute_ns("urn:a", "kind") != "x")
+		fail("attribute by namespace");
+	if (second.has_attribute("kind") || second.get_attribute("missing", "d") != "d")
+		fail("missing attribute");
+	if (first.get_text() != "one")
+		fail("element text");
+	if (root.get_last_child().get_node_type() != DomNode::COMMENT_NODE)
+		fail("comment node");
+
+	first.set_attribute("id", "100");
+	first.set_attribute("id", "7");
+	if (first.get_attribute("id") != "7")
+		fail("attribute value rewritten");
+
+	DomText text = second.get_first_child().to_text();
+	text.append_data(" three");
+	DomElement added = document.create_element("added");
+	root.append_child(added);
+	text.append_data(" four");
+	text.insert_data(0, ">");
+	if (text.get_node_value() != ">two three four")
+		fail("text appended and inserted");
+	text.delete_data(0, 1);
+	if (text.get_node_value() != "two three four")
+		fail("text deleted");
+
+	root.remove_child(first);
+	if (root.get_first_child_element().get_attribute("id") != "2")
+		fail("child removed");
+	if (root.select_nodes("item").size() != 1 || root.select_string("added/..") != "two three four")
+		fail("xpath over edited tree");
+	if (root.select_nodes("item[1 = '1']").size() != 1 || !root.select_nodes("item[1 = 'one']").empty())
+		fail("xpath number compared with a string");
+
+	for (int i = 0; i < 2000; i++)
+		text.set_node_value(string_format("value %1 %2", i, std::string(i % 200, 'x')));
+	if (text.get_node_value() != string_format("value 1999 %1", std::string(1999 % 200, 'x')))
+		fail("value arena reuse");
+}
+
+static int walk_elements(const DomNode &node, int &attributes)
+{
+	int count = 0;
+	for (DomNode cur = node.get_first_child(); !cur.is_null(); cur = cur.get_next_sibling())
+	{
+		if (cur.is_element())
+		{
+			DomElement element = cur.to_element();
+			if (element.has_attribute("name"))
+				attributes += (int)element.get_attribute("name").size();
+			count += 1 + walk_elements(cur, attributes);
+		}
+	}
+	return count;
+}
+
+void TestApp::BenchmarkDom()
+{
+	std::string xml = generate_resources(4 * 1024 * 1024);
+
+	uint64_t start = System::get_microseconds();
+	DataBuffer buffer(xml.data(), xml.size());
+	MemoryDevice device(buffer);
+	DomDocument document(device, false);
+	uint64_t parsed = System::get_microseconds();
+
+	int attributes = 0;
+	int elements = walk_elements(document.get_document_element(), attributes);
+	uint64_t walked = System::get_microseconds();
+
+	std::vector<DomNode> frames = document.select_nodes("/resources/sprite/frame");
+	uint64_t selected = System::get_microseconds();
+
+	if (elements != (int)frames.size() * 3)
+		fail("walk visits every element");
+	Console::write_line("Parsed %1 MB into a DOM: %2 ms, walked %3 elements: %4 ms, selected %5 nodes with xpath: %6 ms",
+		(int)(xml.size() >> 20), (int)((parsed - start) / 1000), elements, (int)((walked - parsed) / 1000), (int)frames.size(), (int)((selected - walked) / 1000));
+}
 
 void TestXMLFile(const std::string &filename)
 {
@@ -26,6 +286,12 @@ void TestXMLFile(const std::string &filename)
 }
 
 int main(int, char**)
+{
+	TestApp program;
+	return program.main();
+}
+
+int TestApp::main()
 {
 
 	TestXMLFile("test-emeditor-utf8-iso-8859-1.xml");
@@ -35,5 +301,23 @@ int main(int, char**)
 	TestXMLFile("test-notepad-unicode.xml");
 	TestXMLFile("test-notepad-ansi.xml");
 
+	try
+	{
+		TestTokenizer();
+		BenchmarkTokenizer();
+		TestDom();
+		BenchmarkDom();
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
 	return 0;
 }
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -41,6 +41,7 @@ int TestApp::main()
 	try
 	{
 		run_test();
+		run_archive_test();
 		console.display_close_message();
 	}
 	catch(Exception error)
@@ -86,3 +87,118 @@ void TestApp::run_test()
 		Console::write_line("Contents: %1", StringHelp::utf8_to_text(str8));
 	}
 }
+
+void TestApp::run_archive_test()
+{
+	Console::write_line("");
+
+	std::string large_file;
+	for (int i = 0; large_file.size() < 4 * 1024 * 1024; i++)
+		large_file += string_format("Line %1: the quick brown fox %2 jumps over the lazy dog\n", i, (i * 7919) % 1000);
+
+	write_test_archive("ZipArchive.zip", large_file);
+
+	// Archive opened by filename is memory mapped when possible, the device version reads through the device
+	ZipArchive mapped_archive("ZipArchive.zip");
+	File file("ZipArchive.zip", File::open_existing, File::access_read);
+	ZipArchive device_archive(file);
+
+	ZipArchive *archives[] = { &mapped_archive, &device_archive };
+	for (auto archive : archives)
+	{
+		test_entry(*archive, "data/file1.txt", "Contents of file 1");
+		test_entry(*archive, "data/file4999.txt", "Contents of file 4999");
+		test_entry(*archive, "/data/file2500.txt", "Contents of file 2500");
+		test_entry(*archive, "large_stored.txt", large_file);
+		test_entry(*archive, "large_deflated.txt", large_file);
+
+		bool thrown = false;
+		try
+		{
+			archive->open_file("data/missing.txt");
+		}
+		catch (Exception &)
+		{
+			thrown = true;
+		}
+		check(thrown, "missing entry throws");
+
+		test_random_access(*archive, "large_stored.txt", large_file, 200);
+	}
+
+	uint64_t start = System::get_microseconds();
+	for (int i = 0; i < 5000; i++)
+		mapped_archive.open_file(string_format("data/file%1.txt", i));
+	uint64_t end = System::get_microseconds();
+	Console::write_line("Opening 5000 entries: %1 ms", (int)((end - start) / 1000));
+
+	start = System::get_microseconds();
+	test_random_access(mapped_archive, "large_deflated.txt", large_file, 20);
+	end = System::get_microseconds();
+	Console::write_line("20 random seeks without seek index: %1 ms", (int)((end - start) / 1000));
+
+	for (auto archive : archives)
+	{
+		archive->set_seek_index_interval(256 * 1024);
+
+		start = System::get_microseconds();
+		test_random_access(*archive, "large_deflated.txt", large_file, 200);
+		end = System::get_microseconds();
+		Console::write_line("200 random seeks with seek index: %1 ms", (int)((end - start) / 1000));
+	}
+	Console::write_line("Zip archive tests passed");
+}
+
+void TestApp::write_test_archive(const std::string &filename, const std::string &large_file)
+{
+	File file(filename, File::create_always, File::access_write);
+	ZipWriter zip_writer(file);
+	for (int i = 0; i < 5000; i++)
+	{
+		std::string contents = string_format("Contents of file %1", i);
+		zip_writer.begin_file(string_format("data/file%1.txt", i), (i % 2) == 0);
+		zip_writer.write_file_data(contents.data(), contents.size());
+		zip_writer.end_file();
+	}
+	zip_writer.begin_file("large_stored.txt", false);
+	zip_writer.write_file_data(large_file.data(), large_file.size());
+	zip_writer.end_file();
+	zip_writer.begin_file("large_deflated.txt", true);
+	zip_writer.write_file_data(large_file.data(), large_file.size());
+	zip_writer.end_file();
+	zip_writer.write_toc();
+	file.close();
+}
+
+void TestApp::test_entry(ZipArchive &archive, const std::string &filename, const std::string &contents)
+{
+	IODevice device = archive.open_file(filename[0] == '/' ? filename.substr(1) : filename);
+	check(device.get_size() == contents.size(), "entry size");
+
+	std::string data(contents.size(), 0);
+	check(device.read(&data[0], data.size()) == data.size() && data == contents, "entry contents");
+}
+
+void TestApp::test_random_access(ZipArchive &archive, const std::string &filename, const std::string &contents, int seeks)
+{
+	IODevice device = archive.open_file(filename);
+	unsigned int seed = 12345;
+	char buffer[100];
+	for (int i = 0; i < seeks; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		int position = (seed >> 8) % (contents.size() - sizeof(buffer));
+		check(device.seek(position), "seek");
+		check(device.get_position() == (size_t)position, "position after seek");
+		check(device.read(buffer, sizeof(buffer)) == sizeof(buffer), "read after seek");
+		check(memcmp(buffer, contents.data() + position, sizeof(buffer)) == 0, "data after seek");
+	}
+
+	check(device.seek(-10, IODevice::seek_end) && device.read(buffer, 20) == 10, "read at end");
+}
+
+void TestApp::check(bool condition, const char *description)
+{
+	if (!condition)
+		throw Exception(string_format("Check failed: %1", description));
+}
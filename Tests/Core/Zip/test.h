@@ -40,6 +40,11 @@ public:
 
 private:
 	void run_test();
+	void run_archive_test();
+	void write_test_archive(const std::string &filename, const std::string &large_file);
+	void test_entry(ZipArchive &archive, const std::string &filename, const std::string &contents);
+	void test_random_access(ZipArchive &archive, const std::string &filename, const std::string &contents, int seeks);
+	void check(bool condition, const char *description);
 };
 
 #endif
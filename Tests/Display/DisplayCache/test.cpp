@@ -0,0 +1,149 @@
+
+#include "test.h"
+
+// Asynchronous DisplayCache loading test.
+//
+// Writes a few images to a temporary directory, requests them through the file display cache
+// of a recording display target and reports how long the main thread spends per upload step.
+// Usage: displaycache [images]
+
+static std::string image_name(int index)
+{
+	return string_format("image%1.png", index);
+}
+
+static void create_images(const std::string &path, int count)
+{
+	Directory::create(path);
+	for (int i = 0; i < count; i++)
+	{
+		PixelBuffer pixels(256 + i, 200, tf_rgba8);
+		unsigned char *data = static_cast<unsigned char *>(pixels.get_data());
+		for (int j = 0; j < pixels.get_width() * pixels.get_height() * 4; j++)
+			data[j] = static_cast<unsigned char>(j * (i + 3));
+		ImageProviderFactory::save(pixels, PathHelp::combine(path, image_name(i)));
+	}
+}
+
+static void remove_images(const std::string &path, int count)
+{
+	for (int i = 0; i < count; i++)
+		FileHelp::delete_file(PathHelp::combine(path, image_name(i)));
+	Directory::remove(path);
+}
+
+static bool wait_for_loads(DisplayCache &cache, GraphicContext &gc, int &steps, uint64_t &longest_step)
+{
+	uint64_t timeout = System::get_microseconds() + 30000000;
+	while (cache.get_pending_loads() > 0)
+	{
+		if (System::get_microseconds() > timeout)
+			return false;
+
+		uint64_t start = System::get_microseconds();
+		cache.process_loads(gc, 1000);
+		longest_step = max(longest_step, System::get_microseconds() - start);
+		steps++;
+		System::sleep(1);
+	}
+	return true;
+}
+
+void TestApp::test_async(DisplayCache &cache, Canvas &canvas, int count)
+{
+	GraphicContext gc = canvas.get_gc();
+
+	Resource<Texture> texture = cache.get_texture_async(gc, image_name(0), 0);
+	Resource<Image> image = cache.get_image_async(canvas, image_name(1), 10);
+	Resource<Sprite> sprite = cache.get_sprite_async(canvas, image_name(2), 5);
+	Resource<Image> cancelled = cache.get_image_async(canvas, image_name(3), -10);
+	Resource<Texture> missing = cache.get_texture_async(gc, "missing.png", 0);
+	cache.cancel(image_name(3));
+
+	std::vector<std::string> ids;
+	for (int i = 4; i < count; i++)
+		ids.push_back(image_name(i));
+	cache.prefetch(gc, ids, -5);
+
+	if (!texture.get().is_null() || !image.get().is_null() || !sprite.get().is_null())
+		fail("placeholders start out empty");
+	missing.updated();
+	if (cache.get_load_state(image_name(3)) != ResourceLoadState::cancelled)
+		fail("cancelled request");
+	if (cache.get_load_state("never_requested.png") != ResourceLoadState::none)
+		fail("unknown request");
+
+	int steps = 0;
+	uint64_t longest_step = 0;
+	uint64_t start = System::get_microseconds();
+	if (!wait_for_loads(cache, gc, steps, longest_step))
+		fail("all requests finish");
+	uint64_t end = System::get_microseconds();
+
+	if (cache.get_load_state(image_name(0)) != ResourceLoadState::loaded)
+		fail("texture loaded");
+	if (texture.get().is_null() || texture.get().to_texture_2d().get_width() != 256)
+		fail("texture placeholder filled in");
+	if (image.get().is_null() || image.get().get_width() != 257)
+		fail("image placeholder filled in");
+	if (sprite.get().is_null() || sprite.get().get_width() != 258)
+		fail("sprite placeholder filled in");
+	if (!cancelled.get().is_null())
+		fail("cancelled placeholder stays empty");
+	if (cache.get_load_state("missing.png") != ResourceLoadState::failed || !missing.get().is_null())
+		fail("missing file fails");
+	if (!missing.updated())
+		fail("failed placeholder reports an update");
+	if (cache.get_load_state(image_name(count - 1)) != ResourceLoadState::loaded)
+		fail("prefetched texture loaded");
+
+	// Loaded resources come straight from the cache
+	Resource<Texture> cached = cache.get_texture_async(gc, image_name(count - 1), 0);
+	if (cached.get().is_null())
+		fail("prefetched texture is cached");
+	if (cache.get_pending_loads() != 0)
+		fail("cached request queues no work");
+
+	Console::write_line("Loaded %1 images in %2 ms, %3 upload steps, longest step %4 ms",
+		count - 2, (end - start) / 1000.0, steps, longest_step / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int count = argc > 1 ? atoi(argv[1]) : 24;
+	if (count < 5)
+		count = 24;
+
+	const std::string path = "displaycache_test";
+
+	try
+	{
+		RecordingTarget::set_current();
+		DisplayWindow window("Display Cache", 640, 480);
+		Canvas canvas(window);
+
+		create_images(path, count);
+		ResourceManager resources = FileResourceManager::create(FileResourceDocument(FileSystem(path)));
+		test_async(DisplayCache::get(resources), canvas, count);
+		remove_images(path, count);
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		remove_images(path, count);
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cstdlib>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_async(DisplayCache &cache, Canvas &canvas, int count);
+public:
+	void fail(const char *description) const;
+};
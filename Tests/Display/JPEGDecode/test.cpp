@@ -0,0 +1,359 @@
+
+#include "test.h"
+
+// JPEG decoder tests and benchmark.
+//
+// Decodes images written by JPEGProvider, and baseline images with restart intervals and long Huffman codes
+// written by a small DC only encoder, both on the calling thread and on a work queue.
+// Then decodes a large photo like image and reports the time taken.
+// Usage: jpegdecode [image size]
+
+static PixelBuffer decode(DataBuffer jpeg, WorkQueue *work_queue)
+{
+	MemoryDevice device(jpeg);
+	return work_queue ? JPEGProvider::load(device, false, *work_queue) : JPEGProvider::load(device);
+}
+
+static bool equal(const PixelBuffer &a, const PixelBuffer &b)
+{
+	if (a.get_width() != b.get_width() || a.get_height() != b.get_height())
+		return false;
+	for (int y = 0; y < a.get_height(); y++)
+	{
+		if (memcmp(a.get_line(y), b.get_line(y), a.get_width() * 4) != 0)
+			return false;
+	}
+	return true;
+}
+
+static PixelBuffer create_photo(int width, int height)
+{
+	// Smooth shading with some texture, roughly what a photo compresses like
+	PixelBuffer image(width, height, tf_rgba8);
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char *line = static_cast<unsigned char *>(image.get_line(y));
+		for (int x = 0; x < width; x++)
+		{
+			float u = x / (float)width;
+			float v = y / (float)height;
+			float texture = std::sin(x * 0.31f) * std::cos(y * 0.17f) * 20.0f + (rand() % 16);
+			line[x * 4 + 0] = (unsigned char)clamp(128.0f + 100.0f * std::sin(u * 6.0f) + texture, 0.0f, 255.0f);
+			line[x * 4 + 1] = (unsigned char)clamp(40.0f + 180.0f * v + texture, 0.0f, 255.0f);
+			line[x * 4 + 2] = (unsigned char)clamp(200.0f - 150.0f * u * v + texture, 0.0f, 255.0f);
+			line[x * 4 + 3] = 255;
+		}
+	}
+	return image;
+}
+
+static DataBuffer encode_photo(const PixelBuffer &image, int quality)
+{
+	MemoryDevice device;
+	JPEGProvider::save(image, device, quality);
+	return device.get_data();
+}
+
+static double mean_error(const PixelBuffer &a, const PixelBuffer &b)
+{
+	double error = 0.0;
+	for (int y = 0; y < a.get_height(); y++)
+	{
+		const unsigned char *line_a = static_cast<const unsigned char *>(a.get_line(y));
+		const unsigned char *line_b = static_cast<const unsigned char *>(b.get_line(y));
+		for (int x = 0; x < a.get_width() * 4; x++)
+			error += std::abs(line_a[x] - line_b[x]);
+	}
+	return error / (a.get_width() * a.get_height() * 4);
+}
+
+void TestApp::test_photo(WorkQueue &work_queue)
+{
+	// Odd size so the last MCU row and column are partial
+	PixelBuffer source = create_photo(301, 197);
+	DataBuffer jpeg = encode_photo(source, 95);
+
+	PixelBuffer decoded = decode(jpeg, nullptr);
+	if (decoded.get_width() != 301 || decoded.get_height() != 197)
+		fail("photo size");
+	if (!(mean_error(source, decoded) < 4.0))
+		fail("photo decodes close to the source");
+	if (!equal(decoded, decode(jpeg, &work_queue)))
+		fail("photo decodes the same on a work queue");
+}
+
+// Minimal baseline encoder. Every block is flat, so only DC coefficients are coded.
+class FlatJPEGEncoder
+{
+public:
+	FlatJPEGEncoder(int width, int height, bool color, int restart_interval)
+		: width(width), height(height), color(color), restart_interval(restart_interval)
+	{
+		int mcu_size = color ? 16 : 8;
+		mcu_width = (width + mcu_size - 1) / mcu_size;
+		mcu_height = (height + mcu_size - 1) / mcu_size;
+		int blocks_per_mcu = color ? 6 : 1;
+		levels.resize(mcu_width * mcu_height * blocks_per_mcu);
+		for (auto &level : levels)
+			level = rand() % 256;
+	}
+
+	DataBuffer encode()
+	{
+		write_marker(0xd8);
+
+		// Quantization table of ones
+		write_marker(0xdb);
+		write_uint16(2 + 65);
+		output.push_back(0);
+		for (int i = 0; i < 64; i++)
+			output.push_back(1);
+
+		int num_components = color ? 3 : 1;
+		write_marker(0xc0);
+		write_uint16(8 + 3 * num_components);
+		output.push_back(8);
+		write_uint16(height);
+		write_uint16(width);
+		output.push_back(num_components);
+		for (int c = 0; c < num_components; c++)
+		{
+			output.push_back(c + 1);
+			output.push_back((color && c == 0) ? 0x22 : 0x11);
+			output.push_back(0);
+		}
+
+		// DC table with code lengths 1 to 12, so large differences need more than the lookahead bits
+		write_marker(0xc4);
+		write_uint16(2 + 17 + 12 + 17 + 1);
+		output.push_back(0x00);
+		for (int i = 0; i < 16; i++)
+			output.push_back(i < 12 ? 1 : 0);
+		for (int i = 0; i < 12; i++)
+			output.push_back(i);
+		output.push_back(0x10); // AC table holding only the end of block code
+		for (int i = 0; i < 16; i++)
+			output.push_back(i == 0 ? 1 : 0);
+		output.push_back(0x00);
+
+		if (restart_interval)
+		{
+			write_marker(0xdd);
+			write_uint16(4);
+			write_uint16(restart_interval);
+		}
+
+		write_marker(0xda);
+		write_uint16(6 + 2 * num_components);
+		output.push_back(num_components);
+		for (int c = 0; c < num_components; c++)
+		{
+			output.push_back(c + 1);
+			output.push_back(0x00);
+		}
+		output.push_back(0);
+		output.push_back(63);
+		output.push_back(0);
+
+		int dc[3] = { 0, 0, 0 };
+		int blocks_per_mcu = color ? 6 : 1;
+		for (int mcu = 0; mcu < mcu_width * mcu_height; mcu++)
+		{
+			if (restart_interval && mcu > 0 && mcu % restart_interval == 0)
+			{
+				flush_bits();
+				write_marker(0xd0 + (mcu / restart_interval - 1) % 8);
+				dc[0] = dc[1] = dc[2] = 0;
+			}
+
+			for (int block = 0; block < blocks_per_mcu; block++)
+			{
+				int c = color ? (block < 4 ? 0 : block - 3) : 0;
+				int value = 8 * (levels[mcu * blocks_per_mcu + block] - 128);
+				write_dc(value - dc[c]);
+				dc[c] = value;
+				write_bits(0, 1); // end of block
+			}
+		}
+		flush_bits();
+
+		write_marker(0xd9);
+		return DataBuffer(output.data(), output.size());
+	}
+
+	Vec4ub expected_pixel(int x, int y) const
+	{
+		if (!color)
+		{
+			int level = levels[(y / 8) * mcu_width + x / 8];
+			return Vec4ub(level, level, level, 255);
+		}
+
+		int mcu = (y / 16) * mcu_width + x / 16;
+		int block = ((y % 16) / 8) * 2 + (x % 16) / 8;
+		float Y = levels[mcu * 6 + block];
+		float Cb = levels[mcu * 6 + 4] - 128.0f;
+		float Cr = levels[mcu * 6 + 5] - 128.0f;
+		float R = clamp(Y + 1.40200f * Cr, 0.0f, 255.0f) + 0.5f;
+		float G = clamp(Y - 0.34414f * Cb - 0.71414f * Cr, 0.0f, 255.0f) + 0.5f;
+		float B = clamp(Y + 1.77200f * Cb, 0.0f, 255.0f) + 0.5f;
+		return Vec4ub((int)R, (int)G, (int)B, 255);
+	}
+
+	bool compare(const PixelBuffer &image) const
+	{
+		if (image.get_width() != width || image.get_height() != height)
+			return false;
+		for (int y = 0; y < height; y++)
+		{
+			const Vec4ub *line = static_cast<const Vec4ub *>(image.get_line(y));
+			for (int x = 0; x < width; x++)
+			{
+				Vec4ub expected = expected_pixel(x, y);
+				if (std::abs(line[x].x - expected.x) > 1 || std::abs(line[x].y - expected.y) > 1 || std::abs(line[x].z - expected.z) > 1 || line[x].w != expected.w)
+					return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	void write_dc(int diff)
+	{
+		int magnitude = std::abs(diff);
+		int category = 0;
+		while ((1 << category) <= magnitude)
+			category++;
+
+		// Code for category n is n ones followed by a zero
+		write_bits(((1 << category) - 1) << 1, category + 1);
+		if (category > 0)
+			write_bits(diff >= 0 ? diff : diff + (1 << category) - 1, category);
+	}
+
+	void write_bits(unsigned int bits, int count)
+	{
+		for (int i = count - 1; i >= 0; i--)
+		{
+			accumulator = (accumulator << 1) | ((bits >> i) & 1);
+			if (++bit_count == 8)
+			{
+				output.push_back(accumulator);
+				if (accumulator == 0xff)
+					output.push_back(0x00);
+				accumulator = 0;
+				bit_count = 0;
+			}
+		}
+	}
+
+	void flush_bits()
+	{
+		while (bit_count != 0)
+			write_bits(1, 1);
+	}
+
+	void write_marker(int marker)
+	{
+		output.push_back(0xff);
+		output.push_back(marker);
+	}
+
+	void write_uint16(int value)
+	{
+		output.push_back(value >> 8);
+		output.push_back(value & 0xff);
+	}
+
+	int width, height;
+	bool color;
+	int restart_interval;
+	int mcu_width = 0, mcu_height = 0;
+	std::vector<int> levels;
+	std::vector<unsigned char> output;
+	unsigned int accumulator = 0;
+	int bit_count = 0;
+};
+
+void TestApp::test_flat(WorkQueue &work_queue, bool color, int restart_interval, const char *description)
+{
+	Console::write_line("   ... Running Test (%1)", description);
+	FlatJPEGEncoder encoder(203, 117, color, restart_interval);
+	DataBuffer jpeg = encoder.encode();
+	if (!encoder.compare(decode(jpeg, nullptr)))
+		fail(description);
+	if (!encoder.compare(decode(jpeg, &work_queue)))
+		fail((std::string(description) + " on a work queue").c_str());
+}
+
+void TestApp::test_restart_intervals(WorkQueue &work_queue)
+{
+	test_flat(work_queue, false, 0, "gray without restart intervals");
+	test_flat(work_queue, false, 5, "gray with restart intervals");
+	test_flat(work_queue, true, 0, "4:2:0 without restart intervals");
+	test_flat(work_queue, true, 3, "4:2:0 with restart intervals");
+	test_flat(work_queue, true, 1000, "4:2:0 with one restart interval");
+
+	// Entropy data ending early must be reported
+	FlatJPEGEncoder encoder(64, 64, false, 4);
+	DataBuffer jpeg = encoder.encode();
+	DataBuffer truncated(jpeg, 0, jpeg.get_size() - 20);
+	bool thrown = false;
+	try
+	{
+		decode(truncated, &work_queue);
+	}
+	catch (Exception &)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+		fail("truncated entropy data throws");
+}
+
+static void benchmark(WorkQueue &work_queue, int size)
+{
+	DataBuffer jpeg = encode_photo(create_photo(size, size), 90);
+	Console::write_line("Decoding %1x%2 photo, %3 KB", size, size, (int)(jpeg.get_size() / 1024));
+
+	for (int threaded = 0; threaded < 2; threaded++)
+	{
+		uint64_t start = System::get_microseconds();
+		PixelBuffer pixels = decode(jpeg, threaded ? &work_queue : nullptr);
+		uint64_t end = System::get_microseconds();
+		Console::write_line("%1: %2 ms", threaded ? "Decode on work queue" : "Decode", (int)((end - start) / 1000));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int size = argc > 1 ? atoi(argv[1]) : 4096;
+	if (size <= 0)
+		size = 4096;
+
+	try
+	{
+		WorkQueue work_queue(work_queue_stealing);
+		test_photo(work_queue);
+		test_restart_intervals(work_queue);
+		benchmark(work_queue, size);
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
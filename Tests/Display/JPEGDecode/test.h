@@ -0,0 +1,22 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_photo(WorkQueue &work_queue);
+	void test_flat(WorkQueue &work_queue, bool color, int restart_interval, const char *description);
+	void test_restart_intervals(WorkQueue &work_queue);
+public:
+	void fail(const char *description) const;
+};
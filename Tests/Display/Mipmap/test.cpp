@@ -0,0 +1,386 @@
+
+#include "test.h"
+
+// PixelResampler tests and benchmark.
+//
+// Checks mipmap chain sizes, gamma correct filtering of sRGB formats, alpha weighting, that every filter keeps
+// constant images constant and preserves linear gradients, and that filtering on a work queue gives the same result.
+// Then generates mipmap chains for 4k and 8k images with each filter and reports the time taken.
+// Usage: mipmap [image size]
+
+static PixelBuffer create_noise(int width, int height, TextureFormat format)
+{
+	PixelBuffer image(width, height, format);
+	unsigned char *data = image.get_data_uint8();
+	int size = image.get_pitch() * height;
+	for (int i = 0; i < size; i++)
+		data[i] = rand() & 0xff;
+	return image;
+}
+
+static PixelBuffer create_float_noise(int width, int height)
+{
+	PixelBuffer image(width, height, tf_rgba32f);
+	for (int y = 0; y < height; y++)
+	{
+		float *line = static_cast<float*>(image.get_line(y));
+		for (int x = 0; x < width * 4; x++)
+			line[x] = (rand() % 1000) / 1000.0f;
+	}
+	return image;
+}
+
+static const PixelResampleFilter all_filters[] = { resample_box, resample_lanczos3, resample_kaiser };
+static const char *filter_names[] = { "box", "lanczos3", "kaiser" };
+
+void TestApp::test_chain_sizes()
+{
+	PixelResampler resampler;
+	PixelBufferSet image_set = resampler.create_mipmaps(PixelBuffer(100, 37, tf_rgba8));
+
+	static const int expected[][2] = { { 100, 37 }, { 50, 18 }, { 25, 9 }, { 12, 4 }, { 6, 2 }, { 3, 1 }, { 1, 1 } };
+	if (image_set.get_base_level() != 0 || image_set.get_max_level() != 6)
+		fail("mipmap levels for 100x37");
+	for (int level = 0; level <= 6; level++)
+	{
+		PixelBuffer image = image_set.get_image(0, level);
+		if (image.get_width() != expected[level][0] || image.get_height() != expected[level][1])
+			fail("mipmap level size");
+		if (image.get_format() != tf_rgba8)
+			fail("mipmap level format");
+	}
+
+	PixelBufferSet single = resampler.create_mipmaps(PixelBuffer(1, 1, tf_rgba8));
+	if (single.get_max_level() != 0)
+		fail("mipmap levels for 1x1");
+}
+
+void TestApp::test_gamma()
+{
+	// Black and white checkerboard. Averaged in linear light the result is 0.5, which is 188 in sRGB
+	for (int format_index = 0; format_index < 3; format_index++)
+	{
+		TextureFormat format = format_index == 0 ? tf_srgb8_alpha8 : tf_rgba8;
+		bool force_srgb = format_index == 2;
+
+		PixelBuffer image(64, 64, format);
+		for (int y = 0; y < 64; y++)
+		{
+			Vec4ub *line = static_cast<Vec4ub*>(image.get_line(y));
+			for (int x = 0; x < 64; x++)
+			{
+				unsigned char value = ((x + y) & 1) ? 255 : 0;
+				line[x] = Vec4ub(value, value, value, 255);
+			}
+		}
+
+		PixelResampler resampler;
+		resampler.set_srgb(force_srgb);
+		PixelBufferSet image_set = resampler.create_mipmaps(image);
+		for (int level = 1; level <= image_set.get_max_level(); level++)
+		{
+			PixelBuffer mip = image_set.get_image(0, level);
+			bool srgb_result = format == tf_srgb8_alpha8 || force_srgb;
+			int expected = srgb_result ? 188 : 128;
+			bool matches = true;
+			for (int y = 0; y < mip.get_height(); y++)
+			{
+				const Vec4ub *line = static_cast<const Vec4ub*>(mip.get_line(y));
+				for (int x = 0; x < mip.get_width(); x++)
+					matches = matches && std::abs(line[x].r - expected) <= 1 && std::abs(line[x].g - expected) <= 1 && line[x].a == 255;
+			}
+			if (!matches)
+				fail("checkerboard averaged in gamma space");
+		}
+	}
+}
+
+void TestApp::test_alpha_weighting()
+{
+	// Transparent red next to opaque green must not turn brown
+	PixelBuffer image(2, 2, tf_rgba8);
+	for (int y = 0; y < 2; y++)
+	{
+		Vec4ub *line = static_cast<Vec4ub*>(image.get_line(y));
+		line[0] = Vec4ub(255, 0, 0, 0);
+		line[1] = Vec4ub(0, 255, 0, 255);
+	}
+
+	PixelResampler resampler;
+	PixelBuffer mip = resampler.create_mipmaps(image).get_image(0, 1);
+	Vec4ub pixel = *static_cast<const Vec4ub*>(mip.get_line(0));
+	if (!(pixel.r == 0 && pixel.g == 255 && std::abs(pixel.a - 128) <= 1))
+		fail("colors weighted by alpha");
+
+	resampler.set_premultiplied_alpha(true);
+	mip = resampler.create_mipmaps(image).get_image(0, 1);
+	pixel = *static_cast<const Vec4ub*>(mip.get_line(0));
+	if (!(std::abs(pixel.r - 128) <= 1 && std::abs(pixel.g - 128) <= 1))
+		fail("premultiplied colors filtered as is");
+}
+
+void TestApp::test_constant()
+{
+	const TextureFormat formats[] = { tf_rgba8, tf_srgb8_alpha8, tf_rgb8, tf_bgra8, tf_rgba16, tf_rgba32f };
+	for (PixelResampleFilter filter : all_filters)
+	{
+		for (TextureFormat format : formats)
+		{
+			PixelBuffer image(77, 50, tf_rgba32f);
+			for (int y = 0; y < image.get_height(); y++)
+			{
+				Vec4f *line = static_cast<Vec4f*>(image.get_line(y));
+				for (int x = 0; x < image.get_width(); x++)
+					line[x] = Vec4f(51.0f, 153.0f, 230.0f, 191.0f) * (1.0f / 255.0f);
+			}
+			image = image.to_format(format);
+
+			PixelResampler resampler;
+			resampler.set_filter(filter);
+			PixelBufferSet image_set = resampler.create_mipmaps(image);
+
+			Vec4f expected = *static_cast<const Vec4f*>(image.to_format(tf_rgba32f).get_line(0));
+			bool matches = true;
+			for (int level = 1; level <= image_set.get_max_level(); level++)
+			{
+				PixelBuffer mip = image_set.get_image(0, level).to_format(tf_rgba32f);
+				for (int y = 0; y < mip.get_height(); y++)
+				{
+					const Vec4f *line = static_cast<const Vec4f*>(mip.get_line(y));
+					for (int x = 0; x < mip.get_width(); x++)
+					{
+						matches = matches && std::abs(line[x].x - expected.x) < 0.003f && std::abs(line[x].y - expected.y) < 0.003f &&
+							std::abs(line[x].z - expected.z) < 0.003f && std::abs(line[x].w - expected.w) < 0.003f;
+					}
+				}
+			}
+			if (!matches)
+				fail("constant image stays constant");
+		}
+	}
+}
+
+void TestApp::test_box_reference()
+{
+	PixelBuffer image = create_float_noise(64, 48);
+
+	PixelResampler resampler;
+	PixelBuffer mip = resampler.create_mipmaps(image).get_image(0, 1);
+
+	bool matches = true;
+	for (int y = 0; y < 24; y++)
+	{
+		const float *line0 = static_cast<const float*>(image.get_line(y * 2));
+		const float *line1 = static_cast<const float*>(image.get_line(y * 2 + 1));
+		const float *result = static_cast<const float*>(mip.get_line(y));
+		for (int x = 0; x < 24; x++)
+		{
+			// Colors are weighted by alpha
+			const float *p[4] = { line0 + x * 8, line0 + x * 8 + 4, line1 + x * 8, line1 + x * 8 + 4 };
+			float alpha = (p[0][3] + p[1][3] + p[2][3] + p[3][3]) * 0.25f;
+			for (int c = 0; c < 3; c++)
+			{
+				float sum = (p[0][c] * p[0][3] + p[1][c] * p[1][3] + p[2][c] * p[2][3] + p[3][c] * p[3][3]) * 0.25f;
+				float expected = alpha > 0.0f ? sum / alpha : 0.0f;
+				matches = matches && std::abs(result[x * 4 + c] - expected) < 1e-4f;
+			}
+			matches = matches && std::abs(result[x * 4 + 3] - alpha) < 1e-5f;
+		}
+	}
+	if (!matches)
+		fail("box filter averages 2x2 blocks");
+}
+
+void TestApp::test_gradient()
+{
+	// Symmetric normalized filters reproduce a linear function away from the edges
+	for (PixelResampleFilter filter : all_filters)
+	{
+		PixelBuffer image(64, 16, tf_rgba32f);
+		for (int y = 0; y < 16; y++)
+		{
+			Vec4f *line = static_cast<Vec4f*>(image.get_line(y));
+			for (int x = 0; x < 64; x++)
+			{
+				float value = (x + 0.5f) / 64.0f;
+				line[x] = Vec4f(value, 1.0f - value, 0.5f, 1.0f);
+			}
+		}
+
+		PixelResampler resampler;
+		resampler.set_filter(filter);
+		PixelBuffer mip = resampler.create_mipmaps(image).get_image(0, 1);
+
+		bool matches = true;
+		for (int y = 0; y < mip.get_height(); y++)
+		{
+			const Vec4f *line = static_cast<const Vec4f*>(mip.get_line(y));
+			for (int x = 4; x < 28; x++)
+			{
+				float expected = (2 * x + 1) / 64.0f;
+				matches = matches && std::abs(line[x].x - expected) < 1e-4f && std::abs(line[x].y - (1.0f - expected)) < 1e-4f;
+			}
+		}
+		if (!matches)
+			fail("linear gradient preserved");
+	}
+}
+
+void TestApp::test_upscale()
+{
+	PixelBuffer image = create_noise(13, 7, tf_rgba8);
+	for (int y = 0; y < 7; y++)
+	{
+		Vec4ub *line = static_cast<Vec4ub*>(image.get_line(y));
+		for (int x = 0; x < 13; x++)
+			line[x].a = 255;
+	}
+
+	PixelResampler resampler;
+	PixelBuffer scaled = resampler.resample(image, 26, 14);
+	bool matches = scaled.get_width() == 26 && scaled.get_height() == 14;
+	for (int y = 0; y < 14 && matches; y++)
+	{
+		const Vec4ub *line = static_cast<const Vec4ub*>(scaled.get_line(y));
+		const Vec4ub *source = static_cast<const Vec4ub*>(image.get_line(y / 2));
+		for (int x = 0; x < 26; x++)
+			matches = matches && line[x] == source[x / 2];
+	}
+	if (!matches)
+		fail("box filter upscales by repeating pixels");
+}
+
+void TestApp::test_work_queue(WorkQueue &work_queue)
+{
+	PixelBuffer image = create_noise(1000, 700, tf_srgb8_alpha8);
+	for (PixelResampleFilter filter : all_filters)
+	{
+		PixelResampler single_thread;
+		PixelResampler threaded(work_queue);
+		single_thread.set_filter(filter);
+		threaded.set_filter(filter);
+
+		PixelBufferSet expected = single_thread.create_mipmaps(image);
+		PixelBufferSet result = threaded.create_mipmaps(image);
+		bool matches = expected.get_max_level() == result.get_max_level();
+		for (int level = 1; level <= expected.get_max_level() && matches; level++)
+		{
+			PixelBuffer a = expected.get_image(0, level);
+			PixelBuffer b = result.get_image(0, level);
+			matches = a.get_data_size() == b.get_data_size() && memcmp(a.get_data(), b.get_data(), a.get_data_size()) == 0;
+		}
+		if (!matches)
+			fail("work queue gives the same result");
+
+		PixelBuffer scaled = threaded.resample(image, 333, 999);
+		PixelBuffer scaled_expected = single_thread.resample(image, 333, 999);
+		if (memcmp(scaled.get_data(), scaled_expected.get_data(), scaled.get_data_size()) != 0)
+			fail("work queue resample gives the same result");
+	}
+}
+
+void TestApp::test_image_sets()
+{
+	PixelResampler resampler;
+
+	PixelBufferSet array_set(texture_2d_array, tf_rgba8, 32, 16, 2);
+	array_set.set_image(0, 0, create_noise(32, 16, tf_rgba8));
+	array_set.set_image(1, 0, create_noise(32, 16, tf_rgba8));
+	resampler.generate_mipmaps(array_set);
+	if (array_set.get_max_level() != 5)
+		fail("array mipmap levels");
+	if (array_set.get_image(0, 5).is_null() || array_set.get_image(1, 5).is_null())
+		fail("array slices have mipmaps");
+
+	bool thrown = false;
+	try
+	{
+		PixelBufferSet volume(texture_3d, tf_rgba8, 4, 4, 4);
+		resampler.generate_mipmaps(volume);
+	}
+	catch (Exception &)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+		fail("3D texture rejected");
+
+	thrown = false;
+	try
+	{
+		resampler.resample(PixelBuffer(16, 16, tf_compressed_rgba_s3tc_dxt5), 8, 8);
+	}
+	catch (Exception &)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+		fail("compressed pixel buffer rejected");
+}
+
+static void benchmark(WorkQueue &work_queue, int size)
+{
+	Console::write_line("Generating mipmaps for %1x%2 sRGB image", size, size);
+	PixelBuffer image = create_noise(size, size, tf_srgb8_alpha8);
+
+	for (int i = 0; i < 3; i++)
+	{
+		for (int threaded = 0; threaded < 2; threaded++)
+		{
+			PixelResampler resampler = threaded ? PixelResampler(work_queue) : PixelResampler();
+			resampler.set_filter(all_filters[i]);
+
+			uint64_t start = System::get_microseconds();
+			PixelBufferSet image_set = resampler.create_mipmaps(image);
+			uint64_t end = System::get_microseconds();
+			Console::write_line("%1%2: %3 ms", filter_names[i], threaded ? " on work queue" : "", (int)((end - start) / 1000));
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int size = argc > 1 ? atoi(argv[1]) : 0;
+
+	try
+	{
+		WorkQueue work_queue(work_queue_stealing);
+		test_chain_sizes();
+		test_gamma();
+		test_alpha_weighting();
+		test_constant();
+		test_box_reference();
+		test_gradient();
+		test_upscale();
+		test_work_queue(work_queue);
+		test_image_sets();
+
+		if (size > 0)
+		{
+			benchmark(work_queue, size);
+		}
+		else
+		{
+			benchmark(work_queue, 4096);
+			benchmark(work_queue, 8192);
+		}
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_chain_sizes();
+	void test_gamma();
+	void test_alpha_weighting();
+	void test_constant();
+	void test_box_reference();
+	void test_gradient();
+	void test_upscale();
+	void test_work_queue(WorkQueue &work_queue);
+	void test_image_sets();
+public:
+	void fail(const char *description) const;
+};
@@ -0,0 +1,412 @@
+
+#include "test.h"
+
+// PNG decoder tests and benchmark.
+//
+// Encodes images with every filter type, bit depth and colour type, with and without Adam7 interlacing,
+// and verifies that PNGProvider decodes them exactly, both on the calling thread and on a work queue.
+// Then decodes a large texture atlas and reports the time taken.
+// Usage: pngdecode [atlas size]
+
+struct SourceImage
+{
+	int width = 0;
+	int height = 0;
+	int color_type = 6;
+	int bit_depth = 8;
+	std::vector<int> samples;
+	std::vector<unsigned char> palette;
+	std::vector<unsigned char> palette_alpha;
+
+	int channels() const
+	{
+		switch (color_type)
+		{
+		case 0: return 1;
+		case 2: return 3;
+		case 3: return 1;
+		case 4: return 2;
+		default: return 4;
+		}
+	}
+
+	int sample(int x, int y, int c) const { return samples[(y * width + x) * channels() + c]; }
+};
+
+static SourceImage create_image(int width, int height, int color_type, int bit_depth)
+{
+	SourceImage image;
+	image.width = width;
+	image.height = height;
+	image.color_type = color_type;
+	image.bit_depth = bit_depth;
+
+	// Gradients with some noise, so every predictor sees a mix of small and large differences
+	int max_value = (1 << bit_depth) - 1;
+	image.samples.resize(width * height * image.channels());
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < image.channels(); c++)
+			{
+				int value = (x * (3 + c) + y * (5 - c)) * (max_value / 255 + 1) + rand() % 8;
+				image.samples[(y * width + x) * image.channels() + c] = value & max_value;
+			}
+		}
+	}
+
+	if (color_type == 3)
+	{
+		for (int i = 0; i <= max_value; i++)
+		{
+			image.palette.push_back(i * 7);
+			image.palette.push_back(255 - i);
+			image.palette.push_back(i * 13);
+		}
+		image.palette_alpha.push_back(0);
+		image.palette_alpha.push_back(128);
+	}
+	return image;
+}
+
+static Vec4us expected_pixel(const SourceImage &image, int x, int y)
+{
+	int max_value = (1 << image.bit_depth) - 1;
+	int scale = image.bit_depth < 8 ? 255 / max_value : 1;
+	int opaque = image.bit_depth == 16 ? 65535 : 255;
+	switch (image.color_type)
+	{
+	case 0:
+	{
+		int v = image.sample(x, y, 0) * scale;
+		return Vec4us(v, v, v, opaque);
+	}
+	case 2:
+		return Vec4us(image.sample(x, y, 0), image.sample(x, y, 1), image.sample(x, y, 2), opaque);
+	case 3:
+	{
+		int index = image.sample(x, y, 0);
+		int alpha = index < (int)image.palette_alpha.size() ? image.palette_alpha[index] : 255;
+		return Vec4us(image.palette[index * 3], image.palette[index * 3 + 1], image.palette[index * 3 + 2], alpha);
+	}
+	case 4:
+		return Vec4us(image.sample(x, y, 0), image.sample(x, y, 0), image.sample(x, y, 0), image.sample(x, y, 1));
+	default:
+		return Vec4us(image.sample(x, y, 0), image.sample(x, y, 1), image.sample(x, y, 2), image.sample(x, y, 3));
+	}
+}
+
+static std::vector<unsigned char> pack_scanline(const SourceImage &image, int y, int start_col, int col_increment)
+{
+	std::vector<unsigned char> scanline;
+	int bits = 0;
+	int accumulator = 0;
+	for (int x = start_col; x < image.width; x += col_increment)
+	{
+		for (int c = 0; c < image.channels(); c++)
+		{
+			int value = image.sample(x, y, c);
+			if (image.bit_depth == 16)
+			{
+				scanline.push_back(value >> 8);
+				scanline.push_back(value & 0xff);
+			}
+			else
+			{
+				accumulator = (accumulator << image.bit_depth) | value;
+				bits += image.bit_depth;
+				if (bits == 8)
+				{
+					scanline.push_back(accumulator);
+					accumulator = 0;
+					bits = 0;
+				}
+			}
+		}
+	}
+	if (bits > 0)
+		scanline.push_back(accumulator << (8 - bits));
+	return scanline;
+}
+
+static int paeth(int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = abs(p - a);
+	int pb = abs(p - b);
+	int pc = abs(p - c);
+	if (pa <= pb && pa <= pc)
+		return a;
+	else if (pb <= pc)
+		return b;
+	else
+		return c;
+}
+
+static void write_filtered_scanline(std::vector<unsigned char> &output, const std::vector<unsigned char> &scanline, const std::vector<unsigned char> &prev, int bytes_per_pixel, int filter)
+{
+	output.push_back(filter);
+	for (size_t i = 0; i < scanline.size(); i++)
+	{
+		int a = i >= (size_t)bytes_per_pixel ? scanline[i - bytes_per_pixel] : 0;
+		int b = prev.empty() ? 0 : prev[i];
+		int c = (i >= (size_t)bytes_per_pixel && !prev.empty()) ? prev[i - bytes_per_pixel] : 0;
+		int predictor = 0;
+		switch (filter)
+		{
+		case 1: predictor = a; break;
+		case 2: predictor = b; break;
+		case 3: predictor = (a + b) / 2; break;
+		case 4: predictor = paeth(a, b, c); break;
+		}
+		output.push_back(static_cast<unsigned char>(scanline[i] - predictor));
+	}
+}
+
+static void write_chunk(MemoryDevice &device, const char *name, const void *data, int size)
+{
+	device.write_uint32(size);
+	device.write(name, 4);
+	device.write(data, size);
+	device.write_uint32(HashFunctions::crc32(data, size, HashFunctions::crc32(name, 4)));
+}
+
+static DataBuffer encode_png(const SourceImage &image, bool interlaced, int idat_chunk_size, int compression_level = 6)
+{
+	int bytes_per_pixel = std::max(image.channels() * image.bit_depth / 8, 1);
+
+	static const int starting_row[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	static const int starting_col[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	static const int row_increment[7] = { 8, 8, 8, 4, 4, 2, 2 };
+	static const int col_increment[7] = { 8, 8, 4, 4, 2, 2, 1 };
+
+	std::vector<unsigned char> raw;
+	int num_passes = interlaced ? 7 : 1;
+	for (int pass = 0; pass < num_passes; pass++)
+	{
+		int row_start = interlaced ? starting_row[pass] : 0;
+		int row_inc = interlaced ? row_increment[pass] : 1;
+		int col_start = interlaced ? starting_col[pass] : 0;
+		int col_inc = interlaced ? col_increment[pass] : 1;
+		if (col_start >= image.width)
+			continue;
+
+		std::vector<unsigned char> prev;
+		for (int y = row_start; y < image.height; y += row_inc)
+		{
+			std::vector<unsigned char> scanline = pack_scanline(image, y, col_start, col_inc);
+			write_filtered_scanline(raw, scanline, prev, bytes_per_pixel, (y + pass) % 5);
+			prev = scanline;
+		}
+	}
+
+	DataBuffer idat = ZLibCompression::compress(DataBuffer(raw.data(), raw.size()), false, compression_level);
+
+	MemoryDevice device;
+	device.set_big_endian_mode();
+	unsigned char magic[8] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+	device.write(magic, 8);
+
+	unsigned char ihdr[13];
+	ihdr[0] = image.width >> 24; ihdr[1] = image.width >> 16; ihdr[2] = image.width >> 8; ihdr[3] = image.width;
+	ihdr[4] = image.height >> 24; ihdr[5] = image.height >> 16; ihdr[6] = image.height >> 8; ihdr[7] = image.height;
+	ihdr[8] = image.bit_depth;
+	ihdr[9] = image.color_type;
+	ihdr[10] = 0;
+	ihdr[11] = 0;
+	ihdr[12] = interlaced ? 1 : 0;
+	write_chunk(device, "IHDR", ihdr, 13);
+
+	if (image.color_type == 3)
+	{
+		write_chunk(device, "PLTE", image.palette.data(), image.palette.size());
+		write_chunk(device, "tRNS", image.palette_alpha.data(), image.palette_alpha.size());
+	}
+
+	for (int pos = 0; pos < (int)idat.get_size(); pos += idat_chunk_size)
+		write_chunk(device, "IDAT", idat.get_data() + pos, std::min(idat_chunk_size, (int)idat.get_size() - pos));
+
+	write_chunk(device, "tEXt", "Comment\0test", 12);
+	write_chunk(device, "IEND", nullptr, 0);
+
+	return device.get_data();
+}
+
+static bool compare(const SourceImage &image, const PixelBuffer &pixels)
+{
+	if (pixels.get_width() != image.width || pixels.get_height() != image.height)
+		return false;
+
+	for (int y = 0; y < image.height; y++)
+	{
+		for (int x = 0; x < image.width; x++)
+		{
+			Vec4us expected = expected_pixel(image, x, y);
+			Vec4us actual;
+			if (image.bit_depth == 16)
+			{
+				actual = static_cast<const Vec4us *>(pixels.get_line(y))[x];
+			}
+			else
+			{
+				Vec4ub value = static_cast<const Vec4ub *>(pixels.get_line(y))[x];
+				actual = Vec4us(value.r, value.g, value.b, value.a);
+			}
+
+			if (actual != expected)
+				return false;
+		}
+	}
+	return true;
+}
+
+static PixelBuffer decode(DataBuffer png, WorkQueue *work_queue)
+{
+	MemoryDevice device(png);
+	return work_queue ? PNGProvider::load(device, false, *work_queue) : PNGProvider::load(device);
+}
+
+void TestApp::test_format(WorkQueue &work_queue, int color_type, int bit_depth, const char *description)
+{
+	for (int interlaced = 0; interlaced < 2; interlaced++)
+	{
+		// Odd sizes so the Adam7 passes and packed samples don't line up with bytes, and small chunks so
+		// scanlines straddle IDAT boundaries
+		SourceImage image = create_image(123, 77, color_type, bit_depth);
+		DataBuffer png = encode_png(image, interlaced != 0, 333);
+
+		std::string name = string_format("%1%2", description, interlaced ? " (Adam7)" : "");
+		Console::write_line("   ... Running Test (%1)", name);
+		if (!compare(image, decode(png, nullptr)))
+			fail((name + " decodes").c_str());
+		if (!compare(image, decode(png, &work_queue)))
+			fail((name + " decodes on a work queue").c_str());
+	}
+}
+
+void TestApp::test_decoder(WorkQueue &work_queue)
+{
+	test_format(work_queue, 6, 8, "RGBA 8 bit");
+	test_format(work_queue, 2, 8, "RGB 8 bit");
+	test_format(work_queue, 4, 8, "Gray alpha 8 bit");
+	test_format(work_queue, 0, 8, "Gray 8 bit");
+	test_format(work_queue, 0, 4, "Gray 4 bit");
+	test_format(work_queue, 0, 1, "Gray 1 bit");
+	test_format(work_queue, 3, 8, "Indexed 8 bit");
+	test_format(work_queue, 3, 2, "Indexed 2 bit");
+	test_format(work_queue, 6, 16, "RGBA 16 bit");
+	test_format(work_queue, 2, 16, "RGB 16 bit");
+	test_format(work_queue, 4, 16, "Gray alpha 16 bit");
+
+	// Images smaller than an Adam7 block leave some of the passes empty
+	SourceImage tiny = create_image(3, 2, 6, 8);
+	if (!compare(tiny, decode(encode_png(tiny, true, 1000), &work_queue)))
+		fail("Adam7 with empty passes");
+
+	// Truncated image data must be reported rather than leaving rows undecoded
+	SourceImage image = create_image(64, 64, 6, 8);
+	DataBuffer png = encode_png(image, false, 100);
+	DataBuffer truncated(png, 0, png.get_size() / 2);
+	bool thrown = false;
+	try
+	{
+		decode(truncated, &work_queue);
+	}
+	catch (Exception &)
+	{
+		thrown = true;
+	}
+	if (!thrown)
+		fail("truncated image data throws");
+}
+
+static SourceImage create_atlas(int size)
+{
+	SourceImage atlas;
+	atlas.width = size;
+	atlas.height = size;
+	atlas.samples.resize((size_t)size * size * 4);
+
+	// Tiles of gradients with flat borders and some noisy tiles, roughly how a sprite atlas compresses
+	for (int y = 0; y < size; y++)
+	{
+		for (int x = 0; x < size; x++)
+		{
+			int tile = (y / 64) * (size / 64) + x / 64;
+			int tx = x % 64;
+			int ty = y % 64;
+			int *pixel = &atlas.samples[((size_t)y * size + x) * 4];
+			if (tx < 2 || ty < 2)
+			{
+				pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+			}
+			else if (tile % 7 == 0)
+			{
+				pixel[0] = rand() & 0xff;
+				pixel[1] = rand() & 0xff;
+				pixel[2] = rand() & 0xff;
+				pixel[3] = 255;
+			}
+			else
+			{
+				pixel[0] = (tx * 4 + tile) & 0xff;
+				pixel[1] = (ty * 4 + tile * 3) & 0xff;
+				pixel[2] = ((tx + ty) * 2) & 0xff;
+				pixel[3] = 255 - ((tx * ty) >> 4);
+			}
+		}
+	}
+	return atlas;
+}
+
+static void benchmark(WorkQueue &work_queue, int size)
+{
+	Console::write_line("Encoding %1x%2 atlas", size, size);
+	DataBuffer png;
+	{
+		SourceImage atlas = create_atlas(size);
+		png = encode_png(atlas, false, 64 * 1024);
+	}
+	Console::write_line("Compressed size: %1 MB", png.get_size() / (1024 * 1024));
+
+	for (int threaded = 0; threaded < 2; threaded++)
+	{
+		uint64_t start = System::get_microseconds();
+		PixelBuffer pixels = decode(png, threaded ? &work_queue : nullptr);
+		uint64_t end = System::get_microseconds();
+		Console::write_line("%1: %2 ms", threaded ? "Decode on work queue" : "Decode", (int)((end - start) / 1000));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int size = argc > 1 ? atoi(argv[1]) : 8192;
+	if (size <= 0)
+		size = 8192;
+
+	try
+	{
+		WorkQueue work_queue(work_queue_stealing);
+		test_decoder(work_queue);
+		benchmark(work_queue, size);
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_format(WorkQueue &work_queue, int color_type, int bit_depth, const char *description);
+	void test_decoder(WorkQueue &work_queue);
+public:
+	void fail(const char *description) const;
+};
@@ -0,0 +1,189 @@
+
+#include "test.h"
+
+// CPU path rasterizer benchmark.
+//
+// Fills a few typical scenes into a PixelBuffer with Path::fill and reports the time per frame.
+// Usage: pathraster [frames]
+
+static int alpha_at(const PixelBuffer &pixels, int x, int y)
+{
+	return static_cast<const unsigned char *>(pixels.get_line(y))[x * 4 + 3];
+}
+
+static void clear(PixelBuffer &pixels)
+{
+	memset(pixels.get_data(), 0, pixels.get_pitch() * pixels.get_height());
+}
+
+void TestApp::test_coverage()
+{
+	PixelBuffer pixels(64, 64, tf_rgba8);
+
+	clear(pixels);
+	Path::rect(10.0f, 10.0f, 20.5f, 20.0f).fill(pixels, Colorf::white);
+	if (alpha_at(pixels, 20, 20) != 255)
+		fail("rect interior is fully covered");
+	if (alpha_at(pixels, 9, 20) != 0)
+		fail("pixel left of rect is empty");
+	if (!(alpha_at(pixels, 30, 20) >= 126 && alpha_at(pixels, 30, 20) <= 129))
+		fail("half covered rect edge");
+	if (alpha_at(pixels, 20, 30) != 0)
+		fail("pixel below rect is empty");
+
+	// Clipped against the pixel buffer on all sides
+	clear(pixels);
+	Path::rect(-100.0f, -100.0f, 300.0f, 300.0f).fill(pixels, Colorf::white);
+	if (alpha_at(pixels, 0, 0) != 255 || alpha_at(pixels, 63, 63) != 255)
+		fail("clipped rect covers the whole buffer");
+
+	// A square inside a square: alternate leaves a hole, winding does not
+	Path nested = Path::rect(8.0f, 8.0f, 48.0f, 48.0f) + Path::rect(24.0f, 24.0f, 16.0f, 16.0f);
+	clear(pixels);
+	nested.fill(pixels, Colorf::white);
+	if (alpha_at(pixels, 32, 32) != 0 || alpha_at(pixels, 12, 32) != 255)
+		fail("alternate fill mode");
+
+	nested.set_fill_mode(PathFillMode::winding);
+	clear(pixels);
+	nested.fill(pixels, Colorf::white);
+	if (alpha_at(pixels, 32, 32) != 255)
+		fail("winding fill mode");
+
+	// Coverage is analytic, so the summed alpha matches the area of the polygon
+	const int sides = 64;
+	Path polygon;
+	for (int i = 0; i < sides; i++)
+	{
+		float angle = i * 2.0f * PI / sides;
+		Pointf point(32.3f + 20.0f * std::cos(angle), 31.7f + 20.0f * std::sin(angle));
+		if (i == 0)
+			polygon.move_to(point);
+		else
+			polygon.line_to(point);
+	}
+	polygon.close();
+
+	clear(pixels);
+	polygon.fill(pixels, Colorf::white);
+	int total = 0;
+	for (int y = 0; y < 64; y++)
+	{
+		for (int x = 0; x < 64; x++)
+			total += alpha_at(pixels, x, y);
+	}
+	float area = total / 255.0f;
+	float expected = 0.5f * sides * 400.0f * std::sin(2.0f * PI / sides);
+	if (!(std::abs(area - expected) < 0.5f))
+		fail("polygon area");
+}
+
+static std::vector<Path> create_map_scene(int width, int height)
+{
+	std::vector<Path> paths;
+	srand(1);
+	for (int i = 0; i < 300; i++)
+	{
+		float cx = static_cast<float>(rand() % width);
+		float cy = static_cast<float>(rand() % height);
+		Path path;
+		path.set_fill_mode(PathFillMode::winding);
+		for (int j = 0; j < 12; j++)
+		{
+			float angle = j * 2.0f * PI / 12.0f;
+			float radius = 20.0f + static_cast<float>(rand() % 60);
+			Pointf point(cx + radius * std::cos(angle), cy + radius * std::sin(angle));
+			if (j == 0)
+				path.move_to(point);
+			else
+				path.line_to(point);
+		}
+		path.close();
+		paths.push_back(path);
+	}
+	return paths;
+}
+
+static std::vector<Path> create_circle_scene(int width, int height)
+{
+	std::vector<Path> paths;
+	srand(2);
+	for (int i = 0; i < 1000; i++)
+	{
+		float radius = 2.0f + static_cast<float>(rand() % 30);
+		paths.push_back(Path::circle(static_cast<float>(rand() % width), static_cast<float>(rand() % height), radius));
+	}
+	return paths;
+}
+
+static std::vector<Path> create_star_scene(int width, int height)
+{
+	Path path;
+	const int points = 101;
+	for (int i = 0; i < points; i++)
+	{
+		float angle = i * 2.0f * PI * 50.0f / points;
+		Pointf point(width * 0.5f + height * 0.48f * std::cos(angle), height * 0.5f + height * 0.48f * std::sin(angle));
+		if (i == 0)
+			path.move_to(point);
+		else
+			path.line_to(point);
+	}
+	path.close();
+	return std::vector<Path>(1, path);
+}
+
+static void benchmark(const char *name, std::vector<Path> paths, PixelBuffer &pixels, int frames)
+{
+	Colorf color(0.2f, 0.5f, 0.8f, 0.7f);
+	uint64_t start = System::get_microseconds();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		clear(pixels);
+		for (auto &path : paths)
+			path.fill(pixels, color);
+	}
+	uint64_t end = System::get_microseconds();
+
+	double ms_per_frame = (end - start) / 1000.0 / frames;
+	Console::write_line("%1: %2 paths, %3 ms per frame", name, (int)paths.size(), ms_per_frame);
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 20;
+	if (frames <= 0)
+		frames = 20;
+
+	try
+	{
+		test_coverage();
+
+		const int width = 1024;
+		const int height = 768;
+		PixelBuffer pixels(width, height, tf_rgba8);
+
+		Console::write_line("Rasterizing %1 frames of %2x%3", frames, width, height);
+		benchmark("Map polygons", create_map_scene(width, height), pixels, frames);
+		benchmark("Circles", create_circle_scene(width, height), pixels, frames);
+		benchmark("Star (alternate)", create_star_scene(width, height), pixels, frames);
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void test_coverage();
+public:
+	void fail(const char *description) const;
+};
@@ -0,0 +1,364 @@
+
+#include "test.h"
+
+// 2D and UI renderer benchmark.
+//
+// Renders a few typical scenes to a recording display target, which needs no window system or
+// graphics driver, and reports the CPU time per frame together with the work submitted to the
+// graphic context.
+// Usage: renderbenchmark [frames]
+
+void TestApp::benchmark(const char *name, DisplayWindow &window, Canvas &canvas, int frames, const std::function<void()> &render, bool clear)
+{
+	GraphicContext gc = canvas.get_gc();
+	RecordingTarget::reset_statistics(gc);
+	canvas.reset_batch_statistics();
+
+	uint64_t start = System::get_microseconds();
+	for (int frame = 0; frame < frames; frame++)
+	{
+		if (clear)
+			canvas.clear(Colorf::black);
+		render();
+		window.flip();
+	}
+	uint64_t end = System::get_microseconds();
+
+	RecordingStatistics stats = RecordingTarget::get_statistics(gc);
+	CanvasBatchStatistics batch = canvas.get_batch_statistics();
+	if (stats.frames != frames)
+		fail("every flip is recorded");
+	if (!(stats.draw_calls > 0 && stats.vertices > 0))
+		fail("scene submits draw calls");
+
+	double ms_per_frame = (end - start) / 1000.0 / frames;
+	Console::write_line("%1: %2 ms per frame", name, ms_per_frame);
+	Console::write_line("    %1 draw calls, %2 vertices, %3 state changes per frame",
+		stats.draw_calls / frames, (int)(stats.vertices / frames), stats.state_changes / frames);
+	Console::write_line("    %1 buffer uploads (%2 KB), %3 texture uploads (%4 KB) per frame",
+		stats.buffer_uploads / frames, (int)(stats.buffer_bytes / frames / 1024),
+		stats.texture_uploads / frames, (int)(stats.texture_bytes / frames / 1024));
+	Console::write_line("    %1 batch flushes, %2 bytes per batched vertex",
+		batch.flushes / frames, batch.total_vertices ? (int)(batch.total_bytes / batch.total_vertices) : 0);
+}
+
+void TestApp::test_command_log(Canvas &canvas)
+{
+	GraphicContext gc = canvas.get_gc();
+	RecordingTarget::reset_statistics(gc);
+	if (!RecordingTarget::get_command_log(gc).empty())
+		fail("command log is disabled by default");
+
+	RecordingTarget::set_command_log_enabled(gc, true);
+	canvas.fill_rect(10.0f, 10.0f, 20.0f, 20.0f, Colorf::white);
+	canvas.flush();
+	std::vector<std::string> log = RecordingTarget::get_command_log(gc);
+	if (log.empty())
+		fail("commands are logged when enabled");
+
+	RecordingTarget::set_command_log_enabled(gc, false);
+	RecordingTarget::reset_statistics(gc);
+	if (!RecordingTarget::get_command_log(gc).empty())
+		fail("reset clears the command log");
+}
+
+// Makes the damage calculation the window does before each render available to the test
+class DamageWindow : public TextureWindow
+{
+public:
+	DamageWindow(Canvas &canvas) : TextureWindow(canvas) {}
+	using TextureWindow::update_damage;
+};
+
+static bool damage_covers(const std::vector<Rectf> &damage, const Rectf &box)
+{
+	for (const auto &rect : damage)
+	{
+		if (rect.left <= box.left && rect.top <= box.top && rect.right >= box.right && rect.bottom >= box.bottom)
+			return true;
+	}
+	return false;
+}
+
+void TestApp::test_shadow_damage(Canvas &canvas)
+{
+	Rectf viewport(0.0f, 0.0f, 400.0f, 300.0f);
+	DamageWindow ui(canvas);
+	ui.set_viewport(viewport);
+
+	auto root = std::make_shared<View>();
+	root->style()->set("flex-direction: column");
+	auto view = root->add_child();
+	view->style()->set("width: 40px; height: 20px; margin-left: 100px; margin-top: 100px; background: white; box-shadow: 0 0 10px black");
+	view->style("hot")->set("box-shadow: 5px 5px 30px black");
+	ui.set_root_view(root);
+	ui.update_damage(canvas, viewport);
+
+	// The shadow is part of the render box before the view has been rendered
+	view->style()->set("margin-left: 200px");
+	view->set_needs_layout();
+	std::vector<Rectf> damage = ui.update_damage(canvas, viewport);
+	if (!damage_covers(damage, Rectf(90.0f, 90.0f, 150.0f, 130.0f)))
+		fail("old position including the shadow is damaged");
+	if (!damage_covers(damage, Rectf(190.0f, 90.0f, 250.0f, 130.0f)))
+		fail("new position including the shadow is damaged");
+
+	view->set_state("hot", true);
+	damage = ui.update_damage(canvas, viewport);
+	if (!damage_covers(damage, Rectf(170.0f, 70.0f, 275.0f, 155.0f)))
+		fail("larger hot shadow is damaged");
+
+	view->set_state("hot", false);
+	damage = ui.update_damage(canvas, viewport);
+	if (!damage_covers(damage, Rectf(170.0f, 70.0f, 275.0f, 155.0f)))
+		fail("shadow shrinking back is damaged");
+
+	view->remove_from_parent();
+	damage = ui.update_damage(canvas, viewport);
+	if (!damage_covers(damage, Rectf(190.0f, 90.0f, 250.0f, 130.0f)))
+		fail("removed view and its shadow are damaged");
+}
+
+void TestApp::test_fixed_after_move(Canvas &canvas)
+{
+	Rectf viewport(0.0f, 0.0f, 400.0f, 300.0f);
+	TextureWindow ui(canvas);
+	ui.set_viewport(viewport);
+
+	auto root = std::make_shared<View>();
+	root->style()->set("flex-direction: column");
+	auto spacer = root->add_child();
+	spacer->style()->set("width: 40px; height: 20px");
+	auto container = root->add_child();
+	container->style()->set("width: 100px; height: 50px; flex-direction: column");
+	auto inner = container->add_child();
+	inner->style()->set("width: 80px; height: 30px; margin-left: 7px");
+	auto fixed = inner->add_child();
+	fixed->style()->set("position: fixed; left: 10px; top: 20px; width: 5px; height: 5px");
+	ui.set_root_view(root);
+	ui.update();
+
+	// Moving the container without resizing it must keep the fixed view in place
+	spacer->style()->set("height: 60px");
+	spacer->set_needs_layout();
+	ui.update();
+
+	Pointf offset = container->geometry().content_pos() + inner->geometry().content_pos();
+	if (offset.y != 60.0f)
+		fail("container moved below the taller spacer");
+	if (inner->geometry().content_box() != Rectf(7.0f, 0.0f, 87.0f, 30.0f))
+		fail("container kept its size and children");
+	if (fixed->geometry().content_box().translate(offset) != Rectf(10.0f, 20.0f, 15.0f, 25.0f))
+		fail("fixed view stays at its position in the viewport when an ancestor moves");
+}
+
+static std::vector<Image> create_images(Canvas &canvas)
+{
+	std::vector<Image> images;
+	for (int i = 0; i < 4; i++)
+	{
+		PixelBuffer pixels(64, 64, tf_rgba8);
+		unsigned char *data = static_cast<unsigned char *>(pixels.get_data());
+		for (int j = 0; j < 64 * 64 * 4; j++)
+			data[j] = static_cast<unsigned char>(j * (i + 1));
+		images.push_back(Image(canvas, pixels, pixels.get_size()));
+	}
+	return images;
+}
+
+static std::shared_ptr<View> create_ui_scene()
+{
+	auto root = std::make_shared<View>();
+	root->style()->set("flex-direction: row; flex-wrap: wrap; background: rgb(40,40,40)");
+	for (int i = 0; i < 200; i++)
+	{
+		auto child = root->add_child();
+		child->style()->set("width: 60px; height: 30px; margin: 4px; background: rgb(80,120,200); border: 1px solid white; border-radius: 4px");
+		child->style("hot")->set("background: rgb(200,120,80)");
+	}
+	return root;
+}
+
+// 100 rows of 100 leaves, with the width of each leaf given in pixels
+static std::shared_ptr<View> create_layout_scene(const std::vector<int> &leaf_widths)
+{
+	auto root = std::make_shared<View>();
+	root->style()->set("flex-direction: column; background: rgb(40,40,40)");
+	for (int row = 0; row < 100; row++)
+	{
+		auto row_view = root->add_child();
+		row_view->style()->set("flex-direction: row; margin-bottom: 1px");
+		for (int column = 0; column < 100; column++)
+		{
+			auto leaf = row_view->add_child();
+			leaf->style()->set(string_format("width: %1px; height: 6px; margin-right: 1px; background: rgb(80,120,200)", leaf_widths[row * 100 + column]));
+		}
+	}
+	return root;
+}
+
+static void print_view_statistics(TextureWindow &ui, int frames)
+{
+	const ViewRenderStatistics &stats = ui.render_statistics();
+	Console::write_line("    %1 display list hits, %2 misses, %3 views rendered, %4 regions (%5 pixels) per frame",
+		stats.cache_hits / frames, stats.cache_misses / frames, stats.views_rendered / frames,
+		stats.damage_rects / frames, (int)(stats.damage_area / frames));
+	Console::write_line("    %1 views laid out per frame", stats.views_laid_out / frames);
+}
+
+int main(int argc, char **argv)
+{
+	TestApp program;
+	return program.main(argc, argv);
+}
+
+int TestApp::main(int argc, char **argv)
+{
+	int frames = argc > 1 ? atoi(argv[1]) : 50;
+	if (frames <= 0)
+		frames = 50;
+
+	try
+	{
+		RecordingTarget::set_current();
+		if (!RecordingTarget::is_current())
+			fail("recording target is current");
+
+		const int width = 1024;
+		const int height = 768;
+		DisplayWindowDescription desc;
+		desc.set_title("Render Benchmark");
+		desc.set_size(Sizef((float)width, (float)height), true);
+		DisplayWindow window(desc);
+		Canvas canvas(window);
+
+		test_command_log(canvas);
+		test_shadow_damage(canvas);
+		test_fixed_after_move(canvas);
+
+		Console::write_line("Rendering %1 frames of %2x%3", frames, width, height);
+
+		benchmark("Rectangles", window, canvas, frames, [&]()
+		{
+			srand(1);
+			for (int i = 0; i < 10000; i++)
+			{
+				float x = (float)(rand() % width);
+				float y = (float)(rand() % height);
+				canvas.fill_rect(x, y, x + 16.0f, y + 16.0f, Colorf(0.2f, 0.5f, 0.8f, 0.7f));
+			}
+		});
+
+		std::vector<Image> images = create_images(canvas);
+		benchmark("Images", window, canvas, frames, [&]()
+		{
+			srand(2);
+			for (int i = 0; i < 10000; i++)
+				images[i % images.size()].draw(canvas, (float)(rand() % width), (float)(rand() % height));
+		});
+
+		benchmark("Lines", window, canvas, frames, [&]()
+		{
+			srand(3);
+			for (int i = 0; i < 10000; i++)
+				canvas.draw_line((float)(rand() % width), (float)(rand() % height), (float)(rand() % width), (float)(rand() % height), Colorf::white);
+		});
+
+		std::vector<Path> paths;
+		srand(4);
+		for (int i = 0; i < 300; i++)
+			paths.push_back(Path::circle((float)(rand() % width), (float)(rand() % height), 4.0f + (float)(rand() % 30)));
+		benchmark("Paths", window, canvas, frames, [&]()
+		{
+			for (auto &path : paths)
+				path.fill(canvas, Brush::solid(0.15f, 0.8f, 0.3f, 0.7f));
+		});
+
+		TextureWindow ui(canvas);
+		ui.set_viewport(Rectf(0.0f, 0.0f, (float)width, (float)height));
+		ui.set_always_render();
+		ui.set_root_view(create_ui_scene());
+		ui.update();
+		ui.reset_render_statistics();
+		benchmark("Views", window, canvas, frames, [&]()
+		{
+			ui.update();
+		});
+		print_view_statistics(ui, frames);
+		if (ui.render_statistics().cache_misses != 0)
+			fail("unchanged views render from their display lists");
+
+		// Only the view changing state is rendered again
+		ui.set_always_render(false);
+		ui.reset_render_statistics();
+		int frame = 0;
+		benchmark("Views, one changing per frame", window, canvas, frames, [&]()
+		{
+			auto &views = ui.root_view()->children();
+			views[frame % views.size()]->set_state("hot", (frame / views.size()) % 2 == 0);
+			frame++;
+			ui.update();
+		}, false);
+		print_view_statistics(ui, frames);
+		if (!(ui.render_statistics().damage_area < frames * width * height / 10.0f))
+			fail("state changes only render the damaged region");
+		if (ui.render_statistics().cache_misses != frames)
+			fail("state change rebuilds one display list");
+
+		// Resizing one leaf only lays out its row again
+		std::vector<int> leaf_widths(100 * 100, 8);
+		TextureWindow layout_ui(canvas);
+		layout_ui.set_viewport(Rectf(0.0f, 0.0f, (float)width, (float)height));
+		layout_ui.set_root_view(create_layout_scene(leaf_widths));
+		benchmark("Layout 10k views", window, canvas, 1, [&]()
+		{
+			layout_ui.update();
+		});
+		print_view_statistics(layout_ui, 1);
+
+		layout_ui.reset_render_statistics();
+		frame = 0;
+		benchmark("Layout 10k views, one leaf resized per frame", window, canvas, frames, [&]()
+		{
+			int index = (frame * 7919) % leaf_widths.size();
+			leaf_widths[index] = leaf_widths[index] == 8 ? 5 : 8;
+			auto leaf = layout_ui.root_view()->children()[index / 100]->children()[index % 100];
+			leaf->style()->set(string_format("width: %1px", leaf_widths[index]));
+			leaf->set_needs_layout();
+			frame++;
+			layout_ui.update();
+		}, false);
+		print_view_statistics(layout_ui, frames);
+		if (layout_ui.render_statistics().views_laid_out != frames * 3)
+			fail("only the root, the row and the resized leaf are laid out");
+
+		TextureWindow reference_ui(canvas);
+		reference_ui.set_viewport(Rectf(0.0f, 0.0f, (float)width, (float)height));
+		reference_ui.set_root_view(create_layout_scene(leaf_widths));
+		reference_ui.update();
+		bool same_layout = true;
+		for (size_t row = 0; row < 100; row++)
+		{
+			for (size_t column = 0; column < 100; column++)
+			{
+				const auto &leaf = layout_ui.root_view()->children()[row]->children()[column];
+				const auto &reference = reference_ui.root_view()->children()[row]->children()[column];
+				same_layout = same_layout && leaf->geometry().content_box() == reference->geometry().content_box();
+			}
+		}
+		if (!same_layout)
+			fail("incremental layout matches a full layout");
+	}
+	catch (Exception &e)
+	{
+		Console::write_line("Exception caught: %1", e.get_message_and_stack_trace());
+		return 1;
+	}
+
+	return 0;
+}
+
+void TestApp::fail(const char *description) const
+{
+	throw Exception(string_format("Failed Test: %1", description));
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ClanLib/core.h>
+#include <ClanLib/display.h>
+#include <ClanLib/ui.h>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace clan;
+
+class TestApp
+{
+public:
+	int main(int argc, char **argv);
+private:
+	void benchmark(const char *name, DisplayWindow &window, Canvas &canvas, int frames, const std::function<void()> &render, bool clear = true);
+	void test_command_log(Canvas &canvas);
+	void test_shadow_damage(Canvas &canvas);
+	void test_fixed_after_move(Canvas &canvas);
+public:
+	void fail(const char *description) const;
+};
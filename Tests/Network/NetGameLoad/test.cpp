@@ -0,0 +1,144 @@
+
+#include <ClanLib/core.h>
+#include <ClanLib/network.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace clan;
+
+// Loopback load generator for NetGameServer.
+//
+// Every client keeps a fixed number of "ping" events in flight. The server echoes them back
+// and the client measures the round trip. Usage: netgameload [clients] [in-flight] [seconds]
+
+struct LoadResult
+{
+	int connected = 0;
+	int events = 0;
+	double seconds = 0.0;
+	std::vector<unsigned int> latencies;
+};
+
+struct LoadClient
+{
+	NetGameClient client;
+	Slot slot_connected;
+	Slot slot_event;
+	bool connected = false;
+};
+
+LoadResult run_load(NetGameServerMode mode, const std::string &port, int num_clients, int in_flight, int duration_ms);
+void print_result(const std::string &name, const LoadResult &result);
+
+int main(int argc, char **argv)
+{
+	int num_clients = argc > 1 ? StringHelp::text_to_int(argv[1]) : 64;
+	int in_flight = argc > 2 ? StringHelp::text_to_int(argv[2]) : 4;
+	int seconds = argc > 3 ? StringHelp::text_to_int(argv[3]) : 3;
+
+	try
+	{
+		Console::write_line("NetGameServer loopback load: %1 clients, %2 events in flight each, %3 seconds", num_clients, in_flight, seconds);
+		Console::write_line("");
+
+		print_result("thread per connection", run_load(netgame_server_thread_per_connection, "4571", num_clients, in_flight, seconds * 1000));
+		print_result("reactor", run_load(netgame_server_reactor, "4572", num_clients, in_flight, seconds * 1000));
+	}
+	catch (Exception &e)
+	{
+		Console::write_line(e.message);
+		return 1;
+	}
+	return 0;
+}
+
+LoadResult run_load(NetGameServerMode mode, const std::string &port, int num_clients, int in_flight, int duration_ms)
+{
+	LoadResult result;
+	bool sending = true;
+
+	NetGameServer server(mode);
+	Slot slot_server_event = server.sig_event_received().connect([&](NetGameConnection *connection, const NetGameEvent &e)
+	{
+		result.events++;
+		connection->send_event(e);
+	});
+	server.start("127.0.0.1", port);
+
+	std::vector<std::unique_ptr<LoadClient>> clients;
+	for (int i = 0; i < num_clients; i++)
+	{
+		LoadClient *load_client = new LoadClient();
+		clients.push_back(std::unique_ptr<LoadClient>(load_client));
+
+		load_client->slot_connected = load_client->client.sig_connected().connect([&result, load_client]()
+		{
+			load_client->connected = true;
+			result.connected++;
+		});
+		load_client->slot_event = load_client->client.sig_event_received().connect([&result, &sending, load_client](const NetGameEvent &e)
+		{
+			unsigned int sent = e.get_argument(0).get_uinteger();
+			unsigned int now = (unsigned int)System::get_microseconds();
+			result.latencies.push_back(now - sent);
+			if (sending)
+				load_client->client.send_event(NetGameEvent("ping", { NetGameEventValue((unsigned int)System::get_microseconds()) }));
+		});
+		load_client->client.connect("127.0.0.1", port);
+	}
+
+	uint64_t connect_timeout = System::get_time() + 10000;
+	while (result.connected < num_clients && System::get_time() < connect_timeout)
+	{
+		server.process_events();
+		for (auto &load_client : clients)
+			load_client->client.process_events();
+		System::sleep(1);
+	}
+	if (result.connected < num_clients)
+		throw Exception(string_format("Only %1 of %2 clients connected", result.connected, num_clients));
+
+	for (auto &load_client : clients)
+	{
+		for (int i = 0; i < in_flight; i++)
+			load_client->client.send_event(NetGameEvent("ping", { NetGameEventValue((unsigned int)System::get_microseconds()) }));
+	}
+
+	uint64_t start_time = System::get_microseconds();
+	uint64_t end_time = start_time + duration_ms * (uint64_t)1000;
+	while (System::get_microseconds() < end_time)
+	{
+		server.process_events();
+		for (auto &load_client : clients)
+			load_client->client.process_events();
+		std::this_thread::yield();
+	}
+	result.seconds = (System::get_microseconds() - start_time) / 1000000.0;
+	sending = false;
+
+	// Let the events still in flight arrive before the connections are torn down
+	System::sleep(200);
+	server.process_events();
+	for (auto &load_client : clients)
+		load_client->client.process_events();
+
+	clients.clear();
+	server.stop();
+	return result;
+}
+
+void print_result(const std::string &name, const LoadResult &result)
+{
+	std::vector<unsigned int> latencies = result.latencies;
+	std::sort(latencies.begin(), latencies.end());
+
+	unsigned int p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+	unsigned int p99 = latencies.empty() ? 0 : latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+
+	Console::write_line("%1:", name);
+	Console::write_line("    events/second: %1", (int)(result.events / result.seconds));
+	Console::write_line("    latency p50: %1 us, p99: %2 us", p50, p99);
+	Console::write_line("");
+}